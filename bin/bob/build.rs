@@ -94,6 +94,24 @@ fn test_bob_{}() {{
             "Failed to test example {dir_name}:\nstdout: {{stdout}}\nstderr: {{stderr}}",
         );
     }}
+    "#
+                )
+            } else if dir_name.contains("-with-benches") {
+                format!(
+                    r#"
+    // Bench example
+    let output = std::process::Command::new(env!("CARGO_BIN_EXE_bob"))
+        .arg("bench")
+        .current_dir("{entry}")
+        .output()
+        .expect("Failed to execute bob bench command");
+    if !output.status.success() {{
+        let stdout = String::from_utf8_lossy(&output.stdout);
+        let stderr = String::from_utf8_lossy(&output.stderr);
+        panic!(
+            "Failed to bench example {dir_name}:\nstdout: {{stdout}}\nstderr: {{stderr}}",
+        );
+    }}
     "#
                 )
             } else {
@@ -0,0 +1,36 @@
+#include "fib.h"
+
+uint64_t fib_recursive(uint32_t n) {
+    return n < 2 ? n : fib_recursive(n - 1) + fib_recursive(n - 2);
+}
+
+uint64_t fib_iterative(uint32_t n) {
+    uint64_t a = 0, b = 1;
+    for (uint32_t i = 0; i < n; i++) {
+        uint64_t c = a + b;
+        a = b;
+        b = c;
+    }
+    return a;
+}
+
+// MARK: Benchmarks
+#ifdef BENCH
+
+#include <bob/bench.h>
+
+void bench_fib_recursive(bench_t *bench) {
+    for (uint64_t i = 0; i < bench->iterations; i++) {
+        uint64_t result = fib_recursive(20);
+        bench_black_box(&result);
+    }
+}
+
+void bench_fib_iterative(bench_t *bench) {
+    for (uint64_t i = 0; i < bench->iterations; i++) {
+        uint64_t result = fib_iterative(20);
+        bench_black_box(&result);
+    }
+}
+
+#endif
@@ -0,0 +1,7 @@
+#pragma once
+
+#include <stdint.h>
+
+uint64_t fib_recursive(uint32_t n);
+
+uint64_t fib_iterative(uint32_t n);
@@ -0,0 +1,9 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "fib.h"
+
+int main(void) {
+    printf("Hello fib %llu!\n", (unsigned long long)fib_iterative(20));
+    return EXIT_SUCCESS;
+}
@@ -4,8 +4,367 @@
  * SPDX-License-Identifier: MIT
  */
 
+#define _POSIX_C_SOURCE 200112L
+
 #include "canvas.h"
 
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cp437.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#elif defined(__aarch64__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+// MARK: Span fill kernels
+// Every kernel fills a scalar head until dst is aligned, then stores whole aligned vectors
+// and finishes with a scalar tail
+typedef void (*canvas_fill_span_t)(uint32_t* dst, size_t count, uint32_t color);
+
+static void canvas_fill_span_scalar(uint32_t* dst, size_t count, uint32_t color) {
+    for (size_t i = 0; i < count; i++)
+        dst[i] = color;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+__attribute__((target("sse2"))) static void canvas_fill_span_sse2(uint32_t* dst, size_t count, uint32_t color) {
+    for (; count > 0 && ((uintptr_t)dst & 15) != 0; count--)
+        *dst++ = color;
+    __m128i value = _mm_set1_epi32((int32_t)color);
+    for (; count >= 16; count -= 16, dst += 16) {
+        _mm_store_si128((__m128i*)dst, value);
+        _mm_store_si128((__m128i*)(dst + 4), value);
+        _mm_store_si128((__m128i*)(dst + 8), value);
+        _mm_store_si128((__m128i*)(dst + 12), value);
+    }
+    for (; count >= 4; count -= 4, dst += 4)
+        _mm_store_si128((__m128i*)dst, value);
+    canvas_fill_span_scalar(dst, count, color);
+}
+
+__attribute__((target("avx2"))) static void canvas_fill_span_avx2(uint32_t* dst, size_t count, uint32_t color) {
+    for (; count > 0 && ((uintptr_t)dst & 31) != 0; count--)
+        *dst++ = color;
+    __m256i value = _mm256_set1_epi32((int32_t)color);
+    for (; count >= 32; count -= 32, dst += 32) {
+        _mm256_store_si256((__m256i*)dst, value);
+        _mm256_store_si256((__m256i*)(dst + 8), value);
+        _mm256_store_si256((__m256i*)(dst + 16), value);
+        _mm256_store_si256((__m256i*)(dst + 24), value);
+    }
+    for (; count >= 8; count -= 8, dst += 8)
+        _mm256_store_si256((__m256i*)dst, value);
+    canvas_fill_span_scalar(dst, count, color);
+}
+#elif defined(__aarch64__) || defined(__ARM_NEON)
+static void canvas_fill_span_neon(uint32_t* dst, size_t count, uint32_t color) {
+    for (; count > 0 && ((uintptr_t)dst & 15) != 0; count--)
+        *dst++ = color;
+    uint32x4_t value = vdupq_n_u32(color);
+    for (; count >= 16; count -= 16, dst += 16) {
+        vst1q_u32(dst, value);
+        vst1q_u32(dst + 4, value);
+        vst1q_u32(dst + 8, value);
+        vst1q_u32(dst + 12, value);
+    }
+    for (; count >= 4; count -= 4, dst += 4)
+        vst1q_u32(dst, value);
+    canvas_fill_span_scalar(dst, count, color);
+}
+#endif
+
+// MARK: Blend kernels
+// Source over blending of premultiplied ARGB: dst = src + dst * (255 - src alpha) / 255 for
+// every channel, the division is rounded with (t + 128 + ((t + 128) >> 8)) >> 8
+static inline uint32_t canvas_div255(uint32_t t) {
+    t += 128;
+    return (t + (t >> 8)) >> 8;
+}
+
+static inline uint32_t canvas_blend_pixel(uint32_t dst, uint32_t src) {
+    uint32_t inv_alpha = 255 - (src >> 24);
+    uint32_t result = 0;
+    for (uint32_t shift = 0; shift < 32; shift += 8) {
+        uint32_t channel = ((src >> shift) & 0xff) + canvas_div255(((dst >> shift) & 0xff) * inv_alpha);
+        result |= (channel > 255 ? 255 : channel) << shift;
+    }
+    return result;
+}
+
+static void canvas_blend_span_scalar(uint32_t* dst, const uint32_t* src, size_t src_step, size_t count) {
+    for (size_t i = 0; i < count; i++)
+        dst[i] = canvas_blend_pixel(dst[i], src[i * src_step]);
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+__attribute__((target("sse2"))) static inline __m128i canvas_div255_sse2(__m128i t) {
+    t = _mm_add_epi16(t, _mm_set1_epi16(128));
+    return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+}
+
+// Blend 4 pixels, every 16-bit lane of the unpacked source alpha is broadcast over its pixel
+__attribute__((target("sse2"))) static inline __m128i canvas_blend_sse2(__m128i dst, __m128i src) {
+    __m128i zero = _mm_setzero_si128();
+    __m128i max = _mm_set1_epi16(255);
+    __m128i src_lo = _mm_unpacklo_epi8(src, zero);
+    __m128i src_hi = _mm_unpackhi_epi8(src, zero);
+    __m128i inv_lo = _mm_sub_epi16(max, _mm_shufflehi_epi16(_mm_shufflelo_epi16(src_lo, 0xff), 0xff));
+    __m128i inv_hi = _mm_sub_epi16(max, _mm_shufflehi_epi16(_mm_shufflelo_epi16(src_hi, 0xff), 0xff));
+    __m128i dst_lo = canvas_div255_sse2(_mm_mullo_epi16(_mm_unpacklo_epi8(dst, zero), inv_lo));
+    __m128i dst_hi = canvas_div255_sse2(_mm_mullo_epi16(_mm_unpackhi_epi8(dst, zero), inv_hi));
+    return _mm_adds_epu8(src, _mm_packus_epi16(dst_lo, dst_hi));
+}
+
+__attribute__((target("sse2"))) static void canvas_blend_span_sse2(uint32_t* dst, const uint32_t* src, size_t src_step,
+                                                                   size_t count) {
+    for (; count > 0 && ((uintptr_t)dst & 15) != 0; count--, dst++, src += src_step)
+        *dst = canvas_blend_pixel(*dst, *src);
+    __m128i color = _mm_set1_epi32(src_step == 0 ? (int32_t)*src : 0);
+    for (; count >= 4; count -= 4, dst += 4, src += src_step * 4) {
+        __m128i pixels = src_step == 0 ? color : _mm_loadu_si128((const __m128i*)src);
+        _mm_store_si128((__m128i*)dst, canvas_blend_sse2(_mm_load_si128((const __m128i*)dst), pixels));
+    }
+    canvas_blend_span_scalar(dst, src, src_step, count);
+}
+
+__attribute__((target("avx2"))) static inline __m256i canvas_div255_avx2(__m256i t) {
+    t = _mm256_add_epi16(t, _mm256_set1_epi16(128));
+    return _mm256_srli_epi16(_mm256_add_epi16(t, _mm256_srli_epi16(t, 8)), 8);
+}
+
+// Blend 8 pixels, the unpacks and the pack work within 128-bit lanes so the order is kept
+__attribute__((target("avx2"))) static inline __m256i canvas_blend_avx2(__m256i dst, __m256i src) {
+    __m256i zero = _mm256_setzero_si256();
+    __m256i max = _mm256_set1_epi16(255);
+    __m256i src_lo = _mm256_unpacklo_epi8(src, zero);
+    __m256i src_hi = _mm256_unpackhi_epi8(src, zero);
+    __m256i inv_lo = _mm256_sub_epi16(max, _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(src_lo, 0xff), 0xff));
+    __m256i inv_hi = _mm256_sub_epi16(max, _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(src_hi, 0xff), 0xff));
+    __m256i dst_lo = canvas_div255_avx2(_mm256_mullo_epi16(_mm256_unpacklo_epi8(dst, zero), inv_lo));
+    __m256i dst_hi = canvas_div255_avx2(_mm256_mullo_epi16(_mm256_unpackhi_epi8(dst, zero), inv_hi));
+    return _mm256_adds_epu8(src, _mm256_packus_epi16(dst_lo, dst_hi));
+}
+
+__attribute__((target("avx2"))) static void canvas_blend_span_avx2(uint32_t* dst, const uint32_t* src, size_t src_step,
+                                                                   size_t count) {
+    for (; count > 0 && ((uintptr_t)dst & 31) != 0; count--, dst++, src += src_step)
+        *dst = canvas_blend_pixel(*dst, *src);
+    __m256i color = _mm256_set1_epi32(src_step == 0 ? (int32_t)*src : 0);
+    for (; count >= 8; count -= 8, dst += 8, src += src_step * 8) {
+        __m256i pixels = src_step == 0 ? color : _mm256_loadu_si256((const __m256i*)src);
+        _mm256_store_si256((__m256i*)dst, canvas_blend_avx2(_mm256_load_si256((const __m256i*)dst), pixels));
+    }
+    canvas_blend_span_scalar(dst, src, src_step, count);
+}
+#elif defined(__aarch64__) || defined(__ARM_NEON)
+static inline uint8x8_t canvas_div255_neon(uint16x8_t t) {
+    t = vaddq_u16(t, vdupq_n_u16(128));
+    return vshrn_n_u16(vaddq_u16(t, vshrq_n_u16(t, 8)), 8);
+}
+
+// Blend 4 pixels, the source alpha is copied to every byte of its pixel by a multiply
+static inline uint8x16_t canvas_blend_neon(uint8x16_t dst, uint8x16_t src) {
+    uint32x4_t alpha = vmulq_n_u32(vshrq_n_u32(vreinterpretq_u32_u8(src), 24), 0x01010101);
+    uint8x16_t inv_alpha = vmvnq_u8(vreinterpretq_u8_u32(alpha));
+    uint8x8_t dst_lo = canvas_div255_neon(vmull_u8(vget_low_u8(dst), vget_low_u8(inv_alpha)));
+    uint8x8_t dst_hi = canvas_div255_neon(vmull_u8(vget_high_u8(dst), vget_high_u8(inv_alpha)));
+    return vqaddq_u8(src, vcombine_u8(dst_lo, dst_hi));
+}
+
+static void canvas_blend_span_neon(uint32_t* dst, const uint32_t* src, size_t src_step, size_t count) {
+    for (; count > 0 && ((uintptr_t)dst & 15) != 0; count--, dst++, src += src_step)
+        *dst = canvas_blend_pixel(*dst, *src);
+    uint8x16_t color = vreinterpretq_u8_u32(vdupq_n_u32(src_step == 0 ? *src : 0));
+    for (; count >= 4; count -= 4, dst += 4, src += src_step * 4) {
+        uint8x16_t pixels = src_step == 0 ? color : vld1q_u8((const uint8_t*)src);
+        vst1q_u8((uint8_t*)dst, canvas_blend_neon(vld1q_u8((const uint8_t*)dst), pixels));
+    }
+    canvas_blend_span_scalar(dst, src, src_step, count);
+}
+#endif
+
+// MARK: Image kernels
+// Scaled images are copied with pixel doubling for 2x nearest and otherwise sampled from 16.16 fixed point
+// positions. Bilinear samples are two linear interpolations with weights from 0 to 256 of the second pixel,
+// a horizontal one between two neighbouring pixels and a vertical one between two interpolated rows
+static inline uint32_t canvas_lerp_pixel(uint32_t a, uint32_t b, uint32_t weight) {
+    uint32_t result = 0;
+    for (uint32_t shift = 0; shift < 32; shift += 8) {
+        uint32_t channel = ((a >> shift) & 0xff) * (256 - weight) + ((b >> shift) & 0xff) * weight;
+        result |= ((channel + 128) >> 8) << shift;
+    }
+    return result;
+}
+
+// Write every source pixel twice, count is the number of destination pixels
+static void canvas_double_span_scalar(uint32_t* dst, const uint32_t* src, size_t count) {
+    for (size_t i = 0; i < count; i++)
+        dst[i] = src[i / 2];
+}
+
+static void canvas_lerp_span_scalar(uint32_t* dst, const uint32_t* a, const uint32_t* b, uint32_t weight,
+                                    size_t count) {
+    for (size_t i = 0; i < count; i++)
+        dst[i] = canvas_lerp_pixel(a[i], b[i], weight);
+}
+
+// Interpolate the pixel pairs src[offsets[i]] and src[offsets[i] + 1]
+static void canvas_lerp_pairs_scalar(uint32_t* dst, const uint32_t* src, const int32_t* offsets,
+                                     const uint16_t* weights, size_t count) {
+    for (size_t i = 0; i < count; i++)
+        dst[i] = canvas_lerp_pixel(src[offsets[i]], src[offsets[i] + 1], weights[i]);
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+__attribute__((target("sse2"))) static void canvas_double_span_sse2(uint32_t* dst, const uint32_t* src,
+                                                                    size_t count) {
+    for (; count >= 8; count -= 8, dst += 8, src += 4) {
+        __m128i pixels = _mm_loadu_si128((const __m128i*)src);
+        _mm_storeu_si128((__m128i*)dst, _mm_unpacklo_epi32(pixels, pixels));
+        _mm_storeu_si128((__m128i*)(dst + 4), _mm_unpackhi_epi32(pixels, pixels));
+    }
+    canvas_double_span_scalar(dst, src, count);
+}
+
+// Interpolate 16-bit channels, a * (256 - weight) + b * weight stays below 65536
+__attribute__((target("sse2"))) static inline __m128i canvas_lerp_sse2(__m128i a, __m128i b, __m128i weight) {
+    __m128i inv_weight = _mm_sub_epi16(_mm_set1_epi16(256), weight);
+    __m128i sum = _mm_add_epi16(_mm_mullo_epi16(a, inv_weight), _mm_mullo_epi16(b, weight));
+    return _mm_srli_epi16(_mm_add_epi16(sum, _mm_set1_epi16(128)), 8);
+}
+
+__attribute__((target("sse2"))) static void canvas_lerp_span_sse2(uint32_t* dst, const uint32_t* a, const uint32_t* b,
+                                                                  uint32_t weight, size_t count) {
+    __m128i zero = _mm_setzero_si128();
+    __m128i weights = _mm_set1_epi16((int16_t)weight);
+    for (; count >= 4; count -= 4, dst += 4, a += 4, b += 4) {
+        __m128i pa = _mm_loadu_si128((const __m128i*)a);
+        __m128i pb = _mm_loadu_si128((const __m128i*)b);
+        __m128i lo = canvas_lerp_sse2(_mm_unpacklo_epi8(pa, zero), _mm_unpacklo_epi8(pb, zero), weights);
+        __m128i hi = canvas_lerp_sse2(_mm_unpackhi_epi8(pa, zero), _mm_unpackhi_epi8(pb, zero), weights);
+        _mm_storeu_si128((__m128i*)dst, _mm_packus_epi16(lo, hi));
+    }
+    canvas_lerp_span_scalar(dst, a, b, weight, count);
+}
+
+// Interpolate the pair of one pixel, the 64-bit load of a pair unpacks to the left pixel in the low half
+// and the right pixel in the high half
+__attribute__((target("sse2"))) static inline __m128i canvas_lerp_pair_sse2(__m128i pair_a, __m128i pair_b,
+                                                                           uint16_t weight_a, uint16_t weight_b) {
+    __m128i left = _mm_unpacklo_epi64(pair_a, pair_b);
+    __m128i right = _mm_unpackhi_epi64(pair_a, pair_b);
+    __m128i weights = _mm_unpacklo_epi64(_mm_set1_epi16((int16_t)weight_a), _mm_set1_epi16((int16_t)weight_b));
+    return canvas_lerp_sse2(left, right, weights);
+}
+
+__attribute__((target("sse2"))) static void canvas_lerp_pairs_sse2(uint32_t* dst, const uint32_t* src,
+                                                                   const int32_t* offsets, const uint16_t* weights,
+                                                                   size_t count) {
+    __m128i zero = _mm_setzero_si128();
+    for (; count >= 4; count -= 4, dst += 4, offsets += 4, weights += 4) {
+        __m128i p0 = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(src + offsets[0])), zero);
+        __m128i p1 = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(src + offsets[1])), zero);
+        __m128i p2 = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(src + offsets[2])), zero);
+        __m128i p3 = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(src + offsets[3])), zero);
+        __m128i lo = canvas_lerp_pair_sse2(p0, p1, weights[0], weights[1]);
+        __m128i hi = canvas_lerp_pair_sse2(p2, p3, weights[2], weights[3]);
+        _mm_storeu_si128((__m128i*)dst, _mm_packus_epi16(lo, hi));
+    }
+    canvas_lerp_pairs_scalar(dst, src, offsets, weights, count);
+}
+#elif defined(__aarch64__) || defined(__ARM_NEON)
+static void canvas_double_span_neon(uint32_t* dst, const uint32_t* src, size_t count) {
+    for (; count >= 8; count -= 8, dst += 8, src += 4) {
+        uint32x4_t pixels = vld1q_u32(src);
+        uint32x4x2_t doubled = vzipq_u32(pixels, pixels);
+        vst1q_u32(dst, doubled.val[0]);
+        vst1q_u32(dst + 4, doubled.val[1]);
+    }
+    canvas_double_span_scalar(dst, src, count);
+}
+
+// Interpolate 16-bit channels and narrow them with rounding, a * (256 - weight) + b * weight stays below 65536
+static inline uint8x8_t canvas_lerp_neon(uint16x8_t a, uint16x8_t b, uint16x8_t weight) {
+    uint16x8_t inv_weight = vsubq_u16(vdupq_n_u16(256), weight);
+    return vrshrn_n_u16(vmlaq_u16(vmulq_u16(a, inv_weight), b, weight), 8);
+}
+
+static void canvas_lerp_span_neon(uint32_t* dst, const uint32_t* a, const uint32_t* b, uint32_t weight,
+                                  size_t count) {
+    uint16x8_t weights = vdupq_n_u16((uint16_t)weight);
+    for (; count >= 4; count -= 4, dst += 4, a += 4, b += 4) {
+        uint8x16_t pa = vld1q_u8((const uint8_t*)a);
+        uint8x16_t pb = vld1q_u8((const uint8_t*)b);
+        uint8x8_t lo = canvas_lerp_neon(vmovl_u8(vget_low_u8(pa)), vmovl_u8(vget_low_u8(pb)), weights);
+        uint8x8_t hi = canvas_lerp_neon(vmovl_u8(vget_high_u8(pa)), vmovl_u8(vget_high_u8(pb)), weights);
+        vst1q_u8((uint8_t*)dst, vcombine_u8(lo, hi));
+    }
+    canvas_lerp_span_scalar(dst, a, b, weight, count);
+}
+
+static void canvas_lerp_pairs_neon(uint32_t* dst, const uint32_t* src, const int32_t* offsets,
+                                   const uint16_t* weights, size_t count) {
+    for (; count >= 2; count -= 2, dst += 2, offsets += 2, weights += 2) {
+        uint16x8_t p0 = vmovl_u8(vld1_u8((const uint8_t*)(src + offsets[0])));
+        uint16x8_t p1 = vmovl_u8(vld1_u8((const uint8_t*)(src + offsets[1])));
+        uint16x8_t left = vcombine_u16(vget_low_u16(p0), vget_low_u16(p1));
+        uint16x8_t right = vcombine_u16(vget_high_u16(p0), vget_high_u16(p1));
+        uint16x8_t weight = vcombine_u16(vdup_n_u16(weights[0]), vdup_n_u16(weights[1]));
+        vst1_u8((uint8_t*)dst, canvas_lerp_neon(left, right, weight));
+    }
+    canvas_lerp_pairs_scalar(dst, src, offsets, weights, count);
+}
+#endif
+
+// MARK: Kernel selection
+// Widest kernels the CPU supports, NEON is always there on AArch64. The blend kernels read
+// the source with a step of 0 pixels for a single color or 1 pixel for an image
+static canvas_fill_span_t canvas_fill_span = NULL;
+static void (*canvas_blend_span)(uint32_t* dst, const uint32_t* src, size_t src_step, size_t count) = NULL;
+static void (*canvas_double_span)(uint32_t* dst, const uint32_t* src, size_t count) = NULL;
+static void (*canvas_lerp_span)(uint32_t* dst, const uint32_t* a, const uint32_t* b, uint32_t weight,
+                                size_t count) = NULL;
+static void (*canvas_lerp_pairs)(uint32_t* dst, const uint32_t* src, const int32_t* offsets, const uint16_t* weights,
+                                 size_t count) = NULL;
+
+static void canvas_select_kernels(void) {
+    canvas_fill_span = canvas_fill_span_scalar;
+    canvas_blend_span = canvas_blend_span_scalar;
+    canvas_double_span = canvas_double_span_scalar;
+    canvas_lerp_span = canvas_lerp_span_scalar;
+    canvas_lerp_pairs = canvas_lerp_pairs_scalar;
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        canvas_fill_span = canvas_fill_span_avx2;
+        canvas_blend_span = canvas_blend_span_avx2;
+    } else if (__builtin_cpu_supports("sse2")) {
+        canvas_fill_span = canvas_fill_span_sse2;
+        canvas_blend_span = canvas_blend_span_sse2;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        canvas_double_span = canvas_double_span_sse2;
+        canvas_lerp_span = canvas_lerp_span_sse2;
+        canvas_lerp_pairs = canvas_lerp_pairs_sse2;
+    }
+#elif defined(__aarch64__) || defined(__ARM_NEON)
+    canvas_fill_span = canvas_fill_span_neon;
+    canvas_blend_span = canvas_blend_span_neon;
+    canvas_double_span = canvas_double_span_neon;
+    canvas_lerp_span = canvas_lerp_span_neon;
+    canvas_lerp_pairs = canvas_lerp_pairs_neon;
+#endif
+}
+
+// MARK: Canvas
 void canvas_init(canvas_t* canvas, int32_t width, int32_t height, uint32_t* pixels, float scale) {
     canvas->width = width;
     canvas->height = height;
@@ -13,51 +372,1328 @@ void canvas_init(canvas_t* canvas, int32_t width, int32_t height, uint32_t* pixe
     canvas->phys_width = (int32_t)((float)width * canvas->scale + 0.5f);
     canvas->phys_height = (int32_t)((float)height * canvas->scale + 0.5f);
     canvas->pixels = pixels;
+    canvas->dirty_count = 0;
+    canvas->tiler = NULL;
+    canvas->list = NULL;
+    if (canvas_fill_span == NULL)
+        canvas_select_kernels();
 }
 
-void canvas_fill_rect(canvas_t* canvas, float x, float y, float w, float h, uint32_t color) {
+// MARK: Dirty rects
+static canvas_rect_t canvas_rect_union(canvas_rect_t a, canvas_rect_t b) {
+    int32_t x1 = a.x < b.x ? a.x : b.x;
+    int32_t y1 = a.y < b.y ? a.y : b.y;
+    int32_t x2 = a.x + a.width > b.x + b.width ? a.x + a.width : b.x + b.width;
+    int32_t y2 = a.y + a.height > b.y + b.height ? a.y + a.height : b.y + b.height;
+    canvas_rect_t rect = {x1, y1, x2 - x1, y2 - y1};
+    return rect;
+}
+
+static int canvas_rects_touch(canvas_rect_t a, canvas_rect_t b) {
+    return a.x <= b.x + b.width && b.x <= a.x + a.width && a.y <= b.y + b.height && b.y <= a.y + a.height;
+}
+
+// Add a rect to a set of at most CANVAS_MAX_DIRTY_RECTS rects, the rects of a set never overlap or touch
+static void canvas_rects_add(canvas_rect_t* rects, int32_t* count, canvas_rect_t rect) {
+    for (;;) {
+        // Merge every rect the rect overlaps or touches, the union can reach other rects
+        int32_t index = 0;
+        while (index < *count) {
+            if (canvas_rects_touch(rect, rects[index])) {
+                rect = canvas_rect_union(rect, rects[index]);
+                rects[index] = rects[--*count];
+                index = 0;
+            } else {
+                index++;
+            }
+        }
+        if (*count < CANVAS_MAX_DIRTY_RECTS)
+            break;
+
+        // The set is full, merge the rect that grows least and check the others again
+        int32_t best = 0;
+        int64_t best_growth = INT64_MAX;
+        for (int32_t i = 0; i < *count; i++) {
+            canvas_rect_t other = rects[i];
+            canvas_rect_t merged = canvas_rect_union(rect, other);
+            int64_t growth = (int64_t)merged.width * merged.height - (int64_t)other.width * other.height;
+            if (growth < best_growth) {
+                best = i;
+                best_growth = growth;
+            }
+        }
+        rect = canvas_rect_union(rect, rects[best]);
+        rects[best] = rects[--*count];
+    }
+    rects[(*count)++] = rect;
+}
+
+void canvas_add_dirty_rect(canvas_t* canvas, int32_t x, int32_t y, int32_t width, int32_t height) {
+    int32_t x1 = x > 0 ? x : 0;
+    int32_t y1 = y > 0 ? y : 0;
+    int32_t x2 = x + width < canvas->phys_width ? x + width : canvas->phys_width;
+    int32_t y2 = y + height < canvas->phys_height ? y + height : canvas->phys_height;
+    if (x1 >= x2 || y1 >= y2)
+        return;
+    canvas_rect_t rect = {x1, y1, x2 - x1, y2 - y1};
+    canvas_rects_add(canvas->dirty_rects, &canvas->dirty_count, rect);
+}
+
+void canvas_clear_dirty_rects(canvas_t* canvas) {
+    canvas->dirty_count = 0;
+}
+
+// MARK: Commands
+typedef enum canvas_command_type_t {
+    CANVAS_COMMAND_FILL,
+    CANVAS_COMMAND_BLEND,
+    CANVAS_COMMAND_IMAGE,
+    CANVAS_COMMAND_SCALED_IMAGE,
+    CANVAS_COMMAND_MASK,
+} canvas_command_type_t;
+
+// A draw call reduced to a clipped rect in physical pixels
+typedef struct canvas_command_t {
+    canvas_command_type_t type;
+    canvas_rect_t rect;
+    uint32_t color;  // fill color or premultiplied blend color
+    const uint32_t* image;
+    int32_t image_x;  // physical origin of the image or mask, can be outside the canvas
+    int32_t image_y;
+    int32_t image_width;   // row stride of the image or mask
+    int32_t src_width;     // size of a scaled image, it is stretched over scaled_width x scaled_height pixels
+    int32_t src_height;
+    int32_t scaled_width;
+    int32_t scaled_height;
+    canvas_filter_t filter;
+    const uint8_t* mask;  // coverage the color is blended with
+    uint32_t mask_generation;  // the glyphs at an atlas address change when the atlas starts over
+} canvas_command_t;
+
+// Blend an opaque color through a coverage mask. Glyphs at integer scales are mostly empty or fully
+// covered, those runs are skipped or filled and only the partly covered pixels are premultiplied
+// into a buffer that goes through the blend kernel
+static void canvas_mask_span(uint32_t* dst, const uint8_t* mask, uint32_t color, size_t count) {
+    size_t i = 0;
+    while (i < count) {
+        size_t start = i;
+        uint8_t coverage = mask[i];
+        if (coverage == 0 || coverage == 255) {
+            while (i < count && mask[i] == coverage)
+                i++;
+            if (coverage == 255)
+                canvas_fill_span(dst + start, i - start, color);
+            continue;
+        }
+        uint32_t src[CANVAS_TILE_SIZE];
+        for (; i < count && mask[i] != 0 && mask[i] != 255 && i - start < CANVAS_TILE_SIZE; i++) {
+            uint32_t pixel = (uint32_t)mask[i] << 24;
+            for (uint32_t shift = 0; shift < 24; shift += 8)
+                pixel |= canvas_div255(((color >> shift) & 0xff) * mask[i]) << shift;
+            src[i - start] = pixel;
+        }
+        canvas_blend_span(dst + start, src, 1, i - start);
+    }
+}
+
+// Left pixel of the pair a bilinear sample at a 16.16 position interpolates and the weight of the right pixel,
+// samples beyond the first or last pixel center take that pixel
+static inline int32_t canvas_bilinear_sample(int64_t position, int32_t size, uint16_t* weight) {
+    if (position < 0) {
+        *weight = 0;
+        return 0;
+    }
+    int32_t left = (int32_t)(position >> 16);
+    if (left >= size - 1) {
+        *weight = 256;
+        return size - 2;
+    }
+    *weight = (uint16_t)((position >> 8) & 0xff);
+    return left;
+}
+
+// Copy the part of a scaled image inside a clipped rect. Pixels sample the source at their mapped centers, the
+// positions only depend on the distance to the image origin so every tile samples the same pixels as a direct draw
+static void canvas_copy_scaled_image(canvas_t* canvas, const canvas_command_t* command, int32_t x1, int32_t y1,
+                                     int32_t x2, int32_t y2) {
+    size_t stride = (size_t)canvas->phys_width;
+    size_t src_stride = (size_t)command->image_width;
+    int64_t step_x = ((int64_t)command->src_width << 16) / command->scaled_width;
+    int64_t step_y = ((int64_t)command->src_height << 16) / command->scaled_height;
+    bool same_width = command->scaled_width == command->src_width;
+    bool same_height = command->scaled_height == command->src_height;
+
+    // Bilinear needs two pixels on both axes and is a plain copy at 1x
+    if (command->filter != CANVAS_FILTER_BILINEAR || command->src_width < 2 || command->src_height < 2 ||
+        (same_width && same_height)) {
+        size_t count = (size_t)(x2 - x1);
+        int32_t dx = x1 - command->image_x;
+        int32_t last_sy = -1;
+        for (int32_t row = y1; row < y2; row++) {
+            int32_t sy = (int32_t)(((int64_t)(row - command->image_y) * step_y + step_y / 2) >> 16);
+            uint32_t* dst = canvas->pixels + (size_t)row * stride + x1;
+            if (sy == last_sy) {
+                // Upscaled rows repeat the row above
+                memcpy(dst, dst - stride, count * sizeof(uint32_t));
+                continue;
+            }
+            last_sy = sy;
+            const uint32_t* src = command->image + (size_t)sy * src_stride;
+            if (same_width) {
+                memcpy(dst, src + dx, count * sizeof(uint32_t));
+            } else if (command->scaled_width == command->src_width * 2) {
+                // An odd start is the second copy of its source pixel
+                size_t odd = (size_t)(dx & 1);
+                if (odd)
+                    dst[0] = src[dx / 2];
+                canvas_double_span(dst + odd, src + (dx + 1) / 2, count - odd);
+            } else {
+                int64_t position = (int64_t)dx * step_x + step_x / 2;
+                for (size_t i = 0; i < count; i++, position += step_x)
+                    dst[i] = src[position >> 16];
+            }
+        }
+        return;
+    }
+
+    // Bilinear in chunks of at most a tile: the source rows are interpolated horizontally and the two rows of the
+    // last pair are kept, upscaled rows share them with the rows above. Then every row interpolates its pair
+    int32_t offsets[CANVAS_TILE_SIZE];
+    uint16_t weights[CANVAS_TILE_SIZE];
+    uint32_t rows[2][CANVAS_TILE_SIZE];
+    for (int32_t chunk_x = x1; chunk_x < x2; chunk_x += CANVAS_TILE_SIZE) {
+        size_t count = (size_t)(x2 - chunk_x < CANVAS_TILE_SIZE ? x2 - chunk_x : CANVAS_TILE_SIZE);
+        int64_t position = (int64_t)(chunk_x - command->image_x) * step_x + step_x / 2 - 0x8000;
+        for (size_t i = 0; i < count; i++, position += step_x)
+            offsets[i] = canvas_bilinear_sample(position, command->src_width, &weights[i]);
+
+        int32_t cached[2] = {-1, -1};
+        uint32_t* dst = canvas->pixels + (size_t)y1 * stride + chunk_x;
+        for (int32_t row = y1; row < y2; row++, dst += stride) {
+            uint16_t weight;
+            int64_t position_y = (int64_t)(row - command->image_y) * step_y + step_y / 2 - 0x8000;
+            int32_t top = canvas_bilinear_sample(position_y, command->src_height, &weight);
+            int32_t slots[2] = {0, 0};
+            for (int32_t k = weight == 256 ? 1 : 0; k <= (weight == 0 ? 0 : 1); k++) {
+                int32_t source_row = top + k;
+                int32_t slot = cached[0] == source_row ? 0 : (cached[1] == source_row ? 1 : -1);
+                if (slot < 0) {
+                    // Keep the slot of the other row of the pair
+                    slot = k == 1 ? 1 - slots[0] : (cached[1] == top + 1 ? 0 : 1);
+                    canvas_lerp_pairs(rows[slot], command->image + (size_t)source_row * src_stride, offsets, weights,
+                                      count);
+                    cached[slot] = source_row;
+                }
+                slots[k] = slot;
+            }
+            if (weight == 0 || weight == 256)
+                memcpy(dst, rows[slots[weight == 256]], count * sizeof(uint32_t));
+            else
+                canvas_lerp_span(dst, rows[slots[0]], rows[slots[1]], weight, count);
+        }
+    }
+}
+
+// Run the part of a command inside a clip rect, the tiles and the direct path both draw with this
+static void canvas_execute(canvas_t* canvas, const canvas_command_t* command, int32_t clip_x1, int32_t clip_y1,
+                           int32_t clip_x2, int32_t clip_y2) {
+    int32_t x1 = command->rect.x > clip_x1 ? command->rect.x : clip_x1;
+    int32_t y1 = command->rect.y > clip_y1 ? command->rect.y : clip_y1;
+    int32_t x2 = command->rect.x + command->rect.width < clip_x2 ? command->rect.x + command->rect.width : clip_x2;
+    int32_t y2 = command->rect.y + command->rect.height < clip_y2 ? command->rect.y + command->rect.height : clip_y2;
+    if (x1 >= x2 || y1 >= y2)
+        return;
+
+    if (command->type == CANVAS_COMMAND_SCALED_IMAGE) {
+        canvas_copy_scaled_image(canvas, command, x1, y1, x2, y2);
+        return;
+    }
+    int32_t stride = canvas->phys_width;
+    if (command->type == CANVAS_COMMAND_FILL && x1 == 0 && x2 == stride) {
+        // The rows have no padding, so full width rows are one span
+        canvas_fill_span(canvas->pixels + (size_t)y1 * (size_t)stride, (size_t)(y2 - y1) * (size_t)stride,
+                         command->color);
+        return;
+    }
+    size_t count = (size_t)(x2 - x1);
+    for (int32_t row = y1; row < y2; row++) {
+        uint32_t* dst = canvas->pixels + (size_t)row * (size_t)stride + x1;
+        if (command->type == CANVAS_COMMAND_FILL) {
+            canvas_fill_span(dst, count, command->color);
+        } else if (command->type == CANVAS_COMMAND_BLEND) {
+            canvas_blend_span(dst, &command->color, 0, count);
+        } else if (command->type == CANVAS_COMMAND_MASK) {
+            const uint8_t* mask = command->mask + (size_t)(row - command->image_y) * (size_t)command->image_width +
+                                  (x1 - command->image_x);
+            canvas_mask_span(dst, mask, command->color, count);
+        } else {
+            const uint32_t* src = command->image + (size_t)(row - command->image_y) * (size_t)command->image_width +
+                                  (x1 - command->image_x);
+            canvas_blend_span(dst, src, 1, count);
+        }
+    }
+}
+
+// MARK: Tiler
+struct canvas_tiler_t {
+    pthread_mutex_t mutex;
+    pthread_cond_t work_cond;
+    pthread_cond_t done_cond;
+    pthread_t* workers;
+    int32_t worker_count;
+    int32_t busy_workers;
+    uint64_t generation;
+    bool stopping;
+
+    // Recorded commands of the current frame
+    canvas_command_t* commands;
+    int32_t command_count;
+    int32_t command_capacity;
+
+    // Command indices binned per tile, the bin of tile i is tile_commands[tile_offsets[i]..tile_offsets[i + 1]]
+    canvas_t* canvas;
+    int32_t tiles_x;
+    int32_t tile_count;
+    int32_t* tile_offsets;
+    int32_t* tile_cursors;
+    int32_t tile_capacity;
+    int32_t* tile_commands;
+    int32_t tile_commands_capacity;
+    atomic_int next_tile;
+};
+
+// Rasterize tiles until none are left, the tiles don't overlap so the order they are taken in doesn't matter
+static void canvas_tiler_run(canvas_tiler_t* tiler) {
+    canvas_t* canvas = tiler->canvas;
+    for (;;) {
+        int32_t tile = atomic_fetch_add(&tiler->next_tile, 1);
+        if (tile >= tiler->tile_count)
+            break;
+        int32_t x1 = (tile % tiler->tiles_x) * CANVAS_TILE_SIZE;
+        int32_t y1 = (tile / tiler->tiles_x) * CANVAS_TILE_SIZE;
+        int32_t x2 = x1 + CANVAS_TILE_SIZE < canvas->phys_width ? x1 + CANVAS_TILE_SIZE : canvas->phys_width;
+        int32_t y2 = y1 + CANVAS_TILE_SIZE < canvas->phys_height ? y1 + CANVAS_TILE_SIZE : canvas->phys_height;
+        for (int32_t i = tiler->tile_offsets[tile]; i < tiler->tile_offsets[tile + 1]; i++)
+            canvas_execute(canvas, &tiler->commands[tiler->tile_commands[i]], x1, y1, x2, y2);
+    }
+}
+
+static void* canvas_tiler_worker(void* arg) {
+    canvas_tiler_t* tiler = arg;
+    uint64_t generation = 0;
+    pthread_mutex_lock(&tiler->mutex);
+    for (;;) {
+        while (!tiler->stopping && tiler->generation == generation)
+            pthread_cond_wait(&tiler->work_cond, &tiler->mutex);
+        if (tiler->stopping)
+            break;
+        generation = tiler->generation;
+        pthread_mutex_unlock(&tiler->mutex);
+
+        canvas_tiler_run(tiler);
+
+        pthread_mutex_lock(&tiler->mutex);
+        if (--tiler->busy_workers == 0)
+            pthread_cond_signal(&tiler->done_cond);
+    }
+    pthread_mutex_unlock(&tiler->mutex);
+    return NULL;
+}
+
+canvas_tiler_t* canvas_tiler_create(int32_t thread_count) {
+    canvas_tiler_t* tiler = calloc(1, sizeof(canvas_tiler_t));
+    if (tiler == NULL)
+        return NULL;
+    pthread_mutex_init(&tiler->mutex, NULL);
+    pthread_cond_init(&tiler->work_cond, NULL);
+    pthread_cond_init(&tiler->done_cond, NULL);
+    atomic_init(&tiler->next_tile, 0);
+
+    // The thread that ends the frame rasterizes tiles as well
+    if (thread_count > 1) {
+        tiler->workers = malloc((size_t)(thread_count - 1) * sizeof(pthread_t));
+        if (tiler->workers == NULL) {
+            canvas_tiler_destroy(tiler);
+            return NULL;
+        }
+        for (int32_t i = 0; i < thread_count - 1; i++) {
+            if (pthread_create(&tiler->workers[i], NULL, canvas_tiler_worker, tiler) != 0)
+                break;
+            tiler->worker_count++;
+        }
+    }
+    return tiler;
+}
+
+void canvas_tiler_destroy(canvas_tiler_t* tiler) {
+    if (tiler == NULL)
+        return;
+    pthread_mutex_lock(&tiler->mutex);
+    tiler->stopping = true;
+    pthread_cond_broadcast(&tiler->work_cond);
+    pthread_mutex_unlock(&tiler->mutex);
+    for (int32_t i = 0; i < tiler->worker_count; i++)
+        pthread_join(tiler->workers[i], NULL);
+    pthread_cond_destroy(&tiler->done_cond);
+    pthread_cond_destroy(&tiler->work_cond);
+    pthread_mutex_destroy(&tiler->mutex);
+    free(tiler->workers);
+    free(tiler->commands);
+    free(tiler->tile_offsets);
+    free(tiler->tile_cursors);
+    free(tiler->tile_commands);
+    free(tiler);
+}
+
+// Range of tiles a rect touches, clamped to the tiles of the canvas
+static void canvas_tile_range(const canvas_rect_t* rect, int32_t tiles_x, int32_t tiles_y, int32_t* tx1, int32_t* ty1,
+                              int32_t* tx2, int32_t* ty2) {
+    *tx1 = rect->x / CANVAS_TILE_SIZE > 0 ? rect->x / CANVAS_TILE_SIZE : 0;
+    *ty1 = rect->y / CANVAS_TILE_SIZE > 0 ? rect->y / CANVAS_TILE_SIZE : 0;
+    *tx2 = (rect->x + rect->width - 1) / CANVAS_TILE_SIZE;
+    *ty2 = (rect->y + rect->height - 1) / CANVAS_TILE_SIZE;
+    if (*tx2 > tiles_x - 1)
+        *tx2 = tiles_x - 1;
+    if (*ty2 > tiles_y - 1)
+        *ty2 = tiles_y - 1;
+}
+
+// Sort the recorded commands into the bins of the tiles they touch, returns false when out of memory
+static bool canvas_tiler_bin(canvas_tiler_t* tiler, canvas_t* canvas) {
+    tiler->tiles_x = (canvas->phys_width + CANVAS_TILE_SIZE - 1) / CANVAS_TILE_SIZE;
+    int32_t tiles_y = (canvas->phys_height + CANVAS_TILE_SIZE - 1) / CANVAS_TILE_SIZE;
+    int32_t tx1, ty1, tx2, ty2;
+    tiler->tile_count = tiler->tiles_x * tiles_y;
+    if (tiler->tile_count + 1 > tiler->tile_capacity) {
+        int32_t* offsets = realloc(tiler->tile_offsets, (size_t)(tiler->tile_count + 1) * sizeof(int32_t));
+        if (offsets == NULL)
+            return false;
+        tiler->tile_offsets = offsets;
+        int32_t* cursors = realloc(tiler->tile_cursors, (size_t)(tiler->tile_count + 1) * sizeof(int32_t));
+        if (cursors == NULL)
+            return false;
+        tiler->tile_cursors = cursors;
+        tiler->tile_capacity = tiler->tile_count + 1;
+    }
+
+    // Count the commands of every tile and turn the counts into offsets
+    memset(tiler->tile_offsets, 0, (size_t)(tiler->tile_count + 1) * sizeof(int32_t));
+    for (int32_t i = 0; i < tiler->command_count; i++) {
+        canvas_tile_range(&tiler->commands[i].rect, tiler->tiles_x, tiles_y, &tx1, &ty1, &tx2, &ty2);
+        for (int32_t ty = ty1; ty <= ty2; ty++)
+            for (int32_t tx = tx1; tx <= tx2; tx++)
+                tiler->tile_offsets[ty * tiler->tiles_x + tx + 1]++;
+    }
+    for (int32_t i = 0; i < tiler->tile_count; i++)
+        tiler->tile_offsets[i + 1] += tiler->tile_offsets[i];
+    int32_t total = tiler->tile_offsets[tiler->tile_count];
+    if (total > tiler->tile_commands_capacity) {
+        int32_t* tile_commands = realloc(tiler->tile_commands, (size_t)total * sizeof(int32_t));
+        if (tile_commands == NULL)
+            return false;
+        tiler->tile_commands = tile_commands;
+        tiler->tile_commands_capacity = total;
+    }
+
+    // Fill the bins in recording order, so every tile draws its commands in the same order as the direct path
+    memcpy(tiler->tile_cursors, tiler->tile_offsets, (size_t)tiler->tile_count * sizeof(int32_t));
+    for (int32_t i = 0; i < tiler->command_count; i++) {
+        canvas_tile_range(&tiler->commands[i].rect, tiler->tiles_x, tiles_y, &tx1, &ty1, &tx2, &ty2);
+        for (int32_t ty = ty1; ty <= ty2; ty++)
+            for (int32_t tx = tx1; tx <= tx2; tx++)
+                tiler->tile_commands[tiler->tile_cursors[ty * tiler->tiles_x + tx]++] = i;
+    }
+    return true;
+}
+
+// Rasterize the recorded commands on the worker pool and wait until all tiles are done
+static void canvas_tiler_flush(canvas_tiler_t* tiler, canvas_t* canvas) {
+    if (tiler->command_count == 0)
+        return;
+    if (!canvas_tiler_bin(tiler, canvas)) {
+        for (int32_t i = 0; i < tiler->command_count; i++)
+            canvas_execute(canvas, &tiler->commands[i], 0, 0, canvas->phys_width, canvas->phys_height);
+        tiler->command_count = 0;
+        return;
+    }
+
+    tiler->canvas = canvas;
+    atomic_store(&tiler->next_tile, 0);
+    pthread_mutex_lock(&tiler->mutex);
+    tiler->busy_workers = tiler->worker_count;
+    tiler->generation++;
+    pthread_cond_broadcast(&tiler->work_cond);
+    pthread_mutex_unlock(&tiler->mutex);
+
+    canvas_tiler_run(tiler);
+
+    pthread_mutex_lock(&tiler->mutex);
+    while (tiler->busy_workers > 0)
+        pthread_cond_wait(&tiler->done_cond, &tiler->mutex);
+    pthread_mutex_unlock(&tiler->mutex);
+    tiler->command_count = 0;
+}
+
+void canvas_begin_tiled(canvas_t* canvas, canvas_tiler_t* tiler) {
+    canvas->tiler = tiler;
+    if (tiler != NULL)
+        tiler->command_count = 0;
+}
+
+void canvas_end_tiled(canvas_t* canvas) {
+    if (canvas->tiler == NULL)
+        return;
+    canvas_tiler_flush(canvas->tiler, canvas);
+    canvas->tiler = NULL;
+}
+
+// Append a command to a growing array, returns false when out of memory
+static bool canvas_commands_push(canvas_command_t** commands, int32_t* count, int32_t* capacity,
+                                 const canvas_command_t* command) {
+    if (*count == *capacity) {
+        int32_t new_capacity = *capacity > 0 ? *capacity * 2 : 64;
+        canvas_command_t* new_commands = realloc(*commands, (size_t)new_capacity * sizeof(canvas_command_t));
+        if (new_commands == NULL)
+            return false;
+        *commands = new_commands;
+        *capacity = new_capacity;
+    }
+    (*commands)[(*count)++] = *command;
+    return true;
+}
+
+// Run a command right away or record it in the tiler
+static void canvas_dispatch(canvas_t* canvas, const canvas_command_t* command) {
+    canvas_tiler_t* tiler = canvas->tiler;
+    if (tiler == NULL) {
+        canvas_execute(canvas, command, 0, 0, canvas->phys_width, canvas->phys_height);
+        return;
+    }
+    if (!canvas_commands_push(&tiler->commands, &tiler->command_count, &tiler->command_capacity, command)) {
+        // Out of memory: draw what is recorded, then this command
+        canvas_tiler_flush(tiler, canvas);
+        canvas_execute(canvas, command, 0, 0, canvas->phys_width, canvas->phys_height);
+    }
+}
+
+// MARK: Display lists
+struct canvas_list_t {
+    canvas_command_t* commands;  // recording of the current frame
+    int32_t command_count;
+    int32_t command_capacity;
+    canvas_command_t* drawn;  // recording of the last drawn frame
+    int32_t drawn_count;
+    int32_t drawn_capacity;
+    int32_t drawn_width;  // physical canvas size of the drawn recording, 0 before the first frame
+    int32_t drawn_height;
+    bool out_of_memory;  // the recording is incomplete, the whole canvas is drawn once memory is available
+    canvas_rect_t damage[CANVAS_MAX_DIRTY_RECTS];
+    int32_t damage_count;
+};
+
+canvas_list_t* canvas_list_create(void) {
+    return calloc(1, sizeof(canvas_list_t));
+}
+
+void canvas_list_destroy(canvas_list_t* list) {
+    if (list == NULL)
+        return;
+    free(list->commands);
+    free(list->drawn);
+    free(list);
+}
+
+void canvas_begin_list(canvas_t* canvas, canvas_list_t* list) {
+    canvas->list = list;
+    list->command_count = 0;
+    list->out_of_memory = false;
+}
+
+static bool canvas_commands_equal(const canvas_command_t* a, const canvas_command_t* b) {
+    return a->type == b->type && a->rect.x == b->rect.x && a->rect.y == b->rect.y && a->rect.width == b->rect.width &&
+           a->rect.height == b->rect.height && a->color == b->color && a->image == b->image &&
+           a->image_x == b->image_x && a->image_y == b->image_y && a->image_width == b->image_width &&
+           a->src_width == b->src_width && a->src_height == b->src_height && a->scaled_width == b->scaled_width &&
+           a->scaled_height == b->scaled_height && a->filter == b->filter && a->mask == b->mask &&
+           a->mask_generation == b->mask_generation;
+}
+
+bool canvas_end_list(canvas_t* canvas) {
+    canvas_list_t* list = canvas->list;
+    canvas->list = NULL;
+    list->damage_count = 0;
+    if (list->out_of_memory || list->drawn_width != canvas->phys_width || list->drawn_height != canvas->phys_height) {
+        canvas_rect_t all = {0, 0, canvas->phys_width, canvas->phys_height};
+        canvas_rects_add(list->damage, &list->damage_count, all);
+        return true;
+    }
+
+    // Commands are compared by position, a changed command damages its old and its new rect
+    int32_t count = list->command_count > list->drawn_count ? list->command_count : list->drawn_count;
+    for (int32_t i = 0; i < count; i++) {
+        bool recorded = i < list->command_count;
+        bool drawn = i < list->drawn_count;
+        if (recorded && drawn && canvas_commands_equal(&list->commands[i], &list->drawn[i]))
+            continue;
+        if (recorded)
+            canvas_rects_add(list->damage, &list->damage_count, list->commands[i].rect);
+        if (drawn)
+            canvas_rects_add(list->damage, &list->damage_count, list->drawn[i].rect);
+    }
+    return list->damage_count > 0;
+}
+
+void canvas_draw_list(canvas_t* canvas, canvas_list_t* list, bool redraw) {
+    if (redraw) {
+        list->damage_count = 0;
+        canvas_rect_t all = {0, 0, canvas->phys_width, canvas->phys_height};
+        canvas_rects_add(list->damage, &list->damage_count, all);
+    }
+
+    // Replay the commands that touch the damage clipped to it, the damage rects don't overlap
+    // so every pixel is blended once
+    for (int32_t i = 0; i < list->damage_count; i++) {
+        canvas_rect_t damage = list->damage[i];
+        canvas_add_dirty_rect(canvas, damage.x, damage.y, damage.width, damage.height);
+        for (int32_t j = 0; j < list->command_count; j++) {
+            canvas_command_t command = list->commands[j];
+            int32_t x1 = command.rect.x > damage.x ? command.rect.x : damage.x;
+            int32_t y1 = command.rect.y > damage.y ? command.rect.y : damage.y;
+            int32_t x2 = command.rect.x + command.rect.width < damage.x + damage.width
+                             ? command.rect.x + command.rect.width
+                             : damage.x + damage.width;
+            int32_t y2 = command.rect.y + command.rect.height < damage.y + damage.height
+                             ? command.rect.y + command.rect.height
+                             : damage.y + damage.height;
+            if (x1 >= x2 || y1 >= y2)
+                continue;
+            command.rect.x = x1;
+            command.rect.y = y1;
+            command.rect.width = x2 - x1;
+            command.rect.height = y2 - y1;
+            canvas_dispatch(canvas, &command);
+        }
+    }
+    list->damage_count = 0;
+
+    // The recording becomes the drawn frame, its array is reused for the next recording
+    canvas_command_t* commands = list->drawn;
+    int32_t capacity = list->drawn_capacity;
+    list->drawn = list->commands;
+    list->drawn_count = list->command_count;
+    list->drawn_capacity = list->command_capacity;
+    list->commands = commands;
+    list->command_count = 0;
+    list->command_capacity = capacity;
+    list->drawn_width = list->out_of_memory ? 0 : canvas->phys_width;
+    list->drawn_height = list->out_of_memory ? 0 : canvas->phys_height;
+}
+
+// Mark the rect of a command dirty and run it, or record it in the display list
+static void canvas_submit(canvas_t* canvas, const canvas_command_t* command) {
+    if (command->rect.width <= 0 || command->rect.height <= 0)
+        return;
+    canvas_list_t* list = canvas->list;
+    if (list == NULL) {
+        canvas_add_dirty_rect(canvas, command->rect.x, command->rect.y, command->rect.width, command->rect.height);
+        canvas_dispatch(canvas, command);
+        return;
+    }
+
+    // Merge a fill into the last one when they have the same color and together form a rect
+    if (command->type == CANVAS_COMMAND_FILL && list->command_count > 0) {
+        canvas_command_t* last = &list->commands[list->command_count - 1];
+        canvas_rect_t* a = &last->rect;
+        const canvas_rect_t* b = &command->rect;
+        if (last->type == CANVAS_COMMAND_FILL && last->color == command->color) {
+            if (a->y == b->y && a->height == b->height && a->x + a->width == b->x) {
+                a->width += b->width;
+                return;
+            }
+            if (a->x == b->x && a->width == b->width && a->y + a->height == b->y) {
+                a->height += b->height;
+                return;
+            }
+        }
+    }
+    if (!canvas_commands_push(&list->commands, &list->command_count, &list->command_capacity, command))
+        list->out_of_memory = true;
+}
+
+// MARK: Drawing
+void canvas_clear(canvas_t* canvas, uint32_t color) {
+    // Everything drawn before is overwritten, so recorded commands can be dropped
+    if (canvas->list != NULL) {
+        canvas->list->command_count = 0;
+    } else {
+        canvas->dirty_count = 0;
+        if (canvas->tiler != NULL)
+            canvas->tiler->command_count = 0;
+    }
+    canvas_command_t command = {
+        .type = CANVAS_COMMAND_FILL, .rect = {0, 0, canvas->phys_width, canvas->phys_height}, .color = color};
+    canvas_submit(canvas, &command);
+}
+
+// Physical pixel that contains a physical position, also for negative positions
+static inline int32_t canvas_floor(float value) {
+    return (int32_t)value - ((float)(int32_t)value > value);
+}
+
+// Convert a logical rect to physical pixel edges clamped to the canvas, the rect can be empty
+static void canvas_scale_rect(canvas_t* canvas, float x, float y, float w, float h, int32_t* x1, int32_t* y1,
+                              int32_t* x2, int32_t* y2) {
     // All math in float; only convert to int at the pixel boundary
     float px = x * canvas->scale;
     float py = y * canvas->scale;
     float px2 = px + w * canvas->scale;
     float py2 = py + h * canvas->scale;
 
-    // Clip to physical canvas bounds
+    // Clip to physical canvas bounds, both edges of rects past the canvas end on it
     if (px < 0.0f)
         px = 0.0f;
     if (py < 0.0f)
         py = 0.0f;
+    if (px > (float)canvas->phys_width)
+        px = (float)canvas->phys_width;
+    if (py > (float)canvas->phys_height)
+        py = (float)canvas->phys_height;
     if (px2 > (float)canvas->phys_width)
         px2 = (float)canvas->phys_width;
     if (py2 > (float)canvas->phys_height)
         py2 = (float)canvas->phys_height;
-    if (px >= px2 || py >= py2)
+
+    *x1 = (int32_t)px;
+    *y1 = (int32_t)py;
+    *x2 = px2 > px ? (int32_t)px2 : *x1;
+    *y2 = py2 > py ? (int32_t)py2 : *y1;
+}
+
+// Convert a logical rect to physical pixels clipped to the canvas, returns 0 when nothing is left
+static int canvas_clip_rect(canvas_t* canvas, float x, float y, float w, float h, int32_t* x1, int32_t* y1,
+                            int32_t* x2, int32_t* y2) {
+    canvas_scale_rect(canvas, x, y, w, h, x1, y1, x2, y2);
+    return *x1 < *x2 && *y1 < *y2;
+}
+
+static void canvas_fill_pixels(canvas_t* canvas, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint32_t color) {
+    canvas_command_t command = {.type = CANVAS_COMMAND_FILL, .rect = {x1, y1, x2 - x1, y2 - y1}, .color = color};
+    canvas_submit(canvas, &command);
+}
+
+void canvas_fill_rect(canvas_t* canvas, float x, float y, float w, float h, uint32_t color) {
+    int32_t x1, y1, x2, y2;
+    canvas_scale_rect(canvas, x, y, w, h, &x1, &y1, &x2, &y2);
+    canvas_fill_pixels(canvas, x1, y1, x2, y2, color);
+}
+
+void canvas_stroke_rect(canvas_t* canvas, float x, float y, float w, float h, float line_width, uint32_t color) {
+    if (w <= 0.0f || h <= 0.0f || line_width <= 0.0f)
+        return;
+    int32_t ox1, oy1, ox2, oy2;
+    canvas_scale_rect(canvas, x, y, w, h, &ox1, &oy1, &ox2, &oy2);
+    if (w <= line_width * 2.0f || h <= line_width * 2.0f) {
+        canvas_fill_pixels(canvas, ox1, oy1, ox2, oy2, color);
         return;
+    }
 
-    int32_t x1 = (int32_t)px;
-    int32_t y1 = (int32_t)py;
-    int32_t x2 = (int32_t)px2;
-    int32_t y2 = (int32_t)py2;
-    int32_t stride = canvas->phys_width;
-    int32_t count = x2 - x1;
-    for (int32_t row = y1; row < y2; row++) {
-        uint32_t* dst = canvas->pixels + row * stride + x1;
-        for (int32_t col = 0; col < count; col++) {
-            dst[col] = color;
+    // Scale the outer and the inner rect once, the edges are the bands between them
+    int32_t ix1, iy1, ix2, iy2;
+    canvas_scale_rect(canvas, x + line_width, y + line_width, w - line_width * 2.0f, h - line_width * 2.0f, &ix1,
+                      &iy1, &ix2, &iy2);
+    canvas_fill_pixels(canvas, ox1, oy1, ox2, iy1, color);
+    canvas_fill_pixels(canvas, ox1, iy2, ox2, oy2, color);
+    canvas_fill_pixels(canvas, ox1, iy1, ix1, iy2, color);
+    canvas_fill_pixels(canvas, ix2, iy1, ox2, iy2, color);
+}
+
+void canvas_blend_rect(canvas_t* canvas, float x, float y, float w, float h, uint32_t color) {
+    uint32_t alpha = color >> 24;
+    if (alpha == 0)
+        return;
+    if (alpha == 255) {
+        canvas_fill_rect(canvas, x, y, w, h, color);
+        return;
+    }
+    int32_t x1, y1, x2, y2;
+    if (!canvas_clip_rect(canvas, x, y, w, h, &x1, &y1, &x2, &y2))
+        return;
+
+    // Premultiply the color once
+    uint32_t premultiplied = alpha << 24;
+    for (uint32_t shift = 0; shift < 24; shift += 8)
+        premultiplied |= canvas_div255(((color >> shift) & 0xff) * alpha) << shift;
+    canvas_command_t command = {
+        .type = CANVAS_COMMAND_BLEND, .rect = {x1, y1, x2 - x1, y2 - y1}, .color = premultiplied};
+    canvas_submit(canvas, &command);
+}
+
+void canvas_blend_image(canvas_t* canvas, float x, float y, int32_t width, int32_t height, const uint32_t* pixels) {
+    // The image is not scaled, its origin is the physical pixel of its logical position
+    int32_t ox = canvas_floor(x * canvas->scale);
+    int32_t oy = canvas_floor(y * canvas->scale);
+    int32_t x1 = ox > 0 ? ox : 0;
+    int32_t y1 = oy > 0 ? oy : 0;
+    int32_t x2 = ox + width < canvas->phys_width ? ox + width : canvas->phys_width;
+    int32_t y2 = oy + height < canvas->phys_height ? oy + height : canvas->phys_height;
+    if (x1 >= x2 || y1 >= y2)
+        return;
+    canvas_command_t command = {.type = CANVAS_COMMAND_IMAGE,
+                                .rect = {x1, y1, x2 - x1, y2 - y1},
+                                .image = pixels,
+                                .image_x = ox,
+                                .image_y = oy,
+                                .image_width = width};
+    canvas_submit(canvas, &command);
+}
+
+void canvas_draw_image(canvas_t* canvas, const uint32_t* pixels, int32_t width, int32_t height, int32_t stride,
+                       float x, float y, float w, float h, canvas_filter_t filter) {
+    if (width <= 0 || height <= 0)
+        return;
+    int32_t ox = canvas_floor(x * canvas->scale);
+    int32_t oy = canvas_floor(y * canvas->scale);
+    int32_t scaled_width = canvas_floor((x + w) * canvas->scale) - ox;
+    int32_t scaled_height = canvas_floor((y + h) * canvas->scale) - oy;
+    if (scaled_width <= 0 || scaled_height <= 0)
+        return;
+    int32_t x1 = ox > 0 ? ox : 0;
+    int32_t y1 = oy > 0 ? oy : 0;
+    int32_t x2 = ox + scaled_width < canvas->phys_width ? ox + scaled_width : canvas->phys_width;
+    int32_t y2 = oy + scaled_height < canvas->phys_height ? oy + scaled_height : canvas->phys_height;
+    if (x1 >= x2 || y1 >= y2)
+        return;
+    canvas_command_t command = {.type = CANVAS_COMMAND_SCALED_IMAGE,
+                                .rect = {x1, y1, x2 - x1, y2 - y1},
+                                .image = pixels,
+                                .image_x = ox,
+                                .image_y = oy,
+                                .image_width = stride,
+                                .src_width = width,
+                                .src_height = height,
+                                .scaled_width = scaled_width,
+                                .scaled_height = scaled_height,
+                                .filter = filter};
+    canvas_submit(canvas, &command);
+}
+
+// MARK: Text
+// Side of the square coverage texture the glyphs are packed into, on shelves as high as their tallest glyph
+#define CANVAS_ATLAS_SIZE 1024
+// Slots of the glyph hash table, the atlas starts over when 3/4 of them are used or the texture is full
+#define CANVAS_MAX_GLYPHS 2048
+// Slots of the layout cache, a string takes the slot of its hash
+#define CANVAS_TEXT_LAYOUTS 256
+
+typedef struct canvas_glyph_t {
+    const uint8_t (*bitmap_font)[8];  // NULL for a free slot
+    int32_t size;                     // physical cell size
+    uint8_t code;
+    int16_t atlas_x;  // coverage rect in the atlas, empty for blank glyphs
+    int16_t atlas_y;
+    int16_t width;
+    int16_t height;
+    int16_t bearing_x;  // offset of the coverage rect from the pen position and the top of the cell
+    int16_t bearing_y;
+    int16_t advance;
+} canvas_glyph_t;
+
+typedef struct canvas_text_layout_t {
+    char* text;  // NULL for a free slot
+    const uint8_t (*bitmap_font)[8];
+    int32_t size;
+    uint32_t generation;  // atlas generation the glyph slots belong to
+    int32_t* glyphs;      // glyph slot of every character
+    int32_t* pens;        // physical pen position of every character
+    int32_t glyph_count;
+    int32_t width;
+} canvas_text_layout_t;
+
+struct canvas_text_cache_t {
+    uint8_t atlas[CANVAS_ATLAS_SIZE * CANVAS_ATLAS_SIZE];
+    int32_t shelf_x;
+    int32_t shelf_y;
+    int32_t shelf_height;
+    uint32_t generation;  // incremented every time the atlas starts over
+    canvas_glyph_t glyphs[CANVAS_MAX_GLYPHS];
+    int32_t glyph_count;
+    canvas_text_layout_t layouts[CANVAS_TEXT_LAYOUTS];
+};
+
+// FNV-1a
+static uint32_t canvas_hash(uint32_t hash, const void* data, size_t size) {
+    const uint8_t* bytes = data;
+    for (size_t i = 0; i < size; i++)
+        hash = (hash ^ bytes[i]) * 16777619u;
+    return hash;
+}
+
+canvas_text_cache_t* canvas_text_cache_create(void) {
+    return calloc(1, sizeof(canvas_text_cache_t));
+}
+
+void canvas_text_cache_destroy(canvas_text_cache_t* cache) {
+    if (cache == NULL)
+        return;
+    for (int32_t i = 0; i < CANVAS_TEXT_LAYOUTS; i++) {
+        free(cache->layouts[i].text);
+        free(cache->layouts[i].glyphs);
+        free(cache->layouts[i].pens);
+    }
+    free(cache);
+}
+
+// Empty the atlas, recorded commands still blend from it so they are rasterized first
+static void canvas_text_cache_reset(canvas_t* canvas, canvas_text_cache_t* cache) {
+    if (canvas->tiler != NULL)
+        canvas_tiler_flush(canvas->tiler, canvas);
+    memset(cache->glyphs, 0, sizeof(cache->glyphs));
+    cache->glyph_count = 0;
+    cache->shelf_x = 0;
+    cache->shelf_y = 0;
+    cache->shelf_height = 0;
+    cache->generation++;
+}
+
+// Box filter a glyph bitmap to a cell of size pixels. In units where a bitmap pixel is size wide
+// and a cell pixel 8, the coverage of a cell pixel is the area of the set bitmap pixels over it
+static void canvas_rasterize_glyph(const uint8_t* rows, int32_t size, uint8_t* cell) {
+    for (int32_t y = 0; y < size; y++) {
+        for (int32_t x = 0; x < size; x++) {
+            uint32_t area = 0;
+            for (int32_t by = y * 8 / size; by <= (y * 8 + 7) / size; by++) {
+                int32_t top = by * size > y * 8 ? by * size : y * 8;
+                int32_t bottom = (by + 1) * size < y * 8 + 8 ? (by + 1) * size : y * 8 + 8;
+                for (int32_t bx = x * 8 / size; bx <= (x * 8 + 7) / size; bx++) {
+                    if ((rows[by] & (0x80 >> bx)) == 0)
+                        continue;
+                    int32_t left = bx * size > x * 8 ? bx * size : x * 8;
+                    int32_t right = (bx + 1) * size < x * 8 + 8 ? (bx + 1) * size : x * 8 + 8;
+                    area += (uint32_t)((right - left) * (bottom - top));
+                }
+            }
+            cell[y * size + x] = (uint8_t)((area * 255 + 32) / 64);
         }
     }
 }
 
-void canvas_stroke_rect(canvas_t* canvas, float x, float y, float w, float h, float line_width, uint32_t color) {
-    if (w <= 0.0f || h <= 0.0f || line_width <= 0.0f)
+// Find the atlas slot of a glyph and rasterize it the first time, returns -1 when it doesn't fit in an empty atlas
+static int32_t canvas_text_glyph(canvas_t* canvas, canvas_text_cache_t* cache, const uint8_t (*bitmap_font)[8],
+                                 int32_t size, uint8_t code) {
+    uint32_t hash = canvas_hash(2166136261u, (const void*)&bitmap_font, sizeof(bitmap_font));
+    hash = canvas_hash(hash, &size, sizeof(size));
+    hash = canvas_hash(hash, &code, sizeof(code));
+    int32_t slot = (int32_t)(hash & (CANVAS_MAX_GLYPHS - 1));
+    while (cache->glyphs[slot].bitmap_font != NULL) {
+        canvas_glyph_t* glyph = &cache->glyphs[slot];
+        if (glyph->bitmap_font == bitmap_font && glyph->size == size && glyph->code == code)
+            return slot;
+        slot = (slot + 1) & (CANVAS_MAX_GLYPHS - 1);
+    }
+
+    // Printable ASCII starts at its first column and advances one column past its last,
+    // a space is half a cell and the other glyphs are full cells so box drawing connects
+    const uint8_t* rows = bitmap_font[code];
+    uint8_t columns = 0;
+    for (int32_t i = 0; i < 8; i++)
+        columns |= rows[i];
+    int32_t start = 0;
+    int32_t advance = 8;
+    if (code == ' ') {
+        advance = 4;
+    } else if (code > ' ' && code < 127 && columns != 0) {
+        int32_t end = 7;
+        while ((columns & (0x80 >> start)) == 0)
+            start++;
+        while ((columns & (0x80 >> end)) == 0)
+            end--;
+        advance = end - start + 2;
+    }
+
+    // Crop the rasterized cell to its covered pixels
+    uint8_t cell[CANVAS_MAX_GLYPH_SIZE * CANVAS_MAX_GLYPH_SIZE];
+    canvas_rasterize_glyph(rows, size, cell);
+    int32_t x1 = size, y1 = size, x2 = 0, y2 = 0;
+    for (int32_t y = 0; y < size; y++) {
+        for (int32_t x = 0; x < size; x++) {
+            if (cell[y * size + x] != 0) {
+                x1 = x < x1 ? x : x1;
+                y1 = y < y1 ? y : y1;
+                x2 = x + 1 > x2 ? x + 1 : x2;
+                y2 = y + 1 > y2 ? y + 1 : y2;
+            }
+        }
+    }
+    int32_t width = x2 > x1 ? x2 - x1 : 0;
+    int32_t height = y2 > y1 ? y2 - y1 : 0;
+
+    // Pack it on the current shelf or start a new one, start over when the atlas is full
+    if (cache->shelf_x + width > CANVAS_ATLAS_SIZE) {
+        cache->shelf_x = 0;
+        cache->shelf_y += cache->shelf_height;
+        cache->shelf_height = 0;
+    }
+    if (cache->glyph_count >= CANVAS_MAX_GLYPHS * 3 / 4 || cache->shelf_y + height > CANVAS_ATLAS_SIZE) {
+        if (cache->glyph_count == 0)
+            return -1;
+        canvas_text_cache_reset(canvas, cache);
+        return canvas_text_glyph(canvas, cache, bitmap_font, size, code);
+    }
+
+    canvas_glyph_t* glyph = &cache->glyphs[slot];
+    glyph->bitmap_font = bitmap_font;
+    glyph->size = size;
+    glyph->code = code;
+    glyph->atlas_x = (int16_t)cache->shelf_x;
+    glyph->atlas_y = (int16_t)cache->shelf_y;
+    glyph->width = (int16_t)width;
+    glyph->height = (int16_t)height;
+    glyph->bearing_x = (int16_t)(x1 - start * size / 8);
+    glyph->bearing_y = (int16_t)y1;
+    glyph->advance = (int16_t)((advance * size + 4) / 8 > 0 ? (advance * size + 4) / 8 : 1);
+    for (int32_t y = 0; y < height; y++)
+        memcpy(&cache->atlas[(size_t)(cache->shelf_y + y) * CANVAS_ATLAS_SIZE + (size_t)cache->shelf_x],
+               &cell[(y1 + y) * size + x1], (size_t)width);
+    cache->shelf_x += width;
+    if (height > cache->shelf_height)
+        cache->shelf_height = height;
+    cache->glyph_count++;
+    return slot;
+}
+
+// Return the cached layout of a string or lay it out again, returns NULL when out of memory
+static canvas_text_layout_t* canvas_text_layout(canvas_t* canvas, canvas_text_cache_t* cache,
+                                                const uint8_t (*bitmap_font)[8], int32_t size, const char* text) {
+    size_t length = strlen(text);
+    uint32_t hash = canvas_hash(2166136261u, text, length);
+    hash = canvas_hash(hash, (const void*)&bitmap_font, sizeof(bitmap_font));
+    hash = canvas_hash(hash, &size, sizeof(size));
+    canvas_text_layout_t* layout = &cache->layouts[hash % CANVAS_TEXT_LAYOUTS];
+    if (layout->text != NULL && layout->bitmap_font == bitmap_font && layout->size == size &&
+        layout->generation == cache->generation && strcmp(layout->text, text) == 0)
+        return layout;
+
+    char* copy = realloc(layout->text, length + 1);
+    if (copy == NULL)
+        return NULL;
+    layout->text = copy;
+    memcpy(layout->text, text, length + 1);
+    int32_t* glyphs = realloc(layout->glyphs, (length + 1) * sizeof(int32_t));
+    if (glyphs == NULL) {
+        layout->text[0] = '\0';
+        return NULL;
+    }
+    layout->glyphs = glyphs;
+    int32_t* pens = realloc(layout->pens, (length + 1) * sizeof(int32_t));
+    if (pens == NULL) {
+        layout->text[0] = '\0';
+        return NULL;
+    }
+    layout->pens = pens;
+    layout->bitmap_font = bitmap_font;
+    layout->size = size;
+
+    // When the atlas starts over halfway, the glyphs before are gone, so the string is laid out again
+    // in the empty atlas. A string with more glyphs than the atlas holds is left empty
+    for (int32_t attempt = 0; attempt < 2; attempt++) {
+        uint32_t generation = cache->generation;
+        layout->glyph_count = 0;
+        layout->width = 0;
+        for (size_t i = 0; i < length; i++) {
+            int32_t slot = canvas_text_glyph(canvas, cache, bitmap_font, size, (uint8_t)text[i]);
+            if (slot < 0 || cache->generation != generation)
+                break;
+            layout->glyphs[layout->glyph_count] = slot;
+            layout->pens[layout->glyph_count] = layout->width;
+            layout->glyph_count++;
+            layout->width += cache->glyphs[slot].advance;
+        }
+        if (cache->generation == generation)
+            break;
+        layout->glyph_count = 0;
+        layout->width = 0;
+    }
+    layout->generation = cache->generation;
+    return layout;
+}
+
+float canvas_measure_text(canvas_t* canvas, canvas_text_cache_t* cache, const uint8_t (*bitmap_font)[8], float size,
+                          const char* text) {
+    int32_t size_px = (int32_t)(size * canvas->scale + 0.5f);
+    if (size_px < 1 || size_px > CANVAS_MAX_GLYPH_SIZE)
+        return 0.0f;
+    canvas_text_layout_t* layout =
+        canvas_text_layout(canvas, cache, bitmap_font != NULL ? bitmap_font : font, size_px, text);
+    return layout != NULL ? (float)layout->width / canvas->scale : 0.0f;
+}
+
+void canvas_draw_text(canvas_t* canvas, canvas_text_cache_t* cache, const uint8_t (*bitmap_font)[8], float x, float y,
+                      float size, const char* text, uint32_t color) {
+    int32_t size_px = (int32_t)(size * canvas->scale + 0.5f);
+    if (size_px < 1 || size_px > CANVAS_MAX_GLYPH_SIZE)
+        return;
+    canvas_text_layout_t* layout =
+        canvas_text_layout(canvas, cache, bitmap_font != NULL ? bitmap_font : font, size_px, text);
+    if (layout == NULL)
         return;
-    float lw = line_width;
-    // Top and bottom edges
-    canvas_fill_rect(canvas, x, y, w, lw, color);
-    canvas_fill_rect(canvas, x, y + h - lw, w, lw, color);
-    // Left and right edges (excluding corners already drawn)
-    if (h > lw * 2.0f) {
-        canvas_fill_rect(canvas, x, y + lw, lw, h - lw * 2.0f, color);
-        canvas_fill_rect(canvas, x + w - lw, y + lw, lw, h - lw * 2.0f, color);
+
+    // The glyphs are not scaled, the pen starts at the physical pixel of the logical position
+    float fx = x * canvas->scale;
+    float fy = y * canvas->scale;
+    int32_t ox = (int32_t)fx - ((float)(int32_t)fx > fx);
+    int32_t oy = (int32_t)fy - ((float)(int32_t)fy > fy);
+    uint32_t opaque = 0xff000000 | (color & 0xffffff);
+    for (int32_t i = 0; i < layout->glyph_count; i++) {
+        canvas_glyph_t* glyph = &cache->glyphs[layout->glyphs[i]];
+        int32_t gx = ox + layout->pens[i] + glyph->bearing_x;
+        int32_t gy = oy + glyph->bearing_y;
+        int32_t x1 = gx > 0 ? gx : 0;
+        int32_t y1 = gy > 0 ? gy : 0;
+        int32_t x2 = gx + glyph->width < canvas->phys_width ? gx + glyph->width : canvas->phys_width;
+        int32_t y2 = gy + glyph->height < canvas->phys_height ? gy + glyph->height : canvas->phys_height;
+        if (x1 >= x2 || y1 >= y2)
+            continue;
+        const uint8_t* mask = &cache->atlas[(size_t)glyph->atlas_y * CANVAS_ATLAS_SIZE + (size_t)glyph->atlas_x];
+        canvas_command_t command = {.type = CANVAS_COMMAND_MASK,
+                                    .rect = {x1, y1, x2 - x1, y2 - y1},
+                                    .color = opaque,
+                                    .image_x = gx,
+                                    .image_y = gy,
+                                    .image_width = CANVAS_ATLAS_SIZE,
+                                    .mask = mask,
+                                    .mask_generation = cache->generation};
+        canvas_submit(canvas, &command);
+    }
+}
+
+// MARK: Tests
+#ifdef TEST
+
+#include <CUnit/Basic.h>
+
+#define TEST_WIDTH 1280
+#define TEST_HEIGHT 720
+
+// Strokes and fills that hang over every edge of the canvas
+static void draw_off_edge_scene(canvas_t* canvas) {
+    canvas_clear(canvas, CANVAS_COLOR(255, 255, 255));
+    canvas_stroke_rect(canvas, 1270.0f, 700.0f, 200.0f, 200.0f, 15.0f, CANVAS_COLOR(255, 0, 0));
+    canvas_stroke_rect(canvas, -100.0f, -100.0f, 150.0f, 150.0f, 20.0f, CANVAS_COLOR(0, 255, 0));
+    canvas_stroke_rect(canvas, 1275.0f, -50.0f, 40.0f, 900.0f, 3.0f, CANVAS_COLOR(0, 0, 255));
+    canvas_stroke_rect(canvas, -20.0f, 715.0f, 1400.0f, 30.0f, 8.0f, CANVAS_COLOR(0, 0, 0));
+    canvas_fill_rect(canvas, 1300.0f, 800.0f, 50.0f, 50.0f, CANVAS_COLOR(255, 0, 255));
+    canvas_blend_rect(canvas, 1200.0f, 640.0f, 400.0f, 400.0f, CANVAS_ARGB(128, 0, 128, 255));
+}
+
+void test_canvas_tiled_off_edge(void) {
+    size_t size = (size_t)TEST_WIDTH * TEST_HEIGHT * sizeof(uint32_t);
+    uint32_t* direct_pixels = malloc(size);
+    uint32_t* tiled_pixels = malloc(size);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(direct_pixels);
+    CU_ASSERT_PTR_NOT_NULL_FATAL(tiled_pixels);
+
+    canvas_t direct;
+    canvas_init(&direct, TEST_WIDTH, TEST_HEIGHT, direct_pixels, 1.0f);
+    draw_off_edge_scene(&direct);
+
+    canvas_t tiled;
+    canvas_init(&tiled, TEST_WIDTH, TEST_HEIGHT, tiled_pixels, 1.0f);
+    canvas_tiler_t* tiler = canvas_tiler_create(4);
+    canvas_begin_tiled(&tiled, tiler);
+    draw_off_edge_scene(&tiled);
+    canvas_end_tiled(&tiled);
+    canvas_tiler_destroy(tiler);
+
+    CU_ASSERT_EQUAL(memcmp(direct_pixels, tiled_pixels, size), 0);
+    free(direct_pixels);
+    free(tiled_pixels);
+}
+
+#endif
+
+// MARK: Benchmarks
+#ifdef BENCH
+
+#include <bob/bench.h>
+#include <stdio.h>
+
+// A 4K buffer, like a 1920x1080 window at scale 2
+#define BENCH_WIDTH 1920
+#define BENCH_HEIGHT 1080
+#define BENCH_SCALE 2
+static uint32_t bench_pixels[BENCH_WIDTH * BENCH_SCALE * BENCH_HEIGHT * BENCH_SCALE];
+
+void bench_canvas_clear_4k(bench_t* bench) {
+    canvas_t canvas;
+    canvas_init(&canvas, BENCH_WIDTH, BENCH_HEIGHT, bench_pixels, (float)BENCH_SCALE);
+    bench->bytes = sizeof(bench_pixels);
+    for (uint64_t i = 0; i < bench->iterations; i++) {
+        canvas_clear(&canvas, CANVAS_COLOR(255, 255, 255));
+        bench_black_box(bench_pixels);
     }
 }
+
+void bench_canvas_fill_rect_4k(bench_t* bench) {
+    canvas_t canvas;
+    canvas_init(&canvas, BENCH_WIDTH, BENCH_HEIGHT, bench_pixels, (float)BENCH_SCALE);
+    // Not full width, so every row is a separate span
+    bench->bytes = sizeof(bench_pixels) - (size_t)canvas.phys_height * sizeof(uint32_t);
+    for (uint64_t i = 0; i < bench->iterations; i++) {
+        canvas_fill_rect(&canvas, 0.5f, 0.0f, (float)BENCH_WIDTH, (float)BENCH_HEIGHT, CANVAS_COLOR(255, 0, 0));
+        bench_black_box(bench_pixels);
+    }
+}
+
+void bench_canvas_fill_span_scalar_4k(bench_t* bench) {
+    bench->bytes = sizeof(bench_pixels);
+    for (uint64_t i = 0; i < bench->iterations; i++) {
+        canvas_fill_span_scalar(bench_pixels, sizeof(bench_pixels) / sizeof(uint32_t), CANVAS_COLOR(0, 0, 255));
+        bench_black_box(bench_pixels);
+    }
+}
+
+void bench_canvas_blend_rect_4k(bench_t* bench) {
+    canvas_t canvas;
+    canvas_init(&canvas, BENCH_WIDTH, BENCH_HEIGHT, bench_pixels, (float)BENCH_SCALE);
+    bench->bytes = sizeof(bench_pixels);
+    for (uint64_t i = 0; i < bench->iterations; i++) {
+        canvas_blend_rect(&canvas, 0.0f, 0.0f, (float)BENCH_WIDTH, (float)BENCH_HEIGHT, CANVAS_ARGB(128, 0, 0, 0));
+        bench_black_box(bench_pixels);
+    }
+}
+
+void bench_canvas_blend_image_4k(bench_t* bench) {
+    canvas_t canvas;
+    canvas_init(&canvas, BENCH_WIDTH, BENCH_HEIGHT, bench_pixels, (float)BENCH_SCALE);
+    static uint32_t image[BENCH_WIDTH * BENCH_SCALE * BENCH_HEIGHT * BENCH_SCALE];
+    for (size_t i = 0; i < sizeof(image) / sizeof(uint32_t); i++)
+        image[i] = (uint32_t)(i & 0xff) * 0x01010101u;
+    bench->bytes = sizeof(bench_pixels);
+    for (uint64_t i = 0; i < bench->iterations; i++) {
+        canvas_blend_image(&canvas, 0.0f, 0.0f, canvas.phys_width, canvas.phys_height, image);
+        bench_black_box(bench_pixels);
+    }
+}
+
+// A 1080p frame scaled to the 4K canvas, the logical size of the canvas is the size of the image
+static uint32_t bench_image[BENCH_WIDTH * BENCH_HEIGHT];
+
+static void bench_canvas_draw_image(canvas_filter_t filter, float w, float h, bench_t* bench) {
+    canvas_t canvas;
+    canvas_init(&canvas, BENCH_WIDTH, BENCH_HEIGHT, bench_pixels, (float)BENCH_SCALE);
+    for (size_t i = 0; i < sizeof(bench_image) / sizeof(uint32_t); i++)
+        bench_image[i] = (uint32_t)(i * 2654435761u);
+    bench->bytes = sizeof(bench_pixels);
+    for (uint64_t i = 0; i < bench->iterations; i++) {
+        canvas_draw_image(&canvas, bench_image, BENCH_WIDTH, BENCH_HEIGHT, BENCH_WIDTH, 0.0f, 0.0f, w, h, filter);
+        bench_black_box(bench_pixels);
+    }
+}
+
+void bench_canvas_draw_image_nearest_2x_4k(bench_t* bench) {
+    bench_canvas_draw_image(CANVAS_FILTER_NEAREST, (float)BENCH_WIDTH, (float)BENCH_HEIGHT, bench);
+}
+
+// Not an integer scale, every pixel samples its own source position
+void bench_canvas_draw_image_nearest_4k(bench_t* bench) {
+    bench_canvas_draw_image(CANVAS_FILTER_NEAREST, BENCH_WIDTH * 0.75f, BENCH_HEIGHT * 0.75f, bench);
+}
+
+void bench_canvas_draw_image_bilinear_4k(bench_t* bench) {
+    bench_canvas_draw_image(CANVAS_FILTER_BILINEAR, (float)BENCH_WIDTH, (float)BENCH_HEIGHT, bench);
+}
+
+void bench_canvas_blend_span_scalar_4k(bench_t* bench) {
+    uint32_t color = CANVAS_ARGB(128, 0, 0, 0);
+    bench->bytes = sizeof(bench_pixels);
+    for (uint64_t i = 0; i < bench->iterations; i++) {
+        canvas_blend_span_scalar(bench_pixels, &color, 0, sizeof(bench_pixels) / sizeof(uint32_t));
+        bench_black_box(bench_pixels);
+    }
+}
+
+// A screen of labels at scale 2, after the first iteration every string comes from the layout cache
+void bench_canvas_text_4k(bench_t* bench) {
+    canvas_t canvas;
+    canvas_init(&canvas, BENCH_WIDTH, BENCH_HEIGHT, bench_pixels, (float)BENCH_SCALE);
+    canvas_text_cache_t* cache = canvas_text_cache_create();
+    char lines[64][32];
+    for (int32_t i = 0; i < 64; i++)
+        snprintf(lines[i], sizeof(lines[i]), "Sensor %d: %d.%d C", i, 20 + i % 10, i % 7);
+    for (uint64_t i = 0; i < bench->iterations; i++) {
+        for (int32_t j = 0; j < 64; j++)
+            canvas_draw_text(&canvas, cache, NULL, (float)(j % 4) * 480.0f, (float)(j / 4) * 64.0f, 16.0f, lines[j],
+                             CANVAS_COLOR(0, 0, 0));
+        bench_black_box(bench_pixels);
+    }
+    canvas_text_cache_destroy(cache);
+}
+
+// The scene of the example at scale 2, drawn directly
+static void bench_canvas_scene(canvas_t* canvas) {
+    canvas_clear(canvas, CANVAS_COLOR(255, 255, 255));
+    for (int32_t i = 0; i < 32; i++) {
+        float x = (float)(i % 8) * 240.0f;
+        float y = (float)(i / 8) * 270.0f;
+        canvas_fill_rect(canvas, x + 8.0f, y + 8.0f, 224.0f, 254.0f, CANVAS_COLOR(i * 8, 128, 255 - i * 8));
+        canvas_stroke_rect(canvas, x + 16.0f, y + 16.0f, 208.0f, 238.0f, 4.0f, CANVAS_COLOR(0, 0, 0));
+    }
+    canvas_blend_rect(canvas, 100.0f, 100.0f, 1720.0f, 880.0f, CANVAS_ARGB(96, 0, 0, 0));
+}
+
+void bench_canvas_scene_4k(bench_t* bench) {
+    canvas_t canvas;
+    canvas_init(&canvas, BENCH_WIDTH, BENCH_HEIGHT, bench_pixels, (float)BENCH_SCALE);
+    for (uint64_t i = 0; i < bench->iterations; i++) {
+        bench_canvas_scene(&canvas);
+        bench_black_box(bench_pixels);
+    }
+}
+
+void bench_canvas_scene_tiled_4k(bench_t* bench) {
+    canvas_t canvas;
+    canvas_init(&canvas, BENCH_WIDTH, BENCH_HEIGHT, bench_pixels, (float)BENCH_SCALE);
+    canvas_tiler_t* tiler = canvas_tiler_create(4);
+    for (uint64_t i = 0; i < bench->iterations; i++) {
+        canvas_begin_tiled(&canvas, tiler);
+        bench_canvas_scene(&canvas);
+        canvas_end_tiled(&canvas);
+        bench_black_box(bench_pixels);
+    }
+    canvas_tiler_destroy(tiler);
+}
+
+// The scene recorded in a display list and compared with the last frame, nothing changed so nothing is drawn
+void bench_canvas_scene_list_unchanged_4k(bench_t* bench) {
+    canvas_t canvas;
+    canvas_init(&canvas, BENCH_WIDTH, BENCH_HEIGHT, bench_pixels, (float)BENCH_SCALE);
+    canvas_list_t* list = canvas_list_create();
+    for (uint64_t i = 0; i < bench->iterations; i++) {
+        canvas_begin_list(&canvas, list);
+        bench_canvas_scene(&canvas);
+        if (canvas_end_list(&canvas))
+            canvas_draw_list(&canvas, list, false);
+        canvas_clear_dirty_rects(&canvas);
+        bench_black_box(bench_pixels);
+    }
+    canvas_list_destroy(list);
+}
+
+// The scene with one rect that changes color every frame, only that rect is drawn again
+void bench_canvas_scene_list_changed_4k(bench_t* bench) {
+    canvas_t canvas;
+    canvas_init(&canvas, BENCH_WIDTH, BENCH_HEIGHT, bench_pixels, (float)BENCH_SCALE);
+    canvas_list_t* list = canvas_list_create();
+    for (uint64_t i = 0; i < bench->iterations; i++) {
+        canvas_begin_list(&canvas, list);
+        bench_canvas_scene(&canvas);
+        canvas_fill_rect(&canvas, 960.0f, 540.0f, 64.0f, 32.0f, CANVAS_COLOR(i & 0xff, 0, 0));
+        if (canvas_end_list(&canvas))
+            canvas_draw_list(&canvas, list, false);
+        canvas_clear_dirty_rects(&canvas);
+        bench_black_box(bench_pixels);
+    }
+    canvas_list_destroy(list);
+}
+
+#endif
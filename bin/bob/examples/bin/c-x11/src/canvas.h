@@ -6,9 +6,41 @@
 
 #pragma once
 
+#include <stdbool.h>
 #include <stdint.h>
 
 #define CANVAS_COLOR(r, g, b) ((uint32_t)(((uint32_t)(r) << 16) | ((uint32_t)(g) << 8) | (uint32_t)(b)))
+#define CANVAS_ARGB(a, r, g, b) ((uint32_t)((uint32_t)(a) << 24) | CANVAS_COLOR(r, g, b))
+
+// Most dirty rects a canvas keeps, more rects are merged into the one that grows least
+#define CANVAS_MAX_DIRTY_RECTS 16
+
+// Rect in physical pixels
+typedef struct canvas_rect_t {
+    int32_t x;
+    int32_t y;
+    int32_t width;
+    int32_t height;
+} canvas_rect_t;
+
+// Side of the square screen tiles the tiled renderer rasterizes in parallel
+#define CANVAS_TILE_SIZE 64
+
+// Worker pool of the tiled renderer, draw calls between canvas_begin_tiled and canvas_end_tiled are recorded,
+// binned into tiles and rasterized in parallel, the result is the same as drawing them directly
+typedef struct canvas_tiler_t canvas_tiler_t;
+
+// Retained display list, draw calls between canvas_begin_list and canvas_end_list are recorded clipped and scaled
+// to physical pixels, compared with the last drawn recording and only the changed regions are drawn again
+typedef struct canvas_list_t canvas_list_t;
+
+// Largest glyph cell in physical pixels that text is drawn with, larger text is skipped
+#define CANVAS_MAX_GLYPH_SIZE 128
+
+// Glyph atlas and text layout cache. Glyphs of 8x8 bitmap fonts are rasterized once per font and physical size
+// into a packed coverage texture, the glyph positions of a string are kept so unchanged strings aren't laid out
+// again every frame
+typedef struct canvas_text_cache_t canvas_text_cache_t;
 
 typedef struct canvas_t {
     int32_t width;        // logical width in design units
@@ -17,10 +49,82 @@ typedef struct canvas_t {
     int32_t phys_height;  // physical pixel height
     float scale;
     uint32_t* pixels;
+    // Regions drawn since the dirty rects were cleared, overlapping and touching rects are merged
+    canvas_rect_t dirty_rects[CANVAS_MAX_DIRTY_RECTS];
+    int32_t dirty_count;
+    canvas_tiler_t* tiler;  // recording tiler, NULL when drawing directly
+    canvas_list_t* list;    // recording display list, NULL when drawing
 } canvas_t;
 
 void canvas_init(canvas_t* canvas, int32_t width, int32_t height, uint32_t* pixels, float scale);
 
+// Add a rect in physical pixels to the dirty rects, every draw call adds what it draws
+void canvas_add_dirty_rect(canvas_t* canvas, int32_t x, int32_t y, int32_t width, int32_t height);
+
+void canvas_clear_dirty_rects(canvas_t* canvas);
+
+// Create a tiler that rasterizes on this many threads, the calling thread included, returns NULL on failure
+canvas_tiler_t* canvas_tiler_create(int32_t thread_count);
+
+void canvas_tiler_destroy(canvas_tiler_t* tiler);
+
+// Record the following draw calls in the tiler, a NULL tiler keeps drawing directly
+void canvas_begin_tiled(canvas_t* canvas, canvas_tiler_t* tiler);
+
+// Rasterize the recorded draw calls into the pixels, blended images must stay alive until then
+void canvas_end_tiled(canvas_t* canvas);
+
+canvas_list_t* canvas_list_create(void);
+
+void canvas_list_destroy(canvas_list_t* list);
+
+// Record the following draw calls in the list, adjacent fills of the same color are merged. Images are compared
+// by address, so draw the list again with redraw after the pixels of an image changed. The glyphs of the text in a
+// recording must fit in the atlas of the text cache together
+void canvas_begin_list(canvas_t* canvas, canvas_list_t* list);
+
+// Stop recording and compare the commands with the last drawn recording by position, returns true when anything
+// changed. A changed command damages its old and its new rect, a new canvas size damages the whole canvas
+bool canvas_end_list(canvas_t* canvas);
+
+// Draw the commands of the recording that touch the damage, clipped to it, and mark the damage dirty. Pass redraw
+// when the pixels don't hold the last drawn recording, then everything is drawn. Works inside canvas_begin_tiled
+void canvas_draw_list(canvas_t* canvas, canvas_list_t* list, bool redraw);
+
+void canvas_clear(canvas_t* canvas, uint32_t color);
+
 void canvas_fill_rect(canvas_t* canvas, float x, float y, float w, float h, uint32_t color);
 
 void canvas_stroke_rect(canvas_t* canvas, float x, float y, float w, float h, float line_width, uint32_t color);
+
+// Blend a translucent CANVAS_ARGB color over a rect, an opaque color takes the fill path
+void canvas_blend_rect(canvas_t* canvas, float x, float y, float w, float h, uint32_t color);
+
+// Blend an image of premultiplied ARGB pixels at a logical position, the image is not scaled
+void canvas_blend_image(canvas_t* canvas, float x, float y, int32_t width, int32_t height, const uint32_t* pixels);
+
+// How canvas_draw_image samples a scaled image
+typedef enum canvas_filter_t {
+    CANVAS_FILTER_NEAREST,   // the closest pixel, sharp icons and pixel art
+    CANVAS_FILTER_BILINEAR,  // the 4 closest pixels weighted by distance, smooth thumbnails and camera frames
+} canvas_filter_t;
+
+// Draw an image scaled to a logical rect, stride is the row length of the image in pixels. The pixels are copied
+// with their alpha, so translucent images at their own size go through canvas_blend_image instead. Nearest at 1x and
+// 2x copies rows and doubles pixels
+void canvas_draw_image(canvas_t* canvas, const uint32_t* pixels, int32_t width, int32_t height, int32_t stride,
+                       float x, float y, float w, float h, canvas_filter_t filter);
+
+canvas_text_cache_t* canvas_text_cache_create(void);
+
+void canvas_text_cache_destroy(canvas_text_cache_t* cache);
+
+// Logical width of a line of text drawn at a font size, bitmap_font is 256 glyphs of 8 rows with the left pixel in the
+// high bit like the C export of bin/pixelfont, NULL is the built-in CP437 font. Printable ASCII is proportional
+float canvas_measure_text(canvas_t* canvas, canvas_text_cache_t* cache, const uint8_t (*bitmap_font)[8], float size,
+                          const char* text);
+
+// Draw a line of text with the top left of its first glyph cell at a logical position, size is the logical
+// height of a glyph cell. The glyph edges are blended with their coverage of the pixels, the alpha of color is ignored
+void canvas_draw_text(canvas_t* canvas, canvas_text_cache_t* cache, const uint8_t (*bitmap_font)[8], float x, float y,
+                      float size, const char* text, uint32_t color);
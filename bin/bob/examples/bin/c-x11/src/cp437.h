@@ -0,0 +1,264 @@
+// Font: cp437.pf
+
+#pragma once
+
+#include <stdint.h>
+
+static const uint8_t font[256][8] = {
+    { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, /*   0     */
+    { 0x7E, 0x81, 0xA5, 0x81, 0xBD, 0x99, 0x81, 0x7E }, /*   1     */
+    { 0x7E, 0xFF, 0xDB, 0xFF, 0xC3, 0xE7, 0xFF, 0x7E }, /*   2     */
+    { 0x6C, 0xFE, 0xFE, 0xFE, 0x7C, 0x38, 0x10, 0x00 }, /*   3     */
+    { 0x10, 0x38, 0x7C, 0xFE, 0x7C, 0x38, 0x10, 0x00 }, /*   4     */
+    { 0x38, 0x7C, 0x38, 0xFE, 0xFE, 0xD6, 0x10, 0x38 }, /*   5     */
+    { 0x10, 0x38, 0x7C, 0xFE, 0xFE, 0x7C, 0x10, 0x38 }, /*   6     */
+    { 0x00, 0x00, 0x18, 0x3C, 0x3C, 0x18, 0x00, 0x00 }, /*   7     */
+    { 0xFF, 0xFF, 0xE7, 0xC3, 0xC3, 0xE7, 0xFF, 0xFF }, /*   8     */
+    { 0x00, 0x3C, 0x66, 0x42, 0x42, 0x66, 0x3C, 0x00 }, /*   9     */
+    { 0xFF, 0xC3, 0x99, 0xBD, 0xBD, 0x99, 0xC3, 0xFF }, /*  10     */
+    { 0x0F, 0x07, 0x0F, 0x7D, 0xCC, 0xCC, 0xCC, 0x78 }, /*  11     */
+    { 0x3C, 0x66, 0x66, 0x66, 0x3C, 0x18, 0x7E, 0x18 }, /*  12     */
+    { 0x3F, 0x33, 0x3F, 0x30, 0x30, 0x70, 0xF0, 0xE0 }, /*  13     */
+    { 0x7F, 0x63, 0x7F, 0x63, 0x63, 0x67, 0xE6, 0xC0 }, /*  14     */
+    { 0x18, 0xDB, 0x3C, 0xE7, 0xE7, 0x3C, 0xDB, 0x18 }, /*  15     */
+    { 0x80, 0xE0, 0xF8, 0xFE, 0xF8, 0xE0, 0x80, 0x00 }, /*  16     */
+    { 0x02, 0x0E, 0x3E, 0xFE, 0x3E, 0x0E, 0x02, 0x00 }, /*  17     */
+    { 0x18, 0x3C, 0x7E, 0x18, 0x18, 0x7E, 0x3C, 0x18 }, /*  18     */
+    { 0x66, 0x66, 0x66, 0x66, 0x66, 0x00, 0x66, 0x00 }, /*  19     */
+    { 0x7F, 0xDB, 0xDB, 0x7B, 0x1B, 0x1B, 0x1B, 0x00 }, /*  20     */
+    { 0x3E, 0x61, 0x3C, 0x66, 0x66, 0x3C, 0x86, 0x7C }, /*  21     */
+    { 0x00, 0x00, 0x00, 0x00, 0x7E, 0x7E, 0x7E, 0x00 }, /*  22     */
+    { 0x18, 0x3C, 0x7E, 0x18, 0x7E, 0x3C, 0x18, 0xFF }, /*  23     */
+    { 0x18, 0x3C, 0x7E, 0x18, 0x18, 0x18, 0x18, 0x00 }, /*  24     */
+    { 0x18, 0x18, 0x18, 0x18, 0x7E, 0x3C, 0x18, 0x00 }, /*  25     */
+    { 0x00, 0x18, 0x0C, 0xFE, 0x0C, 0x18, 0x00, 0x00 }, /*  26     */
+    { 0x00, 0x30, 0x60, 0xFE, 0x60, 0x30, 0x00, 0x00 }, /*  27     */
+    { 0x00, 0x00, 0xC0, 0xC0, 0xC0, 0xFE, 0x00, 0x00 }, /*  28     */
+    { 0x00, 0x24, 0x66, 0xFF, 0x66, 0x24, 0x00, 0x00 }, /*  29     */
+    { 0x00, 0x18, 0x3C, 0x7E, 0xFF, 0xFF, 0x00, 0x00 }, /*  30     */
+    { 0x00, 0xFF, 0xFF, 0x7E, 0x3C, 0x18, 0x00, 0x00 }, /*  31     */
+    { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, /*  32 ' ' */
+    { 0x18, 0x3C, 0x3C, 0x18, 0x18, 0x00, 0x18, 0x00 }, /*  33 '!' */
+    { 0x66, 0x66, 0x24, 0x00, 0x00, 0x00, 0x00, 0x00 }, /*  34 '"' */
+    { 0x6C, 0x6C, 0xFE, 0x6C, 0xFE, 0x6C, 0x6C, 0x00 }, /*  35 '#' */
+    { 0x18, 0x3E, 0x60, 0x3C, 0x06, 0x7C, 0x18, 0x00 }, /*  36 '$' */
+    { 0x00, 0xC6, 0xCC, 0x18, 0x30, 0x66, 0xC6, 0x00 }, /*  37 '%' */
+    { 0x38, 0x6C, 0x38, 0x76, 0xDC, 0xCC, 0x76, 0x00 }, /*  38 '&' */
+    { 0x18, 0x18, 0x30, 0x00, 0x00, 0x00, 0x00, 0x00 }, /*  39 ''' */
+    { 0x0C, 0x18, 0x30, 0x30, 0x30, 0x18, 0x0C, 0x00 }, /*  40 '(' */
+    { 0x30, 0x18, 0x0C, 0x0C, 0x0C, 0x18, 0x30, 0x00 }, /*  41 ')' */
+    { 0x00, 0x66, 0x3C, 0xFF, 0x3C, 0x66, 0x00, 0x00 }, /*  42 '*' */
+    { 0x00, 0x18, 0x18, 0x7E, 0x18, 0x18, 0x00, 0x00 }, /*  43 '+' */
+    { 0x00, 0x00, 0x00, 0x00, 0x00, 0x18, 0x18, 0x30 }, /*  44 ',' */
+    { 0x00, 0x00, 0x00, 0x7E, 0x00, 0x00, 0x00, 0x00 }, /*  45 '-' */
+    { 0x00, 0x00, 0x00, 0x00, 0x00, 0x18, 0x18, 0x00 }, /*  46 '.' */
+    { 0x06, 0x0C, 0x18, 0x30, 0x60, 0xC0, 0x80, 0x00 }, /*  47 '/' */
+    { 0x38, 0x6C, 0xC6, 0xD6, 0xC6, 0x6C, 0x38, 0x00 }, /*  48 '0' */
+    { 0x18, 0x38, 0x18, 0x18, 0x18, 0x18, 0x7E, 0x00 }, /*  49 '1' */
+    { 0x7C, 0xC6, 0x06, 0x1C, 0x30, 0x66, 0xFE, 0x00 }, /*  50 '2' */
+    { 0x7C, 0xC6, 0x06, 0x3C, 0x06, 0xC6, 0x7C, 0x00 }, /*  51 '3' */
+    { 0x1C, 0x3C, 0x6C, 0xCC, 0xFE, 0x0C, 0x1E, 0x00 }, /*  52 '4' */
+    { 0xFE, 0xC0, 0xC0, 0xFC, 0x06, 0xC6, 0x7C, 0x00 }, /*  53 '5' */
+    { 0x38, 0x60, 0xC0, 0xFC, 0xC6, 0xC6, 0x7C, 0x00 }, /*  54 '6' */
+    { 0xFE, 0xC6, 0x0C, 0x18, 0x30, 0x30, 0x30, 0x00 }, /*  55 '7' */
+    { 0x7C, 0xC6, 0xC6, 0x7C, 0xC6, 0xC6, 0x7C, 0x00 }, /*  56 '8' */
+    { 0x7C, 0xC6, 0xC6, 0x7E, 0x06, 0x0C, 0x78, 0x00 }, /*  57 '9' */
+    { 0x00, 0x18, 0x18, 0x00, 0x00, 0x18, 0x18, 0x00 }, /*  58 ':' */
+    { 0x00, 0x18, 0x18, 0x00, 0x00, 0x18, 0x18, 0x30 }, /*  59 ';' */
+    { 0x06, 0x0C, 0x18, 0x30, 0x18, 0x0C, 0x06, 0x00 }, /*  60 '<' */
+    { 0x00, 0x00, 0x7E, 0x00, 0x00, 0x7E, 0x00, 0x00 }, /*  61 '=' */
+    { 0x60, 0x30, 0x18, 0x0C, 0x18, 0x30, 0x60, 0x00 }, /*  62 '>' */
+    { 0x7C, 0xC6, 0x0C, 0x18, 0x18, 0x00, 0x18, 0x00 }, /*  63 '?' */
+    { 0x7C, 0xC6, 0xDE, 0xDE, 0xDE, 0xC0, 0x78, 0x00 }, /*  64 '@' */
+    { 0x38, 0x6C, 0xC6, 0xFE, 0xC6, 0xC6, 0xC6, 0x00 }, /*  65 'A' */
+    { 0xFC, 0x66, 0x66, 0x7C, 0x66, 0x66, 0xFC, 0x00 }, /*  66 'B' */
+    { 0x3C, 0x66, 0xC0, 0xC0, 0xC0, 0x66, 0x3C, 0x00 }, /*  67 'C' */
+    { 0xF8, 0x6C, 0x66, 0x66, 0x66, 0x6C, 0xF8, 0x00 }, /*  68 'D' */
+    { 0xFE, 0x62, 0x68, 0x78, 0x68, 0x62, 0xFE, 0x00 }, /*  69 'E' */
+    { 0xFE, 0x62, 0x68, 0x78, 0x68, 0x60, 0xF0, 0x00 }, /*  70 'F' */
+    { 0x3C, 0x66, 0xC0, 0xC0, 0xCE, 0x66, 0x3A, 0x00 }, /*  71 'G' */
+    { 0xC6, 0xC6, 0xC6, 0xFE, 0xC6, 0xC6, 0xC6, 0x00 }, /*  72 'H' */
+    { 0x3C, 0x18, 0x18, 0x18, 0x18, 0x18, 0x3C, 0x00 }, /*  73 'I' */
+    { 0x1E, 0x0C, 0x0C, 0x0C, 0xCC, 0xCC, 0x78, 0x00 }, /*  74 'J' */
+    { 0xE6, 0x66, 0x6C, 0x78, 0x6C, 0x66, 0xE6, 0x00 }, /*  75 'K' */
+    { 0xF0, 0x60, 0x60, 0x60, 0x62, 0x66, 0xFE, 0x00 }, /*  76 'L' */
+    { 0xC6, 0xEE, 0xFE, 0xFE, 0xD6, 0xC6, 0xC6, 0x00 }, /*  77 'M' */
+    { 0xC6, 0xE6, 0xF6, 0xDE, 0xCE, 0xC6, 0xC6, 0x00 }, /*  78 'N' */
+    { 0x7C, 0xC6, 0xC6, 0xC6, 0xC6, 0xC6, 0x7C, 0x00 }, /*  79 'O' */
+    { 0xFC, 0x66, 0x66, 0x7C, 0x60, 0x60, 0xF0, 0x00 }, /*  80 'P' */
+    { 0x7C, 0xC6, 0xC6, 0xC6, 0xC6, 0xCE, 0x7C, 0x0E }, /*  81 'Q' */
+    { 0xFC, 0x66, 0x66, 0x7C, 0x6C, 0x66, 0xE6, 0x00 }, /*  82 'R' */
+    { 0x3C, 0x66, 0x30, 0x18, 0x0C, 0x66, 0x3C, 0x00 }, /*  83 'S' */
+    { 0x7E, 0x7E, 0x5A, 0x18, 0x18, 0x18, 0x3C, 0x00 }, /*  84 'T' */
+    { 0xC6, 0xC6, 0xC6, 0xC6, 0xC6, 0xC6, 0x7C, 0x00 }, /*  85 'U' */
+    { 0xC6, 0xC6, 0xC6, 0xC6, 0xC6, 0x6C, 0x38, 0x00 }, /*  86 'V' */
+    { 0xC6, 0xC6, 0xC6, 0xD6, 0xD6, 0xFE, 0x6C, 0x00 }, /*  87 'W' */
+    { 0xC6, 0xC6, 0x6C, 0x38, 0x6C, 0xC6, 0xC6, 0x00 }, /*  88 'X' */
+    { 0x66, 0x66, 0x66, 0x3C, 0x18, 0x18, 0x3C, 0x00 }, /*  89 'Y' */
+    { 0xFE, 0xC6, 0x8C, 0x18, 0x32, 0x66, 0xFE, 0x00 }, /*  90 'Z' */
+    { 0x3C, 0x30, 0x30, 0x30, 0x30, 0x30, 0x3C, 0x00 }, /*  91 '[' */
+    { 0xC0, 0x60, 0x30, 0x18, 0x0C, 0x06, 0x02, 0x00 }, /*  92 '\' */
+    { 0x3C, 0x0C, 0x0C, 0x0C, 0x0C, 0x0C, 0x3C, 0x00 }, /*  93 ']' */
+    { 0x10, 0x38, 0x6C, 0xC6, 0x00, 0x00, 0x00, 0x00 }, /*  94 '^' */
+    { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF }, /*  95 '_' */
+    { 0x30, 0x18, 0x0C, 0x00, 0x00, 0x00, 0x00, 0x00 }, /*  96 '`' */
+    { 0x00, 0x00, 0x78, 0x0C, 0x7C, 0xCC, 0x76, 0x00 }, /*  97 'a' */
+    { 0xE0, 0x60, 0x7C, 0x66, 0x66, 0x66, 0xDC, 0x00 }, /*  98 'b' */
+    { 0x00, 0x00, 0x7C, 0xC6, 0xC0, 0xC6, 0x7C, 0x00 }, /*  99 'c' */
+    { 0x1C, 0x0C, 0x7C, 0xCC, 0xCC, 0xCC, 0x76, 0x00 }, /* 100 'd' */
+    { 0x00, 0x00, 0x7C, 0xC6, 0xFE, 0xC0, 0x7C, 0x00 }, /* 101 'e' */
+    { 0x3C, 0x66, 0x60, 0xF8, 0x60, 0x60, 0xF0, 0x00 }, /* 102 'f' */
+    { 0x00, 0x00, 0x76, 0xCC, 0xCC, 0x7C, 0x0C, 0xF8 }, /* 103 'g' */
+    { 0xE0, 0x60, 0x6C, 0x76, 0x66, 0x66, 0xE6, 0x00 }, /* 104 'h' */
+    { 0x18, 0x00, 0x38, 0x18, 0x18, 0x18, 0x3C, 0x00 }, /* 105 'i' */
+    { 0x06, 0x00, 0x06, 0x06, 0x06, 0x66, 0x66, 0x3C }, /* 106 'j' */
+    { 0xE0, 0x60, 0x66, 0x6C, 0x78, 0x6C, 0xE6, 0x00 }, /* 107 'k' */
+    { 0x38, 0x18, 0x18, 0x18, 0x18, 0x18, 0x3C, 0x00 }, /* 108 'l' */
+    { 0x00, 0x00, 0xEC, 0xFE, 0xD6, 0xD6, 0xD6, 0x00 }, /* 109 'm' */
+    { 0x00, 0x00, 0xDC, 0x66, 0x66, 0x66, 0x66, 0x00 }, /* 110 'n' */
+    { 0x00, 0x00, 0x7C, 0xC6, 0xC6, 0xC6, 0x7C, 0x00 }, /* 111 'o' */
+    { 0x00, 0x00, 0xDC, 0x66, 0x66, 0x7C, 0x60, 0xF0 }, /* 112 'p' */
+    { 0x00, 0x00, 0x76, 0xCC, 0xCC, 0x7C, 0x0C, 0x1E }, /* 113 'q' */
+    { 0x00, 0x00, 0xDC, 0x76, 0x60, 0x60, 0xF0, 0x00 }, /* 114 'r' */
+    { 0x00, 0x00, 0x7E, 0xC0, 0x7C, 0x06, 0xFC, 0x00 }, /* 115 's' */
+    { 0x30, 0x30, 0xFC, 0x30, 0x30, 0x36, 0x1C, 0x00 }, /* 116 't' */
+    { 0x00, 0x00, 0xCC, 0xCC, 0xCC, 0xCC, 0x76, 0x00 }, /* 117 'u' */
+    { 0x00, 0x00, 0xC6, 0xC6, 0xC6, 0x6C, 0x38, 0x00 }, /* 118 'v' */
+    { 0x00, 0x00, 0xC6, 0xD6, 0xD6, 0xFE, 0x6C, 0x00 }, /* 119 'w' */
+    { 0x00, 0x00, 0xC6, 0x6C, 0x38, 0x6C, 0xC6, 0x00 }, /* 120 'x' */
+    { 0x00, 0x00, 0xC6, 0xC6, 0xC6, 0x7E, 0x06, 0xFC }, /* 121 'y' */
+    { 0x00, 0x00, 0x7E, 0x4C, 0x18, 0x32, 0x7E, 0x00 }, /* 122 'z' */
+    { 0x0E, 0x18, 0x18, 0x70, 0x18, 0x18, 0x0E, 0x00 }, /* 123 '{' */
+    { 0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x00 }, /* 124 '|' */
+    { 0x70, 0x18, 0x18, 0x0E, 0x18, 0x18, 0x70, 0x00 }, /* 125 '}' */
+    { 0x76, 0xDC, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, /* 126 '~' */
+    { 0x00, 0x10, 0x38, 0x6C, 0xC6, 0xC6, 0xFE, 0x00 }, /* 127     */
+    { 0x7C, 0xC6, 0xC0, 0xC0, 0xC6, 0x7C, 0x0C, 0x78 }, /* 128     */
+    { 0xCC, 0x00, 0xCC, 0xCC, 0xCC, 0xCC, 0x76, 0x00 }, /* 129     */
+    { 0x0C, 0x18, 0x7C, 0xC6, 0xFE, 0xC0, 0x7C, 0x00 }, /* 130     */
+    { 0x7C, 0x82, 0x78, 0x0C, 0x7C, 0xCC, 0x76, 0x00 }, /* 131     */
+    { 0xC6, 0x00, 0x78, 0x0C, 0x7C, 0xCC, 0x76, 0x00 }, /* 132     */
+    { 0x30, 0x18, 0x78, 0x0C, 0x7C, 0xCC, 0x76, 0x00 }, /* 133     */
+    { 0x30, 0x30, 0x78, 0x0C, 0x7C, 0xCC, 0x76, 0x00 }, /* 134     */
+    { 0x00, 0x00, 0x7E, 0xC0, 0xC0, 0x7E, 0x0C, 0x38 }, /* 135     */
+    { 0x7C, 0x82, 0x7C, 0xC6, 0xFE, 0xC0, 0x7C, 0x00 }, /* 136     */
+    { 0xC6, 0x00, 0x7C, 0xC6, 0xFE, 0xC0, 0x7C, 0x00 }, /* 137     */
+    { 0x30, 0x18, 0x7C, 0xC6, 0xFE, 0xC0, 0x7C, 0x00 }, /* 138     */
+    { 0x66, 0x00, 0x38, 0x18, 0x18, 0x18, 0x3C, 0x00 }, /* 139     */
+    { 0x7C, 0x82, 0x38, 0x18, 0x18, 0x18, 0x3C, 0x00 }, /* 140     */
+    { 0x30, 0x18, 0x00, 0x38, 0x18, 0x18, 0x3C, 0x00 }, /* 141     */
+    { 0xC6, 0x38, 0x6C, 0xC6, 0xFE, 0xC6, 0xC6, 0x00 }, /* 142     */
+    { 0x38, 0x6C, 0x7C, 0xC6, 0xFE, 0xC6, 0xC6, 0x00 }, /* 143     */
+    { 0x18, 0x30, 0xFE, 0xC0, 0xF8, 0xC0, 0xFE, 0x00 }, /* 144     */
+    { 0x00, 0x00, 0x7E, 0x18, 0x7E, 0xD8, 0x7E, 0x00 }, /* 145     */
+    { 0x3E, 0x6C, 0xCC, 0xFE, 0xCC, 0xCC, 0xCE, 0x00 }, /* 146     */
+    { 0x7C, 0x82, 0x7C, 0xC6, 0xC6, 0xC6, 0x7C, 0x00 }, /* 147     */
+    { 0xC6, 0x00, 0x7C, 0xC6, 0xC6, 0xC6, 0x7C, 0x00 }, /* 148     */
+    { 0x30, 0x18, 0x7C, 0xC6, 0xC6, 0xC6, 0x7C, 0x00 }, /* 149     */
+    { 0x78, 0x84, 0x00, 0xCC, 0xCC, 0xCC, 0x76, 0x00 }, /* 150     */
+    { 0x60, 0x30, 0xCC, 0xCC, 0xCC, 0xCC, 0x76, 0x00 }, /* 151     */
+    { 0xC6, 0x00, 0xC6, 0xC6, 0xC6, 0x7E, 0x06, 0xFC }, /* 152     */
+    { 0xC6, 0x38, 0x6C, 0xC6, 0xC6, 0x6C, 0x38, 0x00 }, /* 153     */
+    { 0xC6, 0x00, 0xC6, 0xC6, 0xC6, 0xC6, 0x7C, 0x00 }, /* 154     */
+    { 0x18, 0x18, 0x7E, 0xC0, 0xC0, 0x7E, 0x18, 0x18 }, /* 155     */
+    { 0x38, 0x6C, 0x64, 0xF0, 0x60, 0x66, 0xFC, 0x00 }, /* 156     */
+    { 0x66, 0x66, 0x3C, 0x7E, 0x18, 0x7E, 0x18, 0x18 }, /* 157     */
+    { 0xF8, 0xCC, 0xCC, 0xFA, 0xC6, 0xCF, 0xC6, 0xC7 }, /* 158     */
+    { 0x0E, 0x1B, 0x18, 0x3C, 0x18, 0xD8, 0x70, 0x00 }, /* 159     */
+    { 0x18, 0x30, 0x78, 0x0C, 0x7C, 0xCC, 0x76, 0x00 }, /* 160     */
+    { 0x0C, 0x18, 0x00, 0x38, 0x18, 0x18, 0x3C, 0x00 }, /* 161     */
+    { 0x0C, 0x18, 0x7C, 0xC6, 0xC6, 0xC6, 0x7C, 0x00 }, /* 162     */
+    { 0x18, 0x30, 0xCC, 0xCC, 0xCC, 0xCC, 0x76, 0x00 }, /* 163     */
+    { 0x76, 0xDC, 0x00, 0xDC, 0x66, 0x66, 0x66, 0x00 }, /* 164     */
+    { 0x76, 0xDC, 0x00, 0xE6, 0xF6, 0xDE, 0xCE, 0x00 }, /* 165     */
+    { 0x3C, 0x6C, 0x6C, 0x3E, 0x00, 0x7E, 0x00, 0x00 }, /* 166     */
+    { 0x38, 0x6C, 0x6C, 0x38, 0x00, 0x7C, 0x00, 0x00 }, /* 167     */
+    { 0x18, 0x00, 0x18, 0x18, 0x30, 0x63, 0x3E, 0x00 }, /* 168     */
+    { 0x00, 0x00, 0x00, 0xFE, 0xC0, 0xC0, 0x00, 0x00 }, /* 169     */
+    { 0x00, 0x00, 0x00, 0xFE, 0x06, 0x06, 0x00, 0x00 }, /* 170     */
+    { 0x63, 0xE6, 0x6C, 0x7E, 0x33, 0x66, 0xCC, 0x0F }, /* 171     */
+    { 0x63, 0xE6, 0x6C, 0x7A, 0x36, 0x6A, 0xDF, 0x06 }, /* 172     */
+    { 0x18, 0x00, 0x18, 0x18, 0x3C, 0x3C, 0x18, 0x00 }, /* 173     */
+    { 0x00, 0x33, 0x66, 0xCC, 0x66, 0x33, 0x00, 0x00 }, /* 174     */
+    { 0x00, 0xCC, 0x66, 0x33, 0x66, 0xCC, 0x00, 0x00 }, /* 175     */
+    { 0x22, 0x88, 0x22, 0x88, 0x22, 0x88, 0x22, 0x88 }, /* 176     */
+    { 0x55, 0xAA, 0x55, 0xAA, 0x55, 0xAA, 0x55, 0xAA }, /* 177     */
+    { 0x77, 0xDD, 0x77, 0xDD, 0x77, 0xDD, 0x77, 0xDD }, /* 178     */
+    { 0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18 }, /* 179     */
+    { 0x18, 0x18, 0x18, 0x18, 0xF8, 0x18, 0x18, 0x18 }, /* 180     */
+    { 0x18, 0x18, 0xF8, 0x18, 0xF8, 0x18, 0x18, 0x18 }, /* 181     */
+    { 0x36, 0x36, 0x36, 0x36, 0xF6, 0x36, 0x36, 0x36 }, /* 182     */
+    { 0x00, 0x00, 0x00, 0x00, 0xFE, 0x36, 0x36, 0x36 }, /* 183     */
+    { 0x00, 0x00, 0xF8, 0x18, 0xF8, 0x18, 0x18, 0x18 }, /* 184     */
+    { 0x36, 0x36, 0xF6, 0x06, 0xF6, 0x36, 0x36, 0x36 }, /* 185     */
+    { 0x36, 0x36, 0x36, 0x36, 0x36, 0x36, 0x36, 0x36 }, /* 186     */
+    { 0x00, 0x00, 0xFE, 0x06, 0xF6, 0x36, 0x36, 0x36 }, /* 187     */
+    { 0x36, 0x36, 0xF6, 0x06, 0xFE, 0x00, 0x00, 0x00 }, /* 188     */
+    { 0x36, 0x36, 0x36, 0x36, 0xFE, 0x00, 0x00, 0x00 }, /* 189     */
+    { 0x18, 0x18, 0xF8, 0x18, 0xF8, 0x00, 0x00, 0x00 }, /* 190     */
+    { 0x00, 0x00, 0x00, 0x00, 0xF8, 0x18, 0x18, 0x18 }, /* 191     */
+    { 0x18, 0x18, 0x18, 0x18, 0x1F, 0x00, 0x00, 0x00 }, /* 192     */
+    { 0x18, 0x18, 0x18, 0x18, 0xFF, 0x00, 0x00, 0x00 }, /* 193     */
+    { 0x00, 0x00, 0x00, 0x00, 0xFF, 0x18, 0x18, 0x18 }, /* 194     */
+    { 0x18, 0x18, 0x18, 0x18, 0x1F, 0x18, 0x18, 0x18 }, /* 195     */
+    { 0x00, 0x00, 0x00, 0x00, 0xFF, 0x00, 0x00, 0x00 }, /* 196     */
+    { 0x18, 0x18, 0x18, 0x18, 0xFF, 0x18, 0x18, 0x18 }, /* 197     */
+    { 0x18, 0x18, 0x1F, 0x18, 0x1F, 0x18, 0x18, 0x18 }, /* 198     */
+    { 0x36, 0x36, 0x36, 0x36, 0x37, 0x36, 0x36, 0x36 }, /* 199     */
+    { 0x36, 0x36, 0x37, 0x30, 0x3F, 0x00, 0x00, 0x00 }, /* 200     */
+    { 0x00, 0x00, 0x3F, 0x30, 0x37, 0x36, 0x36, 0x36 }, /* 201     */
+    { 0x36, 0x36, 0xF7, 0x00, 0xFF, 0x00, 0x00, 0x00 }, /* 202     */
+    { 0x00, 0x00, 0xFF, 0x00, 0xF7, 0x36, 0x36, 0x36 }, /* 203     */
+    { 0x36, 0x36, 0x37, 0x30, 0x37, 0x36, 0x36, 0x36 }, /* 204     */
+    { 0x00, 0x00, 0xFF, 0x00, 0xFF, 0x00, 0x00, 0x00 }, /* 205     */
+    { 0x36, 0x36, 0xF7, 0x00, 0xF7, 0x36, 0x36, 0x36 }, /* 206     */
+    { 0x18, 0x18, 0xFF, 0x00, 0xFF, 0x00, 0x00, 0x00 }, /* 207     */
+    { 0x36, 0x36, 0x36, 0x36, 0xFF, 0x00, 0x00, 0x00 }, /* 208     */
+    { 0x00, 0x00, 0xFF, 0x00, 0xFF, 0x18, 0x18, 0x18 }, /* 209     */
+    { 0x00, 0x00, 0x00, 0x00, 0xFF, 0x36, 0x36, 0x36 }, /* 210     */
+    { 0x36, 0x36, 0x36, 0x36, 0x3F, 0x00, 0x00, 0x00 }, /* 211     */
+    { 0x18, 0x18, 0x1F, 0x18, 0x1F, 0x00, 0x00, 0x00 }, /* 212     */
+    { 0x00, 0x00, 0x1F, 0x18, 0x1F, 0x18, 0x18, 0x18 }, /* 213     */
+    { 0x00, 0x00, 0x00, 0x00, 0x3F, 0x36, 0x36, 0x36 }, /* 214     */
+    { 0x36, 0x36, 0x36, 0x36, 0xFF, 0x36, 0x36, 0x36 }, /* 215     */
+    { 0x18, 0x18, 0xFF, 0x18, 0xFF, 0x18, 0x18, 0x18 }, /* 216     */
+    { 0x18, 0x18, 0x18, 0x18, 0xF8, 0x00, 0x00, 0x00 }, /* 217     */
+    { 0x00, 0x00, 0x00, 0x00, 0x1F, 0x18, 0x18, 0x18 }, /* 218     */
+    { 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF }, /* 219     */
+    { 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0xFF, 0xFF }, /* 220     */
+    { 0xF0, 0xF0, 0xF0, 0xF0, 0xF0, 0xF0, 0xF0, 0xF0 }, /* 221     */
+    { 0x0F, 0x0F, 0x0F, 0x0F, 0x0F, 0x0F, 0x0F, 0x0F }, /* 222     */
+    { 0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00 }, /* 223     */
+    { 0x00, 0x00, 0x76, 0xDC, 0xC8, 0xDC, 0x76, 0x00 }, /* 224     */
+    { 0x78, 0xCC, 0xCC, 0xD8, 0xCC, 0xC6, 0xCC, 0x00 }, /* 225     */
+    { 0xFE, 0xC6, 0xC0, 0xC0, 0xC0, 0xC0, 0xC0, 0x00 }, /* 226     */
+    { 0x00, 0x00, 0xFE, 0x6C, 0x6C, 0x6C, 0x6C, 0x00 }, /* 227     */
+    { 0xFE, 0xC6, 0x60, 0x30, 0x60, 0xC6, 0xFE, 0x00 }, /* 228     */
+    { 0x00, 0x00, 0x7E, 0xD8, 0xD8, 0xD8, 0x70, 0x00 }, /* 229     */
+    { 0x00, 0x00, 0x66, 0x66, 0x66, 0x66, 0x7C, 0xC0 }, /* 230     */
+    { 0x00, 0x76, 0xDC, 0x18, 0x18, 0x18, 0x18, 0x00 }, /* 231     */
+    { 0x7E, 0x18, 0x3C, 0x66, 0x66, 0x3C, 0x18, 0x7E }, /* 232     */
+    { 0x38, 0x6C, 0xC6, 0xFE, 0xC6, 0x6C, 0x38, 0x00 }, /* 233     */
+    { 0x38, 0x6C, 0xC6, 0xC6, 0x6C, 0x6C, 0xEE, 0x00 }, /* 234     */
+    { 0x0E, 0x18, 0x0C, 0x3E, 0x66, 0x66, 0x3C, 0x00 }, /* 235     */
+    { 0x00, 0x00, 0x7E, 0xDB, 0xDB, 0x7E, 0x00, 0x00 }, /* 236     */
+    { 0x06, 0x0C, 0x7E, 0xDB, 0xDB, 0x7E, 0x60, 0xC0 }, /* 237     */
+    { 0x1E, 0x30, 0x60, 0x7E, 0x60, 0x30, 0x1E, 0x00 }, /* 238     */
+    { 0x00, 0x7C, 0xC6, 0xC6, 0xC6, 0xC6, 0xC6, 0x00 }, /* 239     */
+    { 0x00, 0xFE, 0x00, 0xFE, 0x00, 0xFE, 0x00, 0x00 }, /* 240     */
+    { 0x18, 0x18, 0x7E, 0x18, 0x18, 0x00, 0x7E, 0x00 }, /* 241     */
+    { 0x30, 0x18, 0x0C, 0x18, 0x30, 0x00, 0x7E, 0x00 }, /* 242     */
+    { 0x0C, 0x18, 0x30, 0x18, 0x0C, 0x00, 0x7E, 0x00 }, /* 243     */
+    { 0x0E, 0x1B, 0x1B, 0x18, 0x18, 0x18, 0x18, 0x18 }, /* 244     */
+    { 0x18, 0x18, 0x18, 0x18, 0x18, 0xD8, 0xD8, 0x70 }, /* 245     */
+    { 0x00, 0x18, 0x00, 0x7E, 0x00, 0x18, 0x00, 0x00 }, /* 246     */
+    { 0x00, 0x76, 0xDC, 0x00, 0x76, 0xDC, 0x00, 0x00 }, /* 247     */
+    { 0x38, 0x6C, 0x6C, 0x38, 0x00, 0x00, 0x00, 0x00 }, /* 248     */
+    { 0x00, 0x00, 0x00, 0x18, 0x18, 0x00, 0x00, 0x00 }, /* 249     */
+    { 0x00, 0x00, 0x00, 0x18, 0x00, 0x00, 0x00, 0x00 }, /* 250     */
+    { 0x0F, 0x0C, 0x0C, 0x0C, 0xEC, 0x6C, 0x3C, 0x1C }, /* 251     */
+    { 0x6C, 0x36, 0x36, 0x36, 0x36, 0x00, 0x00, 0x00 }, /* 252     */
+    { 0x78, 0x0C, 0x18, 0x30, 0x7C, 0x00, 0x00, 0x00 }, /* 253     */
+    { 0x00, 0x00, 0x3C, 0x3C, 0x3C, 0x3C, 0x00, 0x00 }, /* 254     */
+    { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }  /* 255     */
+};
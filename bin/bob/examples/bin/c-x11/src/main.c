@@ -15,14 +15,19 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include <unistd.h>
 
 #include "canvas.h"
 #include "x11.h"
 
-static void render(canvas_t* canvas) {
+// Most threads the tiled renderer uses, more threads mostly wait on memory bandwidth
+#define MAX_RENDER_THREADS 8
+
+// Draw the scene, it is recorded in a display list so only what changed is rasterized
+static void render(canvas_t* canvas, canvas_text_cache_t* text_cache) {
     // Clear to white
-    canvas_fill_rect(canvas, 0.0f, 0.0f, (float)canvas->width, (float)canvas->height, CANVAS_COLOR(255, 255, 255));
+    canvas_clear(canvas, CANVAS_COLOR(255, 255, 255));
 
     // Draw filled rectangles
     canvas_fill_rect(canvas, 40.0f, 40.0f, 120.0f, 80.0f, CANVAS_COLOR(255, 0, 0));
@@ -39,6 +44,81 @@ static void render(canvas_t* canvas) {
         canvas_stroke_rect(canvas, 40.0f + i * 12.0f, 280.0f + i * 8.0f, 200.0f - i * 24.0f, 120.0f - i * 16.0f, 1.0f,
                            CANVAS_COLOR(80 + i * 30, 80 + i * 20, 200 - i * 30));
     }
+
+    // Translucent overlay across the filled rectangles
+    canvas_blend_rect(canvas, 100.0f, 60.0f, 320.0f, 120.0f, CANVAS_ARGB(96, 0, 0, 0));
+
+    // Labels, the glyphs come from the atlas after the first frame
+    canvas_draw_text(canvas, text_cache, NULL, 40.0f, 16.0f, 16.0f, "Hello Canvas!", CANVAS_COLOR(0, 0, 0));
+    const char* labels[] = {"Red", "Green", "Blue"};
+    for (int32_t i = 0; i < 3; i++) {
+        float width = canvas_measure_text(canvas, text_cache, NULL, 8.0f, labels[i]);
+        canvas_draw_text(canvas, text_cache, NULL, 100.0f + i * 160.0f - width / 2.0f, 128.0f, 8.0f, labels[i],
+                         CANVAS_COLOR(64, 64, 64));
+    }
+}
+
+// How long a presented frame may wait for its PresentCompleteNotify before the next frame goes anyway
+#define PRESENT_TIMEOUT_MS 100
+
+// Where frames go: a pixmap shown at vblank with Present, an XDBE back buffer or the window itself
+typedef struct presenter_t {
+    uint32_t window;
+    uint32_t pixmap;       // Present pixmap, 0 without Present
+    uint32_t back_buffer;  // XDBE back buffer, 0 without XDBE
+    uint32_t serial;       // serial of the last presented pixmap
+    bool pending;          // the last presented pixmap isn't shown yet, it can't be drawn into
+} presenter_t;
+
+static void presenter_init(x11_connection_t* conn, presenter_t* presenter, uint32_t window, int32_t width,
+                           int32_t height) {
+    presenter->window = window;
+    presenter->pixmap = 0;
+    presenter->back_buffer = 0;
+    presenter->serial = 0;
+    presenter->pending = false;
+    if (conn->has_present) {
+        presenter->pixmap = x11_create_pixmap(conn, window, width, height);
+        x11_present_select_input(conn, window);
+    } else if (conn->has_xdbe) {
+        // Render into the back buffer and swap atomically to eliminate tearing
+        presenter->back_buffer = x11_xdbe_alloc_back_buffer(conn, window);
+    }
+}
+
+static void presenter_resize(x11_connection_t* conn, presenter_t* presenter, int32_t width, int32_t height) {
+    // The server keeps a pixmap that is still being presented until it is shown
+    if (presenter->pixmap) {
+        x11_free_pixmap(conn, presenter->pixmap);
+        presenter->pixmap = x11_create_pixmap(conn, presenter->window, width, height);
+    }
+}
+
+// Upload the dirty rects of the canvas from the last acquired image and show them. The back buffer is copied
+// on swap and the pixmap is copied to the window, so the regions that didn't change stay valid in both.
+static void presenter_show(x11_connection_t* conn, presenter_t* presenter, x11_swapchain_t* swapchain,
+                           canvas_t* canvas) {
+    uint32_t target = presenter->pixmap      ? presenter->pixmap
+                      : presenter->back_buffer ? presenter->back_buffer
+                                               : presenter->window;
+    for (int32_t i = 0; i < canvas->dirty_count; i++) {
+        canvas_rect_t* rect = &canvas->dirty_rects[i];
+        x11_swapchain_put_region(conn, swapchain, target, rect->x, rect->y, rect->width, rect->height);
+    }
+    if (presenter->pixmap) {
+        x11_present_pixmap(conn, presenter->window, presenter->pixmap, ++presenter->serial);
+        presenter->pending = true;
+    } else if (presenter->back_buffer) {
+        x11_xdbe_swap_buffers(conn, presenter->window);
+    }
+    canvas_clear_dirty_rects(canvas);
+}
+
+static void presenter_destroy(x11_connection_t* conn, presenter_t* presenter) {
+    if (presenter->pixmap)
+        x11_free_pixmap(conn, presenter->pixmap);
+    if (presenter->back_buffer)
+        x11_xdbe_free_back_buffer(conn, presenter->back_buffer);
 }
 
 // Find the monitor with the greatest overlap with the window rect.
@@ -85,17 +165,173 @@ static float compute_scale(const x11_connection_t* conn, x11_monitor_t* monitors
     return snap_scale(raw);
 }
 
-int main(void) {
+// MARK: Frame benchmark
+// Frames drawn per configuration when --frames isn't given
+#define BENCH_DEFAULT_FRAMES 100
+
+static const struct {
+    int32_t width;
+    int32_t height;
+} bench_sizes[] = {{1280, 720}, {1920, 1080}, {3840, 2160}};
+static const float bench_scales[] = {1.0f, 1.5f, 2.0f};
+
+static double bench_now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1000.0 + (double)ts.tv_nsec / 1e6;
+}
+
+static int bench_compare_times(const void* a, const void* b) {
+    double x = *(const double*)a;
+    double y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+// Print the median and 99th percentile of the frame times, the times are sorted in place
+static void bench_report(const char* label, double* times, int32_t count) {
+    qsort(times, (size_t)count, sizeof(double), bench_compare_times);
+    int32_t p99 = (count * 99 + 99) / 100 - 1;
+    printf("  %-28s p50 %8.3f ms  p99 %8.3f ms\n", label, times[(count - 1) / 2], times[p99]);
+}
+
+// Draw the scene completely into an offscreen canvas every frame at several sizes and scales, on one core and
+// tiled when there are more cores. With upload the frames are also uploaded to a pixmap with ShmPutImage and
+// PutImage, every upload waits for the server so its time includes the copy by the server.
+static int run_bench(int32_t frames, bool upload) {
+    long cpu_count = sysconf(_SC_NPROCESSORS_ONLN);
+    int32_t thread_count = cpu_count < MAX_RENDER_THREADS ? (int32_t)cpu_count : MAX_RENDER_THREADS;
+    size_t max_pixels = 0;
+    for (size_t i = 0; i < sizeof(bench_sizes) / sizeof(bench_sizes[0]); i++) {
+        size_t pixels = (size_t)bench_sizes[i].width * (size_t)bench_sizes[i].height;
+        if (pixels > max_pixels)
+            max_pixels = pixels;
+    }
+    uint32_t* pixels = malloc(max_pixels * sizeof(uint32_t));
+    double* times = malloc((size_t)frames * sizeof(double));
+    canvas_tiler_t* tiler = thread_count > 1 ? canvas_tiler_create(thread_count) : NULL;
+    canvas_text_cache_t* text_cache = canvas_text_cache_create();
+    if (!pixels || !times || (thread_count > 1 && !tiler) || !text_cache) {
+        fprintf(stderr, "Can't allocate benchmark buffers\n");
+        canvas_text_cache_destroy(text_cache);
+        canvas_tiler_destroy(tiler);
+        free(times);
+        free(pixels);
+        return EXIT_FAILURE;
+    }
+
+    printf("Raster, %d frames, tiled on %d threads:\n", frames, tiler ? thread_count : 0);
+    for (size_t i = 0; i < sizeof(bench_sizes) / sizeof(bench_sizes[0]); i++) {
+        for (size_t j = 0; j < sizeof(bench_scales) / sizeof(bench_scales[0]); j++) {
+            for (int32_t tiled = 0; tiled < (tiler ? 2 : 1); tiled++) {
+                float scale = bench_scales[j];
+                canvas_t canvas;
+                canvas_init(&canvas, (int32_t)((float)bench_sizes[i].width / scale),
+                            (int32_t)((float)bench_sizes[i].height / scale), pixels, scale);
+                // The first frame fills the glyph atlas, it isn't measured
+                for (int32_t frame = -1; frame < frames; frame++) {
+                    double start = bench_now_ms();
+                    if (tiled)
+                        canvas_begin_tiled(&canvas, tiler);
+                    render(&canvas, text_cache);
+                    if (tiled)
+                        canvas_end_tiled(&canvas);
+                    canvas_clear_dirty_rects(&canvas);
+                    if (frame >= 0)
+                        times[frame] = bench_now_ms() - start;
+                }
+                char label[64];
+                snprintf(label, sizeof(label), "%dx%d @%.2fx %s", bench_sizes[i].width, bench_sizes[i].height,
+                         (double)scale, tiled ? "tiled" : "direct");
+                bench_report(label, times, frames);
+            }
+        }
+    }
+
+    int result = EXIT_SUCCESS;
+    x11_connection_t conn;
+    if (upload && !x11_connect(&conn)) {
+        fprintf(stderr, "Can't connect to X11 display\n");
+        result = EXIT_FAILURE;
+    } else if (upload) {
+        printf("Upload, %d frames, MIT-SHM: %s:\n", frames, conn.has_shm ? "yes" : "no");
+        bool has_shm = conn.has_shm;
+        for (size_t i = 0; i < sizeof(bench_sizes) / sizeof(bench_sizes[0]) && result == EXIT_SUCCESS; i++) {
+            int32_t width = bench_sizes[i].width;
+            int32_t height = bench_sizes[i].height;
+            uint32_t pixmap = x11_create_pixmap(&conn, conn.screen.root, width, height);
+            for (int32_t shm = has_shm ? 1 : 0; shm >= 0; shm--) {
+                // Images are created with plain PutImage uploads when the connection has no MIT-SHM
+                conn.has_shm = shm;
+                x11_image_t image;
+                if (!x11_create_image(&conn, &image, pixmap, width, height)) {
+                    fprintf(stderr, "Can't create image\n");
+                    result = EXIT_FAILURE;
+                    break;
+                }
+                canvas_t canvas;
+                canvas_init(&canvas, width, height, image.pixels, 1.0f);
+                render(&canvas, text_cache);
+                for (int32_t frame = -1; frame < frames && result == EXIT_SUCCESS; frame++) {
+                    double start = bench_now_ms();
+                    x11_put_image(&conn, pixmap, &image);
+                    if (!x11_sync(&conn))
+                        result = EXIT_FAILURE;
+                    if (frame >= 0)
+                        times[frame] = bench_now_ms() - start;
+                }
+                x11_destroy_image(&conn, &image);
+                if (result != EXIT_SUCCESS) {
+                    fprintf(stderr, "Connection to X11 display failed\n");
+                    break;
+                }
+                char label[64];
+                snprintf(label, sizeof(label), "%dx%d %s", width, height, shm ? "ShmPutImage" : "PutImage");
+                bench_report(label, times, frames);
+            }
+            conn.has_shm = has_shm;
+            x11_free_pixmap(&conn, pixmap);
+        }
+        x11_disconnect(&conn);
+    }
+
+    canvas_text_cache_destroy(text_cache);
+    canvas_tiler_destroy(tiler);
+    free(times);
+    free(pixels);
+    return result;
+}
+
+int main(int argc, char** argv) {
     signal(SIGPIPE, SIG_IGN);
 
+    // x11 --bench [--frames <count>] [--upload] measures frames without a window
+    bool bench = false;
+    bool bench_upload = false;
+    int32_t bench_frames = BENCH_DEFAULT_FRAMES;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--bench")) {
+            bench = true;
+        } else if (!strcmp(argv[i], "--upload")) {
+            bench_upload = true;
+        } else if (!strcmp(argv[i], "--frames") && i + 1 < argc && atoi(argv[i + 1]) > 0) {
+            bench_frames = atoi(argv[++i]);
+        } else {
+            fprintf(stderr, "Usage: %s [--bench [--frames <count>] [--upload]]\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (bench)
+        return run_bench(bench_frames, bench_upload);
+
     x11_connection_t conn;
     if (!x11_connect(&conn)) {
         fprintf(stderr, "Can't connect to X11 display\n");
         return EXIT_FAILURE;
     }
-    printf("Screen: %dx%d, MIT-SHM: %s, RANDR: %s (v%d.%d), SYNC: %s, XDBE: %s\n", conn.screen.width_in_pixels,
-           conn.screen.height_in_pixels, conn.has_shm ? "yes" : "no", conn.has_randr ? "yes" : "no", conn.randr_major,
-           conn.randr_minor, conn.has_sync ? "yes" : "no", conn.has_xdbe ? "yes" : "no");
+    printf("Screen: %dx%d, MIT-SHM: %s, RANDR: %s (v%d.%d), SYNC: %s, XDBE: %s, Present: %s\n",
+           conn.screen.width_in_pixels, conn.screen.height_in_pixels, conn.has_shm ? "yes" : "no",
+           conn.has_randr ? "yes" : "no", conn.randr_major, conn.randr_minor, conn.has_sync ? "yes" : "no",
+           conn.has_xdbe ? "yes" : "no", conn.has_present ? "yes" : "no");
 
     // Validate root visual pixel format (expect standard RGB: R=0xFF0000 G=0xFF00 B=0xFF)
     if (conn.root_visual_red_mask != 0xFF0000 || conn.root_visual_green_mask != 0xFF00 ||
@@ -209,9 +445,9 @@ int main(void) {
     // Subscribe to screen-layout change events (monitor hot-plug, DPI changes)
     x11_randr_select_input(&conn, window);
 
-    // Create image and canvas backed by it
-    x11_image_t img;
-    if (!x11_create_image(&conn, &img, window, window_width, window_height)) {
+    // Create the images frames are drawn into in turn, a frame doesn't wait for the upload of the previous one
+    x11_swapchain_t swapchain;
+    if (!x11_swapchain_create(&conn, &swapchain, window, window_width, window_height)) {
         fprintf(stderr, "Can't create image\n");
         if (sync_counter)
             x11_sync_destroy_counter(&conn, sync_counter);
@@ -219,20 +455,82 @@ int main(void) {
         return EXIT_FAILURE;
     }
 
-    // Allocate XDBE back buffer; render into it and swap atomically to eliminate tearing.
-    // Falls back to direct window rendering if XDBE is unavailable.
-    uint32_t back_buffer = conn.has_xdbe ? x11_xdbe_alloc_back_buffer(&conn, window) : 0;
-    uint32_t render_target = back_buffer ? back_buffer : window;
+    // Present frames at vblank with Present, falls back to XDBE swaps and then to direct window rendering
+    presenter_t presenter;
+    presenter_init(&conn, &presenter, window, window_width, window_height);
 
     canvas_t canvas;
-    canvas_init(&canvas, logical_w, logical_h, img.pixels, scale);
+    canvas_init(&canvas, logical_w, logical_h, swapchain.images[0].pixels, scale);
+
+    // Rasterize frames in tiles on multiple threads, falls back to drawing directly on one core
+    long cpu_count = sysconf(_SC_NPROCESSORS_ONLN);
+    canvas_tiler_t* tiler =
+        cpu_count > 1 ? canvas_tiler_create(cpu_count < MAX_RENDER_THREADS ? (int32_t)cpu_count : MAX_RENDER_THREADS)
+                      : NULL;
+    canvas_text_cache_t* text_cache = canvas_text_cache_create();
+    canvas_list_t* list = canvas_list_create();
+    if (!text_cache || !list) {
+        fprintf(stderr, "Can't create text cache or display list\n");
+        canvas_list_destroy(list);
+        canvas_text_cache_destroy(text_cache);
+        canvas_tiler_destroy(tiler);
+        presenter_destroy(&conn, &presenter);
+        x11_swapchain_destroy(&conn, &swapchain);
+        if (sync_counter)
+            x11_sync_destroy_counter(&conn, sync_counter);
+        x11_randr_free_monitors(monitors);
+        x11_disconnect(&conn);
+        return EXIT_FAILURE;
+    }
 
-    // Event loop
+    // Event loop: handle all queued events first, then draw one frame. With Present the next frame
+    // waits until the previous one was shown, which paces drawing to the display refresh.
     x11_event_t event;
     bool running = true;
+    x11_image_t* drawn_image = NULL;
     bool has_pending_sync = false;
     int32_t pending_sync_lo = 0, pending_sync_hi = 0;
-    while (running && x11_wait_for_event(&conn, &event)) {
+    while (running) {
+        bool frame_due = canvas.dirty_count > 0 && !presenter.pending;
+        int32_t timeout = frame_due ? 0 : (presenter.pending && canvas.dirty_count > 0 ? PRESENT_TIMEOUT_MS : -1);
+        int32_t result = x11_poll_event(&conn, &event, timeout);
+        if (result < 0)
+            break;
+        if (result == 0) {
+            if (presenter.pending) {
+                // The completion got lost (e.g. the window was unmapped), don't stall
+                presenter.pending = false;
+                continue;
+            }
+            // Record the scene, when nothing changed only the exposed regions are uploaded again
+            canvas_begin_list(&canvas, list);
+            render(&canvas, text_cache);
+            if (canvas_end_list(&canvas)) {
+                x11_image_t* img = x11_swapchain_acquire(&conn, &swapchain);
+                if (!img) {
+                    fprintf(stderr, "Can't acquire image\n");
+                    break;
+                }
+                // Only the image of the last frame can be drawn over with the changes
+                canvas.pixels = img->pixels;
+                canvas_begin_tiled(&canvas, tiler);
+                canvas_draw_list(&canvas, list, img != drawn_image);
+                canvas_end_tiled(&canvas);
+                drawn_image = img;
+            }
+            presenter_show(&conn, &presenter, &swapchain, &canvas);
+            // Ack the sync request once the frame for the new size is out
+            if (has_pending_sync && sync_counter) {
+                x11_sync_set_counter(&conn, sync_counter, pending_sync_lo, pending_sync_hi);
+                has_pending_sync = false;
+            }
+            continue;
+        }
+
+        if (event.type == X11_PRESENT_COMPLETE_NOTIFY && event.present_serial == presenter.serial) {
+            presenter.pending = false;
+        }
+
         if (event.type == X11_CLIENT_MESSAGE_SYNC_REQUEST) {
             has_pending_sync = true;
             pending_sync_lo = event.sync_value_lo;
@@ -276,30 +574,17 @@ int main(void) {
                 uint32_t size_vals[] = {(uint32_t)phys_w, (uint32_t)phys_h};
                 x11_configure_window(&conn, window, X11_CONFIG_WINDOW_WIDTH | X11_CONFIG_WINDOW_HEIGHT, size_vals,
                                      sizeof(size_vals));
-            } else if (new_w != img.width || new_h != img.height) {
-                // User resize: derive logical dimensions from the new physical size.
+            } else if (new_w != swapchain.width || new_h != swapchain.height) {
+                // User resize: derive logical dimensions from the new physical size. The images are
+                // resized when the next frame acquires them, so uploads in flight are left alone.
                 logical_w = (int32_t)(new_w / scale);
                 logical_h = (int32_t)(new_h / scale);
-                if (!x11_resize_image(&conn, &img, new_w, new_h)) {
-                    fprintf(stderr, "Can't resize image\n");
-                    running = false;
-                    break;
-                }
-                canvas_init(&canvas, logical_w, logical_h, img.pixels, scale);
-                // Coalesce: if more events are already queued (common during a
-                // live resize drag), skip rendering this intermediate frame -
-                // the next ConfigureNotify will render at the final size.
-                // Always ack the sync so the compositor can send the next step.
-                if (!x11_has_event_pending(&conn)) {
-                    render(&canvas);
-                    x11_put_image(&conn, render_target, &img);
-                    if (back_buffer)
-                        x11_xdbe_swap_buffers(&conn, window);
-                }
-                if (has_pending_sync && sync_counter) {
-                    x11_sync_set_counter(&conn, sync_counter, pending_sync_lo, pending_sync_hi);
-                    has_pending_sync = false;
-                }
+                x11_swapchain_resize(&swapchain, new_w, new_h);
+                presenter_resize(&conn, &presenter, new_w, new_h);
+                canvas_init(&canvas, logical_w, logical_h, NULL, scale);
+                // The frame is drawn once the queued events are handled, so the intermediate
+                // sizes of a live resize drag are skipped. The sync is acked after that frame.
+                canvas_add_dirty_rect(&canvas, 0, 0, canvas.phys_width, canvas.phys_height);
             } else if (has_pending_sync && sync_counter) {
                 // Position-only change: no repaint needed, ack immediately.
                 x11_sync_set_counter(&conn, sync_counter, pending_sync_lo, pending_sync_hi);
@@ -307,12 +592,10 @@ int main(void) {
             }
         }
 
-        // Expose (count == 0 means no more expose events pending): render and blit.
-        if (event.type == X11_EXPOSE && event.expose_count == 0) {
-            render(&canvas);
-            x11_put_image(&conn, render_target, &img);
-            if (back_buffer)
-                x11_xdbe_swap_buffers(&conn, window);
+        // Expose: collect the exposed regions, only those are blitted with the next frame.
+        // The display list only draws again what changed.
+        if (event.type == X11_EXPOSE) {
+            canvas_add_dirty_rect(&canvas, event.expose_x, event.expose_y, event.expose_width, event.expose_height);
         }
 
         if (event.type == X11_RANDR_SCREEN_CHANGE_NOTIFY) {
@@ -324,26 +607,20 @@ int main(void) {
             x11_randr_get_monitors(&conn, &monitors, &monitor_count);
 
             int32_t idx = (monitor_count > 0) ? find_monitor_for_window(monitors, monitor_count, window_x, window_y,
-                                                                        img.width, img.height)
+                                                                        swapchain.width, swapchain.height)
                                               : 0;
             float new_scale = compute_scale(&conn, monitors, monitor_count, idx);
             if (new_scale != scale) {
                 scale = new_scale;
                 int32_t phys_w = (int32_t)(logical_w * scale);
                 int32_t phys_h = (int32_t)(logical_h * scale);
-                if (!x11_resize_image(&conn, &img, phys_w, phys_h)) {
-                    fprintf(stderr, "Can't resize image\n");
-                    running = false;
-                    break;
-                }
+                x11_swapchain_resize(&swapchain, phys_w, phys_h);
                 uint32_t size_vals[] = {(uint32_t)phys_w, (uint32_t)phys_h};
                 x11_configure_window(&conn, window, X11_CONFIG_WINDOW_WIDTH | X11_CONFIG_WINDOW_HEIGHT, size_vals,
                                      sizeof(size_vals));
-                canvas_init(&canvas, logical_w, logical_h, img.pixels, scale);
-                render(&canvas);
-                x11_put_image(&conn, render_target, &img);
-                if (back_buffer)
-                    x11_xdbe_swap_buffers(&conn, window);
+                presenter_resize(&conn, &presenter, phys_w, phys_h);
+                canvas_init(&canvas, logical_w, logical_h, NULL, scale);
+                canvas_add_dirty_rect(&canvas, 0, 0, canvas.phys_width, canvas.phys_height);
             }
         }
 
@@ -354,9 +631,11 @@ int main(void) {
 
     if (sync_counter)
         x11_sync_destroy_counter(&conn, sync_counter);
-    if (back_buffer)
-        x11_xdbe_free_back_buffer(&conn, back_buffer);
-    x11_destroy_image(&conn, &img);
+    presenter_destroy(&conn, &presenter);
+    canvas_list_destroy(list);
+    canvas_text_cache_destroy(text_cache);
+    canvas_tiler_destroy(tiler);
+    x11_swapchain_destroy(&conn, &swapchain);
     x11_randr_free_monitors(monitors);
     x11_disconnect(&conn);
     return EXIT_SUCCESS;
@@ -80,45 +80,233 @@ static bool x11_skip(int fd, size_t len) {
     return true;
 }
 
+// Write all iovecs, continuing after partial writes
+static bool x11_writev_all(int fd, struct iovec* iov, int count) {
+    while (count > 0) {
+        ssize_t n = writev(fd, iov, count);
+        if (n <= 0) {
+            if (n < 0 && errno == EINTR)
+                continue;
+            return false;
+        }
+        size_t advance = (size_t)n;
+        while (count > 0 && advance >= iov->iov_len) {
+            advance -= iov->iov_len;
+            iov++;
+            count--;
+        }
+        if (count > 0) {
+            iov->iov_base = (uint8_t*)iov->iov_base + advance;
+            iov->iov_len -= advance;
+        }
+    }
+    return true;
+}
+
+// MARK: Requests
+
+bool x11_flush(x11_connection_t* conn) {
+    if (conn->out_len > 0) {
+        if (!conn->io_error && !x11_write_all(conn->fd, conn->out_buf, conn->out_len))
+            conn->io_error = true;
+        conn->out_len = 0;
+    }
+    return !conn->io_error;
+}
+
+// Queue one request made of iovecs and return its sequence number. A request that doesn't fit
+// in the buffer is written together with the buffered requests in one writev.
+static uint64_t x11_send_iov(x11_connection_t* conn, const struct iovec* iov, int count) {
+    conn->sequence++;
+    size_t total = 0;
+    for (int i = 0; i < count; i++)
+        total += iov[i].iov_len;
+    if (total > X11_OUTPUT_BUFFER_SIZE - conn->out_len && total <= X11_OUTPUT_BUFFER_SIZE)
+        x11_flush(conn);
+    if (total <= X11_OUTPUT_BUFFER_SIZE - conn->out_len) {
+        for (int i = 0; i < count; i++) {
+            if (iov[i].iov_len > 0)
+                memcpy(conn->out_buf + conn->out_len, iov[i].iov_base, iov[i].iov_len);
+            conn->out_len += iov[i].iov_len;
+        }
+        return conn->sequence;
+    }
+
+    struct iovec all[2 + X11_PUT_IMAGE_MAX_ROW_IOVS];
+    all[0].iov_base = conn->out_buf;
+    all[0].iov_len = conn->out_len;
+    memcpy(&all[1], iov, (size_t)count * sizeof(struct iovec));
+    if (!conn->io_error && !x11_writev_all(conn->fd, all, count + 1))
+        conn->io_error = true;
+    conn->out_len = 0;
+    return conn->sequence;
+}
+
+// Queue a request header with data padded to 4 bytes and return its sequence number
+static uint64_t x11_send(x11_connection_t* conn, const void* header, size_t header_size, const void* data,
+                         size_t data_size) {
+    uint8_t zeros[3] = {0};
+    struct iovec iov[3] = {
+        {.iov_base = (void*)header, .iov_len = header_size},
+        {.iov_base = (void*)data, .iov_len = data_size},
+        {.iov_base = zeros, .iov_len = (4 - (data_size % 4)) % 4},
+    };
+    return x11_send_iov(conn, iov, 3);
+}
+
+// Widen the 16-bit sequence number of a packet, it belongs to a request at most 65535 requests ago
+static uint64_t x11_widen_sequence(x11_connection_t* conn, uint16_t sequence) {
+    uint64_t full = (conn->sequence & ~(uint64_t)0xffff) | sequence;
+    if (full > conn->sequence && full >= 0x10000)
+        full -= 0x10000;
+    return full;
+}
+
+// The server attached the segments of processed attaches, so they can be marked for removal now.
+// They are removed once the client and the server both detached, also after a crash.
+static void x11_retire_shm_attaches(x11_connection_t* conn) {
+    int32_t i = 0;
+    while (i < conn->shm_attach_count) {
+        if (conn->shm_attaches[i].sequence <= conn->processed_sequence) {
+            shmctl(conn->shm_attaches[i].shmid, IPC_RMID, NULL);
+            conn->shm_attaches[i] = conn->shm_attaches[--conn->shm_attach_count];
+        } else {
+            i++;
+        }
+    }
+}
+
+// Errors arrive asynchronously, match them to their request by sequence number
+static void x11_handle_error(x11_connection_t* conn, const uint8_t* buf) {
+    conn->error_sequence = conn->processed_sequence;
+    for (int32_t i = 0; i < conn->shm_attach_count; i++) {
+        if (conn->shm_attaches[i].sequence == conn->processed_sequence) {
+            // The image keeps its pixels, they are uploaded with PutImage from now on
+            fprintf(stderr, "X11: MIT-SHM attach failed, falling back to PutImage\n");
+            conn->has_shm = false;
+            return;
+        }
+    }
+    if (conn->processed_sequence == conn->checked_sequence)
+        return;
+    uint16_t minor_opcode;
+    memcpy(&minor_opcode, &buf[8], 2);
+    fprintf(stderr, "X11 error: code=%d sequence=%llu opcode=%d.%d\n", buf[1],
+            (unsigned long long)conn->processed_sequence, buf[10], minor_opcode);
+}
+
+// Read one reply header, error or event into a X11_MAX_EVENT_SIZE buffer and track the sequence
+// number the server processed. Generic events are read whole, up to the buffer size.
+static bool x11_read_packet(x11_connection_t* conn, uint8_t* buf) {
+    if (conn->io_error || !x11_read_all(conn->fd, buf, 32)) {
+        conn->io_error = true;
+        return false;
+    }
+    if (buf[0] == X11_GENERIC_EVENT) {
+        uint32_t extra;
+        memcpy(&extra, &buf[4], 4);
+        size_t extra_bytes = (size_t)extra * 4;
+        size_t kept = extra_bytes < X11_MAX_EVENT_SIZE - 32 ? extra_bytes : X11_MAX_EVENT_SIZE - 32;
+        if (!x11_read_all(conn->fd, buf + 32, kept) || !x11_skip(conn->fd, extra_bytes - kept)) {
+            conn->io_error = true;
+            return false;
+        }
+    }
+    if ((buf[0] & 0x7f) != X11_KEYMAP_NOTIFY) {
+        uint16_t sequence;
+        memcpy(&sequence, &buf[2], 2);
+        conn->processed_sequence = x11_widen_sequence(conn, sequence);
+    }
+    if (buf[0] == X11_ERROR)
+        x11_handle_error(conn, buf);
+    x11_retire_shm_attaches(conn);
+    return true;
+}
+
+static void x11_queue_event(x11_connection_t* conn, const uint8_t* buf) {
+    if (conn->event_count == conn->event_capacity) {
+        size_t capacity = conn->event_capacity > 0 ? conn->event_capacity * 2 : 16;
+        uint8_t(*events)[X11_MAX_EVENT_SIZE] = realloc(conn->events, capacity * X11_MAX_EVENT_SIZE);
+        if (!events) {
+            fprintf(stderr, "X11: out of memory, dropping event\n");
+            return;
+        }
+        conn->events = events;
+        conn->event_capacity = capacity;
+    }
+    memcpy(conn->events[conn->event_count++], buf, X11_MAX_EVENT_SIZE);
+}
+
+// Flush and read the reply of a request, events that arrive first are queued. Returns false when
+// the request failed or the connection broke. Replies longer than 32 bytes are read into reply up to
+// size, the rest of the reply data stays in the socket for the caller.
+static bool x11_read_reply(x11_connection_t* conn, uint64_t sequence, void* reply, size_t size) {
+    if (!x11_flush(conn))
+        return false;
+    uint8_t buf[X11_MAX_EVENT_SIZE];
+    for (;;) {
+        if (!x11_read_packet(conn, buf))
+            return false;
+        if (buf[0] == X11_REPLY) {
+            if (conn->processed_sequence == sequence)
+                break;
+            // A reply nobody waits for, skip its data
+            uint32_t extra;
+            memcpy(&extra, &buf[4], 4);
+            if (!x11_skip(conn->fd, (size_t)extra * 4)) {
+                conn->io_error = true;
+                return false;
+            }
+        } else if (buf[0] == X11_ERROR) {
+            if (conn->processed_sequence == sequence)
+                return false;
+        } else {
+            x11_queue_event(conn, buf);
+        }
+    }
+    memcpy(reply, buf, size < 32 ? size : 32);
+    if (size > 32 && !x11_read_all(conn->fd, (uint8_t*)reply + 32, size - 32)) {
+        conn->io_error = true;
+        return false;
+    }
+    return true;
+}
+
 // Minimal round-trip (GetInputFocus) used to drain the server's request queue.
-static bool x11_sync(int fd) {
+bool x11_sync(x11_connection_t* conn) {
     typedef struct X11_PACKED {
         uint8_t op;
         uint8_t pad;
         uint16_t len;
     } x11_get_input_focus_t;
     x11_get_input_focus_t req = {43, 0, 1};
-    if (!x11_write_all(fd, &req, sizeof(req)))
-        return false;
+    uint64_t sequence = x11_send(conn, &req, sizeof(req), NULL, 0);
     uint8_t reply[32];
-    return x11_read_all(fd, reply, 32);
+    return x11_read_reply(conn, sequence, reply, sizeof(reply));
 }
 
-// Like x11_sync, but returns false if the server replied with an error to the
-// preceding request (e.g. BadAlloc from AllocBackBuffer on XQuartz).
-// Consumes one leading error event, then reads the GetInputFocus reply.
-static bool x11_sync_check_error(int fd) {
-    typedef struct X11_PACKED {
-        uint8_t op;
-        uint8_t pad;
-        uint16_t len;
-    } x11_get_input_focus_t;
-    x11_get_input_focus_t req = {43, 0, 1};
-    if (!x11_write_all(fd, &req, sizeof(req)))
-        return false;
-    uint8_t buf[32];
-    if (!x11_read_all(fd, buf, 32))
-        return false;
-    if (buf[0] == 0) {
-        // Error response: consume the GetInputFocus reply that follows and report failure.
-        if (!x11_read_all(fd, buf, 32))
-            return false;
-        return false;
+// Attach a shared memory segment without waiting for the server, the segment is marked for removal
+// when a later packet shows the server processed the attach
+static void x11_shm_attach(x11_connection_t* conn, uint32_t shmseg, int32_t shmid) {
+    if (conn->shm_attach_count == X11_MAX_PENDING_SHM_ATTACHES)
+        x11_sync(conn);
+    x11_shm_attach_request_t attach = {
+        .major_opcode = conn->shm_opcode,
+        .minor_opcode = X11_SHM_ATTACH,
+        .length = sizeof(attach) / 4,
+        .shmseg = shmseg,
+        .shmid = (uint32_t)shmid,
+        .read_only = 0,
+    };
+    uint64_t sequence = x11_send(conn, &attach, sizeof(attach), NULL, 0);
+    if (conn->shm_attach_count < X11_MAX_PENDING_SHM_ATTACHES) {
+        conn->shm_attaches[conn->shm_attach_count].sequence = sequence;
+        conn->shm_attaches[conn->shm_attach_count].shmid = shmid;
+        conn->shm_attach_count++;
     }
-    return true;
 }
 
-static bool x11_intern_atom(int fd, const char* name) {
+static uint64_t x11_intern_atom(x11_connection_t* conn, const char* name) {
     size_t name_len = strlen(name);
     size_t padded = (name_len + 3) & ~3;
     x11_intern_atom_request_t req = {
@@ -127,14 +315,12 @@ static bool x11_intern_atom(int fd, const char* name) {
         .length = (sizeof(x11_intern_atom_request_t) + padded) / 4,
         .name_len = name_len,
     };
-    if (!x11_write_all(fd, &req, sizeof(req)))
-        return false;
-    return x11_write_padded(fd, name, name_len);
+    return x11_send(conn, &req, sizeof(req), name, name_len);
 }
 
-static bool x11_read_intern_atom_reply(int fd, uint32_t* atom) {
+static bool x11_read_intern_atom_reply(x11_connection_t* conn, uint64_t sequence, uint32_t* atom) {
     x11_intern_atom_reply_t reply;
-    if (!x11_read_all(fd, &reply, sizeof(reply)))
+    if (!x11_read_reply(conn, sequence, &reply, sizeof(reply)))
         return false;
     if (reply.reply != 1)
         return false;
@@ -142,7 +328,7 @@ static bool x11_read_intern_atom_reply(int fd, uint32_t* atom) {
     return true;
 }
 
-static bool x11_query_extension(int fd, const char* name) {
+static uint64_t x11_query_extension(x11_connection_t* conn, const char* name) {
     size_t name_len = strlen(name);
     size_t padded = (name_len + 3) & ~3;
     x11_query_extension_request_t req = {
@@ -150,14 +336,13 @@ static bool x11_query_extension(int fd, const char* name) {
         .length = (uint16_t)((sizeof(x11_query_extension_request_t) + padded) / 4),
         .name_len = (uint16_t)name_len,
     };
-    if (!x11_write_all(fd, &req, sizeof(req)))
-        return false;
-    return x11_write_padded(fd, name, name_len);
+    return x11_send(conn, &req, sizeof(req), name, name_len);
 }
 
-static bool x11_read_query_extension_reply(int fd, bool* present, uint8_t* major_opcode, uint8_t* first_event) {
+static bool x11_read_query_extension_reply(x11_connection_t* conn, uint64_t sequence, bool* present,
+                                           uint8_t* major_opcode, uint8_t* first_event) {
     x11_query_extension_reply_t reply;
-    if (!x11_read_all(fd, &reply, sizeof(reply)))
+    if (!x11_read_reply(conn, sequence, &reply, sizeof(reply)))
         return false;
     if (reply.reply != 1)
         return false;
@@ -520,65 +705,51 @@ bool x11_connect(x11_connection_t* conn) {
         }
     }
 
-    // Intern atoms
-    if (!x11_intern_atom(conn->fd, "WM_PROTOCOLS"))
-        goto fail;
-    if (!x11_intern_atom(conn->fd, "WM_DELETE_WINDOW"))
-        goto fail;
-    if (!x11_intern_atom(conn->fd, "_NET_WM_NAME"))
-        goto fail;
-    if (!x11_intern_atom(conn->fd, "_NET_WM_PID"))
-        goto fail;
-    if (!x11_intern_atom(conn->fd, "UTF8_STRING"))
-        goto fail;
-    if (!x11_intern_atom(conn->fd, "_NET_WM_WINDOW_TYPE"))
-        goto fail;
-    if (!x11_intern_atom(conn->fd, "_NET_WM_WINDOW_TYPE_NORMAL"))
-        goto fail;
-    if (!x11_intern_atom(conn->fd, "_NET_WM_SYNC_REQUEST"))
-        goto fail;
-    if (!x11_intern_atom(conn->fd, "_NET_WM_SYNC_REQUEST_COUNTER"))
-        goto fail;
-
-    if (!x11_read_intern_atom_reply(conn->fd, &conn->wm_protocols))
-        goto fail;
-    if (!x11_read_intern_atom_reply(conn->fd, &conn->wm_delete_window))
-        goto fail;
-    if (!x11_read_intern_atom_reply(conn->fd, &conn->net_wm_name))
-        goto fail;
-    if (!x11_read_intern_atom_reply(conn->fd, &conn->net_wm_pid))
-        goto fail;
-    if (!x11_read_intern_atom_reply(conn->fd, &conn->utf8_string))
-        goto fail;
-    if (!x11_read_intern_atom_reply(conn->fd, &conn->net_wm_window_type))
-        goto fail;
-    if (!x11_read_intern_atom_reply(conn->fd, &conn->net_wm_window_type_normal))
-        goto fail;
-    if (!x11_read_intern_atom_reply(conn->fd, &conn->net_wm_sync_request))
-        goto fail;
-    if (!x11_read_intern_atom_reply(conn->fd, &conn->net_wm_sync_request_counter))
-        goto fail;
-
-    // Query MIT-SHM, BIG-REQUESTS, RANDR, SYNC, DOUBLE-BUFFER (pipelined)
-    if (!x11_query_extension(conn->fd, "MIT-SHM"))
-        goto fail;
-    if (!x11_query_extension(conn->fd, "BIG-REQUESTS"))
-        goto fail;
-    if (!x11_query_extension(conn->fd, "RANDR"))
-        goto fail;
-    if (!x11_query_extension(conn->fd, "SYNC"))
-        goto fail;
-    if (!x11_query_extension(conn->fd, "DOUBLE-BUFFER"))
-        goto fail;
+    // Intern atoms (pipelined, the replies are matched by sequence number)
+    {
+        const char* atom_names[] = {
+            "WM_PROTOCOLS",
+            "WM_DELETE_WINDOW",
+            "_NET_WM_NAME",
+            "_NET_WM_PID",
+            "UTF8_STRING",
+            "_NET_WM_WINDOW_TYPE",
+            "_NET_WM_WINDOW_TYPE_NORMAL",
+            "_NET_WM_SYNC_REQUEST",
+            "_NET_WM_SYNC_REQUEST_COUNTER",
+        };
+        uint32_t* atoms[] = {
+            &conn->wm_protocols,
+            &conn->wm_delete_window,
+            &conn->net_wm_name,
+            &conn->net_wm_pid,
+            &conn->utf8_string,
+            &conn->net_wm_window_type,
+            &conn->net_wm_window_type_normal,
+            &conn->net_wm_sync_request,
+            &conn->net_wm_sync_request_counter,
+        };
+        uint64_t atom_sequences[sizeof(atom_names) / sizeof(atom_names[0])];
+        for (size_t i = 0; i < sizeof(atom_names) / sizeof(atom_names[0]); i++)
+            atom_sequences[i] = x11_intern_atom(conn, atom_names[i]);
+        for (size_t i = 0; i < sizeof(atom_names) / sizeof(atom_names[0]); i++) {
+            if (!x11_read_intern_atom_reply(conn, atom_sequences[i], atoms[i]))
+                goto fail;
+        }
+    }
 
-    // Read ALL 5 replies before sending any further requests - inserting a
-    // BIG-REQUESTS Enable request between reads would displace the RANDR/SYNC/XDBE
-    // replies and cause those extensions to be silently reported as absent.
+    // Query MIT-SHM, BIG-REQUESTS, RANDR, SYNC, DOUBLE-BUFFER, Present (pipelined)
+    uint64_t shm_sequence = x11_query_extension(conn, "MIT-SHM");
+    uint64_t big_sequence = x11_query_extension(conn, "BIG-REQUESTS");
+    uint64_t randr_sequence = x11_query_extension(conn, "RANDR");
+    uint64_t sync_sequence = x11_query_extension(conn, "SYNC");
+    uint64_t xdbe_sequence = x11_query_extension(conn, "DOUBLE-BUFFER");
+    uint64_t present_sequence = x11_query_extension(conn, "Present");
     {
         bool shm_present = false;
         uint8_t shm_opcode = 0;
         uint8_t shm_first_event = 0;
-        if (!x11_read_query_extension_reply(conn->fd, &shm_present, &shm_opcode, &shm_first_event))
+        if (!x11_read_query_extension_reply(conn, shm_sequence, &shm_present, &shm_opcode, &shm_first_event))
             goto fail;
         conn->has_shm = shm_present;
         conn->shm_opcode = shm_opcode;
@@ -586,13 +757,13 @@ bool x11_connect(x11_connection_t* conn) {
     }
     bool big_present = false;
     uint8_t big_opcode = 0;
-    if (!x11_read_query_extension_reply(conn->fd, &big_present, &big_opcode, NULL))
+    if (!x11_read_query_extension_reply(conn, big_sequence, &big_present, &big_opcode, NULL))
         goto fail;
     {
         bool randr_present = false;
         uint8_t randr_opcode = 0;
         uint8_t randr_first_event = 0;
-        if (!x11_read_query_extension_reply(conn->fd, &randr_present, &randr_opcode, &randr_first_event))
+        if (!x11_read_query_extension_reply(conn, randr_sequence, &randr_present, &randr_opcode, &randr_first_event))
             goto fail;
         conn->has_randr = randr_present;
         conn->randr_opcode = randr_opcode;
@@ -601,7 +772,7 @@ bool x11_connect(x11_connection_t* conn) {
     {
         bool sync_present = false;
         uint8_t sync_opcode = 0;
-        if (!x11_read_query_extension_reply(conn->fd, &sync_present, &sync_opcode, NULL))
+        if (!x11_read_query_extension_reply(conn, sync_sequence, &sync_present, &sync_opcode, NULL))
             goto fail;
         conn->has_sync = sync_present;
         conn->sync_opcode = sync_opcode;
@@ -609,43 +780,44 @@ bool x11_connect(x11_connection_t* conn) {
     {
         bool xdbe_present = false;
         uint8_t xdbe_opcode = 0;
-        if (!x11_read_query_extension_reply(conn->fd, &xdbe_present, &xdbe_opcode, NULL))
+        if (!x11_read_query_extension_reply(conn, xdbe_sequence, &xdbe_present, &xdbe_opcode, NULL))
             goto fail;
         conn->has_xdbe = xdbe_present;
         conn->xdbe_opcode = xdbe_opcode;
     }
+    {
+        bool present_present = false;
+        uint8_t present_opcode = 0;
+        if (!x11_read_query_extension_reply(conn, present_sequence, &present_present, &present_opcode, NULL))
+            goto fail;
+        conn->has_present = present_present;
+        conn->present_opcode = present_opcode;
+    }
 
-    // Now that all pipelined replies have been consumed, enable BIG-REQUESTS.
+    // Enable BIG-REQUESTS and initialize the extensions (pipelined, one round trip for all of them)
+    uint64_t big_enable_sequence = 0;
     if (big_present) {
         x11_big_req_enable_request_t br_req = {
             .major_opcode = big_opcode,
             .minor_opcode = 0,
             .length = sizeof(br_req) / 4,
         };
-        if (!x11_write_all(conn->fd, &br_req, sizeof(br_req)))
-            goto fail;
-        x11_big_req_enable_reply_t br_reply;
-        if (!x11_read_all(conn->fd, &br_reply, sizeof(br_reply)) || br_reply.reply != 1)
-            goto fail;
-        conn->max_request_len = br_reply.maximum_request_length;
+        big_enable_sequence = x11_send(conn, &br_req, sizeof(br_req), NULL, 0);
     }
 
     // Verify SHM is actually functional via a round-trip QueryVersion
+    uint64_t shm_version_sequence = 0;
     if (conn->has_shm) {
         x11_shm_query_version_request_t qv = {
             .major_opcode = conn->shm_opcode,
             .minor_opcode = 0,
             .length = sizeof(qv) / 4,
         };
-        if (!x11_write_all(conn->fd, &qv, sizeof(qv)))
-            goto fail;
-        x11_shm_query_version_reply_t qv_reply;
-        if (!x11_read_all(conn->fd, &qv_reply, sizeof(qv_reply)) || qv_reply.reply != 1) {
-            conn->has_shm = false;
-        }
+        shm_version_sequence = x11_send(conn, &qv, sizeof(qv), NULL, 0);
     }
 
     // Query RANDR version
+    uint64_t randr_version_sequence = 0;
     if (conn->has_randr) {
         x11_randr_query_version_request_t vreq = {
             .major_opcode = conn->randr_opcode,
@@ -654,18 +826,11 @@ bool x11_connect(x11_connection_t* conn) {
             .major_version = 1,
             .minor_version = 5,
         };
-        if (!x11_write_all(conn->fd, &vreq, sizeof(vreq)))
-            goto fail;
-        x11_randr_query_version_reply_t vreply;
-        if (!x11_read_all(conn->fd, &vreply, sizeof(vreply)) || vreply.reply != 1) {
-            conn->has_randr = false;
-        } else {
-            conn->randr_major = vreply.server_major;
-            conn->randr_minor = vreply.server_minor;
-        }
+        randr_version_sequence = x11_send(conn, &vreq, sizeof(vreq), NULL, 0);
     }
 
     // Initialize SYNC extension (must be done before using any SYNC requests)
+    uint64_t sync_init_sequence = 0;
     if (conn->has_sync) {
         x11_sync_initialize_request_t sreq = {
             .major_opcode = conn->sync_opcode,
@@ -674,15 +839,11 @@ bool x11_connect(x11_connection_t* conn) {
             .major_version = 3,
             .minor_version = 1,
         };
-        if (!x11_write_all(conn->fd, &sreq, sizeof(sreq)))
-            goto fail;
-        x11_sync_initialize_reply_t sreply;
-        if (!x11_read_all(conn->fd, &sreply, sizeof(sreply)) || sreply.reply != 1) {
-            conn->has_sync = false;
-        }
+        sync_init_sequence = x11_send(conn, &sreq, sizeof(sreq), NULL, 0);
     }
 
     // Initialize XDBE extension (must be done before using any XDBE requests)
+    uint64_t xdbe_version_sequence = 0;
     if (conn->has_xdbe) {
         x11_xdbe_get_version_request_t xreq = {
             .major_opcode = conn->xdbe_opcode,
@@ -691,13 +852,59 @@ bool x11_connect(x11_connection_t* conn) {
             .major_version = 1,
             .minor_version = 0,
         };
-        if (!x11_write_all(conn->fd, &xreq, sizeof(xreq)))
+        xdbe_version_sequence = x11_send(conn, &xreq, sizeof(xreq), NULL, 0);
+    }
+
+    // Query the Present version (must be done before using any Present requests)
+    uint64_t present_version_sequence = 0;
+    if (conn->has_present) {
+        x11_present_query_version_request_t preq = {
+            .major_opcode = conn->present_opcode,
+            .minor_opcode = X11_PRESENT_QUERY_VERSION,
+            .length = sizeof(preq) / 4,
+            .major_version = 1,
+            .minor_version = 0,
+        };
+        present_version_sequence = x11_send(conn, &preq, sizeof(preq), NULL, 0);
+    }
+
+    if (big_present) {
+        x11_big_req_enable_reply_t br_reply;
+        if (!x11_read_reply(conn, big_enable_sequence, &br_reply, sizeof(br_reply)) || br_reply.reply != 1)
             goto fail;
+        conn->max_request_len = br_reply.maximum_request_length;
+    }
+    if (conn->has_shm) {
+        x11_shm_query_version_reply_t qv_reply;
+        if (!x11_read_reply(conn, shm_version_sequence, &qv_reply, sizeof(qv_reply)) || qv_reply.reply != 1)
+            conn->has_shm = false;
+    }
+    if (conn->has_randr) {
+        x11_randr_query_version_reply_t vreply;
+        if (!x11_read_reply(conn, randr_version_sequence, &vreply, sizeof(vreply)) || vreply.reply != 1) {
+            conn->has_randr = false;
+        } else {
+            conn->randr_major = vreply.server_major;
+            conn->randr_minor = vreply.server_minor;
+        }
+    }
+    if (conn->has_sync) {
+        x11_sync_initialize_reply_t sreply;
+        if (!x11_read_reply(conn, sync_init_sequence, &sreply, sizeof(sreply)) || sreply.reply != 1)
+            conn->has_sync = false;
+    }
+    if (conn->has_xdbe) {
         x11_xdbe_get_version_reply_t xreply;
-        if (!x11_read_all(conn->fd, &xreply, sizeof(xreply)) || xreply.reply != 1) {
+        if (!x11_read_reply(conn, xdbe_version_sequence, &xreply, sizeof(xreply)) || xreply.reply != 1)
             conn->has_xdbe = false;
-        }
     }
+    if (conn->has_present) {
+        x11_present_query_version_reply_t preply;
+        if (!x11_read_reply(conn, present_version_sequence, &preply, sizeof(preply)) || preply.reply != 1)
+            conn->has_present = false;
+    }
+    if (conn->io_error)
+        goto fail;
 
     // Query Xft.dpi from root RESOURCE_MANAGER property (loop until bytes_after == 0)
     {
@@ -715,12 +922,9 @@ bool x11_connect(x11_connection_t* conn) {
                 .long_offset = rm_offset,
                 .long_length = 1024,
             };
-            if (!x11_write_all(conn->fd, &prop_req, sizeof(prop_req))) {
-                free(rm_buf);
-                goto fail;
-            }
+            uint64_t prop_sequence = x11_send(conn, &prop_req, sizeof(prop_req), NULL, 0);
             x11_get_property_reply_t prop_reply;
-            if (!x11_read_all(conn->fd, &prop_reply, sizeof(prop_reply))) {
+            if (!x11_read_reply(conn, prop_sequence, &prop_reply, sizeof(prop_reply))) {
                 free(rm_buf);
                 goto fail;
             }
@@ -759,6 +963,7 @@ bool x11_connect(x11_connection_t* conn) {
 fail:
     if (conn->fd >= 0)
         close(conn->fd);
+    free(conn->events);
     free_cookie(cookie);
     return false;
 }
@@ -786,8 +991,7 @@ void x11_create_window(x11_connection_t* conn, uint8_t depth, uint32_t wid, uint
         ._class = _class,
         .visual = visual,
         .value_mask = value_mask};
-    x11_write_all(conn->fd, &create_window_request, sizeof(x11_create_window_request_t));
-    x11_write_all(conn->fd, value_list, value_list_size);
+    x11_send(conn, &create_window_request, sizeof(x11_create_window_request_t), value_list, value_list_size);
 }
 
 void x11_change_property(x11_connection_t* conn, uint8_t mode, uint32_t window, uint32_t property, uint32_t type,
@@ -807,8 +1011,7 @@ void x11_change_property(x11_connection_t* conn, uint8_t mode, uint32_t window,
         .type = type,
         .format = format,
         .data_len = data_len_in_format_units};
-    x11_write_all(conn->fd, &change_property_request, sizeof(x11_change_property_request_t));
-    x11_write_padded(conn->fd, data, data_size);
+    x11_send(conn, &change_property_request, sizeof(x11_change_property_request_t), data, data_size);
 }
 
 void x11_configure_window(x11_connection_t* conn, uint32_t window, uint16_t value_mask, uint32_t* value_list,
@@ -818,8 +1021,7 @@ void x11_configure_window(x11_connection_t* conn, uint32_t window, uint16_t valu
         .length = (sizeof(x11_configure_window_request_t) + value_list_size) / 4,
         .window = window,
         .value_mask = value_mask};
-    x11_write_all(conn->fd, &configure_window_request, sizeof(x11_configure_window_request_t));
-    x11_write_all(conn->fd, value_list, value_list_size);
+    x11_send(conn, &configure_window_request, sizeof(x11_configure_window_request_t), value_list, value_list_size);
 }
 
 void x11_set_wm_protocols(x11_connection_t* conn, uint32_t window) {
@@ -847,7 +1049,7 @@ void x11_set_wm_hints(x11_connection_t* conn, uint32_t window) {
 void x11_map_window(x11_connection_t* conn, uint32_t window) {
     x11_map_window_request_t map_window_request = {
         .major_opcode = X11_MAP_WINDOW, .length = sizeof(x11_map_window_request_t) / 4, .window = window};
-    x11_write_all(conn->fd, &map_window_request, sizeof(x11_map_window_request_t));
+    x11_send(conn, &map_window_request, sizeof(x11_map_window_request_t), NULL, 0);
 }
 
 bool x11_create_image(x11_connection_t* conn, x11_image_t* img, uint32_t window, int32_t width, int32_t height) {
@@ -863,8 +1065,7 @@ bool x11_create_image(x11_connection_t* conn, x11_image_t* img, uint32_t window,
         .drawable = window,
         .value_mask = X11_GC_GRAPHICS_EXPOSURES,
     };
-    x11_write_all(conn->fd, &gc_req, sizeof(gc_req));
-    x11_write_all(conn->fd, gc_values, sizeof(gc_values));
+    x11_send(conn, &gc_req, sizeof(gc_req), gc_values, sizeof(gc_values));
 
     if (conn->has_shm) {
         img->shmid = shmget(IPC_PRIVATE, size, IPC_CREAT | 0600);
@@ -877,20 +1078,10 @@ bool x11_create_image(x11_connection_t* conn, x11_image_t* img, uint32_t window,
             }
         }
         if (img->shmid >= 0) {
+            // The segment is marked for auto-cleanup on crash once the server has attached,
+            // without a round trip. It persists until all processes (client + server) detach.
             img->shmseg = x11_generate_id(conn);
-            x11_shm_attach_request_t attach = {
-                .major_opcode = conn->shm_opcode,
-                .minor_opcode = X11_SHM_ATTACH,
-                .length = sizeof(attach) / 4,
-                .shmseg = img->shmseg,
-                .shmid = (uint32_t)img->shmid,
-                .read_only = 0,
-            };
-            x11_write_all(conn->fd, &attach, sizeof(attach));
-            // Sync to confirm the server has attached, then mark for auto-cleanup on crash.
-            // The segment persists until all processes (client + server) detach.
-            x11_sync(conn->fd);
-            shmctl(img->shmid, IPC_RMID, NULL);
+            x11_shm_attach(conn, img->shmseg, img->shmid);
         } else {
             conn->has_shm = false;
         }
@@ -932,7 +1123,9 @@ bool x11_resize_image(x11_connection_t* conn, x11_image_t* img, int32_t new_w, i
             .length = sizeof(detach) / 4,
             .shmseg = img->shmseg,
         };
-        x11_write_all(conn->fd, &detach, sizeof(detach));
+        // A failed attach turned MIT-SHM off, then there is nothing to detach on the server
+        if (conn->has_shm)
+            x11_send(conn, &detach, sizeof(detach), NULL, 0);
         if (img->pixels && img->pixels != (uint32_t*)-1)
             shmdt(img->pixels);
         // IPC_RMID was set at attach time; shmdt above completes the cleanup.
@@ -961,17 +1154,7 @@ bool x11_resize_image(x11_connection_t* conn, x11_image_t* img, int32_t new_w, i
         }
         if (img->shmid >= 0) {
             img->shmseg = x11_generate_id(conn);
-            x11_shm_attach_request_t attach = {
-                .major_opcode = conn->shm_opcode,
-                .minor_opcode = X11_SHM_ATTACH,
-                .length = sizeof(attach) / 4,
-                .shmseg = img->shmseg,
-                .shmid = (uint32_t)img->shmid,
-                .read_only = 0,
-            };
-            x11_write_all(conn->fd, &attach, sizeof(attach));
-            x11_sync(conn->fd);
-            shmctl(img->shmid, IPC_RMID, NULL);
+            x11_shm_attach(conn, img->shmseg, img->shmid);
         } else {
             conn->has_shm = false;
         }
@@ -992,6 +1175,29 @@ bool x11_resize_image(x11_connection_t* conn, x11_image_t* img, int32_t new_w, i
 }
 
 void x11_put_image(x11_connection_t* conn, uint32_t window, x11_image_t* img) {
+    x11_put_image_region(conn, window, img, 0, 0, img->width, img->height);
+}
+
+// Blit a rect of the image, returns the sequence number of the ShmPutImage or 0 when the pixels were
+// copied into the request. With send_event the server sends a ShmCompletion once it read the pixels.
+static uint64_t x11_put_image_rect(x11_connection_t* conn, uint32_t window, x11_image_t* img, int32_t x, int32_t y,
+                                   int32_t width, int32_t height, bool send_event) {
+    // Clip to the image
+    if (x < 0) {
+        width += x;
+        x = 0;
+    }
+    if (y < 0) {
+        height += y;
+        y = 0;
+    }
+    if (width > img->width - x)
+        width = img->width - x;
+    if (height > img->height - y)
+        height = img->height - y;
+    if (width <= 0 || height <= 0)
+        return 0;
+
     uint8_t depth = conn->screen.root_depth;
     if (conn->has_shm && img->shmseg != 0) {
         x11_shm_put_image_request_t req = {
@@ -1002,40 +1208,44 @@ void x11_put_image(x11_connection_t* conn, uint32_t window, x11_image_t* img) {
             .gc = img->gc,
             .total_width = (uint16_t)img->width,
             .total_height = (uint16_t)img->height,
-            .src_x = 0,
-            .src_y = 0,
-            .src_width = (uint16_t)img->width,
-            .src_height = (uint16_t)img->height,
-            .dst_x = 0,
-            .dst_y = 0,
+            .src_x = (uint16_t)x,
+            .src_y = (uint16_t)y,
+            .src_width = (uint16_t)width,
+            .src_height = (uint16_t)height,
+            .dst_x = (int16_t)x,
+            .dst_y = (int16_t)y,
             .depth = depth,
             .format = X11_IMAGE_FORMAT_Z_PIXMAP,
-            .send_event = 0,
+            .send_event = send_event ? 1 : 0,
             .shmseg = img->shmseg,
             .offset = 0,
         };
-        x11_write_all(conn->fd, &req, sizeof(req));
+        return x11_send(conn, &req, sizeof(req), NULL, 0);
     } else {
         // PutImage fallback: batch as many rows as fit within max_request_len.
         // With BigRequests (max_request_len > 65535) the entire frame usually fits
         // in a single atomic request, eliminating visible tearing on XQuartz/remote X.
-        // writev() combines the header and pixel data into one syscall per chunk.
-        uint32_t row_bytes = (uint32_t)img->width * sizeof(uint32_t);
+        // The chunks are written with the buffered requests in one writev() each, a region
+        // narrower than the image needs one iovec per row because its rows are not contiguous.
+        uint32_t row_bytes = (uint32_t)width * sizeof(uint32_t);
         bool use_big_req = conn->max_request_len > 65535;
+        bool contiguous = width == img->width;
         uint32_t header_words = use_big_req ? 7 : 6;  // 28 or 24 bytes
         uint32_t max_rows = (conn->max_request_len - header_words) * 4 / row_bytes;
+        if (!contiguous && max_rows > X11_PUT_IMAGE_MAX_ROW_IOVS)
+            max_rows = X11_PUT_IMAGE_MAX_ROW_IOVS;
         if (max_rows < 1)
             max_rows = 1;
 
-        int32_t y = 0;
-        while (y < img->height) {
-            uint32_t rows = (uint32_t)(img->height - y);
+        int32_t row = y;
+        while (row < y + height) {
+            uint32_t rows = (uint32_t)(y + height - row);
             if (rows > max_rows)
                 rows = max_rows;
             uint32_t data_bytes = row_bytes * rows;
             uint32_t req_units = header_words + data_bytes / 4;
 
-            struct iovec iov[2];
+            struct iovec iov[1 + X11_PUT_IMAGE_MAX_ROW_IOVS];
             uint8_t header[28];  // large enough for both request variants
             size_t header_size;
             if (use_big_req) {
@@ -1046,10 +1256,10 @@ void x11_put_image(x11_connection_t* conn, uint32_t window, x11_image_t* img) {
                     .big_length = req_units,
                     .drawable = window,
                     .gc = img->gc,
-                    .width = (uint16_t)img->width,
+                    .width = (uint16_t)width,
                     .height = (uint16_t)rows,
-                    .dst_x = 0,
-                    .dst_y = (int16_t)y,
+                    .dst_x = (int16_t)x,
+                    .dst_y = (int16_t)row,
                     .left_pad = 0,
                     .depth = depth,
                 };
@@ -1062,10 +1272,10 @@ void x11_put_image(x11_connection_t* conn, uint32_t window, x11_image_t* img) {
                     .length = (uint16_t)req_units,
                     .drawable = window,
                     .gc = img->gc,
-                    .width = (uint16_t)img->width,
+                    .width = (uint16_t)width,
                     .height = (uint16_t)rows,
-                    .dst_x = 0,
-                    .dst_y = (int16_t)y,
+                    .dst_x = (int16_t)x,
+                    .dst_y = (int16_t)row,
                     .left_pad = 0,
                     .depth = depth,
                 };
@@ -1074,49 +1284,32 @@ void x11_put_image(x11_connection_t* conn, uint32_t window, x11_image_t* img) {
             }
             iov[0].iov_base = header;
             iov[0].iov_len = header_size;
-            iov[1].iov_base = img->pixels + y * img->width;
-            iov[1].iov_len = data_bytes;
-
-            size_t total = iov[0].iov_len + iov[1].iov_len;
-            size_t sent = 0;
-            int iov_idx = 0;
-            size_t iov_off = 0;
-            while (sent < total) {
-                struct iovec viov[2];
-                int vcnt = 0;
-                size_t remaining = iov[iov_idx].iov_len - iov_off;
-                viov[vcnt].iov_base = (uint8_t*)iov[iov_idx].iov_base + iov_off;
-                viov[vcnt].iov_len = remaining;
-                vcnt++;
-                if (iov_idx == 0 && iov[1].iov_len > 0) {
-                    viov[vcnt] = iov[1];
-                    vcnt++;
-                }
-                ssize_t n = writev(conn->fd, viov, vcnt);
-                if (n <= 0) {
-                    if (n < 0 && errno == EINTR)
-                        continue;
-                    break;
-                }
-                sent += (size_t)n;
-                size_t advance = (size_t)n;
-                while (advance > 0 && iov_idx < 2) {
-                    size_t avail = iov[iov_idx].iov_len - iov_off;
-                    if (advance >= avail) {
-                        advance -= avail;
-                        iov_idx++;
-                        iov_off = 0;
-                    } else {
-                        iov_off += advance;
-                        advance = 0;
-                    }
+            int iov_count = 1;
+            if (contiguous) {
+                iov[iov_count].iov_base = img->pixels + (size_t)row * (size_t)img->width;
+                iov[iov_count].iov_len = data_bytes;
+                iov_count++;
+            } else {
+                for (uint32_t i = 0; i < rows; i++) {
+                    iov[iov_count].iov_base = img->pixels + (size_t)(row + (int32_t)i) * (size_t)img->width + x;
+                    iov[iov_count].iov_len = row_bytes;
+                    iov_count++;
                 }
             }
-            y += (int32_t)rows;
+            x11_send_iov(conn, iov, iov_count);
+            if (conn->io_error)
+                break;
+            row += (int32_t)rows;
         }
+        return 0;
     }
 }
 
+void x11_put_image_region(x11_connection_t* conn, uint32_t window, x11_image_t* img, int32_t x, int32_t y,
+                          int32_t width, int32_t height) {
+    x11_put_image_rect(conn, window, img, x, y, width, height, false);
+}
+
 void x11_destroy_image(x11_connection_t* conn, x11_image_t* img) {
     // Free the server-side GC
     x11_free_gc_request_t free_gc = {
@@ -1124,7 +1317,7 @@ void x11_destroy_image(x11_connection_t* conn, x11_image_t* img) {
         .length = sizeof(free_gc) / 4,
         .gc = img->gc,
     };
-    x11_write_all(conn->fd, &free_gc, sizeof(free_gc));
+    x11_send(conn, &free_gc, sizeof(free_gc), NULL, 0);
 
     if (img->shmseg != 0) {
         x11_shm_detach_request_t detach = {
@@ -1133,7 +1326,9 @@ void x11_destroy_image(x11_connection_t* conn, x11_image_t* img) {
             .length = sizeof(detach) / 4,
             .shmseg = img->shmseg,
         };
-        x11_write_all(conn->fd, &detach, sizeof(detach));
+        // A failed attach turned MIT-SHM off, then there is nothing to detach on the server
+        if (conn->has_shm)
+            x11_send(conn, &detach, sizeof(detach), NULL, 0);
         if (img->pixels && img->pixels != (uint32_t*)-1)
             shmdt(img->pixels);
         // IPC_RMID was set at attach time; shmdt above triggers final cleanup.
@@ -1146,6 +1341,83 @@ void x11_destroy_image(x11_connection_t* conn, x11_image_t* img) {
     }
 }
 
+bool x11_swapchain_create(x11_connection_t* conn, x11_swapchain_t* swapchain, uint32_t window, int32_t width,
+                          int32_t height) {
+    swapchain->window = window;
+    swapchain->image_count = 0;
+    swapchain->current = 0;
+    swapchain->width = width;
+    swapchain->height = height;
+    if (!x11_create_image(conn, &swapchain->images[0], window, width, height))
+        return false;
+    swapchain->put_sequences[0] = 0;
+    swapchain->image_count = 1;
+    return true;
+}
+
+void x11_swapchain_resize(x11_swapchain_t* swapchain, int32_t width, int32_t height) {
+    swapchain->width = width;
+    swapchain->height = height;
+}
+
+x11_image_t* x11_swapchain_acquire(x11_connection_t* conn, x11_swapchain_t* swapchain) {
+    for (;;) {
+        // Reuse the image of the last frame once the server processed its last ShmPutImage, it still holds
+        // that frame. Otherwise take the next free image
+        for (int32_t i = 0; i < swapchain->image_count; i++) {
+            int32_t index = (swapchain->current + i) % swapchain->image_count;
+            if (swapchain->put_sequences[index] > conn->processed_sequence)
+                continue;
+            x11_image_t* img = &swapchain->images[index];
+            if ((img->width != swapchain->width || img->height != swapchain->height) &&
+                !x11_resize_image(conn, img, swapchain->width, swapchain->height))
+                return NULL;
+            swapchain->current = index;
+            return img;
+        }
+
+        // Every image is in flight: add an image, or wait for the ShmCompletion of the oldest one
+        if (swapchain->image_count < X11_SWAPCHAIN_MAX_IMAGES) {
+            int32_t index = swapchain->image_count;
+            if (!x11_create_image(conn, &swapchain->images[index], swapchain->window, swapchain->width,
+                                  swapchain->height))
+                return NULL;
+            swapchain->put_sequences[index] = 0;
+            swapchain->image_count++;
+            swapchain->current = index;
+            return &swapchain->images[index];
+        }
+        uint8_t buf[X11_MAX_EVENT_SIZE];
+        if (!x11_flush(conn) || !x11_read_packet(conn, buf))
+            return NULL;
+        if (buf[0] == X11_REPLY) {
+            uint32_t extra;
+            memcpy(&extra, &buf[4], 4);
+            if (!x11_skip(conn->fd, (size_t)extra * 4)) {
+                conn->io_error = true;
+                return NULL;
+            }
+        } else if (buf[0] != X11_ERROR) {
+            x11_queue_event(conn, buf);
+        }
+    }
+}
+
+void x11_swapchain_put_region(x11_connection_t* conn, x11_swapchain_t* swapchain, uint32_t drawable, int32_t x,
+                              int32_t y, int32_t width, int32_t height) {
+    uint64_t sequence =
+        x11_put_image_rect(conn, drawable, &swapchain->images[swapchain->current], x, y, width, height, true);
+    if (sequence != 0)
+        swapchain->put_sequences[swapchain->current] = sequence;
+}
+
+void x11_swapchain_destroy(x11_connection_t* conn, x11_swapchain_t* swapchain) {
+    // The detaches are processed after the uploads still in flight
+    for (int32_t i = 0; i < swapchain->image_count; i++)
+        x11_destroy_image(conn, &swapchain->images[i]);
+    swapchain->image_count = 0;
+}
+
 bool x11_randr_get_monitors(x11_connection_t* conn, x11_monitor_t** monitors, int32_t* count) {
     if (!conn->has_randr)
         return false;
@@ -1159,11 +1431,9 @@ bool x11_randr_get_monitors(x11_connection_t* conn, x11_monitor_t** monitors, in
             .window = conn->screen.root,
             .get_active = 1,
         };
-        if (!x11_write_all(conn->fd, &req, sizeof(req)))
-            return false;
-
+        uint64_t sequence = x11_send(conn, &req, sizeof(req), NULL, 0);
         x11_randr_get_monitors_reply_t reply;
-        if (!x11_read_all(conn->fd, &reply, sizeof(reply)) || reply.reply != 1)
+        if (!x11_read_reply(conn, sequence, &reply, sizeof(reply)) || reply.reply != 1)
             return false;
 
         uint32_t n = reply.n_monitors;
@@ -1174,10 +1444,15 @@ bool x11_randr_get_monitors(x11_connection_t* conn, x11_monitor_t** monitors, in
         }
 
         uint32_t* atoms = malloc(n * sizeof(uint32_t));
+        uint64_t* name_sequences = malloc(n * sizeof(uint64_t));
         x11_monitor_t* result = malloc(n * sizeof(x11_monitor_t));
-        if (!atoms || !result) {
+        if (!atoms || !name_sequences || !result) {
             free(atoms);
+            free(name_sequences);
             free(result);
+            // Consume the monitor infos of the reply
+            if (!x11_skip(conn->fd, (size_t)reply.reply_length * 4))
+                conn->io_error = true;
             return false;
         }
 
@@ -1185,6 +1460,7 @@ bool x11_randr_get_monitors(x11_connection_t* conn, x11_monitor_t** monitors, in
             x11_randr_monitor_info_t info;
             if (!x11_read_all(conn->fd, &info, sizeof(info))) {
                 free(atoms);
+                free(name_sequences);
                 free(result);
                 return false;
             }
@@ -1201,6 +1477,7 @@ bool x11_randr_get_monitors(x11_connection_t* conn, x11_monitor_t** monitors, in
             result[i].name[0] = '\0';
             if (!x11_skip(conn->fd, info.n_output * 4)) {
                 free(atoms);
+                free(name_sequences);
                 free(result);
                 return false;
             }
@@ -1212,16 +1489,13 @@ bool x11_randr_get_monitors(x11_connection_t* conn, x11_monitor_t** monitors, in
                 .length = sizeof(name_req) / 4,
                 .atom = atoms[i],
             };
-            if (!x11_write_all(conn->fd, &name_req, sizeof(name_req))) {
-                free(atoms);
-                free(result);
-                return false;
-            }
+            name_sequences[i] = x11_send(conn, &name_req, sizeof(name_req), NULL, 0);
         }
+        free(atoms);
         for (uint32_t i = 0; i < n; i++) {
             x11_get_atom_name_reply_t name_reply;
-            if (!x11_read_all(conn->fd, &name_reply, sizeof(name_reply)) || name_reply.reply != 1) {
-                free(atoms);
+            if (!x11_read_reply(conn, name_sequences[i], &name_reply, sizeof(name_reply)) || name_reply.reply != 1) {
+                free(name_sequences);
                 free(result);
                 return false;
             }
@@ -1231,12 +1505,12 @@ bool x11_randr_get_monitors(x11_connection_t* conn, x11_monitor_t** monitors, in
                 char name_buf[256];
                 size_t read_len = padded < sizeof(name_buf) ? padded : sizeof(name_buf) - 1;
                 if (!x11_read_all(conn->fd, name_buf, read_len)) {
-                    free(atoms);
+                    free(name_sequences);
                     free(result);
                     return false;
                 }
                 if (padded > read_len && !x11_skip(conn->fd, padded - read_len)) {
-                    free(atoms);
+                    free(name_sequences);
                     free(result);
                     return false;
                 }
@@ -1246,7 +1520,7 @@ bool x11_randr_get_monitors(x11_connection_t* conn, x11_monitor_t** monitors, in
             }
         }
 
-        free(atoms);
+        free(name_sequences);
         *monitors = result;
         *count = (int32_t)n;
         return true;
@@ -1265,11 +1539,9 @@ bool x11_randr_get_monitors(x11_connection_t* conn, x11_monitor_t** monitors, in
             .length = sizeof(sreq) / 4,
             .window = conn->screen.root,
         };
-        if (!x11_write_all(conn->fd, &sreq, sizeof(sreq)))
-            return false;
-
+        uint64_t sequence = x11_send(conn, &sreq, sizeof(sreq), NULL, 0);
         x11_randr_get_screen_resources_reply_t sreply;
-        if (!x11_read_all(conn->fd, &sreply, sizeof(sreply)) || sreply.reply != 1)
+        if (!x11_read_reply(conn, sequence, &sreply, sizeof(sreply)) || sreply.reply != 1)
             return false;
 
         uint16_t ncrtcs = sreply.ncrtcs;
@@ -1303,6 +1575,11 @@ bool x11_randr_get_monitors(x11_connection_t* conn, x11_monitor_t** monitors, in
         }
 
         // Pipeline all RRGetCrtcInfo requests
+        uint64_t* crtc_sequences = malloc(ncrtcs * sizeof(uint64_t));
+        if (!crtc_sequences) {
+            free(crtcs);
+            return false;
+        }
         for (uint16_t i = 0; i < ncrtcs; i++) {
             x11_randr_get_crtc_info_request_t creq = {
                 .major_opcode = conn->randr_opcode,
@@ -1311,27 +1588,29 @@ bool x11_randr_get_monitors(x11_connection_t* conn, x11_monitor_t** monitors, in
                 .crtc = crtcs[i],
                 .config_timestamp = config_ts,
             };
-            if (!x11_write_all(conn->fd, &creq, sizeof(creq))) {
-                free(crtcs);
-                return false;
-            }
+            crtc_sequences[i] = x11_send(conn, &creq, sizeof(creq), NULL, 0);
         }
         free(crtcs);
 
-        // Read all RRGetCrtcInfo replies, collecting active CRTCs
+        // Read all RRGetCrtcInfo replies, collecting active CRTCs. Replies of CRTCs that are
+        // not read after a failure are skipped by the next reply read.
         x11_monitor_t* result = malloc(ncrtcs * sizeof(x11_monitor_t));
-        if (!result)
+        if (!result) {
+            free(crtc_sequences);
             return false;
+        }
 
         int32_t active = 0;
         for (uint16_t i = 0; i < ncrtcs; i++) {
             x11_randr_get_crtc_info_reply_t creply;
-            if (!x11_read_all(conn->fd, &creply, sizeof(creply)) || creply.reply != 1) {
+            if (!x11_read_reply(conn, crtc_sequences[i], &creply, sizeof(creply)) || creply.reply != 1) {
+                free(crtc_sequences);
                 free(result);
                 return false;
             }
             // Skip variable-length output lists
             if (!x11_skip(conn->fd, (creply.noutputs + creply.npossible) * 4)) {
+                free(crtc_sequences);
                 free(result);
                 return false;
             }
@@ -1368,6 +1647,7 @@ bool x11_randr_get_monitors(x11_connection_t* conn, x11_monitor_t** monitors, in
         if (!found_primary && active > 0)
             result[0].primary = true;
 
+        free(crtc_sequences);
         *monitors = result;
         *count = active;
         return true;
@@ -1388,31 +1668,60 @@ void x11_randr_select_input(x11_connection_t* conn, uint32_t window) {
         .window = window,
         .enable = X11_RANDR_SCREEN_CHANGE_NOTIFY_MASK,
     };
-    x11_write_all(conn->fd, &req, sizeof(req));
+    x11_send(conn, &req, sizeof(req), NULL, 0);
 }
 
 bool x11_wait_for_event(x11_connection_t* conn, x11_event_t* event) {
-    uint8_t buf[32];
-    if (!x11_read_all(conn->fd, buf, 32))
+    // Requests are flushed before every event, so replies to events like sync acks go out right away
+    uint8_t buf[X11_MAX_EVENT_SIZE];
+    if (!x11_flush(conn))
         return false;
+    if (conn->event_head < conn->event_count) {
+        memcpy(buf, conn->events[conn->event_head++], X11_MAX_EVENT_SIZE);
+        if (conn->event_head == conn->event_count) {
+            conn->event_head = 0;
+            conn->event_count = 0;
+        }
+    } else {
+        // Replies of requests nobody waits for are skipped
+        do {
+            if (!x11_read_packet(conn, buf))
+                return false;
+            if (buf[0] == X11_REPLY) {
+                uint32_t extra;
+                memcpy(&extra, &buf[4], 4);
+                if (!x11_skip(conn->fd, (size_t)extra * 4)) {
+                    conn->io_error = true;
+                    return false;
+                }
+            }
+        } while (buf[0] == X11_REPLY);
+    }
     uint8_t raw_type = buf[0];
     event->type = raw_type & ~0x80;
+    event->expose_x = 0;
+    event->expose_y = 0;
+    event->expose_width = 0;
+    event->expose_height = 0;
     event->expose_count = 0;
     event->configure_is_synthetic = false;
     event->configure_x = 0;
     event->configure_y = 0;
     event->configure_width = 0;
     event->configure_height = 0;
+    event->present_serial = 0;
+    event->present_msc = 0;
+    event->shm_completion_shmseg = 0;
 
-    if (event->type == X11_ERROR) {
-        uint8_t error_code = buf[1];
-        uint16_t seq;
-        memcpy(&seq, &buf[2], 2);
-        fprintf(stderr, "X11 error: code=%d sequence=%d\n", error_code, seq);
+    // Errors are reported by x11_read_packet when they arrive
+    if (event->type == X11_ERROR)
         return true;
-    }
 
     if (event->type == X11_EXPOSE) {
+        memcpy(&event->expose_x, &buf[8], 2);
+        memcpy(&event->expose_y, &buf[10], 2);
+        memcpy(&event->expose_width, &buf[12], 2);
+        memcpy(&event->expose_height, &buf[14], 2);
         memcpy(&event->expose_count, &buf[16], 2);
     }
 
@@ -1440,6 +1749,21 @@ bool x11_wait_for_event(x11_connection_t* conn, x11_event_t* event) {
         }
     }
 
+    if (event->type == X11_GENERIC_EVENT && conn->has_present && buf[1] == conn->present_opcode) {
+        uint16_t evtype;
+        memcpy(&evtype, &buf[8], 2);
+        if (evtype == X11_PRESENT_COMPLETE_NOTIFY_EVENT) {
+            memcpy(&event->present_serial, &buf[20], 4);
+            memcpy(&event->present_msc, &buf[32], 8);
+            event->type = X11_PRESENT_COMPLETE_NOTIFY;
+        }
+    }
+
+    if (conn->shm_first_event != 0 && event->type == conn->shm_first_event + X11_SHM_COMPLETION_EVENT) {
+        memcpy(&event->shm_completion_shmseg, &buf[12], 4);
+        event->type = X11_SHM_COMPLETION;
+    }
+
     // Translate RRScreenChangeNotify into the synthetic type
     if (conn->has_randr && conn->randr_first_event != 0 && event->type == conn->randr_first_event) {
         event->type = X11_RANDR_SCREEN_CHANGE_NOTIFY;
@@ -1448,7 +1772,23 @@ bool x11_wait_for_event(x11_connection_t* conn, x11_event_t* event) {
     return true;
 }
 
+int32_t x11_poll_event(x11_connection_t* conn, x11_event_t* event, int32_t timeout_ms) {
+    if (!x11_flush(conn))
+        return -1;
+    if (conn->event_head == conn->event_count) {
+        struct pollfd pfd = {.fd = conn->fd, .events = POLLIN};
+        int result = poll(&pfd, 1, timeout_ms);
+        if (result < 0)
+            return errno == EINTR ? 0 : -1;
+        if (result == 0)
+            return 0;
+    }
+    return x11_wait_for_event(conn, event) ? 1 : -1;
+}
+
 bool x11_has_event_pending(x11_connection_t* conn) {
+    if (conn->event_head < conn->event_count)
+        return true;
     struct pollfd pfd = {.fd = conn->fd, .events = POLLIN};
     return poll(&pfd, 1, 0) > 0;
 }
@@ -1462,7 +1802,7 @@ uint32_t x11_sync_create_counter(x11_connection_t* conn) {
         .id = id,
         .initial_value = {.high = 0, .low = 0},
     };
-    x11_write_all(conn->fd, &req, sizeof(req));
+    x11_send(conn, &req, sizeof(req), NULL, 0);
     return id;
 }
 
@@ -1474,7 +1814,7 @@ void x11_sync_set_counter(x11_connection_t* conn, uint32_t counter, int32_t lo,
         .counter = counter,
         .value = {.high = hi, .low = (uint32_t)lo},
     };
-    x11_write_all(conn->fd, &req, sizeof(req));
+    x11_send(conn, &req, sizeof(req), NULL, 0);
 }
 
 void x11_sync_destroy_counter(x11_connection_t* conn, uint32_t counter) {
@@ -1484,7 +1824,7 @@ void x11_sync_destroy_counter(x11_connection_t* conn, uint32_t counter) {
         .length = sizeof(req) / 4,
         .counter = counter,
     };
-    x11_write_all(conn->fd, &req, sizeof(req));
+    x11_send(conn, &req, sizeof(req), NULL, 0);
 }
 
 uint32_t x11_xdbe_alloc_back_buffer(x11_connection_t* conn, uint32_t window) {
@@ -1495,13 +1835,12 @@ uint32_t x11_xdbe_alloc_back_buffer(x11_connection_t* conn, uint32_t window) {
         .length = sizeof(req) / 4,
         .window = window,
         .buffer = buffer,
-        .swap_action = X11_XDBE_SWAP_ACTION_UNDEFINED,
+        .swap_action = X11_XDBE_SWAP_ACTION_COPIED,
     };
-    if (!x11_write_all(conn->fd, &req, sizeof(req)))
-        return 0;
     // Verify the server accepted the alloc (XQuartz may return BadAlloc here).
     // On failure return 0 so the caller falls back to direct window rendering.
-    if (!x11_sync_check_error(conn->fd))
+    conn->checked_sequence = x11_send(conn, &req, sizeof(req), NULL, 0);
+    if (!x11_sync(conn) || conn->error_sequence == conn->checked_sequence)
         return 0;
     return buffer;
 }
@@ -1512,9 +1851,9 @@ void x11_xdbe_swap_buffers(x11_connection_t* conn, uint32_t window) {
         .minor_opcode = X11_XDBE_SWAP_BUFFERS,
         .length = sizeof(req) / 4,
         .n_windows = 1,
-        .info = {.window = window, .swap_action = X11_XDBE_SWAP_ACTION_UNDEFINED},
+        .info = {.window = window, .swap_action = X11_XDBE_SWAP_ACTION_COPIED},
     };
-    x11_write_all(conn->fd, &req, sizeof(req));
+    x11_send(conn, &req, sizeof(req), NULL, 0);
 }
 
 void x11_xdbe_free_back_buffer(x11_connection_t* conn, uint32_t buffer) {
@@ -1524,10 +1863,68 @@ void x11_xdbe_free_back_buffer(x11_connection_t* conn, uint32_t buffer) {
         .length = sizeof(req) / 4,
         .buffer = buffer,
     };
-    x11_write_all(conn->fd, &req, sizeof(req));
+    x11_send(conn, &req, sizeof(req), NULL, 0);
+}
+
+uint32_t x11_create_pixmap(x11_connection_t* conn, uint32_t drawable, int32_t width, int32_t height) {
+    uint32_t pixmap = x11_generate_id(conn);
+    x11_create_pixmap_request_t req = {
+        .major_opcode = X11_CREATE_PIXMAP,
+        .depth = conn->screen.root_depth,
+        .length = sizeof(req) / 4,
+        .pid = pixmap,
+        .drawable = drawable,
+        .width = (uint16_t)width,
+        .height = (uint16_t)height,
+    };
+    x11_send(conn, &req, sizeof(req), NULL, 0);
+    return pixmap;
+}
+
+void x11_free_pixmap(x11_connection_t* conn, uint32_t pixmap) {
+    x11_free_pixmap_request_t req = {
+        .major_opcode = X11_FREE_PIXMAP,
+        .length = sizeof(req) / 4,
+        .pixmap = pixmap,
+    };
+    x11_send(conn, &req, sizeof(req), NULL, 0);
+}
+
+void x11_present_select_input(x11_connection_t* conn, uint32_t window) {
+    x11_present_select_input_request_t req = {
+        .major_opcode = conn->present_opcode,
+        .minor_opcode = X11_PRESENT_SELECT_INPUT,
+        .length = sizeof(req) / 4,
+        .eid = x11_generate_id(conn),
+        .window = window,
+        .event_mask = X11_PRESENT_COMPLETE_NOTIFY_MASK,
+    };
+    x11_send(conn, &req, sizeof(req), NULL, 0);
+}
+
+void x11_present_pixmap(x11_connection_t* conn, uint32_t window, uint32_t pixmap, uint32_t serial) {
+    // Copy instead of flipping, so the pixmap is free again once the presentation completed.
+    // A target msc of 0 without divisor presents at the next vblank.
+    x11_present_pixmap_request_t req = {
+        .major_opcode = conn->present_opcode,
+        .minor_opcode = X11_PRESENT_PIXMAP,
+        .length = sizeof(req) / 4,
+        .window = window,
+        .pixmap = pixmap,
+        .serial = serial,
+        .options = X11_PRESENT_OPTION_COPY,
+    };
+    x11_send(conn, &req, sizeof(req), NULL, 0);
 }
 
 void x11_disconnect(x11_connection_t* conn) {
+    x11_flush(conn);
+    // The server detaches the segments of pending attaches when the connection closes
+    for (int32_t i = 0; i < conn->shm_attach_count; i++)
+        shmctl(conn->shm_attaches[i].shmid, IPC_RMID, NULL);
+    conn->shm_attach_count = 0;
     close(conn->fd);
     conn->fd = -1;
+    free(conn->events);
+    conn->events = NULL;
 }
@@ -34,6 +34,8 @@
 #define X11_GET_ATOM_NAME 17
 #define X11_CHANGE_PROPERTY 18
 #define X11_GET_PROPERTY 20
+#define X11_CREATE_PIXMAP 53
+#define X11_FREE_PIXMAP 54
 #define X11_FREE_GC 60
 #define X11_CREATE_GC 55
 #define X11_PUT_IMAGE 72
@@ -59,20 +61,39 @@
 #define X11_XDBE_DEALLOCATE_BACK_BUFFER 2
 #define X11_XDBE_SWAP_BUFFERS 3
 #define X11_XDBE_SWAP_ACTION_UNDEFINED 0
+#define X11_XDBE_SWAP_ACTION_COPIED 3
+
+// Present minor opcodes, event types, event masks and options
+#define X11_PRESENT_QUERY_VERSION 0
+#define X11_PRESENT_PIXMAP 1
+#define X11_PRESENT_SELECT_INPUT 3
+#define X11_PRESENT_COMPLETE_NOTIFY_EVENT 1
+#define X11_PRESENT_COMPLETE_NOTIFY_MASK 2
+#define X11_PRESENT_OPTION_COPY 2
 
 // RANDR event-mask bits (used with RRSelectInput)
 #define X11_RANDR_SCREEN_CHANGE_NOTIFY_MASK 1
 
 // Event types
 #define X11_ERROR 0
+#define X11_REPLY 1
+#define X11_KEYMAP_NOTIFY 11  // the only event without a sequence number
 #define X11_EXPOSE 12
 #define X11_CONFIGURE_NOTIFY 22
 #define X11_CLIENT_MESSAGE 33
+#define X11_GENERIC_EVENT 35  // extension events, can be longer than 32 bytes
 #define X11_CLIENT_MESSAGE_CLOSE 255
 // Synthetic event for _NET_WM_SYNC_REQUEST ClientMessage
 #define X11_CLIENT_MESSAGE_SYNC_REQUEST 253
 // Synthetic event emitted by x11_wait_for_event when an RRScreenChangeNotify arrives
 #define X11_RANDR_SCREEN_CHANGE_NOTIFY 254
+// Synthetic event emitted by x11_wait_for_event when a PresentCompleteNotify arrives
+#define X11_PRESENT_COMPLETE_NOTIFY 252
+// Synthetic event emitted by x11_wait_for_event when a ShmCompletion arrives
+#define X11_SHM_COMPLETION 251
+
+// Longest event that is kept, the rest of longer generic events is skipped
+#define X11_MAX_EVENT_SIZE 64
 
 // GC value masks
 #define X11_GC_GRAPHICS_EXPOSURES 65536
@@ -89,10 +110,23 @@
 // PutImage format
 #define X11_IMAGE_FORMAT_Z_PIXMAP 2
 
-// MIT-SHM sub-opcodes
+// Most rows one PutImage chunk of a region narrower than the image sends, one iovec each
+#define X11_PUT_IMAGE_MAX_ROW_IOVS 64
+
+// Requests are collected in this buffer and written with one syscall on flush
+#define X11_OUTPUT_BUFFER_SIZE 16384
+
+// Most MIT-SHM attaches that wait for the server before their segments are marked for removal
+#define X11_MAX_PENDING_SHM_ATTACHES 4
+
+// MIT-SHM sub-opcodes and events
 #define X11_SHM_ATTACH 1
 #define X11_SHM_DETACH 2
 #define X11_SHM_PUT_IMAGE 3
+#define X11_SHM_COMPLETION_EVENT 0
+
+// Most images of a swapchain, a third image lets a frame be drawn while two are still uploading
+#define X11_SWAPCHAIN_MAX_IMAGES 3
 
 // Property constants
 #define X11_PROP_MODE_REPLACE 0
@@ -281,6 +315,23 @@ typedef struct X11_PACKED x11_create_gc_request_t {
     uint32_t value_mask;
 } x11_create_gc_request_t;
 
+typedef struct X11_PACKED x11_create_pixmap_request_t {
+    uint8_t major_opcode;
+    uint8_t depth;
+    uint16_t length;
+    uint32_t pid;
+    uint32_t drawable;
+    uint16_t width;
+    uint16_t height;
+} x11_create_pixmap_request_t;
+
+typedef struct X11_PACKED x11_free_pixmap_request_t {
+    uint8_t major_opcode;
+    uint8_t pad0;
+    uint16_t length;
+    uint32_t pixmap;
+} x11_free_pixmap_request_t;
+
 typedef struct X11_PACKED x11_free_gc_request_t {
     uint8_t major_opcode;
     uint8_t pad0;
@@ -633,7 +684,62 @@ typedef struct X11_PACKED x11_xdbe_swap_buffers_request_t {
     x11_xdbe_swap_info_t info;
 } x11_xdbe_swap_buffers_request_t;
 
+typedef struct X11_PACKED x11_present_query_version_request_t {
+    uint8_t major_opcode;
+    uint8_t minor_opcode;
+    uint16_t length;
+    uint32_t major_version;
+    uint32_t minor_version;
+} x11_present_query_version_request_t;
+
+typedef struct X11_PACKED x11_present_query_version_reply_t {
+    uint8_t reply;
+    uint8_t pad0;
+    uint16_t sequence_number;
+    uint32_t reply_length;
+    uint32_t major_version;
+    uint32_t minor_version;
+    uint8_t pad1[16];
+} x11_present_query_version_reply_t;
+
+typedef struct X11_PACKED x11_present_select_input_request_t {
+    uint8_t major_opcode;
+    uint8_t minor_opcode;
+    uint16_t length;
+    uint32_t eid;
+    uint32_t window;
+    uint32_t event_mask;
+} x11_present_select_input_request_t;
+
+typedef struct X11_PACKED x11_present_pixmap_request_t {
+    uint8_t major_opcode;
+    uint8_t minor_opcode;
+    uint16_t length;
+    uint32_t window;
+    uint32_t pixmap;
+    uint32_t serial;
+    uint32_t valid;   // region, 0 = whole pixmap
+    uint32_t update;  // region, 0 = whole pixmap
+    int16_t x_off;
+    int16_t y_off;
+    uint32_t target_crtc;
+    uint32_t wait_fence;
+    uint32_t idle_fence;
+    uint32_t options;
+    uint32_t pad0;
+    uint64_t target_msc;
+    uint64_t divisor;
+    uint64_t remainder;
+} x11_present_pixmap_request_t;
+
 // X11 structs
+
+// A MIT-SHM attach the server hasn't processed yet, its segment can only be removed after that
+typedef struct x11_shm_attach_t {
+    uint64_t sequence;
+    int32_t shmid;
+} x11_shm_attach_t;
+
 typedef struct x11_connection_t {
     int32_t fd;
     uint32_t id;
@@ -665,11 +771,38 @@ typedef struct x11_connection_t {
     uint8_t sync_opcode;
     bool has_xdbe;
     uint8_t xdbe_opcode;
+    bool has_present;
+    uint8_t present_opcode;
+
+    // Output buffer, flushed when a reply is needed, when it is full or by x11_flush
+    uint8_t out_buf[X11_OUTPUT_BUFFER_SIZE];
+    size_t out_len;
+    bool io_error;  // a write or read failed, the connection is unusable
+
+    // Sequence numbers widened to 64 bits: of the last request sent, of the last request the server
+    // processed, of the last request that failed and of the request whose error the caller checks itself
+    uint64_t sequence;
+    uint64_t processed_sequence;
+    uint64_t error_sequence;
+    uint64_t checked_sequence;
+
+    // Events that arrived while waiting for a reply, returned before reading the socket again
+    uint8_t (*events)[X11_MAX_EVENT_SIZE];
+    size_t event_head;
+    size_t event_count;
+    size_t event_capacity;
+
+    x11_shm_attach_t shm_attaches[X11_MAX_PENDING_SHM_ATTACHES];
+    int32_t shm_attach_count;
 } x11_connection_t;
 
 typedef struct x11_event_t {
     uint8_t type;
     bool configure_is_synthetic;  // true if x/y are root-relative (WM sent via SendEvent)
+    uint16_t expose_x;  // exposed rect in window pixels
+    uint16_t expose_y;
+    uint16_t expose_width;
+    uint16_t expose_height;
     uint16_t expose_count;
     int16_t configure_x;
     int16_t configure_y;
@@ -677,6 +810,9 @@ typedef struct x11_event_t {
     uint16_t configure_height;
     int32_t sync_value_lo;  // _NET_WM_SYNC_REQUEST counter value (low 32 bits)
     int32_t sync_value_hi;  // _NET_WM_SYNC_REQUEST counter value (high 32 bits)
+    uint32_t present_serial;  // serial passed to x11_present_pixmap
+    uint64_t present_msc;     // vblank counter of the presentation
+    uint32_t shm_completion_shmseg;  // segment the server finished reading
 } x11_event_t;
 
 // Image backed by a pixel buffer (MIT-SHM or heap)
@@ -690,6 +826,19 @@ typedef struct x11_image_t {
     int32_t capacity;  // allocated pixel count; reuse when new_w*new_h <= capacity
 } x11_image_t;
 
+// Images that frames are drawn into in turn, so a frame never overwrites pixels the server still reads.
+// ShmPutImage requests of a swapchain ask for a ShmCompletion, an image is free again once the server
+// processed its last upload. Without MIT-SHM uploads copy the pixels and one image is enough.
+typedef struct x11_swapchain_t {
+    uint32_t window;
+    x11_image_t images[X11_SWAPCHAIN_MAX_IMAGES];
+    uint64_t put_sequences[X11_SWAPCHAIN_MAX_IMAGES];  // last ShmPutImage of every image, 0 if none
+    int32_t image_count;  // images allocated so far, more are added when all are in flight
+    int32_t current;      // image of the last acquired frame
+    int32_t width;
+    int32_t height;
+} x11_swapchain_t;
+
 typedef struct x11_monitor_t {
     int16_t x;
     int16_t y;
@@ -733,14 +882,50 @@ bool x11_resize_image(x11_connection_t* conn, x11_image_t* img, int32_t new_w, i
 // Blit the full image to the window at (0, 0) using ShmPutImage or PutImage
 void x11_put_image(x11_connection_t* conn, uint32_t window, x11_image_t* img);
 
+// Blit a rect of the image to the same rect of the window, the rect is clipped to the image
+void x11_put_image_region(x11_connection_t* conn, uint32_t window, x11_image_t* img, int32_t x, int32_t y,
+                          int32_t width, int32_t height);
+
 // Free image resources (SHM or heap)
 void x11_destroy_image(x11_connection_t* conn, x11_image_t* img);
 
+// Create a swapchain with its first image, up to X11_SWAPCHAIN_MAX_IMAGES are allocated when needed
+bool x11_swapchain_create(x11_connection_t* conn, x11_swapchain_t* swapchain, uint32_t window, int32_t width,
+                          int32_t height);
+
+// Set the size of the next acquired images. Images still in flight are resized when they are acquired
+// again, new segments are attached without waiting for the server.
+void x11_swapchain_resize(x11_swapchain_t* swapchain, int32_t width, int32_t height);
+
+// Return a free image for the next frame. That is the image of the last frame when the server is done with it,
+// then only the changes need to be drawn, another image holds an older frame and must be drawn completely.
+// Waits for a ShmCompletion only when every image is in flight, returns NULL on failure.
+x11_image_t* x11_swapchain_acquire(x11_connection_t* conn, x11_swapchain_t* swapchain);
+
+// Blit a rect of the last acquired image to the same rect of the drawable, like x11_put_image_region
+void x11_swapchain_put_region(x11_connection_t* conn, x11_swapchain_t* swapchain, uint32_t drawable, int32_t x,
+                              int32_t y, int32_t width, int32_t height);
+
+void x11_swapchain_destroy(x11_connection_t* conn, x11_swapchain_t* swapchain);
+
+// Write the buffered requests to the socket, returns false when the connection failed
+bool x11_flush(x11_connection_t* conn);
+
+// Flush the buffered requests and wait until the server processed all of them, returns false when the
+// connection failed
+bool x11_sync(x11_connection_t* conn);
+
+// Flush the buffered requests and wait for the next event, errors of requests are reported as X11_ERROR events
 bool x11_wait_for_event(x11_connection_t* conn, x11_event_t* event);
 
-// Returns true if at least one event is waiting in the socket buffer (non-blocking).
+// Returns true if at least one event is queued or waiting in the socket buffer (non-blocking).
 bool x11_has_event_pending(x11_connection_t* conn);
 
+// Flush and wait at most timeout_ms for an event, -1 waits forever and 0 doesn't wait.
+// Returns 1 with an event, 0 on timeout and -1 when the connection failed. To wait in an own
+// poll or epoll loop add conn->fd, but call this with timeout 0 first, events can be queued.
+int32_t x11_poll_event(x11_connection_t* conn, x11_event_t* event, int32_t timeout_ms);
+
 // Enumerate monitors via RANDR; returns heap-allocated array of count entries.
 // Returns false if RANDR is unavailable. Free with x11_randr_free_monitors().
 bool x11_randr_get_monitors(x11_connection_t* conn, x11_monitor_t** monitors, int32_t* count);
@@ -771,4 +956,16 @@ void x11_xdbe_swap_buffers(x11_connection_t* conn, uint32_t window);
 // Free an XDBE back buffer allocated with x11_xdbe_alloc_back_buffer.
 void x11_xdbe_free_back_buffer(x11_connection_t* conn, uint32_t buffer);
 
+// Create a pixmap with the depth of the root window, free it with x11_free_pixmap.
+uint32_t x11_create_pixmap(x11_connection_t* conn, uint32_t drawable, int32_t width, int32_t height);
+
+void x11_free_pixmap(x11_connection_t* conn, uint32_t pixmap);
+
+// Subscribe to PresentCompleteNotify events for the window. Only call when conn->has_present is true.
+void x11_present_select_input(x11_connection_t* conn, uint32_t window);
+
+// Copy the pixmap to the window at the next vblank, a X11_PRESENT_COMPLETE_NOTIFY event with the
+// serial follows when it was shown. The pixmap can be drawn into again after that event.
+void x11_present_pixmap(x11_connection_t* conn, uint32_t window, uint32_t pixmap, uint32_t serial);
+
 void x11_disconnect(x11_connection_t* conn);
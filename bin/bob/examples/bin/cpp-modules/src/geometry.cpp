@@ -0,0 +1,5 @@
+export module geometry;
+
+export import :shapes;
+
+export int area(Rect rect);
@@ -0,0 +1,3 @@
+module geometry;
+
+int area(Rect rect) { return rect.width * rect.height; }
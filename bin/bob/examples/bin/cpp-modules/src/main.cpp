@@ -0,0 +1,10 @@
+#include <cstdio>
+#include <cstdlib>
+
+import geometry;
+
+int main(void) {
+    Rect rect = {3, 4};
+    printf("Hello modules, area %d!\n", area(rect));
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,6 @@
+export module geometry:shapes;
+
+export struct Rect {
+    int width;
+    int height;
+};
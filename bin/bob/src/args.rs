@@ -8,8 +8,11 @@ use std::env;
 use std::fmt::{self, Display, Formatter};
 use std::process::exit;
 
+use crate::utils::cache_dir;
+
 #[derive(Clone, Copy, PartialEq, Eq)]
 pub(crate) enum Subcommand {
+    Bench,
     Build,
     Clean,
     CleanCache,
@@ -17,6 +20,7 @@ pub(crate) enum Subcommand {
     Run,
     Test,
     Version,
+    Worker,
 }
 
 #[derive(Clone, Copy, PartialEq, Eq)]
@@ -24,6 +28,7 @@ pub(crate) enum Profile {
     Debug,
     Release,
     Test,
+    Bench,
 }
 
 impl Display for Profile {
@@ -32,20 +37,47 @@ impl Display for Profile {
             Profile::Debug => write!(f, "debug"),
             Profile::Release => write!(f, "release"),
             Profile::Test => write!(f, "test"),
+            Profile::Bench => write!(f, "bench"),
         }
     }
 }
 
+/// Profile guided optimization step, each step builds into its own out directory.
+#[derive(Clone, Copy, PartialEq, Eq)]
+pub(crate) enum Pgo {
+    Generate,
+    Use,
+}
+
+impl Display for Pgo {
+    fn fmt(&self, f: &mut Formatter) -> fmt::Result {
+        match self {
+            Pgo::Generate => write!(f, "pgo-generate"),
+            Pgo::Use => write!(f, "pgo-use"),
+        }
+    }
+}
+
+#[derive(Clone)]
 pub(crate) struct Args {
     pub subcommand: Subcommand,
     pub manifest_dir: String,
     pub target_dir: String,
     pub profile: Profile,
     pub target: Option<String>,
+    pub targets: Vec<String>,
     pub verbose: bool,
     pub thread_count: Option<usize>,
     pub clean_first: bool,
     pub show_time: bool,
+    pub object_cache_dir: Option<String>,
+    pub pgo: Option<Pgo>,
+    pub timings: bool,
+    pub remote_workers: Vec<String>,
+    pub listen: Option<String>,
+    pub save_baseline: bool,
+    pub test_filter: Option<String>,
+    pub watch: bool,
 }
 
 impl Default for Args {
@@ -56,10 +88,19 @@ impl Default for Args {
             target_dir: "target".to_string(),
             profile: Profile::Debug,
             target: None,
+            targets: Vec::new(),
             verbose: false,
             thread_count: None,
             clean_first: false,
             show_time: false,
+            object_cache_dir: None,
+            pgo: None,
+            timings: false,
+            remote_workers: Vec::new(),
+            listen: None,
+            save_baseline: false,
+            test_filter: None,
+            watch: false,
         }
     }
 }
@@ -91,16 +132,30 @@ pub(crate) fn parse_args() -> Args {
                 args.profile = Profile::Test;
                 args.clean_first = true;
             }
+            "bench" => {
+                args.subcommand = Subcommand::Bench;
+                args.profile = Profile::Bench;
+            }
             "version" | "--version" => args.subcommand = Subcommand::Version,
+            "worker" => args.subcommand = Subcommand::Worker,
+            "watch" => {
+                args.watch = true;
+                if args.subcommand == Subcommand::Help {
+                    args.subcommand = Subcommand::Build;
+                }
+            }
             "-C" | "--manifest-dir" => {
                 args.manifest_dir = args_iter.next().expect("Invalid argument")
             }
             "-t" | "--time" => args.show_time = true,
+            "--timings" => args.timings = true,
             "-T" | "--target-dir" => {
                 args.target_dir = args_iter.next().expect("Invalid argument");
             }
             "--target" => {
-                args.target = Some(args_iter.next().expect("Invalid argument"));
+                let target = args_iter.next().expect("Invalid argument");
+                args.target = Some(target.clone());
+                args.targets.push(target);
             }
             "-r" | "--release" => args.profile = Profile::Release,
             "-v" | "--verbose" => args.verbose = true,
@@ -108,6 +163,33 @@ pub(crate) fn parse_args() -> Args {
             "-j" | "--jobs" | "--thread-count" => {
                 args.thread_count = args_iter.next().and_then(|s| s.parse::<usize>().ok());
             }
+            "--object-cache" => {
+                args.object_cache_dir = Some(format!("{}/object-cache", cache_dir().display()));
+            }
+            "--object-cache-dir" => {
+                // Resolve now, bob changes directory to the manifest before building
+                let dir = args_iter.next().expect("Invalid argument");
+                args.object_cache_dir = Some(
+                    env::current_dir()
+                        .expect("Can't get current directory")
+                        .join(dir)
+                        .display()
+                        .to_string(),
+                );
+            }
+            "--pgo-generate" => args.pgo = Some(Pgo::Generate),
+            "--pgo-use" => args.pgo = Some(Pgo::Use),
+            "--remote" => {
+                args.remote_workers
+                    .push(args_iter.next().expect("Invalid argument"));
+            }
+            "--listen" => {
+                args.listen = Some(args_iter.next().expect("Invalid argument"));
+            }
+            "--save-baseline" => args.save_baseline = true,
+            "--filter" => {
+                args.test_filter = Some(args_iter.next().expect("Invalid argument"));
+            }
             _ => {
                 eprintln!("Unknown argument: {arg}");
                 exit(1);
@@ -126,10 +208,19 @@ Options:
   -T <dir>, --target-dir                Write artifacts to directory <dir>
   -r, --release                         Build artifacts in release mode
   -t, --time                            Show time taken for the build
+  --timings                             Write a trace of the build tasks and show the critical path
   -v, --verbose                         Print verbose output
-  --target <target>                     Build for the specified target (e.g., x86_64-unknown-linux-gnu)
+  --target <target>                     Build for the specified target (e.g., x86_64-unknown-linux-gnu), can be repeated
   -1, --single-threaded                 Run tasks single threaded
-  -j, --jobs, --thread-count <count>    Use <count> threads for building (default: number of available cores)"
+  -j, --jobs, --thread-count <count>    Use <count> threads for building (default: number of available cores)
+  --object-cache                        Reuse C/C++ objects from the global bob cache
+  --object-cache-dir <dir>              Reuse C/C++ objects from directory <dir>, which can be shared
+  --pgo-generate                        Build C/C++ artifacts instrumented to collect profiles when run
+  --pgo-use                             Build C/C++ artifacts optimized with the collected profiles
+  --remote <host[:port]>                Compile C/C++ sources on a bob worker, can be repeated
+  --listen <addr[:port]>                Listen on <addr> as bob worker (default: 0.0.0.0:7070)
+  --filter <text>                       Only run the C/C++ unit tests whose name contains <text>
+  --save-baseline                       Save the benchmark results as baseline for later bench runs"
     );
 
     println!(
@@ -144,6 +235,9 @@ Subcommands:
   rerun                                 Clean, build and run the build artifact
   test                                  Build and run the unit tests
   retest                                Clean, build and run the unit tests
-  version                               Print the version number"
+  bench                                 Build and run the benchmarks in release mode
+  version                               Print the version number
+  watch [run|test|bench]                Rebuild when a source file changes and run the subcommand after every build
+  worker                                Run a daemon compiling C/C++ sources for --remote builds"
     );
 }
@@ -7,10 +7,11 @@
 use std::collections::HashMap;
 use std::fs;
 use std::process::exit;
+use std::sync::OnceLock;
 
-use crate::args::{Args, Profile};
+use crate::args::{Args, Pgo, Profile};
 use crate::executor::ExecutorBuilder;
-use crate::manifest::{Dependency, JarDependency, LibraryType, Manifest};
+use crate::manifest::{Dependency, JarDependency, LibraryType, Manifest, ProfileConfig};
 use crate::tasks::android::{
     detect_android, generate_android_dex_tasks, generate_android_final_apk_tasks,
     generate_android_res_tasks, link_android_classpath,
@@ -18,9 +19,11 @@ use crate::tasks::android::{
 #[cfg(target_os = "macos")]
 use crate::tasks::bundle::{bundle_is_lipo, detect_bundle, generate_bundle_tasks};
 use crate::tasks::cx::{
-    copy_cx_headers, detect_asm, detect_c, detect_cpp, detect_cx, detect_objc, detect_objcpp,
-    generate_asm_tasks, generate_c_tasks, generate_cpp_tasks, generate_cx_test_main,
-    generate_ld_cunit_tests, generate_ld_tasks, generate_objc_tasks, generate_objcpp_tasks,
+    CxVars, copy_cx_headers, detect_asm, detect_c, detect_cpp, detect_cx, detect_objc,
+    detect_objcpp, generate_asm_tasks, generate_bundled_tasks, generate_c_tasks,
+    generate_cpp_tasks, generate_cx_bench_main, generate_cx_pgo_profdata, generate_cx_test_main,
+    generate_cx_unity_sources, generate_ld_bench, generate_ld_cunit_tests, generate_ld_tasks,
+    generate_objc_tasks, generate_objcpp_tasks,
 };
 use crate::tasks::jvm::{
     detect_jar, detect_java_kotlin, detect_kotlin, download_extract_jar_tasks, generate_jar_tasks,
@@ -66,6 +69,11 @@ pub(crate) struct Bobje {
     pub jar: Option<JarDependency>,
     pub source_files: Vec<String>,
     pub dependencies: HashMap<String, Bobje>,
+    pub object_cache_dir: Option<String>,
+    pub profile_config: ProfileConfig,
+    pub pgo: Option<Pgo>,
+    pub remote: bool,
+    pub cx_vars: OnceLock<CxVars>,
 }
 
 impl Bobje {
@@ -74,6 +82,7 @@ impl Bobje {
         manifest_dir: &str,
         executor: &mut ExecutorBuilder,
         is_main: bool,
+        main_profile_config: Option<&ProfileConfig>,
     ) -> Self {
         // MARK: Read manifest
         let manifest_path = format!("{manifest_dir}/bob.toml");
@@ -111,6 +120,15 @@ impl Bobje {
             .clone()
             .or_else(|| manifest.build.target.clone());
 
+        // Profile config of the main package, so dependencies are compiled the same way
+        let profile_config = main_profile_config
+            .cloned()
+            .unwrap_or_else(|| match args.profile {
+                Profile::Debug => manifest.profile.debug.clone(),
+                Profile::Release | Profile::Bench => manifest.profile.release.clone(),
+                Profile::Test => manifest.profile.test.clone(),
+            });
+
         // MARK: Auto dependencies
         // Add libSystem dep when Cx on macOS
         if cfg!(target_os = "macos") && detect_cx(&source_files) {
@@ -180,8 +198,13 @@ impl Bobje {
         let mut dependencies = HashMap::new();
         for (dep_name, dep) in &manifest.dependencies {
             if let Dependency::Path { path } = &dep {
-                let dep_bobje =
-                    Bobje::new(args, &format!("{manifest_dir}/{path}"), executor, false);
+                let dep_bobje = Bobje::new(
+                    args,
+                    &format!("{manifest_dir}/{path}"),
+                    executor,
+                    false,
+                    Some(&profile_config),
+                );
                 if !dep_bobje.r#type.is_library() {
                     eprintln!("Dependency '{dep_name}' in {path} is not a library");
                     exit(1);
@@ -243,6 +266,11 @@ impl Bobje {
             jar: None,
             source_files,
             dependencies,
+            object_cache_dir: args.object_cache_dir.clone(),
+            profile_config,
+            pgo: args.pgo,
+            remote: !args.remote_workers.is_empty(),
+            cx_vars: OnceLock::new(),
         };
 
         let mut visit_bobje = |bobje: &mut Bobje| {
@@ -252,8 +280,21 @@ impl Bobje {
             if bobje.is_main && bobje.profile == Profile::Test && detect_cx(&bobje.source_files) {
                 generate_cx_test_main(bobje);
             }
+            if bobje.is_main && bobje.profile == Profile::Bench && detect_cx(&bobje.source_files) {
+                generate_cx_bench_main(bobje);
+            }
+            // Unity sources hide the test and bench functions from the generated mains
+            if !matches!(bobje.profile, Profile::Test | Profile::Bench)
+                && detect_cpp(&bobje.source_files)
+            {
+                generate_cx_unity_sources(bobje);
+            }
             if detect_cx(&bobje.source_files) {
                 copy_cx_headers(bobje, executor);
+                generate_bundled_tasks(bobje, executor);
+                if bobje.pgo == Some(Pgo::Use) {
+                    generate_cx_pgo_profdata(bobje, executor);
+                }
             }
             if detect_asm(&bobje.source_files) {
                 generate_asm_tasks(bobje, executor);
@@ -282,6 +323,8 @@ impl Bobje {
             if detect_cx(&bobje.source_files) {
                 if bobje.profile == Profile::Test {
                     generate_ld_cunit_tests(bobje, executor);
+                } else if bobje.profile == Profile::Bench {
+                    generate_ld_bench(bobje, executor);
                 } else {
                     generate_ld_tasks(bobje, executor);
                 }
@@ -339,20 +382,42 @@ impl Bobje {
             jar: Some(jar.clone()),
             source_files: vec![],
             dependencies: HashMap::new(),
+            object_cache_dir: args.object_cache_dir.clone(),
+            profile_config: ProfileConfig::default(),
+            pgo: args.pgo,
+            remote: false,
+            cx_vars: OnceLock::new(),
         };
         download_extract_jar_tasks(&bobje, executor, jar);
         bobje
     }
 
+    fn profile_dir(&self, pgo: Option<Pgo>) -> String {
+        if let Some(pgo) = pgo {
+            format!("{}-{}", self.profile, pgo)
+        } else {
+            self.profile.to_string()
+        }
+    }
+
     pub(crate) fn out_dir(&self) -> String {
-        format!("{}/{}", self.target_dir, self.profile)
+        format!("{}/{}", self.target_dir, self.profile_dir(self.pgo))
     }
 
     pub(crate) fn out_dir_with_target(&self) -> String {
+        self.out_dir_with_target_for(self.pgo)
+    }
+
+    /// Out directory of the instrumented `--pgo-generate` build, which holds its profiles.
+    pub(crate) fn pgo_generate_dir(&self) -> String {
+        self.out_dir_with_target_for(Some(Pgo::Generate))
+    }
+
+    fn out_dir_with_target_for(&self, pgo: Option<Pgo>) -> String {
         if let Some(target) = &self.target {
-            format!("{}/{}/{}", self.target_dir, target, self.profile)
+            format!("{}/{}/{}", self.target_dir, target, self.profile_dir(pgo))
         } else {
-            self.out_dir()
+            format!("{}/{}", self.target_dir, self.profile_dir(pgo))
         }
     }
 }
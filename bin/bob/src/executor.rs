@@ -6,18 +6,22 @@
 
 #![allow(unused_variables)]
 
-use std::collections::HashSet;
+use std::collections::{HashMap, HashSet};
 use std::path::Path;
-use std::process::{Command, exit};
+use std::process::{Stdio, exit};
 use std::sync::atomic::{AtomicUsize, Ordering};
-use std::sync::{Arc, Mutex};
-use std::time::{Duration, SystemTime};
-use std::{env, fs, thread};
+use std::sync::{Arc, Condvar, Mutex, mpsc};
+use std::time::{Duration, Instant, SystemTime};
+use std::{env, fs, mem, thread};
 
 use sha1::Sha1;
 use threadpool::ThreadPool;
 
 use crate::log::{Log, LogEntry};
+use crate::object_cache::{object_cache_key, restore_object, store_object};
+use crate::remote::RemoteSlot;
+use crate::timings::{TaskTiming, print_timings, write_trace};
+use crate::utils::shell_command;
 
 // MARK: Task
 #[derive(Debug, Clone)]
@@ -26,6 +30,10 @@ pub(crate) struct Task {
     action: TaskAction,
     inputs: Vec<String>,
     outputs: Vec<String>,
+    depfile: Option<String>,
+    /// Dependencies the depfile listed on the previous build, they may no longer exist. A task
+    /// with a depfile but without dependencies in the log always runs.
+    deps: Option<Vec<String>>,
 }
 
 #[derive(Debug, Clone)]
@@ -33,48 +41,37 @@ pub(crate) struct Task {
 pub(crate) enum TaskAction {
     Phony(String),
     Copy(String, String),
+    /// Remove a file when it exists.
+    Remove(String),
     Command(String),
+    /// Compile command that reuses objects from the object cache in the cache directory, or
+    /// runs the remote command on a remote worker with the preprocessed source. The cache key
+    /// hashes the key command instead of the command when there is one, so it can leave out
+    /// paths to share objects between projects.
+    Compile {
+        command: String,
+        preprocess_command: String,
+        object_file: String,
+        cache_dir: Option<String>,
+        cache_key_command: Option<String>,
+        remote_command: Option<String>,
+    },
     Multiple(Vec<TaskAction>),
 }
 
 impl Task {
-    fn have_inputs_change(&self, log: &Log) -> bool {
+    fn have_inputs_change(&self, changed_inputs: &HashSet<&str>) -> bool {
         // Check if inputs have changed
-        for input in &self.inputs {
-            // Get input modified time
-            let metadata = match fs::metadata(input) {
-                Ok(metadata) => metadata,
-                Err(_) => return true,
-            };
-            let mtime = metadata
-                .modified()
-                .expect("Failed to get modified time")
-                .duration_since(SystemTime::UNIX_EPOCH)
-                .expect("Time went backwards");
-
-            // Get input hash
-            let hash = if !metadata.is_dir() {
-                // Calculate input hash
-                let buffer = fs::read(input).unwrap_or_else(|_| {
-                    eprintln!("Can't read input file: {input}");
-                    exit(1)
-                });
-                if !buffer.is_empty() {
-                    Some(Sha1::digest(buffer))
-                } else {
-                    None
-                }
-            } else {
-                None
-            };
-
-            // Check if the input has changed
-            if log
-                .get(input)
-                .is_none_or(|entry| entry.mtime != mtime || entry.hash != hash)
-            {
-                return true;
-            }
+        if self.depfile.is_some() && self.deps.is_none() {
+            return true;
+        }
+        if self
+            .inputs
+            .iter()
+            .chain(self.deps.iter().flatten())
+            .any(|input| changed_inputs.contains(input.as_str()))
+        {
+            return true;
         }
 
         // Check if outputs are missing
@@ -90,51 +87,17 @@ impl Task {
     fn execute(
         &self,
         log: Arc<Mutex<Log>>,
+        hashes: Arc<FileHashes>,
         task_counter: Arc<AtomicUsize>,
         total_tasks: usize,
         pretty_print: bool,
-    ) {
+        local_slots: &Slots,
+    ) -> Option<(String, bool)> {
         // Update log entries of inputs
-        {
-            let mut log: std::sync::MutexGuard<'_, Log> = log.lock().expect("Could not lock mutex");
-            for input in &self.inputs {
-                // Get input modified time
-                let metadata = fs::metadata(input).unwrap_or_else(|_| {
-                    eprintln!("Can't open input file: {input}");
-                    exit(1)
-                });
-                let mtime = metadata
-                    .modified()
-                    .expect("Failed to get modified time")
-                    .duration_since(SystemTime::UNIX_EPOCH)
-                    .expect("Time went backwards");
-
-                // Get input hash
-                let hash = if !metadata.is_dir() {
-                    // Calculate input hash
-                    let buffer = fs::read(input).unwrap_or_else(|_| {
-                        eprintln!("Can't read input file: {input}");
-                        exit(1)
-                    });
-                    if !buffer.is_empty() {
-                        Some(Sha1::digest(buffer))
-                    } else {
-                        None
-                    }
-                } else {
-                    None
-                };
-
-                if log
-                    .get(input)
-                    .is_none_or(|entry| entry.mtime != mtime || entry.hash != hash)
-                {
-                    log.add(LogEntry {
-                        path: input.clone(),
-                        mtime,
-                        hash,
-                    });
-                }
+        for input in &self.inputs {
+            if !log_file(input, &log, &hashes) {
+                eprintln!("Can't open input file: {input}");
+                exit(1);
             }
         }
 
@@ -148,10 +111,20 @@ impl Task {
             }
         }
 
-        // Execute command
-        let line = self.action.execute();
+        // Execute command, on a remote slot when one is free or else on a local slot
+        let remote_slot = match &self.action {
+            TaskAction::Compile {
+                remote_command: Some(_),
+                ..
+            } => RemoteSlot::acquire(),
+            _ => None,
+        };
+        let local_slot = remote_slot.is_none().then(|| local_slots.acquire());
+        let action_line = self.action.execute(remote_slot, local_slots);
+        drop(local_slot);
+        let action_line = action_line?;
         let current_task = task_counter.fetch_add(1, Ordering::SeqCst);
-        let line = format!("[{current_task}/{total_tasks}] {line}");
+        let line = format!("[{current_task}/{total_tasks}] {action_line}");
         if pretty_print {
             let term_width = terminal_size::terminal_size()
                 .map(|(w, _)| w.0 as usize)
@@ -168,6 +141,29 @@ impl Task {
             println!("{line}");
         }
 
+        // Store the dependencies from the depfile in the log, so the next build checks them
+        // without parsing it again
+        if let Some(depfile) = &self.depfile
+            && let Ok(contents) = fs::read_to_string(depfile)
+        {
+            let deps = parse_depfile(&contents)
+                .into_iter()
+                .filter(|dep| !self.inputs.contains(dep))
+                .collect::<Vec<_>>();
+            for dep in &deps {
+                log_file(dep, &log, &hashes);
+            }
+            log.lock()
+                .expect("Could not lock mutex")
+                .add_deps(self.outputs[0].clone(), deps);
+            _ = fs::remove_file(depfile);
+        }
+
+        // Compare the outputs with the contents their dependents last saw
+        let outputs_changed = self.outputs.iter().fold(false, |changed, output| {
+            output_changed(output, &log, &hashes) || changed
+        });
+
         // Update log entries of output dirs
         {
             let mut log = log.lock().expect("Could not lock mutex");
@@ -183,17 +179,21 @@ impl Task {
                             .duration_since(SystemTime::UNIX_EPOCH)
                             .expect("Time went backwards")
                             - Duration::from_nanos(1),
+                        size: None,
                         hash: None,
                     });
                 }
             }
         }
+        Some((action_line, outputs_changed))
     }
 }
 
 impl TaskAction {
-    fn execute(&self) -> String {
-        match self {
+    /// Run the action, returns None when a command failed. An action with a remote slot holds
+    /// no local slot, so it takes one from the local slots when it falls back to a local compile.
+    fn execute(&self, mut remote_slot: Option<RemoteSlot>, local_slots: &Slots) -> Option<String> {
+        Some(match self {
             TaskAction::Phony(dest) => dest.clone(),
             TaskAction::Copy(src, dst) => {
                 fs::copy(src, dst).unwrap_or_else(|_| {
@@ -202,45 +202,330 @@ impl TaskAction {
                 });
                 format!("cp {src} {dst}")
             }
+            TaskAction::Remove(path) => {
+                _ = fs::remove_file(path);
+                format!("rm -f {path}")
+            }
             TaskAction::Command(command) => {
-                let status = if cfg!(windows) {
-                    let parts = command.split(' ').collect::<Vec<_>>();
-                    Command::new(parts[0]).args(&parts[1..]).status()
+                if !run_command(command) {
+                    return None;
+                }
+                command.clone()
+            }
+            TaskAction::Compile {
+                command,
+                preprocess_command,
+                object_file,
+                cache_dir,
+                cache_key_command,
+                remote_command,
+            } => {
+                // Without preprocessed source the compiler reports the error
+                let preprocessed = preprocess(preprocess_command);
+                let key =
+                    preprocessed
+                        .as_ref()
+                        .filter(|_| cache_dir.is_some())
+                        .map(|preprocessed| {
+                            object_cache_key(command, cache_key_command.as_deref(), preprocessed)
+                        });
+                if let (Some(cache_dir), Some(key)) = (cache_dir, &key)
+                    && restore_object(cache_dir, key, object_file)
+                {
+                    return Some(format!("{command} (cached)"));
+                }
+
+                // Remove the old object first, it can be a hard link into the cache
+                _ = fs::remove_file(object_file);
+                let mut line = command.clone();
+                if let (Some(remote_slot), Some(remote_command), Some(preprocessed)) =
+                    (remote_slot.as_ref(), remote_command, &preprocessed)
+                    && remote_slot.compile(remote_command, preprocessed, object_file)
+                {
+                    line = format!("{command} (remote {})", remote_slot.addr());
                 } else {
-                    Command::new("sh").arg("-c").arg(command).status()
+                    let local_slot = remote_slot.take().map(|_| local_slots.acquire());
+                    if !run_command(command) {
+                        return None;
+                    }
                 }
-                .unwrap_or_else(|_| {
-                    eprintln!("Failed to execute command: {command}");
-                    exit(1)
-                });
-                if !status.success() {
-                    eprintln!("Command failed: {command}");
-                    exit(1);
+                if let (Some(cache_dir), Some(key)) = (cache_dir, &key) {
+                    store_object(cache_dir, key, object_file);
                 }
-                command.clone()
+                line
             }
             TaskAction::Multiple(actions) => {
                 let mut lines = Vec::new();
                 for action in actions {
-                    lines.push(action.execute());
+                    lines.push(action.execute(None, local_slots)?);
                 }
                 lines.join(" && ")
             }
+        })
+    }
+}
+
+fn preprocess(preprocess_command: &str) -> Option<Vec<u8>> {
+    shell_command(preprocess_command)
+        .stderr(Stdio::null())
+        .output()
+        .ok()
+        .filter(|output| output.status.success())
+        .map(|output| output.stdout)
+}
+
+fn run_command(command: &str) -> bool {
+    let status = shell_command(command).status().unwrap_or_else(|_| {
+        eprintln!("Failed to execute command: {command}");
+        exit(1)
+    });
+    if !status.success() {
+        eprintln!("Command failed: {command}");
+    }
+    status.success()
+}
+
+// MARK: Depfiles
+/// Prerequisites of the first rule of a Makefile style depfile, like the compiler writes with
+/// `-MMD -MF`.
+fn parse_depfile(contents: &str) -> Vec<String> {
+    let contents = contents.replace("\\\r\n", " ").replace("\\\n", " ");
+    let Some((_, prerequisites)) = contents.split_once(": ") else {
+        return Vec::new();
+    };
+
+    let mut deps = Vec::new();
+    let mut dep = String::new();
+    let mut chars = prerequisites.chars().peekable();
+    while let Some(char) = chars.next() {
+        match char {
+            '\\' if chars.peek() == Some(&' ') => {
+                dep.push(' ');
+                chars.next();
+            }
+            ' ' | '\t' | '\r' | '\n' => {
+                if !dep.is_empty() {
+                    deps.push(mem::take(&mut dep));
+                }
+                if char == '\n' {
+                    break;
+                }
+            }
+            _ => dep.push(char),
+        }
+    }
+    if !dep.is_empty() {
+        deps.push(dep);
+    }
+    deps
+}
+
+// MARK: Input Changes
+/// Modified time and size of a file, directories have no size.
+pub(crate) fn file_stat(path: &str) -> Option<(Duration, Option<u64>)> {
+    let metadata = fs::metadata(path).ok()?;
+    let mtime = metadata
+        .modified()
+        .expect("Failed to get modified time")
+        .duration_since(SystemTime::UNIX_EPOCH)
+        .expect("Time went backwards");
+    Some((mtime, (!metadata.is_dir()).then_some(metadata.len())))
+}
+
+/// Content hashes of the files read during this run, an entry stays valid while the modified
+/// time and size of the file stay the same.
+#[derive(Default)]
+struct FileHashes(Mutex<HashMap<String, FileHash>>);
+
+type FileHash = (Duration, u64, Option<[u8; 20]>);
+
+impl FileHashes {
+    fn hash(&self, path: &str, mtime: Duration, size: u64) -> Option<[u8; 20]> {
+        if let Some(&(cached_mtime, cached_size, hash)) =
+            self.0.lock().expect("Could not lock mutex").get(path)
+            && cached_mtime == mtime
+            && cached_size == size
+        {
+            return hash;
+        }
+
+        // Empty files have no hash
+        let hash = if size > 0 {
+            let buffer = fs::read(path).unwrap_or_else(|_| {
+                eprintln!("Can't read input file: {path}");
+                exit(1)
+            });
+            Some(Sha1::digest(buffer))
+        } else {
+            None
+        };
+        self.0
+            .lock()
+            .expect("Could not lock mutex")
+            .insert(path.to_string(), (mtime, size, hash));
+        hash
+    }
+}
+
+/// Update the log entry of a file, it is only hashed when its modified time or size differ
+/// from the log and never while holding the log lock. Returns false when the file is missing.
+fn log_file(path: &str, log: &Mutex<Log>, hashes: &FileHashes) -> bool {
+    let Some((mtime, size)) = file_stat(path) else {
+        return false;
+    };
+    if log
+        .lock()
+        .expect("Could not lock mutex")
+        .get(path)
+        .is_some_and(|entry| entry.mtime == mtime && entry.size == size)
+    {
+        return true;
+    }
+    let hash = size.and_then(|size| hashes.hash(path, mtime, size));
+    log.lock().expect("Could not lock mutex").add(LogEntry {
+        path: path.to_string(),
+        mtime,
+        size,
+        hash,
+    });
+    true
+}
+
+/// Whether the contents of an output differ from its log entry, which holds the contents its
+/// dependents last saw. An output with the same contents gets a new log entry, so it is not
+/// hashed again. Directories and outputs without a log entry always count as changed.
+fn output_changed(path: &str, log: &Mutex<Log>, hashes: &FileHashes) -> bool {
+    let Some((mtime, Some(size))) = file_stat(path) else {
+        return true;
+    };
+    let Some(entry_hash) = log
+        .lock()
+        .expect("Could not lock mutex")
+        .get(path)
+        .filter(|entry| entry.size == Some(size))
+        .map(|entry| entry.hash)
+    else {
+        return true;
+    };
+    let hash = hashes.hash(path, mtime, size);
+    if hash != entry_hash {
+        return true;
+    }
+    log.lock().expect("Could not lock mutex").add(LogEntry {
+        path: path.to_string(),
+        mtime,
+        size: Some(size),
+        hash,
+    });
+    false
+}
+
+enum InputState {
+    Unchanged,
+    Touched(LogEntry),
+    Changed,
+}
+
+/// Compare an input with its log entry. A file with the modified time and size of the log is
+/// trusted without reading it, a file that is only touched keeps its contents and gets a new
+/// log entry instead of a rebuild.
+fn input_state(path: &str, log: &Log, hashes: &FileHashes) -> InputState {
+    let Some((mtime, size)) = file_stat(path) else {
+        return InputState::Changed;
+    };
+    let Some(entry) = log.get(path) else {
+        return InputState::Changed;
+    };
+    if entry.mtime == mtime && entry.size == size {
+        return InputState::Unchanged;
+    }
+    let Some(size) = size else {
+        return InputState::Changed;
+    };
+    if entry.size.is_some_and(|entry_size| entry_size != size) {
+        return InputState::Changed;
+    }
+    let hash = hashes.hash(path, mtime, size);
+    if hash != entry.hash {
+        return InputState::Changed;
+    }
+    InputState::Touched(LogEntry {
+        path: path.to_string(),
+        mtime,
+        size: Some(size),
+        hash,
+    })
+}
+
+/// Inputs of all tasks that changed since the log was written, every path is checked once and
+/// the checks are spread over all cores.
+fn changed_inputs<'a>(tasks: &'a [Task], log: &mut Log, hashes: &FileHashes) -> HashSet<&'a str> {
+    let mut seen = HashSet::new();
+    let inputs = tasks
+        .iter()
+        .flat_map(|task| task.inputs.iter().chain(task.deps.iter().flatten()))
+        .map(String::as_str)
+        .filter(|input| seen.insert(*input))
+        .collect::<Vec<_>>();
+
+    let thread_count = thread::available_parallelism().map_or(1, |n| n.get());
+    let chunk_size = inputs.len().div_ceil(thread_count).max(1);
+    let states = thread::scope(|scope| {
+        let log = &*log;
+        inputs
+            .chunks(chunk_size)
+            .map(|chunk| {
+                scope.spawn(move || {
+                    chunk
+                        .iter()
+                        .map(|input| input_state(input, log, hashes))
+                        .collect::<Vec<_>>()
+                })
+            })
+            .collect::<Vec<_>>()
+            .into_iter()
+            .flat_map(|handle| handle.join().expect("Input check failed"))
+            .collect::<Vec<_>>()
+    });
+
+    let mut changed = HashSet::new();
+    for (input, state) in inputs.into_iter().zip(states) {
+        match state {
+            InputState::Unchanged => {}
+            InputState::Touched(entry) => log.add(entry),
+            InputState::Changed => {
+                changed.insert(input);
+            }
         }
     }
+    changed
 }
 
 // MARK: ExecutorBuilder
 pub(crate) struct ExecutorBuilder {
     tasks_id_counter: usize,
     tasks: Vec<Task>,
+    task_outputs: HashSet<Vec<String>>,
+    roots: Vec<usize>,
 }
 
 impl ExecutorBuilder {
-    pub(crate) const fn new() -> Self {
+    pub(crate) fn new() -> Self {
         Self {
             tasks_id_counter: 0,
             tasks: Vec::new(),
+            task_outputs: HashSet::new(),
+            roots: Vec::new(),
+        }
+    }
+
+    /// Mark the last added task as the final task of a build graph, the executor runs the
+    /// tasks of every marked graph. Without marks only the last added task is final.
+    pub(crate) fn mark_root(&mut self) {
+        if let Some(index) = self.tasks.len().checked_sub(1)
+            && !self.roots.contains(&index)
+        {
+            self.roots.push(index);
         }
     }
 
@@ -250,12 +535,26 @@ impl ExecutorBuilder {
         inputs: Vec<String>,
         outputs: Vec<String>,
     ) {
-        if !self.tasks.iter().any(|task| task.outputs == outputs) {
+        self.add_task_with_depfile(action, inputs, outputs, None);
+    }
+
+    /// Add a task whose action writes the headers it includes to a depfile, which are inputs
+    /// of the task on the next build.
+    pub(crate) fn add_task_with_depfile(
+        &mut self,
+        action: TaskAction,
+        inputs: Vec<String>,
+        outputs: Vec<String>,
+        depfile: Option<String>,
+    ) {
+        if self.task_outputs.insert(outputs.clone()) {
             self.tasks.push(Task {
                 id: self.tasks_id_counter,
                 action,
                 inputs,
                 outputs,
+                depfile,
+                deps: None,
             });
             self.tasks_id_counter += 1;
         }
@@ -282,256 +581,443 @@ impl ExecutorBuilder {
         );
     }
 
-    pub(crate) fn build(self, log_path: &str) -> Executor {
-        Executor::new(self.tasks, log_path)
+    pub(crate) fn build(mut self, log_path: &str) -> Executor {
+        if self.roots.is_empty() {
+            self.mark_root();
+        }
+        Executor::new(self.tasks, self.roots, log_path)
     }
 }
 
-// MARK: Circular Dependency Detection
-fn detect_circular_dependencies(tasks: &[Task]) {
-    for task in tasks {
-        let mut visited = HashSet::new();
-        let mut rec_stack = HashSet::new();
-        if has_cycle(task, tasks, &mut visited, &mut rec_stack) {
-            // Build the cycle path for error reporting
-            let mut cycle_path = Vec::new();
-            let mut current_stack = HashSet::new();
-            find_cycle_path(task, tasks, &mut current_stack, &mut cycle_path);
-
-            eprintln!("Circular dependency in tasks detected!\n");
-            eprintln!("Problematic tasks:");
-            for task_id in &cycle_path {
-                for t in tasks {
-                    if t.id == *task_id {
-                        eprintln!(
-                            "  Task {}: inputs={:?}, outputs={:?}",
-                            t.id, t.inputs, t.outputs
-                        );
-                    }
-                }
-            }
-            eprintln!("\nDependency cycle:");
-            for (i, task_id) in cycle_path.iter().enumerate() {
-                for t in tasks {
-                    if t.id == *task_id {
-                        eprint!("  Task {} (outputs: {:?})", t.id, t.outputs);
-                        if i < cycle_path.len() - 1 {
-                            eprintln!(" →");
-                        } else {
-                            eprintln!(" → [CYCLE]");
-                        }
+// MARK: Dependency Graph
+/// Indices of the tasks producing the inputs of every task, looked up in an index of all
+/// outputs that is built once.
+fn task_dependencies(tasks: &[Task]) -> Vec<Vec<usize>> {
+    let mut producers: HashMap<&str, Vec<usize>> = HashMap::new();
+    for (index, task) in tasks.iter().enumerate() {
+        for output in &task.outputs {
+            producers.entry(output).or_default().push(index);
+        }
+    }
+    tasks
+        .iter()
+        .map(|task| {
+            let mut dependencies = Vec::new();
+            for input in task.inputs.iter().chain(task.deps.iter().flatten()) {
+                for producer in producers.get(input.as_str()).into_iter().flatten() {
+                    if !dependencies.contains(producer) {
+                        dependencies.push(*producer);
                     }
                 }
             }
-            exit(1);
-        }
-    }
+            dependencies
+        })
+        .collect()
 }
 
-fn has_cycle(
-    task: &Task,
-    all_tasks: &[Task],
-    visited: &mut HashSet<usize>,
-    rec_stack: &mut HashSet<usize>,
-) -> bool {
-    visited.insert(task.id);
-    rec_stack.insert(task.id);
-
-    for input in &task.inputs {
-        for other_task in all_tasks {
-            if other_task.outputs.contains(input) {
-                if !visited.contains(&other_task.id) {
-                    if has_cycle(other_task, all_tasks, visited, rec_stack) {
-                        return true;
-                    }
-                } else if rec_stack.contains(&other_task.id) {
-                    return true;
-                }
+// MARK: Circular Dependency Detection
+fn detect_circular_dependencies(tasks: &[Task], dependencies: &[Vec<usize>]) {
+    let mut states = vec![VisitState::Unvisited; tasks.len()];
+    let mut path = Vec::new();
+    for index in 0..tasks.len() {
+        if states[index] != VisitState::Unvisited {
+            continue;
+        }
+        let Some(cycle_path) = find_cycle_path(index, dependencies, &mut states, &mut path) else {
+            continue;
+        };
+
+        eprintln!("Circular dependency in tasks detected!\n");
+        eprintln!("Problematic tasks:");
+        for task in cycle_path.iter().map(|index| &tasks[*index]) {
+            eprintln!(
+                "  Task {}: inputs={:?}, outputs={:?}",
+                task.id, task.inputs, task.outputs
+            );
+        }
+        eprintln!("\nDependency cycle:");
+        for (i, task) in cycle_path.iter().map(|index| &tasks[*index]).enumerate() {
+            eprint!("  Task {} (outputs: {:?})", task.id, task.outputs);
+            if i < cycle_path.len() - 1 {
+                eprintln!(" →");
+            } else {
+                eprintln!(" → [CYCLE]");
             }
         }
+        exit(1);
     }
+}
 
-    rec_stack.remove(&task.id);
-    false
+#[derive(Clone, Copy, PartialEq, Eq)]
+enum VisitState {
+    Unvisited,
+    OnPath,
+    Done,
 }
 
+/// Depth first search that visits every task once, returns the cycle when it reaches a task
+/// that is on the current path.
 fn find_cycle_path(
-    task: &Task,
-    all_tasks: &[Task],
-    current_stack: &mut HashSet<usize>,
-    cycle_path: &mut Vec<usize>,
-) -> bool {
-    current_stack.insert(task.id);
-    cycle_path.push(task.id);
-
-    for input in &task.inputs {
-        for other_task in all_tasks {
-            if other_task.outputs.contains(input) {
-                if current_stack.contains(&other_task.id) {
-                    // Found the cycle, keep only the cycle part
-                    while let Some(&id) = cycle_path.first() {
-                        if id == other_task.id {
-                            break;
-                        }
-                        cycle_path.remove(0);
-                    }
-                    cycle_path.push(other_task.id);
-                    return true;
-                }
-                if find_cycle_path(other_task, all_tasks, current_stack, cycle_path) {
-                    return true;
+    index: usize,
+    dependencies: &[Vec<usize>],
+    states: &mut [VisitState],
+    path: &mut Vec<usize>,
+) -> Option<Vec<usize>> {
+    states[index] = VisitState::OnPath;
+    path.push(index);
+    for &dependency in &dependencies[index] {
+        match states[dependency] {
+            VisitState::Unvisited => {
+                if let Some(cycle_path) = find_cycle_path(dependency, dependencies, states, path) {
+                    return Some(cycle_path);
                 }
             }
+            VisitState::OnPath => {
+                let start = path
+                    .iter()
+                    .position(|&other| other == dependency)
+                    .expect("Task is on the path");
+                let mut cycle_path = path[start..].to_vec();
+                cycle_path.push(dependency);
+                return Some(cycle_path);
+            }
+            VisitState::Done => {}
         }
     }
-
-    cycle_path.pop();
-    current_stack.remove(&task.id);
-    false
+    path.pop();
+    states[index] = VisitState::Done;
+    None
 }
 
 // MARK: Executor
 pub(crate) struct Executor {
     log: Arc<Mutex<Log>>,
+    hashes: Arc<FileHashes>,
+    all_tasks: Vec<Task>,
+    roots: Vec<usize>,
     tasks: Vec<Task>,
+    dependencies: Vec<Vec<usize>>,
+    /// Whether the inputs of a task changed, the other tasks only run when a dependency
+    /// changes its outputs.
+    dirty: Vec<bool>,
+    timings: Vec<TaskTiming>,
 }
 
 impl Executor {
-    fn new(tasks: Vec<Task>, log_path: &str) -> Self {
+    fn new(tasks: Vec<Task>, roots: Vec<usize>, log_path: &str) -> Self {
+        let mut executor = Self {
+            log: Arc::new(Mutex::new(Log::new(log_path))),
+            hashes: Arc::new(FileHashes::default()),
+            all_tasks: tasks,
+            roots,
+            tasks: Vec::new(),
+            dependencies: Vec::new(),
+            dirty: Vec::new(),
+            timings: Vec::new(),
+        };
+        executor.plan();
+        executor
+    }
+
+    /// Select the tasks whose inputs changed since they last ran and the tasks depending on
+    /// them, which may be cut off when the outputs they depend on stay the same. The file
+    /// hashes of earlier plans are reused while a file stays the same.
+    pub(crate) fn plan(&mut self) {
+        // Add the dependencies found in depfiles on the previous build
+        let mut log = self.log.lock().expect("Could not lock mutex");
+        for task in &mut self.all_tasks {
+            if task.depfile.is_some() {
+                task.deps = log.deps(&task.outputs[0]).map(<[String]>::to_vec);
+            }
+        }
+        let tasks = &self.all_tasks;
+
+        let dependencies = task_dependencies(tasks);
+
         // Detect circular dependencies before processing
-        detect_circular_dependencies(&tasks);
+        detect_circular_dependencies(tasks, &dependencies);
 
         fn visit_task(
-            task: &Task,
+            index: usize,
+            dependencies: &[Vec<usize>],
             all_tasks: &[Task],
-            new_tasks: &mut Vec<Task>,
-            log: &Log,
+            changed: &mut [Option<bool>],
+            dirty: &mut [bool],
+            new_tasks: &mut Vec<usize>,
+            changed_inputs: &HashSet<&str>,
         ) -> bool {
-            if new_tasks.iter().any(|t| t.id == task.id) {
-                return false;
+            if let Some(inputs_changed) = changed[index] {
+                return inputs_changed;
             }
 
-            let mut inputs_changed = task.have_inputs_change(log);
-            for input in &task.inputs {
-                for other_task in all_tasks {
-                    if other_task.outputs.contains(input) {
-                        inputs_changed |= visit_task(other_task, all_tasks, new_tasks, log);
-                    }
-                }
+            dirty[index] = all_tasks[index].have_inputs_change(changed_inputs);
+            let mut inputs_changed = dirty[index];
+            for &dependency in &dependencies[index] {
+                inputs_changed |= visit_task(
+                    dependency,
+                    dependencies,
+                    all_tasks,
+                    changed,
+                    dirty,
+                    new_tasks,
+                    changed_inputs,
+                );
             }
 
+            changed[index] = Some(inputs_changed);
             if inputs_changed {
-                new_tasks.push(task.clone());
+                new_tasks.push(index);
             }
             inputs_changed
         }
 
-        // Create new task tree with all needed tasks
-        let log = Log::new(log_path);
-        let mut new_tasks = Vec::new();
-        let last_task = tasks.last().expect("No tasks to execute");
-        visit_task(last_task, &tasks, &mut new_tasks, &log);
+        // Create new task tree with all needed tasks, dependencies come before their dependents
+        let changed_inputs = changed_inputs(tasks, &mut log, &self.hashes);
+        let mut new_task_indices = Vec::new();
+        let mut changed = vec![None; tasks.len()];
+        let mut dirty = vec![false; tasks.len()];
+        assert!(!tasks.is_empty(), "No tasks to execute");
+        for &root in &self.roots {
+            visit_task(
+                root,
+                &dependencies,
+                tasks,
+                &mut changed,
+                &mut dirty,
+                &mut new_task_indices,
+                &changed_inputs,
+            );
+        }
 
-        Self {
-            log: Arc::new(Mutex::new(log)),
-            tasks: new_tasks,
+        // Keep the dependencies on tasks that run, the others are up to date
+        let mut new_positions = vec![None; tasks.len()];
+        for (position, &index) in new_task_indices.iter().enumerate() {
+            new_positions[index] = Some(position);
         }
+        self.dependencies = new_task_indices
+            .iter()
+            .map(|&index| {
+                dependencies[index]
+                    .iter()
+                    .filter_map(|&dependency| new_positions[dependency])
+                    .collect()
+            })
+            .collect();
+        self.dirty = new_task_indices.iter().map(|&index| dirty[index]).collect();
+        self.tasks = new_task_indices
+            .iter()
+            .map(|&index| tasks[index].clone())
+            .collect();
+    }
+
+    /// Inputs and depfile dependencies of all tasks that no task produces, a change to one of
+    /// them needs a new plan.
+    pub(crate) fn source_files(&self) -> Vec<String> {
+        let log = self.log.lock().expect("Could not lock mutex");
+        let outputs = self
+            .all_tasks
+            .iter()
+            .flat_map(|task| task.outputs.iter())
+            .collect::<HashSet<_>>();
+        let mut seen = HashSet::new();
+        self.all_tasks
+            .iter()
+            .flat_map(|task| {
+                let deps = task
+                    .depfile
+                    .as_ref()
+                    .and_then(|_| log.deps(&task.outputs[0]))
+                    .unwrap_or_default();
+                task.inputs.iter().chain(deps)
+            })
+            .filter(|input| !outputs.contains(input) && seen.insert(*input))
+            .cloned()
+            .collect()
     }
 
     pub(crate) const fn total_tasks(&self) -> usize {
         self.tasks.len()
     }
 
-    pub(crate) fn execute(&mut self, verbose: bool, thread_count: Option<usize>) {
-        // Start execution if there is a last task
-        if let Some(last_task) = self.tasks.last() {
-            // Print task tree
-            if verbose {
-                println!("{:#?}", self.tasks);
-            }
+    pub(crate) fn execute(
+        &mut self,
+        verbose: bool,
+        thread_count: Option<usize>,
+        remote_slots: usize,
+    ) -> bool {
+        if self.tasks.is_empty() {
+            return true;
+        }
 
-            let pretty_print = !verbose && env::var("NO_COLOR").is_err() && env::var("CI").is_err();
-            if pretty_print {
-                println!();
-            }
+        // Print task tree
+        if verbose {
+            println!("{:#?}", self.tasks);
+        }
 
-            let pool = ThreadPool::new(
-                thread_count
-                    .unwrap_or_else(|| thread::available_parallelism().map_or(1, |n| n.get())),
-            );
-            self.execute_task(
-                last_task,
-                &pool,
-                Arc::new(Mutex::new(Vec::new())),
-                Arc::new(Mutex::new(Vec::new())),
-                Arc::new(AtomicUsize::new(1)),
-                pretty_print,
-            );
-            pool.join();
+        let pretty_print = !verbose && env::var("NO_COLOR").is_err() && env::var("CI").is_err();
+        if pretty_print {
+            println!();
         }
-    }
 
-    fn execute_task(
-        &self,
-        task: &Task,
-        pool: &ThreadPool,
-        scheduled_task_ids: Arc<Mutex<Vec<usize>>>,
-        done_task_ids: Arc<Mutex<Vec<usize>>>,
-        task_counter: Arc<AtomicUsize>,
-        pretty_print: bool,
-    ) {
-        // Check if task is already scheduled
-        {
-            let mut scheduled_task_ids = scheduled_task_ids.lock().expect("Could not lock mutex");
-            if scheduled_task_ids.contains(&task.id) {
-                return;
-            }
-            scheduled_task_ids.push(task.id);
-        }
-
-        // Find and run dependencies
-        let mut dependency_ids = Vec::new();
-        for input in &task.inputs {
-            for other_task in &self.tasks {
-                if other_task.outputs.contains(input) {
-                    dependency_ids.push(other_task.id);
-                    self.execute_task(
-                        other_task,
-                        pool,
-                        scheduled_task_ids.clone(),
-                        done_task_ids.clone(),
-                        task_counter.clone(),
-                        pretty_print,
-                    );
-                }
+        // Count the unfinished dependencies of every task, a task is queued on the pool when
+        // its count drops to zero and workers report finished tasks back over a channel
+        let mut pending_dependencies = self.dependencies.iter().map(Vec::len).collect::<Vec<_>>();
+        let mut dependents = vec![Vec::new(); self.tasks.len()];
+        for (index, dependencies) in self.dependencies.iter().enumerate() {
+            for &dependency in dependencies {
+                dependents[dependency].push(index);
             }
         }
 
-        let task = task.clone();
-        let log = self.log.clone();
-        let task_counter: Arc<AtomicUsize> = task_counter.clone();
+        // Tasks on remote slots wait on the network, so the pool gets a thread for every
+        // remote slot while local slots keep the local processes at the thread count
+        let thread_count =
+            thread_count.unwrap_or_else(|| thread::available_parallelism().map_or(1, |n| n.get()));
+        let pool = ThreadPool::new(thread_count + remote_slots);
+        let local_slots = Arc::new(Slots::new(thread_count));
+        let (done_sender, done_receiver) = mpsc::channel();
+        let task_counter = Arc::new(AtomicUsize::new(1));
         let total_tasks = self.tasks.len();
-        pool.execute(move || {
-            // Wait for dependencies to finish
-            if !dependency_ids.is_empty() {
-                while {
-                    let done_task_ids = done_task_ids.lock().expect("Could not lock mutex");
-                    !dependency_ids
+        let start_time = Instant::now();
+        let queue_task = |index: usize| {
+            let task = self.tasks[index].clone();
+            let log = self.log.clone();
+            let hashes = self.hashes.clone();
+            let task_counter = task_counter.clone();
+            let done_sender = done_sender.clone();
+            let local_slots = local_slots.clone();
+            pool.execute(move || {
+                let start = start_time.elapsed();
+                let line = task.execute(
+                    log,
+                    hashes,
+                    task_counter,
+                    total_tasks,
+                    pretty_print,
+                    &local_slots,
+                );
+                let result = line.map(|(line, outputs_changed)| {
+                    let timing = TaskTiming {
+                        start,
+                        end: start_time.elapsed(),
+                        worker: worker_id(),
+                        line,
+                    };
+                    (timing, outputs_changed)
+                });
+                done_sender.send((index, result)).expect("Executor stopped");
+            });
+        };
+        let mut running_tasks = 0;
+        let mut ready_tasks = (0..total_tasks)
+            .filter(|&index| pending_dependencies[index] == 0)
+            .collect::<Vec<_>>();
+
+        // A task whose inputs didn't change only runs when a dependency changed its outputs,
+        // otherwise it is cut off like its dependencies finished. After a failed task no new
+        // tasks are queued, the running ones are waited for
+        let mut timings = (0..total_tasks).map(|_| None).collect::<Vec<_>>();
+        let mut outputs_changed = vec![false; total_tasks];
+        let mut failed = false;
+        loop {
+            while let Some(index) = ready_tasks.pop() {
+                if self.dirty[index]
+                    || self.dependencies[index]
                         .iter()
-                        .all(|dep_id| done_task_ids.contains(dep_id))
-                } {
-                    thread::yield_now();
+                        .any(|&dependency| outputs_changed[dependency])
+                {
+                    queue_task(index);
+                    running_tasks += 1;
+                    continue;
+                }
+                task_counter.fetch_add(1, Ordering::SeqCst);
+                let now = start_time.elapsed();
+                timings[index] = Some(TaskTiming {
+                    start: now,
+                    end: now,
+                    worker: 0,
+                    line: format!("{} (unchanged)", self.tasks[index].outputs.join(" ")),
+                });
+                for &dependent in &dependents[index] {
+                    pending_dependencies[dependent] -= 1;
+                    if pending_dependencies[dependent] == 0 {
+                        ready_tasks.push(dependent);
+                    }
                 }
             }
+            if running_tasks == 0 {
+                break;
+            }
 
-            // Execute task
-            task.execute(log, task_counter, total_tasks, pretty_print);
-
-            // Mark task as done
-            {
-                let mut done_ids = done_task_ids.lock().expect("Could not lock mutex");
-                done_ids.push(task.id);
+            let (index, result) = done_receiver.recv().expect("Worker stopped");
+            running_tasks -= 1;
+            let Some((timing, changed)) = result else {
+                failed = true;
+                continue;
+            };
+            timings[index] = Some(timing);
+            outputs_changed[index] = changed;
+            for &dependent in &dependents[index] {
+                pending_dependencies[dependent] -= 1;
+                if pending_dependencies[dependent] == 0 && !failed {
+                    ready_tasks.push(dependent);
+                }
             }
-        });
+        }
+        pool.join();
+        self.timings = timings.into_iter().flatten().collect();
+        !failed
+    }
+
+    /// Write the timings of the executed tasks as a trace and print the critical path.
+    pub(crate) fn report_timings(&self, trace_path: &str) {
+        if let Err(err) = write_trace(trace_path, &self.timings) {
+            eprintln!("Can't write {trace_path} file: {err}");
+        }
+        print_timings(&self.timings, &self.dependencies);
+        println!("Timings trace written to {trace_path}");
+    }
+}
+
+// MARK: Slots
+/// Counting semaphore limiting how many tasks run at once.
+struct Slots {
+    free: Mutex<usize>,
+    released: Condvar,
+}
+
+struct SlotGuard<'a>(&'a Slots);
+
+impl Slots {
+    const fn new(count: usize) -> Self {
+        Self {
+            free: Mutex::new(count),
+            released: Condvar::new(),
+        }
+    }
+
+    fn acquire(&self) -> SlotGuard<'_> {
+        let mut free = self.free.lock().expect("Could not lock mutex");
+        while *free == 0 {
+            free = self.released.wait(free).expect("Could not lock mutex");
+        }
+        *free -= 1;
+        SlotGuard(self)
+    }
+}
+
+impl Drop for SlotGuard<'_> {
+    fn drop(&mut self) {
+        *self.0.free.lock().expect("Could not lock mutex") += 1;
+        self.0.released.notify_one();
+    }
+}
+
+/// Number of the pool worker running on the current thread.
+fn worker_id() -> usize {
+    static NEXT_WORKER: AtomicUsize = AtomicUsize::new(0);
+    thread_local! {
+        static WORKER: usize = NEXT_WORKER.fetch_add(1, Ordering::Relaxed);
     }
+    WORKER.with(|worker| *worker)
 }
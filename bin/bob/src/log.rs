@@ -4,6 +4,7 @@
  * SPDX-License-Identifier: MIT
  */
 
+use std::collections::HashMap;
 use std::fmt::{self, Display, Formatter};
 use std::fs::{File, OpenOptions};
 use std::io::{Read, Write};
@@ -11,9 +12,11 @@ use std::str::FromStr;
 use std::time::Duration;
 
 // MARK: LogEntry
+/// Modified time, size and content hash of a file, directories have no size and no hash.
 pub(crate) struct LogEntry {
     pub path: String,
     pub mtime: Duration,
+    pub size: Option<u64>,
     pub hash: Option<[u8; 20]>,
 }
 
@@ -21,7 +24,7 @@ impl FromStr for LogEntry {
     type Err = String;
     fn from_str(s: &str) -> Result<Self, Self::Err> {
         let parts: Vec<&str> = s.split(' ').collect();
-        if parts.len() != 3 && parts.len() != 4 {
+        if !(3..=5).contains(&parts.len()) {
             return Err("Invalid log entry format".to_string());
         }
 
@@ -34,8 +37,19 @@ impl FromStr for LogEntry {
             .parse::<u32>()
             .map_err(|_| "Invalid modified time".to_string())?;
 
-        let hash = if parts.len() == 4 {
-            let hash_str = parts[3];
+        // Older logs have no size field, a size never has the 40 digits of a hash
+        let (size, hash_str) = match parts[3..] {
+            [] => (None, None),
+            [hash_str] if hash_str.len() == 40 => (None, Some(hash_str)),
+            [size] => (Some(size), None),
+            [size, hash_str] => (Some(size), Some(hash_str)),
+            _ => unreachable!(),
+        };
+        let size = size
+            .map(|size| size.parse::<u64>().map_err(|_| "Invalid size".to_string()))
+            .transpose()?;
+
+        let hash = if let Some(hash_str) = hash_str {
             if hash_str.len() != 40 {
                 return Err("Invalid hash format".to_string());
             }
@@ -52,6 +66,7 @@ impl FromStr for LogEntry {
         Ok(LogEntry {
             path,
             mtime: Duration::new(mtime_secs, mtime_nanos),
+            size,
             hash,
         })
     }
@@ -66,6 +81,9 @@ impl Display for LogEntry {
             self.mtime.as_secs(),
             self.mtime.subsec_nanos()
         )?;
+        if let Some(size) = self.size {
+            write!(f, " {size}")?;
+        }
         if let Some(hash) = &self.hash {
             write!(f, " ")?;
             for byte in hash {
@@ -77,9 +95,19 @@ impl Display for LogEntry {
 }
 
 // MARK: Log
+/// The log is rewritten with only the live entries when it has this many times more lines.
+const COMPACT_FACTOR: usize = 2;
+/// Small logs are never compacted.
+const COMPACT_MIN_LINES: usize = 256;
+/// Lines starting with this character list the discovered dependencies of an output.
+const DEPS_PREFIX: char = '@';
+
 pub(crate) struct Log {
+    path: String,
     file: File,
-    entries: Vec<LogEntry>,
+    entries: HashMap<String, LogEntry>,
+    deps: HashMap<String, Vec<String>>,
+    lines: usize,
 }
 
 impl Log {
@@ -95,28 +123,102 @@ impl Log {
         file.read_to_string(&mut contents)
             .unwrap_or_else(|_| panic!("Can't read file: {path}"));
 
-        let entries = match contents
-            .lines()
-            .map(|line| line.parse::<LogEntry>())
-            .collect::<Result<Vec<_>, _>>()
-        {
-            Ok(entries) => entries,
-            Err(_) => {
-                // Truncate the file if corrupt and return empty log
-                file.set_len(0)
-                    .unwrap_or_else(|_| panic!("Can't truncate file: {path}"));
-                Vec::new()
+        // Later lines of a path replace the earlier ones
+        let mut entries = HashMap::new();
+        let mut deps = HashMap::new();
+        let mut lines = 0;
+        for line in contents.lines() {
+            if let Some(line) = line.strip_prefix(DEPS_PREFIX) {
+                let mut paths = line.split(' ').map(str::to_string);
+                if let Some(output) = paths.next() {
+                    deps.insert(output, paths.collect());
+                }
+                lines += 1;
+                continue;
+            }
+            match line.parse::<LogEntry>() {
+                Ok(entry) => {
+                    entries.insert(entry.path.clone(), entry);
+                    lines += 1;
+                }
+                Err(_) => {
+                    // Truncate the file if corrupt and return empty log
+                    file.set_len(0)
+                        .unwrap_or_else(|_| panic!("Can't truncate file: {path}"));
+                    entries.clear();
+                    deps.clear();
+                    lines = 0;
+                    break;
+                }
             }
+        }
+
+        let mut log = Log {
+            path: path.to_string(),
+            file,
+            entries,
+            deps,
+            lines,
         };
-        Log { file, entries }
+        if log.lines >= COMPACT_MIN_LINES && log.lines > COMPACT_FACTOR * log.live_lines() {
+            log.compact();
+        }
+        log
     }
 
     pub(crate) fn get(&self, path: &str) -> Option<&LogEntry> {
-        self.entries.iter().rev().find(|entry| entry.path == path)
+        self.entries.get(path)
     }
 
     pub(crate) fn add(&mut self, entry: LogEntry) {
         writeln!(self.file, "{entry}").unwrap_or_else(|_| panic!("Can't write to file"));
-        self.entries.push(entry);
+        self.entries.insert(entry.path.clone(), entry);
+        self.lines += 1;
+    }
+
+    /// Dependencies the compiler reported for an output on an earlier build.
+    pub(crate) fn deps(&self, output: &str) -> Option<&[String]> {
+        self.deps.get(output).map(Vec::as_slice)
+    }
+
+    pub(crate) fn add_deps(&mut self, output: String, deps: Vec<String>) {
+        if self.deps.get(&output) == Some(&deps) {
+            return;
+        }
+        writeln!(self.file, "{}", deps_line(&output, &deps))
+            .unwrap_or_else(|_| panic!("Can't write to file"));
+        self.deps.insert(output, deps);
+        self.lines += 1;
+    }
+
+    fn live_lines(&self) -> usize {
+        self.entries.len() + self.deps.len()
+    }
+
+    /// Rewrite the log with one line per path, so loading it stays proportional to the
+    /// number of live entries instead of the build history. A log left half written is
+    /// corrupt and is truncated on the next load, which only costs a full rebuild.
+    fn compact(&mut self) {
+        let mut contents = String::new();
+        for entry in self.entries.values() {
+            contents.push_str(&format!("{entry}\n"));
+        }
+        for (output, deps) in &self.deps {
+            contents.push_str(&format!("{}\n", deps_line(output, deps)));
+        }
+        self.file
+            .set_len(0)
+            .and_then(|_| self.file.write_all(contents.as_bytes()))
+            .unwrap_or_else(|_| panic!("Can't write file: {}", self.path));
+        self.lines = self.live_lines();
+    }
+}
+
+fn deps_line(output: &str, deps: &[String]) -> String {
+    let mut line = format!("{DEPS_PREFIX}{output}");
+    for dep in deps {
+        line.push(' ');
+        line.push_str(dep);
     }
+    line
 }
@@ -8,27 +8,34 @@
 
 use std::path::{Path, PathBuf};
 use std::process::exit;
-use std::time::Instant;
-use std::{env, fs};
+use std::time::{Duration, Instant};
+use std::{env, fs, thread};
 
-use crate::args::{Profile, Subcommand, parse_args, subcommand_help};
+use crate::args::{Args, Profile, Subcommand, parse_args, subcommand_help};
 use crate::bobje::Bobje;
-use crate::executor::ExecutorBuilder;
+use crate::executor::{ExecutorBuilder, file_stat};
+use crate::remote::{connect_workers, run_worker};
 use crate::tasks::android::{detect_android, run_android_apk};
 #[cfg(target_os = "macos")]
 use crate::tasks::bundle::{detect_bundle, run_bundle, sign_bundle};
-use crate::tasks::cx::{detect_cx, run_ld, run_ld_cunit_tests};
+use crate::tasks::cx::{detect_cx, run_ld, run_ld_bench, run_ld_cunit_tests};
 use crate::tasks::jvm::{detect_jar, detect_java_kotlin, run_jar, run_java_class, run_junit_tests};
-use crate::utils::{cache_dir, format_bytes, index_files};
+use crate::utils::{cache_dir, format_bytes, index_dirs, index_files};
 
 mod args;
 mod bobje;
 mod executor;
 mod log;
 mod manifest;
+mod object_cache;
+mod remote;
 mod tasks;
+mod timings;
 mod utils;
 
+/// How often `bob watch` checks the watched files for changes.
+const WATCH_POLL_INTERVAL: Duration = Duration::from_millis(200);
+
 // MARK: Subcommands
 fn print_dir_remove_stats(path: &str) {
     let files = index_files(path);
@@ -72,6 +79,149 @@ fn subcommand_version() {
     println!("bob v{}", env!("CARGO_PKG_VERSION"));
 }
 
+/// Run the build artifact, unit tests or benchmarks of the subcommand and return the exit code.
+fn run_artifact(args: &Args, bobje: &Bobje) -> i32 {
+    match args.subcommand {
+        Subcommand::Run => {
+            #[cfg(target_os = "macos")]
+            if detect_bundle(bobje) {
+                return run_bundle(bobje);
+            }
+            if detect_jar(bobje) {
+                return run_jar(bobje);
+            }
+            if detect_android(bobje) {
+                return run_android_apk(bobje);
+            }
+            if detect_cx(&bobje.source_files) {
+                return run_ld(bobje);
+            }
+            if detect_java_kotlin(&bobje.source_files) {
+                return run_java_class(bobje);
+            }
+            eprintln!("No build artifact to run");
+        }
+        Subcommand::Test => {
+            if detect_cx(&bobje.source_files) {
+                return run_ld_cunit_tests(bobje, args.thread_count, args.test_filter.as_deref());
+            }
+            if detect_java_kotlin(&bobje.source_files) {
+                return run_junit_tests(bobje);
+            }
+            eprintln!("No test artifact to run");
+        }
+        Subcommand::Bench => {
+            if detect_cx(&bobje.source_files) {
+                return run_ld_bench(bobje, args.save_baseline);
+            }
+            eprintln!("No benchmark artifact to run");
+        }
+        _ => {}
+    }
+    0
+}
+
+/// Create the main bobje of every target, their tasks are added to one executor so all
+/// targets build on the same thread pool. Tasks with the same outputs are added once.
+fn create_bobjes(args: &Args, executor: &mut ExecutorBuilder) -> Vec<Bobje> {
+    if args.targets.len() <= 1 {
+        return vec![Bobje::new(args, ".", executor, true, None)];
+    }
+    args.targets
+        .iter()
+        .map(|target| {
+            let target_args = Args {
+                target: Some(target.clone()),
+                ..args.clone()
+            };
+            let bobje = Bobje::new(&target_args, ".", executor, true, None);
+            executor.mark_root();
+            bobje
+        })
+        .collect()
+}
+
+/// Modified time and size of every file, a missing file has none.
+fn stat_files(paths: &[String]) -> Vec<Option<(Duration, Option<u64>)>> {
+    paths.iter().map(|path| file_stat(path)).collect()
+}
+
+/// Manifests and source directories of a bobje and its dependencies, adding or removing a
+/// source file changes the modified time of its directory.
+fn graph_files(bobje: &Bobje, files: &mut Vec<String>) {
+    let manifest_path = format!("{}/bob.toml", bobje.manifest_dir);
+    if Path::new(&manifest_path).exists() && !files.contains(&manifest_path) {
+        files.push(manifest_path);
+        let src_dir = format!("{}/src", bobje.manifest_dir);
+        if Path::new(&src_dir).is_dir() {
+            files.push(src_dir.clone());
+            files.extend(index_dirs(&src_dir));
+        }
+    }
+    for dependency in bobje.dependencies.values() {
+        graph_files(dependency, files);
+    }
+}
+
+/// Keep the task graph, the file hashes and the depfile dependencies in memory and rebuild
+/// the tasks affected by every change. The files are polled, which works the same on every
+/// platform and costs a stat per file. The task graph is only created again when a manifest
+/// changes or a source file is added or removed.
+fn subcommand_watch(args: &Args, remote_slots: usize) -> ! {
+    loop {
+        let mut executor = ExecutorBuilder::new();
+        let bobjes = create_bobjes(args, &mut executor);
+        let mut executor = executor.build(&format!("{}/bob.log", &args.target_dir));
+        let mut graph_paths = Vec::new();
+        for bobje in &bobjes {
+            graph_files(bobje, &mut graph_paths);
+        }
+        let graph_stats = stat_files(&graph_paths);
+
+        loop {
+            if executor.total_tasks() > 0 {
+                let start_time = Instant::now();
+                if executor.execute(args.verbose, args.thread_count, remote_slots) {
+                    #[cfg(target_os = "macos")]
+                    for bobje in bobjes.iter().filter(|bobje| detect_bundle(bobje)) {
+                        sign_bundle(bobje);
+                    }
+                    if args.show_time {
+                        println!(
+                            "[{}/{}] Execute time: {:.2?}",
+                            executor.total_tasks(),
+                            executor.total_tasks(),
+                            Instant::now().duration_since(start_time)
+                        );
+                    }
+                    run_artifact(args, &bobjes[0]);
+                }
+            }
+
+            // Wait until a watched file changes
+            let source_paths = executor.source_files();
+            let source_stats = stat_files(&source_paths);
+            println!("Watching {} files for changes...", source_paths.len());
+            let graph_changed = loop {
+                thread::sleep(WATCH_POLL_INTERVAL);
+                if stat_files(&graph_paths) != graph_stats {
+                    break true;
+                }
+                if stat_files(&source_paths) != source_stats {
+                    break false;
+                }
+            };
+
+            // Editors often write a file in multiple steps
+            thread::sleep(WATCH_POLL_INTERVAL);
+            if graph_changed {
+                break;
+            }
+            executor.plan();
+        }
+    }
+}
+
 // MARK: Main
 fn main() {
     #[cfg(windows)]
@@ -94,6 +244,19 @@ fn main() {
         subcommand_version();
         return;
     }
+    if args.subcommand == Subcommand::Worker {
+        run_worker(args.listen.as_deref());
+    }
+
+    if args.targets.len() > 1
+        && matches!(
+            args.subcommand,
+            Subcommand::Run | Subcommand::Test | Subcommand::Bench
+        )
+    {
+        eprintln!("Can't run the artifact of multiple targets, pass a single --target");
+        exit(1);
+    }
 
     // Find bob.toml and change directory to its location
     let mut bob_dir = PathBuf::from(&args.manifest_dir)
@@ -137,17 +300,26 @@ fn main() {
         fs::create_dir(&args.target_dir).expect("Failed to create target directory");
     }
 
+    // Keep rebuilding on changes
+    let remote_slots = connect_workers(&args.remote_workers);
+    if args.watch {
+        subcommand_watch(&args, remote_slots);
+    }
+
     // Build main bobje
     let mut executor = ExecutorBuilder::new();
-    let bobje = Bobje::new(&args, ".", &mut executor, true);
+    let bobjes = create_bobjes(&args, &mut executor);
     let mut executor = executor.build(&format!("{}/bob.log", &args.target_dir));
-
-    executor.execute(args.verbose, args.thread_count);
+    if !executor.execute(args.verbose, args.thread_count, remote_slots) {
+        exit(1);
+    }
 
     // Ad-hoc codesign the macOS bundle after it is (re)built
     #[cfg(target_os = "macos")]
-    if executor.total_tasks() > 0 && detect_bundle(&bobje) {
-        sign_bundle(&bobje);
+    if executor.total_tasks() > 0 {
+        for bobje in bobjes.iter().filter(|bobje| detect_bundle(bobje)) {
+            sign_bundle(bobje);
+        }
     }
 
     // Show time taken
@@ -160,35 +332,16 @@ fn main() {
         );
     }
 
-    // Run build artifact
-    if args.subcommand == Subcommand::Run {
-        #[cfg(target_os = "macos")]
-        if detect_bundle(&bobje) {
-            run_bundle(&bobje);
-        }
-        if detect_jar(&bobje) {
-            run_jar(&bobje);
-        }
-        if detect_android(&bobje) {
-            run_android_apk(&bobje);
-        }
-        if detect_cx(&bobje.source_files) {
-            run_ld(&bobje);
-        }
-        if detect_java_kotlin(&bobje.source_files) {
-            run_java_class(&bobje);
-        }
-        eprintln!("No build artifact to run");
+    // Show task timings
+    if executor.total_tasks() > 0 && args.timings {
+        executor.report_timings(&format!("{}/bob-timings.json", &args.target_dir));
     }
 
-    // Run unit tests
-    if args.subcommand == Subcommand::Test {
-        if detect_cx(&bobje.source_files) {
-            run_ld_cunit_tests(&bobje);
-        }
-        if detect_java_kotlin(&bobje.source_files) {
-            run_junit_tests(&bobje);
-        }
-        eprintln!("No test artifact to run");
+    // Run build artifact, unit tests or benchmarks
+    if matches!(
+        args.subcommand,
+        Subcommand::Run | Subcommand::Test | Subcommand::Bench
+    ) {
+        exit(run_artifact(&args, &bobjes[0]));
     }
 }
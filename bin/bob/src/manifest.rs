@@ -15,6 +15,7 @@ pub(crate) struct Manifest {
     #[serde(rename = "lib")]
     pub library: Option<Library>,
     pub build: Build,
+    pub profile: Profiles,
     pub dependencies: HashMap<String, Dependency>,
 }
 
@@ -137,6 +138,13 @@ pub(crate) struct Build {
     pub ldflags: String,
     pub target: Option<String>,
     pub entry: Option<String>,
+    pub pch: Option<String>,
+    #[serde(rename = "cpp-std")]
+    pub cpp_std: Option<String>,
+    pub unity: Option<Unity>,
+    pub linker: Option<String>,
+    #[serde(rename = "split-debuginfo")]
+    pub split_debuginfo: Option<bool>,
     pub javac_flags: String,
     pub kotlinc_flags: String,
     pub classpath: Vec<String>,
@@ -159,6 +167,21 @@ impl Build {
         if other_build.entry.is_some() {
             self.entry = other_build.entry;
         }
+        if other_build.pch.is_some() {
+            self.pch = other_build.pch;
+        }
+        if other_build.cpp_std.is_some() {
+            self.cpp_std = other_build.cpp_std;
+        }
+        if other_build.unity.is_some() {
+            self.unity = other_build.unity;
+        }
+        if other_build.linker.is_some() {
+            self.linker = other_build.linker;
+        }
+        if other_build.split_debuginfo.is_some() {
+            self.split_debuginfo = other_build.split_debuginfo;
+        }
         if !other_build.javac_flags.is_empty() {
             self.javac_flags = other_build.javac_flags;
         }
@@ -171,6 +194,45 @@ impl Build {
     }
 }
 
+#[derive(Clone, Deserialize)]
+pub(crate) struct Unity {
+    pub batch: usize,
+}
+
+// MARK: Profiles
+#[derive(Default, Clone, Deserialize)]
+#[serde(default)]
+pub(crate) struct Profiles {
+    pub debug: ProfileConfig,
+    pub release: ProfileConfig,
+    pub test: ProfileConfig,
+}
+
+/// Code generation settings of a profile, unset fields keep the profile defaults.
+#[derive(Default, Clone, Deserialize)]
+#[serde(default, rename_all = "kebab-case")]
+pub(crate) struct ProfileConfig {
+    pub opt_level: Option<OptLevel>,
+    pub lto: Option<Lto>,
+    pub codegen_units: Option<usize>,
+    pub debug: Option<bool>,
+    pub target_cpu: Option<String>,
+}
+
+#[derive(Clone, Deserialize)]
+#[serde(untagged)]
+pub(crate) enum OptLevel {
+    Level(u8),
+    Name(String),
+}
+
+#[derive(Clone, Deserialize)]
+#[serde(untagged)]
+pub(crate) enum Lto {
+    Enabled(bool),
+    Kind(String),
+}
+
 // MARK: Dependencies
 #[derive(Clone, Deserialize)]
 #[serde(untagged)]
@@ -185,6 +247,13 @@ pub(crate) enum Dependency {
         #[serde(rename = "pkg-config")]
         pkg_config: String,
     },
+    /// C source like the SQLite amalgamation, compiled with the defines into a static library.
+    Bundled {
+        bundled: String,
+        include: Option<String>,
+        #[serde(default)]
+        defines: Vec<String>,
+    },
     Framework {
         framework: String,
     },
@@ -0,0 +1,102 @@
+/*
+ * Copyright (c) 2025 Bastiaan van der Plaat
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+use std::collections::HashMap;
+use std::fmt::Write;
+use std::path::Path;
+use std::process::{self, Stdio};
+use std::sync::{Mutex, OnceLock};
+use std::{env, fs};
+
+use sha1::Sha1;
+
+use crate::utils::shell_command;
+
+// MARK: Compiler identity
+/// Version output of a compiler, asked once per run, so a compiler upgrade changes every key.
+fn compiler_identity(compiler: &str) -> String {
+    static IDENTITIES: OnceLock<Mutex<HashMap<String, String>>> = OnceLock::new();
+    let identities = IDENTITIES.get_or_init(Default::default);
+    if let Some(identity) = identities
+        .lock()
+        .expect("Could not lock mutex")
+        .get(compiler)
+    {
+        return identity.clone();
+    }
+
+    let identity = shell_command(&format!("{compiler} --version"))
+        .stderr(Stdio::null())
+        .output()
+        .map(|output| String::from_utf8_lossy(&output.stdout).to_string())
+        .unwrap_or_default();
+    identities
+        .lock()
+        .expect("Could not lock mutex")
+        .insert(compiler.to_string(), identity.clone());
+    identity
+}
+
+// MARK: Object cache
+/// Key of the object a compile command produces, the hash of the compiler identity, the command
+/// line with all flags and the preprocessed source. A `key_command` without paths replaces the
+/// command, except with debug info: that holds the working directory and the source path, so
+/// then the real command and the working directory are part of the key.
+pub(crate) fn object_cache_key(
+    command: &str,
+    key_command: Option<&str>,
+    preprocessed: &[u8],
+) -> String {
+    let debug_info = command
+        .split(' ')
+        .any(|flag| flag.starts_with("-g") && flag != "-g0");
+    let key_command = key_command.filter(|_| !debug_info).unwrap_or(command);
+    let compiler = key_command.split(' ').next().unwrap_or_default();
+    let mut hasher = Sha1::new();
+    hasher.update(compiler_identity(compiler));
+    hasher.update([0]);
+    hasher.update(key_command);
+    hasher.update([0]);
+    if debug_info && let Ok(cwd) = env::current_dir() {
+        hasher.update(cwd.as_os_str().as_encoded_bytes());
+    }
+    hasher.update([0]);
+    hasher.update(preprocessed);
+    let mut key = String::new();
+    for byte in hasher.finalize() {
+        _ = write!(key, "{byte:02x}");
+    }
+    key
+}
+
+fn cached_object_path(cache_dir: &str, key: &str) -> String {
+    format!("{}/{}/{}.o", cache_dir, &key[..2], key)
+}
+
+/// Link or copy a cached object to the object path, returns false on a cache miss.
+pub(crate) fn restore_object(cache_dir: &str, key: &str, object_file: &str) -> bool {
+    let cached_object = cached_object_path(cache_dir, key);
+    if !Path::new(&cached_object).exists() {
+        return false;
+    }
+    _ = fs::remove_file(object_file);
+    fs::hard_link(&cached_object, object_file).is_ok()
+        || fs::copy(&cached_object, object_file).is_ok()
+}
+
+/// Store a compiled object in the cache, a failure only costs a future cache hit. The object is
+/// copied to a temporary file first, so other builds sharing the cache never see half an object.
+pub(crate) fn store_object(cache_dir: &str, key: &str, object_file: &str) {
+    let cached_object = cached_object_path(cache_dir, key);
+    let temp_object = format!("{cached_object}.{}.tmp", process::id());
+    if let Some(parent) = Path::new(&cached_object).parent()
+        && fs::create_dir_all(parent).is_ok()
+        && fs::copy(object_file, &temp_object).is_ok()
+        && fs::rename(&temp_object, &cached_object).is_err()
+    {
+        _ = fs::remove_file(&temp_object);
+    }
+}
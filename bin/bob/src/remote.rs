@@ -0,0 +1,255 @@
+/*
+ * Copyright (c) 2025 Bastiaan van der Plaat
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+use std::io::{self, BufRead, BufReader, Write};
+use std::net::{TcpListener, TcpStream, ToSocketAddrs};
+use std::process::{Command, Stdio, exit};
+use std::sync::atomic::{AtomicUsize, Ordering};
+use std::sync::{Mutex, OnceLock};
+use std::time::Duration;
+use std::{env, fs, process, thread};
+
+use threadpool::ThreadPool;
+
+pub(crate) const DEFAULT_WORKER_PORT: u16 = 7070;
+const CONNECT_TIMEOUT: Duration = Duration::from_secs(1);
+/// Flags a worker refuses, they can write files or load code on the worker.
+const REFUSED_FLAGS: [&str; 10] = [
+    "-o",
+    "-fplugin",
+    "-specs",
+    "-B",
+    "-wrapper",
+    "-M",
+    "@",
+    "-save-temps",
+    "-fdump-",
+    "-fprofile-",
+];
+
+// MARK: Workers
+struct Workers {
+    addrs: Vec<String>,
+    /// Worker index of every free remote slot.
+    free_slots: Mutex<Vec<usize>>,
+}
+
+static WORKERS: OnceLock<Workers> = OnceLock::new();
+
+fn with_default_port(addr: &str) -> String {
+    if addr.contains(':') {
+        addr.to_string()
+    } else {
+        format!("{addr}:{DEFAULT_WORKER_PORT}")
+    }
+}
+
+fn connect(addr: &str) -> io::Result<TcpStream> {
+    let socket_addr = addr
+        .to_socket_addrs()?
+        .next()
+        .ok_or_else(|| io::Error::new(io::ErrorKind::NotFound, "Unknown host"))?;
+    TcpStream::connect_timeout(&socket_addr, CONNECT_TIMEOUT)
+}
+
+/// Ask every worker for its number of slots, unreachable workers are skipped. Returns the
+/// total number of remote slots, the executor runs that many extra tasks at once.
+pub(crate) fn connect_workers(addrs: &[String]) -> usize {
+    let mut workers = Workers {
+        addrs: Vec::new(),
+        free_slots: Mutex::new(Vec::new()),
+    };
+    let free_slots = workers.free_slots.get_mut().expect("Could not lock mutex");
+    for addr in addrs.iter().map(|addr| with_default_port(addr)) {
+        let slots = connect(&addr).and_then(|mut stream| {
+            stream.write_all(b"slots\n")?;
+            read_line(&mut BufReader::new(stream))?
+                .parse::<usize>()
+                .map_err(|_| io::Error::new(io::ErrorKind::InvalidData, "Invalid slots"))
+        });
+        match slots {
+            Ok(slots) => {
+                free_slots.extend(std::iter::repeat_n(workers.addrs.len(), slots));
+                workers.addrs.push(addr);
+            }
+            Err(err) => eprintln!("Can't reach remote worker {addr}: {err}"),
+        }
+    }
+    let total_slots = free_slots.len();
+    _ = WORKERS.set(workers);
+    total_slots
+}
+
+/// A claimed slot on a remote worker, it is freed again when dropped.
+pub(crate) struct RemoteSlot {
+    worker: usize,
+}
+
+impl RemoteSlot {
+    /// Claim a free remote slot, None when all are busy or there are no workers.
+    pub(crate) fn acquire() -> Option<Self> {
+        let workers = WORKERS.get()?;
+        let worker = workers
+            .free_slots
+            .lock()
+            .expect("Could not lock mutex")
+            .pop()?;
+        Some(Self { worker })
+    }
+
+    pub(crate) fn addr(&self) -> &str {
+        &WORKERS.get().expect("Workers are connected").addrs[self.worker]
+    }
+
+    /// Compile a preprocessed source on the worker and write the object, returns false when
+    /// the worker can't be reached or the compile fails, the caller then compiles locally.
+    pub(crate) fn compile(&self, command: &str, preprocessed: &[u8], object_file: &str) -> bool {
+        let object = (|| {
+            let mut stream = connect(self.addr())?;
+            stream.write_all(format!("compile\n{command}\n{}\n", preprocessed.len()).as_bytes())?;
+            stream.write_all(preprocessed)?;
+
+            let mut reader = BufReader::new(stream);
+            let success = read_line(&mut reader)? == "0";
+            let stderr = read_block(&mut reader)?;
+            let object = read_block(&mut reader)?;
+            if success && !stderr.is_empty() {
+                _ = io::stderr().write_all(&stderr);
+            }
+            Ok::<_, io::Error>(success.then_some(object))
+        })();
+        matches!(object, Ok(Some(object)) if fs::write(object_file, &object).is_ok())
+    }
+}
+
+impl Drop for RemoteSlot {
+    fn drop(&mut self) {
+        if let Some(workers) = WORKERS.get() {
+            workers
+                .free_slots
+                .lock()
+                .expect("Could not lock mutex")
+                .push(self.worker);
+        }
+    }
+}
+
+// MARK: Protocol
+fn read_line(reader: &mut impl BufRead) -> io::Result<String> {
+    let mut line = String::new();
+    reader.read_line(&mut line)?;
+    Ok(line.trim_end().to_string())
+}
+
+/// A decimal length line followed by that many bytes.
+fn read_block(reader: &mut impl BufRead) -> io::Result<Vec<u8>> {
+    let len = read_line(reader)?
+        .parse::<usize>()
+        .map_err(|_| io::Error::new(io::ErrorKind::InvalidData, "Invalid length"))?;
+    let mut block = vec![0; len];
+    reader.read_exact(&mut block)?;
+    Ok(block)
+}
+
+fn write_block(stream: &mut impl Write, block: &[u8]) -> io::Result<()> {
+    stream.write_all(format!("{}\n", block.len()).as_bytes())?;
+    stream.write_all(block)
+}
+
+// MARK: Worker
+/// Run the `bob worker` daemon, it compiles one source per slot at a time. A worker receives
+/// preprocessed sources and compile flags, so it needs the same compiler but none of the
+/// headers. It runs the flags it is sent, so only run it on a trusted network.
+pub(crate) fn run_worker(listen: Option<&str>) -> ! {
+    let listen = listen.map_or_else(
+        || format!("0.0.0.0:{DEFAULT_WORKER_PORT}"),
+        with_default_port,
+    );
+    let listener = TcpListener::bind(&listen).unwrap_or_else(|err| {
+        eprintln!("Can't listen on {listen}: {err}");
+        exit(1);
+    });
+    let slots = thread::available_parallelism().map_or(1, |n| n.get());
+    println!("bob worker listening on {listen} with {slots} slots");
+
+    let pool = ThreadPool::new(slots);
+    for stream in listener.incoming().flatten() {
+        pool.execute(move || {
+            if let Err(err) = handle_connection(stream, slots) {
+                eprintln!("Remote compile failed: {err}");
+            }
+        });
+    }
+    exit(0);
+}
+
+fn handle_connection(mut stream: TcpStream, slots: usize) -> io::Result<()> {
+    let mut reader = BufReader::new(stream.try_clone()?);
+    match read_line(&mut reader)?.as_str() {
+        "slots" => stream.write_all(format!("{slots}\n").as_bytes()),
+        "compile" => {
+            let command = read_line(&mut reader)?;
+            let source = read_block(&mut reader)?;
+            let (success, stderr, object) = compile(&command, &source)?;
+            stream.write_all(if success { b"0\n" } else { b"1\n" })?;
+            write_block(&mut stream, &stderr)?;
+            write_block(&mut stream, &object)
+        }
+        _ => Err(io::Error::new(
+            io::ErrorKind::InvalidData,
+            "Unknown request",
+        )),
+    }
+}
+
+fn compile(command: &str, source: &[u8]) -> io::Result<(bool, Vec<u8>, Vec<u8>)> {
+    let mut parts = command.split(' ').filter(|part| !part.is_empty());
+    let compiler = parts.next().unwrap_or_default();
+    let args = parts.collect::<Vec<_>>();
+    let is_compiler = ["cc", "c++", "gcc", "g++", "clang", "clang++"]
+        .iter()
+        .any(|name| compiler == *name || compiler.ends_with(&format!("-{name}")));
+    if !is_compiler
+        || args
+            .iter()
+            .any(|arg| REFUSED_FLAGS.iter().any(|refused| arg.starts_with(refused)))
+    {
+        return Ok((
+            false,
+            b"Refused remote compile command\n".to_vec(),
+            Vec::new(),
+        ));
+    }
+
+    static COUNTER: AtomicUsize = AtomicUsize::new(0);
+    let object_file = env::temp_dir().join(format!(
+        "bob-worker-{}-{}.o",
+        process::id(),
+        COUNTER.fetch_add(1, Ordering::Relaxed)
+    ));
+    let mut child = Command::new(compiler)
+        .args(&args)
+        .arg("-")
+        .arg("-o")
+        .arg(&object_file)
+        .stdin(Stdio::piped())
+        .stdout(Stdio::null())
+        .stderr(Stdio::piped())
+        .spawn()?;
+    let mut stdin = child.stdin.take().expect("Stdin is piped");
+    let source = source.to_vec();
+    let writer = thread::spawn(move || stdin.write_all(&source));
+    let output = child.wait_with_output()?;
+    _ = writer.join();
+
+    let object = if output.status.success() {
+        fs::read(&object_file)?
+    } else {
+        Vec::new()
+    };
+    _ = fs::remove_file(&object_file);
+    Ok((output.status.success(), output.stderr, object))
+}
@@ -500,7 +500,7 @@ pub(crate) fn generate_android_final_apk_tasks(bobje: &Bobje, executor: &mut Exe
     );
 }
 
-pub(crate) fn run_android_apk(bobje: &Bobje) -> ! {
+pub(crate) fn run_android_apk(bobje: &Bobje) -> i32 {
     let vars = AndroidVars::new(bobje);
 
     // Try to install the APK
@@ -538,10 +538,10 @@ pub(crate) fn run_android_apk(bobje: &Bobje) -> ! {
                 .status()
                 .expect("Failed to execute adb");
             if !status.success() {
-                exit(status.code().unwrap_or(1));
+                return status.code().unwrap_or(1);
             }
         } else {
-            exit(output.status.code().unwrap_or(1));
+            return output.status.code().unwrap_or(1);
         }
     }
 
@@ -558,7 +558,7 @@ pub(crate) fn run_android_apk(bobje: &Bobje) -> ! {
         .status()
         .expect("Failed to execute adb");
     if !status.success() {
-        exit(status.code().unwrap_or(1));
+        return status.code().unwrap_or(1);
     }
 
     // Clear logcat logs
@@ -568,7 +568,7 @@ pub(crate) fn run_android_apk(bobje: &Bobje) -> ! {
         .status()
         .expect("Failed to execute adb logcat");
     if !status.success() {
-        exit(status.code().unwrap_or(1));
+        return status.code().unwrap_or(1);
     }
 
     // Start logcat with app filter
@@ -577,7 +577,7 @@ pub(crate) fn run_android_apk(bobje: &Bobje) -> ! {
         .arg(format!("{}:* *:S", bobje.name))
         .status()
         .expect("Failed to execute adb logcat");
-    exit(status.code().unwrap_or(1))
+    status.code().unwrap_or(1)
 }
 
 // MARK: Utils
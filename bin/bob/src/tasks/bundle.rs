@@ -214,7 +214,7 @@ pub(crate) fn generate_bundle_tasks(bobje: &Bobje, executor: &mut ExecutorBuilde
     );
 }
 
-pub(crate) fn run_bundle(bobje: &Bobje) -> ! {
+pub(crate) fn run_bundle(bobje: &Bobje) -> i32 {
     let status = Command::new(format!(
         "{}/{}.app/Contents/MacOS/{}",
         bobje.out_dir(),
@@ -223,7 +223,7 @@ pub(crate) fn run_bundle(bobje: &Bobje) -> ! {
     ))
     .status()
     .expect("Failed to execute executable");
-    exit(status.code().unwrap_or(1))
+    status.code().unwrap_or(1)
 }
 
 #[cfg(target_os = "macos")]
@@ -4,18 +4,24 @@
  * SPDX-License-Identifier: MIT
  */
 
-use std::collections::HashSet;
+use std::collections::{HashMap, HashSet};
 use std::fmt::Write;
 use std::fs::{self};
+use std::io::{self, Write as _};
+use std::path::{self, Component, Path};
 use std::process::{Command, exit};
+use std::sync::atomic::{AtomicUsize, Ordering};
+use std::sync::Mutex;
+use std::time::SystemTime;
+use std::{env, thread};
 
 use regex::{Regex, regex};
 
-use crate::args::Profile;
+use crate::args::{Pgo, Profile};
 use crate::bobje::{Bobje, PackageType};
-use crate::executor::ExecutorBuilder;
-use crate::manifest::{Dependency, LibraryType};
-use crate::utils::write_file_when_different;
+use crate::executor::{ExecutorBuilder, TaskAction};
+use crate::manifest::{Dependency, LibraryType, Lto, OptLevel};
+use crate::utils::{cache_dir, write_bytes_when_different, write_file_when_different};
 
 // MARK: Constants
 const DYLIB_EXT: &str = if cfg!(target_os = "macos") {
@@ -26,11 +32,15 @@ const DYLIB_EXT: &str = if cfg!(target_os = "macos") {
     "so"
 };
 const EXECUTABLE_EXT: &str = if cfg!(windows) { ".exe" } else { "" };
+const USE_LLVM: bool = cfg!(any(target_os = "macos", windows));
 
 // MARK: Cx vars
-struct CxVars {
+#[derive(Clone)]
+pub(crate) struct CxVars {
+    use_llvm: bool,
     asflags: String,
     cflags: String,
+    bundled_cflags: String,
     ldflags: String,
     libs: String,
     cc: String,
@@ -41,8 +51,14 @@ struct CxVars {
 }
 
 impl CxVars {
+    /// Compiler and linker variables of a bobje, they are created once per bobje because
+    /// every kind of task needs them and creating them runs the toolchain probes.
+    fn get(bobje: &Bobje) -> &Self {
+        bobje.cx_vars.get_or_init(|| Self::new(bobje))
+    }
+
     fn new(bobje: &Bobje) -> Self {
-        let use_llvm = cfg!(any(target_os = "macos", windows));
+        let use_llvm = USE_LLVM;
 
         // Asflags
         let mut asflags = if !bobje.manifest.build.asflags.is_empty() {
@@ -54,15 +70,105 @@ impl CxVars {
             asflags.push_str(&format!(" --target={target}"));
         }
 
+        // Profile flags, the code generation ones are passed to the linker as well for LTO
+        let config = &bobje.profile_config;
+        let mut codegen_flags = Vec::new();
+        let opt_level = match &config.opt_level {
+            Some(OptLevel::Level(level @ 0..=3)) => Some(level.to_string()),
+            Some(OptLevel::Name(name)) if name == "s" || name == "z" => Some(name.clone()),
+            Some(_) => {
+                eprintln!("Invalid opt-level, expected 0, 1, 2, 3, \"s\" or \"z\"");
+                exit(1);
+            }
+            None if matches!(bobje.profile, Profile::Release | Profile::Bench) => {
+                Some("s".to_string())
+            }
+            None => None,
+        };
+        if let Some(opt_level) = opt_level {
+            codegen_flags.push(format!("-O{opt_level}"));
+        }
+        if let Some(target_cpu) = &config.target_cpu {
+            codegen_flags.push(format!("-march={target_cpu}"));
+        }
+        let lto = match &config.lto {
+            None | Some(Lto::Enabled(false)) => false,
+            Some(Lto::Enabled(true)) => {
+                codegen_flags.push("-flto".to_string());
+                true
+            }
+            Some(Lto::Kind(kind)) if kind == "off" => false,
+            Some(Lto::Kind(kind)) if kind == "thin" || kind == "full" => {
+                // GCC has no thin LTO, it partitions the link over all cores instead
+                codegen_flags.push(if !use_llvm {
+                    "-flto=auto".to_string()
+                } else if kind == "thin" {
+                    "-flto=thin".to_string()
+                } else {
+                    "-flto".to_string()
+                });
+                true
+            }
+            Some(Lto::Kind(kind)) => {
+                eprintln!(
+                    "Invalid lto '{kind}', expected true, false, \"thin\", \"full\" or \"off\""
+                );
+                exit(1);
+            }
+        };
+
+        // Bundled sources get only the code generation flags, no warnings, split debug info or
+        // profile data, so their objects can always be cached
+        let mut bundled_flags = codegen_flags.clone();
+        if has_debug_info(bobje) {
+            bundled_flags.push("-g".to_string());
+        }
+        if use_llvm && let Some(target) = &bobje.target {
+            bundled_flags.push(format!("--target={target}"));
+        }
+        let bundled_cflags = bundled_flags.join(" ");
+
         // Cflags
-        let mut cflags = match bobje.profile {
-            Profile::Debug => "-g -DDEBUG".to_string(),
-            Profile::Release => "-Os -DRELEASE".to_string(),
-            Profile::Test => "-g -DDEBUG -DTEST".to_string(),
+        let mut profile_flags = codegen_flags.clone();
+        if has_debug_info(bobje) {
+            profile_flags.push("-g".to_string());
+        }
+        // Split DWARF keeps most debug info out of the objects the linker has to copy
+        if uses_split_dwarf(bobje) {
+            profile_flags.push("-gsplit-dwarf -ggnu-pubnames".to_string());
+        }
+        profile_flags.push(match bobje.profile {
+            Profile::Debug => "-DDEBUG".to_string(),
+            Profile::Release => "-DRELEASE".to_string(),
+            Profile::Test => "-DDEBUG -DTEST".to_string(),
+            Profile::Bench => "-DRELEASE -DBENCH".to_string(),
+        });
+
+        // Profile guided optimization, the instrumented build writes profiles when it runs
+        let pgo_flags = match bobje.pgo {
+            Some(Pgo::Generate) if use_llvm => format!(
+                "-fprofile-instr-generate={}/%m.profraw",
+                path::absolute(get_pgo_profraw_dir(bobje))
+                    .expect("Can't get absolute path")
+                    .display()
+            ),
+            Some(Pgo::Generate) => "-fprofile-generate".to_string(),
+            Some(Pgo::Use) if use_llvm => format!(
+                "-fprofile-instr-use={} -Wno-profile-instr-out-of-date -Wno-profile-instr-unprofiled",
+                get_pgo_profdata_path(bobje)
+            ),
+            Some(Pgo::Use) => {
+                "-fprofile-use -Wno-missing-profile -Wno-error=coverage-mismatch".to_string()
+            }
+            None => String::new(),
         };
+        if !pgo_flags.is_empty() {
+            profile_flags.push(pgo_flags.clone());
+        }
+        let mut cflags = profile_flags.join(" ");
         cflags.push_str(&format!(
             " -Wall -Wextra -Wpedantic -Werror -I{}/include",
-            bobje.out_dir_with_target()
+            bobje.out_dir()
         ));
         if use_llvm && let Some(target) = &bobje.target {
             cflags.push_str(&format!(" --target={target}"));
@@ -72,8 +178,23 @@ impl CxVars {
             cflags.push_str(&bobje.manifest.build.cflags);
         }
         for dep in bobje.manifest.dependencies.values() {
-            if let Dependency::PkgConfig { pkg_config } = &dep {
-                cflags.push_str(&format!(" {}", pkg_config_cflags(pkg_config)));
+            if let Dependency::PkgConfig {
+                pkg_config: package,
+            } = &dep
+            {
+                cflags.push_str(&format!(" {}", pkg_config(bobje, "--cflags", package)));
+            }
+            if let Dependency::Bundled {
+                bundled, include, ..
+            } = &dep
+            {
+                let include = include.clone().unwrap_or_else(|| {
+                    Path::new(bundled)
+                        .parent()
+                        .map(|parent| parent.display().to_string())
+                        .unwrap_or_default()
+                });
+                cflags.push_str(&format!(" -isystem {}/{include}", bobje.manifest_dir));
             }
         }
 
@@ -89,25 +210,28 @@ impl CxVars {
                 ldflags.push_str(" -nostartfiles");
             }
         }
+        // The macOS linker is called directly and optimizes LTO objects on its own
+        if lto && !cfg!(target_os = "macos") {
+            ldflags.push_str(&format!(" {}", codegen_flags.join(" ")));
+        }
+        if bobje.pgo == Some(Pgo::Generate) && !cfg!(target_os = "macos") {
+            ldflags.push_str(&format!(" {pgo_flags}"));
+        }
 
         // Libs
         let mut libs = format!("-L{}", bobje.out_dir_with_target());
         if cfg!(target_os = "macos") {
-            let sdk_path = Command::new("xcrun")
-                .arg("-sdk")
-                .arg("macosx")
-                .arg("--show-sdk-path")
-                .output()
-                .map(|output| {
-                    if output.status.success() {
-                        String::from_utf8_lossy(&output.stdout).trim().to_string()
-                    } else {
-                        panic!("Can't find macOS SDK path");
-                    }
-                })
-                .unwrap_or_default();
+            let sdk_path = probe(bobje, "xcrun", &["-sdk", "macosx", "--show-sdk-path"])
+                .unwrap_or_else(|_| panic!("Can't find macOS SDK path"));
             libs.push_str(&format!(" -syslibroot {sdk_path}"));
 
+            // The linker is called directly, so link the profile runtime of clang by hand
+            if bobje.pgo == Some(Pgo::Generate) {
+                let runtime_dir =
+                    probe(bobje, "clang", &["--print-runtime-dir"]).unwrap_or_default();
+                libs.push_str(&format!(" {runtime_dir}/libclang_rt.profile_osx.a"));
+            }
+
             for dep in bobje.manifest.dependencies.values() {
                 if let Dependency::Framework { framework } = &dep {
                     libs.push_str(&format!(" -framework {framework}"));
@@ -119,13 +243,16 @@ impl CxVars {
             if let Dependency::Library { library } = &dep {
                 libs.push_str(&format!(" -l{library}"));
             }
-            if let Dependency::PkgConfig { pkg_config } = &dep {
-                libs.push_str(&format!(" {}", pkg_config_libs(pkg_config)));
+            if let Dependency::PkgConfig {
+                pkg_config: package,
+            } = &dep
+            {
+                libs.push_str(&format!(" {}", pkg_config(bobje, "--libs", package)));
             }
         }
 
         // Find correct toolchain
-        let (cc, cxx, ld, ar, strip) = if use_llvm {
+        let (cc, cxx, ld, mut ar, strip) = if use_llvm {
             (
                 "clang".to_string(),
                 "clang++".to_string(),
@@ -163,10 +290,27 @@ impl CxVars {
                 "strip".to_string(),
             )
         };
+        if let Some(linker) = get_linker(bobje, &cc, use_llvm, lto) {
+            ldflags.push_str(&format!(" -fuse-ld={linker}"));
+            if uses_split_dwarf(bobje) {
+                ldflags.push_str(" -Wl,--gdb-index");
+            }
+        }
+
+        // Static libraries of LTO objects need an archiver with the compiler's LTO plugin
+        if lto {
+            ar = if use_llvm {
+                "llvm-ar".to_string()
+            } else {
+                format!("{}gcc-ar", ar.strip_suffix("ar").unwrap_or_default())
+            };
+        }
 
         Self {
+            use_llvm,
             asflags,
             cflags,
+            bundled_cflags,
             ldflags,
             libs,
             cc,
@@ -178,7 +322,56 @@ impl CxVars {
     }
 }
 
+fn has_debug_info(bobje: &Bobje) -> bool {
+    bobje
+        .profile_config
+        .debug
+        .unwrap_or(!matches!(bobje.profile, Profile::Release | Profile::Bench))
+}
+
+/// Whether debug info is split into `.dwo` files next to the objects, the macOS linker
+/// leaves debug info in the objects already.
+fn uses_split_dwarf(bobje: &Bobje) -> bool {
+    !cfg!(target_os = "macos")
+        && bobje.manifest.build.split_debuginfo == Some(true)
+        && has_debug_info(bobje)
+}
+
+/// Linker passed to the compiler driver with `-fuse-ld`, None for its default linker. Without
+/// `build.linker` the fastest linker found is used on Linux.
+fn get_linker(bobje: &Bobje, cc: &str, use_llvm: bool, lto: bool) -> Option<&'static str> {
+    if cfg!(target_os = "macos") {
+        return None;
+    }
+    match bobje.manifest.build.linker.as_deref() {
+        Some("mold") => Some("mold"),
+        Some("lld") => Some("lld"),
+        Some("default") => None,
+        Some(linker) => {
+            eprintln!("Invalid linker '{linker}', expected \"mold\", \"lld\" or \"default\"");
+            exit(1);
+        }
+        None if cfg!(target_os = "linux") => detect_linker(bobje, cc, use_llvm, lto),
+        None => None,
+    }
+}
+
+/// First linker found that the compiler can drive, older compilers don't know every linker,
+/// GCC supports mold since 12.1. lld can't load the LTO plugin of GCC.
+fn detect_linker(bobje: &Bobje, cc: &str, use_llvm: bool, lto: bool) -> Option<&'static str> {
+    let path = env::var_os("PATH").unwrap_or_default();
+    [("mold", "mold"), ("lld", "ld.lld")]
+        .into_iter()
+        .filter(|(linker, _)| *linker != "lld" || use_llvm || !lto)
+        .filter(|(_, program)| env::split_paths(&path).any(|dir| dir.join(program).is_file()))
+        .find(|(linker, _)| {
+            probe(bobje, cc, &[&format!("-fuse-ld={linker}"), "-Wl,--version"]).is_ok()
+        })
+        .map(|(linker, _)| linker)
+}
+
 // MARK: Copy headers
+/// Copy the headers to the include directory, which all targets share.
 pub(crate) fn copy_cx_headers(bobje: &Bobje, _executor: &mut ExecutorBuilder) {
     for source_file in &bobje.source_files {
         if source_file.ends_with(".h")
@@ -187,7 +380,7 @@ pub(crate) fn copy_cx_headers(bobje: &Bobje, _executor: &mut ExecutorBuilder) {
         {
             let dest = format!(
                 "{}/include/{}/{}",
-                bobje.out_dir_with_target(),
+                bobje.out_dir(),
                 bobje.name,
                 source_file
                     .split("src/")
@@ -195,9 +388,8 @@ pub(crate) fn copy_cx_headers(bobje: &Bobje, _executor: &mut ExecutorBuilder) {
                     .or_else(|| source_file.split("src-gen/").nth(1))
                     .expect("Should be some")
             );
-            fs::create_dir_all(dest.rsplit_once('/').expect("Should be some").0)
-                .expect("Failed to create include directory");
-            fs::copy(source_file, dest).expect("Failed to copy header file");
+            let contents = fs::read(source_file).expect("Failed to read header file");
+            write_bytes_when_different(&dest, &contents).expect("Failed to copy header file");
         }
     }
 }
@@ -210,7 +402,7 @@ pub(crate) fn detect_asm(source_files: &[String]) -> bool {
 }
 
 pub(crate) fn generate_asm_tasks(bobje: &Bobje, executor: &mut ExecutorBuilder) {
-    let vars = CxVars::new(bobje);
+    let vars = CxVars::get(bobje);
     let asm_source_files = bobje
         .source_files
         .iter()
@@ -234,22 +426,19 @@ pub(crate) fn detect_c(source_files: &[String]) -> bool {
 }
 
 pub(crate) fn generate_c_tasks(bobje: &Bobje, executor: &mut ExecutorBuilder) {
-    let vars = CxVars::new(bobje);
+    let vars = CxVars::get(bobje);
     let c_source_files = bobje
         .source_files
         .iter()
         .filter(|source_file| source_file.ends_with(".c"));
     for source_file in c_source_files {
-        let object_file = get_object_path(bobje, source_file);
-        let mut inputs = find_included_header_files(bobje, source_file);
-        inputs.push(source_file.clone());
-        executor.add_task_cmd(
-            format!(
-                "{} -c {} --std=c11 {} -o {}",
-                vars.cc, vars.cflags, source_file, object_file
-            ),
-            inputs,
-            vec![object_file],
+        add_compile_task(
+            bobje,
+            executor,
+            &vars.cc,
+            &format!("{} --std=c11", vars.cflags),
+            source_file,
+            None,
         );
     }
 }
@@ -260,22 +449,193 @@ pub(crate) fn detect_cpp(source_files: &[String]) -> bool {
 }
 
 pub(crate) fn generate_cpp_tasks(bobje: &Bobje, executor: &mut ExecutorBuilder) {
-    let vars = CxVars::new(bobje);
-    let cpp_source_files = bobje
+    let vars = CxVars::get(bobje);
+    let cpp_std = get_cpp_std(bobje);
+    let mut cpp_source_files = bobje
         .source_files
         .iter()
-        .filter(|source_file| source_file.ends_with(".cpp"));
+        .filter(|source_file| source_file.ends_with(".cpp"))
+        .collect::<Vec<_>>();
+    let pch = add_pch_task(
+        bobje,
+        executor,
+        vars,
+        "cpp",
+        &format!("-x c++-header {} --std={cpp_std}", vars.cflags),
+    );
+    if uses_cpp_modules(bobje) {
+        let module_units = scan_module_units(bobje);
+        cpp_source_files.retain(|source_file| !module_units.contains_key(*source_file));
+        add_module_tasks(
+            bobje,
+            executor,
+            &format!("{} --std={cpp_std}", vars.cflags),
+            &module_units,
+        );
+    }
     for source_file in cpp_source_files {
+        add_compile_task(
+            bobje,
+            executor,
+            &vars.cxx,
+            &format!("{} --std={cpp_std}", vars.cflags),
+            source_file,
+            pch.as_ref(),
+        );
+    }
+}
+
+fn get_cpp_std(bobje: &Bobje) -> &str {
+    bobje.manifest.build.cpp_std.as_deref().unwrap_or("c++17")
+}
+
+/// Whether the C++ standard of a bobje has named modules, C++20 or later.
+fn uses_cpp_modules(bobje: &Bobje) -> bool {
+    let cpp_std = get_cpp_std(bobje);
+    let version = cpp_std
+        .strip_prefix("c++")
+        .or_else(|| cpp_std.strip_prefix("gnu++"))
+        .unwrap_or_default();
+    matches!(version, "20" | "2a" | "23" | "2b" | "26" | "2c")
+}
+
+// MARK: C++ modules
+/// The module a C++ source provides and the modules it imports, like a P1689 scan reports.
+struct ModuleUnit {
+    provides: Option<String>,
+    requires: Vec<String>,
+}
+
+/// Scan the module declarations and imports of the C++ sources, sources without them are not
+/// module units. Partitions are named `module:partition`, an implementation unit imports the
+/// module it implements.
+fn scan_module_units(bobje: &Bobje) -> HashMap<String, ModuleUnit> {
+    let module_re =
+        regex!(r"(?m)^\s*(export\s+)?module\s+([A-Za-z_][\w.]*(?::[A-Za-z_][\w.]*)?)\s*;");
+    let import_re = regex!(r"(?m)^\s*(?:export\s+)?import\s+([A-Za-z_:][\w.:]*)\s*;");
+    let mut module_units = HashMap::new();
+    for source_file in bobje
+        .source_files
+        .iter()
+        .filter(|source_file| source_file.ends_with(".cpp"))
+    {
+        let Ok(contents) = fs::read_to_string(source_file) else {
+            continue;
+        };
+        let declaration = module_re.captures(&contents);
+        let module = declaration.as_ref().map(|cap| cap[2].to_string());
+        let module_name = module
+            .as_deref()
+            .map(|module| module.split(':').next().unwrap_or_default());
+        let mut requires = import_re
+            .captures_iter(&contents)
+            .map(|cap| match (cap[1].strip_prefix(':'), module_name) {
+                (Some(partition), Some(module_name)) => format!("{module_name}:{partition}"),
+                _ => cap[1].to_string(),
+            })
+            .collect::<Vec<_>>();
+        let provides = match (&declaration, module) {
+            (Some(cap), Some(module)) if cap.get(1).is_some() || module.contains(':') => {
+                Some(module)
+            }
+            (_, Some(module)) => {
+                requires.push(module);
+                None
+            }
+            _ => None,
+        };
+        if provides.is_some() || !requires.is_empty() {
+            module_units.insert(source_file.clone(), ModuleUnit { provides, requires });
+        }
+    }
+    module_units
+}
+
+/// Path of the built module interface of a module, `:` is not allowed in every file name.
+fn get_bmi_path(bobje: &Bobje, module: &str) -> String {
+    format!(
+        "{}/modules/{}/{}.{}",
+        bobje.out_dir_with_target(),
+        bobje.name,
+        module.replace(':', "-"),
+        if USE_LLVM { "pcm" } else { "gcm" }
+    )
+}
+
+/// Add the compile tasks of the module units, a unit that provides a module writes its built
+/// module interface next to its object and the units importing it depend on that file. So
+/// module interfaces build before their importers and the other sources build in parallel.
+/// Module units are not cached or compiled remotely, their built interfaces stay local.
+fn add_module_tasks(
+    bobje: &Bobje,
+    executor: &mut ExecutorBuilder,
+    flags: &str,
+    module_units: &HashMap<String, ModuleUnit>,
+) {
+    let vars = CxVars::get(bobje);
+    let modules_dir = format!("{}/modules/{}", bobje.out_dir_with_target(), bobje.name);
+    let mut providers = HashMap::new();
+    for (source_file, module_unit) in module_units {
+        if let Some(module) = &module_unit.provides
+            && let Some(other) = providers.insert(module.as_str(), source_file.as_str())
+        {
+            eprintln!("Module {module} is provided by both {other} and {source_file}");
+            exit(1);
+        }
+    }
+
+    // GCC finds the interface of every module in a module mapper file, clang in a directory
+    let mut module_flags = format!("{flags} -fprebuilt-module-path={modules_dir}");
+    let mut inputs = Vec::new();
+    if !USE_LLVM {
+        let mut modules = providers.keys().collect::<Vec<_>>();
+        modules.sort();
+        let mut mapper = String::new();
+        for module in modules {
+            _ = writeln!(mapper, "{module} {}", get_bmi_path(bobje, module));
+        }
+        let mapper_path = format!("{modules_dir}.map");
+        fs::create_dir_all(&modules_dir).expect("Can't create modules directory");
+        write_file_when_different(&mapper_path, &mapper).expect("Can't write module mapper");
+        module_flags = format!("{flags} -fmodules-ts -fmodule-mapper={mapper_path}");
+        inputs.push(mapper_path);
+    }
+
+    for (source_file, module_unit) in module_units {
         let object_file = get_object_path(bobje, source_file);
-        let mut inputs = find_included_header_files(bobje, source_file);
+        let depfile = get_depfile_path(&object_file);
+        let mut inputs = inputs.clone();
         inputs.push(source_file.clone());
-        executor.add_task_cmd(
-            format!(
-                "{} -c {} --std=c++17 {} -o {}",
-                vars.cxx, vars.cflags, source_file, object_file
-            ),
+        if bobje.pgo == Some(Pgo::Use) {
+            inputs.extend(add_pgo_profile_task(bobje, executor, &object_file));
+        }
+        for module in &module_unit.requires {
+            if !providers.contains_key(module.as_str()) {
+                eprintln!(
+                    "Module {module} imported by {source_file} is not provided by any source"
+                );
+                exit(1);
+            }
+            inputs.push(get_bmi_path(bobje, module));
+        }
+
+        let mut outputs = vec![object_file.clone()];
+        let mut unit_flags = module_flags.clone();
+        if let Some(module) = &module_unit.provides {
+            let bmi_path = get_bmi_path(bobje, module);
+            if USE_LLVM {
+                unit_flags.push_str(&format!(" -fmodule-output={bmi_path} -x c++-module"));
+            }
+            outputs.push(bmi_path);
+        }
+        executor.add_task_with_depfile(
+            TaskAction::Command(format!(
+                "{} -c {unit_flags} {source_file} -o {object_file} -MMD -MF {depfile}",
+                vars.cxx
+            )),
             inputs,
-            vec![object_file],
+            outputs,
+            Some(depfile),
         );
     }
 }
@@ -286,22 +646,19 @@ pub(crate) fn detect_objc(source_files: &[String]) -> bool {
 }
 
 pub(crate) fn generate_objc_tasks(bobje: &Bobje, executor: &mut ExecutorBuilder) {
-    let vars = CxVars::new(bobje);
+    let vars = CxVars::get(bobje);
     let m_source_files = bobje
         .source_files
         .iter()
         .filter(|source_file| source_file.ends_with(".m"));
     for source_file in m_source_files {
-        let object_file = get_object_path(bobje, source_file);
-        let mut inputs = find_included_header_files(bobje, source_file);
-        inputs.push(source_file.clone());
-        executor.add_task_cmd(
-            format!(
-                "{} -x objective-c -fobjc-arc -c {} --std=c11 {} -o {}",
-                vars.cc, vars.cflags, source_file, object_file
-            ),
-            inputs,
-            vec![object_file],
+        add_compile_task(
+            bobje,
+            executor,
+            &vars.cc,
+            &format!("-x objective-c -fobjc-arc {} --std=c11", vars.cflags),
+            source_file,
+            None,
         );
     }
 }
@@ -312,26 +669,342 @@ pub(crate) fn detect_objcpp(source_files: &[String]) -> bool {
 }
 
 pub(crate) fn generate_objcpp_tasks(bobje: &Bobje, executor: &mut ExecutorBuilder) {
-    let vars = CxVars::new(bobje);
+    let vars = CxVars::get(bobje);
     let mm_source_files = bobje
         .source_files
         .iter()
         .filter(|source_file| source_file.ends_with(".mm"));
+    let pch = add_pch_task(
+        bobje,
+        executor,
+        vars,
+        "objcpp",
+        &format!(
+            "-x objective-c++-header -fobjc-arc {} --std={}",
+            vars.cflags,
+            get_cpp_std(bobje)
+        ),
+    );
     for source_file in mm_source_files {
-        let object_file = get_object_path(bobje, source_file);
-        let mut inputs = find_included_header_files(bobje, source_file);
-        inputs.push(source_file.clone());
-        executor.add_task_cmd(
-            format!(
-                "{} -x objective-c++ -fobjc-arc -c {} --std=c++17 {} -o {}",
-                vars.cxx, vars.cflags, source_file, object_file
+        add_compile_task(
+            bobje,
+            executor,
+            &vars.cxx,
+            &format!(
+                "-x objective-c++ -fobjc-arc {} --std={}",
+                vars.cflags,
+                get_cpp_std(bobje)
             ),
-            inputs,
+            source_file,
+            pch.as_ref(),
+        );
+    }
+}
+
+// MARK: Compile tasks
+/// Add a task compiling a source file to an object, with the object cache enabled an object
+/// compiled before from the same preprocessed source and flags is reused. With remote workers
+/// the preprocessed source can be compiled on a worker.
+fn add_compile_task(
+    bobje: &Bobje,
+    executor: &mut ExecutorBuilder,
+    compiler: &str,
+    flags: &str,
+    source_file: &str,
+    pch: Option<&Pch>,
+) {
+    let object_file = get_object_path(bobje, source_file);
+    let depfile = get_depfile_path(&object_file);
+    let mut inputs = vec![source_file.to_string()];
+    if bobje.pgo == Some(Pgo::Use) {
+        inputs.extend(add_pgo_profile_task(bobje, executor, &object_file));
+    }
+    let (compile_flags, preprocess_flags) = if let Some(pch) = pch {
+        inputs.push(pch.file.clone());
+        (
+            format!("{} {flags}", pch.include_flag()),
+            format!("-include {} {flags}", pch.header),
+        )
+    } else {
+        (flags.to_string(), flags.to_string())
+    };
+    let command =
+        format!("{compiler} -c {compile_flags} {source_file} -o {object_file} -MMD -MF {depfile}");
+    // The object cache key does not cover profile data and split debug info is not stored
+    let cache_dir = bobje
+        .object_cache_dir
+        .clone()
+        .filter(|_| bobje.pgo != Some(Pgo::Use) && !uses_split_dwarf(bobje));
+    // Generated sources and profile data stay local, the preprocessed source includes the
+    // precompiled header so the remote compile has the flags without it
+    let remote_command = if bobje.remote
+        && bobje.pgo.is_none()
+        && !uses_split_dwarf(bobje)
+        && !source_file.contains("/src-gen/")
+    {
+        preprocessed_language(source_file)
+            .map(|language| format!("{compiler} -c {flags} -x {language}"))
+    } else {
+        None
+    };
+    let action = if cache_dir.is_some() || remote_command.is_some() {
+        TaskAction::Compile {
+            command,
+            preprocess_command: format!(
+                "{compiler} -E {preprocess_flags} {source_file} -MMD -MF {depfile}"
+            ),
+            object_file: object_file.clone(),
+            cache_dir,
+            cache_key_command: None,
+            remote_command,
+        }
+    } else {
+        TaskAction::Command(command)
+    };
+    executor.add_task_with_depfile(action, inputs, vec![object_file], Some(depfile));
+}
+
+/// Language of the preprocessed output of a source, for the `-x` flag.
+fn preprocessed_language(source_file: &str) -> Option<&'static str> {
+    match source_file.rsplit_once('.')?.1 {
+        "c" => Some("cpp-output"),
+        "cpp" => Some("c++-cpp-output"),
+        "m" => Some("objective-c-cpp-output"),
+        "mm" => Some("objective-c++-cpp-output"),
+        _ => None,
+    }
+}
+
+// MARK: Bundled dependencies
+fn get_bundled_library_path(bobje: &Bobje, name: &str) -> String {
+    format!("{}/bundled/lib{}.a", bobje.out_dir_with_target(), name)
+}
+
+/// Static libraries of the bundled dependencies of a bobje, sorted so the link command stays
+/// the same between builds.
+fn bundled_libraries(bobje: &Bobje) -> Vec<String> {
+    let mut libraries = bobje
+        .manifest
+        .dependencies
+        .iter()
+        .filter(|(_, dep)| matches!(dep, Dependency::Bundled { .. }))
+        .map(|(name, _)| get_bundled_library_path(bobje, name))
+        .collect::<Vec<_>>();
+    libraries.sort();
+    libraries
+}
+
+/// Add the tasks compiling the bundled C sources once per profile and target and archiving
+/// them into a static library. A bundled source is often huge like the SQLite amalgamation, so
+/// its object is always stored in the global bob cache, which survives clean builds and is
+/// shared between projects.
+pub(crate) fn generate_bundled_tasks(bobje: &Bobje, executor: &mut ExecutorBuilder) {
+    let vars = CxVars::get(bobje);
+    let object_cache_dir = bobje
+        .object_cache_dir
+        .clone()
+        .unwrap_or_else(|| format!("{}/object-cache", cache_dir().display()));
+    for (name, dep) in &bobje.manifest.dependencies {
+        let Dependency::Bundled {
+            bundled, defines, ..
+        } = dep
+        else {
+            continue;
+        };
+        let source_file = format!("{}/{}", bobje.manifest_dir, bundled);
+        let object_file = format!(
+            "{}/bundled/{}/{}.o",
+            bobje.out_dir_with_target(),
+            name,
+            Path::new(bundled)
+                .file_stem()
+                .expect("Should be some")
+                .to_string_lossy()
+        );
+        let depfile = get_depfile_path(&object_file);
+        let mut flags = vars.bundled_cflags.clone();
+        for define in defines {
+            flags.push_str(&format!(" -D{define}"));
+        }
+        // The key leaves out the source, object and depfile paths and the preprocessed source has
+        // no line markers, so every project with the same source, compiler and flags shares it
+        executor.add_task_with_depfile(
+            TaskAction::Compile {
+                command: format!(
+                    "{} -c {flags} {source_file} -o {object_file} -MMD -MF {depfile}",
+                    vars.cc
+                ),
+                preprocess_command: format!(
+                    "{} -E -P {flags} {source_file} -MMD -MF {depfile}",
+                    vars.cc
+                ),
+                object_file: object_file.clone(),
+                cache_dir: Some(object_cache_dir.clone()),
+                cache_key_command: Some(format!("{} -c {flags}", vars.cc)),
+                remote_command: bobje
+                    .remote
+                    .then(|| format!("{} -c {flags} -x cpp-output", vars.cc)),
+            },
+            vec![source_file],
+            vec![object_file.clone()],
+            Some(depfile),
+        );
+
+        let library_path = get_bundled_library_path(bobje, name);
+        executor.add_task(
+            TaskAction::Multiple(vec![
+                TaskAction::Remove(library_path.clone()),
+                TaskAction::Command(format!("{} rc {library_path} {object_file}", vars.ar)),
+            ]),
             vec![object_file],
+            vec![library_path],
         );
     }
 }
 
+// MARK: Profile guided optimization
+fn get_pgo_profraw_dir(bobje: &Bobje) -> String {
+    format!("{}/pgo", bobje.pgo_generate_dir())
+}
+
+fn get_pgo_profdata_path(bobje: &Bobje) -> String {
+    format!("{}/pgo/default.profdata", bobje.out_dir_with_target())
+}
+
+/// Add the task merging the raw clang profiles of the instrumented build into the profile the
+/// optimized build reads. GCC writes a profile per object instead, see `add_pgo_profile_task`.
+pub(crate) fn generate_cx_pgo_profdata(bobje: &Bobje, executor: &mut ExecutorBuilder) {
+    if !USE_LLVM {
+        return;
+    }
+    let profraw_dir = get_pgo_profraw_dir(bobje);
+    let mut profraw_files = fs::read_dir(&profraw_dir)
+        .map(|entries| {
+            entries
+                .filter_map(Result::ok)
+                .map(|entry| entry.path().display().to_string())
+                .filter(|path| path.ends_with(".profraw"))
+                .collect::<Vec<_>>()
+        })
+        .unwrap_or_default();
+    if profraw_files.is_empty() {
+        eprintln!("No profiles in {profraw_dir}, run the artifact built with --pgo-generate first");
+        exit(1);
+    }
+    profraw_files.sort();
+
+    let profdata_path = get_pgo_profdata_path(bobje);
+    executor.add_task_cmd(
+        format!(
+            "{} merge -o {} {}",
+            if cfg!(target_os = "macos") {
+                "xcrun llvm-profdata"
+            } else {
+                "llvm-profdata"
+            },
+            profdata_path,
+            profraw_files.join(" ")
+        ),
+        profraw_files,
+        vec![profdata_path],
+    );
+}
+
+/// Profile data an object compiled with `--pgo-use` reads, it is an input of the compile task
+/// so new profiles recompile the object. GCC reads the profile next to the object, so it is
+/// copied from the instrumented build, objects that never ran have no profile.
+fn add_pgo_profile_task(
+    bobje: &Bobje,
+    executor: &mut ExecutorBuilder,
+    object_file: &str,
+) -> Option<String> {
+    if USE_LLVM {
+        return Some(get_pgo_profdata_path(bobje));
+    }
+    let profile_file = format!(
+        "{}.gcda",
+        object_file.strip_suffix(".o").unwrap_or(object_file)
+    );
+    let generated_profile_file =
+        profile_file.replacen(&bobje.out_dir_with_target(), &bobje.pgo_generate_dir(), 1);
+    if !Path::new(&generated_profile_file).exists() {
+        return None;
+    }
+    executor.add_task_cp(generated_profile_file, profile_file.clone());
+    Some(profile_file)
+}
+
+// MARK: Precompiled headers
+/// Precompiled version of the `build.pch` header. It is compiled from a stub header that
+/// includes the real one, so gcc finds the precompiled file next to the stub and does not warn
+/// about `#pragma once` in the main file. Preprocessing alone reads the stub as text.
+struct Pch {
+    header: String,
+    file: String,
+    use_llvm: bool,
+}
+
+impl Pch {
+    fn include_flag(&self) -> String {
+        if self.use_llvm {
+            format!("-include-pch {}", self.file)
+        } else {
+            format!("-include {}", self.header)
+        }
+    }
+}
+
+/// Add the task precompiling the `build.pch` header once for every language, profile and
+/// target. The flags must match the flags of the compile tasks using it.
+fn add_pch_task(
+    bobje: &Bobje,
+    executor: &mut ExecutorBuilder,
+    vars: &CxVars,
+    language: &str,
+    flags: &str,
+) -> Option<Pch> {
+    let pch = bobje.manifest.build.pch.as_ref()?;
+    let source_header = format!("{}/{}", bobje.manifest_dir, pch);
+    let pch_dir = format!(
+        "{}/pch/{}/{}",
+        bobje.out_dir_with_target(),
+        bobje.name,
+        language
+    );
+    let header = format!(
+        "{}/{}",
+        pch_dir,
+        Path::new(pch)
+            .file_name()
+            .expect("Should be some")
+            .to_string_lossy()
+    );
+
+    let include_path = get_include_path(&pch_dir, &source_header);
+    write_file_when_different(
+        &header,
+        &format!("// This file is generated by bob, do not edit!\n#include \"{include_path}\"\n"),
+    )
+    .expect("Can't write precompiled header stub");
+
+    let file = format!("{header}.{}", if vars.use_llvm { "pch" } else { "gch" });
+    let depfile = format!("{file}.d");
+    executor.add_task_with_depfile(
+        TaskAction::Command(format!(
+            "{} {} {} -o {} -MMD -MF {}",
+            vars.cxx, flags, header, file, depfile
+        )),
+        vec![header.clone(), source_header],
+        vec![file.clone()],
+        Some(depfile),
+    );
+    Some(Pch {
+        header,
+        file,
+        use_llvm: vars.use_llvm,
+    })
+}
+
 // MARK: Linker tasks
 pub(crate) fn detect_cx(source_files: &[String]) -> bool {
     detect_asm(source_files)
@@ -342,30 +1015,35 @@ pub(crate) fn detect_cx(source_files: &[String]) -> bool {
 }
 
 pub(crate) fn generate_ld_tasks(bobje: &Bobje, executor: &mut ExecutorBuilder) {
-    let vars = CxVars::new(bobje);
+    let vars = CxVars::get(bobje);
 
     // Gather inputs
-    let mut inputs = Vec::new();
+    let mut inputs = object_files(bobje);
     let mut contains_cpp = false;
     for source_file in &bobje.source_files {
-        if source_file.ends_with(".s")
-            || source_file.ends_with(".S")
-            || source_file.ends_with(".c")
-            || source_file.ends_with(".cpp")
-            || source_file.ends_with(".m")
-            || source_file.ends_with(".mm")
-        {
-            inputs.push(get_object_path(bobje, source_file));
-        }
         if source_file.ends_with(".cpp") || source_file.ends_with(".mm") {
             contains_cpp = true;
         }
     }
 
-    // Add dependencies
-    fn visit_bobje(bobje: &Bobje, inputs: &mut Vec<String>, contains_cpp: &mut bool) {
+    // Add dependencies, the objects of thin archives are inputs as well because the archive
+    // only changes when the size of an object changes. The bundled libraries of static
+    // libraries are linked last, after every archive that uses them
+    fn visit_bobje(
+        bobje: &Bobje,
+        inputs: &mut Vec<String>,
+        member_inputs: &mut Vec<String>,
+        bundled_inputs: &mut Vec<String>,
+        contains_cpp: &mut bool,
+    ) {
         for dependency_bobje in bobje.dependencies.values() {
-            visit_bobje(dependency_bobje, inputs, contains_cpp);
+            visit_bobje(
+                dependency_bobje,
+                inputs,
+                member_inputs,
+                bundled_inputs,
+                contains_cpp,
+            );
         }
         for source_file in &bobje.source_files {
             if source_file.ends_with(".cpp") || source_file.ends_with(".mm") {
@@ -383,32 +1061,75 @@ pub(crate) fn generate_ld_tasks(bobje: &Bobje, executor: &mut ExecutorBuilder) {
                     LibraryType::Dynamic => DYLIB_EXT,
                 }
             ));
+            if uses_thin_archive(bobje) {
+                member_inputs.extend(object_files(bobje));
+            }
+            if matches!(r#type, LibraryType::Static) {
+                bundled_inputs.extend(bundled_libraries(bobje));
+            }
         }
     }
+    let mut member_inputs = Vec::new();
+    let mut bundled_inputs = bundled_libraries(bobje);
     for dependency_bobje in bobje.dependencies.values() {
-        visit_bobje(dependency_bobje, &mut inputs, &mut contains_cpp);
+        visit_bobje(
+            dependency_bobje,
+            &mut inputs,
+            &mut member_inputs,
+            &mut bundled_inputs,
+            &mut contains_cpp,
+        );
     }
+    let mut seen = HashSet::new();
+    bundled_inputs.retain(|input| seen.insert(input.clone()));
+    inputs.extend(bundled_inputs.iter().cloned());
+    let response_file = format!("{}/objects/{}.rsp", bobje.out_dir_with_target(), bobje.name);
 
     // Link library
     let linker = if cfg!(target_os = "macos") {
-        vars.ld
+        &vars.ld
     } else if contains_cpp {
-        vars.cxx
+        &vars.cxx
     } else {
-        vars.cc
+        &vars.cc
     };
     if let PackageType::Library { r#type } = bobje.r#type {
-        let input_objects = inputs
+        // A dynamic library contains its bundled libraries, a static library leaves them to
+        // the package that links it
+        let objects = inputs
             .iter()
-            .filter(|f| f.ends_with(".o"))
+            .filter(|f| {
+                f.ends_with(".o")
+                    || matches!(r#type, LibraryType::Dynamic) && bundled_inputs.contains(f)
+            })
             .cloned()
-            .collect::<Vec<_>>()
-            .join(" ");
+            .collect::<Vec<_>>();
         match r#type {
             LibraryType::Static => {
                 let staticlib_path = format!("{}/lib{}.a", bobje.out_dir_with_target(), bobje.name);
-                executor.add_task_cmd(
-                    format!("{} rc {} {}", vars.ar, staticlib_path, input_objects),
+                // Apple ar has no thin archives and no response files
+                let input_objects = if cfg!(target_os = "macos") {
+                    objects.join(" ")
+                } else {
+                    objects_arg(&objects, &response_file, &mut inputs)
+                };
+                // The archive is created again, ar can't switch an archive between thin and
+                // normal and would keep the members of removed sources
+                executor.add_task(
+                    TaskAction::Multiple(vec![
+                        TaskAction::Remove(staticlib_path.clone()),
+                        TaskAction::Command(format!(
+                            "{} {} {} {}",
+                            vars.ar,
+                            if uses_thin_archive(bobje) {
+                                "rcT"
+                            } else {
+                                "rc"
+                            },
+                            staticlib_path,
+                            input_objects
+                        )),
+                    ]),
                     inputs.clone(),
                     vec![staticlib_path],
                 );
@@ -420,6 +1141,8 @@ pub(crate) fn generate_ld_tasks(bobje: &Bobje, executor: &mut ExecutorBuilder) {
                     bobje.name,
                     DYLIB_EXT
                 );
+                let input_objects = objects_arg(&objects, &response_file, &mut inputs);
+                inputs.extend(member_inputs.iter().cloned());
                 executor.add_task_cmd(
                     format!(
                         "{} {} {} {} {} {} -o {}",
@@ -449,12 +1172,13 @@ pub(crate) fn generate_ld_tasks(bobje: &Bobje, executor: &mut ExecutorBuilder) {
     // Link executable
     if bobje.r#type.is_binary() {
         let executable_file = format!("{}/{}", bobje.out_dir_with_target(), bobje.name);
-        let input_objects = inputs
+        let objects = inputs
             .iter()
             .filter(|f| f.ends_with(".o") || f.ends_with(".a"))
             .cloned()
-            .collect::<Vec<_>>()
-            .join(" ");
+            .collect::<Vec<_>>();
+        let input_objects = objects_arg(&objects, &response_file, &mut inputs);
+        inputs.extend(member_inputs);
         let mut libs = vars.libs.clone();
         for input in &inputs {
             if input.ends_with(DYLIB_EXT) {
@@ -511,22 +1235,37 @@ pub(crate) fn generate_ld_tasks(bobje: &Bobje, executor: &mut ExecutorBuilder) {
 }
 
 pub(crate) fn generate_ld_cunit_tests(bobje: &Bobje, executor: &mut ExecutorBuilder) {
-    let vars = CxVars::new(bobje);
+    add_ld_harness_task(bobje, executor, &find_test_functions(bobje), "test");
+}
+
+pub(crate) fn generate_ld_bench(bobje: &Bobje, executor: &mut ExecutorBuilder) {
+    add_ld_harness_task(bobje, executor, &find_bench_functions(bobje), "bench");
+}
+
+/// Link the objects of the sources with test or bench functions and the generated main into
+/// the `{prefix}_{name}` executable.
+fn add_ld_harness_task(
+    bobje: &Bobje,
+    executor: &mut ExecutorBuilder,
+    functions: &[TestFunction],
+    prefix: &str,
+) {
+    let vars = CxVars::get(bobje);
 
     // Gather inputs
     let mut inputs = Vec::new();
     let mut contains_cpp = false;
-    let test_functions = find_test_functions(bobje);
-    for test_function in &test_functions {
+    for test_function in functions {
         inputs.push(get_object_path(bobje, &test_function.source_file));
         if test_function.source_file.ends_with(".cpp") || test_function.source_file.ends_with(".mm")
         {
             contains_cpp = true;
         }
     }
+    inputs.extend(bundled_libraries(bobje));
 
-    // Link test executable
-    let executable_file = format!("{}/test_{}", bobje.out_dir_with_target(), bobje.name);
+    // Link harness executable
+    let executable_file = format!("{}/{prefix}_{}", bobje.out_dir_with_target(), bobje.name);
     let mut libs = vars.libs.clone();
     if cfg!(target_os = "macos") && contains_cpp {
         libs.push_str(" -lc++");
@@ -537,11 +1276,11 @@ pub(crate) fn generate_ld_cunit_tests(bobje: &Bobje, executor: &mut ExecutorBuil
         format!(
             "{} {} {} {} -o {}",
             if cfg!(target_os = "macos") {
-                vars.ld
+                &vars.ld
             } else if contains_cpp {
-                vars.cxx
+                &vars.cxx
             } else {
-                vars.cc
+                &vars.cc
             },
             vars.ldflags,
             inputs.join(" "),
@@ -553,7 +1292,7 @@ pub(crate) fn generate_ld_cunit_tests(bobje: &Bobje, executor: &mut ExecutorBuil
     );
 }
 
-pub(crate) fn run_ld(bobje: &Bobje) -> ! {
+pub(crate) fn run_ld(bobje: &Bobje) -> i32 {
     let status = Command::new(format!(
         "{}/{}{}",
         bobje.out_dir_with_target(),
@@ -562,22 +1301,179 @@ pub(crate) fn run_ld(bobje: &Bobje) -> ! {
     ))
     .status()
     .expect("Failed to execute executable");
-    exit(status.code().unwrap_or(1))
+    status.code().unwrap_or(1)
 }
 
-pub(crate) fn run_ld_cunit_tests(bobje: &Bobje) -> ! {
-    let status = Command::new(format!(
+/// Run the benchmarks, they are compared with the saved baseline and the harness fails when
+/// one regressed. With `save_baseline` the results become the new baseline.
+pub(crate) fn run_ld_bench(bobje: &Bobje, save_baseline: bool) -> i32 {
+    let out_dir = bobje.out_dir_with_target();
+    let baseline_path = format!("{out_dir}/bench_baseline.json");
+    let status = Command::new(format!("{out_dir}/bench_{}{}", bobje.name, EXECUTABLE_EXT))
+        .arg("--baseline")
+        .arg(&baseline_path)
+        .arg("--save")
+        .arg(if save_baseline {
+            baseline_path.clone()
+        } else {
+            format!("{out_dir}/bench_results.json")
+        })
+        .status()
+        .expect("Failed to execute executable");
+    status.code().unwrap_or(1)
+}
+
+/// Run the test suites sharded over `thread_count` test processes, so a crashing test only
+/// fails its own suite. The suite reports are printed in order followed by the totals.
+pub(crate) fn run_ld_cunit_tests(
+    bobje: &Bobje,
+    thread_count: Option<usize>,
+    test_filter: Option<&str>,
+) -> i32 {
+    let executable = format!(
         "{}/test_{}{}",
         bobje.out_dir_with_target(),
         bobje.name,
         EXECUTABLE_EXT
-    ))
-    .status()
-    .expect("Failed to execute executable");
-    exit(status.code().unwrap_or(1))
+    );
+    let test_command = |extra_args: &[&str]| {
+        let mut command = Command::new(&executable);
+        command.args(extra_args);
+        if let Some(test_filter) = test_filter {
+            command.arg("--test").arg(test_filter);
+        }
+        command
+    };
+
+    // List the suites with matching tests
+    let output = test_command(&["--list"])
+        .output()
+        .expect("Failed to execute executable");
+    if !output.status.success() {
+        eprintln!("Failed to list tests");
+        return 1;
+    }
+    let suites = String::from_utf8_lossy(&output.stdout)
+        .lines()
+        .map(str::to_string)
+        .collect::<Vec<_>>();
+
+    // Run every suite in its own process
+    let thread_count = thread_count
+        .unwrap_or_else(|| thread::available_parallelism().map_or(1, |n| n.get()))
+        .clamp(1, suites.len().max(1));
+    let next_suite = AtomicUsize::new(0);
+    let outputs = Mutex::new(vec![None; suites.len()]);
+    thread::scope(|scope| {
+        for _ in 0..thread_count {
+            scope.spawn(|| {
+                loop {
+                    let index = next_suite.fetch_add(1, Ordering::Relaxed);
+                    let Some(suite) = suites.get(index) else {
+                        break;
+                    };
+                    let output = test_command(&["--suite", suite])
+                        .output()
+                        .expect("Failed to execute executable");
+                    outputs.lock().expect("Could not lock mutex")[index] = Some(output);
+                }
+            });
+        }
+    });
+
+    // Merge the suite reports
+    let mut tests_run = 0;
+    let mut tests_failed = 0;
+    for (suite, output) in suites
+        .iter()
+        .zip(outputs.into_inner().expect("Could not lock mutex"))
+    {
+        let output = output.expect("Suite should have run");
+        let stdout = String::from_utf8_lossy(&output.stdout);
+        let (report, completed) = match stdout.rsplit_once("Tests run: ") {
+            Some((report, _)) => (report, true),
+            None => (stdout.as_ref(), false),
+        };
+        print!("{report}");
+        tests_run += report
+            .lines()
+            .filter(|line| line.starts_with("  Test: "))
+            .count();
+        tests_failed += report
+            .lines()
+            .filter(|line| line.starts_with("  Test: ") && line.contains("FAILED"))
+            .count();
+        _ = io::stderr().write_all(&output.stderr);
+
+        // A crash fails the test that was running and skips the rest of the suite
+        if !completed {
+            if report.is_empty() || report.ends_with('\n') {
+                println!("\x1b[31mSuite {suite} CRASHED\x1b[0m ({})", output.status);
+            } else {
+                println!("\x1b[31mCRASHED\x1b[0m ({})", output.status);
+            }
+            tests_failed += 1;
+        }
+    }
+
+    println!(
+        "\nRan {tests_run} tests in {} suites on {thread_count} processes",
+        suites.len()
+    );
+    if tests_failed == 0 {
+        println!("\x1b[32mAll tests passed!\x1b[0m");
+        return 0;
+    }
+    println!("\x1b[31m{tests_failed} tests failed!\x1b[0m");
+    1
 }
 
 // MARK: Utils
+/// Objects of all assembly, C, C++, Objective-C and Objective-C++ sources.
+fn object_files(bobje: &Bobje) -> Vec<String> {
+    bobje
+        .source_files
+        .iter()
+        .filter(|source_file| {
+            source_file.ends_with(".s")
+                || source_file.ends_with(".S")
+                || source_file.ends_with(".c")
+                || source_file.ends_with(".cpp")
+                || source_file.ends_with(".m")
+                || source_file.ends_with(".mm")
+        })
+        .map(|source_file| get_object_path(bobje, source_file))
+        .collect()
+}
+
+/// Static libraries of dependencies are thin archives, which only reference their objects
+/// instead of copying them. They are only read by this build, so the objects stay around.
+const fn uses_thin_archive(bobje: &Bobje) -> bool {
+    !cfg!(target_os = "macos") && !bobje.is_main
+}
+
+/// Command lines longer than this pass the objects in a response file, `sh -c` gets the
+/// command as a single argument which Linux limits to 128 KiB and Windows limits to 32 KiB.
+const RESPONSE_FILE_THRESHOLD: usize = 16 * 1024;
+
+/// The objects as arguments, or a response file listing them when there are many. The
+/// response file becomes an input, so a changed list reruns the command.
+fn objects_arg(objects: &[String], response_file: &str, inputs: &mut Vec<String>) -> String {
+    let joined = objects.join(" ");
+    if joined.len() <= RESPONSE_FILE_THRESHOLD {
+        return joined;
+    }
+    write_file_when_different(response_file, &format!("{}\n", objects.join("\n")))
+        .expect("Can't write response file");
+    inputs.push(response_file.to_string());
+    // The macOS linker reads a file list instead
+    if cfg!(target_os = "macos") {
+        format!("-filelist {response_file}")
+    } else {
+        format!("@{response_file}")
+    }
+}
+
 fn get_object_path(bobje: &Bobje, source_file: &str) -> String {
     format!(
         "{}/objects/{}/{}",
@@ -597,71 +1493,222 @@ fn get_object_path(bobje: &Bobje, source_file: &str) -> String {
     )
 }
 
-fn pkg_config_cflags(package: &str) -> String {
-    let output = Command::new("pkg-config")
-        .arg("--cflags")
-        .arg(package)
-        .output()
-        .expect("Failed to execute pkg-config");
-    if output.status.success() {
-        String::from_utf8(output.stdout)
-            .expect("Invalid UTF-8 sequence")
-            .replace('\n', " ")
+/// Path to include a file from a generated source in a directory, relative when possible so it
+/// does not depend on the location of the checkout.
+fn get_include_path(dir: &str, path: &str) -> String {
+    let components = Path::new(dir).components().collect::<Vec<_>>();
+    if components
+        .iter()
+        .all(|component| matches!(component, Component::Normal(_) | Component::CurDir))
+    {
+        let depth = components
+            .iter()
+            .filter(|component| matches!(component, Component::Normal(_)))
+            .count();
+        format!("{}{}", "../".repeat(depth), path.trim_start_matches("./"))
     } else {
-        eprintln!(
-            "pkg-config failed with error: {}",
-            String::from_utf8_lossy(&output.stderr)
-        );
+        fs::canonicalize(path)
+            .unwrap_or_else(|_| {
+                eprintln!("Can't find file: {path}");
+                exit(1)
+            })
+            .display()
+            .to_string()
+    }
+}
+
+/// The compiler writes the headers an object includes to this depfile.
+fn get_depfile_path(object_file: &str) -> String {
+    format!("{}.d", object_file.trim_end_matches(".o"))
+}
+
+fn pkg_config(bobje: &Bobje, flag: &str, package: &str) -> String {
+    probe(bobje, "pkg-config", &[flag, package]).unwrap_or_else(|err| {
+        eprintln!("pkg-config failed with error: {err}");
         exit(1);
+    })
+}
+
+// MARK: Toolchain probes
+/// Outputs of the toolchain probes, stored in `target/bob-probes` so no-op builds don't start
+/// `pkg-config` and `xcrun` again. The first line is the stamp the outputs were probed with.
+struct Probes {
+    path: String,
+    stamp: String,
+    outputs: HashMap<String, String>,
+}
+
+static PROBES: Mutex<Option<Probes>> = Mutex::new(None);
+
+/// Environment variables that change the probe outputs and the modified times of the probe
+/// tools, a new SDK or toolchain version changes the stamp and probes everything again.
+fn probes_stamp() -> String {
+    let mut stamp = [
+        "PKG_CONFIG_PATH",
+        "PKG_CONFIG_LIBDIR",
+        "SDKROOT",
+        "DEVELOPER_DIR",
+    ]
+    .iter()
+    .map(|name| format!("{name}={}", env::var(name).unwrap_or_default()))
+    .collect::<Vec<_>>();
+    let path = env::var_os("PATH").unwrap_or_default();
+    for tool in ["pkg-config", "xcrun", "clang", "gcc", "mold", "ld.lld"] {
+        let mtime = env::split_paths(&path)
+            .find_map(|dir| fs::metadata(dir.join(tool)).ok())
+            .and_then(|metadata| metadata.modified().ok())
+            .and_then(|mtime| mtime.duration_since(SystemTime::UNIX_EPOCH).ok())
+            .map(|mtime| mtime.as_nanos())
+            .unwrap_or_default();
+        stamp.push(format!("{tool}={mtime}"));
     }
+    stamp.join(" ")
 }
 
-fn pkg_config_libs(package: &str) -> String {
-    let output = Command::new("pkg-config")
-        .arg("--libs")
-        .arg(package)
+/// Trimmed stdout of a probe command with its newlines replaced by spaces, or its stderr when
+/// it fails. Only successful outputs are stored.
+fn probe(bobje: &Bobje, program: &str, args: &[&str]) -> Result<String, String> {
+    let mut probes = PROBES.lock().expect("Could not lock mutex");
+    let probes = probes.get_or_insert_with(|| {
+        let path = format!("{}/bob-probes", bobje.target_dir);
+        let stamp = probes_stamp();
+        let mut outputs = HashMap::new();
+        if let Ok(contents) = fs::read_to_string(&path)
+            && let Some((file_stamp, lines)) = contents.split_once('\n')
+            && file_stamp == stamp
+        {
+            outputs.extend(lines.lines().filter_map(|line| {
+                line.split_once('\t')
+                    .map(|(command, output)| (command.to_string(), output.to_string()))
+            }));
+        }
+        Probes {
+            path,
+            stamp,
+            outputs,
+        }
+    });
+
+    let command = format!("{program} {}", args.join(" "));
+    if let Some(output) = probes.outputs.get(&command) {
+        return Ok(output.clone());
+    }
+    let output = Command::new(program)
+        .args(args)
         .output()
-        .expect("Failed to execute pkg-config");
-    if output.status.success() {
-        String::from_utf8(output.stdout)
-            .expect("Invalid UTF-8 sequence")
-            .replace('\n', " ")
-    } else {
-        eprintln!(
-            "pkg-config failed with error: {}",
-            String::from_utf8_lossy(&output.stderr)
-        );
-        exit(1);
+        .map_err(|err| format!("Failed to execute {program}: {err}"))?;
+    if !output.status.success() {
+        return Err(String::from_utf8_lossy(&output.stderr).to_string());
     }
+    let stdout = String::from_utf8(output.stdout)
+        .expect("Invalid UTF-8 sequence")
+        .trim()
+        .replace('\n', " ");
+    probes.outputs.insert(command, stdout.clone());
+
+    let mut contents = format!("{}\n", probes.stamp);
+    for (command, output) in &probes.outputs {
+        _ = writeln!(contents, "{command}\t{output}");
+    }
+    _ = fs::create_dir_all(&bobje.target_dir);
+    _ = fs::write(&probes.path, contents);
+    Ok(stdout)
 }
 
-fn find_included_header_files(bobje: &Bobje, source_file: &str) -> Vec<String> {
-    fn visit_file(
-        bobje: &Bobje,
-        source_file: &str,
-        visited: &mut HashSet<String>,
-        re: &Regex,
-    ) -> Vec<String> {
-        let mut included_files = Vec::new();
-        if let Ok(contents) = fs::read_to_string(source_file) {
-            for cap in re.captures_iter(&contents) {
-                let header_path = cap[1].to_string();
-                if let Some(full_path) = bobje
-                    .source_files
-                    .iter()
-                    .find(|f| f.ends_with(&header_path))
-                    && visited.insert(full_path.clone())
-                {
-                    included_files.push(full_path.clone());
-                    included_files.extend(visit_file(bobje, full_path, visited, re));
-                }
+// MARK: Unity build
+/// Replace batches of C++ sources with `src-gen/{name}/unity_N.cpp` sources that include them.
+/// The batches are stored when they are first generated, sources changed since then are
+/// compiled on their own until the next clean build, so editing a source only recompiles it.
+/// The profile `codegen-units` spreads the sources over that many batches instead.
+pub(crate) fn generate_cx_unity_sources(bobje: &mut Bobje) {
+    // Module units can't share a translation unit
+    let module_units = if uses_cpp_modules(bobje) {
+        scan_module_units(bobje)
+    } else {
+        HashMap::new()
+    };
+    let mut sources = bobje
+        .source_files
+        .iter()
+        .filter(|source_file| {
+            source_file.ends_with(".cpp") && !module_units.contains_key(*source_file)
+        })
+        .cloned()
+        .collect::<Vec<_>>();
+    let batch = match (
+        bobje.profile_config.codegen_units,
+        &bobje.manifest.build.unity,
+    ) {
+        (Some(codegen_units), _) => sources.len().div_ceil(codegen_units.max(1)),
+        (None, Some(unity)) => unity.batch,
+        (None, None) => return,
+    };
+    let unity_dir = format!("{}/src-gen/{}", bobje.out_dir(), bobje.name);
+    let batches_path = format!("{unity_dir}/unity_batches.txt");
+
+    // Read the stored batches, or batch the sorted sources
+    let header = format!("batch {batch}");
+    let batches = match fs::read_to_string(&batches_path) {
+        Ok(contents) if contents.lines().next() == Some(header.as_str()) => contents
+            .lines()
+            .skip(1)
+            .map(|line| line.split(' ').map(str::to_string).collect::<Vec<_>>())
+            .collect::<Vec<_>>(),
+        _ => {
+            sources.sort();
+            let batches = sources
+                .chunks(batch.max(1))
+                .map(<[String]>::to_vec)
+                .collect::<Vec<_>>();
+            let mut contents = header;
+            for batch in &batches {
+                _ = write!(contents, "\n{}", batch.join(" "));
             }
+            fs::create_dir_all(&unity_dir).expect("Can't create src-gen directory");
+            fs::write(&batches_path, contents).expect("Can't write unity batches");
+            batches
+        }
+    };
+    let batched_time = fs::metadata(&batches_path)
+        .and_then(|metadata| metadata.modified())
+        .expect("Can't read unity batches");
+
+    let source_files = bobje.source_files.iter().collect::<HashSet<_>>();
+    let is_unchanged = |source_file: &String| {
+        source_files.contains(source_file)
+            && fs::metadata(source_file)
+                .and_then(|metadata| metadata.modified())
+                .is_ok_and(|modified: SystemTime| modified <= batched_time)
+    };
+    let mut batched_sources = HashSet::new();
+    let mut unity_sources = Vec::new();
+    for (index, batch) in batches.iter().enumerate() {
+        let sources = batch
+            .iter()
+            .filter(|source_file| is_unchanged(source_file))
+            .collect::<Vec<_>>();
+        if sources.len() < 2 {
+            continue;
         }
-        included_files
+
+        let mut s = String::new();
+        _ = writeln!(s, "// This file is generated by bob, do not edit!");
+        for source_file in &sources {
+            _ = writeln!(
+                s,
+                "#include \"{}\"",
+                get_include_path(&unity_dir, source_file)
+            );
+        }
+        let dest = format!("{unity_dir}/unity_{index}.cpp");
+        write_file_when_different(&dest, &s).expect("Can't write unity source");
+        batched_sources.extend(sources.into_iter().cloned());
+        unity_sources.push(dest);
     }
-    let re = regex!(r#"#include\s+"([^"]+)""#);
-    let mut visited = HashSet::new();
-    visit_file(bobje, source_file, &mut visited, re)
+    bobje
+        .source_files
+        .retain(|source_file| !batched_sources.contains(source_file));
+    bobje.source_files.extend(unity_sources);
 }
 
 struct TestFunction {
@@ -670,8 +1717,18 @@ struct TestFunction {
 }
 
 fn find_test_functions(bobje: &Bobje) -> Vec<TestFunction> {
+    find_functions(bobje, regex!(r"void\s+(test_[^\(]+)"))
+}
+
+fn find_bench_functions(bobje: &Bobje) -> Vec<TestFunction> {
+    find_functions(
+        bobje,
+        regex!(r"void\s+(bench_[A-Za-z0-9_]+)\s*\(\s*bench_t\s*\*"),
+    )
+}
+
+fn find_functions(bobje: &Bobje, re: &Regex) -> Vec<TestFunction> {
     let mut test_functions = Vec::new();
-    let re = regex!(r"void\s+(test_[^\(]+)");
     for source_file in &bobje.source_files {
         if let Ok(contents) = fs::read_to_string(source_file) {
             let mut functions = Vec::new();
@@ -689,19 +1746,112 @@ fn find_test_functions(bobje: &Bobje) -> Vec<TestFunction> {
     test_functions
 }
 
+const TEST_MAIN: &str = r#"
+#define ANSI_COLOR_RED "\x1b[31m"
+#define ANSI_COLOR_GREEN "\x1b[32m"
+#define ANSI_COLOR_RESET "\x1b[0m"
+
+static const char *suite_filter = NULL;
+static const char *test_filter = NULL;
+static int list_suites = 0;
+static const char *current_suite = NULL;
+static double test_start_ms;
+static unsigned int tests_run = 0;
+static unsigned int tests_failed = 0;
+
+static double now_ms(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec * 1e3 + (double)ts.tv_nsec / 1e6;
+}
+
+// Register the test when it matches the filters, its suite is added on the first match
+static void add_test(CU_pSuite *suite, const char *suite_name, const char *test_name, CU_TestFunc function) {
+    if ((suite_filter != NULL && strcmp(suite_filter, suite_name) != 0) ||
+        (test_filter != NULL && strstr(test_name, test_filter) == NULL)) {
+        return;
+    }
+    if (*suite == NULL) {
+        if (list_suites) printf("%s\n", suite_name);
+        *suite = CU_add_suite(suite_name, 0, 0);
+    }
+    CU_add_test(*suite, test_name, function);
+}
+
+static void on_test_start(const CU_pTest test, const CU_pSuite suite) {
+    if (current_suite != suite->pName) {
+        current_suite = suite->pName;
+        printf("Suite: %s\n", suite->pName);
+    }
+    // Flush, so a crashing test is still reported
+    printf("  Test: %-48s ", test->pName);
+    fflush(stdout);
+    test_start_ms = now_ms();
+}
+
+static void on_test_complete(const CU_pTest test, const CU_pSuite suite, const CU_pFailureRecord failure) {
+    (void)test;
+    (void)suite;
+    double duration = now_ms() - test_start_ms;
+    tests_run++;
+    if (failure == NULL) {
+        printf(ANSI_COLOR_GREEN "passed" ANSI_COLOR_RESET " %10.3f ms\n", duration);
+    } else {
+        tests_failed++;
+        printf(ANSI_COLOR_RED "FAILED" ANSI_COLOR_RESET " %10.3f ms\n", duration);
+        for (CU_pFailureRecord record = failure; record != NULL; record = record->pNext) {
+            printf("    %s:%u - %s\n", record->strFileName, record->uiLineNumber, record->strCondition);
+        }
+    }
+    fflush(stdout);
+}
+
+int main(int argc, char **argv) {
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--list") == 0) list_suites = 1;
+        if (strcmp(argv[i], "--suite") == 0 && i + 1 < argc) suite_filter = argv[++i];
+        if (strcmp(argv[i], "--test") == 0 && i + 1 < argc) test_filter = argv[++i];
+    }
+
+    CU_initialize_registry();
+    register_tests();
+    if (list_suites) {
+        CU_cleanup_registry();
+        return EXIT_SUCCESS;
+    }
+
+    CU_set_test_start_handler(on_test_start);
+    CU_set_test_complete_handler(on_test_complete);
+    CU_run_all_tests();
+    printf("Tests run: %u, failed: %u\n", tests_run, tests_failed);
+
+    CU_cleanup_registry();
+    return tests_failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+"#;
+
+/// Generate the CUnit test main, it runs the tests matching the `--suite <name>` and
+/// `--test <substring>` filters and `--list` prints the matching suites.
 pub(crate) fn generate_cx_test_main(bobje: &mut Bobje) {
     let test_functions = find_test_functions(bobje);
 
     let mut s = String::new();
     _ = writeln!(s, "// This file is generated by bob, do not edit!");
-    _ = writeln!(s, "\n#include <CUnit/Basic.h>\n");
+    _ = writeln!(s, "\n#include <stdio.h>");
+    _ = writeln!(s, "#include <stdlib.h>");
+    _ = writeln!(s, "#include <string.h>");
+    _ = writeln!(s, "#include <time.h>\n");
+    _ = writeln!(s, "#include <CUnit/Basic.h>\n");
     for test_function in &test_functions {
         for function in &test_function.functions {
             _ = writeln!(s, "extern void {function}(void);");
         }
     }
-    _ = writeln!(s, "\nint main(void) {{");
-    _ = writeln!(s, "    CU_initialize_registry();\n");
+    _ = writeln!(
+        s,
+        "\nstatic void add_test(CU_pSuite *suite, const char *suite_name, const char *test_name, CU_TestFunc function);"
+    );
+    _ = writeln!(s, "\nstatic void register_tests(void) {{");
     for test_function in &test_functions {
         let module_name_suite = format!(
             "{}_suite",
@@ -718,40 +1868,221 @@ pub(crate) fn generate_cx_test_main(bobje: &mut Bobje) {
                 .trim_end_matches(".mm")
                 .replace(['/', '\\'], "_")
         );
-        _ = writeln!(
-            s,
-            "    CU_pSuite {} = CU_add_suite(\"{}\", 0, 0);",
-            module_name_suite, test_function.source_file
-        );
+        _ = writeln!(s, "    CU_pSuite {module_name_suite} = NULL;");
         for function in &test_function.functions {
             _ = writeln!(
                 s,
-                "    CU_add_test({module_name_suite}, \"{function}\", {function});"
+                "    add_test(&{module_name_suite}, \"{}\", \"{function}\", {function});",
+                test_function.source_file
             );
         }
-        _ = writeln!(s);
     }
-    _ = writeln!(
-        s,
-        r#"    CU_basic_set_mode(CU_BRM_VERBOSE);
-    CU_basic_run_tests();
+    _ = writeln!(s, "}}");
+    s.push_str(TEST_MAIN);
+
+    let dest = format!("{}/src-gen/test_main.c", bobje.out_dir());
+    write_file_when_different(&dest, &s).expect("Can't write src-gen/test_main.c");
+    bobje.source_files.push(dest);
+}
+
+// MARK: Benchmarks
+const BENCH_HEADER: &str = r#"// This file is generated by bob, do not edit!
+#pragma once
+
+#include <stdint.h>
+
+// A benchmark function runs the benchmarked code `iterations` times, it can set the bytes one
+// iteration processes to report the throughput
+typedef struct bench_t {
+    uint64_t iterations;
+    uint64_t bytes;
+} bench_t;
+
+// Keep a value alive, so the compiler can't optimize the benchmarked code away
+static inline void bench_black_box(const void *value) {
+#if defined(__GNUC__) || defined(__clang__)
+    __asm__ volatile("" : : "r"(value) : "memory");
+#else
+    (void)value;
+#endif
+}
+"#;
+
+const BENCH_MAIN: &str = r#"
+typedef struct bench_result_t {
+    double ns_per_iter;
+    double ci;
+    uint64_t bytes;
+} bench_result_t;
+
+#define BENCH_SAMPLE_NS 10000000.0
+#define BENCH_SAMPLES 20
+// Two sided 95% t-distribution value for BENCH_SAMPLES - 1 degrees of freedom
+#define BENCH_T_95 2.093
+// Changes smaller than this percentage are never reported
+#define BENCH_THRESHOLD 5.0
 
 #define ANSI_COLOR_RED "\x1b[31m"
 #define ANSI_COLOR_GREEN "\x1b[32m"
 #define ANSI_COLOR_RESET "\x1b[0m"
-    int number_of_failures = CU_get_number_of_failures();
-    if (number_of_failures == 0) {{
-        printf(ANSI_COLOR_GREEN "All tests passed!" ANSI_COLOR_RESET "\n");
-    }} else {{
-        printf(ANSI_COLOR_RED "%d tests failed!" ANSI_COLOR_RESET "\n", number_of_failures);
-    }}
 
-    CU_cleanup_registry();
-    return CU_get_error();
-}}"#
+static double bench_now_ns(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static double bench_sqrt(double x) {
+    double root = x > 1.0 ? x : 1.0;
+    for (int i = 0; i < 64; i++) root = (root + x / root) / 2.0;
+    return root;
+}
+
+static double bench_run(void (*function)(bench_t *), uint64_t iterations, uint64_t *bytes) {
+    bench_t bench = {iterations, 0};
+    double start = bench_now_ns();
+    function(&bench);
+    double duration = bench_now_ns() - start;
+    *bytes = bench.bytes;
+    return duration;
+}
+
+// Double the iterations until a sample takes long enough to time precisely, then take the
+// samples and return the mean time per iteration with its 95% confidence interval
+static bench_result_t bench_measure(void (*function)(bench_t *)) {
+    uint64_t iterations = 1;
+    uint64_t bytes = 0;
+    while (bench_run(function, iterations, &bytes) < BENCH_SAMPLE_NS && iterations < (UINT64_C(1) << 40)) {
+        iterations *= 2;
+    }
+
+    double samples[BENCH_SAMPLES];
+    double sum = 0.0;
+    for (int i = 0; i < BENCH_SAMPLES; i++) {
+        samples[i] = bench_run(function, iterations, &bytes) / (double)iterations;
+        sum += samples[i];
+    }
+    double mean = sum / BENCH_SAMPLES;
+    double variance = 0.0;
+    for (int i = 0; i < BENCH_SAMPLES; i++) {
+        variance += (samples[i] - mean) * (samples[i] - mean);
+    }
+    variance /= BENCH_SAMPLES - 1;
+    bench_result_t result = {mean, BENCH_T_95 * bench_sqrt(variance / BENCH_SAMPLES), bytes};
+    return result;
+}
+
+static int bench_read_baseline(const char *path, const char *name, bench_result_t *result) {
+    FILE *file = path != NULL ? fopen(path, "r") : NULL;
+    if (file == NULL) return 0;
+    char line[512];
+    char line_name[256];
+    int found = 0;
+    while (!found && fgets(line, sizeof(line), file) != NULL) {
+        found = sscanf(line, " {\"name\": \"%255[^\"]\", \"ns_per_iter\": %lf, \"ci\": %lf}", line_name,
+                       &result->ns_per_iter, &result->ci) == 3 &&
+                strcmp(line_name, name) == 0;
+    }
+    fclose(file);
+    return found;
+}
+
+int main(int argc, char **argv) {
+    const char *baseline_path = NULL;
+    const char *save_path = NULL;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "--baseline") == 0) baseline_path = argv[i + 1];
+        if (strcmp(argv[i], "--save") == 0) save_path = argv[i + 1];
+    }
+
+    // Read all baselines before the results can overwrite them
+    size_t bench_count = sizeof(benches) / sizeof(benches[0]);
+    bench_result_t baselines[sizeof(benches) / sizeof(benches[0])];
+    int has_baselines[sizeof(benches) / sizeof(benches[0])];
+    for (size_t i = 0; i < bench_count; i++) {
+        has_baselines[i] = bench_read_baseline(baseline_path, benches[i].name, &baselines[i]);
+    }
+
+    bench_result_t results[sizeof(benches) / sizeof(benches[0])];
+    int regressions = 0;
+    for (size_t i = 0; i < bench_count; i++) {
+        results[i] = bench_measure(benches[i].function);
+        printf("%-40s %12.2f ns/iter (+/- %.2f)", benches[i].name, results[i].ns_per_iter, results[i].ci);
+        if (results[i].bytes > 0) {
+            printf(" %.2f GB/s", (double)results[i].bytes / results[i].ns_per_iter);
+        }
+        if (has_baselines[i]) {
+            double difference = results[i].ns_per_iter - baselines[i].ns_per_iter;
+            double change = difference / baselines[i].ns_per_iter * 100.0;
+            int significant = (difference > 0 ? difference : -difference) > results[i].ci + baselines[i].ci;
+            if (significant && change > BENCH_THRESHOLD) {
+                printf(ANSI_COLOR_RED " regressed %+.1f%%" ANSI_COLOR_RESET, change);
+                regressions++;
+            } else if (significant && change < -BENCH_THRESHOLD) {
+                printf(ANSI_COLOR_GREEN " improved %+.1f%%" ANSI_COLOR_RESET, change);
+            } else {
+                printf(" no change %+.1f%%", change);
+            }
+        }
+        printf("\n");
+    }
+
+    FILE *file = save_path != NULL ? fopen(save_path, "w") : NULL;
+    if (file != NULL) {
+        fprintf(file, "[\n");
+        for (size_t i = 0; i < bench_count; i++) {
+            fprintf(file, "  {\"name\": \"%s\", \"ns_per_iter\": %.3f, \"ci\": %.3f}%s\n", benches[i].name,
+                    results[i].ns_per_iter, results[i].ci, i + 1 < bench_count ? "," : "");
+        }
+        fprintf(file, "]\n");
+        fclose(file);
+    }
+
+    if (regressions > 0) {
+        printf(ANSI_COLOR_RED "%d benchmarks regressed!" ANSI_COLOR_RESET "\n", regressions);
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+"#;
+
+/// Generate the `bob/bench.h` header with the `bench_t` type and the benchmark harness main.
+pub(crate) fn generate_cx_bench_main(bobje: &mut Bobje) {
+    let header_dest = format!("{}/include/bob/bench.h", bobje.out_dir());
+    write_file_when_different(&header_dest, BENCH_HEADER).expect("Can't write bob/bench.h");
+
+    let bench_functions = find_bench_functions(bobje);
+    if bench_functions.is_empty() {
+        eprintln!("No benchmark functions found, add void bench_*(bench_t *) functions");
+        exit(1);
+    }
+
+    let mut s = String::new();
+    _ = writeln!(s, "// This file is generated by bob, do not edit!");
+    _ = writeln!(s, "\n#define _CRT_SECURE_NO_WARNINGS\n");
+    _ = writeln!(s, "#include <stdio.h>");
+    _ = writeln!(s, "#include <stdlib.h>");
+    _ = writeln!(s, "#include <string.h>");
+    _ = writeln!(s, "#include <time.h>\n");
+    _ = writeln!(s, "#include <bob/bench.h>\n");
+    for bench_function in &bench_functions {
+        for function in &bench_function.functions {
+            _ = writeln!(s, "extern void {function}(bench_t *bench);");
+        }
+    }
+    _ = writeln!(
+        s,
+        "\nstatic const struct {{\n    const char *name;\n    void (*function)(bench_t *);\n}} benches[] = {{"
     );
+    for bench_function in &bench_functions {
+        for function in &bench_function.functions {
+            _ = writeln!(s, "    {{\"{function}\", {function}}},");
+        }
+    }
+    _ = writeln!(s, "}};");
+    s.push_str(BENCH_MAIN);
 
-    let dest = format!("{}/src-gen/test_main.c", bobje.out_dir_with_target());
-    write_file_when_different(&dest, &s).expect("Can't write src-gen/test_main.c");
+    let dest = format!("{}/src-gen/bench_main.c", bobje.out_dir());
+    write_file_when_different(&dest, &s).expect("Can't write src-gen/bench_main.c");
     bobje.source_files.push(dest);
 }
@@ -165,7 +165,7 @@ pub(crate) fn generate_javac_kotlinc_tasks(bobje: &Bobje, executor: &mut Executo
     }
 }
 
-pub(crate) fn run_java_class(bobje: &Bobje) -> ! {
+pub(crate) fn run_java_class(bobje: &Bobje) -> i32 {
     let java_bin = jdk_bin("java");
     let status = Command::new(&java_bin)
         .arg("-cp")
@@ -176,10 +176,10 @@ pub(crate) fn run_java_class(bobje: &Bobje) -> ! {
         }))
         .status()
         .expect("Failed to execute java");
-    exit(status.code().unwrap_or(1))
+    status.code().unwrap_or(1)
 }
 
-pub(crate) fn run_junit_tests(bobje: &Bobje) -> ! {
+pub(crate) fn run_junit_tests(bobje: &Bobje) -> i32 {
     let java_bin = jdk_bin("java");
     let mut cmd = Command::new(&java_bin);
     cmd.arg("-cp")
@@ -192,7 +192,7 @@ pub(crate) fn run_junit_tests(bobje: &Bobje) -> ! {
     }
 
     let status = cmd.status().expect("JUnit tests failed");
-    exit(status.code().unwrap_or(1))
+    status.code().unwrap_or(1)
 }
 
 // MARK: Jar tasks
@@ -324,7 +324,7 @@ pub(crate) fn generate_jar_tasks(bobje: &Bobje, executor: &mut ExecutorBuilder)
     );
 }
 
-pub(crate) fn run_jar(bobje: &Bobje) -> ! {
+pub(crate) fn run_jar(bobje: &Bobje) -> i32 {
     let status = Command::new("java")
         .arg("-jar")
         .arg(format!(
@@ -335,7 +335,7 @@ pub(crate) fn run_jar(bobje: &Bobje) -> ! {
         ))
         .status()
         .expect("Failed to execute java");
-    exit(status.code().unwrap_or(1))
+    status.code().unwrap_or(1)
 }
 
 // MARK: Utils
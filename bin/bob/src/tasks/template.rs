@@ -30,7 +30,7 @@ pub(crate) fn process_templates(bobje: &mut Bobje, _executor: &mut ExecutorBuild
         });
         let dest = format!(
             "{}/src-gen/{}",
-            bobje.out_dir_with_target(),
+            bobje.out_dir(),
             path.rsplit("src/")
                 .next()
                 .expect("Can't get file stem")
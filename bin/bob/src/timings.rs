@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) 2025 Bastiaan van der Plaat
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+use std::fmt::Write;
+use std::time::Duration;
+use std::{fs, io};
+
+/// Number of slowest tasks printed after the critical path.
+const SLOWEST_TASKS: usize = 10;
+
+// MARK: TaskTiming
+/// When a task ran relative to the start of the build and on which pool worker.
+pub(crate) struct TaskTiming {
+    pub start: Duration,
+    pub end: Duration,
+    pub worker: usize,
+    pub line: String,
+}
+
+impl TaskTiming {
+    const fn duration(&self) -> Duration {
+        self.end.saturating_sub(self.start)
+    }
+}
+
+// MARK: Trace
+/// Write the timings as Chrome trace events, which Perfetto and chrome://tracing load.
+pub(crate) fn write_trace(path: &str, timings: &[TaskTiming]) -> io::Result<()> {
+    let mut s = String::from("{\"traceEvents\":[");
+    for (index, timing) in timings.iter().enumerate() {
+        if index > 0 {
+            s.push(',');
+        }
+        _ = write!(
+            s,
+            "\n{{\"name\":\"{}\",\"cat\":\"task\",\"ph\":\"X\",\"ts\":{},\"dur\":{},\"pid\":1,\"tid\":{}}}",
+            escape_json(&timing.line),
+            timing.start.as_micros(),
+            timing.duration().as_micros(),
+            timing.worker
+        );
+    }
+    s.push_str("\n]}\n");
+    fs::write(path, s)
+}
+
+fn escape_json(s: &str) -> String {
+    let mut escaped = String::with_capacity(s.len());
+    for c in s.chars() {
+        match c {
+            '"' => escaped.push_str("\\\""),
+            '\\' => escaped.push_str("\\\\"),
+            '\n' => escaped.push_str("\\n"),
+            c if (c as u32) < 0x20 => _ = write!(escaped, "\\u{:04x}", c as u32),
+            c => escaped.push(c),
+        }
+    }
+    escaped
+}
+
+// MARK: Report
+/// Print the chain of dependent tasks that took the longest, which bounds the build time no
+/// matter the number of threads, followed by the slowest tasks. The tasks are ordered so
+/// dependencies come before their dependents.
+pub(crate) fn print_timings(timings: &[TaskTiming], dependencies: &[Vec<usize>]) {
+    let mut path_durations = vec![Duration::ZERO; timings.len()];
+    let mut path_previous = vec![None; timings.len()];
+    for (index, timing) in timings.iter().enumerate() {
+        let previous = dependencies[index]
+            .iter()
+            .copied()
+            .max_by_key(|&dependency| path_durations[dependency]);
+        path_durations[index] = previous
+            .map_or(Duration::ZERO, |previous| path_durations[previous])
+            + timing.duration();
+        path_previous[index] = previous;
+    }
+
+    let Some(mut index) = (0..timings.len()).max_by_key(|&index| path_durations[index]) else {
+        return;
+    };
+    let mut critical_path = vec![index];
+    while let Some(previous) = path_previous[index] {
+        critical_path.push(previous);
+        index = previous;
+    }
+    println!("Critical path: {:.2?}", path_durations[critical_path[0]]);
+    for &index in critical_path.iter().rev() {
+        println!(
+            "  {:>10.2?}  {}",
+            timings[index].duration(),
+            timings[index].line
+        );
+    }
+
+    let mut slowest = timings.iter().collect::<Vec<_>>();
+    slowest.sort_by_key(|timing| std::cmp::Reverse(timing.duration()));
+    println!("Slowest tasks:");
+    for timing in slowest.iter().take(SLOWEST_TASKS) {
+        println!("  {:>10.2?}  {}", timing.duration(), timing.line);
+    }
+}
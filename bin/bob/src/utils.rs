@@ -14,6 +14,20 @@ pub(crate) fn cache_dir() -> PathBuf {
     project_dirs.cache_dir()
 }
 
+/// Command that runs a shell command line, on Windows the command is split on spaces.
+pub(crate) fn shell_command(command: &str) -> Command {
+    if cfg!(windows) {
+        let parts = command.split(' ').collect::<Vec<_>>();
+        let mut shell_command = Command::new(parts[0]);
+        shell_command.args(&parts[1..]);
+        shell_command
+    } else {
+        let mut shell_command = Command::new("sh");
+        shell_command.arg("-c").arg(command);
+        shell_command
+    }
+}
+
 pub(crate) fn format_bytes(bytes: u64) -> String {
     const KIB: u64 = 1024;
     const MIB: u64 = KIB * 1024;
@@ -43,7 +57,6 @@ pub(crate) fn write_file_when_different(path: &str, contents: &str) -> io::Resul
     Ok(())
 }
 
-#[cfg(target_os = "macos")]
 pub(crate) fn write_bytes_when_different(path: &str, contents: &[u8]) -> io::Result<()> {
     if let Ok(existing) = fs::read(path)
         && existing == contents
@@ -82,6 +95,20 @@ pub(crate) fn index_files(dir: &str) -> Vec<String> {
     files
 }
 
+/// All directories below a directory.
+pub(crate) fn index_dirs(dir: &str) -> Vec<String> {
+    let mut dirs = Vec::new();
+    for entry in fs::read_dir(dir).into_iter().flatten().flatten() {
+        let path = entry.path();
+        if path.is_dir() {
+            let path = path.to_string_lossy().to_string();
+            dirs.extend(index_dirs(&path));
+            dirs.push(path);
+        }
+    }
+    dirs
+}
+
 #[allow(dead_code)]
 pub(crate) fn spawn_service(program: &str, args: &[&str]) -> io::Result<()> {
     let mut command = Command::new(program);
@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) 2026 Bastiaan van der Plaat
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+// ref() / free() pairs on a plain object and on a @shared object with atomic refs
+// Run with: ccc -r benches/atomic_refs.cc, and again with --atomic-refs to make every class shared
+
+#include <time.h>
+
+#include <Object.hh>
+
+#define COUNT 1024
+#define ROUNDS 100000
+
+class Node {
+    @init i32 value;
+};
+
+@shared class SharedNode {
+    @init i32 value;
+};
+
+f64 now(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (f64)ts.tv_sec + (f64)ts.tv_nsec / 1e9;
+}
+
+int main(void) {
+    Node* nodes[COUNT];
+    SharedNode* shared_nodes[COUNT];
+    for (usize i = 0; i < COUNT; i++) {
+        nodes[i] = node_new((i32)i);
+        shared_nodes[i] = shared_node_new((i32)i);
+    }
+
+    f64 start = now();
+    for (usize r = 0; r < ROUNDS; r++)
+        for (usize i = 0; i < COUNT; i++)
+            node_free(node_ref(nodes[i]));
+    printf("plain    %6.2f ns/ref+free\n", (now() - start) * 1e9 / ((f64)ROUNDS * COUNT));
+
+    start = now();
+    for (usize r = 0; r < ROUNDS; r++)
+        for (usize i = 0; i < COUNT; i++)
+            shared_node_free(shared_node_ref(shared_nodes[i]));
+    printf("@shared  %6.2f ns/ref+free\n", (now() - start) * 1e9 / ((f64)ROUNDS * COUNT));
+
+    for (usize i = 0; i < COUNT; i++) {
+        shared_node_free(shared_nodes[i]);
+        node_free(nodes[i]);
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,171 @@
+/*
+ * Copyright (c) 2026 Bastiaan van der Plaat
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+// instanceof<> against an abstract base with many concrete subclasses, the widget toolkit case
+// Run with: ccc -r benches/class_instanceof.cc
+
+#include <time.h>
+
+#include <Object.hh>
+
+#define ROUNDS 100000000
+
+class Widget {
+    virtual i32 kind() = 0;
+};
+
+class Control : Widget {
+    virtual i32 kind() = 0;
+};
+
+class Button : Control {
+    virtual i32 kind();
+};
+i32 Button::kind() {
+    (void)this;
+    return 0;
+}
+
+class Label : Control {
+    virtual i32 kind();
+};
+i32 Label::kind() {
+    (void)this;
+    return 1;
+}
+
+class Slider : Control {
+    virtual i32 kind();
+};
+i32 Slider::kind() {
+    (void)this;
+    return 2;
+}
+
+class Checkbox : Control {
+    virtual i32 kind();
+};
+i32 Checkbox::kind() {
+    (void)this;
+    return 3;
+}
+
+class Radio : Control {
+    virtual i32 kind();
+};
+i32 Radio::kind() {
+    (void)this;
+    return 4;
+}
+
+class Toggle : Control {
+    virtual i32 kind();
+};
+i32 Toggle::kind() {
+    (void)this;
+    return 5;
+}
+
+class Spinner : Control {
+    virtual i32 kind();
+};
+i32 Spinner::kind() {
+    (void)this;
+    return 6;
+}
+
+class Tooltip : Control {
+    virtual i32 kind();
+};
+i32 Tooltip::kind() {
+    (void)this;
+    return 7;
+}
+
+class Image : Control {
+    virtual i32 kind();
+};
+i32 Image::kind() {
+    (void)this;
+    return 8;
+}
+
+class Icon : Control {
+    virtual i32 kind();
+};
+i32 Icon::kind() {
+    (void)this;
+    return 9;
+}
+
+class Menu : Control {
+    virtual i32 kind();
+};
+i32 Menu::kind() {
+    (void)this;
+    return 10;
+}
+
+class Tab : Control {
+    virtual i32 kind();
+};
+i32 Tab::kind() {
+    (void)this;
+    return 11;
+}
+
+class Table : Control {
+    virtual i32 kind();
+};
+i32 Table::kind() {
+    (void)this;
+    return 12;
+}
+
+class Tree : Control {
+    virtual i32 kind();
+};
+i32 Tree::kind() {
+    (void)this;
+    return 13;
+}
+
+class Scrollbar : Control {
+    virtual i32 kind();
+};
+i32 Scrollbar::kind() {
+    (void)this;
+    return 14;
+}
+
+class Splitter : Control {
+    virtual i32 kind();
+};
+i32 Splitter::kind() {
+    (void)this;
+    return 15;
+}
+
+f64 now(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (f64)ts.tv_sec + (f64)ts.tv_nsec / 1e9;
+}
+
+int main(void) {
+    // The last declared leaf is the worst case for a check that walks all subclasses
+    Object* widgets[2] = {(Object*)splitter_new(), object_new()};
+
+    usize hits = 0;
+    f64 start = now();
+    for (i64 i = 0; i < ROUNDS; i++)
+        hits += instanceof<Control>(widgets[i & 1]);
+    printf("instanceof<Control> %6.2f ns/op (%zu)\n", (now() - start) * 1e9 / ROUNDS, hits);
+
+    object_free(widgets[1]);
+    object_free(widgets[0]);
+    return EXIT_SUCCESS;
+}
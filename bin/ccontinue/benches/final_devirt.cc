@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) 2026 Bastiaan van der Plaat
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+// Virtual getter in a hot loop, dispatched through the vtbl or called directly on a @final class
+// Run with: ccc -r benches/final_devirt.cc
+
+#include <time.h>
+
+#include <Object.hh>
+
+#define COUNT 1024
+#define ROUNDS 200000
+
+class Particle {
+    @init f32 mass;
+
+    virtual f32 weight();
+};
+f32 Particle::weight() {
+    return this->mass * 9.81f;
+}
+
+@final class FinalParticle {
+    @init f32 mass;
+
+    virtual f32 weight();
+};
+f32 FinalParticle::weight() {
+    return this->mass * 9.81f;
+}
+
+f64 now(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (f64)ts.tv_sec + (f64)ts.tv_nsec / 1e9;
+}
+
+int main(void) {
+    Particle* particles[COUNT];
+    FinalParticle* final_particles[COUNT];
+    for (usize i = 0; i < COUNT; i++) {
+        particles[i] = particle_new((f32)i);
+        final_particles[i] = final_particle_new((f32)i);
+    }
+
+    f32 total = 0;
+    f64 start = now();
+    for (usize r = 0; r < ROUNDS; r++)
+        for (usize i = 0; i < COUNT; i++)
+            total += particle_weight(particles[i]);
+    printf("virtual  %6.2f ns/call (%.0f)\n", (now() - start) * 1e9 / ((f64)ROUNDS * COUNT), total);
+
+    total = 0;
+    start = now();
+    for (usize r = 0; r < ROUNDS; r++)
+        for (usize i = 0; i < COUNT; i++)
+            total += final_particle_weight(final_particles[i]);
+    printf("@final   %6.2f ns/call (%.0f)\n", (now() - start) * 1e9 / ((f64)ROUNDS * COUNT), total);
+
+    for (usize i = 0; i < COUNT; i++) {
+        final_particle_free(final_particles[i]);
+        particle_free(particles[i]);
+    }
+    return EXIT_SUCCESS;
+}
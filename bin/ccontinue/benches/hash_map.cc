@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) 2026 Bastiaan van der Plaat
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+// Compares the linear probing Map against the Swiss table HashMap
+// Run with: ccc -r benches/hash_map.cc
+
+#include <time.h>
+
+#include <HashMap.hh>
+#include <Map.hh>
+#include <String.hh>
+
+#define COUNT 1000000
+
+f64 now(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (f64)ts.tv_sec + (f64)ts.tv_nsec / 1e9;
+}
+
+void report(char* name, f64 start, f64 end) {
+    printf("%-24s %8.1f ns/op\n", name, (end - start) * 1e9 / COUNT);
+}
+
+void bench_keys(char* label, IKeyable* keys) {
+    char name[64];
+    Int* value = @0;
+
+    Map* map = map_new();
+    f64 start = now();
+    for (usize i = 0; i < COUNT; i++)
+        map_set(map, keys[i], object_ref(value));
+    snprintf(name, sizeof(name), "Map::set %s", label);
+    report(name, start, now());
+    start = now();
+    for (usize i = 0; i < COUNT; i++)
+        map_get(map, keys[i]);
+    snprintf(name, sizeof(name), "Map::get %s", label);
+    report(name, start, now());
+    map_free(map);
+
+    HashMap* hash_map = hash_map_new();
+    start = now();
+    for (usize i = 0; i < COUNT; i++)
+        hash_map_set(hash_map, keys[i], object_ref(value));
+    snprintf(name, sizeof(name), "HashMap::set %s", label);
+    report(name, start, now());
+    start = now();
+    for (usize i = 0; i < COUNT; i++)
+        hash_map_get(hash_map, keys[i]);
+    snprintf(name, sizeof(name), "HashMap::get %s", label);
+    report(name, start, now());
+    hash_map_free(hash_map);
+
+    int_free(value);
+}
+
+int main(void) {
+    IKeyable* keys = malloc(COUNT * sizeof(IKeyable));
+
+    for (usize i = 0; i < COUNT; i++)
+        keys[i] = cast<IKeyable>(int_new((i64)i));
+    bench_keys("Int", keys);
+    for (usize i = 0; i < COUNT; i++)
+        object_free((Object*)keys[i].obj);
+
+    for (usize i = 0; i < COUNT; i++) {
+        char buf[32];
+        snprintf(buf, sizeof(buf), "key-%zu", i);
+        keys[i] = cast<IKeyable>(string_new(buf));
+    }
+    bench_keys("String", keys);
+    for (usize i = 0; i < COUNT; i++)
+        object_free((Object*)keys[i].obj);
+
+    free(keys);
+    return EXIT_SUCCESS;
+}
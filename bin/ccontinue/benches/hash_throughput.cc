@@ -0,0 +1,59 @@
+/*
+ * Copyright (c) 2026 Bastiaan van der Plaat
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+// Byte hash throughput of wyhash against the old fnv1a_32, and the integer mixer behind Int::hash
+// Run with: ccc -r benches/hash_throughput.cc
+
+#include <time.h>
+
+#include <Object.hh>
+
+#define BYTES (256 * 1024 * 1024)
+#define INT_KEYS 100000000
+
+f64 now(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (f64)ts.tv_sec + (f64)ts.tv_nsec / 1e9;
+}
+
+void report(char* name, usize size, f64 start, f64 end, usize sink) {
+    printf("%-10s %5zu B %8.2f GB/s (%zx)\n", name, size, (f64)BYTES / (end - start) / 1e9, sink & 0xf);
+}
+
+int main(void) {
+    usize sizes[] = {8, 64, 4096};
+    u8* data = malloc(4096 + 64);
+    for (usize i = 0; i < 4096 + 64; i++)
+        data[i] = (u8)(i * 31);
+
+    for (usize s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        usize size = sizes[s];
+        usize rounds = BYTES / size;
+        usize sink = 0;
+        f64 start = now();
+        for (usize i = 0; i < rounds; i++)
+            sink += fnv1a_32(data + (i & 63), size);
+        report("fnv1a_32", size, start, now(), sink);
+        start = now();
+        for (usize i = 0; i < rounds; i++)
+            sink += hash_bytes(data + (i & 63), size);
+        report("hash_bytes", size, start, now(), sink);
+    }
+    free(data);
+
+    // Int::hash before and after: fnv1a_32 over the 8 value bytes against the integer mixer
+    usize sink = 0;
+    f64 start = now();
+    for (i64 i = 0; i < INT_KEYS; i++)
+        sink += fnv1a_32(&i, sizeof(i));
+    printf("fnv1a_32   i64 %8.2f ns/op (%zx)\n", (now() - start) * 1e9 / INT_KEYS, sink & 0xf);
+    start = now();
+    for (i64 i = 0; i < INT_KEYS; i++)
+        sink += hash_u64((u64)i);
+    printf("hash_u64   i64 %8.2f ns/op (%zx)\n", (now() - start) * 1e9 / INT_KEYS, sink & 0xf);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) 2026 Bastiaan van der Plaat
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+// cast<> and instanceof<> on a class implementing eight interfaces, checking the last one
+// Run with: ccc -r benches/interface_cast.cc
+
+#include <time.h>
+
+#include <Object.hh>
+
+#define ROUNDS 100000000
+
+class IPaint { i64 paint(); };
+class ILayout { i64 layout(); };
+class IFocus { i64 focus(); };
+class IScroll { i64 scroll(); };
+class IDrag { i64 drag(); };
+class IDrop { i64 drop(); };
+class IHover { i64 hover(); };
+class IResize { i64 resize(); };
+
+class Widget : IPaint, ILayout, IFocus, IScroll, IDrag, IDrop, IHover, IResize {
+    @init i64 value;
+
+    virtual i64 paint();
+    virtual i64 layout();
+    virtual i64 focus();
+    virtual i64 scroll();
+    virtual i64 drag();
+    virtual i64 drop();
+    virtual i64 hover();
+    virtual i64 resize();
+};
+i64 Widget::paint() {
+    return this->value;
+}
+
+i64 Widget::layout() {
+    return this->value;
+}
+
+i64 Widget::focus() {
+    return this->value;
+}
+
+i64 Widget::scroll() {
+    return this->value;
+}
+
+i64 Widget::drag() {
+    return this->value;
+}
+
+i64 Widget::drop() {
+    return this->value;
+}
+
+i64 Widget::hover() {
+    return this->value;
+}
+
+i64 Widget::resize() {
+    return this->value + 1;
+}
+
+f64 now(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (f64)ts.tv_sec + (f64)ts.tv_nsec / 1e9;
+}
+
+int main(void) {
+    Widget* widget = widget_new(1);
+
+    i64 sum = 0;
+    f64 start = now();
+    for (i64 i = 0; i < ROUNDS; i++)
+        sum += i_resize_resize(cast<IResize>(widget));
+    printf("cast<IResize> + call   %6.2f ns/op (%lld)\n", (now() - start) * 1e9 / ROUNDS, (long long)sum);
+
+    usize hits = 0;
+    start = now();
+    for (i64 i = 0; i < ROUNDS; i++)
+        hits += instanceof<IResize>(widget);
+    printf("instanceof<IResize>    %6.2f ns/op (%zu)\n", (now() - start) * 1e9 / ROUNDS, hits);
+
+    widget_free(widget);
+    return EXIT_SUCCESS;
+}
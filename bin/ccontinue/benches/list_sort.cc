@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) 2026 Bastiaan van der Plaat
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+// Sorting 10^6 boxed values: qsort() with a comparator calling through IComparable against
+// list_sort() and list_sort_stable()
+// Run with: ccc -r benches/list_sort.cc
+
+#include <time.h>
+
+#include <List.hh>
+#include <String.hh>
+
+#define COUNT 1000000
+
+f64 now(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (f64)ts.tv_sec + (f64)ts.tv_nsec / 1e9;
+}
+
+static int compare_comparable(const void* a, const void* b) {
+    Object* left = *(Object* const*)a;
+    Object* right = *(Object* const*)b;
+    return i_comparable_compare(cast<IComparable>(left), right);
+}
+
+static u64 seed = 12345;
+static u64 random_u64(void) {
+    seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+    return seed >> 33;
+}
+
+static List* random_list(bool strings) {
+    List* list = list_new_with_capacity(COUNT);
+    for (usize i = 0; i < COUNT; i++) {
+        if (strings) {
+            char buffer[32];
+            snprintf(buffer, sizeof(buffer), "key-%llu", (unsigned long long)random_u64());
+            list_add(list, (Object*)string_new(buffer));
+        } else {
+            list_add(list, (Object*)int_new((i64)random_u64()));
+        }
+    }
+    return list;
+}
+
+static void bench(char* name, bool strings) {
+    List* list = random_list(strings);
+    f64 start = now();
+    qsort(list->items, list->size, sizeof(Object*), compare_comparable);
+    printf("%s qsort        %6.1f ms\n", name, (now() - start) * 1e3);
+    list_free(list);
+
+    list = random_list(strings);
+    start = now();
+    list_sort(list);
+    printf("%s sort         %6.1f ms\n", name, (now() - start) * 1e3);
+    start = now();
+    list_sort(list);
+    printf("%s sort sorted  %6.1f ms\n", name, (now() - start) * 1e3);
+    list_free(list);
+
+    list = random_list(strings);
+    start = now();
+    list_sort_stable(list);
+    printf("%s sort_stable  %6.1f ms\n", name, (now() - start) * 1e3);
+    list_free(list);
+}
+
+int main(void) {
+    bench("Int   ", false);
+    bench("String", true);
+    return EXIT_SUCCESS;
+}
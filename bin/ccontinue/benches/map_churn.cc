@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) 2026 Bastiaan van der Plaat
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+// Insert/remove churn on Map and Set at a steady ~70% load factor
+// Run with: ccc -r benches/map_churn.cc
+
+#include <time.h>
+
+#include <Map.hh>
+#include <Set.hh>
+#include <String.hh>
+
+// 70% of a 2^20 slot table, below the 3/4 growth threshold
+#define LIVE 734003
+#define ROUNDS 2000000
+
+f64 now(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (f64)ts.tv_sec + (f64)ts.tv_nsec / 1e9;
+}
+
+void report(char* name, f64 start, f64 end, usize ops) {
+    printf("%-24s %8.1f ns/op\n", name, (end - start) * 1e9 / (f64)ops);
+}
+
+int main(void) {
+    usize count = LIVE + ROUNDS;
+    IKeyable* keys = malloc(count * sizeof(IKeyable));
+    for (usize i = 0; i < count; i++)
+        keys[i] = cast<IKeyable>(int_new((i64)(i * 2654435761u)));
+    Int* value = @0;
+
+    Map* map = map_new();
+    for (usize i = 0; i < LIVE; i++)
+        map_set(map, keys[i], object_ref(value));
+    f64 start = now();
+    for (usize i = 0; i < ROUNDS; i++) {
+        map_remove(map, keys[i]);
+        map_set(map, keys[LIVE + i], object_ref(value));
+    }
+    report("Map remove+set", start, now(), ROUNDS);
+    start = now();
+    for (usize i = ROUNDS; i < count; i++)
+        map_get(map, keys[i]);
+    report("Map::get after churn", start, now(), LIVE);
+    map_free(map);
+
+    Set* set = set_new();
+    for (usize i = 0; i < LIVE; i++)
+        set_add(set, keys[i]);
+    start = now();
+    for (usize i = 0; i < ROUNDS; i++) {
+        set_remove(set, keys[i]);
+        set_add(set, keys[LIVE + i]);
+    }
+    report("Set remove+add", start, now(), ROUNDS);
+    start = now();
+    for (usize i = ROUNDS; i < count; i++)
+        set_contains(set, keys[i]);
+    report("Set::contains after churn", start, now(), LIVE);
+    set_free(set);
+
+    int_free(value);
+    for (usize i = 0; i < count; i++)
+        object_free((Object*)keys[i].obj);
+    free(keys);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) 2026 Bastiaan van der Plaat
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+// Walking every entry of a 10^6 entry map: copying the keys into a List first, for-in over the
+// slot cursor, map_foreach() and the IIterator interface
+// Run with: ccc -r benches/map_iteration.cc
+
+#include <time.h>
+
+#include <List.hh>
+#include <Map.hh>
+
+#define COUNT 1000000
+#define ROUNDS 10
+
+f64 now(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (f64)ts.tv_sec + (f64)ts.tv_nsec / 1e9;
+}
+
+static void sum_value(Object* key, Object* value, void* context) {
+    (void)key;
+    *(i64*)context += int_get_value((Int*)value);
+}
+
+int main(void) {
+    Map* map = map_new();
+    for (i64 i = 0; i < COUNT; i++) {
+        Int* key = int_new(i);
+        map_set(map, cast<IKeyable>(key), int_new(i));
+        int_free(key);
+    }
+
+    i64 sum = 0;
+    f64 start = now();
+    for (usize r = 0; r < ROUNDS; r++) {
+        List* keys = list_new_with_capacity(COUNT);
+        for (Object* key in map) {
+            list_add(keys, object_ref(key));
+        }
+        for (Int* key in keys) {
+            sum += int_get_value((Int*)map_get(map, cast<IKeyable>(key)));
+        }
+        list_free(keys);
+    }
+    printf("key list  %6.2f ns/entry (%lld)\n", (now() - start) * 1e9 / ((f64)ROUNDS * COUNT), (long long)sum);
+
+    sum = 0;
+    start = now();
+    MapValues* values = map_values(map);
+    for (usize r = 0; r < ROUNDS; r++) {
+        for (Int* value in values) {
+            sum += int_get_value(value);
+        }
+    }
+    map_values_free(values);
+    printf("for-in    %6.2f ns/entry (%lld)\n", (now() - start) * 1e9 / ((f64)ROUNDS * COUNT), (long long)sum);
+
+    sum = 0;
+    start = now();
+    for (usize r = 0; r < ROUNDS; r++)
+        map_foreach(map, sum_value, &sum);
+    printf("foreach   %6.2f ns/entry (%lld)\n", (now() - start) * 1e9 / ((f64)ROUNDS * COUNT), (long long)sum);
+
+    sum = 0;
+    start = now();
+    values = map_values(map);
+    for (usize r = 0; r < ROUNDS; r++) {
+        IIterator iterator = i_iterable_iterator(cast<IIterable>(values));
+        while (i_iterator_has_next(iterator))
+            sum += int_get_value((Int*)i_iterator_next(iterator));
+        object_free((Object*)iterator.obj);
+    }
+    map_values_free(values);
+    printf("iterator  %6.2f ns/entry (%lld)\n", (now() - start) * 1e9 / ((f64)ROUNDS * COUNT), (long long)sum);
+
+    map_free(map);
+    return EXIT_SUCCESS;
+}
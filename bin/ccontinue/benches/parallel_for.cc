@@ -0,0 +1,52 @@
+/*
+ * Copyright (c) 2026 Bastiaan van der Plaat
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+// Batch transform over a large List of Float, serial and with parallel_for on the global pool
+// Run with: ccc -r benches/parallel_for.cc
+
+#include <time.h>
+
+#include <ThreadPool.hh>
+
+#define COUNT 4000000
+
+f64 now(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (f64)ts.tv_sec + (f64)ts.tv_nsec / 1e9;
+}
+
+static void transform(Object* item, void* context) {
+    (void)context;
+    // A few Newton steps towards sqrt(x), enough work per item to be worth spreading
+    Float* value = (Float*)item;
+    f64 x = float_get_value(value) + 1.0;
+    f64 root = x;
+    for (i32 i = 0; i < 8; i++)
+        root = 0.5 * (root + x / root);
+    value->value = root;
+}
+
+int main(void) {
+    List* list = list_new_with_capacity(COUNT);
+    for (usize i = 0; i < COUNT; i++)
+        list_add(list, (Object*)float_new((f64)i));
+
+    f64 start = now();
+    for (usize i = 0; i < COUNT; i++)
+        transform(list_get(list, i), NULL);
+    f64 serial = now() - start;
+    printf("serial        %7.2f ms\n", serial * 1e3);
+
+    start = now();
+    parallel_for(list, transform, NULL);
+    f64 parallel = now() - start;
+    printf("parallel_for  %7.2f ms (%zu workers, %.1fx)\n", parallel * 1e3,
+           thread_pool_get_size(thread_pool_global()), serial / parallel);
+
+    list_free(list);
+    return EXIT_SUCCESS;
+}
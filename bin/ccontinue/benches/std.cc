@@ -0,0 +1,299 @@
+/*
+ * Copyright (c) 2026 Bastiaan van der Plaat
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+// Standard benchmark set for the std containers and strings, compare its output across releases
+// Run with: ccc --bench benches/std.cc, rerun a subset with: benches/std map_ string_
+
+#include <List.hh>
+#include <Map.hh>
+#include <Set.hh>
+#include <String.hh>
+#include <StringBuilder.hh>
+
+// Power of two working set that fits in L2, so the numbers measure the code and not the memory
+#define KEYS 4096
+
+static Int* int_keys[KEYS];
+static String* string_keys[KEYS];
+
+// Keys are created once and live until exit, outside of every measurement
+static void setup_keys(void) {
+    if (int_keys[0] != NULL)
+        return;
+    for (usize i = 0; i < KEYS; i++) {
+        int_keys[i] = int_new((i64)(i * 2654435761u));
+        char buffer[32];
+        snprintf(buffer, sizeof(buffer), "key-%zu", i * 2654435761u);
+        string_keys[i] = string_new(buffer);
+    }
+}
+
+static Map* int_map(void) {
+    Map* map = map_new();
+    for (usize i = 0; i < KEYS; i++)
+        map_set(map, cast<IKeyable>(int_keys[i]), object_ref(int_keys[i]));
+    return map;
+}
+
+// List
+void bench_list_add(Bench* b) {
+    setup_keys();
+    List* list = list_new();
+    for (usize i = 0; i < b->iterations; i++) {
+        if (list_get_size(list) == KEYS) {
+            list_free(list);
+            list = list_new();
+        }
+        list_add(list, object_ref(int_keys[i & (KEYS - 1)]));
+    }
+    bench_stop_timer(b);
+    list_free(list);
+}
+
+void bench_list_get(Bench* b) {
+    bench_stop_timer(b);
+    setup_keys();
+    List* list = list_new();
+    for (usize i = 0; i < KEYS; i++)
+        list_add(list, object_ref(int_keys[i]));
+    bench_start_timer(b);
+    i64 sum = 0;
+    for (usize i = 0; i < b->iterations; i++)
+        sum += int_get_value((Int*)list_get(list, i & (KEYS - 1)));
+    bench_use(sum);
+    bench_stop_timer(b);
+    list_free(list);
+}
+
+void bench_list_iterate(Bench* b) {
+    bench_stop_timer(b);
+    setup_keys();
+    List* list = list_new();
+    for (usize i = 0; i < KEYS; i++)
+        list_add(list, object_ref(int_keys[i]));
+    bench_start_timer(b);
+    i64 sum = 0;
+    for (usize i = 0; i < b->iterations; i += KEYS) {
+        for (Int* item in list) {
+            sum += int_get_value(item);
+        }
+    }
+    bench_use(sum);
+    bench_stop_timer(b);
+    list_free(list);
+}
+
+// One op sorts KEYS shuffled items
+void bench_list_sort(Bench* b) {
+    bench_stop_timer(b);
+    setup_keys();
+    List* list = list_new();
+    for (usize i = 0; i < KEYS; i++)
+        list_add(list, object_ref(int_keys[i]));
+    for (usize i = 0; i < b->iterations; i++) {
+        bench_stop_timer(b);
+        u64 seed = i + 1;
+        for (usize j = KEYS - 1; j > 0; j--) {
+            seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+            usize k = (usize)(seed >> 33) % (j + 1);
+            Object* item = list->items[j];
+            list->items[j] = list->items[k];
+            list->items[k] = item;
+        }
+        bench_start_timer(b);
+        list_sort(list);
+    }
+    bench_stop_timer(b);
+    list_free(list);
+}
+
+// Map
+void bench_map_set_int(Bench* b) {
+    setup_keys();
+    Map* map = map_new();
+    for (usize i = 0; i < b->iterations; i++) {
+        if ((i & (KEYS - 1)) == 0 && i != 0) {
+            map_free(map);
+            map = map_new();
+        }
+        map_set(map, cast<IKeyable>(int_keys[i & (KEYS - 1)]), object_ref(int_keys[0]));
+    }
+    bench_stop_timer(b);
+    map_free(map);
+}
+
+void bench_map_set_string(Bench* b) {
+    setup_keys();
+    Map* map = map_new();
+    for (usize i = 0; i < b->iterations; i++) {
+        if ((i & (KEYS - 1)) == 0 && i != 0) {
+            map_free(map);
+            map = map_new();
+        }
+        map_set(map, cast<IKeyable>(string_keys[i & (KEYS - 1)]), object_ref(int_keys[0]));
+    }
+    bench_stop_timer(b);
+    map_free(map);
+}
+
+void bench_map_get_int_hit(Bench* b) {
+    bench_stop_timer(b);
+    setup_keys();
+    Map* map = int_map();
+    bench_start_timer(b);
+    usize found = 0;
+    for (usize i = 0; i < b->iterations; i++)
+        found += map_get(map, cast<IKeyable>(int_keys[i & (KEYS - 1)])) != NULL;
+    bench_use(found);
+    bench_stop_timer(b);
+    map_free(map);
+}
+
+void bench_map_get_int_miss(Bench* b) {
+    bench_stop_timer(b);
+    setup_keys();
+    Map* map = int_map();
+    Int* missing[KEYS / 16];
+    for (usize i = 0; i < KEYS / 16; i++)
+        missing[i] = int_new(-(i64)i - 1);
+    bench_start_timer(b);
+    usize found = 0;
+    for (usize i = 0; i < b->iterations; i++)
+        found += map_get(map, cast<IKeyable>(missing[i & (KEYS / 16 - 1)])) != NULL;
+    bench_use(found);
+    bench_stop_timer(b);
+    for (usize i = 0; i < KEYS / 16; i++)
+        int_free(missing[i]);
+    map_free(map);
+}
+
+void bench_map_get_string(Bench* b) {
+    bench_stop_timer(b);
+    setup_keys();
+    Map* map = map_new();
+    for (usize i = 0; i < KEYS; i++)
+        map_set(map, cast<IKeyable>(string_keys[i]), object_ref(int_keys[i]));
+    bench_start_timer(b);
+    usize found = 0;
+    for (usize i = 0; i < b->iterations; i++)
+        found += map_get(map, cast<IKeyable>(string_keys[i & (KEYS - 1)])) != NULL;
+    bench_use(found);
+    bench_stop_timer(b);
+    map_free(map);
+}
+
+// One op removes a key and inserts it again, the load factor stays put
+void bench_map_churn(Bench* b) {
+    bench_stop_timer(b);
+    setup_keys();
+    Map* map = int_map();
+    bench_start_timer(b);
+    for (usize i = 0; i < b->iterations; i++) {
+        IKeyable key = cast<IKeyable>(int_keys[(i * 7) & (KEYS - 1)]);
+        map_remove(map, key);
+        map_set(map, key, object_ref(int_keys[0]));
+    }
+    bench_stop_timer(b);
+    map_free(map);
+}
+
+void bench_map_iterate(Bench* b) {
+    bench_stop_timer(b);
+    setup_keys();
+    Map* map = int_map();
+    bench_start_timer(b);
+    i64 sum = 0;
+    for (usize i = 0; i < b->iterations; i += KEYS) {
+        for (Int* key in map) {
+            sum += int_get_value(key);
+        }
+    }
+    bench_use(sum);
+    bench_stop_timer(b);
+    map_free(map);
+}
+
+// Set
+void bench_set_add_int(Bench* b) {
+    setup_keys();
+    Set* set = set_new();
+    for (usize i = 0; i < b->iterations; i++) {
+        if ((i & (KEYS - 1)) == 0 && i != 0) {
+            set_free(set);
+            set = set_new();
+        }
+        set_add(set, cast<IKeyable>(int_keys[i & (KEYS - 1)]));
+    }
+    bench_stop_timer(b);
+    set_free(set);
+}
+
+void bench_set_contains_int(Bench* b) {
+    bench_stop_timer(b);
+    setup_keys();
+    Set* set = set_new();
+    for (usize i = 0; i < KEYS; i++)
+        set_add(set, cast<IKeyable>(int_keys[i]));
+    bench_start_timer(b);
+    usize found = 0;
+    for (usize i = 0; i < b->iterations; i++)
+        found += set_contains(set, cast<IKeyable>(int_keys[(i * 7) & (KEYS - 1)]));
+    bench_use(found);
+    bench_stop_timer(b);
+    set_free(set);
+}
+
+// String
+void bench_string_new(Bench* b) {
+    for (usize i = 0; i < b->iterations; i++)
+        string_free(string_new("a short string literal"));
+}
+
+void bench_string_hash(Bench* b) {
+    setup_keys();
+    u32 hash = 0;
+    for (usize i = 0; i < b->iterations; i++)
+        hash ^= string_hash(string_keys[i & (KEYS - 1)]);
+    bench_use(hash);
+}
+
+void bench_string_equals(Bench* b) {
+    bench_stop_timer(b);
+    String* left = string_new("the quick brown fox jumps over the lazy dog");
+    String* right = string_new("the quick brown fox jumps over the lazy dog");
+    bench_start_timer(b);
+    usize equal = 0;
+    for (usize i = 0; i < b->iterations; i++)
+        equal += string_equals(left, (Object*)right);
+    bench_use(equal);
+    bench_stop_timer(b);
+    string_free(left);
+    string_free(right);
+}
+
+void bench_string_split(Bench* b) {
+    bench_stop_timer(b);
+    String* csv = string_new("alpha,beta,gamma,delta,epsilon,zeta,eta,theta");
+    bench_start_timer(b);
+    for (usize i = 0; i < b->iterations; i++)
+        list_free(string_split(csv, ','));
+    bench_stop_timer(b);
+    string_free(csv);
+}
+
+// StringBuilder, one op appends a word
+void bench_string_builder_append(Bench* b) {
+    StringBuilder* sb = string_builder_new();
+    for (usize i = 0; i < b->iterations; i++) {
+        if ((i & (KEYS - 1)) == 0 && i != 0) {
+            string_builder_free(sb);
+            sb = string_builder_new();
+        }
+        string_builder_append_cstr(sb, "word ");
+    }
+    bench_stop_timer(b);
+    string_builder_free(sb);
+}
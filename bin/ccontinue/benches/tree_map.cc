@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) 2026 Bastiaan van der Plaat
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+// TreeMap on 10^6 Int keys: random inserts, lookups, a full in-order walk, range scans of 100
+// keys and bulk loading from a sorted List
+// Run with: ccc -r benches/tree_map.cc
+
+#include <time.h>
+
+#include <TreeMap.hh>
+
+#define COUNT 1000000
+#define SCANS 10000
+#define SCAN_LENGTH 100
+
+f64 now(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (f64)ts.tv_sec + (f64)ts.tv_nsec / 1e9;
+}
+
+static void sum_value(Object* key, Object* value, void* context) {
+    (void)key;
+    *(i64*)context += int_get_value((Int*)value);
+}
+
+int main(void) {
+    // Keys in a pseudo random order, every key once
+    List* keys = list_new_with_capacity(COUNT);
+    for (i64 i = 0; i < COUNT; i++)
+        list_add(keys, int_new((i * 7919) % COUNT));
+
+    f64 start = now();
+    TreeMap* map = tree_map_new();
+    for (Int* key in keys) {
+        tree_map_set(map, cast<IComparable>(key), int_new(int_get_value(key)));
+    }
+    printf("insert    %6.2f ns/key\n", (now() - start) * 1e9 / COUNT);
+
+    i64 sum = 0;
+    start = now();
+    for (Int* key in keys) {
+        sum += int_get_value((Int*)tree_map_get(map, cast<IComparable>(key)));
+    }
+    printf("get       %6.2f ns/key (%lld)\n", (now() - start) * 1e9 / COUNT, (long long)sum);
+
+    sum = 0;
+    start = now();
+    for (Int* key in map) {
+        sum += int_get_value(key);
+    }
+    printf("for-in    %6.2f ns/key (%lld)\n", (now() - start) * 1e9 / COUNT, (long long)sum);
+
+    sum = 0;
+    start = now();
+    for (i64 i = 0; i < SCANS; i++) {
+        Int* low = int_new((i * 7919) % (COUNT - SCAN_LENGTH));
+        Int* high = int_new(int_get_value(low) + SCAN_LENGTH);
+        tree_map_foreach_range(map, (Object*)low, (Object*)high, sum_value, &sum);
+        int_free(low);
+        int_free(high);
+    }
+    printf("range     %6.2f ns/key (%lld)\n", (now() - start) * 1e9 / ((f64)SCANS * SCAN_LENGTH), (long long)sum);
+    tree_map_free(map);
+
+    List* sorted = list_new_with_capacity(COUNT);
+    List* values = list_new_with_capacity(COUNT);
+    for (i64 i = 0; i < COUNT; i++) {
+        list_add(sorted, int_new(i));
+        list_add(values, int_new(i));
+    }
+    start = now();
+    map = tree_map_new_from_sorted(sorted, values);
+    printf("bulk load %6.2f ns/key\n", (now() - start) * 1e9 / COUNT);
+    tree_map_free(map);
+
+    list_free(sorted);
+    list_free(values);
+    list_free(keys);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,60 @@
+/*
+ * Copyright (c) 2026 Bastiaan van der Plaat
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+// Translating an array of points held as objects or as contiguous @value structs
+// Run with: ccc -r benches/value_class.cc
+
+#include <time.h>
+
+#include <Object.hh>
+
+#define COUNT 100000
+#define ROUNDS 1000
+
+class ObjectPoint {
+    @prop @init f32 x;
+    @prop @init f32 y;
+};
+
+@value class ValuePoint {
+    @prop @init f32 x;
+    @prop @init f32 y;
+};
+
+f64 now(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (f64)ts.tv_sec + (f64)ts.tv_nsec / 1e9;
+}
+
+int main(void) {
+    ObjectPoint** objects = malloc(COUNT * sizeof(ObjectPoint*));
+    ValuePoint* values = malloc(COUNT * sizeof(ValuePoint));
+    for (usize i = 0; i < COUNT; i++) {
+        objects[i] = object_point_new((f32)i, (f32)i);
+        values[i] = value_point_new((f32)i, (f32)i);
+    }
+
+    f64 start = now();
+    for (usize r = 0; r < ROUNDS; r++)
+        for (usize i = 0; i < COUNT; i++)
+            object_point_set_x(objects[i], object_point_get_x(objects[i]) + 1.0f);
+    printf("object  %6.2f ns/point, %zu bytes each (%.0f)\n", (now() - start) * 1e9 / ((f64)ROUNDS * COUNT),
+           sizeof(ObjectPoint), object_point_get_x(objects[COUNT - 1]));
+
+    start = now();
+    for (usize r = 0; r < ROUNDS; r++)
+        for (usize i = 0; i < COUNT; i++)
+            value_point_set_x(&values[i], value_point_get_x(&values[i]) + 1.0f);
+    printf("@value  %6.2f ns/point, %zu bytes each (%.0f)\n", (now() - start) * 1e9 / ((f64)ROUNDS * COUNT),
+           sizeof(ValuePoint), value_point_get_x(&values[COUNT - 1]));
+
+    for (usize i = 0; i < COUNT; i++)
+        object_point_free(objects[i]);
+    free(objects);
+    free(values);
+    return EXIT_SUCCESS;
+}
@@ -4,21 +4,20 @@
  * SPDX-License-Identifier: MIT
  */
 
-// IComparable
-class IComparable : IEquatable {
-    i32 compare(Object* other);
+// IOrdered, default methods on top of IComparable from Object.hh
+class IOrdered : IComparable {
     bool less_than(Object* other);
     bool greater_than(Object* other);
 };
-bool IComparable::less_than(Object* other) {
+bool IOrdered::less_than(Object* other) {
     return compare(this, other) < 0;
 }
-bool IComparable::greater_than(Object* other) {
+bool IOrdered::greater_than(Object* other) {
     return compare(this, other) > 0;
 }
 
 // Number
-class Number : IComparable {
+class Number : IOrdered {
     @get @init i32 value;
 
     virtual bool equals(Object* other);
@@ -43,12 +42,12 @@ int main(void) {
     printf("a == b: %s\n", number_equals(a, (Object*)b) ? "true" : "false");
     printf("a < b: %s\n", number_compare(a, (Object*)b) < 0 ? "true" : "false");
 
-    // Via IComparable
-    IComparable c_a = cast<IComparable>(a);
-    IComparable c_b = cast<IComparable>(b);
-    printf("c_a < c_b (default less_than): %s\n", i_comparable_less_than(c_a, (Object*)b) ? "true" : "false");
-    printf("c_a > c_b (default greater_than): %s\n", i_comparable_greater_than(c_a, (Object*)b) ? "true" : "false");
-    printf("c_b > c_a (default greater_than): %s\n", i_comparable_greater_than(c_b, (Object*)a) ? "true" : "false");
+    // Via IOrdered
+    IOrdered c_a = cast<IOrdered>(a);
+    IOrdered c_b = cast<IOrdered>(b);
+    printf("c_a < c_b (default less_than): %s\n", i_ordered_less_than(c_a, (Object*)b) ? "true" : "false");
+    printf("c_a > c_b (default greater_than): %s\n", i_ordered_greater_than(c_a, (Object*)b) ? "true" : "false");
+    printf("c_b > c_a (default greater_than): %s\n", i_ordered_greater_than(c_b, (Object*)a) ? "true" : "false");
 
     // Via IEquatable
     IEquatable e_a = cast<IEquatable>(a);
@@ -6,15 +6,29 @@
 
 use std::env;
 
+use crate::pgo::DEFAULT_PROFILE_DIR;
+
 #[derive(Debug)]
 pub(crate) struct Args {
     pub(crate) files: Vec<String>,
     pub(crate) output: Option<String>,
     pub(crate) include_paths: Vec<String>,
+    pub(crate) jobs: Option<usize>,
+    pub(crate) opt_level: Option<String>,
+    pub(crate) pgo_generate: Option<String>,
+    pub(crate) pgo_use: Option<String>,
     pub(crate) flag_source: bool,
     pub(crate) flag_compile: bool,
     pub(crate) flag_run: bool,
     pub(crate) flag_run_leaks: bool,
+    pub(crate) flag_pool: bool,
+    pub(crate) flag_atomic_refs: bool,
+    pub(crate) flag_random_hash_seed: bool,
+    pub(crate) flag_track_allocs: bool,
+    pub(crate) flag_profile: bool,
+    pub(crate) flag_bench: bool,
+    pub(crate) flag_no_cache: bool,
+    pub(crate) flag_release: bool,
 }
 
 pub(crate) fn parse_args() -> Args {
@@ -22,10 +36,22 @@ pub(crate) fn parse_args() -> Args {
     let mut files = Vec::new();
     let mut output = None;
     let mut include_paths = Vec::new();
+    let mut jobs = None;
+    let mut opt_level = None;
+    let mut pgo_generate = None;
+    let mut pgo_use = None;
     let mut flag_source = false;
     let mut flag_compile = false;
     let mut flag_run = false;
     let mut flag_run_leaks = false;
+    let mut flag_pool = false;
+    let mut flag_atomic_refs = false;
+    let mut flag_random_hash_seed = false;
+    let mut flag_track_allocs = false;
+    let mut flag_profile = false;
+    let mut flag_bench = false;
+    let mut flag_no_cache = false;
+    let mut flag_release = false;
 
     let mut i = 1;
     while i < raw.len() {
@@ -41,10 +67,34 @@ pub(crate) fn parse_args() -> Args {
             arg if arg.starts_with("-I") => {
                 include_paths.push(arg[2..].to_owned());
             }
+            "-j" | "--jobs" => {
+                i += 1;
+                jobs = Some(parse_jobs(&raw[i]));
+            }
+            arg if arg.starts_with("-j") => jobs = Some(parse_jobs(&arg[2..])),
+            "-O0" | "-O1" | "-O2" | "-O3" | "-Os" | "-Og" => {
+                opt_level = Some(raw[i][2..].to_owned())
+            }
+            "--pgo-generate" => pgo_generate = Some(DEFAULT_PROFILE_DIR.to_owned()),
+            arg if arg.starts_with("--pgo-generate=") => {
+                pgo_generate = Some(arg["--pgo-generate=".len()..].to_owned())
+            }
+            "--pgo-use" => pgo_use = Some(DEFAULT_PROFILE_DIR.to_owned()),
+            arg if arg.starts_with("--pgo-use=") => {
+                pgo_use = Some(arg["--pgo-use=".len()..].to_owned())
+            }
             "-S" | "--source" => flag_source = true,
             "-c" | "--compile" => flag_compile = true,
             "-r" | "--run" => flag_run = true,
             "-R" | "--run-leaks" => flag_run_leaks = true,
+            "--pool" => flag_pool = true,
+            "--atomic-refs" => flag_atomic_refs = true,
+            "--random-hash-seed" => flag_random_hash_seed = true,
+            "--track-allocs" => flag_track_allocs = true,
+            "--profile" => flag_profile = true,
+            "--bench" => flag_bench = true,
+            "--no-cache" => flag_no_cache = true,
+            "--release" => flag_release = true,
             arg if !arg.starts_with('-') => files.push(arg.to_owned()),
             _ => {
                 eprintln!("Unknown argument: {}", raw[i]);
@@ -55,7 +105,13 @@ pub(crate) fn parse_args() -> Args {
     }
 
     if files.is_empty() {
-        eprintln!("Usage: ccc <file> [-o output] [-I include] [-S] [-c] [-r] [-R]");
+        eprintln!(
+            "Usage: ccc <file> [-o output] [-I include] [-j jobs] [-O level] [--pgo-generate[=dir]] [--pgo-use[=dir]] [-S] [-c] [-r] [-R] [--pool] [--atomic-refs] [--random-hash-seed] [--track-allocs] [--profile] [--bench] [--no-cache] [--release]"
+        );
+        std::process::exit(1);
+    }
+    if pgo_generate.is_some() && pgo_use.is_some() {
+        eprintln!("--pgo-generate and --pgo-use can't be combined");
         std::process::exit(1);
     }
 
@@ -63,9 +119,31 @@ pub(crate) fn parse_args() -> Args {
         files,
         output,
         include_paths,
+        jobs,
+        opt_level,
+        pgo_generate,
+        pgo_use,
         flag_source,
         flag_compile,
         flag_run,
         flag_run_leaks,
+        flag_pool,
+        flag_atomic_refs,
+        flag_random_hash_seed,
+        flag_track_allocs,
+        flag_profile,
+        flag_bench,
+        flag_no_cache,
+        flag_release,
+    }
+}
+
+fn parse_jobs(value: &str) -> usize {
+    match value.parse::<usize>() {
+        Ok(jobs) if jobs > 0 => jobs,
+        _ => {
+            eprintln!("Invalid job count: {value}");
+            std::process::exit(1);
+        }
     }
 }
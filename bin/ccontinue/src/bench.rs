@@ -0,0 +1,33 @@
+/*
+ * Copyright (c) 2026 Bastiaan van der Plaat
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+use regex::regex;
+
+/// Find the `void bench_<name>(Bench* b)` functions of a source file and generate a
+/// main() that runs them through the prelude benchmark harness.
+pub(crate) fn generate_bench_main(path: &str, text: &str) -> String {
+    let re_bench = regex!(
+        r"(?m)^\s*(?:static\s+)?void\s+bench_([_A-Za-z0-9]+)\s*\(\s*Bench\s*\*\s*[_A-Za-z0-9]*\s*\)\s*\{"
+    );
+    let names: Vec<&str> = re_bench
+        .captures_iter(text)
+        .map(|captures| captures.get(1).expect("bench name").as_str())
+        .collect();
+    if names.is_empty() {
+        eprintln!("[ERROR] No void bench_<name>(Bench* b) functions found in {path}");
+        std::process::exit(1);
+    }
+
+    let mut c = String::from("\n// Benchmark runner\nint main(int argc, char** argv) {\n");
+    c += "    static const _BenchCase cases[] = {\n";
+    for name in &names {
+        c += &format!("        {{\"{name}\", bench_{name}}},\n");
+    }
+    c += "    };\n";
+    c += "    return _bench_main(argc, argv, cases, sizeof(cases) / sizeof(cases[0]));\n";
+    c += "}\n";
+    c
+}
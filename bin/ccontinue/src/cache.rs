@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) 2026 Bastiaan van der Plaat
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+use std::hash::{DefaultHasher, Hash, Hasher};
+use std::path::{Path, PathBuf};
+use std::process::Command;
+
+/// Compiled std library cached as a libccstd.a across ccc invocations.
+/// Each ccc version, std source, compiler, flag and include path combination gets its own directory.
+pub(crate) struct StdCache {
+    dir: PathBuf,
+}
+
+impl StdCache {
+    /// Cache for the given build, or None when there is no user cache directory.
+    pub(crate) fn new(
+        cc: &str,
+        flags: &[String],
+        include_paths: &[String],
+        std_files: &[(&str, &[u8])],
+    ) -> Option<Self> {
+        let mut hasher = DefaultHasher::new();
+        env!("CARGO_PKG_VERSION").hash(&mut hasher);
+        cc.hash(&mut hasher);
+        // The compiler identity, so a compiler upgrade rebuilds the std library
+        if let Ok(output) = Command::new(cc).arg("--version").output() {
+            output.stdout.hash(&mut hasher);
+        }
+        flags.hash(&mut hasher);
+        for (name, data) in std_files {
+            name.hash(&mut hasher);
+            data.hash(&mut hasher);
+        }
+        // The std sources are built with the include paths, where a file with the name of a
+        // std file comes before the embedded one
+        for include_path in include_paths {
+            std::fs::canonicalize(include_path)
+                .unwrap_or_else(|_| PathBuf::from(include_path))
+                .hash(&mut hasher);
+            for (name, _) in std_files {
+                if let Ok(data) = std::fs::read(Path::new(include_path).join(name)) {
+                    name.hash(&mut hasher);
+                    data.hash(&mut hasher);
+                }
+            }
+        }
+
+        let dir = cache_dir()?.join(format!("std-{:016x}", hasher.finish()));
+        Some(StdCache { dir })
+    }
+
+    fn archive_path(&self) -> PathBuf {
+        self.dir.join("libccstd.a")
+    }
+
+    /// The cached archive, if an earlier build stored it.
+    pub(crate) fn lookup(&self) -> Option<String> {
+        let path = self.archive_path();
+        if path.is_file() {
+            path.to_str().map(str::to_owned)
+        } else {
+            None
+        }
+    }
+
+    /// Archive the std objects into the cache, returns the archive path or None when
+    /// archiving failed and the objects should be linked directly.
+    pub(crate) fn store(&self, object_paths: &[String]) -> Option<String> {
+        std::fs::create_dir_all(&self.dir).ok()?;
+
+        // Build under a unique name and rename, so concurrent builds never see a partial archive
+        let temp_path = self.dir.join(format!("libccstd.a.{}", std::process::id()));
+        let _ = std::fs::remove_file(&temp_path);
+        let ar = std::env::var("AR").unwrap_or_else(|_| "ar".to_owned());
+        let status = Command::new(ar)
+            .arg("rcs")
+            .arg(&temp_path)
+            .args(object_paths)
+            .status()
+            .ok()?;
+        if !status.success() || std::fs::rename(&temp_path, self.archive_path()).is_err() {
+            let _ = std::fs::remove_file(&temp_path);
+            return None;
+        }
+        self.lookup()
+    }
+}
+
+/// The ccontinue directory in the user cache directory of the platform, CCC_CACHE_DIR overrides it.
+fn cache_dir() -> Option<PathBuf> {
+    if let Some(dir) = std::env::var_os("CCC_CACHE_DIR") {
+        return Some(PathBuf::from(dir));
+    }
+    let base = if cfg!(windows) {
+        PathBuf::from(std::env::var_os("LOCALAPPDATA")?)
+    } else if let Some(dir) = std::env::var_os("XDG_CACHE_HOME") {
+        PathBuf::from(dir)
+    } else if cfg!(target_os = "macos") {
+        PathBuf::from(std::env::var_os("HOME")?)
+            .join("Library")
+            .join("Caches")
+    } else {
+        PathBuf::from(std::env::var_os("HOME")?).join(".cache")
+    };
+    Some(base.join("ccontinue"))
+}
@@ -7,15 +7,23 @@
 #![doc = include_str!("../README.md")]
 
 mod args;
+mod bench;
+mod cache;
+mod pgo;
 mod temp;
 mod transpiler;
 mod types;
 mod utils;
 
 use std::collections::HashMap;
+use std::path::Path;
 use std::process::Command;
+use std::sync::atomic::{AtomicBool, AtomicUsize, Ordering};
 
 use args::parse_args;
+use bench::generate_bench_main;
+use cache::StdCache;
+use pgo::{Pgo, stable_unit_name};
 use rust_embed::Embed;
 use temp::TempFileManager;
 use transpiler::Transpiler;
@@ -24,13 +32,24 @@ use transpiler::Transpiler;
 #[folder = "std"]
 struct StdFiles;
 
-/// Set up standard library files: extract embedded files, transpile .cc files,
-/// and write outputs to temp_dir/ccontinue for compiler access.
-/// Returns (std_source_paths, std_temp_dir, transpiler_with_embedded_includes).
+/// A translation unit of the build, kept in link order.
+enum Unit {
+    /// A file on disk: .cc/.hh to transpile, .c to compile or .o/.a to link as is
+    File(String),
+    /// An embedded std .cc source
+    Std { name: String, text: String },
+}
+
+/// Set up standard library files: extract the embedded plain C files to temp_dir/ccontinue
+/// for compiler access and collect the std .cc sources as units to build.
+/// Returns (std_units, std_temp_dir, transpiler_with_embedded_includes).
 fn setup_std_files(
     temp_mgr: &TempFileManager,
     include_paths: &[String],
-) -> (Vec<String>, String, Transpiler) {
+    flag_pool: bool,
+    flag_atomic_refs: bool,
+    flag_profile: bool,
+) -> (Vec<Unit>, String, Transpiler) {
     // Build an in-memory map of embedded .hh files for the transpiler
     let mut embedded_includes: HashMap<String, String> = HashMap::new();
     // Collect embedded .c / .h / .cc files that need compiler access
@@ -53,123 +72,218 @@ fn setup_std_files(
         .expect("std temp dir is valid UTF-8")
         .to_owned();
 
-    let mut std_source_paths: Vec<String> = Vec::new();
+    let mut std_units: Vec<Unit> = Vec::new();
 
-    // Prepare a transpiler seeded with the embedded .hh map to transpile std .cc files
+    // Prepare a transpiler seeded with the embedded .hh map, the workers fork it
     let mut std_transpiler = Transpiler::new(include_paths.to_vec());
-    std_transpiler.set_embedded_includes(embedded_includes.clone());
+    std_transpiler.set_embedded_includes(embedded_includes);
+    std_transpiler.set_pool_all(flag_pool);
+    std_transpiler.set_shared_all(flag_atomic_refs);
+    std_transpiler.set_profile(flag_profile);
 
-    for (filename, content) in &std_c_files {
+    for (filename, content) in std_c_files {
         if filename.ends_with(".h") || filename.ends_with(".c") {
             // Plain C files: write directly for the compiler
-            let dest = temp_mgr.base_dir().join(filename);
+            let dest = temp_mgr.base_dir().join(&filename);
             std::fs::write(&dest, content).unwrap_or_else(|e| {
                 eprintln!("[ERROR] Can't write std file {filename}: {e}");
                 std::process::exit(1);
             });
             if filename.ends_with(".c") {
-                std_source_paths.push(dest.to_str().expect("dest path is valid UTF-8").to_owned());
+                std_units.push(Unit::File(
+                    dest.to_str().expect("dest path is valid UTF-8").to_owned(),
+                ));
             }
         } else if filename.ends_with(".cc") {
-            // CCC sources: transpile in-memory, write .c output to temp dir
-            let text = String::from_utf8_lossy(content).into_owned();
-            std_transpiler.reset();
-            let c_output = std_transpiler.transpile(filename, false, &text);
-            let out_name = filename.replace(".cc", ".c");
-            let dest = temp_mgr.base_dir().join(&out_name);
-            std::fs::write(&dest, &c_output).unwrap_or_else(|e| {
-                eprintln!("[ERROR] Can't write transpiled std file {out_name}: {e}");
-                std::process::exit(1);
+            // CCC sources: transpiled in memory by a build worker
+            let text = String::from_utf8_lossy(&content).into_owned();
+            std_units.push(Unit::Std {
+                name: filename,
+                text,
             });
-            std_source_paths.push(dest.to_str().expect("dest path is valid UTF-8").to_owned());
         }
     }
 
-    (std_source_paths, std_temp_dir, std_transpiler)
+    (std_units, std_temp_dir, std_transpiler)
 }
 
-/// Transpile and compile user source files (.cc, .hh, .c).
-/// Returns (object_paths, embedded_includes for next stage).
-#[allow(clippy::too_many_arguments)]
-fn transpile_and_compile_sources(
-    temp_mgr: &TempFileManager,
-    transpiler: &mut Transpiler,
-    include_paths: &[String],
-    source_paths: &[String],
-    output: &Option<String>,
+/// Everything a build worker needs, shared read-only between the workers.
+struct BuildContext<'a> {
+    temp_mgr: &'a TempFileManager,
+    transpiler: &'a Transpiler,
+    include_paths: &'a [String],
+    cflags: &'a [String],
+    output: &'a Option<String>,
     flag_source: bool,
     flag_compile: bool,
-    cc: &str,
-) -> Vec<String> {
-    let mut object_paths: Vec<String> = Vec::new();
-
-    for path in source_paths {
-        if path.ends_with(".o") {
-            object_paths.push(path.clone());
-            continue;
-        }
+    flag_bench: bool,
+    /// Compile in the temp dir under stable names, for GCC profiles, see `Pgo`
+    stable_names: bool,
+    cc: &'a str,
+}
 
-        let source_path = if path.ends_with(".hh") || path.ends_with(".cc") {
-            let sp = if flag_source {
-                if let Some(o) = output {
-                    o.clone()
-                } else {
-                    path.replace(".cc", ".c").replace(".hh", ".h")
-                }
-            } else {
-                temp_mgr.temp_file(".c")
-            };
-            transpiler.reset();
+/// Transpile a unit if needed and compile it.
+/// Returns the object path, or the exit code of the failed compiler.
+fn build_unit(ctx: &BuildContext, unit: &Unit) -> Result<String, i32> {
+    let (path, text) = match unit {
+        Unit::File(path) if path.ends_with(".o") || path.ends_with(".a") => return Ok(path.clone()),
+        Unit::File(path) if path.ends_with(".hh") || path.ends_with(".cc") => {
             let text = std::fs::read_to_string(path).unwrap_or_else(|e| {
                 eprintln!("[ERROR] Can't read {path}: {e}");
                 std::process::exit(1);
             });
-            let result = transpiler.transpile(path, path.ends_with(".hh"), &text);
-            std::fs::write(&sp, &result).unwrap_or_else(|e| {
-                eprintln!("[ERROR] Can't write {sp}: {e}");
-                std::process::exit(1);
-            });
-            if flag_source {
-                std::process::exit(0);
+            (path.as_str(), Some(text))
+        }
+        Unit::File(path) => (path.as_str(), None),
+        Unit::Std { name, text } => (name.as_str(), Some(text.clone())),
+    };
+
+    let base_dir = ctx.temp_mgr.base_dir();
+    let stable_name = ctx.stable_names.then(|| match unit {
+        Unit::File(path) => stable_unit_name(path, base_dir),
+        Unit::Std { name, .. } => stable_unit_name(&format!("std/{name}"), base_dir),
+    });
+    let temp_file = |ext: &str| match &stable_name {
+        Some(name) => ctx.temp_mgr.named_file(&format!("{name}{ext}")),
+        None => ctx.temp_mgr.temp_file(ext),
+    };
+
+    let source_path = if let Some(text) = text {
+        let sp = if ctx.flag_source {
+            if let Some(o) = ctx.output {
+                o.clone()
+            } else {
+                path.replace(".cc", ".c").replace(".hh", ".h")
             }
-            sp
         } else {
-            path.clone()
+            temp_file(".c")
         };
+        let mut transpiler = ctx.transpiler.fork();
+        let mut result = transpiler.transpile(path, path.ends_with(".hh"), &text);
+        if ctx.flag_bench && matches!(unit, Unit::File(_)) && path.ends_with(".cc") {
+            result += &generate_bench_main(path, &text);
+        }
+        std::fs::write(&sp, &result).unwrap_or_else(|e| {
+            eprintln!("[ERROR] Can't write {sp}: {e}");
+            std::process::exit(1);
+        });
+        if ctx.flag_source {
+            std::process::exit(0);
+        }
+        sp
+    } else {
+        path.to_owned()
+    };
 
-        let object_path = if flag_compile {
-            output
-                .clone()
-                .unwrap_or_else(|| path.replace(".cc", ".o").replace(".c", ".o"))
-        } else {
-            temp_mgr.temp_file(".o")
-        };
-        object_paths.push(object_path.clone());
+    let object_path = if ctx.flag_compile {
+        ctx.output
+            .clone()
+            .unwrap_or_else(|| path.replace(".cc", ".o").replace(".c", ".o"))
+    } else {
+        temp_file(".o")
+    };
 
-        let mut cmd = Command::new(cc);
-        cmd.args(["--std=c11", "-Wall", "-Wextra", "-Wpedantic", "-Werror"]);
-        for inc in include_paths {
+    let mut cmd = Command::new(ctx.cc);
+    cmd.args(["--std=c11", "-Wall", "-Wextra", "-Wpedantic", "-Werror"]);
+    cmd.args(ctx.cflags);
+    if ctx.stable_names {
+        // Files in the temp dir are passed by name, so neither the source names GCC checks
+        // nor the profile names it derives from the objects contain the per-process temp dir
+        let compile_path = |path: &str| match Path::new(path).strip_prefix(base_dir) {
+            Ok(relative) if relative.as_os_str().is_empty() => ".".to_owned(),
+            Ok(relative) => relative.to_string_lossy().into_owned(),
+            Err(_) => std::path::absolute(path).map_or(path.to_owned(), |absolute| {
+                absolute.to_string_lossy().into_owned()
+            }),
+        };
+        cmd.current_dir(base_dir);
+        cmd.arg(format!("-fprofile-prefix-path={}", base_dir.display()));
+        for inc in ctx.include_paths {
+            cmd.arg(format!("-I{}", compile_path(inc)));
+        }
+        cmd.args([
+            "-c",
+            &compile_path(&source_path),
+            "-o",
+            &compile_path(&object_path),
+        ]);
+    } else {
+        for inc in ctx.include_paths {
             cmd.arg(format!("-I{inc}"));
         }
         cmd.args(["-c", &source_path, "-o", &object_path]);
-        let status = cmd.status().unwrap_or_else(|e| {
-            eprintln!("[ERROR] Failed to run compiler: {e}");
-            std::process::exit(1);
-        });
-        if !status.success() {
-            std::process::exit(status.code().unwrap_or(1));
-        }
-        if flag_compile {
-            std::process::exit(0);
+    }
+    let status = cmd.status().unwrap_or_else(|e| {
+        eprintln!("[ERROR] Failed to run compiler: {e}");
+        std::process::exit(1);
+    });
+    if !status.success() {
+        return Err(status.code().unwrap_or(1));
+    }
+    if ctx.flag_compile {
+        std::process::exit(0);
+    }
+    Ok(object_path)
+}
+
+/// Transpile and compile all units on up to `jobs` worker threads.
+/// Returns the object paths in unit order.
+fn transpile_and_compile_sources(ctx: &BuildContext, units: &[Unit], jobs: usize) -> Vec<String> {
+    // -S and -c only build the first file, into the output path
+    if ctx.flag_source || ctx.flag_compile {
+        if let Some(unit) = units.first()
+            && let Err(code) = build_unit(ctx, unit)
+        {
+            std::process::exit(code);
         }
+        return Vec::new();
     }
 
+    // Workers take the next unit from a shared counter, after a failure they stop taking new ones
+    let next = AtomicUsize::new(0);
+    let failed = AtomicBool::new(false);
+    let mut results: Vec<Option<Result<String, i32>>> = (0..units.len()).map(|_| None).collect();
+    std::thread::scope(|scope| {
+        let workers: Vec<_> = (0..jobs.clamp(1, units.len().max(1)))
+            .map(|_| {
+                scope.spawn(|| {
+                    let mut done = Vec::new();
+                    while !failed.load(Ordering::Relaxed) {
+                        let index = next.fetch_add(1, Ordering::Relaxed);
+                        if index >= units.len() {
+                            break;
+                        }
+                        let result = build_unit(ctx, &units[index]);
+                        if result.is_err() {
+                            failed.store(true, Ordering::Relaxed);
+                        }
+                        done.push((index, result));
+                    }
+                    done
+                })
+            })
+            .collect();
+        for worker in workers {
+            for (index, result) in worker.join().expect("build worker panicked") {
+                results[index] = Some(result);
+            }
+        }
+    });
+
+    let mut object_paths: Vec<String> = Vec::new();
+    for result in results.into_iter().flatten() {
+        match result {
+            Ok(object_path) => object_paths.push(object_path),
+            Err(code) => std::process::exit(code),
+        }
+    }
     object_paths
 }
 
 /// Link object files and optionally run the resulting executable.
 fn link_and_run(
     object_paths: &[String],
+    ldflags: &[String],
     output: &Option<String>,
     files: &[String],
     cc: &str,
@@ -188,6 +302,7 @@ fn link_and_run(
     let mut link_cmd = Command::new(cc);
     link_cmd.args(object_paths);
     link_cmd.args(["-o", &exe_path]);
+    link_cmd.args(ldflags);
     let status = link_cmd.status().unwrap_or_else(|e| {
         eprintln!("[ERROR] Failed to run linker: {e}");
         std::process::exit(1);
@@ -243,39 +358,149 @@ fn main() {
         .to_str()
         .expect("std temp dir is valid UTF-8")
         .to_owned();
-    let mut include_paths: Vec<String> = vec![".".to_owned(), std_temp_str];
+    let mut include_paths: Vec<String> = vec![".".to_owned(), std_temp_str.clone()];
     include_paths.extend(args.include_paths.clone());
 
     // Set up standard library files
-    let (std_source_paths, _std_temp_dir, std_transpiler) =
-        setup_std_files(&temp_mgr, &include_paths);
+    let (std_units, _std_temp_dir, transpiler) = setup_std_files(
+        &temp_mgr,
+        &include_paths,
+        args.flag_pool,
+        args.flag_atomic_refs,
+        args.flag_profile,
+    );
+
+    // Extra compiler flags for every translation unit
+    let mut cflags: Vec<String> = Vec::new();
+    if args.flag_random_hash_seed {
+        cflags.push("-DCCC_RANDOM_HASH_SEED".to_owned());
+    }
+    let mut ldflags: Vec<String> = Vec::new();
+    if args.flag_track_allocs {
+        cflags.push("-DCCC_TRACK_ALLOCS".to_owned());
+        // Export symbols so allocation sites resolve to function names
+        if !cfg!(windows) {
+            ldflags.extend(["-rdynamic".to_owned(), "-ldl".to_owned()]);
+        }
+    }
+
+    if args.flag_profile {
+        cflags.push("-DCCC_PROFILE".to_owned());
+    }
+
+    // Profile guided optimization, the instrumented and the optimized build compile the same
+    let pgo = match (&args.pgo_generate, &args.pgo_use) {
+        (Some(dir), _) => Some(Pgo::new(&cc, dir, true)),
+        (None, Some(dir)) => Some(Pgo::new(&cc, dir, false)),
+        (None, None) => None,
+    };
+    if let Some(pgo) = &pgo {
+        pgo.prepare();
+        cflags.extend(pgo.cflags());
+        ldflags.extend(pgo.ldflags());
+    }
 
-    // Prepare source list
-    let mut source_paths = args.files.clone();
+    // Release, PGO and benchmark builds default to -O2, release builds add link time
+    // optimization so calls between user and std translation units can be inlined
+    let opt_level = args.opt_level.clone().or_else(|| {
+        (args.flag_release || args.flag_bench || pgo.is_some()).then(|| "2".to_owned())
+    });
+    if let Some(opt_level) = &opt_level {
+        cflags.push(format!("-O{opt_level}"));
+    }
+    if args.flag_release {
+        cflags.push("-flto".to_owned());
+        ldflags.push("-flto".to_owned());
+        if let Some(opt_level) = &opt_level {
+            ldflags.push(format!("-O{opt_level}"));
+        }
+    }
+
+    if args.flag_bench {
+        // The harness uses sqrt()
+        cflags.push("-DCCC_BENCH".to_owned());
+        ldflags.push("-lm".to_owned());
+    }
+
+    // The std library comes from the cache when an earlier build with the same compiler and
+    // flags stored it, otherwise it's built with the user sources and stored afterwards
+    let std_cache = if args.flag_source || args.flag_compile || args.flag_no_cache {
+        None
+    } else {
+        let mut cache_flags = cflags.clone();
+        if args.flag_pool {
+            cache_flags.push("--pool".to_owned());
+        }
+        if args.flag_atomic_refs {
+            cache_flags.push("--atomic-refs".to_owned());
+        }
+        if let Some(pgo) = &pgo {
+            cache_flags.push(pgo.cache_key());
+        }
+        let std_files: Vec<_> = StdFiles::iter()
+            .map(|name| {
+                let file = StdFiles::get(name.as_ref()).expect("embedded file exists");
+                (name, file.data)
+            })
+            .collect();
+        let std_files: Vec<(&str, &[u8])> = std_files
+            .iter()
+            .map(|(name, data)| (name.as_ref(), data.as_ref()))
+            .collect();
+        // The temp dir only holds copies of the std files and differs per run
+        let cache_include_paths: Vec<String> = include_paths
+            .iter()
+            .filter(|path| **path != std_temp_str)
+            .cloned()
+            .collect();
+        StdCache::new(&cc, &cache_flags, &cache_include_paths, &std_files)
+    };
+    let std_archive = std_cache.as_ref().and_then(StdCache::lookup);
+
+    // Prepare unit list
+    let mut units: Vec<Unit> = args.files.iter().cloned().map(Unit::File).collect();
     if !args.flag_source && !args.flag_compile {
-        source_paths.extend(std_source_paths);
+        match &std_archive {
+            Some(archive) => units.push(Unit::File(archive.clone())),
+            None => units.extend(std_units),
+        }
     }
 
-    // Transpile and compile user sources
-    let mut transpiler = std_transpiler;
-    let object_paths = transpile_and_compile_sources(
-        &temp_mgr,
-        &mut transpiler,
-        &include_paths,
-        &source_paths,
-        &args.output,
-        args.flag_source,
-        args.flag_compile,
-        &cc,
-    );
+    // Transpile and compile user and std sources in parallel
+    let jobs = args.jobs.unwrap_or_else(|| {
+        std::thread::available_parallelism()
+            .map(|n| n.get())
+            .unwrap_or(1)
+    });
+    let ctx = BuildContext {
+        temp_mgr: &temp_mgr,
+        transpiler: &transpiler,
+        include_paths: &include_paths,
+        cflags: &cflags,
+        output: &args.output,
+        flag_source: args.flag_source,
+        flag_compile: args.flag_compile,
+        flag_bench: args.flag_bench,
+        stable_names: pgo.as_ref().is_some_and(Pgo::stable_names),
+        cc: &cc,
+    };
+    let mut object_paths = transpile_and_compile_sources(&ctx, &units, jobs);
+    if std_archive.is_none()
+        && let Some(std_cache) = &std_cache
+        && let Some(archive) = std_cache.store(&object_paths[args.files.len()..])
+    {
+        object_paths.truncate(args.files.len());
+        object_paths.push(archive);
+    }
 
     // Link and optionally run
     link_and_run(
         &object_paths,
+        &ldflags,
         &args.output,
         &args.files,
         &cc,
-        args.flag_run,
+        args.flag_run || args.flag_bench,
         args.flag_run_leaks,
     );
 }
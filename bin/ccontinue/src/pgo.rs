@@ -0,0 +1,169 @@
+/*
+ * Copyright (c) 2026 Bastiaan van der Plaat
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+use std::hash::{DefaultHasher, Hash, Hasher};
+use std::path::{Path, PathBuf};
+use std::process::Command;
+
+/// Profile directory when --pgo-generate or --pgo-use is given without one.
+pub(crate) const DEFAULT_PROFILE_DIR: &str = "ccc-pgo";
+
+/// Profile guided optimization: an instrumented build writes profiles into a directory
+/// when it runs, a later build optimizes with them. GCC names its .gcda profiles after
+/// the object files and checks the source names, so with GCC every unit is compiled in
+/// the temp dir under a name that is the same in every run, see `stable_names()`.
+pub(crate) struct Pgo {
+    dir: PathBuf,
+    generate: bool,
+    clang: bool,
+}
+
+impl Pgo {
+    pub(crate) fn new(cc: &str, dir: &str, generate: bool) -> Self {
+        // Absolute, so instrumented binaries write their profiles there from any directory
+        let dir = std::path::absolute(dir).unwrap_or_else(|_| PathBuf::from(dir));
+        let clang = Command::new(cc)
+            .arg("--version")
+            .output()
+            .map(|output| String::from_utf8_lossy(&output.stdout).contains("clang"))
+            .unwrap_or(false);
+        Pgo {
+            dir,
+            generate,
+            clang,
+        }
+    }
+
+    /// An instrumented build starts from an empty profile directory, an optimized build
+    /// needs the profiles of a run, Clang's raw profiles are merged into one first.
+    pub(crate) fn prepare(&self) {
+        if self.generate {
+            std::fs::create_dir_all(&self.dir).unwrap_or_else(|e| {
+                eprintln!(
+                    "[ERROR] Can't create profile directory {}: {e}",
+                    self.dir.display()
+                );
+                std::process::exit(1);
+            });
+            for path in self.profile_files(&["gcda", "profraw", "profdata"]) {
+                let _ = std::fs::remove_file(path);
+            }
+            return;
+        }
+
+        if self.clang {
+            let raw_profiles = self.profile_files(&["profraw"]);
+            if !raw_profiles.is_empty() {
+                let llvm_profdata =
+                    std::env::var("LLVM_PROFDATA").unwrap_or_else(|_| "llvm-profdata".to_owned());
+                let status = Command::new(&llvm_profdata)
+                    .arg("merge")
+                    .arg("-o")
+                    .arg(self.profdata_path())
+                    .args(&raw_profiles)
+                    .status();
+                if !status.is_ok_and(|status| status.success()) {
+                    eprintln!("[ERROR] Can't merge the profiles with {llvm_profdata}");
+                    std::process::exit(1);
+                }
+            }
+        }
+        let extension = if self.clang { "profdata" } else { "gcda" };
+        if self.profile_files(&[extension]).is_empty() {
+            eprintln!(
+                "[ERROR] No profiles in {}, build with --pgo-generate and run the program first",
+                self.dir.display()
+            );
+            std::process::exit(1);
+        }
+    }
+
+    /// Flags for every translation unit.
+    pub(crate) fn cflags(&self) -> Vec<String> {
+        let dir = self.dir.display();
+        match (self.generate, self.clang) {
+            // Counters of @shared objects and thread pool tasks are updated from many threads
+            (true, false) => vec![
+                format!("-fprofile-generate={dir}"),
+                "-fprofile-update=prefer-atomic".to_owned(),
+            ],
+            (true, true) => vec![format!("-fprofile-generate={dir}")],
+            // Functions changed or added since the profiling run are optimized without profile
+            (false, false) => vec![
+                format!("-fprofile-use={dir}"),
+                "-Wno-missing-profile".to_owned(),
+                "-Wno-coverage-mismatch".to_owned(),
+            ],
+            (false, true) => vec![
+                format!("-fprofile-use={}", self.profdata_path().display()),
+                "-Wno-profile-instr-missing".to_owned(),
+                "-Wno-profile-instr-out-of-date".to_owned(),
+                "-Wno-profile-instr-unprofiled".to_owned(),
+            ],
+        }
+    }
+
+    /// Flags for the link, the instrumented build links the profiling runtime.
+    pub(crate) fn ldflags(&self) -> Vec<String> {
+        if self.generate {
+            vec![format!("-fprofile-generate={}", self.dir.display())]
+        } else {
+            Vec::new()
+        }
+    }
+
+    /// Whether units are compiled in the temp dir under stable names, which GCC needs to
+    /// find the profiles again. Clang matches profiles by function name.
+    pub(crate) const fn stable_names(&self) -> bool {
+        !self.clang
+    }
+
+    /// Part of the std cache key: an optimized std library depends on the profiles.
+    pub(crate) fn cache_key(&self) -> String {
+        let mut hasher = DefaultHasher::new();
+        self.generate.hash(&mut hasher);
+        self.dir.hash(&mut hasher);
+        if !self.generate {
+            for path in self.profile_files(&["gcda", "profdata"]) {
+                path.hash(&mut hasher);
+                std::fs::read(&path).unwrap_or_default().hash(&mut hasher);
+            }
+        }
+        format!("--pgo={:016x}", hasher.finish())
+    }
+
+    fn profdata_path(&self) -> PathBuf {
+        self.dir.join("ccc.profdata")
+    }
+
+    fn profile_files(&self, extensions: &[&str]) -> Vec<PathBuf> {
+        let Ok(entries) = std::fs::read_dir(&self.dir) else {
+            return Vec::new();
+        };
+        let mut paths: Vec<PathBuf> = entries
+            .filter_map(|entry| entry.ok().map(|entry| entry.path()))
+            .filter(|path| {
+                path.extension()
+                    .and_then(|extension| extension.to_str())
+                    .is_some_and(|extension| extensions.contains(&extension))
+            })
+            .collect();
+        paths.sort();
+        paths
+    }
+}
+
+/// Name of a unit that is the same in every run, for GCC profiles.
+pub(crate) fn stable_unit_name(path: &str, base_dir: &Path) -> String {
+    let path = Path::new(path)
+        .strip_prefix(base_dir)
+        .map_or(path.to_owned(), |relative| {
+            relative.to_string_lossy().into_owned()
+        });
+    path.chars()
+        .map(|c| if c.is_ascii_alphanumeric() { c } else { '_' })
+        .collect()
+}
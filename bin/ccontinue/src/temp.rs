@@ -44,6 +44,16 @@ impl TempFileManager {
             .expect("temp file path is valid UTF-8")
             .to_owned()
     }
+
+    /// Create a temporary file path with a fixed name, for files that must be named the
+    /// same in every run.
+    pub(crate) fn named_file(&self, name: &str) -> String {
+        let mut path = self.base_dir.clone();
+        path.push(name);
+        path.to_str()
+            .expect("temp file path is valid UTF-8")
+            .to_owned()
+    }
 }
 
 impl Default for TempFileManager {
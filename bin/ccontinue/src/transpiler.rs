@@ -6,47 +6,108 @@
 
 use std::collections::HashMap;
 use std::path::Path;
+use std::sync::{Arc, Mutex};
 
 use indexmap::IndexMap;
 use regex::{Captures, Regex, regex};
 
-use crate::types::{Argument, Class, Field, Interface, Method};
-use crate::utils::{find_matching_close, parse_arguments, to_snake_case};
+use crate::types::{Argument, Class, Field, Interface, Method, Template};
+use crate::utils::{
+    add_line_markers, find_matching_close, interface_table_layout, line_directive,
+    make_internal_linkage, mangle_template_name, parse_arguments, parse_attributes,
+    pin_line_markers, rewrite_bracketed, to_snake_case, top_level_start, type_id,
+    type_starts_with_name,
+};
+
+// Everything transpiling one include adds: its text and the transpiler state after it. That
+// state only depends on the includes processed before it, because a file's own classes are
+// indexed after all of its includes, so the result is reused for every translation unit that
+// reaches the same include after the same includes
+struct IncludeMemo {
+    text: String,
+    processed_includes: Vec<String>,
+    classes: IndexMap<String, Class>,
+    interfaces: IndexMap<String, Interface>,
+    templates: IndexMap<String, Template>,
+    template_instances: Vec<String>,
+}
 
 // MARK: Transpiler
 pub(crate) struct Transpiler {
     include_paths: Vec<String>,
-    embedded_includes: HashMap<String, String>,
+    embedded_includes: Arc<HashMap<String, String>>,
     classes: IndexMap<String, Class>,
     interfaces: IndexMap<String, Interface>,
-    next_interface_id: usize,
     processed_includes: Vec<String>,
+    templates: IndexMap<String, Template>,
+    template_instances: Vec<String>,
+    pool_all: bool,
+    shared_all: bool,
+    profile: bool,
+    include_memos: Arc<Mutex<HashMap<String, Arc<IncludeMemo>>>>,
 }
 
 impl Transpiler {
     pub(crate) fn new(include_paths: Vec<String>) -> Self {
         Transpiler {
             include_paths,
-            embedded_includes: HashMap::new(),
+            embedded_includes: Arc::new(HashMap::new()),
             classes: IndexMap::new(),
             interfaces: IndexMap::new(),
-            next_interface_id: 1,
             processed_includes: Vec::new(),
+            templates: IndexMap::new(),
+            template_instances: Vec::new(),
+            pool_all: false,
+            shared_all: false,
+            profile: false,
+            include_memos: Arc::new(Mutex::new(HashMap::new())),
         }
     }
 
     pub(crate) fn set_embedded_includes(&mut self, map: HashMap<String, String>) {
-        self.embedded_includes = map;
+        self.embedded_includes = Arc::new(map);
+    }
+
+    /// A fresh transpiler with the same settings for one translation unit, the embedded
+    /// includes and the include memos are shared so build workers can each fork their own.
+    pub(crate) fn fork(&self) -> Self {
+        Transpiler {
+            include_paths: self.include_paths.clone(),
+            embedded_includes: Arc::clone(&self.embedded_includes),
+            classes: IndexMap::new(),
+            interfaces: IndexMap::new(),
+            processed_includes: Vec::new(),
+            templates: IndexMap::new(),
+            template_instances: Vec::new(),
+            pool_all: self.pool_all,
+            shared_all: self.shared_all,
+            profile: self.profile,
+            include_memos: Arc::clone(&self.include_memos),
+        }
+    }
+
+    /// Allocate every class from the pool allocator, as if all were marked `@pool`.
+    pub(crate) const fn set_pool_all(&mut self, pool_all: bool) {
+        self.pool_all = pool_all;
+    }
+
+    /// Use atomic reference counts for every class, as if all were marked `@shared`.
+    pub(crate) const fn set_shared_all(&mut self, shared_all: bool) {
+        self.shared_all = shared_all;
     }
 
-    pub(crate) fn reset(&mut self) {
-        self.next_interface_id = 1;
-        self.interfaces = IndexMap::new();
-        self.classes = IndexMap::new();
-        self.processed_includes = Vec::new();
+    /// Open every method body with a profiling hook and mark virtual and interface calls.
+    pub(crate) const fn set_profile(&mut self, profile: bool) {
+        self.profile = profile;
     }
 
     // MARK: Helpers
+    // Counter and timer of a method body in profiling builds, see _PROFILE_METHOD in prelude.h
+    fn profile_hook(&self, class_name: &str, method_name: &str) -> Option<String> {
+        self.profile
+            .then(|| format!("_PROFILE_METHOD(\"{class_name}::{method_name}\");"))
+    }
+
     fn find_class_for_method<'a>(&'a self, class_: &'a Class, method_name: &str) -> &'a Class {
         if class_.methods[method_name].class_ == class_.name {
             return class_;
@@ -61,22 +122,29 @@ impl Transpiler {
         )
     }
 
-    fn concrete_subclasses(&self, target_name: &str) -> Vec<String> {
-        let mut result = Vec::new();
-        for cls in self.classes.values() {
-            if cls.is_abstract {
-                continue;
-            }
-            let mut cur_name: Option<&str> = Some(&cls.name);
-            while let Some(cn) = cur_name {
-                if cn == target_name {
-                    result.push(cls.name.clone());
-                    break;
-                }
-                cur_name = self.classes.get(cn).and_then(|c| c.parent_name.as_deref());
-            }
+    // Class names from Object down to class_name, the index of a class is its depth
+    fn class_ancestors(&self, class_name: &str) -> Vec<String> {
+        let mut ancestors = Vec::new();
+        let mut cur_name: Option<&str> = Some(class_name);
+        while let Some(cn) = cur_name {
+            ancestors.push(cn.to_owned());
+            cur_name = self.classes.get(cn).and_then(|c| c.parent_name.as_deref());
         }
-        result
+        ancestors.reverse();
+        ancestors
+    }
+
+    fn is_pool_class(&self, class_: &Class) -> bool {
+        self.pool_all || class_.attributes.contains_key("pool")
+    }
+
+    // Subclasses of a @shared class can be shared across threads as their parent
+    fn is_shared_class(&self, class_: &Class) -> bool {
+        self.shared_all
+            || self
+                .class_ancestors(&class_.name)
+                .iter()
+                .any(|name| self.classes[name].attributes.contains_key("shared"))
     }
 
     fn static_method_signature(&self, class_: &Class, method: &Method) -> String {
@@ -106,13 +174,23 @@ impl Transpiler {
 
     fn codegen_static_method_definition(&self, class_: &Class, method: &Method) -> String {
         let mut code = self.static_method_signature(class_, method) + " {\n";
-        if method.name == "new" {
+        if let Some(hook) = self.profile_hook(&class_.name, &method.name) {
+            code += &format!("    {hook}\n");
+        }
+        // new() calls init(), a named constructor new_<name>() calls init_<name>()
+        if let Some(suffix) = method.name.strip_prefix("new") {
             code += &format!(
-                "    {}* this = malloc(sizeof({}));\n",
-                class_.name, class_.name
+                "    {0}* this = _object_new(&_{0}Vtbl, sizeof({0}), {1});\n",
+                class_.name,
+                self.is_pool_class(class_)
             );
             code += &format!("    this->vtbl = &_{}Vtbl;\n", class_.name);
-            code += &format!("    {}_init(", class_.snake_name);
+            // Arena objects are never freed, so arena_free() runs their own deinit
+            if self.find_class_for_method(class_, "deinit").name != "Object" {
+                code += "    if (_object_in_arena(this))\n";
+                code += "        _arena_defer_deinit(this, (void (*)(void*))this->vtbl->deinit);\n";
+            }
+            code += &format!("    {}_init{}(", class_.snake_name, suffix);
             let args: Vec<String> = std::iter::once("this".to_owned())
                 .chain(method.arguments.iter().map(|a| a.name.clone()))
                 .collect();
@@ -130,7 +208,6 @@ impl Transpiler {
         if self.processed_includes.contains(&base_path) {
             return String::new();
         }
-        self.processed_includes.push(base_path.clone());
 
         // Determine is_header by comparing stems: a .hh file is a "companion header"
         // (not an independent header) only when its stem matches the current file's stem.
@@ -144,6 +221,43 @@ impl Transpiler {
             .unwrap_or("");
         let is_header = include_stem != current_stem;
 
+        let memo_key = format!(
+            "{base_path}:{is_header}:{}",
+            self.processed_includes.join(",")
+        );
+        let memo = self
+            .include_memos
+            .lock()
+            .expect("include memos lock")
+            .get(&memo_key)
+            .cloned();
+        if let Some(memo) = memo {
+            self.processed_includes = memo.processed_includes.clone();
+            self.classes = memo.classes.clone();
+            self.interfaces = memo.interfaces.clone();
+            self.templates = memo.templates.clone();
+            self.template_instances = memo.template_instances.clone();
+            return memo.text.clone();
+        }
+        self.processed_includes.push(base_path.clone());
+
+        let text = self.transpile_include(&base_path, is_header);
+        let memo = IncludeMemo {
+            text: text.clone(),
+            processed_includes: self.processed_includes.clone(),
+            classes: self.classes.clone(),
+            interfaces: self.interfaces.clone(),
+            templates: self.templates.clone(),
+            template_instances: self.template_instances.clone(),
+        };
+        self.include_memos
+            .lock()
+            .expect("include memos lock")
+            .insert(memo_key, Arc::new(memo));
+        text
+    }
+
+    fn transpile_include(&mut self, base_path: &str, is_header: bool) -> String {
         for include_path in self.include_paths.clone() {
             let complete_path = format!("{include_path}/{base_path}");
             if Path::new(&complete_path).exists() {
@@ -155,7 +269,7 @@ impl Transpiler {
             }
         }
         // Fallback: look up in embedded includes map
-        if let Some(text) = self.embedded_includes.get(&base_path).cloned() {
+        if let Some(text) = self.embedded_includes.get(base_path).cloned() {
             let virtual_path = format!("<embedded>/{base_path}");
             return self.transpile(&virtual_path, is_header, &text);
         }
@@ -171,11 +285,18 @@ impl Transpiler {
         contents: &str,
     ) -> String {
         let re_iface_method = regex!(
-            r"([_A-Za-z][_A-Za-z0-9 ]*[\**|\s+])\s*([_A-Za-z][_A-Za-z0-9]*)\(([^\)]*)\)\s*(=\s*0\s*)?;"
+            r"([_A-Za-z][_A-Za-z0-9 ]*[\*\s]+)\s*([_A-Za-z][_A-Za-z0-9]*)\(([^\)]*)\)\s*(=\s*0\s*)?;"
         );
         let snake_name = to_snake_case(iface_name);
-        let id = self.next_interface_id;
-        self.next_interface_id += 1;
+        let id = type_id(iface_name);
+        if let Some((other, _)) = self
+            .interfaces
+            .iter()
+            .find(|(other, other_iface)| other_iface.id == id && *other != iface_name)
+        {
+            eprintln!("[ERROR] Interfaces {iface_name} and {other} have the same id, rename one");
+            std::process::exit(1);
+        }
         let mut iface = Interface::new(iface_name, id);
 
         if let Some(supers) = supers_raw {
@@ -208,16 +329,18 @@ impl Transpiler {
                     return_type,
                     is_return_self: false,
                     is_virtual: true,
+                    is_final: false,
                     is_static: false,
                     arguments,
                     class_: iface_name.to_owned(),
                     origin_class: iface_name.to_owned(),
+                    inline_body: None,
                 },
             );
         }
 
         let mut c = format!("// interface {iface_name}\n");
-        c += &format!("#define _{}_ID {}\n\n", iface_name, iface.id);
+        c += &format!("#define _{}_ID {:#x}u\n\n", iface_name, iface.id);
 
         c += &format!("typedef struct {iface_name}Vtbl {{\n");
         let mut current_origin = String::new();
@@ -244,6 +367,23 @@ impl Transpiler {
             for argument in &method.arguments {
                 c += &format!(", {}", argument.name);
             }
+            if self.profile {
+                // Profiling builds mark the call as an interface call for the callee, after the
+                // arguments are evaluated so calls in them can't take the mark
+                c += &format!(") __extension__({{ {iface_name} _profile_iface = (iface);");
+                for (index, argument) in method.arguments.iter().enumerate() {
+                    c += &format!(" __auto_type _profile_arg{index} = ({});", argument.name);
+                }
+                c += &format!(
+                    " _PROFILE_INTERFACE(); _profile_iface.vtbl->{}(_profile_iface.obj",
+                    method.name
+                );
+                for index in 0..method.arguments.len() {
+                    c += &format!(", _profile_arg{index}");
+                }
+                c += "); })\n";
+                continue;
+            }
             c += &format!(") ((iface).vtbl->{}((iface).obj", method.name);
             for argument in &method.arguments {
                 c += &format!(", ({})", argument.name);
@@ -252,6 +392,17 @@ impl Transpiler {
         }
         c += "\n";
 
+        c += &format!("static inline {iface_name} _cast_{iface_name}(void* obj) {{\n");
+        c += &format!(
+            "    return ({iface_name}){{ .obj = obj, .vtbl = (const {iface_name}Vtbl*)_interface_vtbl(*(const void* const*)obj, _{iface_name}_ID) }};\n"
+        );
+        c += "}\n\n";
+        c += &format!("static inline bool _instanceof_{iface_name}(void* obj) {{\n");
+        c += &format!(
+            "    return _interface_vtbl(*(const void* const*)obj, _{iface_name}_ID) != NULL;\n"
+        );
+        c += "}\n\n";
+
         self.interfaces.insert(iface_name.to_owned(), iface);
         c
     }
@@ -260,16 +411,21 @@ impl Transpiler {
     fn index_class(
         &mut self,
         class_name: &str,
+        attributes_raw: &str,
         supers_raw: Option<&str>,
         contents: &str,
     ) -> (String, Option<String>) {
         let re_field = regex!(r"(.+[^=][\s|\*])([_A-Za-z][_A-Za-z0-9]*)\s*(=\s*[^;]+)?;");
         let re_field_attr = regex!(r"@([_A-Za-z][_A-Za-z0-9]*)(\([^\)]*\))?");
         let re_method_decl = regex!(
-            r"([_A-Za-z][_A-Za-z0-9 ]*[\**|\s+])\s*([_A-Za-z][_A-Za-z0-9]*)\(([^\)]*)\)\s*(=\s*0)?;"
+            r"([_A-Za-z][_A-Za-z0-9 ]*[\*\s]+)\s*([_A-Za-z][_A-Za-z0-9]*)\(([^\)]*)\)\s*(=\s*0)?;"
         );
+        let re_inline_method =
+            regex!(r"inline\s+([^;{}()]*?[\*\s])([_A-Za-z][_A-Za-z0-9]*)\(([^\)]*)\)\s*\{");
         let re_self_return = regex!(r"Self\s*\*");
-        let mut parent_name: Option<String> = if class_name == "Object" {
+        let attributes = parse_attributes(attributes_raw);
+        let is_value = attributes.contains_key("value");
+        let mut parent_name: Option<String> = if class_name == "Object" || is_value {
             None
         } else {
             Some("Object".to_owned())
@@ -283,6 +439,10 @@ impl Transpiler {
                     continue;
                 }
                 if self.classes.contains_key(name) {
+                    if is_value {
+                        eprintln!("[ERROR] Value class {class_name} can't extend class {name}");
+                        std::process::exit(1);
+                    }
                     parent_name = Some(name.to_owned());
                 } else if self.interfaces.contains_key(name) {
                     if !explicit_interfaces.contains(&name.to_owned()) {
@@ -302,8 +462,35 @@ impl Transpiler {
             eprintln!("[ERROR] Can't find parent class {pname} for {class_name}");
             std::process::exit(1);
         }
+        if let Some(ref pname) = parent_class_name
+            && self.classes[pname.as_str()]
+                .attributes
+                .contains_key("final")
+        {
+            eprintln!("[ERROR] Can't extend final class {pname} in {class_name}");
+            std::process::exit(1);
+        }
+        if let Some(ref pname) = parent_class_name
+            && self.classes[pname.as_str()]
+                .attributes
+                .contains_key("value")
+        {
+            eprintln!("[ERROR] Can't extend value class {pname} in {class_name}");
+            std::process::exit(1);
+        }
+
+        let id = type_id(class_name);
+        if let Some(other) = self
+            .classes
+            .keys()
+            .find(|other| type_id(other) == id && *other != class_name)
+        {
+            eprintln!("[ERROR] Classes {class_name} and {other} have the same id, rename one");
+            std::process::exit(1);
+        }
 
         let mut class_ = Class::new(class_name, parent_name.clone());
+        class_.attributes = attributes;
         if let Some(ref pname) = parent_class_name {
             let parent = &self.classes[pname.as_str()];
             class_.fields = parent.fields.clone();
@@ -364,26 +551,31 @@ impl Transpiler {
             }
         }
 
+        // Inline methods carry their body in the class, cut it out so only the declaration is left
+        let mut contents = contents.to_owned();
+        let mut inline_bodies: HashMap<String, String> = HashMap::new();
+        while let Some(caps) = re_inline_method.captures(&contents) {
+            let m0 = caps.get(0).expect("group 0 always present");
+            let declaration = format!("inline {}{}({});", &caps[1], &caps[2], &caps[3]);
+            let name = caps[2].to_owned();
+            let (start, open) = (m0.start(), m0.end() - 1);
+            let close = find_matching_close(&contents, open);
+            inline_bodies.insert(name, contents[open + 1..close].trim().to_owned());
+            contents = format!(
+                "{}{}{}",
+                &contents[..start],
+                declaration,
+                &contents[(close + 1).min(contents.len())..]
+            );
+        }
+
         // Index fields
-        for caps in re_field.captures_iter(contents) {
+        for caps in re_field.captures_iter(&contents) {
             let attributes_and_type_str = &caps[1];
             let name = caps[2].to_owned();
             let default_str = caps.get(3).map(|m| m.as_str()).unwrap_or("");
 
-            let mut attributes: IndexMap<String, Vec<String>> = IndexMap::new();
-            for attr_m in re_field_attr.captures_iter(attributes_and_type_str) {
-                let attr_name = attr_m[1].to_owned();
-                let attr_args = attr_m.get(2).map(|m| m.as_str());
-                let args: Vec<String> = if let Some(args_str) = attr_args {
-                    args_str[1..args_str.len() - 1]
-                        .split(',')
-                        .map(|s| s.trim().to_owned())
-                        .collect()
-                } else {
-                    Vec::new()
-                };
-                attributes.insert(attr_name, args);
-            }
+            let attributes = parse_attributes(attributes_and_type_str);
             let field_type = re_field_attr
                 .replace_all(attributes_and_type_str, "")
                 .trim()
@@ -393,6 +585,10 @@ impl Transpiler {
                 eprintln!("[ERROR] Can't inherit field: {name}");
                 std::process::exit(1);
             }
+            if is_value && attributes.contains_key("deinit") {
+                eprintln!("[ERROR] Value class {class_name} can't own field {name} with @deinit");
+                std::process::exit(1);
+            }
 
             class_.fields.insert(
                 name.clone(),
@@ -411,7 +607,7 @@ impl Transpiler {
         }
 
         // Index methods
-        for caps in re_method_decl.captures_iter(contents) {
+        for caps in re_method_decl.captures_iter(&contents) {
             let mut return_type = caps[1].to_owned();
             let name = caps[2].to_owned();
             let arguments = parse_arguments(&caps[3]);
@@ -429,6 +625,34 @@ impl Transpiler {
                 is_virtual = true;
             }
 
+            let mut is_final = false;
+            if return_type.contains("final ") {
+                return_type = return_type.replace("final ", "");
+                is_final = true;
+                if !is_virtual {
+                    eprintln!("[ERROR] Only virtual methods can be final: {name}");
+                    std::process::exit(1);
+                }
+            }
+
+            if is_value && is_virtual {
+                eprintln!("[ERROR] Value class {class_name} can't have virtual method {name}");
+                std::process::exit(1);
+            }
+
+            let mut inline_body = None;
+            if return_type.contains("inline ") {
+                return_type = return_type.replace("inline ", "");
+                if is_virtual {
+                    eprintln!("[ERROR] Only non-virtual methods can be inline: {name}");
+                    std::process::exit(1);
+                }
+                inline_body = Some(inline_bodies.remove(&name).unwrap_or_else(|| {
+                    eprintln!("[ERROR] Inline method {name} needs a body in class {class_name}");
+                    std::process::exit(1);
+                }));
+            }
+
             let mut is_return_self = false;
             if re_self_return.is_match(&return_type) {
                 is_return_self = true;
@@ -445,6 +669,22 @@ impl Transpiler {
             }
 
             if let Some(existing) = class_.methods.get_mut(&name) {
+                if existing.is_virtual && inline_body.is_some() {
+                    eprintln!(
+                        "[ERROR] Inline method {name} can't override virtual method of {}",
+                        existing.class_
+                    );
+                    std::process::exit(1);
+                }
+                if existing.is_final {
+                    eprintln!(
+                        "[ERROR] Can't override final method {name} of {} in {class_name}",
+                        existing.class_
+                    );
+                    std::process::exit(1);
+                }
+                existing.is_final = is_final;
+                existing.inline_body = inline_body;
                 existing.return_type = return_type;
                 existing.arguments = arguments;
                 existing.class_ = class_name.to_owned();
@@ -457,20 +697,101 @@ impl Transpiler {
                         return_type,
                         is_return_self,
                         is_virtual,
+                        is_final,
                         is_static,
                         arguments,
                         class_: class_name.to_owned(),
                         origin_class: class_name.to_owned(),
+                        inline_body,
                     },
                 );
             }
         }
 
+        if class_.attributes.contains_key("final") && class_.is_abstract {
+            eprintln!("[ERROR] Final class {class_name} can't be abstract");
+            std::process::exit(1);
+        }
+        if is_value && class_.fields.is_empty() {
+            eprintln!("[ERROR] Value class {class_name} needs at least one field");
+            std::process::exit(1);
+        }
+
         self.classes.insert(class_name.to_owned(), class_);
         (class_name.to_owned(), parent_class_name)
     }
 
     // MARK: Convert classes: codegen
+    // Auto getters and setters, emitted as static inline with the class
+    fn index_accessors(&mut self, class_name: &str) {
+        let getter_fields: Vec<Field> = self.classes[class_name]
+            .fields
+            .values()
+            .filter(|f| {
+                f.class_ == class_name
+                    && (f.attributes.contains_key("get") || f.attributes.contains_key("prop"))
+            })
+            .cloned()
+            .collect();
+        for field in getter_fields {
+            let method_name = format!("get_{}", field.name);
+            self.classes
+                .get_mut(class_name)
+                .expect("class exists")
+                .methods
+                .insert(
+                    method_name.clone(),
+                    Method {
+                        name: method_name.clone(),
+                        return_type: field.type_.clone(),
+                        is_return_self: false,
+                        is_virtual: false,
+                        is_final: false,
+                        is_static: false,
+                        arguments: Vec::new(),
+                        class_: class_name.to_owned(),
+                        origin_class: class_name.to_owned(),
+                        inline_body: Some(format!("return this->{};", field.name)),
+                    },
+                );
+        }
+
+        let setter_fields: Vec<Field> = self.classes[class_name]
+            .fields
+            .values()
+            .filter(|f| {
+                f.class_ == class_name
+                    && (f.attributes.contains_key("set") || f.attributes.contains_key("prop"))
+            })
+            .cloned()
+            .collect();
+        for field in setter_fields {
+            let method_name = format!("set_{}", field.name);
+            self.classes
+                .get_mut(class_name)
+                .expect("class exists")
+                .methods
+                .insert(
+                    method_name.clone(),
+                    Method {
+                        name: method_name.clone(),
+                        return_type: "void".to_owned(),
+                        is_return_self: false,
+                        is_virtual: false,
+                        is_final: false,
+                        is_static: false,
+                        arguments: vec![Argument {
+                            name: field.name.clone(),
+                            type_: field.type_.clone(),
+                        }],
+                        class_: class_name.to_owned(),
+                        origin_class: class_name.to_owned(),
+                        inline_body: Some(format!("this->{0} = {0};", field.name)),
+                    },
+                );
+        }
+    }
+
     fn codegen_missing_methods(
         &mut self,
         class_name: &str,
@@ -532,6 +853,9 @@ impl Transpiler {
                     .collect();
                 g += &sig_args.join(", ");
                 g += ") {\n";
+                if let Some(hook) = self.profile_hook(class_name, "init") {
+                    g += &format!("    {hook}\n");
+                }
                 g += &format!(
                     "    {}_init({});\n",
                     parent_snake,
@@ -583,6 +907,9 @@ impl Transpiler {
 
                 let snake_name = self.classes[class_name].snake_name.clone();
                 g += &format!("void _{snake_name}_deinit({class_name}* this) {{\n");
+                if let Some(hook) = self.profile_hook(class_name, "deinit") {
+                    g += &format!("    {hook}\n");
+                }
 
                 let fields: Vec<Field> = self.classes[class_name]
                     .fields
@@ -600,7 +927,10 @@ impl Transpiler {
                         let found_class = self
                             .classes
                             .values()
-                            .find(|c| field_type.starts_with(&c.name))
+                            .find(|c| {
+                                type_starts_with_name(&field_type, &c.name)
+                                    && !c.attributes.contains_key("value")
+                            })
                             .map(|c| c.snake_name.clone());
                         if let Some(sc) = found_class {
                             g += &format!("    {}_free(this->{});\n", sc, field.name);
@@ -632,84 +962,7 @@ impl Transpiler {
                 g += "}\n\n";
             }
 
-            // Auto getters
-            let getter_fields: Vec<Field> = self.classes[class_name]
-                .fields
-                .values()
-                .filter(|f| {
-                    f.class_ == class_name
-                        && (f.attributes.contains_key("get") || f.attributes.contains_key("prop"))
-                })
-                .cloned()
-                .collect();
-            for field in getter_fields {
-                let method_name = format!("get_{}", field.name);
-                let snake_name = self.classes[class_name].snake_name.clone();
-                self.classes
-                    .get_mut(class_name)
-                    .expect("class exists")
-                    .methods
-                    .insert(
-                        method_name.clone(),
-                        Method {
-                            name: method_name.clone(),
-                            return_type: field.type_.clone(),
-                            is_return_self: false,
-                            is_virtual: false,
-                            is_static: false,
-                            arguments: Vec::new(),
-                            class_: class_name.to_owned(),
-                            origin_class: class_name.to_owned(),
-                        },
-                    );
-                g += &format!(
-                    "{} _{}_get_{}({}* this) {{\n",
-                    field.type_, snake_name, field.name, class_name
-                );
-                g += &format!("    return this->{};\n", field.name);
-                g += "}\n\n";
-            }
-
-            // Auto setters
-            let setter_fields: Vec<Field> = self.classes[class_name]
-                .fields
-                .values()
-                .filter(|f| {
-                    f.class_ == class_name
-                        && (f.attributes.contains_key("set") || f.attributes.contains_key("prop"))
-                })
-                .cloned()
-                .collect();
-            for field in setter_fields {
-                let method_name = format!("set_{}", field.name);
-                let snake_name = self.classes[class_name].snake_name.clone();
-                self.classes
-                    .get_mut(class_name)
-                    .expect("class exists")
-                    .methods
-                    .insert(
-                        method_name.clone(),
-                        Method {
-                            name: method_name.clone(),
-                            return_type: "void".to_owned(),
-                            is_return_self: false,
-                            is_virtual: false,
-                            is_static: false,
-                            arguments: vec![Argument {
-                                name: field.name.clone(),
-                                type_: field.type_.clone(),
-                            }],
-                            class_: class_name.to_owned(),
-                            origin_class: class_name.to_owned(),
-                        },
-                    );
-                g += &format!(
-                    "void _{}_set_{}({}* this, {} {}) {{\n",
-                    snake_name, field.name, class_name, field.type_, field.name
-                );
-                g += &format!("    this->{} = {};\n", field.name, field.name);
-                g += "}\n\n";
-            }
+            self.index_accessors(class_name);
         }
 
         // New method (all non-abstract classes)
@@ -721,10 +974,12 @@ impl Transpiler {
                 return_type: format!("{class_name}*"),
                 is_return_self: false,
                 is_virtual: false,
+                is_final: false,
                 is_static: true,
                 arguments: init_args,
                 class_: class_name.to_owned(),
                 origin_class: class_name.to_owned(),
+                inline_body: None,
             };
             self.classes
                 .get_mut(class_name)
@@ -735,6 +990,37 @@ impl Transpiler {
                 let class_ = &self.classes[class_name];
                 g += &self.codegen_static_method_definition(class_, &new_method);
             }
+
+            // Named constructors: every init_<name>() declared here gets a new_<name>()
+            let named_inits: Vec<Method> = self.classes[class_name]
+                .methods
+                .values()
+                .filter(|m| m.class_ == class_name && !m.is_static && m.name.starts_with("init_"))
+                .cloned()
+                .collect();
+            for init in named_inits {
+                let new_method = Method {
+                    name: format!("new{}", &init.name["init".len()..]),
+                    return_type: format!("{class_name}*"),
+                    is_return_self: false,
+                    is_virtual: false,
+                    is_final: false,
+                    is_static: true,
+                    arguments: init.arguments,
+                    class_: class_name.to_owned(),
+                    origin_class: class_name.to_owned(),
+                    inline_body: None,
+                };
+                self.classes
+                    .get_mut(class_name)
+                    .expect("class exists")
+                    .methods
+                    .insert(new_method.name.clone(), new_method.clone());
+                if !is_header {
+                    let class_ = &self.classes[class_name];
+                    g += &self.codegen_static_method_definition(class_, &new_method);
+                }
+            }
         }
 
         g
@@ -745,6 +1031,14 @@ impl Transpiler {
         let mut c = format!("typedef struct {0} {0};\n\n", class_.name);
         c += &format!("typedef struct {}Vtbl {{\n", class_.name);
         c += "    const _InterfaceSlot* interfaces;\n";
+        c += "    u32 interface_mask;\n";
+        c += "    u32 interface_shift;\n";
+        c += "    const usize* classes;\n";
+        c += "    usize class_depth;\n";
+        c += "    usize size;\n";
+        c += "    bool pool;\n";
+        c += "    bool shared;\n";
+        c += "    const char* class_name;\n";
         let mut current_class_name = String::new();
         for method in class_.methods.values() {
             if method.is_virtual {
@@ -780,6 +1074,28 @@ impl Transpiler {
             c += &format!("    {} {};\n", field.type_, field.name);
         }
         c += "};\n\n";
+
+        // Every vtbl lists the ids of its ancestors by depth, so a subclass check is one load
+        let depth = self.class_ancestors(class_name).len() - 1;
+        c += &format!(
+            "#define _{}_ID {:#x}u\n\n",
+            class_.name,
+            type_id(&class_.name)
+        );
+        c += &format!(
+            "static inline bool _instanceof_{}(void* obj) {{\n",
+            class_.name
+        );
+        c += "    const _VtblHeader* vtbl = *(const void* const*)obj;\n";
+        if depth == 0 {
+            c += &format!("    return vtbl->classes[0] == _{}_ID;\n", class_.name);
+        } else {
+            c += &format!(
+                "    return vtbl->class_depth >= {depth} && vtbl->classes[{depth}] == _{}_ID;\n",
+                class_.name
+            );
+        }
+        c += "}\n\n";
         c
     }
 
@@ -789,10 +1105,16 @@ impl Transpiler {
         if !class_.is_abstract
             && let Some(new_m) = class_.methods.get("new")
         {
+            if new_m.inline_body.is_some() {
+                c += "static inline ";
+            }
             c += &self.codegen_static_method_declaration(class_, new_m);
         }
         for method in class_.methods.values() {
             if method.class_ == class_.name && method.name != "new" {
+                if method.inline_body.is_some() {
+                    c += "static inline ";
+                }
                 if method.is_static {
                     c += &self.codegen_static_method_declaration(class_, method);
                 } else {
@@ -821,55 +1143,77 @@ impl Transpiler {
         let class_ = &self.classes[class_name];
         let mut c = String::new();
 
-        if !class_.interface_names.is_empty() {
-            for iface_name in &class_.interface_names {
-                let iface = &self.interfaces[iface_name];
-                c += &format!(
-                    "static const {}Vtbl _{}{}Vtbl = {{\n",
-                    iface_name, class_.name, iface_name
-                );
-                for method in iface.methods.values() {
-                    c += &format!("    ({} (*)(void*", method.return_type);
-                    for argument in &method.arguments {
-                        c += &format!(", {}", argument.type_);
-                    }
-                    c += "))";
-                    if class_.methods.contains_key(&method.name) {
-                        let impl_class = to_snake_case(&class_.methods[&method.name].class_);
-                        c += &format!("&_{}_{},\n", impl_class, method.name);
-                    } else if iface.default_bodies.contains_key(&method.name) {
-                        c += &format!("&_{}_{},\n", iface.snake_name, method.name);
-                    } else {
-                        eprintln!(
-                            "[ERROR] Class {} implements {} but does not provide '{}' and there is no default",
-                            class_.name, iface_name, method.name
-                        );
-                        std::process::exit(1);
-                    }
+        for iface_name in &class_.interface_names {
+            let iface = &self.interfaces[iface_name];
+            c += &format!(
+                "static const {}Vtbl _{}{}Vtbl = {{\n",
+                iface_name, class_.name, iface_name
+            );
+            for method in iface.methods.values() {
+                c += &format!("    ({} (*)(void*", method.return_type);
+                for argument in &method.arguments {
+                    c += &format!(", {}", argument.type_);
+                }
+                c += "))";
+                if class_.methods.contains_key(&method.name) {
+                    let impl_class = to_snake_case(&class_.methods[&method.name].class_);
+                    c += &format!("&_{}_{},\n", impl_class, method.name);
+                } else if iface.default_bodies.contains_key(&method.name) {
+                    c += &format!("&_{}_{},\n", iface.snake_name, method.name);
+                } else {
+                    eprintln!(
+                        "[ERROR] Class {} implements {} but does not provide '{}' and there is no default",
+                        class_.name, iface_name, method.name
+                    );
+                    std::process::exit(1);
                 }
-                c += "};\n\n";
             }
+            c += "};\n\n";
+        }
 
-            c += &format!(
-                "static const _InterfaceSlot _{}Interfaces[] = {{\n",
-                class_.name
-            );
-            for iface_name in &class_.interface_names {
+        // Interface ids index a per class table directly, so casts are a single slot check
+        let ids: Vec<usize> = class_
+            .interface_names
+            .iter()
+            .map(|iface_name| self.interfaces[iface_name].id)
+            .collect();
+        let (mask, shift, slots) = interface_table_layout(&ids);
+        c += &format!(
+            "static const _InterfaceSlot _{}Interfaces[] = {{\n",
+            class_.name
+        );
+        for slot in &slots {
+            if let Some(index) = slot {
+                let iface_name = &class_.interface_names[*index];
                 c += &format!(
                     "    {{ _{}_ID, &_{}{}Vtbl }},\n",
                     iface_name, class_.name, iface_name
                 );
+            } else {
+                c += "    { 0, NULL },\n";
             }
-            c += "    { 0, NULL }\n";
-            c += "};\n\n";
         }
+        c += "};\n\n";
+
+        let ancestors = self.class_ancestors(class_name);
+        c += &format!("static const usize _{}Classes[] = {{ ", class_.name);
+        c += &ancestors
+            .iter()
+            .map(|name| format!("_{name}_ID"))
+            .collect::<Vec<_>>()
+            .join(", ");
+        c += " };\n\n";
 
         c += &format!("{}Vtbl _{}Vtbl = {{\n", class_.name, class_.name);
-        if !class_.interface_names.is_empty() {
-            c += &format!("    _{}Interfaces,\n", class_.name);
-        } else {
-            c += "    NULL,\n";
-        }
+        c += &format!("    _{}Interfaces,\n", class_.name);
+        c += &format!("    {mask},\n");
+        c += &format!("    {shift},\n");
+        c += &format!("    _{}Classes,\n", class_.name);
+        c += &format!("    {},\n", ancestors.len() - 1);
+        c += &format!("    sizeof({}),\n", class_.name);
+        c += &format!("    {},\n", self.is_pool_class(class_));
+        c += &format!("    {},\n", self.is_shared_class(class_));
+        c += &format!("    \"{}\",\n", class_.name);
         let mut current_class_name = String::new();
         for method in class_.methods.values() {
             if method.is_virtual {
@@ -896,7 +1240,53 @@ impl Transpiler {
             } else {
                 String::new()
             };
-            let target = if method.is_virtual {
+            // Calls on a final class or to a final method can't be overridden, so they skip the vtbl
+            let is_final = method.is_final || class_.attributes.contains_key("final");
+            let is_dispatch = method.is_virtual && !is_final;
+            c += &format!("#define {}_{}(", class_.snake_name, method.name);
+            c += &std::iter::once("this".to_owned())
+                .chain(method.arguments.iter().map(|a| a.name.clone()))
+                .collect::<Vec<_>>()
+                .join(", ");
+            let arguments: Vec<String> = method
+                .arguments
+                .iter()
+                .map(|argument| {
+                    let found_class = self
+                        .classes
+                        .values()
+                        .find(|oc| {
+                            type_starts_with_name(&argument.type_, &oc.name)
+                                && !oc.attributes.contains_key("value")
+                        })
+                        .map(|oc| oc.name.clone());
+                    match found_class {
+                        Some(cn) => format!("({}*)({})", cn, argument.name),
+                        None => format!("({})", argument.name),
+                    }
+                })
+                .collect();
+            if self.profile && is_dispatch {
+                // Profiling builds mark the call as a virtual call for the callee, after the
+                // arguments are evaluated so calls in them can't take the mark
+                c += &format!(
+                    ") {return_cast}__extension__({{ {0}* _profile_this = ({0}*)(this);",
+                    class_.name
+                );
+                for (index, argument) in arguments.iter().enumerate() {
+                    c += &format!(" __auto_type _profile_arg{index} = {argument};");
+                }
+                c += &format!(
+                    " _PROFILE_VIRTUAL(); _profile_this->vtbl->{}(({}*)_profile_this",
+                    method.name, method.class_
+                );
+                for index in 0..arguments.len() {
+                    c += &format!(", _profile_arg{index}");
+                }
+                c += "); })\n";
+                continue;
+            }
+            let target = if is_dispatch {
                 format!(
                     "(({class_name}*)(this))->vtbl->{}",
                     method.name,
@@ -905,23 +1295,9 @@ impl Transpiler {
             } else {
                 format!("_{}_{}", to_snake_case(&method.class_), method.name)
             };
-            c += &format!("#define {}_{}(", class_.snake_name, method.name);
-            c += &std::iter::once("this".to_owned())
-                .chain(method.arguments.iter().map(|a| a.name.clone()))
-                .collect::<Vec<_>>()
-                .join(", ");
-            c += &format!(") {}{target}(({}*)(this)", return_cast, method.class_);
-            for argument in &method.arguments {
-                let found_class = self
-                    .classes
-                    .values()
-                    .find(|oc| argument.type_.starts_with(&oc.name))
-                    .map(|oc| oc.name.clone());
-                if let Some(cn) = found_class {
-                    c += &format!(", ({}*)({})", cn, argument.name);
-                } else {
-                    c += &format!(", ({})", argument.name);
-                }
+            c += &format!(") {return_cast}{target}(({}*)(this)", method.class_);
+            for argument in &arguments {
+                c += &format!(", {argument}");
             }
             c += ")\n";
         }
@@ -929,26 +1305,240 @@ impl Transpiler {
         c
     }
 
-    fn convert_class(
-        &mut self,
-        is_header: bool,
-        class_name: &str,
-        supers_raw: Option<&str>,
-        contents: &str,
-    ) -> String {
-        let (cn, parent_cn) = self.index_class(class_name, supers_raw, contents);
-        let g = self.codegen_missing_methods(&cn, &parent_cn, is_header);
-
-        let mut c = self.codegen_class_struct(&cn);
-        c += &self.codegen_class_forward_decls(&cn);
-        if !is_header && !self.classes[&cn].is_abstract {
-            c += &self.codegen_class_vtbl_instance(&cn);
-        }
-        c += &self.codegen_class_macros(&cn);
-        if !is_header {
-            c += &g;
-        }
-        c
+    // Accessors and inline methods are defined with the class, so other files can inline them
+    fn codegen_class_inline_methods(&self, class_name: &str) -> String {
+        let class_ = &self.classes[class_name];
+        let mut c = String::new();
+        for method in class_.methods.values() {
+            let Some(body) = &method.inline_body else {
+                continue;
+            };
+            if method.class_ != class_.name {
+                continue;
+            }
+            c += "static inline ";
+            if method.is_static {
+                c += &self.static_method_signature(class_, method);
+            } else {
+                c += &format!(
+                    "{} _{}_{}(",
+                    method.return_type, class_.snake_name, method.name
+                );
+                c += &std::iter::once(format!("{}* this", class_.name))
+                    .chain(
+                        method
+                            .arguments
+                            .iter()
+                            .map(|a| format!("{} {}", a.type_, a.name)),
+                    )
+                    .collect::<Vec<_>>()
+                    .join(", ");
+                c += ")";
+            }
+            let body =
+                self.step_instanceof(&self.step_cast(&self.step_move(&self.step_for_in(body))));
+            c += " {\n";
+            if let Some(hook) = self.profile_hook(&class_.name, &method.name) {
+                c += &format!("    {hook}\n");
+            }
+            c += &format!("    {body}\n}}\n\n");
+        }
+        c
+    }
+
+    fn convert_class(
+        &mut self,
+        is_header: bool,
+        class_name: &str,
+        attributes_raw: &str,
+        supers_raw: Option<&str>,
+        contents: &str,
+    ) -> String {
+        let (cn, parent_cn) = self.index_class(class_name, attributes_raw, supers_raw, contents);
+        if self.classes[&cn].attributes.contains_key("value") {
+            return self.convert_value_class(is_header, &cn);
+        }
+        let g = self.codegen_missing_methods(&cn, &parent_cn, is_header);
+
+        let mut c = self.codegen_class_struct(&cn);
+        c += &self.codegen_class_forward_decls(&cn);
+        if !is_header && !self.classes[&cn].is_abstract {
+            c += &self.codegen_class_vtbl_instance(&cn);
+        }
+        c += &self.codegen_class_macros(&cn);
+        c += &self.codegen_class_inline_methods(&cn);
+        if !is_header {
+            c += &g;
+        }
+        c
+    }
+
+    // Value classes are plain structs passed by value: no Object parent, vtbl or refcount,
+    // so every generated method is static inline and init works on a caller owned struct
+    fn convert_value_class(&mut self, is_header: bool, class_name: &str) -> String {
+        self.index_value_class_methods(class_name);
+
+        let class_ = &self.classes[class_name];
+        let mut c = format!("typedef struct {} {{\n", class_.name);
+        for field in class_.fields.values() {
+            c += &format!("    {} {};\n", field.type_, field.name);
+        }
+        c += &format!("}} {};\n\n", class_.name);
+        c += &self.codegen_class_forward_decls(class_name);
+        c += &self.codegen_class_macros(class_name);
+        c += &self.codegen_class_inline_methods(class_name);
+        c += &self.codegen_value_class_box(is_header, class_name);
+        c
+    }
+
+    fn index_value_class_methods(&mut self, class_name: &str) {
+        let class_ = &self.classes[class_name];
+        let snake_name = class_.snake_name.clone();
+
+        // Auto init assigns defaults and @init arguments like for object classes
+        let mut methods: Vec<Method> = Vec::new();
+        if !class_.methods.contains_key("init") {
+            let mut body: Vec<String> = Vec::new();
+            let mut arguments: Vec<Argument> = Vec::new();
+            for field in class_.fields.values() {
+                if let Some(ref default) = field.default {
+                    body.push(format!("this->{} = {};", field.name, default));
+                }
+                if let Some(init_attrs) = field.attributes.get("init") {
+                    arguments.push(Argument {
+                        name: field.name.clone(),
+                        type_: field.type_.clone(),
+                    });
+                    match init_attrs.first() {
+                        Some(init_fn) => {
+                            body.push(format!("this->{} = {init_fn}({});", field.name, field.name))
+                        }
+                        None => body.push(format!("this->{0} = {0};", field.name)),
+                    }
+                }
+            }
+            if body.is_empty() {
+                body.push("(void)this;".to_owned());
+            }
+            methods.push(Method {
+                name: "init".to_owned(),
+                return_type: "void".to_owned(),
+                is_return_self: false,
+                is_virtual: false,
+                is_final: false,
+                is_static: false,
+                arguments,
+                class_: class_name.to_owned(),
+                origin_class: class_name.to_owned(),
+                inline_body: Some(body.join("\n    ")),
+            });
+        }
+
+        // Every init() / init_<name>() gets a new() / new_<name>() returning the struct
+        let inits: Vec<Method> = class_
+            .methods
+            .values()
+            .chain(methods.iter())
+            .filter(|m| !m.is_static && (m.name == "init" || m.name.starts_with("init_")))
+            .cloned()
+            .collect();
+        for init in inits {
+            let suffix = &init.name["init".len()..];
+            let args: Vec<String> = std::iter::once("&this".to_owned())
+                .chain(init.arguments.iter().map(|a| a.name.clone()))
+                .collect();
+            methods.push(Method {
+                name: format!("new{suffix}"),
+                return_type: class_name.to_owned(),
+                is_return_self: false,
+                is_virtual: false,
+                is_final: false,
+                is_static: true,
+                arguments: init.arguments,
+                class_: class_name.to_owned(),
+                origin_class: class_name.to_owned(),
+                inline_body: Some(format!(
+                    "{class_name} this;\n    memset(&this, 0, sizeof(this));\n    _{snake_name}_init{suffix}({});\n    return this;",
+                    args.join(", ")
+                )),
+            });
+        }
+
+        let class_ = self.classes.get_mut(class_name).expect("class exists");
+        for method in methods {
+            class_.methods.insert(method.name.clone(), method);
+        }
+        self.index_accessors(class_name);
+    }
+
+    // A value class implementing interfaces gets a <Name>Box object class holding a copy,
+    // its interface methods forward to the value so cast<>() works on the box
+    fn codegen_value_class_box(&mut self, is_header: bool, class_name: &str) -> String {
+        let class_ = &self.classes[class_name];
+        if class_.interface_names.is_empty() {
+            return String::new();
+        }
+        let box_name = format!("{}Box", class_.name);
+        let mut forwarded: Vec<Method> = Vec::new();
+        for iface_name in &class_.interface_names {
+            for method in self.interfaces[iface_name].methods.values() {
+                if class_.methods.contains_key(&method.name)
+                    && !forwarded.iter().any(|m| m.name == method.name)
+                {
+                    forwarded.push(method.clone());
+                }
+            }
+        }
+
+        let mut body = format!("@get @init {class_name} value;\n");
+        for method in &forwarded {
+            body += &format!(
+                "virtual {} {}({});\n",
+                method.return_type.trim(),
+                method.name,
+                method
+                    .arguments
+                    .iter()
+                    .map(|a| format!("{} {}", a.type_, a.name))
+                    .collect::<Vec<_>>()
+                    .join(", ")
+            );
+        }
+        let supers = format!(": {}", class_.interface_names.join(", "));
+        let mut c = self.convert_class(is_header, &box_name, "@final ", Some(&supers), &body);
+
+        if !is_header {
+            let snake_name = &self.classes[class_name].snake_name;
+            let box_snake = &self.classes[&box_name].snake_name;
+            for method in &forwarded {
+                let return_type = method.return_type.trim();
+                c += &format!("{return_type} _{box_snake}_{}(", method.name);
+                c += &std::iter::once(format!("{box_name}* this"))
+                    .chain(
+                        method
+                            .arguments
+                            .iter()
+                            .map(|a| format!("{} {}", a.type_, a.name)),
+                    )
+                    .collect::<Vec<_>>()
+                    .join(", ");
+                c += ") {\n";
+                if let Some(hook) = self.profile_hook(&box_name, &method.name) {
+                    c += &format!("    {hook}\n");
+                }
+                c += "    ";
+                if return_type != "void" {
+                    c += "return ";
+                }
+                c += &format!("_{snake_name}_{}(", method.name);
+                c += &std::iter::once("&this->value".to_owned())
+                    .chain(method.arguments.iter().map(|a| a.name.clone()))
+                    .collect::<Vec<_>>()
+                    .join(", ");
+                c += ");\n}\n\n";
+            }
+        }
+        c
     }
 
     // MARK: Convert method / super calls
@@ -1002,12 +1592,16 @@ impl Transpiler {
                 }
             );
         }
-        if method_name == "init" {
+        // Additions stay on the line of the opening brace, so the body keeps its lines
+        if let Some(hook) = self.profile_hook(&class_name, &method_name) {
+            c += &format!(" {hook}");
+        }
+        if method_name == "init" || method_name.starts_with("init_") {
             for field in class_.fields.values() {
                 if field.class_ == class_name
                     && let Some(ref default) = field.default
                 {
-                    c += &format!("\n    this->{} = {};", field.name, default);
+                    c += &format!(" this->{} = {};", field.name, default);
                 }
             }
         }
@@ -1016,9 +1610,9 @@ impl Transpiler {
                 if field.class_ == class_name && field.attributes.contains_key("deinit") {
                     let deinit_attrs = &field.attributes["deinit"];
                     if !deinit_attrs.is_empty() {
-                        c += &format!("\n    {}(this->{});", deinit_attrs[0], field.name);
+                        c += &format!(" {}(this->{});", deinit_attrs[0], field.name);
                     } else {
-                        c += &format!("\n    free(this->{});", field.name);
+                        c += &format!(" free(this->{});", field.name);
                     }
                 }
             }
@@ -1096,41 +1690,195 @@ impl Transpiler {
         text
     }
 
-    fn step_interfaces(&mut self, text: &str) -> String {
-        let re_interface =
-            regex!(r"class\s+(I[A-Z][_A-Za-z0-9]*)(\s*:\s*[_A-Za-z][_A-Za-z0-9,\s]*)?\s*\{");
+    fn step_templates(&mut self, text: &str) -> String {
+        let re_template = regex!(
+            r"((?:@[_A-Za-z][_A-Za-z0-9]*(?:\([^\)]*\))?\s+)*)class\s+([_A-Za-z][_A-Za-z0-9]*)\s*<([^<>]*)>(\s*:\s*[_A-Za-z][_A-Za-z0-9,\s]*)?\s*\{"
+        );
+        let re_template_method = regex!(
+            r"(?m)^[^\n;{}]*?\b([_A-Za-z][_A-Za-z0-9]*)\s*<[^<>]*>::[_A-Za-z][_A-Za-z0-9]*\s*\("
+        );
         let mut text = text.to_owned();
-        loop {
-            let (match_start, match_end, iface_name, supers_raw) = {
-                let Some(caps) = re_interface.captures(&text) else {
-                    break;
-                };
-                let m0 = caps.get(0).expect("group 0 always present");
-                (
-                    m0.start(),
-                    m0.end(),
-                    caps[1].to_owned(),
-                    caps.get(2).map(|m| m.as_str().to_owned()),
-                )
-            };
-            let start = match_end - 1;
+
+        // Collect template classes
+        while let Some(caps) = re_template.captures(&text) {
+            let m0 = caps.get(0).expect("group 0 always present");
+            let start = m0.end() - 1;
             let pos = find_matching_close(&text, start);
-            let body = text[start + 1..pos].to_owned();
             let mut end = pos + 1;
             if end < text.len() && text.as_bytes()[end] == b';' {
                 end += 1;
             }
-            let replacement = self.convert_interface(&iface_name, supers_raw.as_deref(), &body);
-            text = format!("{}{}{}", &text[..match_start], replacement, &text[end..]);
+            let template = Template {
+                params: caps[3].split(',').map(|p| p.trim().to_owned()).collect(),
+                attributes_raw: caps[1].to_owned(),
+                supers_raw: caps.get(4).map(|m| m.as_str().to_owned()),
+                body: text[start + 1..pos].to_owned(),
+                methods: Vec::new(),
+            };
+            let (match_start, name) = (m0.start(), caps[2].to_owned());
+            drop(caps);
+            self.templates.insert(name, template);
+            text = format!("{}{}", &text[..match_start], &text[end..]);
+        }
+
+        // Collect template method definitions, `Name<T>::` is stored as `$Template::`
+        let mut search_from = 0;
+        while let Some(caps) = re_template_method.captures_at(&text, search_from) {
+            let m0 = caps.get(0).expect("group 0 always present");
+            if !self.templates.contains_key(&caps[1]) {
+                search_from = m0.end();
+                continue;
+            }
+            let paren_pos = find_matching_close(&text, m0.end() - 1);
+            let Some(brace_offset) = text[paren_pos..].find('{') else {
+                break;
+            };
+            let end = find_matching_close(&text, paren_pos + brace_offset) + 1;
+            let definition = text[m0.start()..end].to_owned();
+            let head = regex!(r"\b[_A-Za-z][_A-Za-z0-9]*\s*<[^<>]*>::")
+                .replace(&definition, "$$Template::")
+                .into_owned();
+            let (match_start, name) = (m0.start(), caps[1].to_owned());
+            drop(caps);
+            self.templates
+                .get_mut(&name)
+                .expect("template exists")
+                .methods
+                .push(head);
+            text = format!("{}{}", &text[..match_start], &text[end..]);
+            search_from = match_start;
+        }
+
+        self.instantiate_templates(&text)
+    }
+
+    fn instantiate_templates(&mut self, text: &str) -> String {
+        let re_instance = regex!(r"\b([A-Z][_A-Za-z0-9]*)\s*<([^<>;{}()]*)>");
+        let mut text = text.to_owned();
+        let mut search_from = 0;
+        while let Some(caps) = re_instance.captures_at(&text, search_from) {
+            let m0 = caps.get(0).expect("group 0 always present");
+            if !self.templates.contains_key(&caps[1]) {
+                search_from = m0.end();
+                continue;
+            }
+            let (match_start, match_end) = (m0.start(), m0.end());
+            let name = caps[1].to_owned();
+            let args: Vec<String> = caps[2].split(',').map(|a| a.trim().to_owned()).collect();
+            drop(caps);
+            let mangled = mangle_template_name(&name, &args);
+            text = format!("{}{}{}", &text[..match_start], mangled, &text[match_end..]);
+            // Rescan the line so enclosing instantiations like `Vec<Vec<i64>*>` are found too
+            search_from = text[..match_start].rfind('\n').map_or(0, |pos| pos + 1);
+
+            if !self.template_instances.contains(&mangled) {
+                self.template_instances.push(mangled.clone());
+                let code = self.instantiate_template(&name, &args, &mangled);
+                let insert_at = top_level_start(&text, match_start);
+                // The instance maps to the line using it, the code after it keeps its lines
+                let code = match (
+                    line_directive(&text, match_start),
+                    line_directive(&text, insert_at),
+                ) {
+                    (Some(use_directive), Some(directive)) => {
+                        format!("{}\n{directive}\n", pin_line_markers(&code, &use_directive))
+                    }
+                    _ => code,
+                };
+                text = format!("{}{}{}", &text[..insert_at], code, &text[insert_at..]);
+                search_from += code.len();
+            }
         }
         text
     }
 
+    fn instantiate_template(&mut self, name: &str, args: &[String], mangled: &str) -> String {
+        let template = self.templates[name].clone();
+        if args.len() != template.params.len() {
+            eprintln!(
+                "[ERROR] Template {name} expects {} arguments, got {}",
+                template.params.len(),
+                args.len()
+            );
+            std::process::exit(1);
+        }
+        let re_params = Regex::new(&format!(
+            r"\b({})\b",
+            template
+                .params
+                .iter()
+                .map(|p| regex::escape(p))
+                .collect::<Vec<_>>()
+                .join("|")
+        ))
+        .expect("valid template params regex");
+        let substitute = |code: &str| -> String {
+            re_params
+                .replace_all(code, |caps: &Captures| {
+                    let index = template
+                        .params
+                        .iter()
+                        .position(|p| p == &caps[1])
+                        .expect("matched a template param");
+                    args[index].clone()
+                })
+                .into_owned()
+        };
+
+        let mut source = format!(
+            "{}class {mangled}{} {{{}}};\n\n",
+            template.attributes_raw,
+            substitute(template.supers_raw.as_deref().unwrap_or("")),
+            substitute(&template.body)
+        );
+        for method in &template.methods {
+            source += &substitute(method).replace("$Template::", &format!("{mangled}::"));
+            source += "\n\n";
+        }
+        let source = self.instantiate_templates(&source);
+
+        // Every translation unit that uses an instantiation gets its own copy of the methods,
+        // the weak vtbl is merged by the linker
+        let code = self.step_classes(&source, false);
+        let code = self.step_default_body_implementations(&code);
+        let code = self.step_methods_and_super_calls(&code);
+        let code = self.step_for_in(&code);
+        let code = self.step_move(&code);
+        format!("\n{}\n", make_internal_linkage(&code))
+    }
+
+    fn step_interfaces(&mut self, text: &str) -> String {
+        let re_interface =
+            regex!(r"class\s+(I[A-Z][_A-Za-z0-9]*)(\s*:\s*[_A-Za-z][_A-Za-z0-9,\s]*)?\s*\{");
+        // Interfaces don't nest, so each one is copied over once in a single pass
+        let mut out = String::with_capacity(text.len());
+        let mut cursor = 0;
+        while let Some(caps) = re_interface.captures_at(text, cursor) {
+            let m0 = caps.get(0).expect("group 0 always present");
+            let start = m0.end() - 1;
+            let pos = find_matching_close(text, start);
+            let body = &text[start + 1..pos];
+            let mut end = pos + 1;
+            if end < text.len() && text.as_bytes()[end] == b';' {
+                end += 1;
+            }
+            out.push_str(&text[cursor..m0.start()]);
+            let code = self.convert_interface(&caps[1], caps.get(2).map(|m| m.as_str()), body);
+            out += &match line_directive(text, m0.start()) {
+                Some(directive) => pin_line_markers(&code, &directive),
+                None => code,
+            };
+            cursor = end;
+        }
+        out.push_str(&text[cursor..]);
+        out
+    }
+
     fn step_prescan_default_bodies(&mut self, text: &str) {
         let iface_names: Vec<String> = self.interfaces.keys().cloned().collect();
         for iface_name in &iface_names {
             let pattern = format!(
-                r"[_A-Za-z][_A-Za-z0-9 ]*[\**|\s+]\s*{}::([_A-Za-z][_A-Za-z0-9]*)\(",
+                r"[_A-Za-z][_A-Za-z0-9 ]*[\*\s]+\s*{}::([_A-Za-z][_A-Za-z0-9]*)\(",
                 regex::escape(iface_name)
             );
             let re = Regex::new(&pattern).expect("valid prescan regex");
@@ -1153,152 +1901,118 @@ impl Transpiler {
 
     fn step_classes(&mut self, text: &str, is_header: bool) -> String {
         let re_class_fwd = regex!(r"class\s+([_A-Za-z][_A-Za-z0-9]*)\s*;");
-        let re_class =
-            regex!(r"class\s+([_A-Za-z][_A-Za-z0-9]*)(\s*:\s*[_A-Za-z][_A-Za-z0-9,\s]*)?\s*\{");
-        let mut text = re_class_fwd
-            .replace_all(text, "typedef struct $1 $1;")
-            .into_owned();
-        loop {
-            let (match_start, match_end, class_name, supers_raw) = {
-                let Some(caps) = re_class.captures(&text) else {
-                    break;
-                };
-                let m0 = caps.get(0).expect("group 0 always present");
-                (
-                    m0.start(),
-                    m0.end(),
-                    caps[1].to_owned(),
-                    caps.get(2).map(|m| m.as_str().to_owned()),
-                )
-            };
-            let start = match_end - 1;
+        let re_class = regex!(
+            r"((?:@[_A-Za-z][_A-Za-z0-9]*(?:\([^\)]*\))?\s+)*)class\s+([_A-Za-z][_A-Za-z0-9]*)(\s*:\s*[_A-Za-z][_A-Za-z0-9,\s]*)?\s*\{"
+        );
+        let text = re_class_fwd.replace_all(text, "typedef struct $1 $1;");
+        // Classes don't nest, so each one is copied over once in a single pass
+        let mut out = String::with_capacity(text.len());
+        let mut cursor = 0;
+        while let Some(caps) = re_class.captures_at(&text, cursor) {
+            let m0 = caps.get(0).expect("group 0 always present");
+            let start = m0.end() - 1;
             let pos = find_matching_close(&text, start);
-            let body = text[start + 1..pos].to_owned();
+            let body = &text[start + 1..pos];
             let mut end = pos + 1;
             if end < text.len() && text.as_bytes()[end] == b';' {
                 end += 1;
             }
-            let replacement =
-                self.convert_class(is_header, &class_name, supers_raw.as_deref(), &body);
-            text = format!("{}{}{}", &text[..match_start], replacement, &text[end..]);
+            out.push_str(&text[cursor..m0.start()]);
+            let code = self.convert_class(
+                is_header,
+                &caps[2],
+                &caps[1],
+                caps.get(3).map(|m| m.as_str()),
+                body,
+            );
+            out += &match line_directive(&text, m0.start()) {
+                Some(directive) => pin_line_markers(&code, &directive),
+                None => code,
+            };
+            cursor = end;
         }
-        text
+        out.push_str(&text[cursor..]);
+        out
     }
 
     fn step_default_body_implementations(&mut self, text: &str) -> String {
-        let mut text = text.to_owned();
-        // Build regex cache once to avoid recompiling per-interface patterns in each outer iteration
-        let iface_names: Vec<String> = self.interfaces.keys().cloned().collect();
-        let re_cache: HashMap<String, Regex> = iface_names
-            .iter()
-            .map(|name| {
-                let pattern = format!(
-                    r"([_A-Za-z][_A-Za-z0-9 ]*[\**|\s+])\s*{}::([_A-Za-z][_A-Za-z0-9]*)\(([^\)]*)\)\s*\{{",
-                    regex::escape(name)
-                );
-                (
-                    name.clone(),
-                    Regex::new(&pattern).expect("valid per-interface regex"),
-                )
-            })
+        if self.interfaces.is_empty() {
+            return text.to_owned();
+        }
+        // One pattern for all interfaces, default bodies don't nest so a single pass suffices
+        let iface_names: Vec<String> = self
+            .interfaces
+            .keys()
+            .map(|name| regex::escape(name))
             .collect();
-        loop {
-            let mut found = false;
-            let iface_names: Vec<String> = self.interfaces.keys().cloned().collect();
-            for cur_iface_name in iface_names {
-                let re = &re_cache[&cur_iface_name];
-                let Some((dm_start, dm_end, ret_type, method_name, arguments_str)) = (|| {
-                    let caps = re.captures(&text)?;
-                    let m0 = caps.get(0)?;
-                    Some((
-                        m0.start(),
-                        m0.end(),
-                        caps[1].to_owned(),
-                        caps[2].to_owned(),
-                        caps[3].to_owned(),
-                    ))
-                })(
-                ) else {
-                    continue;
-                };
-                {
-                    if !self.interfaces[&cur_iface_name]
-                        .methods
-                        .contains_key(&method_name)
-                    {
-                        eprintln!(
-                            "[ERROR] Interface {cur_iface_name} has no method '{method_name}'"
-                        );
-                        std::process::exit(1);
-                    }
-                    let dstart = dm_end - 1;
-                    let dpos = find_matching_close(&text, dstart);
-                    let dend = dpos + 1;
-                    let body_text = text[dstart + 1..dpos].to_owned();
-                    let def_arguments = parse_arguments(&arguments_str);
-
-                    let snake_iface = self.interfaces[&cur_iface_name].snake_name.clone();
-                    let mut fn_code = format!(
-                        "static {} _{}_{}(void* this",
-                        ret_type.trim(),
-                        snake_iface,
-                        method_name
-                    );
-                    for arg in &def_arguments {
-                        fn_code += &format!(", {} {}", arg.type_, arg.name);
-                    }
-                    fn_code += ") {\n";
-                    fn_code += &format!("    const {cur_iface_name}Vtbl* _vtbl;\n");
-                    fn_code += "    {\n";
-                    fn_code += "        const _InterfaceSlot* _s = *(const _InterfaceSlot* const*)*(void* const*)this;\n";
-                    fn_code += "        _vtbl = NULL;\n";
-                    fn_code += "        if (_s) for (; _s->id; _s++) {\n";
-                    fn_code += &format!(
-                        "            if (_s->id == _{cur_iface_name}_ID) {{ _vtbl = (const {cur_iface_name}Vtbl*)_s->vtbl; break; }}\n"
-                    );
-                    fn_code += "        }\n";
-                    fn_code += "    }\n";
-                    let mut transformed_body = body_text.clone();
-                    let method_names: Vec<String> = self.interfaces[&cur_iface_name]
-                        .methods
-                        .keys()
-                        .cloned()
-                        .collect();
-                    for m_name in &method_names {
-                        let sub_re = Regex::new(&format!(r"\b{}\(this\b", regex::escape(m_name)))
-                            .expect("valid regex");
-                        transformed_body = sub_re
-                            .replace_all(
-                                &transformed_body,
-                                format!("_vtbl->{m_name}(this").as_str(),
-                            )
-                            .into_owned();
-                    }
-                    fn_code += &transformed_body;
-                    fn_code += "}\n\n";
-
-                    self.interfaces
-                        .get_mut(&cur_iface_name)
-                        .expect("interface exists")
-                        .default_bodies
-                        .insert(method_name.clone(), fn_code.clone());
-                    text = format!("{}{}{}", &text[..dm_start], fn_code, &text[dend..]);
-                    found = true;
-                }
-                if found {
-                    break;
-                }
+        let re_default = Regex::new(&format!(
+            r"([_A-Za-z][_A-Za-z0-9 ]*[\*\s]+)\s*\b({})::([_A-Za-z][_A-Za-z0-9]*)\(([^\)]*)\)\s*\{{",
+            iface_names.join("|")
+        ))
+        .expect("valid default body regex");
+        let mut out = String::with_capacity(text.len());
+        let mut cursor = 0;
+        while let Some(caps) = re_default.captures_at(text, cursor) {
+            let m0 = caps.get(0).expect("group 0 always present");
+            let (ret_type, cur_iface_name, method_name, arguments_str) =
+                (&caps[1], &caps[2], &caps[3], &caps[4]);
+            if !self.interfaces[cur_iface_name]
+                .methods
+                .contains_key(method_name)
+            {
+                eprintln!("[ERROR] Interface {cur_iface_name} has no method '{method_name}'");
+                std::process::exit(1);
             }
-            if !found {
-                break;
+            let dstart = m0.end() - 1;
+            let dpos = find_matching_close(text, dstart);
+            let body_text = &text[dstart + 1..dpos];
+            let def_arguments = parse_arguments(arguments_str);
+
+            let snake_iface = &self.interfaces[cur_iface_name].snake_name;
+            let mut fn_code = format!(
+                "static {} _{}_{}(void* this",
+                ret_type.trim(),
+                snake_iface,
+                method_name
+            );
+            for arg in &def_arguments {
+                fn_code += &format!(", {} {}", arg.type_, arg.name);
+            }
+            // Everything added to the body goes on the line of the opening brace
+            fn_code += ") {";
+            if let Some(hook) = self.profile_hook(cur_iface_name, method_name) {
+                fn_code += &format!(" {hook}");
+            }
+            fn_code += &format!(
+                " const {cur_iface_name}Vtbl* _vtbl = (const {cur_iface_name}Vtbl*)_interface_vtbl(*(const void* const*)this, _{cur_iface_name}_ID);"
+            );
+            let mut transformed_body = body_text.to_owned();
+            for m_name in self.interfaces[cur_iface_name].methods.keys() {
+                let sub_re = Regex::new(&format!(r"\b{}\(this\b", regex::escape(m_name)))
+                    .expect("valid regex");
+                transformed_body = sub_re
+                    .replace_all(&transformed_body, format!("_vtbl->{m_name}(this").as_str())
+                    .into_owned();
             }
+            fn_code += &transformed_body;
+            fn_code += "}\n\n";
+
+            out.push_str(&text[cursor..m0.start()]);
+            out += &fn_code;
+            self.interfaces
+                .get_mut(cur_iface_name)
+                .expect("interface exists")
+                .default_bodies
+                .insert(method_name.to_owned(), fn_code);
+            cursor = dpos + 1;
         }
-        text
+        out.push_str(&text[cursor..]);
+        out
     }
 
     fn step_methods_and_super_calls(&self, text: &str) -> String {
         let re_method_def = regex!(
-            r"([_A-Za-z][_A-Za-z0-9 ]*[\**|\s+])\s*([_A-Za-z][_A-Za-z0-9]*)::([_A-Za-z][_A-Za-z0-9]*)\(([^\)]*)\)\s*\{"
+            r"([_A-Za-z][_A-Za-z0-9 ]*[\*\s]+)\s*([_A-Za-z][_A-Za-z0-9]*)::([_A-Za-z][_A-Za-z0-9]*)\(([^\)]*)\)\s*\{"
         );
         let re_super_call =
             regex!(r"([_A-Za-z][_A-Za-z0-9]*)::([_A-Za-z][_A-Za-z0-9]*)\(([^\)]*)\)\s*;");
@@ -1329,228 +2043,272 @@ impl Transpiler {
         }
     }
 
+    // Static class of a plain variable, taken from its last `Class* name` declaration
+    // inside the current top-level function
+    fn static_class_of(
+        &self,
+        declarations: &HashMap<String, String>,
+        expr: &str,
+    ) -> Option<String> {
+        let class_name = declarations.get(expr)?;
+        self.classes
+            .contains_key(class_name)
+            .then(|| class_name.clone())
+    }
+
+    fn is_subclass_of(&self, class_name: &str, parent_name: &str) -> bool {
+        let mut current = Some(class_name.to_owned());
+        while let Some(name) = current {
+            if name == parent_name {
+                return true;
+            }
+            current = self
+                .classes
+                .get(&name)
+                .and_then(|class_| class_.parent_name.clone());
+        }
+        false
+    }
+
+    // Class that implements iterator() for a class, empty when it has none
+    fn iterator_class_of(&self, class_name: &str) -> &str {
+        self.classes[class_name]
+            .methods
+            .get("iterator")
+            .map_or("", |method| method.class_.as_str())
+    }
+
     fn step_for_in(&self, text: &str) -> String {
         let re_for_in = regex!(
             r"for\s*\(\s*([_A-Za-z][_A-Za-z0-9 \*]*\*?)\s+([_A-Za-z][_A-Za-z0-9]*)\s+in\s+([^\)]+)\)\s*\{"
         );
-        let mut text = text.to_owned();
+        let re_decl =
+            regex!(r"\b([_A-Za-z][_A-Za-z0-9]*)\s*\*\s*([_A-Za-z][_A-Za-z0-9]*)\s*[=;,\)]");
         let mut counter = 0usize;
-        loop {
-            let (match_start, match_end, var_type, var_name, iterable_expr) = {
-                let Some(caps) = re_for_in.captures(&text) else {
-                    break;
-                };
-                let m0 = caps.get(0).expect("group 0 always present");
-                (
-                    m0.start(),
-                    m0.end(),
-                    caps[1].trim().to_owned(),
-                    caps[2].trim().to_owned(),
-                    caps[3].trim().to_owned(),
-                )
-            };
+        // Start of the top-level block the output ends in and the `Class* name` declarations
+        // seen in it, both tracked as the output grows
+        let (mut scanned, mut depth, mut function_start) = (0, 0usize, 0);
+        let mut declarations: HashMap<String, String> = HashMap::new();
+        let mut declarations_scanned = 0;
+        rewrite_bracketed(text, re_for_in, |caps, out| {
+            for (pos, c) in out.bytes().enumerate().skip(scanned) {
+                match c {
+                    b'{' => depth += 1,
+                    b'}' => {
+                        depth = depth.saturating_sub(1);
+                        if depth == 0 {
+                            function_start = pos + 1;
+                        }
+                    }
+                    _ => {}
+                }
+            }
+            scanned = out.len();
+            if function_start > declarations_scanned {
+                declarations.clear();
+                declarations_scanned = function_start;
+            }
+            for decl in re_decl.captures_iter(&out[declarations_scanned..]) {
+                declarations.insert(decl[2].to_owned(), decl[1].to_owned());
+            }
+            declarations_scanned = out.len();
+
+            let var_type = caps[1].trim();
+            let var_name = caps[2].trim();
+            let iterable_expr = caps[3].trim();
             let iter_var = format!("_iter_{counter}");
             counter += 1;
-            let fstart = match_end - 1;
-            let fpos = find_matching_close(&text, fstart);
-            let body = text[fstart + 1..fpos].trim().to_owned();
-            let fend = fpos + 1;
-            let replacement = format!(
-                "{{\n    IIterator {iter_var} = i_iterable_iterator(cast<IIterable>({iterable_expr}));\n    while (i_iterator_has_next({iter_var})) {{\n        {var_type} {var_name} = ({var_type})i_iterator_next({iter_var});\n        {body}\n    }}\n    object_free((Object*){iter_var}.obj);\n}}",
-            );
-            text = format!("{}{}{}", &text[..match_start], replacement, &text[fend..]);
-        }
-        text
+            let static_class = self.static_class_of(&declarations, iterable_expr);
+            // The lowering stays on the lines of the loop and its closing brace, so the body
+            // keeps its line numbers
+            Some(match static_class {
+                // Lists are walked by index, no iterator object or interface dispatch, unless a
+                // subclass overrides iterator()
+                Some(class_name)
+                    if self.is_subclass_of(&class_name, "List")
+                        && self.iterator_class_of(&class_name) == "List" =>
+                {
+                    (
+                        format!(
+                            "{{ List* {iter_var} = (List*)({iterable_expr}); for (usize {iter_var}_i = 0; {iter_var}_i < {iter_var}->size; {iter_var}_i++) {{ {var_type} {var_name} = ({var_type}){iter_var}->items[{iter_var}_i];"
+                        ),
+                        "} }".to_owned(),
+                    )
+                }
+                // Classes with a slot cursor (Map, Set and the map views) are scanned in place
+                Some(class_name)
+                    if ["first_slot", "next_slot", "slot_item"]
+                        .iter()
+                        .all(|name| self.classes[&class_name].methods.contains_key(*name))
+                        && self.iterator_class_of(&class_name)
+                            == self.classes[&class_name].methods["slot_item"].class_ =>
+                {
+                    let snake_name = &self.classes[&class_name].snake_name;
+                    (
+                        format!(
+                            "{{ {class_name}* {iter_var} = ({class_name}*)({iterable_expr}); for (usize {iter_var}_i = {snake_name}_first_slot({iter_var}); {iter_var}_i != SIZE_MAX; {iter_var}_i = {snake_name}_next_slot({iter_var}, {iter_var}_i + 1)) {{ {var_type} {var_name} = ({var_type}){snake_name}_slot_item({iter_var}, {iter_var}_i);"
+                        ),
+                        "} }".to_owned(),
+                    )
+                }
+                // Known classes skip the interface slot scan of cast<IIterable>()
+                Some(class_name) if self.classes[&class_name].methods.contains_key("iterator") => {
+                    let snake_name = &self.classes[&class_name].snake_name;
+                    (
+                        format!(
+                            "{{ IIterator {iter_var} = {snake_name}_iterator({iterable_expr}); while (i_iterator_has_next({iter_var})) {{ {var_type} {var_name} = ({var_type})i_iterator_next({iter_var});"
+                        ),
+                        format!("}} object_free((Object*){iter_var}.obj); }}"),
+                    )
+                }
+                _ => (
+                    format!(
+                        "{{ IIterator {iter_var} = i_iterable_iterator(cast<IIterable>({iterable_expr})); while (i_iterator_has_next({iter_var})) {{ {var_type} {var_name} = ({var_type})i_iterator_next({iter_var});"
+                    ),
+                    format!("}} object_free((Object*){iter_var}.obj); }}"),
+                ),
+            })
+        })
     }
 
-    fn step_cast(&self, text: &str) -> String {
-        let re_cast_scan = regex!(r"cast<([_A-Za-z][_A-Za-z0-9]*)>");
-        let re_cast = regex!(r"cast<([_A-Za-z][_A-Za-z0-9]*)>\(");
-        let re_main = regex!(r"\bint\s+main\s*\(");
-        let re_insert_after_close = regex!(r"(}\n\n)([a-zA-Z#])");
+    // move(x) hands the caller's reference over: it lowers to x, and when it wraps the first
+    // argument after the receiver of a call that has a _move variant (map_set -> map_set_move),
+    // the call adopts that reference instead of taking one of its own
+    fn step_move(&self, text: &str) -> String {
+        let re_move = regex!(r"\bmove\(");
         let mut text = text.to_owned();
-        let mut ifaces_used: Vec<String> = Vec::new();
-        for caps in re_cast_scan.captures_iter(&text.clone()) {
-            let name = caps[1].to_owned();
-            if self.interfaces.contains_key(&name) && !ifaces_used.contains(&name) {
-                ifaces_used.push(name);
-            }
-        }
-
-        if !ifaces_used.is_empty() {
-            let mut lookup_code = String::new();
-            for lk_iface_name in &ifaces_used {
-                lookup_code +=
-                    &format!("static {lk_iface_name} _cast_{lk_iface_name}(void* obj) {{\n");
-                lookup_code += "    Object* _obj = (Object*)obj;\n";
-                lookup_code += "    const _InterfaceSlot* s = _obj->vtbl->interfaces;\n";
-                lookup_code += &format!("    const {lk_iface_name}Vtbl* vtbl = NULL;\n");
-                lookup_code += "    if (s) for (; s->id; s++) {\n";
-                lookup_code += &format!(
-                    "        if (s->id == _{lk_iface_name}_ID) {{ vtbl = (const {lk_iface_name}Vtbl*)s->vtbl; break; }}\n"
-                );
-                lookup_code += "    }\n";
-                lookup_code +=
-                    &format!("    return ({lk_iface_name}){{ .obj = _obj, .vtbl = vtbl }};\n");
-                lookup_code += "}\n\n";
-            }
-            let ins_pos = if let Some(m) = re_main.find(&text.clone()) {
-                m.start()
-            } else if let Some(m) = re_insert_after_close.find(&text.clone()) {
-                m.end() - 1
-            } else {
-                text.len()
-            };
-            text = format!("{}{}{}", &text[..ins_pos], lookup_code, &text[ins_pos..]);
-        }
-
-        loop {
-            let (match_start, match_end, cast_iface_name) = {
-                let Some(caps) = re_cast.captures(&text) else {
-                    break;
-                };
-                let iface = caps[1].to_owned();
-                if !self.interfaces.contains_key(&iface) {
-                    break;
+        let mut search_from = 0;
+        // Brace depth at `scanned`, move() is only lowered in function bodies
+        let (mut scanned, mut depth) = (0, 0usize);
+        while let Some(m) = re_move.find_at(&text, search_from) {
+            let (match_start, match_end) = (m.start(), m.end());
+            for c in text[scanned..match_start].bytes() {
+                match c {
+                    b'{' => depth += 1,
+                    b'}' => depth = depth.saturating_sub(1),
+                    _ => {}
                 }
-                let m0 = caps.get(0).expect("group 0 always present");
-                (m0.start(), m0.end(), iface)
-            };
-            let cstart = match_end - 1;
-            let cpos = find_matching_close(&text, cstart);
-            let obj_expr = text[cstart + 1..cpos].trim().to_owned();
-            let cend = cpos + 1;
+            }
+            scanned = match_start;
+            // Methods and fields called move, like the vtbl calls in the generated macros
+            let before = text[..match_start].trim_end();
+            let line_start = text[..match_start].rfind('\n').map_or(0, |pos| pos + 1);
+            if depth == 0
+                || before.ends_with("->")
+                || before.ends_with('.')
+                || text[line_start..].trim_start().starts_with('#')
+            {
+                search_from = match_end;
+                continue;
+            }
+            let mpos = find_matching_close(&text, match_end - 1);
+            let moved_expr = text[match_end..mpos].trim().to_owned();
+
+            // Walk out to the enclosing call, through any cast<I>(...) around the argument
+            let bytes = text.as_bytes();
+            let mut callee = None;
+            let mut argument_index = 0;
+            let mut depth = 0usize;
+            let mut pos = match_start;
+            while pos > 0 {
+                pos -= 1;
+                match bytes[pos] {
+                    b')' => depth += 1,
+                    b'(' if depth > 0 => depth -= 1,
+                    b',' if depth == 0 => argument_index += 1,
+                    b'(' => {
+                        let before = text[..pos].trim_end();
+                        if before.ends_with('>') {
+                            argument_index = 0;
+                            continue;
+                        }
+                        let name_start = before
+                            .rfind(|c: char| !(c.is_ascii_alphanumeric() || c == '_'))
+                            .map_or(0, |i| i + 1);
+                        callee = Some((name_start, before.len()));
+                        break;
+                    }
+                    b';' | b'{' | b'}' if depth == 0 => break,
+                    _ => {}
+                }
+            }
+
             text = format!(
-                "{}_cast_{}((void*)({})){}",
+                "{}{}{}",
                 &text[..match_start],
-                cast_iface_name,
-                obj_expr,
-                &text[cend..]
+                moved_expr,
+                &text[mpos + 1..]
             );
+            search_from = match_start;
+            if let Some((name_start, name_end)) = callee
+                && argument_index == 1
+            {
+                let name = &text[name_start..name_end];
+                let has_move_variant = self.classes.values().any(|class_| {
+                    name.strip_prefix(&format!("{}_", class_.snake_name))
+                        .is_some_and(|method_name| {
+                            class_.methods.contains_key(&format!("{method_name}_move"))
+                        })
+                });
+                if has_move_variant {
+                    text.insert_str(name_end, "_move");
+                    search_from += "_move".len();
+                    scanned += "_move".len();
+                }
+            }
         }
         text
     }
 
+    fn step_cast(&self, text: &str) -> String {
+        // The _cast_ helpers are declared next to each interface
+        let re_cast = regex!(r"cast<([_A-Za-z][_A-Za-z0-9]*)>\(");
+        rewrite_bracketed(text, re_cast, |caps, _| {
+            let iface_name = &caps[1];
+            self.interfaces
+                .contains_key(iface_name)
+                .then(|| (format!("_cast_{iface_name}((void*)("), "))".to_owned()))
+        })
+    }
+
     fn step_instanceof(&self, text: &str) -> String {
-        let re_instanceof_scan = regex!(r"instanceof<([_A-Za-z][_A-Za-z0-9]*)>");
+        // The _instanceof_ helpers are declared next to each class and interface
         let re_instanceof = regex!(r"instanceof<([_A-Za-z][_A-Za-z0-9]*)>\(");
-        let re_main = regex!(r"\bint\s+main\s*\(");
-        let re_func_marker = regex!(r"\n(?:typedef|extern|#|struct|}\s*;)");
-        let re_func_impl = regex!(r"\n[_A-Za-z*][_A-Za-z0-9*\s]*\s+\**[_A-Za-z][_A-Za-z0-9]*\s*\(");
-        let mut text = text.to_owned();
-        let mut types_for_instanceof: Vec<String> = Vec::new();
-        for caps in re_instanceof_scan.captures_iter(&text.clone()) {
-            let type_name = caps[1].to_owned();
-            if !types_for_instanceof.contains(&type_name) {
-                types_for_instanceof.push(type_name);
-            }
-        }
-
-        if !types_for_instanceof.is_empty() {
-            let mut instanceof_code = String::new();
-            let mut declared_vtbls: Vec<String> = Vec::new();
-            for type_name in &types_for_instanceof {
-                if self.classes.contains_key(type_name.as_str()) {
-                    for sub in self.concrete_subclasses(type_name) {
-                        if !declared_vtbls.contains(&sub) {
-                            instanceof_code += &format!("typedef struct {sub}Vtbl {sub}Vtbl;\n");
-                            instanceof_code += &format!("extern {sub}Vtbl _{sub}Vtbl;\n");
-                            declared_vtbls.push(sub);
-                        }
-                    }
-                }
+        let mut warned: Vec<String> = Vec::new();
+        rewrite_bracketed(text, re_instanceof, |caps, _| {
+            let inst_type_name = &caps[1];
+            if self
+                .classes
+                .get(inst_type_name)
+                .is_some_and(|class_| class_.attributes.contains_key("value"))
+            {
+                eprintln!("[ERROR] Value class '{inst_type_name}' can't be used in instanceof<>");
+                std::process::exit(1);
             }
-            instanceof_code += "\n";
-
-            for type_name in &types_for_instanceof {
-                if self.interfaces.contains_key(type_name.as_str()) {
-                    instanceof_code +=
-                        &format!("static bool _instanceof_{type_name}(void* obj) {{\n");
-                    instanceof_code += "    Object* _obj = (Object*)obj;\n";
-                    instanceof_code += "    const _InterfaceSlot* s = _obj->vtbl->interfaces;\n";
-                    instanceof_code += "    if (!s) return false;\n";
-                    instanceof_code += "    for (; s->id; s++)\n";
-                    instanceof_code +=
-                        &format!("        if (s->id == _{type_name}_ID) return true;\n");
-                    instanceof_code += "    return false;\n";
-                    instanceof_code += "}\n\n";
-                } else if self.classes.contains_key(type_name.as_str()) {
-                    let subs = self.concrete_subclasses(type_name);
-                    instanceof_code +=
-                        &format!("static bool _instanceof_{type_name}(void* obj) {{\n");
-                    instanceof_code += "    Object* _obj = (Object*)obj;\n";
-                    if !subs.is_empty() {
-                        let checks = subs
-                            .iter()
-                            .map(|s| format!("_obj->vtbl == (void*)&_{s}Vtbl"))
-                            .collect::<Vec<_>>()
-                            .join(" ||\n        ");
-                        instanceof_code += &format!("    return {checks};\n");
-                    } else {
-                        instanceof_code += "    return false;\n";
-                    }
-                    instanceof_code += "}\n\n";
-                } else {
+            if !self.interfaces.contains_key(inst_type_name)
+                && !self.classes.contains_key(inst_type_name)
+            {
+                if !warned.iter().any(|name| name == inst_type_name) {
                     eprintln!(
-                        "[WARNING] Type '{type_name}' used in instanceof<> is not defined as a class or interface"
+                        "[WARNING] Type '{inst_type_name}' used in instanceof<> is not defined as a class or interface"
                     );
+                    warned.push(inst_type_name.to_owned());
                 }
-            }
-
-            let ins_pos2 = if let Some(m) = re_main.find(&text.clone()) {
-                m.start()
-            } else if let Some(fm) = re_func_marker.find(&text.clone()) {
-                let rest = &text[fm.end()..];
-                if let Some(fi) = re_func_impl.find(rest) {
-                    fm.end() + fi.start()
-                } else {
-                    text.len()
-                }
-            } else {
-                text.len()
-            };
-            text = format!(
-                "{}{}{}",
-                &text[..ins_pos2],
-                instanceof_code,
-                &text[ins_pos2..]
-            );
-        }
-
-        loop {
-            let (match_start, match_end, inst_type_name) = {
-                let Some(caps) = re_instanceof.captures(&text) else {
-                    break;
-                };
-                let m0 = caps.get(0).expect("group 0 always present");
-                (m0.start(), m0.end(), caps[1].to_owned())
-            };
-            if !self.interfaces.contains_key(&inst_type_name)
-                && !self.classes.contains_key(&inst_type_name)
-            {
                 eprintln!(
                     "[ERROR] Type '{inst_type_name}' used in instanceof<> is not defined as a class or interface"
                 );
-                text = format!("{}false{}", &text[..match_start], &text[match_end..]);
-                continue;
+                return Some(("(false && (".to_owned(), "))".to_owned()));
             }
-            let istart = match_end - 1;
-            let ipos = find_matching_close(&text, istart);
-            let inst_expr = text[istart + 1..ipos].trim().to_owned();
-            let iend = ipos + 1;
-            text = format!(
-                "{}_instanceof_{}({}){}",
-                &text[..match_start],
-                inst_type_name,
-                inst_expr,
-                &text[iend..]
-            );
-        }
-        text
+            Some((format!("_instanceof_{inst_type_name}("), ")".to_owned()))
+        })
     }
 
     pub(crate) fn transpile(&mut self, path: &str, is_header: bool, text: &str) -> String {
-        let text = self.step_prelude_and_includes(path, is_header, text);
+        let line_path = std::fs::canonicalize(path)
+            .map_or(path.to_owned(), |path| path.to_string_lossy().into_owned());
+        let text = add_line_markers(text, &line_path);
+        let text = self.step_prelude_and_includes(path, is_header, &text);
+        let text = self.step_templates(&text);
         let text = self.step_interfaces(&text);
         if !is_header {
             self.step_prescan_default_bodies(&text);
@@ -1560,6 +2318,7 @@ impl Transpiler {
             let text = self.step_default_body_implementations(&text);
             let text = self.step_methods_and_super_calls(&text);
             let text = self.step_for_in(&text);
+            let text = self.step_move(&text);
             let text = self.step_cast(&text);
             let text = self.step_instanceof(&text);
             return text;
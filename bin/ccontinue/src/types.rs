@@ -29,18 +29,22 @@ pub(crate) struct Method {
     pub(crate) return_type: String,
     pub(crate) is_return_self: bool,
     pub(crate) is_virtual: bool,
+    pub(crate) is_final: bool,
     pub(crate) is_static: bool,
     pub(crate) arguments: Vec<Argument>,
     pub(crate) class_: String,
     pub(crate) origin_class: String,
+    /// Body of a method emitted as static inline next to its class
+    pub(crate) inline_body: Option<String>,
 }
 
-#[derive(Debug)]
+#[derive(Debug, Clone)]
 pub(crate) struct Class {
     pub(crate) name: String,
     pub(crate) snake_name: String,
     pub(crate) parent_name: Option<String>,
     pub(crate) is_abstract: bool,
+    pub(crate) attributes: IndexMap<String, Vec<String>>,
     pub(crate) fields: IndexMap<String, Field>,
     pub(crate) methods: IndexMap<String, Method>,
     pub(crate) interface_names: Vec<String>,
@@ -53,6 +57,7 @@ impl Class {
             name: name.to_owned(),
             parent_name,
             is_abstract: false,
+            attributes: IndexMap::new(),
             fields: IndexMap::new(),
             methods: IndexMap::new(),
             interface_names: Vec::new(),
@@ -60,7 +65,7 @@ impl Class {
     }
 }
 
-#[derive(Debug)]
+#[derive(Debug, Clone)]
 pub(crate) struct Interface {
     pub(crate) snake_name: String,
     pub(crate) id: usize,
@@ -80,3 +85,12 @@ impl Interface {
         }
     }
 }
+
+#[derive(Debug, Clone)]
+pub(crate) struct Template {
+    pub(crate) params: Vec<String>,
+    pub(crate) attributes_raw: String,
+    pub(crate) supers_raw: Option<String>,
+    pub(crate) body: String,
+    pub(crate) methods: Vec<String>,
+}
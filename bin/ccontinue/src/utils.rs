@@ -4,7 +4,8 @@
  * SPDX-License-Identifier: MIT
  */
 
-use regex::regex;
+use indexmap::IndexMap;
+use regex::{Captures, Regex, regex};
 
 use crate::types::Argument;
 
@@ -25,6 +26,13 @@ pub(crate) fn to_snake_case(camel_case: &str) -> String {
     }
 }
 
+// Whether a type spelling starts with the whole identifier name, so Map* matches Map but MapEntry* doesn't
+pub(crate) fn type_starts_with_name(type_: &str, name: &str) -> bool {
+    type_
+        .strip_prefix(name)
+        .is_some_and(|rest| !rest.starts_with(|c: char| c.is_ascii_alphanumeric() || c == '_'))
+}
+
 pub(crate) fn find_matching_close(text: &str, start: usize) -> usize {
     let bytes = text.as_bytes();
     let open_char = bytes[start];
@@ -45,12 +53,232 @@ pub(crate) fn find_matching_close(text: &str, start: usize) -> usize {
     pos
 }
 
+// Rewrite every construct matched by re, whose match ends at an opening ( or {, in one left to
+// right pass. replace gets the captures and the output so far and returns the text emitted in
+// place of the match and in place of the matching close, or None to keep the match. The bracket
+// contents are scanned in the same pass, so nested matches are rewritten as well and every byte
+// is copied once instead of rebuilding the text per match.
+pub(crate) fn rewrite_bracketed(
+    text: &str,
+    re: &Regex,
+    mut replace: impl FnMut(&Captures, &str) -> Option<(String, String)>,
+) -> String {
+    let mut out = String::with_capacity(text.len() + text.len() / 2);
+    let mut closes: Vec<(usize, String)> = Vec::new();
+    let mut cursor = 0;
+    loop {
+        let caps = re.captures_at(text, cursor);
+        let next_start = caps
+            .as_ref()
+            .map(|caps| caps.get(0).expect("group 0 always present").start());
+        // Emit the suffixes of brackets that close before the next match, innermost first
+        if let Some((close, _)) = closes.last()
+            && next_start.is_none_or(|start| *close < start)
+        {
+            let (close, suffix) = closes.pop().expect("close exists");
+            let close = close.min(text.len());
+            out.push_str(&text[cursor..close]);
+            out.push_str(&suffix);
+            cursor = (close + 1).min(text.len());
+            continue;
+        }
+        let Some(caps) = caps else {
+            break;
+        };
+        let m0 = caps.get(0).expect("group 0 always present");
+        out.push_str(&text[cursor..m0.start()]);
+        match replace(&caps, &out) {
+            Some((prefix, suffix)) => {
+                out.push_str(&prefix);
+                closes.push((find_matching_close(text, m0.end() - 1), suffix));
+            }
+            None => out.push_str(m0.as_str()),
+        }
+        cursor = m0.end();
+    }
+    out.push_str(&text[cursor..]);
+    out
+}
+
+// Where the top-level declaration containing pos starts: just after the last `;`, `}`
+// or preprocessor line outside of any braces, skipping comments and literals
+pub(crate) fn top_level_start(text: &str, pos: usize) -> usize {
+    let bytes = text.as_bytes();
+    let mut depth = 0usize;
+    let mut start = 0;
+    let mut i = 0;
+    while i < pos {
+        match bytes[i] {
+            b'{' => depth += 1,
+            b'}' => {
+                depth = depth.saturating_sub(1);
+                if depth == 0 {
+                    start = i + 1;
+                }
+            }
+            b';' if depth == 0 => start = i + 1,
+            b'/' if bytes.get(i + 1) == Some(&b'/') => {
+                while i < pos && bytes[i] != b'\n' {
+                    i += 1;
+                }
+                continue;
+            }
+            b'/' if bytes.get(i + 1) == Some(&b'*') => {
+                i += 2;
+                while i + 1 < pos && !(bytes[i] == b'*' && bytes[i + 1] == b'/') {
+                    i += 1;
+                }
+                i += 1;
+            }
+            quote @ (b'"' | b'\'') => {
+                i += 1;
+                while i < pos && bytes[i] != quote {
+                    if bytes[i] == b'\\' {
+                        i += 1;
+                    }
+                    i += 1;
+                }
+            }
+            b'#' if depth == 0 && (i == 0 || bytes[i - 1] == b'\n') => {
+                while i < pos && bytes[i] != b'\n' {
+                    i += 1;
+                }
+                start = i;
+                continue;
+            }
+            _ => {}
+        }
+        i += 1;
+    }
+    start
+}
+
+// Put a #line directive before every top-level declaration and preprocessor line of a source,
+// so compiler errors, debuggers and profilers point at the lines of path instead of the
+// transpiled C. Code generated for a declaration follows its directive and so maps to the
+// line of the declaration, the directive of the next one puts the numbering back in sync.
+// Only includes switch files, so the file name is only restated after preprocessor lines
+pub(crate) fn add_line_markers(text: &str, path: &str) -> String {
+    let file = path.replace('\\', "\\\\").replace('"', "\\\"");
+    insert_line_markers(text, |index, restate_file| {
+        Some(if restate_file {
+            format!("#line {} \"{file}\"", index + 1)
+        } else {
+            format!("#line {}", index + 1)
+        })
+    })
+}
+
+// Point every top-level declaration of generated code after its first line at the line of
+// directive, the line of the declaration the code was generated for
+pub(crate) fn pin_line_markers(code: &str, directive: &str) -> String {
+    insert_line_markers(code, |index, _| (index > 0).then(|| directive.to_owned()))
+}
+
+// Insert the directive marker gives for the line index before every line that starts a
+// top-level declaration or is a preprocessor line, told whether it's the first directive or
+// follows a preprocessor line
+fn insert_line_markers(text: &str, marker: impl Fn(usize, bool) -> Option<String>) -> String {
+    let mut out = String::with_capacity(text.len() + text.len() / 8);
+    let (mut depth, mut in_comment, mut continued, mut at_start) = (0usize, false, false, true);
+    let mut restate_file = true;
+    for (index, line) in text.split_inclusive('\n').enumerate() {
+        let trimmed = line.trim();
+        let in_code = !in_comment && !continued;
+        if in_code
+            && depth == 0
+            && at_start
+            && !trimmed.is_empty()
+            && !trimmed.starts_with("//")
+            && let Some(directive) = marker(index, restate_file)
+        {
+            out += &directive;
+            out.push('\n');
+            restate_file = false;
+        }
+        out += line;
+
+        if continued || (in_code && trimmed.starts_with('#')) {
+            continued = trimmed.ends_with('\\');
+            restate_file = true;
+            if depth == 0 {
+                at_start = !continued;
+            }
+            continue;
+        }
+        let bytes = line.as_bytes();
+        let mut i = 0;
+        while i < bytes.len() {
+            if in_comment {
+                if bytes[i..].starts_with(b"*/") {
+                    in_comment = false;
+                    i += 1;
+                }
+                i += 1;
+                continue;
+            }
+            match bytes[i] {
+                b'/' if bytes.get(i + 1) == Some(&b'/') => break,
+                b'/' if bytes.get(i + 1) == Some(&b'*') => {
+                    in_comment = true;
+                    i += 1;
+                }
+                quote @ (b'"' | b'\'') => {
+                    i += 1;
+                    while i < bytes.len() && bytes[i] != quote {
+                        if bytes[i] == b'\\' {
+                            i += 1;
+                        }
+                        i += 1;
+                    }
+                    at_start = false;
+                }
+                b'{' => {
+                    depth += 1;
+                    at_start = false;
+                }
+                b'}' => {
+                    depth = depth.saturating_sub(1);
+                    at_start = depth == 0;
+                }
+                b';' => at_start = depth == 0,
+                byte if byte.is_ascii_whitespace() => {}
+                _ => at_start = false,
+            }
+            i += 1;
+        }
+    }
+    out
+}
+
+// Directive numbering the line after it as the line of pos, from the last directive of
+// add_line_markers before pos, so code inserted there can put the numbering back
+pub(crate) fn line_directive(text: &str, pos: usize) -> Option<String> {
+    let start = text[..pos]
+        .rfind("\n#line ")
+        .map(|index| index + 1)
+        .or_else(|| text.starts_with("#line ").then_some(0))?;
+    let directive = &text[start + "#line ".len()..];
+    let directive = &directive[..directive.find('\n').unwrap_or(directive.len())];
+    let (line, file) = directive.split_once(' ').unwrap_or((directive, ""));
+    let line = line.parse::<usize>().ok()?;
+    let newlines = text[start..pos]
+        .bytes()
+        .filter(|byte| *byte == b'\n')
+        .count();
+    Some(
+        format!("#line {} {file}", line + newlines - 1)
+            .trim_end()
+            .to_owned(),
+    )
+}
+
 pub(crate) fn parse_arguments(arguments_str: &str) -> Vec<Argument> {
     let mut arguments = Vec::new();
     if !arguments_str.trim().is_empty() {
         for argument_str in arguments_str.split(',') {
             if let Some(caps) =
-                regex!(r"([_A-Za-z][_A-Za-z0-9 ]*[\**|\s+])\s*([_A-Za-z][_A-Za-z0-9]*)")
+                regex!(r"([_A-Za-z][_A-Za-z0-9 ]*[\*\s]+)\s*([_A-Za-z][_A-Za-z0-9]*)")
                     .captures(argument_str)
             {
                 arguments.push(Argument {
@@ -62,3 +290,109 @@ pub(crate) fn parse_arguments(arguments_str: &str) -> Vec<Argument> {
     }
     arguments
 }
+
+pub(crate) fn parse_attributes(attributes_str: &str) -> IndexMap<String, Vec<String>> {
+    let mut attributes = IndexMap::new();
+    for caps in regex!(r"@([_A-Za-z][_A-Za-z0-9]*)(\([^\)]*\))?").captures_iter(attributes_str) {
+        let args: Vec<String> = if let Some(args_str) = caps.get(2).map(|m| m.as_str()) {
+            args_str[1..args_str.len() - 1]
+                .split(',')
+                .map(|s| s.trim().to_owned())
+                .collect()
+        } else {
+            Vec::new()
+        };
+        attributes.insert(caps[1].to_owned(), args);
+    }
+    attributes
+}
+
+// Class name of a template instantiation: `Vec<i64>` becomes `VecI64`, `Pair<i32, Foo*>` `PairI32FooPtr`
+pub(crate) fn mangle_template_name(name: &str, args: &[String]) -> String {
+    let mut mangled = name.to_owned();
+    for arg in args {
+        for token in regex!(r"[_A-Za-z0-9]+|\*").find_iter(arg) {
+            let token = token.as_str();
+            if token == "*" {
+                mangled.push_str("Ptr");
+                continue;
+            }
+            let mut chars = token.chars();
+            if let Some(first) = chars.next() {
+                mangled.extend(first.to_uppercase());
+                mangled.push_str(chars.as_str());
+            }
+        }
+    }
+    mangled
+}
+
+// Gives every top-level function and variable in generated C code internal linkage, except
+// the class vtbl: it is weak, so the linker keeps one per instantiation and pointers to it
+// agree between translation units
+pub(crate) fn make_internal_linkage(code: &str) -> String {
+    let mut result = String::with_capacity(code.len());
+    for line in code.split_inclusive('\n') {
+        let trimmed = line.trim_end();
+        let is_vtbl = regex!(r"^([_A-Za-z][_A-Za-z0-9]*)Vtbl _([_A-Za-z0-9]*)Vtbl( = \{|;)$")
+            .captures(trimmed.strip_prefix("extern ").unwrap_or(trimmed))
+            .is_some_and(|caps| caps[1] == caps[2]);
+        if is_vtbl {
+            if trimmed.ends_with('{') {
+                result.push_str("__attribute__((weak)) ");
+            }
+            result.push_str(line);
+            continue;
+        }
+        if let Some(declaration) = line.strip_prefix("extern ") {
+            result.push_str("static ");
+            result.push_str(declaration);
+            continue;
+        }
+        let is_definition = line.starts_with(|c: char| c.is_ascii_alphabetic() || c == '_')
+            && !["typedef ", "struct ", "static ", "enum ", "union "]
+                .iter()
+                .any(|keyword| line.starts_with(keyword));
+        if is_definition && trimmed.ends_with("= {") {
+            result.push_str("static ");
+        } else if is_definition
+            && trimmed.contains('(')
+            && (trimmed.ends_with('{') || trimmed.ends_with(';'))
+        {
+            result.push_str("static inline ");
+        }
+        result.push_str(line);
+    }
+    result
+}
+
+// Class or interface id from its name, so every translation unit agrees on it without coordination
+pub(crate) fn type_id(name: &str) -> usize {
+    let mut hash: u32 = 2_166_136_261;
+    for byte in name.bytes() {
+        hash ^= u32::from(byte);
+        hash = hash.wrapping_mul(16_777_619);
+    }
+    // Id 0 marks an empty slot
+    hash.max(1) as usize
+}
+
+// Collision free interface table of a class: returns (mask, shift, slots) so that interface
+// `ids[i]` sits in `slots[(ids[i] >> shift) & mask]`, the table grows until such a layout exists
+pub(crate) fn interface_table_layout(ids: &[usize]) -> (u32, u32, Vec<Option<usize>>) {
+    let mut size = ids.len().next_power_of_two();
+    loop {
+        let mask = size - 1;
+        for shift in 0..32 {
+            let mut slots = vec![None; size];
+            if ids
+                .iter()
+                .enumerate()
+                .all(|(i, id)| slots[(id >> shift) & mask].replace(i).is_none())
+            {
+                return (mask as u32, shift, slots);
+            }
+        }
+        size *= 2;
+    }
+}
@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) 2026 Bastiaan van der Plaat
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <Deque.hh>
+
+// Deque
+static usize deque_capacity_for(usize capacity) {
+    usize power = 1;
+    while (power < capacity)
+        power <<= 1;
+    return power;
+}
+
+// The items that wrapped around to the front of the old buffer move behind the old end, so
+// they follow the others again in the doubled buffer
+static void deque_grow(Deque* deque, usize capacity) {
+    if (capacity <= deque->capacity)
+        return;
+    usize old_capacity = deque->capacity;
+    deque->capacity = deque_capacity_for(capacity);
+    deque->items = _object_buffer_realloc(deque, deque->items, sizeof(Object*) * old_capacity,
+                                          sizeof(Object*) * deque->capacity);
+    if (deque->head + deque->size > old_capacity) {
+        usize wrapped = deque->head + deque->size - old_capacity;
+        memcpy(&deque->items[old_capacity], deque->items, sizeof(Object*) * wrapped);
+    }
+}
+
+void Deque::init() {
+    Object::init();
+    this->items = _object_buffer_alloc(this, sizeof(Object*) * this->capacity);
+}
+
+void Deque::init_with_capacity(usize capacity) {
+    Object::init();
+    this->capacity = deque_capacity_for(capacity);
+    this->items = _object_buffer_alloc(this, sizeof(Object*) * this->capacity);
+}
+
+void Deque::deinit() {
+    deque_clear(this);
+    _object_buffer_free(this, this->items);
+    Object::deinit();
+}
+
+Self* Deque::promote() {
+    if (!_object_in_arena(this))
+        return (Deque*)object_ref(this);
+    Deque* copy = (Deque*)Object::promote();
+    copy->items = malloc(sizeof(Object*) * copy->capacity);
+    copy->head = 0;
+    for (usize i = 0; i < copy->size; i++) {
+        Object* item = deque_slot_item(this, i);
+        copy->items[i] = item != NULL ? object_promote(item) : NULL;
+    }
+    return copy;
+}
+
+Object* Deque::get(usize index) {
+    return this->items[(this->head + index) & (this->capacity - 1)];
+}
+
+Object* Deque::first() {
+    return this->size > 0 ? this->items[this->head] : NULL;
+}
+
+Object* Deque::last() {
+    return this->size > 0 ? this->items[(this->head + this->size - 1) & (this->capacity - 1)] : NULL;
+}
+
+void Deque::push_front(Object* item) {
+    deque_grow(this, this->size + 1);
+    this->head = (this->head - 1) & (this->capacity - 1);
+    this->items[this->head] = item;
+    this->size++;
+}
+
+void Deque::push_back(Object* item) {
+    deque_grow(this, this->size + 1);
+    this->items[(this->head + this->size) & (this->capacity - 1)] = item;
+    this->size++;
+}
+
+Object* Deque::pop_front() {
+    // The deque's reference moves to the caller
+    if (this->size == 0)
+        return NULL;
+    Object* item = this->items[this->head];
+    this->head = (this->head + 1) & (this->capacity - 1);
+    this->size--;
+    return item;
+}
+
+Object* Deque::pop_back() {
+    if (this->size == 0)
+        return NULL;
+    this->size--;
+    return this->items[(this->head + this->size) & (this->capacity - 1)];
+}
+
+void Deque::clear() {
+    for (usize i = 0; i < this->size; i++) {
+        Object* item = deque_slot_item(this, i);
+        if (item != NULL)
+            object_free(item);
+    }
+    this->head = 0;
+    this->size = 0;
+}
+
+void Deque::reserve(usize capacity) {
+    deque_grow(this, capacity);
+}
+
+IIterator Deque::iterator() {
+    return cast<IIterator>(deque_iterator_new(this));
+}
+
+// DequeIterator
+bool DequeIterator::has_next() {
+    return this->index < this->deque->size;
+}
+
+Object* DequeIterator::next() {
+    return deque_get(this->deque, this->index++);
+}
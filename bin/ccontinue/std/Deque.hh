@@ -0,0 +1,51 @@
+/*
+ * Copyright (c) 2026 Bastiaan van der Plaat
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include "Object.hh"
+
+// Double-ended queue in a growable ring buffer, the capacity stays a power of two
+class Deque : IIterable {
+    Object** items;
+    usize head = 0;
+    @get usize capacity = 8;
+    @get usize size = 0;
+
+    void init();
+    void init_with_capacity(usize capacity);
+    virtual void deinit();
+    virtual Self* promote();
+    Object* get(usize index);
+    Object* first();
+    Object* last();
+    void push_front(Object* item);
+    void push_back(Object* item);
+    Object* pop_front();
+    Object* pop_back();
+    void clear();
+    void reserve(usize capacity);
+    virtual IIterator iterator();
+
+    // Slot cursor behind for-in, nothing may be pushed or popped while it is used
+    inline usize first_slot() {
+        return this->size > 0 ? 0 : SIZE_MAX;
+    }
+    inline usize next_slot(usize slot) {
+        return slot < this->size ? slot : SIZE_MAX;
+    }
+    inline Object* slot_item(usize slot) {
+        return this->items[(this->head + slot) & (this->capacity - 1)];
+    }
+};
+
+class DequeIterator : IIterator {
+    @init Deque* deque;
+    usize index = 0;
+
+    virtual bool has_next();
+    virtual Object* next();
+};
@@ -0,0 +1,158 @@
+/*
+ * Copyright (c) 2026 Bastiaan van der Plaat
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include "Object.hh"
+
+// Linear probing hash map of unboxed keys and values, keys are hashed and compared inline
+// with _generic_hash() and ==, so pointer keys compare by identity
+class FlatMap<K, V> {
+    K* keys;
+    V* values;
+    u8* used;
+    @get usize capacity = 8;
+    @get usize size = 0;
+
+    void init();
+    void init_with_capacity(usize capacity);
+    virtual void deinit();
+    virtual Self* promote();
+    bool contains(K key);
+    V* get(K key);
+    void set(K key, V value);
+    bool remove(K key);
+    void clear();
+};
+
+void FlatMap<K, V>::init() {
+    Object::init();
+    this->keys = _object_buffer_alloc(this, sizeof(K) * this->capacity);
+    this->values = _object_buffer_alloc(this, sizeof(V) * this->capacity);
+    this->used = _object_buffer_calloc(this, this->capacity, sizeof(u8));
+}
+
+void FlatMap<K, V>::init_with_capacity(usize capacity) {
+    Object::init();
+    this->capacity = _linear_probe_capacity(capacity);
+    this->keys = _object_buffer_alloc(this, sizeof(K) * this->capacity);
+    this->values = _object_buffer_alloc(this, sizeof(V) * this->capacity);
+    this->used = _object_buffer_calloc(this, this->capacity, sizeof(u8));
+}
+
+void FlatMap<K, V>::deinit() {
+    _object_buffer_free(this, this->keys);
+    _object_buffer_free(this, this->values);
+    _object_buffer_free(this, this->used);
+    Object::deinit();
+}
+
+Self* FlatMap<K, V>::promote() {
+    if (!_object_in_arena(this))
+        return (FlatMap<K, V>*)object_ref(this);
+    FlatMap<K, V>* copy = (FlatMap<K, V>*)Object::promote();
+    copy->keys = malloc(sizeof(K) * copy->capacity);
+    memcpy(copy->keys, this->keys, sizeof(K) * copy->capacity);
+    copy->values = malloc(sizeof(V) * copy->capacity);
+    memcpy(copy->values, this->values, sizeof(V) * copy->capacity);
+    copy->used = malloc(copy->capacity);
+    memcpy(copy->used, this->used, copy->capacity);
+    return copy;
+}
+
+bool FlatMap<K, V>::contains(K key) {
+    usize mask = this->capacity - 1;
+    usize index = _generic_hash(key) & mask;
+    while (this->used[index]) {
+        if (_generic_equals(this->keys[index], key))
+            return true;
+        index = (index + 1) & mask;
+    }
+    return false;
+}
+
+V* FlatMap<K, V>::get(K key) {
+    usize mask = this->capacity - 1;
+    usize index = _generic_hash(key) & mask;
+    while (this->used[index]) {
+        if (_generic_equals(this->keys[index], key))
+            return &this->values[index];
+        index = (index + 1) & mask;
+    }
+    return NULL;
+}
+
+void FlatMap<K, V>::set(K key, V value) {
+    if (this->size >= this->capacity * 3 / 4) {
+        // Grow and reinsert, hashing primitives is cheaper than storing the hashes
+        usize old_capacity = this->capacity;
+        K* old_keys = this->keys;
+        V* old_values = this->values;
+        u8* old_used = this->used;
+        this->capacity <<= 1;
+        this->keys = _object_buffer_alloc(this, sizeof(K) * this->capacity);
+        this->values = _object_buffer_alloc(this, sizeof(V) * this->capacity);
+        this->used = _object_buffer_calloc(this, this->capacity, sizeof(u8));
+        for (usize i = 0; i < old_capacity; i++) {
+            if (old_used[i]) {
+                usize index = _generic_hash(old_keys[i]) & (this->capacity - 1);
+                while (this->used[index])
+                    index = (index + 1) & (this->capacity - 1);
+                this->keys[index] = old_keys[i];
+                this->values[index] = old_values[i];
+                this->used[index] = 1;
+            }
+        }
+        if (!_object_in_arena(this)) {
+            free(old_keys);
+            free(old_values);
+            free(old_used);
+        }
+    }
+
+    usize mask = this->capacity - 1;
+    usize index = _generic_hash(key) & mask;
+    while (this->used[index]) {
+        if (_generic_equals(this->keys[index], key)) {
+            this->values[index] = value;
+            return;
+        }
+        index = (index + 1) & mask;
+    }
+    this->keys[index] = key;
+    this->values[index] = value;
+    this->used[index] = 1;
+    this->size++;
+}
+
+bool FlatMap<K, V>::remove(K key) {
+    usize mask = this->capacity - 1;
+    usize index = _generic_hash(key) & mask;
+    while (this->used[index]) {
+        if (_generic_equals(this->keys[index], key)) {
+            // Backward shift deletion, see _linear_probe_remove()
+            usize hole = index;
+            for (usize next = (index + 1) & mask; this->used[next]; next = (next + 1) & mask) {
+                usize home = _generic_hash(this->keys[next]) & mask;
+                if (((next - home) & mask) >= ((next - hole) & mask)) {
+                    this->keys[hole] = this->keys[next];
+                    this->values[hole] = this->values[next];
+                    hole = next;
+                }
+            }
+            this->used[hole] = 0;
+            this->size--;
+            return true;
+        }
+        index = (index + 1) & mask;
+    }
+    return false;
+}
+
+void FlatMap<K, V>::clear() {
+    memset(this->used, 0, this->capacity);
+    this->size = 0;
+}
@@ -0,0 +1,162 @@
+/*
+ * Copyright (c) 2026 Bastiaan van der Plaat
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <HashMap.hh>
+#include "swiss.h"
+
+static void hash_map_alloc_slots(HashMap* map, usize capacity) {
+    map->capacity = capacity;
+    map->growth_left = capacity - capacity / 8 - map->size;
+    map->ctrl = _object_buffer_alloc(map, capacity + _SWISS_GROUP);
+    memset(map->ctrl, _SWISS_EMPTY, capacity + _SWISS_GROUP);
+    map->entries = _object_buffer_alloc(map, capacity * sizeof(_HashMapEntry));
+}
+
+static usize hash_map_find_free(HashMap* map, u32 hash) {
+    usize mask = map->capacity - 1;
+    usize pos = hash & mask;
+    usize stride = 0;
+    for (;;) {
+        _SwissMask free_mask = _swiss_match_empty_or_deleted(map->ctrl + pos);
+        if (free_mask != 0)
+            return (pos + _swiss_first(free_mask)) & mask;
+        stride += _SWISS_GROUP;
+        pos = (pos + stride) & mask;
+    }
+}
+
+static usize hash_map_find(HashMap* map, IKeyable key, u32 hash) {
+    usize mask = map->capacity - 1;
+    usize pos = hash & mask;
+    usize stride = 0;
+    u8 h2 = _swiss_h2(hash);
+    for (;;) {
+        const u8* group = map->ctrl + pos;
+        for (_SwissMask match = _swiss_match(group, h2); match != 0; match &= match - 1) {
+            usize index = (pos + _swiss_first(match)) & mask;
+            _HashMapEntry* entry = &map->entries[index];
+            if (entry->hash == hash && i_keyable_equals(entry->key, (Object*)key.obj))
+                return index;
+        }
+        if (_swiss_match_empty(group) != 0)
+            return SIZE_MAX;
+        stride += _SWISS_GROUP;
+        pos = (pos + stride) & mask;
+    }
+}
+
+static void hash_map_rehash(HashMap* map, usize capacity) {
+    u8* old_ctrl = map->ctrl;
+    _HashMapEntry* old_entries = map->entries;
+    usize old_capacity = map->capacity;
+    hash_map_alloc_slots(map, capacity);
+    for (usize i = 0; i < old_capacity; i++) {
+        if ((old_ctrl[i] & 0x80) == 0) {
+            usize index = hash_map_find_free(map, old_entries[i].hash);
+            _swiss_set_ctrl(map->ctrl, map->capacity, index, old_ctrl[i]);
+            map->entries[index] = old_entries[i];
+        }
+    }
+    if (!_object_in_arena(map)) {
+        free(old_ctrl);
+        free(old_entries);
+    }
+}
+
+void HashMap::init() {
+    Object::init();
+    hash_map_alloc_slots(this, this->capacity);
+}
+
+void HashMap::deinit() {
+    for (usize i = 0; i < this->capacity; i++) {
+        if ((this->ctrl[i] & 0x80) == 0) {
+            object_free((Object*)this->entries[i].key.obj);
+            if (this->entries[i].value != NULL)
+                object_free(this->entries[i].value);
+        }
+    }
+    _object_buffer_free(this, this->ctrl);
+    _object_buffer_free(this, this->entries);
+    Object::deinit();
+}
+
+Self* HashMap::promote() {
+    if (!_object_in_arena(this))
+        return (HashMap*)object_ref(this);
+    HashMap* copy = (HashMap*)Object::promote();
+    copy->ctrl = malloc(this->capacity + _SWISS_GROUP);
+    memcpy(copy->ctrl, this->ctrl, this->capacity + _SWISS_GROUP);
+    copy->entries = malloc(this->capacity * sizeof(_HashMapEntry));
+    for (usize i = 0; i < this->capacity; i++) {
+        if ((this->ctrl[i] & 0x80) == 0) {
+            copy->entries[i] = this->entries[i];
+            copy->entries[i].key.obj = object_promote((Object*)this->entries[i].key.obj);
+            if (this->entries[i].value != NULL)
+                copy->entries[i].value = object_promote(this->entries[i].value);
+        }
+    }
+    return copy;
+}
+
+Object* HashMap::get(IKeyable key) {
+    usize index = hash_map_find(this, key, i_keyable_hash(key));
+    return index != SIZE_MAX ? this->entries[index].value : NULL;
+}
+
+// With adopt the map takes over the caller's key reference, which is dropped when the key is
+// already present
+static void hash_map_put(HashMap* map, IKeyable key, Object* value, bool adopt) {
+    u32 hash = i_keyable_hash(key);
+    usize index = hash_map_find(map, key, hash);
+    if (index != SIZE_MAX) {
+        object_free(map->entries[index].value);
+        map->entries[index].value = value;
+        if (adopt)
+            object_free((Object*)key.obj);
+        return;
+    }
+
+    if (map->growth_left == 0) {
+        // Only tombstones are in the way: rehash at the same capacity instead of growing
+        bool grow = map->size >= (map->capacity - map->capacity / 8) / 2;
+        hash_map_rehash(map, grow ? map->capacity << 1 : map->capacity);
+    }
+    index = hash_map_find_free(map, hash);
+    if (map->ctrl[index] == _SWISS_EMPTY)
+        map->growth_left--;
+    _swiss_set_ctrl(map->ctrl, map->capacity, index, _swiss_h2(hash));
+    if (!adopt)
+        object_ref((Object*)key.obj);
+    map->entries[index].key = key;
+    map->entries[index].value = value;
+    map->entries[index].hash = hash;
+    map->size++;
+}
+
+void HashMap::set(IKeyable key, Object* value) {
+    hash_map_put(this, key, value, false);
+}
+
+void HashMap::set_move(IKeyable key, Object* value) {
+    hash_map_put(this, key, value, true);
+}
+
+void HashMap::remove(IKeyable key) {
+    usize index = hash_map_find(this, key, i_keyable_hash(key));
+    if (index == SIZE_MAX)
+        return;
+    object_free((Object*)this->entries[index].key.obj);
+    if (this->entries[index].value != NULL)
+        object_free(this->entries[index].value);
+    if (_swiss_can_empty(this->ctrl, this->capacity, index)) {
+        _swiss_set_ctrl(this->ctrl, this->capacity, index, _SWISS_EMPTY);
+        this->growth_left++;
+    } else {
+        _swiss_set_ctrl(this->ctrl, this->capacity, index, _SWISS_DELETED);
+    }
+    this->size--;
+}
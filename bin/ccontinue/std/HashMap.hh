@@ -0,0 +1,31 @@
+/*
+ * Copyright (c) 2026 Bastiaan van der Plaat
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include "Object.hh"
+
+typedef struct _HashMapEntry {
+    IKeyable key;
+    Object* value;
+    u32 hash;
+} _HashMapEntry;
+
+class HashMap {
+    u8* ctrl;
+    _HashMapEntry* entries;
+    @get usize capacity = 16;
+    @get usize size = 0;
+    usize growth_left;
+
+    void init();
+    virtual void deinit();
+    virtual Self* promote();
+    Object* get(IKeyable key);
+    void set(IKeyable key, Object* value);
+    void set_move(IKeyable key, Object* value);
+    void remove(IKeyable key);
+};
@@ -0,0 +1,150 @@
+/*
+ * Copyright (c) 2026 Bastiaan van der Plaat
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <HashSet.hh>
+#include "swiss.h"
+
+static void hash_set_alloc_slots(HashSet* set, usize capacity) {
+    set->capacity = capacity;
+    set->growth_left = capacity - capacity / 8 - set->size;
+    set->ctrl = _object_buffer_alloc(set, capacity + _SWISS_GROUP);
+    memset(set->ctrl, _SWISS_EMPTY, capacity + _SWISS_GROUP);
+    set->entries = _object_buffer_alloc(set, capacity * sizeof(_HashSetEntry));
+}
+
+static usize hash_set_find_free(HashSet* set, u32 hash) {
+    usize mask = set->capacity - 1;
+    usize pos = hash & mask;
+    usize stride = 0;
+    for (;;) {
+        _SwissMask free_mask = _swiss_match_empty_or_deleted(set->ctrl + pos);
+        if (free_mask != 0)
+            return (pos + _swiss_first(free_mask)) & mask;
+        stride += _SWISS_GROUP;
+        pos = (pos + stride) & mask;
+    }
+}
+
+static usize hash_set_find(HashSet* set, IKeyable key, u32 hash) {
+    usize mask = set->capacity - 1;
+    usize pos = hash & mask;
+    usize stride = 0;
+    u8 h2 = _swiss_h2(hash);
+    for (;;) {
+        const u8* group = set->ctrl + pos;
+        for (_SwissMask match = _swiss_match(group, h2); match != 0; match &= match - 1) {
+            usize index = (pos + _swiss_first(match)) & mask;
+            _HashSetEntry* entry = &set->entries[index];
+            if (entry->hash == hash && i_keyable_equals(entry->key, (Object*)key.obj))
+                return index;
+        }
+        if (_swiss_match_empty(group) != 0)
+            return SIZE_MAX;
+        stride += _SWISS_GROUP;
+        pos = (pos + stride) & mask;
+    }
+}
+
+static void hash_set_rehash(HashSet* set, usize capacity) {
+    u8* old_ctrl = set->ctrl;
+    _HashSetEntry* old_entries = set->entries;
+    usize old_capacity = set->capacity;
+    hash_set_alloc_slots(set, capacity);
+    for (usize i = 0; i < old_capacity; i++) {
+        if ((old_ctrl[i] & 0x80) == 0) {
+            usize index = hash_set_find_free(set, old_entries[i].hash);
+            _swiss_set_ctrl(set->ctrl, set->capacity, index, old_ctrl[i]);
+            set->entries[index] = old_entries[i];
+        }
+    }
+    if (!_object_in_arena(set)) {
+        free(old_ctrl);
+        free(old_entries);
+    }
+}
+
+void HashSet::init() {
+    Object::init();
+    hash_set_alloc_slots(this, this->capacity);
+}
+
+void HashSet::deinit() {
+    for (usize i = 0; i < this->capacity; i++) {
+        if ((this->ctrl[i] & 0x80) == 0)
+            object_free((Object*)this->entries[i].key.obj);
+    }
+    _object_buffer_free(this, this->ctrl);
+    _object_buffer_free(this, this->entries);
+    Object::deinit();
+}
+
+Self* HashSet::promote() {
+    if (!_object_in_arena(this))
+        return (HashSet*)object_ref(this);
+    HashSet* copy = (HashSet*)Object::promote();
+    copy->ctrl = malloc(this->capacity + _SWISS_GROUP);
+    memcpy(copy->ctrl, this->ctrl, this->capacity + _SWISS_GROUP);
+    copy->entries = malloc(this->capacity * sizeof(_HashSetEntry));
+    for (usize i = 0; i < this->capacity; i++) {
+        if ((this->ctrl[i] & 0x80) == 0) {
+            copy->entries[i] = this->entries[i];
+            copy->entries[i].key.obj = object_promote((Object*)this->entries[i].key.obj);
+        }
+    }
+    return copy;
+}
+
+bool HashSet::contains(IKeyable key) {
+    return hash_set_find(this, key, i_keyable_hash(key)) != SIZE_MAX;
+}
+
+// With adopt the set takes over the caller's reference, which is dropped when the key is
+// already present
+static void hash_set_put(HashSet* set, IKeyable key, bool adopt) {
+    u32 hash = i_keyable_hash(key);
+    if (hash_set_find(set, key, hash) != SIZE_MAX) {
+        if (adopt)
+            object_free((Object*)key.obj);
+        return;
+    }
+
+    if (set->growth_left == 0) {
+        // Only tombstones are in the way: rehash at the same capacity instead of growing
+        bool grow = set->size >= (set->capacity - set->capacity / 8) / 2;
+        hash_set_rehash(set, grow ? set->capacity << 1 : set->capacity);
+    }
+    usize index = hash_set_find_free(set, hash);
+    if (set->ctrl[index] == _SWISS_EMPTY)
+        set->growth_left--;
+    _swiss_set_ctrl(set->ctrl, set->capacity, index, _swiss_h2(hash));
+    if (!adopt)
+        object_ref((Object*)key.obj);
+    set->entries[index].key = key;
+    set->entries[index].hash = hash;
+    set->size++;
+}
+
+void HashSet::add(IKeyable key) {
+    hash_set_put(this, key, false);
+}
+
+void HashSet::add_move(IKeyable key) {
+    hash_set_put(this, key, true);
+}
+
+void HashSet::remove(IKeyable key) {
+    usize index = hash_set_find(this, key, i_keyable_hash(key));
+    if (index == SIZE_MAX)
+        return;
+    object_free((Object*)this->entries[index].key.obj);
+    if (_swiss_can_empty(this->ctrl, this->capacity, index)) {
+        _swiss_set_ctrl(this->ctrl, this->capacity, index, _SWISS_EMPTY);
+        this->growth_left++;
+    } else {
+        _swiss_set_ctrl(this->ctrl, this->capacity, index, _SWISS_DELETED);
+    }
+    this->size--;
+}
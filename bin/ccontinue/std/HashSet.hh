@@ -0,0 +1,30 @@
+/*
+ * Copyright (c) 2026 Bastiaan van der Plaat
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include "Object.hh"
+
+typedef struct _HashSetEntry {
+    IKeyable key;
+    u32 hash;
+} _HashSetEntry;
+
+class HashSet {
+    u8* ctrl;
+    _HashSetEntry* entries;
+    @get usize capacity = 16;
+    @get usize size = 0;
+    usize growth_left;
+
+    void init();
+    virtual void deinit();
+    virtual Self* promote();
+    bool contains(IKeyable key);
+    void add(IKeyable key);
+    void add_move(IKeyable key);
+    void remove(IKeyable key);
+};
@@ -4,60 +4,539 @@
  * SPDX-License-Identifier: MIT
  */
 
+#include <math.h>
+
 #include <List.hh>
+#include <String.hh>
 
 // List
+static void list_grow(List* list, usize capacity) {
+    if (capacity <= list->capacity)
+        return;
+    usize old_capacity = list->capacity;
+    while (list->capacity < capacity)
+        list->capacity <<= 1;
+    list->items = _object_buffer_realloc(list, list->items, sizeof(Object*) * old_capacity,
+                                         sizeof(Object*) * list->capacity);
+}
+
 void List::init() {
     Object::init();
-    this->items = malloc(sizeof(Object*) * this->capacity);
+    this->items = _object_buffer_alloc(this, sizeof(Object*) * this->capacity);
+}
+
+void List::init_with_capacity(usize capacity) {
+    Object::init();
+    this->capacity = capacity > 0 ? capacity : 1;
+    this->items = _object_buffer_alloc(this, sizeof(Object*) * this->capacity);
 }
 
 void List::deinit() {
-    for (usize i = 0; i < this->size; i++)
-        object_free(this->items[i]);
-    free(this->items);
+    for (usize i = 0; i < this->size; i++) {
+        if (this->items[i] != NULL)
+            object_free(this->items[i]);
+    }
+    _object_buffer_free(this, this->items);
     Object::deinit();
 }
 
+Self* List::promote() {
+    if (!_object_in_arena(this))
+        return (List*)object_ref(this);
+    List* copy = (List*)Object::promote();
+    copy->items = malloc(sizeof(Object*) * copy->capacity);
+    for (usize i = 0; i < copy->size; i++)
+        copy->items[i] = this->items[i] != NULL ? object_promote(this->items[i]) : NULL;
+    return copy;
+}
+
 Object* List::get(usize index) {
     return this->items[index];
 }
 
 void List::set(usize index, Object* item) {
-    if (index > this->capacity) {
-        while (index > this->capacity)
-            this->capacity <<= 1;
-        this->items = realloc(this->items, sizeof(Object*) * this->capacity);
-    }
+    list_grow(this, index + 1);
     while (this->size <= index)
         this->items[this->size++] = NULL;
     this->items[index] = item;
 }
 
 void List::add(Object* item) {
-    if (this->size == this->capacity) {
-        this->capacity <<= 1;
-        this->items = realloc(this->items, sizeof(Object*) * this->capacity);
-    }
+    list_grow(this, this->size + 1);
     this->items[this->size++] = item;
 }
 
 void List::insert(usize index, Object* item) {
-    if (this->size == this->capacity) {
-        this->capacity <<= 1;
-        this->items = realloc(this->items, sizeof(Object*) * this->capacity);
-    }
-    for (usize i = this->size - 1; i >= index; i--)
-        this->items[i + 1] = this->items[i];
+    list_grow(this, this->size + 1);
+    memmove(&this->items[index + 1], &this->items[index], sizeof(Object*) * (this->size - index));
     this->size++;
     this->items[index] = item;
 }
 
 void List::remove(usize index) {
-    object_free(this->items[index]);
-    for (usize i = index; i < this->size - 1; i++)
-        this->items[i] = this->items[i + 1];
-    this->size--;
+    list_remove_range(this, index, 1);
+}
+
+void List::add_all(List* other) {
+    // Items end up owned by both lists
+    list_grow(this, this->size + other->size);
+    for (usize i = 0; i < other->size; i++) {
+        Object* item = other->items[i];
+        this->items[this->size++] = item != NULL ? object_ref(item) : NULL;
+    }
+}
+
+void List::extend(IIterable iterable) {
+    IIterator iterator = i_iterable_iterator(iterable);
+    while (i_iterator_has_next(iterator)) {
+        Object* item = i_iterator_next(iterator);
+        list_add(this, item != NULL ? object_ref(item) : NULL);
+    }
+    object_free((Object*)iterator.obj);
+}
+
+void List::remove_range(usize start, usize length) {
+    for (usize i = start; i < start + length; i++) {
+        if (this->items[i] != NULL)
+            object_free(this->items[i]);
+    }
+    memmove(&this->items[start], &this->items[start + length],
+            sizeof(Object*) * (this->size - start - length));
+    this->size -= length;
+}
+
+void List::truncate(usize size) {
+    if (size < this->size)
+        list_remove_range(this, size, this->size - size);
+}
+
+void List::reserve(usize capacity) {
+    if (capacity > this->capacity) {
+        this->items = _object_buffer_realloc(this, this->items, sizeof(Object*) * this->capacity,
+                                             sizeof(Object*) * capacity);
+        this->capacity = capacity;
+    }
+}
+
+void List::shrink_to_fit() {
+    // Arena buffers are only released with their arena
+    usize capacity = this->size > 0 ? this->size : 1;
+    if (_object_in_arena(this) || capacity == this->capacity)
+        return;
+    this->items = realloc(this->items, sizeof(Object*) * capacity);
+    this->capacity = capacity;
+}
+
+// Sorting: pattern-defeating quicksort (Orson Peters) for sort() and a merge sort for
+// sort_stable(), both generated per comparison so boxed Int, Float and String lists compare
+// raw values inline instead of calling through IComparable
+#define _LIST_SORT_INSERTION 24
+#define _LIST_SORT_NINTHER 128
+#define _LIST_SORT_PARTIAL_MOVES 8
+
+#define _LIST_SWAP(a, b)     \
+    do {                     \
+        Object* _tmp = *(a); \
+        *(a) = *(b);         \
+        *(b) = _tmp;         \
+    } while (0)
+
+#define _LIST_DEFINE_SORT(name, LESS)                                                             \
+    static void name##_insertion(Object** begin, Object** end, const void* ctx) {                 \
+        (void)ctx;                                                                                \
+        for (Object** cur = begin + 1; cur < end; cur++) {                                        \
+            Object* tmp = *cur;                                                                   \
+            Object** sift = cur;                                                                  \
+            while (sift != begin && LESS(tmp, sift[-1])) {                                        \
+                *sift = sift[-1];                                                                 \
+                sift--;                                                                           \
+            }                                                                                     \
+            *sift = tmp;                                                                          \
+        }                                                                                         \
+    }                                                                                             \
+                                                                                                  \
+    /* begin[-1] is known to be <= every item, so the inner loop needs no bounds check */         \
+    static void name##_unguarded_insertion(Object** begin, Object** end, const void* ctx) {       \
+        (void)ctx;                                                                                \
+        for (Object** cur = begin + 1; cur < end; cur++) {                                        \
+            Object* tmp = *cur;                                                                   \
+            Object** sift = cur;                                                                  \
+            while (LESS(tmp, sift[-1])) {                                                         \
+                *sift = sift[-1];                                                                 \
+                sift--;                                                                           \
+            }                                                                                     \
+            *sift = tmp;                                                                          \
+        }                                                                                         \
+    }                                                                                             \
+                                                                                                  \
+    /* Gives up after a few moves, so nearly sorted ranges finish in linear time */               \
+    static bool name##_partial_insertion(Object** begin, Object** end, const void* ctx) {         \
+        (void)ctx;                                                                                \
+        usize moves = 0;                                                                          \
+        for (Object** cur = begin + 1; cur < end; cur++) {                                        \
+            Object* tmp = *cur;                                                                   \
+            Object** sift = cur;                                                                  \
+            while (sift != begin && LESS(tmp, sift[-1])) {                                        \
+                *sift = sift[-1];                                                                 \
+                sift--;                                                                           \
+            }                                                                                     \
+            *sift = tmp;                                                                          \
+            moves += (usize)(cur - sift);                                                         \
+            if (moves > _LIST_SORT_PARTIAL_MOVES)                                                 \
+                return cur + 1 == end;                                                            \
+        }                                                                                         \
+        return true;                                                                              \
+    }                                                                                             \
+                                                                                                  \
+    static void name##_sort3(Object** a, Object** b, Object** c, const void* ctx) {               \
+        (void)ctx;                                                                                \
+        if (LESS(*b, *a))                                                                         \
+            _LIST_SWAP(a, b);                                                                     \
+        if (LESS(*c, *b))                                                                         \
+            _LIST_SWAP(b, c);                                                                     \
+        if (LESS(*b, *a))                                                                         \
+            _LIST_SWAP(a, b);                                                                     \
+    }                                                                                             \
+                                                                                                  \
+    static void name##_sift_down(Object** heap, usize size, usize root, const void* ctx) {        \
+        (void)ctx;                                                                                \
+        Object* item = heap[root];                                                                \
+        for (;;) {                                                                                \
+            usize child = 2 * root + 1;                                                           \
+            if (child >= size)                                                                    \
+                break;                                                                            \
+            if (child + 1 < size && LESS(heap[child], heap[child + 1]))                           \
+                child++;                                                                          \
+            if (!LESS(item, heap[child]))                                                         \
+                break;                                                                            \
+            heap[root] = heap[child];                                                             \
+            root = child;                                                                         \
+        }                                                                                         \
+        heap[root] = item;                                                                        \
+    }                                                                                             \
+                                                                                                  \
+    static void name##_heapsort(Object** begin, Object** end, const void* ctx) {                  \
+        usize size = (usize)(end - begin);                                                        \
+        for (usize i = size / 2; i-- > 0;)                                                        \
+            name##_sift_down(begin, size, i, ctx);                                                \
+        for (usize n = size; n-- > 1;) {                                                          \
+            _LIST_SWAP(begin, begin + n);                                                         \
+            name##_sift_down(begin, n, 0, ctx);                                                   \
+        }                                                                                         \
+    }                                                                                             \
+                                                                                                  \
+    /* Items equal to the pivot go right, returns the final pivot position */                     \
+    static Object** name##_partition_right(Object** begin, Object** end, bool* partitioned,       \
+                                           const void* ctx) {                                     \
+        (void)ctx;                                                                                \
+        Object* pivot = *begin;                                                                   \
+        Object** first = begin;                                                                   \
+        Object** last = end;                                                                      \
+        while (LESS(*++first, pivot))                                                             \
+            ;                                                                                     \
+        if (first - 1 == begin) {                                                                 \
+            while (first < last && !LESS(*--last, pivot))                                         \
+                ;                                                                                 \
+        } else {                                                                                  \
+            while (!LESS(*--last, pivot))                                                         \
+                ;                                                                                 \
+        }                                                                                         \
+        *partitioned = first >= last;                                                             \
+        while (first < last) {                                                                    \
+            _LIST_SWAP(first, last);                                                              \
+            while (LESS(*++first, pivot))                                                         \
+                ;                                                                                 \
+            while (!LESS(*--last, pivot))                                                         \
+                ;                                                                                 \
+        }                                                                                         \
+        Object** pivot_pos = first - 1;                                                           \
+        *begin = *pivot_pos;                                                                      \
+        *pivot_pos = pivot;                                                                       \
+        return pivot_pos;                                                                         \
+    }                                                                                             \
+                                                                                                  \
+    /* Items equal to the pivot go left, used when the pivot repeats the item before the range */ \
+    static Object** name##_partition_left(Object** begin, Object** end, const void* ctx) {        \
+        (void)ctx;                                                                                \
+        Object* pivot = *begin;                                                                   \
+        Object** first = begin;                                                                   \
+        Object** last = end;                                                                      \
+        while (LESS(pivot, *--last))                                                              \
+            ;                                                                                     \
+        if (last + 1 == end) {                                                                    \
+            while (first < last && !LESS(pivot, *++first))                                        \
+                ;                                                                                 \
+        } else {                                                                                  \
+            while (!LESS(pivot, *++first))                                                        \
+                ;                                                                                 \
+        }                                                                                         \
+        while (first < last) {                                                                    \
+            _LIST_SWAP(first, last);                                                              \
+            while (LESS(pivot, *--last))                                                          \
+                ;                                                                                 \
+            while (!LESS(pivot, *++first))                                                        \
+                ;                                                                                 \
+        }                                                                                         \
+        *begin = *last;                                                                           \
+        *last = pivot;                                                                            \
+        return last;                                                                              \
+    }                                                                                             \
+                                                                                                  \
+    /* Swaps a few items of an unbalanced side to break up patterns that fool the pivot choice */ \
+    static void name##_shuffle(Object** begin, Object** end) {                                    \
+        usize size = (usize)(end - begin);                                                        \
+        usize quarter = size / 4;                                                                 \
+        _LIST_SWAP(begin, begin + quarter);                                                       \
+        _LIST_SWAP(end - 1, end - quarter);                                                       \
+        if (size > _LIST_SORT_NINTHER) {                                                          \
+            _LIST_SWAP(begin + 1, begin + (quarter + 1));                                         \
+            _LIST_SWAP(begin + 2, begin + (quarter + 2));                                         \
+            _LIST_SWAP(end - 2, end - (quarter + 1));                                             \
+            _LIST_SWAP(end - 3, end - (quarter + 2));                                             \
+        }                                                                                         \
+    }                                                                                             \
+                                                                                                  \
+    static void name##_pdqsort(Object** begin, Object** end, i32 bad_allowed, bool leftmost,      \
+                               const void* ctx) {                                                 \
+        for (;;) {                                                                                \
+            usize size = (usize)(end - begin);                                                    \
+            if (size < _LIST_SORT_INSERTION) {                                                    \
+                if (leftmost)                                                                     \
+                    name##_insertion(begin, end, ctx);                                            \
+                else                                                                              \
+                    name##_unguarded_insertion(begin, end, ctx);                                  \
+                return;                                                                           \
+            }                                                                                     \
+                                                                                                  \
+            /* Median of 3, or the median of 3 medians (ninther) for larger ranges */             \
+            usize half = size / 2;                                                                \
+            if (size > _LIST_SORT_NINTHER) {                                                      \
+                name##_sort3(begin, begin + half, end - 1, ctx);                                  \
+                name##_sort3(begin + 1, begin + (half - 1), end - 2, ctx);                        \
+                name##_sort3(begin + 2, begin + (half + 1), end - 3, ctx);                        \
+                name##_sort3(begin + (half - 1), begin + half, begin + (half + 1), ctx);          \
+                _LIST_SWAP(begin, begin + half);                                                  \
+            } else {                                                                              \
+                name##_sort3(begin + half, begin, end - 1, ctx);                                  \
+            }                                                                                     \
+                                                                                                  \
+            /* A pivot equal to the item before this range is the smallest value here, so put all \
+               copies of it left in one linear pass and continue with the rest */                 \
+            if (!leftmost && !LESS(begin[-1], *begin)) {                                          \
+                begin = name##_partition_left(begin, end, ctx) + 1;                               \
+                continue;                                                                         \
+            }                                                                                     \
+                                                                                                  \
+            bool partitioned;                                                                     \
+            Object** pivot_pos = name##_partition_right(begin, end, &partitioned, ctx);           \
+            usize left_size = (usize)(pivot_pos - begin);                                         \
+            usize right_size = (usize)(end - (pivot_pos + 1));                                    \
+            if (left_size < size / 8 || right_size < size / 8) {                                  \
+                /* Too many bad pivots means hostile input, heapsort keeps it O(n log n) */       \
+                if (--bad_allowed == 0) {                                                         \
+                    name##_heapsort(begin, end, ctx);                                             \
+                    return;                                                                       \
+                }                                                                                 \
+                if (left_size >= _LIST_SORT_INSERTION)                                            \
+                    name##_shuffle(begin, pivot_pos);                                             \
+                if (right_size >= _LIST_SORT_INSERTION)                                           \
+                    name##_shuffle(pivot_pos + 1, end);                                           \
+            } else if (partitioned && name##_partial_insertion(begin, pivot_pos, ctx) &&          \
+                       name##_partial_insertion(pivot_pos + 1, end, ctx)) {                       \
+                return;                                                                           \
+            }                                                                                     \
+                                                                                                  \
+            name##_pdqsort(begin, pivot_pos, bad_allowed, leftmost, ctx);                         \
+            begin = pivot_pos + 1;                                                                \
+            leftmost = false;                                                                     \
+        }                                                                                         \
+    }                                                                                             \
+                                                                                                  \
+    static void name##_sort(Object** items, usize size, const void* ctx) {                        \
+        if (size < 2)                                                                             \
+            return;                                                                               \
+        i32 log2 = 0;                                                                             \
+        for (usize n = size; n > 1; n >>= 1)                                                      \
+            log2++;                                                                               \
+        name##_pdqsort(items, items + size, log2, true, ctx);                                     \
+    }                                                                                             \
+                                                                                                  \
+    /* Top-down merge sort, buffer holds size / 2 items */                                        \
+    static void name##_merge_sort(Object** items, usize size, Object** buffer, const void* ctx) { \
+        if (size < _LIST_SORT_INSERTION) {                                                        \
+            name##_insertion(items, items + size, ctx);                                           \
+            return;                                                                               \
+        }                                                                                         \
+        usize half = size / 2;                                                                    \
+        name##_merge_sort(items, half, buffer, ctx);                                              \
+        name##_merge_sort(items + half, size - half, buffer, ctx);                                \
+        if (!LESS(items[half], items[half - 1]))                                                  \
+            return;                                                                               \
+        memcpy(buffer, items, sizeof(Object*) * half);                                            \
+        usize i = 0, j = half, k = 0;                                                             \
+        while (i < half && j < size) {                                                            \
+            if (LESS(items[j], buffer[i]))                                                        \
+                items[k++] = items[j++];                                                          \
+            else                                                                                  \
+                items[k++] = buffer[i++];                                                         \
+        }                                                                                         \
+        while (i < half)                                                                          \
+            items[k++] = buffer[i++];                                                             \
+    }                                                                                             \
+                                                                                                  \
+    static void name##_sort_stable(Object** items, usize size, const void* ctx) {                 \
+        if (size < 2)                                                                             \
+            return;                                                                               \
+        Object** buffer = malloc(sizeof(Object*) * (size / 2));                                   \
+        name##_merge_sort(items, size, buffer, ctx);                                              \
+        free(buffer);                                                                             \
+    }
+
+// Index of the first item equal to item, or -(insertion point) - 1
+#define _LIST_DEFINE_SEARCH(name, LESS)                                                           \
+    static isize name##_search(Object** items, usize size, Object* item, const void* ctx) {       \
+        (void)ctx;                                                                                \
+        usize low = 0, high = size;                                                               \
+        while (low < high) {                                                                      \
+            usize middle = low + (high - low) / 2;                                                \
+            if (LESS(items[middle], item))                                                        \
+                low = middle + 1;                                                                 \
+            else                                                                                  \
+                high = middle;                                                                    \
+        }                                                                                         \
+        if (low < size && !LESS(item, items[low]))                                                \
+            return (isize)low;                                                                    \
+        return -(isize)low - 1;                                                                   \
+    }
+
+// NaN sorts last, the same order as Float::compare()
+static inline bool list_float_less(f64 a, f64 b) {
+    return a < b || (isnan(b) && !isnan(a));
+}
+
+static inline i32 list_string_compare(String* a, String* b) {
+    i32 result = memcmp(a->cstr, b->cstr, MIN(a->length, b->length));
+    if (result != 0)
+        return result;
+    return (a->length > b->length) - (a->length < b->length);
+}
+
+// Mixed lists still compare two boxed values of the same type without dispatch
+static i32 list_compare_any(Object* a, Object* b) {
+    if (a->vtbl == b->vtbl) {
+        if (a->vtbl == (void*)&_IntVtbl)
+            return (((Int*)a)->value > ((Int*)b)->value) - (((Int*)a)->value < ((Int*)b)->value);
+        if (a->vtbl == (void*)&_StringVtbl)
+            return list_string_compare((String*)a, (String*)b);
+        if (a->vtbl == (void*)&_FloatVtbl)
+            return _float_compare((Float*)a, b);
+    }
+    return i_comparable_compare(cast<IComparable>(a), b);
+}
+
+#define _LIST_LESS_INT(a, b) (((Int*)(a))->value < ((Int*)(b))->value)
+#define _LIST_LESS_FLOAT(a, b) list_float_less(((Float*)(a))->value, ((Float*)(b))->value)
+#define _LIST_LESS_STRING(a, b) (list_string_compare((String*)(a), (String*)(b)) < 0)
+#define _LIST_LESS_VTBL(a, b) (((const IComparableVtbl*)ctx)->compare((a), (b)) < 0)
+#define _LIST_LESS_ANY(a, b) (list_compare_any((a), (b)) < 0)
+#define _LIST_LESS_FN(a, b) ((*(ListCompareFn* const*)ctx)((a), (b)) < 0)
+
+_LIST_DEFINE_SORT(list_int, _LIST_LESS_INT)
+_LIST_DEFINE_SORT(list_float, _LIST_LESS_FLOAT)
+_LIST_DEFINE_SORT(list_string, _LIST_LESS_STRING)
+_LIST_DEFINE_SORT(list_vtbl, _LIST_LESS_VTBL)
+_LIST_DEFINE_SORT(list_any, _LIST_LESS_ANY)
+_LIST_DEFINE_SORT(list_fn, _LIST_LESS_FN)
+_LIST_DEFINE_SEARCH(list_any, _LIST_LESS_ANY)
+_LIST_DEFINE_SEARCH(list_fn, _LIST_LESS_FN)
+
+typedef enum _ListSortKind {
+    _LIST_SORT_INT,
+    _LIST_SORT_FLOAT,
+    _LIST_SORT_STRING,
+    _LIST_SORT_VTBL,
+    _LIST_SORT_ANY,
+} _ListSortKind;
+
+// One scan picks the comparison: raw values when every item is the same boxed type, the
+// IComparable vtbl looked up once when every item has the same class
+static _ListSortKind list_sort_kind(List* list, const void** ctx) {
+    const void* vtbl = list->items[0]->vtbl;
+    for (usize i = 1; i < list->size; i++) {
+        if (list->items[i]->vtbl != vtbl)
+            return _LIST_SORT_ANY;
+    }
+    if (vtbl == &_IntVtbl)
+        return _LIST_SORT_INT;
+    if (vtbl == &_FloatVtbl)
+        return _LIST_SORT_FLOAT;
+    if (vtbl == &_StringVtbl)
+        return _LIST_SORT_STRING;
+    *ctx = cast<IComparable>(list->items[0]).vtbl;
+    return _LIST_SORT_VTBL;
+}
+
+void List::sort() {
+    if (this->size < 2)
+        return;
+    const void* ctx = NULL;
+    switch (list_sort_kind(this, &ctx)) {
+        case _LIST_SORT_INT:
+            list_int_sort(this->items, this->size, NULL);
+            break;
+        case _LIST_SORT_FLOAT:
+            list_float_sort(this->items, this->size, NULL);
+            break;
+        case _LIST_SORT_STRING:
+            list_string_sort(this->items, this->size, NULL);
+            break;
+        case _LIST_SORT_VTBL:
+            list_vtbl_sort(this->items, this->size, ctx);
+            break;
+        case _LIST_SORT_ANY:
+            list_any_sort(this->items, this->size, NULL);
+            break;
+    }
+}
+
+void List::sort_by(ListCompareFn* fn) {
+    list_fn_sort(this->items, this->size, &fn);
+}
+
+void List::sort_stable() {
+    if (this->size < 2)
+        return;
+    const void* ctx = NULL;
+    switch (list_sort_kind(this, &ctx)) {
+        case _LIST_SORT_INT:
+            list_int_sort_stable(this->items, this->size, NULL);
+            break;
+        case _LIST_SORT_FLOAT:
+            list_float_sort_stable(this->items, this->size, NULL);
+            break;
+        case _LIST_SORT_STRING:
+            list_string_sort_stable(this->items, this->size, NULL);
+            break;
+        case _LIST_SORT_VTBL:
+            list_vtbl_sort_stable(this->items, this->size, ctx);
+            break;
+        case _LIST_SORT_ANY:
+            list_any_sort_stable(this->items, this->size, NULL);
+            break;
+    }
+}
+
+void List::sort_stable_by(ListCompareFn* fn) {
+    list_fn_sort_stable(this->items, this->size, &fn);
+}
+
+isize List::binary_search(Object* item) {
+    // Scanning for one comparison kind would cost more than the search itself
+    return list_any_search(this->items, this->size, item, NULL);
+}
+
+isize List::binary_search_by(Object* item, ListCompareFn* fn) {
+    return list_fn_search(this->items, this->size, item, &fn);
 }
 
 IIterator List::iterator() {
@@ -8,18 +8,34 @@
 
 #include "Object.hh"
 
+typedef i32 ListCompareFn(Object* a, Object* b);
+
 class List : IIterable {
     Object** items;
     @get usize capacity = 8;
     @get usize size = 0;
 
     void init();
+    void init_with_capacity(usize capacity);
     virtual void deinit();
+    virtual Self* promote();
     Object* get(usize index);
     void set(usize index, Object* item);
     void add(Object* item);
     void insert(usize index, Object* item);
     void remove(usize index);
+    void add_all(List* other);
+    void extend(IIterable iterable);
+    void remove_range(usize start, usize length);
+    void truncate(usize size);
+    void reserve(usize capacity);
+    void shrink_to_fit();
+    void sort();
+    void sort_by(ListCompareFn* fn);
+    void sort_stable();
+    void sort_stable_by(ListCompareFn* fn);
+    isize binary_search(Object* item);
+    isize binary_search_by(Object* item, ListCompareFn* fn);
     virtual IIterator iterator();
 };
 
@@ -6,10 +6,107 @@
 
 #include <Map.hh>
 
+// Number of old table slots migrated by every operation during an incremental resize,
+// enough to finish before the new table reaches its own growth threshold
+#define MAP_REHASH_STEP 16
+
+// Marks old table slots that have already been migrated, keeps their probe chains intact
+static u8 map_moved_sentinel;
+#define MAP_MOVED ((void*)&map_moved_sentinel)
+
+static usize map_find_slot(IKeyable* keys, u32* hashes, usize capacity, IKeyable key, u32 hash) {
+    usize mask = capacity - 1;
+    usize index = hash & mask;
+    while (keys[index].obj) {
+        if (keys[index].obj != MAP_MOVED && hashes[index] == hash &&
+            i_keyable_equals(keys[index], (Object*)key.obj))
+            return index;
+        index = (index + 1) & mask;
+    }
+    return SIZE_MAX;
+}
+
+static void map_insert_slot(Map* map, IKeyable key, u32 hash, Object* value) {
+    usize mask = map->capacity - 1;
+    usize index = hash & mask;
+    while (map->keys[index].obj)
+        index = (index + 1) & mask;
+    map->keys[index] = key;
+    map->hashes[index] = hash;
+    map->values[index] = value;
+}
+
+static void map_free_old(Map* map) {
+    if (!_object_in_arena(map)) {
+        free(map->old_keys);
+        free(map->old_hashes);
+        free(map->old_values);
+    }
+    map->old_keys = NULL;
+    map->old_hashes = NULL;
+    map->old_values = NULL;
+    map->old_capacity = 0;
+}
+
+static void map_rehash_step(Map* map, usize steps) {
+    usize end = map->rehash_index + steps;
+    if (end > map->old_capacity)
+        end = map->old_capacity;
+    for (; map->rehash_index < end; map->rehash_index++) {
+        usize i = map->rehash_index;
+        if (map->old_keys[i].obj != NULL && map->old_keys[i].obj != MAP_MOVED) {
+            map_insert_slot(map, map->old_keys[i], map->old_hashes[i], map->old_values[i]);
+            map->old_keys[i].obj = MAP_MOVED;
+        }
+    }
+    if (map->rehash_index == map->old_capacity)
+        map_free_old(map);
+}
+
+static void map_alloc_slots(Map* map) {
+    map->keys = _object_buffer_calloc(map, map->capacity, sizeof(IKeyable));
+    map->hashes = _object_buffer_alloc(map, map->capacity * sizeof(u32));
+    map->values = _object_buffer_calloc(map, map->capacity, sizeof(Object*));
+}
+
+static void map_resize(Map* map, usize capacity, bool incremental) {
+    // Finish a running migration first so there is only ever one old table
+    if (map->old_keys != NULL)
+        map_rehash_step(map, map->old_capacity);
+
+    IKeyable* old_keys = map->keys;
+    u32* old_hashes = map->hashes;
+    Object** old_values = map->values;
+    usize old_capacity = map->capacity;
+    map->capacity = capacity;
+    map_alloc_slots(map);
+
+    map->old_keys = old_keys;
+    map->old_hashes = old_hashes;
+    map->old_values = old_values;
+    map->old_capacity = old_capacity;
+    map->rehash_index = 0;
+    if (!incremental) {
+        // Reinsert everything now using the stored hashes, no calls back into the keys
+        map_rehash_step(map, old_capacity);
+    }
+}
+
 void Map::init() {
     Object::init();
-    this->keys = calloc(this->capacity, sizeof(IKeyable));
-    this->values = calloc(this->capacity, sizeof(Object*));
+    map_alloc_slots(this);
+}
+
+void Map::init_with_capacity(usize capacity) {
+    Object::init();
+    this->capacity = _linear_probe_capacity(capacity);
+    map_alloc_slots(this);
+}
+
+void Map::init_incremental() {
+    Object::init();
+    this->incremental = true;
+    map_alloc_slots(this);
 }
 
 void Map::deinit() {
@@ -20,90 +117,188 @@ void Map::deinit() {
                 object_free(this->values[i]);
         }
     }
-    free(this->keys);
-    free(this->values);
+    for (usize i = this->rehash_index; i < this->old_capacity; i++) {
+        if (this->old_keys[i].obj != NULL && this->old_keys[i].obj != MAP_MOVED) {
+            object_free((Object*)this->old_keys[i].obj);
+            if (this->old_values[i] != NULL)
+                object_free(this->old_values[i]);
+        }
+    }
+    if (this->old_keys != NULL)
+        map_free_old(this);
+    _object_buffer_free(this, this->keys);
+    _object_buffer_free(this, this->hashes);
+    _object_buffer_free(this, this->values);
     Object::deinit();
 }
 
-Object* Map::get(IKeyable key) {
-    u32 hash = i_keyable_hash(key);
-    usize index = hash & (this->capacity - 1);
-    while (this->keys[index].obj) {
-        if (i_keyable_equals(this->keys[index], (Object*)key.obj))
-            return this->values[index];
-        index = (index + 1) & (this->capacity - 1);
+Self* Map::promote() {
+    if (!_object_in_arena(this))
+        return (Map*)object_ref(this);
+    if (this->old_keys != NULL)
+        map_rehash_step(this, this->old_capacity);
+    Map* copy = (Map*)Object::promote();
+    copy->keys = calloc(copy->capacity, sizeof(IKeyable));
+    copy->hashes = malloc(copy->capacity * sizeof(u32));
+    memcpy(copy->hashes, this->hashes, copy->capacity * sizeof(u32));
+    copy->values = calloc(copy->capacity, sizeof(Object*));
+    for (usize i = 0; i < copy->capacity; i++) {
+        if (this->keys[i].obj != NULL) {
+            copy->keys[i].obj = object_promote((Object*)this->keys[i].obj);
+            copy->keys[i].vtbl = this->keys[i].vtbl;
+            copy->values[i] = this->values[i] != NULL ? object_promote(this->values[i]) : NULL;
+        }
     }
-    return NULL;
+    return copy;
 }
 
-void Map::set(IKeyable key, Object* value) {
-    if (this->filled >= this->capacity * 3 / 4) {
-        usize old_capacity = this->capacity;
-        this->capacity <<= 1;
-        IKeyable* new_keys = calloc(this->capacity, sizeof(IKeyable));
-        Object** new_values = calloc(this->capacity, sizeof(Object*));
-        for (usize i = 0; i < old_capacity; i++) {
-            if (this->keys[i].obj) {
-                u32 hash = i_keyable_hash(this->keys[i]);
-                usize index = hash & (this->capacity - 1);
-                while (new_keys[index].obj)
-                    index = (index + 1) & (this->capacity - 1);
-                new_keys[index] = this->keys[i];
-                new_values[index] = this->values[i];
-            }
-        }
-        free(this->keys);
-        free(this->values);
-        this->keys = new_keys;
-        this->values = new_values;
+bool Map::is_rehashing() {
+    return this->old_keys != NULL;
+}
+
+Object* Map::get(IKeyable key) {
+    u32 hash = i_keyable_hash(key);
+    if (this->old_keys != NULL)
+        map_rehash_step(this, MAP_REHASH_STEP);
+    if (this->old_keys != NULL) {
+        usize index = map_find_slot(this->old_keys, this->old_hashes, this->old_capacity, key, hash);
+        if (index != SIZE_MAX)
+            return this->old_values[index];
     }
+    usize index = map_find_slot(this->keys, this->hashes, this->capacity, key, hash);
+    return index != SIZE_MAX ? this->values[index] : NULL;
+}
 
+// With adopt the map takes over the caller's key reference, which is dropped when the key is
+// already present
+static void map_put(Map* map, IKeyable key, Object* value, bool adopt) {
     u32 hash = i_keyable_hash(key);
-    usize index = hash & (this->capacity - 1);
-    while (this->keys[index].obj) {
-        if (i_keyable_equals(this->keys[index], (Object*)key.obj)) {
-            object_free(this->values[index]);
-            this->values[index] = value;
+    if (map->old_keys != NULL)
+        map_rehash_step(map, MAP_REHASH_STEP);
+    if (map->old_keys != NULL) {
+        // Keys still in the old table are updated in place and migrate later
+        usize index = map_find_slot(map->old_keys, map->old_hashes, map->old_capacity, key, hash);
+        if (index != SIZE_MAX) {
+            object_free(map->old_values[index]);
+            map->old_values[index] = value;
+            if (adopt)
+                object_free((Object*)key.obj);
             return;
         }
-        index = (index + 1) & (this->capacity - 1);
     }
-    object_ref((Object*)key.obj);
-    this->keys[index] = key;
-    this->values[index] = value;
-    this->filled++;
+
+    usize index = map_find_slot(map->keys, map->hashes, map->capacity, key, hash);
+    if (index != SIZE_MAX) {
+        object_free(map->values[index]);
+        map->values[index] = value;
+        if (adopt)
+            object_free((Object*)key.obj);
+        return;
+    }
+    if (map->filled >= map->capacity * 3 / 4)
+        map_resize(map, map->capacity << 1, map->incremental);
+    if (!adopt)
+        object_ref((Object*)key.obj);
+    map_insert_slot(map, key, hash, value);
+    map->filled++;
+}
+
+void Map::set(IKeyable key, Object* value) {
+    map_put(this, key, value, false);
+}
+
+void Map::set_move(IKeyable key, Object* value) {
+    map_put(this, key, value, true);
 }
 
 void Map::remove(IKeyable key) {
     u32 hash = i_keyable_hash(key);
-    usize index = hash & (this->capacity - 1);
-    while (this->keys[index].obj) {
-        if (i_keyable_equals(this->keys[index], (Object*)key.obj)) {
-            object_free((Object*)this->keys[index].obj);
-            object_free(this->values[index]);
-            this->keys[index].obj = NULL;
-            this->values[index] = NULL;
+    if (this->old_keys != NULL)
+        map_rehash_step(this, MAP_REHASH_STEP);
+    if (this->old_keys != NULL) {
+        // Removed old table slots become moved markers so later probe chains stay intact
+        usize index = map_find_slot(this->old_keys, this->old_hashes, this->old_capacity, key, hash);
+        if (index != SIZE_MAX) {
+            object_free((Object*)this->old_keys[index].obj);
+            if (this->old_values[index] != NULL)
+                object_free(this->old_values[index]);
+            this->old_keys[index].obj = MAP_MOVED;
             this->filled--;
-
-            // Re-insert displaced entries to maintain linear probe invariant
-            usize next = (index + 1) & (this->capacity - 1);
-            while (this->keys[next].obj) {
-                IKeyable moved_k = this->keys[next];
-                Object* moved_v = this->values[next];
-                this->keys[next].obj = NULL;
-                this->values[next] = NULL;
-                this->filled--;
-                u32 moved_h = i_keyable_hash(moved_k);
-                usize new_idx = moved_h & (this->capacity - 1);
-                while (this->keys[new_idx].obj)
-                    new_idx = (new_idx + 1) & (this->capacity - 1);
-                this->keys[new_idx] = moved_k;
-                this->values[new_idx] = moved_v;
-                this->filled++;
-                next = (next + 1) & (this->capacity - 1);
-            }
             return;
         }
-        index = (index + 1) & (this->capacity - 1);
     }
+
+    usize index = map_find_slot(this->keys, this->hashes, this->capacity, key, hash);
+    if (index != SIZE_MAX) {
+        object_free((Object*)this->keys[index].obj);
+        if (this->values[index] != NULL)
+            object_free(this->values[index]);
+        _linear_probe_remove((_FatPointer*)this->keys, this->hashes, (void**)this->values, this->capacity,
+                             index);
+        this->filled--;
+    }
+}
+
+void Map::reserve(usize capacity) {
+    usize new_capacity = _linear_probe_capacity(capacity);
+    if (new_capacity > this->capacity)
+        map_resize(this, new_capacity, false);
+}
+
+void Map::shrink_to_fit() {
+    // Arena buffers are only released with their arena
+    usize new_capacity = _linear_probe_capacity(this->filled);
+    if (!_object_in_arena(this) && new_capacity < this->capacity)
+        map_resize(this, new_capacity, false);
+}
+
+void Map::foreach(MapForeachFn* fn, void* context) {
+    for (usize i = map_first_slot(this); i != SIZE_MAX; i = map_next_slot(this, i + 1))
+        fn((Object*)this->keys[i].obj, this->values[i], context);
+}
+
+MapKeys* Map::keys() {
+    return map_keys_new(this);
+}
+
+MapValues* Map::values() {
+    return map_values_new(this);
+}
+
+IIterator Map::iterator() {
+    return cast<IIterator>(map_iterator_new(this, false));
+}
+
+usize Map::first_slot() {
+    if (this->old_keys != NULL)
+        map_rehash_step(this, this->old_capacity);
+    return map_next_slot(this, 0);
+}
+
+// MapKeys
+IIterator MapKeys::iterator() {
+    return cast<IIterator>(map_iterator_new(this->map, false));
+}
+
+// MapValues
+IIterator MapValues::iterator() {
+    return cast<IIterator>(map_iterator_new(this->map, true));
+}
+
+// MapIterator
+void MapIterator::init(Map* map, bool values) {
+    Object::init();
+    this->map = map;
+    this->values = values;
+    this->slot = map_first_slot(map);
+}
+
+bool MapIterator::has_next() {
+    return this->slot != SIZE_MAX;
+}
+
+Object* MapIterator::next() {
+    usize slot = this->slot;
+    this->slot = map_next_slot(this->map, slot + 1);
+    return this->values ? this->map->values[slot] : (Object*)this->map->keys[slot].obj;
 }
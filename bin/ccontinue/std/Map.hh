@@ -8,15 +8,98 @@
 
 #include "Object.hh"
 
-class Map {
+typedef void MapForeachFn(Object* key, Object* value, void* context);
+
+typedef struct MapKeys MapKeys;
+typedef struct MapValues MapValues;
+
+class Map : IIterable {
     IKeyable* keys;
+    u32* hashes;
     Object** values;
     @get usize capacity = 8;
     @get usize filled = 0;
 
+    // Incremental resize: the old table is migrated a few slots per operation
+    @get bool incremental = false;
+    IKeyable* old_keys = NULL;
+    u32* old_hashes = NULL;
+    Object** old_values = NULL;
+    usize old_capacity = 0;
+    usize rehash_index = 0;
+
     void init();
+    void init_with_capacity(usize capacity);
+    void init_incremental();
     virtual void deinit();
+    virtual Self* promote();
+    bool is_rehashing();
     Object* get(IKeyable key);
     void set(IKeyable key, Object* value);
+    void set_move(IKeyable key, Object* value);
     void remove(IKeyable key);
+    void reserve(usize capacity);
+    void shrink_to_fit();
+    void foreach(MapForeachFn* fn, void* context);
+    MapKeys* keys();
+    MapValues* values();
+    virtual IIterator iterator();
+
+    // Slot cursor behind for-in, nothing may be added or removed while it is used. first_slot()
+    // finishes a running incremental resize, so lookups in the loop body don't move entries
+    usize first_slot();
+    inline usize next_slot(usize slot) {
+        for (; slot < this->capacity; slot++) {
+            if (this->keys[slot].obj != NULL)
+                return slot;
+        }
+        return SIZE_MAX;
+    }
+    inline Object* slot_item(usize slot) {
+        return (Object*)this->keys[slot].obj;
+    }
+    inline Object* slot_value(usize slot) {
+        return this->values[slot];
+    }
+};
+
+// Views over the keys or values of a map, they keep the map alive but copy nothing
+class MapKeys : IIterable {
+    @get @init(map_ref) @deinit(map_free) Map* map;
+
+    virtual IIterator iterator();
+    inline usize first_slot() {
+        return map_first_slot(this->map);
+    }
+    inline usize next_slot(usize slot) {
+        return map_next_slot(this->map, slot);
+    }
+    inline Object* slot_item(usize slot) {
+        return map_slot_item(this->map, slot);
+    }
+};
+
+class MapValues : IIterable {
+    @get @init(map_ref) @deinit(map_free) Map* map;
+
+    virtual IIterator iterator();
+    inline usize first_slot() {
+        return map_first_slot(this->map);
+    }
+    inline usize next_slot(usize slot) {
+        return map_next_slot(this->map, slot);
+    }
+    inline Object* slot_item(usize slot) {
+        return map_slot_value(this->map, slot);
+    }
+};
+
+class MapIterator : IIterator {
+    Map* map;
+    bool values;
+    usize slot;
+
+    void init(Map* map, bool values);
+    virtual bool has_next();
+    virtual Object* next();
 };
@@ -4,22 +4,48 @@
  * SPDX-License-Identifier: MIT
  */
 
+#include <math.h>
+
 #include "Object.hh"
 
 // Object
-void Object::init() {}
+void Object::init() {
+    (void)this;
+}
 
 void Object::deinit() {
-    free(this);
+    _object_dealloc(this);
+}
+
+Self* Object::promote() {
+    if (!_object_in_arena(this))
+        return object_ref(this);
+    Object* copy = _object_alloc_heap(this->vtbl);
+    memcpy(copy, this, this->vtbl->size);
+    atomic_init(&copy->refs, 1);
+    return copy;
 }
 
+// Only @shared objects pay for locked read-modify-writes, the acquire-release decrement makes
+// every other thread's writes visible before the last owner deinits
 Self* Object::ref() {
-    this->refs++;
+    if (this->vtbl->shared)
+        atomic_fetch_add_explicit(&this->refs, 1, memory_order_relaxed);
+    else
+        atomic_store_explicit(&this->refs, atomic_load_explicit(&this->refs, memory_order_relaxed) + 1,
+                              memory_order_relaxed);
     return this;
 }
 
 void Object::free() {
-    if (--this->refs <= 0)
+    if (this->vtbl->shared) {
+        if (atomic_fetch_sub_explicit(&this->refs, 1, memory_order_acq_rel) == 1)
+            object_deinit(this);
+        return;
+    }
+    usize refs = atomic_load_explicit(&this->refs, memory_order_relaxed) - 1;
+    atomic_store_explicit(&this->refs, refs, memory_order_relaxed);
+    if (refs == 0)
         object_deinit(this);
 }
 
@@ -31,7 +57,7 @@ bool Bool::equals(Object* other) {
 }
 
 u32 Bool::hash() {
-    return this->value ? 1 : 0;
+    return hash_u64(this->value ? 1 : 0);
 }
 
 // Int
@@ -42,7 +68,12 @@ bool Int::equals(Object* other) {
 }
 
 u32 Int::hash() {
-    return fnv1a_32(&this->value, sizeof(this->value));
+    return hash_u64((u64)this->value);
+}
+
+i32 Int::compare(Object* other) {
+    i64 value = ((Int*)other)->value;
+    return (this->value > value) - (this->value < value);
 }
 
 // Float
@@ -53,5 +84,19 @@ bool Float::equals(Object* other) {
 }
 
 u32 Float::hash() {
-    return fnv1a_32(&this->value, sizeof(this->value));
+    // -0.0 equals 0.0, so both must hash the same
+    f64 value = this->value == 0.0 ? 0.0 : this->value;
+    u64 bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return hash_u64(bits);
+}
+
+i32 Float::compare(Object* other) {
+    // NaN sorts after every number so sorting stays a total order
+    f64 value = ((Float*)other)->value;
+    if (isnan(this->value))
+        return isnan(value) ? 0 : 1;
+    if (isnan(value))
+        return -1;
+    return (this->value > value) - (this->value < value);
 }
@@ -10,10 +10,11 @@
 
 // Object
 class Object {
-    usize refs = 1;
+    _Atomic usize refs; // Set by _object_alloc()
 
     void init();
     virtual void deinit();
+    virtual Self* promote();
     Self* ref();
     void free();
 };
@@ -29,6 +30,11 @@ class IHashable {
 
 class IKeyable : IEquatable, IHashable {};
 
+// Total order: compare() returns < 0, 0 or > 0 when this sorts before, with or after other
+class IComparable : IEquatable {
+    i32 compare(Object* other);
+};
+
 class IIterator {
     bool has_next();
     Object* next();
@@ -46,16 +52,18 @@ class Bool : IEquatable, IHashable {
     virtual u32 hash();
 };
 
-class Int : IEquatable, IHashable {
+class Int : IComparable, IHashable {
     @get @init i64 value;
 
     virtual bool equals(Object* other);
     virtual u32 hash();
+    virtual i32 compare(Object* other);
 };
 
-class Float : IEquatable, IHashable {
+class Float : IComparable, IHashable {
     @get @init f64 value;
 
     virtual bool equals(Object* other);
     virtual u32 hash();
+    virtual i32 compare(Object* other);
 };
@@ -0,0 +1,141 @@
+/*
+ * Copyright (c) 2026 Bastiaan van der Plaat
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <PriorityQueue.hh>
+
+// A wider heap is shallower, and the 4 children of a node share a cache line
+#define _HEAP_ARITY 4
+
+// Two Ints compare without dispatch
+static inline bool heap_less(PriorityQueue* queue, Object* a, Object* b) {
+    if (queue->compare != NULL)
+        return queue->compare(a, b) < 0;
+    if (a->vtbl == (void*)&_IntVtbl && b->vtbl == (void*)&_IntVtbl)
+        return ((Int*)a)->value < ((Int*)b)->value;
+    return i_comparable_compare(cast<IComparable>(a), b) < 0;
+}
+
+static void heap_sift_up(PriorityQueue* queue, usize index) {
+    Object* item = queue->items[index];
+    while (index > 0) {
+        usize parent = (index - 1) / _HEAP_ARITY;
+        if (!heap_less(queue, item, queue->items[parent]))
+            break;
+        queue->items[index] = queue->items[parent];
+        index = parent;
+    }
+    queue->items[index] = item;
+}
+
+static void heap_sift_down(PriorityQueue* queue, usize index) {
+    Object* item = queue->items[index];
+    for (;;) {
+        usize first = index * _HEAP_ARITY + 1;
+        if (first >= queue->size)
+            break;
+        usize end = MIN(first + _HEAP_ARITY, queue->size);
+        usize smallest = first;
+        for (usize child = first + 1; child < end; child++) {
+            if (heap_less(queue, queue->items[child], queue->items[smallest]))
+                smallest = child;
+        }
+        if (!heap_less(queue, queue->items[smallest], item))
+            break;
+        queue->items[index] = queue->items[smallest];
+        index = smallest;
+    }
+    queue->items[index] = item;
+}
+
+static void heap_grow(PriorityQueue* queue, usize capacity) {
+    if (capacity <= queue->capacity)
+        return;
+    usize old_capacity = queue->capacity;
+    while (queue->capacity < capacity)
+        queue->capacity <<= 1;
+    queue->items = _object_buffer_realloc(queue, queue->items, sizeof(Object*) * old_capacity,
+                                          sizeof(Object*) * queue->capacity);
+}
+
+// PriorityQueue
+void PriorityQueue::init() {
+    Object::init();
+    this->items = _object_buffer_alloc(this, sizeof(Object*) * this->capacity);
+}
+
+void PriorityQueue::init_with_capacity(usize capacity) {
+    Object::init();
+    this->capacity = capacity > 0 ? capacity : 1;
+    this->items = _object_buffer_alloc(this, sizeof(Object*) * this->capacity);
+}
+
+void PriorityQueue::init_by(PriorityQueueCompareFn* compare) {
+    Object::init();
+    this->compare = compare;
+    this->items = _object_buffer_alloc(this, sizeof(Object*) * this->capacity);
+}
+
+void PriorityQueue::deinit() {
+    priority_queue_clear(this);
+    _object_buffer_free(this, this->items);
+    Object::deinit();
+}
+
+Self* PriorityQueue::promote() {
+    if (!_object_in_arena(this))
+        return (PriorityQueue*)object_ref(this);
+    PriorityQueue* copy = (PriorityQueue*)Object::promote();
+    copy->items = malloc(sizeof(Object*) * copy->capacity);
+    for (usize i = 0; i < copy->size; i++)
+        copy->items[i] = object_promote(this->items[i]);
+    return copy;
+}
+
+Object* PriorityQueue::peek() {
+    return this->size > 0 ? this->items[0] : NULL;
+}
+
+void PriorityQueue::push(Object* item) {
+    heap_grow(this, this->size + 1);
+    this->items[this->size++] = item;
+    heap_sift_up(this, this->size - 1);
+}
+
+Object* PriorityQueue::pop() {
+    // The queue's reference moves to the caller
+    if (this->size == 0)
+        return NULL;
+    Object* top = this->items[0];
+    this->size--;
+    if (this->size > 0) {
+        this->items[0] = this->items[this->size];
+        heap_sift_down(this, 0);
+    }
+    return top;
+}
+
+void PriorityQueue::clear() {
+    for (usize i = 0; i < this->size; i++)
+        object_free(this->items[i]);
+    this->size = 0;
+}
+
+void PriorityQueue::reserve(usize capacity) {
+    if (capacity > this->capacity) {
+        this->items = _object_buffer_realloc(this, this->items, sizeof(Object*) * this->capacity,
+                                             sizeof(Object*) * capacity);
+        this->capacity = capacity;
+    }
+}
+
+void PriorityQueue::shrink_to_fit() {
+    // Arena buffers are only released with their arena
+    usize capacity = this->size > 0 ? this->size : 1;
+    if (_object_in_arena(this) || capacity == this->capacity)
+        return;
+    this->items = realloc(this->items, sizeof(Object*) * capacity);
+    this->capacity = capacity;
+}
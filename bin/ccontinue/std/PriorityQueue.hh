@@ -0,0 +1,32 @@
+/*
+ * Copyright (c) 2026 Bastiaan van der Plaat
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include "Object.hh"
+
+typedef i32 PriorityQueueCompareFn(Object* a, Object* b);
+
+// Min-heap of items in one contiguous array, each node has 4 children. Items are ordered by
+// compare, or by IComparable when it's NULL
+class PriorityQueue {
+    Object** items;
+    PriorityQueueCompareFn* compare = NULL;
+    @get usize capacity = 8;
+    @get usize size = 0;
+
+    void init();
+    void init_with_capacity(usize capacity);
+    void init_by(PriorityQueueCompareFn* compare);
+    virtual void deinit();
+    virtual Self* promote();
+    Object* peek();
+    void push(Object* item);
+    Object* pop();
+    void clear();
+    void reserve(usize capacity);
+    void shrink_to_fit();
+};
@@ -6,9 +6,40 @@
 
 #include <Set.hh>
 
+static void set_resize(Set* set, usize capacity) {
+    // Reinsert using the stored hashes, no calls back into the keys
+    IKeyable* old_keys = set->keys;
+    u32* old_hashes = set->hashes;
+    usize old_capacity = set->capacity;
+    set->capacity = capacity;
+    set->keys = _object_buffer_calloc(set, set->capacity, sizeof(IKeyable));
+    set->hashes = _object_buffer_alloc(set, set->capacity * sizeof(u32));
+    for (usize i = 0; i < old_capacity; i++) {
+        if (old_keys[i].obj) {
+            usize index = old_hashes[i] & (set->capacity - 1);
+            while (set->keys[index].obj)
+                index = (index + 1) & (set->capacity - 1);
+            set->keys[index] = old_keys[i];
+            set->hashes[index] = old_hashes[i];
+        }
+    }
+    if (!_object_in_arena(set)) {
+        free(old_keys);
+        free(old_hashes);
+    }
+}
+
 void Set::init() {
     Object::init();
-    this->keys = calloc(this->capacity, sizeof(IKeyable));
+    this->keys = _object_buffer_calloc(this, this->capacity, sizeof(IKeyable));
+    this->hashes = _object_buffer_alloc(this, this->capacity * sizeof(u32));
+}
+
+void Set::init_with_capacity(usize capacity) {
+    Object::init();
+    this->capacity = _linear_probe_capacity(capacity);
+    this->keys = _object_buffer_calloc(this, this->capacity, sizeof(IKeyable));
+    this->hashes = _object_buffer_alloc(this, this->capacity * sizeof(u32));
 }
 
 void Set::deinit() {
@@ -16,61 +47,118 @@ void Set::deinit() {
         if (this->keys[i].obj != NULL)
             object_free((Object*)this->keys[i].obj);
     }
-    free(this->keys);
+    _object_buffer_free(this, this->keys);
+    _object_buffer_free(this, this->hashes);
     Object::deinit();
 }
 
+Self* Set::promote() {
+    if (!_object_in_arena(this))
+        return (Set*)object_ref(this);
+    Set* copy = (Set*)Object::promote();
+    copy->keys = calloc(copy->capacity, sizeof(IKeyable));
+    copy->hashes = malloc(copy->capacity * sizeof(u32));
+    memcpy(copy->hashes, this->hashes, copy->capacity * sizeof(u32));
+    for (usize i = 0; i < copy->capacity; i++) {
+        if (this->keys[i].obj != NULL) {
+            copy->keys[i].obj = object_promote((Object*)this->keys[i].obj);
+            copy->keys[i].vtbl = this->keys[i].vtbl;
+        }
+    }
+    return copy;
+}
+
 bool Set::contains(IKeyable key) {
     u32 hash = i_keyable_hash(key);
     usize index = hash & (this->capacity - 1);
     while (this->keys[index].obj) {
-        if (i_keyable_equals(this->keys[index], (Object*)key.obj))
+        if (this->hashes[index] == hash && i_keyable_equals(this->keys[index], (Object*)key.obj))
             return true;
         index = (index + 1) & (this->capacity - 1);
     }
     return false;
 }
 
-void Set::add(IKeyable key) {
-    if (this->size >= this->capacity * 3 / 4) {
-        usize old_capacity = this->capacity;
-        this->capacity <<= 1;
-        IKeyable* new_keys = calloc(this->capacity, sizeof(IKeyable));
-        for (usize i = 0; i < old_capacity; i++) {
-            if (this->keys[i].obj) {
-                u32 hash = i_keyable_hash(this->keys[i]);
-                usize index = hash & (this->capacity - 1);
-                while (new_keys[index].obj)
-                    index = (index + 1) & (this->capacity - 1);
-                new_keys[index] = this->keys[i];
-            }
-        }
-        free(this->keys);
-        this->keys = new_keys;
-    }
+// With adopt the set takes over the caller's reference, which is dropped when the key is
+// already present
+static void set_put(Set* set, IKeyable key, bool adopt) {
+    if (set->size >= set->capacity * 3 / 4)
+        set_resize(set, set->capacity << 1);
 
     u32 hash = i_keyable_hash(key);
-    usize index = hash & (this->capacity - 1);
-    while (this->keys[index].obj) {
-        if (i_keyable_equals(this->keys[index], (Object*)key.obj))
+    usize index = hash & (set->capacity - 1);
+    while (set->keys[index].obj) {
+        if (set->hashes[index] == hash && i_keyable_equals(set->keys[index], (Object*)key.obj)) {
+            if (adopt)
+                object_free((Object*)key.obj);
             return;
-        index = (index + 1) & (this->capacity - 1);
+        }
+        index = (index + 1) & (set->capacity - 1);
     }
-    object_ref((Object*)key.obj);
-    this->keys[index] = key;
-    this->size++;
+    if (!adopt)
+        object_ref((Object*)key.obj);
+    set->keys[index] = key;
+    set->hashes[index] = hash;
+    set->size++;
+}
+
+void Set::add(IKeyable key) {
+    set_put(this, key, false);
+}
+
+void Set::add_move(IKeyable key) {
+    set_put(this, key, true);
 }
 
 void Set::remove(IKeyable key) {
     u32 hash = i_keyable_hash(key);
     usize index = hash & (this->capacity - 1);
     while (this->keys[index].obj) {
-        if (i_keyable_equals(this->keys[index], (Object*)key.obj)) {
+        if (this->hashes[index] == hash && i_keyable_equals(this->keys[index], (Object*)key.obj)) {
             object_free((Object*)this->keys[index].obj);
-            this->keys[index].obj = NULL;
+            _linear_probe_remove((_FatPointer*)this->keys, this->hashes, NULL, this->capacity, index);
             this->size--;
             return;
         }
         index = (index + 1) & (this->capacity - 1);
     }
 }
+
+void Set::reserve(usize capacity) {
+    usize new_capacity = _linear_probe_capacity(capacity);
+    if (new_capacity > this->capacity)
+        set_resize(this, new_capacity);
+}
+
+void Set::shrink_to_fit() {
+    // Arena buffers are only released with their arena
+    usize new_capacity = _linear_probe_capacity(this->size);
+    if (!_object_in_arena(this) && new_capacity < this->capacity)
+        set_resize(this, new_capacity);
+}
+
+void Set::foreach(SetForeachFn* fn, void* context) {
+    for (usize i = set_first_slot(this); i != SIZE_MAX; i = set_next_slot(this, i + 1))
+        fn((Object*)this->keys[i].obj, context);
+}
+
+IIterator Set::iterator() {
+    return cast<IIterator>(set_iterator_new(this));
+}
+
+// SetIterator
+void SetIterator::init(Set* set) {
+    Object::init();
+    this->set = set;
+    this->slot = set_first_slot(set);
+}
+
+bool SetIterator::has_next() {
+    return this->slot != SIZE_MAX;
+}
+
+Object* SetIterator::next() {
+    usize slot = this->slot;
+    this->slot = set_next_slot(this->set, slot + 1);
+    return (Object*)this->set->keys[slot].obj;
+}
@@ -8,14 +8,48 @@
 
 #include "Object.hh"
 
-class Set {
+typedef void SetForeachFn(Object* key, void* context);
+
+class Set : IIterable {
     IKeyable* keys;
+    u32* hashes;
     @get usize capacity = 8;
     @get usize size = 0;
 
     void init();
+    void init_with_capacity(usize capacity);
     virtual void deinit();
+    virtual Self* promote();
     bool contains(IKeyable key);
     void add(IKeyable key);
+    void add_move(IKeyable key);
     void remove(IKeyable key);
+    void reserve(usize capacity);
+    void shrink_to_fit();
+    void foreach(SetForeachFn* fn, void* context);
+    virtual IIterator iterator();
+
+    // Slot cursor behind for-in, nothing may be added or removed while it is used
+    inline usize first_slot() {
+        return set_next_slot(this, 0);
+    }
+    inline usize next_slot(usize slot) {
+        for (; slot < this->capacity; slot++) {
+            if (this->keys[slot].obj != NULL)
+                return slot;
+        }
+        return SIZE_MAX;
+    }
+    inline Object* slot_item(usize slot) {
+        return (Object*)this->keys[slot].obj;
+    }
+};
+
+class SetIterator : IIterator {
+    Set* set;
+    usize slot;
+
+    void init(Set* set);
+    virtual bool has_next();
+    virtual Object* next();
 };
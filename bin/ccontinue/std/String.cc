@@ -4,49 +4,102 @@
  * SPDX-License-Identifier: MIT
  */
 
+#include "List.hh"
 #include "String.hh"
+#include "StringView.hh"
+
+void String::init(char* cstr) {
+    Object::init();
+    this->length = strlen(cstr);
+    this->cstr = _object_buffer_alloc(this, this->length + 1);
+    memcpy(this->cstr, cstr, this->length + 1);
+}
+
+void String::init_owned(char* cstr, usize length) {
+    // Adopts a malloc'ed buffer, arena strings copy it so the arena still owns all their memory
+    Object::init();
+    this->length = length;
+    if (_object_in_arena(this)) {
+        this->cstr = _object_buffer_alloc(this, length + 1);
+        memcpy(this->cstr, cstr, length + 1);
+        free(cstr);
+    } else {
+        this->cstr = cstr;
+    }
+}
+
+void String::deinit() {
+    _object_buffer_free(this, this->cstr);
+    Object::deinit();
+}
+
+Self* String::promote() {
+    if (!_object_in_arena(this))
+        return (String*)object_ref(this);
+    String* copy = (String*)Object::promote();
+    copy->cstr = malloc(this->length + 1);
+    memcpy(copy->cstr, this->cstr, this->length + 1);
+    return copy;
+}
 
 bool String::equals(Object* other) {
-    if (other == NULL || !instanceof<String>(other))
+    if (other == NULL)
+        return false;
+    if (instanceof<StringView>(other))
+        return string_view_equals((StringView*)other, (Object*)this);
+    if (!instanceof<String>(other))
+        return false;
+    String* s = (String*)other;
+    if (this == s)
+        return true;
+    if (this->length != s->length)
+        return false;
+    if (this->hashed && s->hashed && this->hash_cache != s->hash_cache)
         return false;
-    return strcmp(this->cstr, ((String*)other)->cstr) == 0;
+    return memcmp(this->cstr, s->cstr, this->length) == 0;
 }
 
 u32 String::hash() {
-    return fnv1a_32(this->cstr, this->length);
+    if (!this->hashed) {
+        this->hash_cache = hash_bytes(this->cstr, this->length);
+        this->hashed = true;
+    }
+    return this->hash_cache;
+}
+
+i32 String::compare(Object* other) {
+    // Byte order, a prefix sorts before the longer string
+    String* s = (String*)other;
+    i32 result = memcmp(this->cstr, s->cstr, MIN(this->length, s->length));
+    if (result != 0)
+        return result;
+    return (this->length > s->length) - (this->length < s->length);
 }
 
 bool String::contains(char* substr) {
-    return strstr(this->cstr, substr) != NULL;
+    return _str_find(this->cstr, this->length, substr, strlen(substr)) >= 0;
 }
 
 bool String::starts_with(char* prefix) {
-    return strncmp(this->cstr, prefix, strlen(prefix)) == 0;
+    usize prefix_len = strlen(prefix);
+    return prefix_len <= this->length && memcmp(this->cstr, prefix, prefix_len) == 0;
 }
 
 bool String::ends_with(char* suffix) {
     usize suffix_len = strlen(suffix);
-    if (suffix_len > this->length)
-        return false;
-    return strcmp(this->cstr + this->length - suffix_len, suffix) == 0;
+    return suffix_len <= this->length && memcmp(this->cstr + this->length - suffix_len, suffix, suffix_len) == 0;
 }
 
 String* String::to_upper() {
-    char* result = strdup(this->cstr);
-    for (usize i = 0; result[i]; i++)
-        result[i] = (char)toupper((unsigned char)result[i]);
-    String* s = string_new(result);
-    free(result);
-    return s;
+    char* result = malloc(this->length + 1);
+    _str_ascii_upper(result, this->cstr, this->length + 1);
+    return string_new_owned(result, this->length);
 }
 
 String* String::to_lower() {
-    char* result = strdup(this->cstr);
-    for (usize i = 0; result[i]; i++)
-        result[i] = (char)tolower((unsigned char)result[i]);
-    String* s = string_new(result);
-    free(result);
-    return s;
+    char* result = malloc(this->length + 1);
+    _str_ascii_lower(result, this->cstr, this->length + 1);
+    return string_new_owned(result, this->length);
 }
 
 String* String::trim() {
@@ -60,16 +113,26 @@ String* String::trim() {
     char* result = malloc(new_len + 1);
     memcpy(result, start, new_len);
     result[new_len] = '\0';
-    String* s = string_new(result);
-    free(result);
-    return s;
+    return string_new_owned(result, new_len);
 }
 
 i32 String::index_of(char* substr) {
-    char* found = strstr(this->cstr, substr);
-    if (found == NULL)
-        return -1;
-    return (i32)(found - this->cstr);
+    return (i32)_str_find(this->cstr, this->length, substr, strlen(substr));
+}
+
+i32 String::find_byte(char c) {
+    return (i32)_str_find_byte(this->cstr, this->length, c);
+}
+
+usize String::count_byte(char c) {
+    return _str_count_byte(this->cstr, this->length, c);
+}
+
+List* String::split(char separator) {
+    StringView* whole = string_view_new(this, 0, this->length);
+    List* parts = string_view_split(whole, separator);
+    string_view_free(whole);
+    return parts;
 }
 
 String* String::substring(usize start, usize length) {
@@ -79,7 +142,9 @@ String* String::substring(usize start, usize length) {
     char* result = malloc(actual + 1);
     memcpy(result, this->cstr + start, actual);
     result[actual] = '\0';
-    String* s = string_new(result);
-    free(result);
-    return s;
+    return string_new_owned(result, actual);
+}
+
+StringView* String::slice(usize start, usize length) {
+    return string_view_new(this, start, length);
 }
@@ -8,12 +8,22 @@
 
 #include "Object.hh"
 
-class String : IEquatable, IHashable {
-    @get @init(strdup) @deinit char* cstr;
-    @get usize length = strlen(cstr);
+class List;
+class StringView;
 
+class String : IComparable, IHashable {
+    @get char* cstr;
+    @get usize length;
+    u32 hash_cache = 0; // Valid when hashed, String is immutable
+    bool hashed = false;
+
+    void init(char* cstr);
+    void init_owned(char* cstr, usize length);
+    virtual void deinit();
+    virtual Self* promote();
     virtual bool equals(Object* other);
     virtual u32 hash();
+    virtual i32 compare(Object* other);
     bool contains(char* substr);
     bool starts_with(char* prefix);
     bool ends_with(char* suffix);
@@ -21,5 +31,9 @@ class String : IEquatable, IHashable {
     String* to_lower();
     String* trim();
     i32 index_of(char* substr);
+    i32 find_byte(char c);
+    usize count_byte(char c);
+    List* split(char separator);
     String* substring(usize start, usize length);
+    StringView* slice(usize start, usize length);
 };
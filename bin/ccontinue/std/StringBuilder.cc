@@ -8,20 +8,38 @@
 
 void StringBuilder::init() {
     Object::init();
-    this->buf = malloc(this->capacity);
+    this->buf = _object_buffer_alloc(this, this->capacity);
+    this->buf[0] = '\0';
+}
+
+void StringBuilder::init_with_capacity(usize capacity) {
+    Object::init();
+    this->capacity = capacity + 1;
+    this->buf = _object_buffer_alloc(this, this->capacity);
     this->buf[0] = '\0';
 }
 
 void StringBuilder::deinit() {
-    free(this->buf);
+    _object_buffer_free(this, this->buf);
     Object::deinit();
 }
 
+Self* StringBuilder::promote() {
+    if (!_object_in_arena(this))
+        return (StringBuilder*)object_ref(this);
+    StringBuilder* copy = (StringBuilder*)Object::promote();
+    copy->buf = malloc(this->capacity);
+    memcpy(copy->buf, this->buf, this->length + 1);
+    return copy;
+}
+
 void StringBuilder::append_cstr(char* s) {
     usize add = strlen(s);
-    while (this->length + add + 1 > this->capacity) {
-        this->capacity <<= 1;
-        this->buf = realloc(this->buf, this->capacity);
+    if (this->length + add + 1 > this->capacity) {
+        usize old_capacity = this->capacity;
+        while (this->length + add + 1 > this->capacity)
+            this->capacity <<= 1;
+        this->buf = _object_buffer_realloc(this, this->buf, old_capacity, this->capacity);
     }
     memcpy(this->buf + this->length, s, add + 1);
     this->length += add;
@@ -30,7 +48,7 @@ void StringBuilder::append_cstr(char* s) {
 void StringBuilder::append_char(char c) {
     if (this->length + 2 > this->capacity) {
         this->capacity <<= 1;
-        this->buf = realloc(this->buf, this->capacity);
+        this->buf = _object_buffer_realloc(this, this->buf, this->capacity >> 1, this->capacity);
     }
     this->buf[this->length++] = c;
     this->buf[this->length] = '\0';
@@ -40,6 +58,38 @@ void StringBuilder::append_string(String* s) {
     string_builder_append_cstr(this, string_get_cstr(s));
 }
 
+void StringBuilder::reserve(usize length) {
+    if (length + 1 > this->capacity) {
+        this->buf = _object_buffer_realloc(this, this->buf, this->capacity, length + 1);
+        this->capacity = length + 1;
+    }
+}
+
+void StringBuilder::shrink_to_fit() {
+    // Arena buffers are only released with their arena
+    if (_object_in_arena(this) || this->length + 1 == this->capacity)
+        return;
+    this->capacity = this->length + 1;
+    this->buf = realloc(this->buf, this->capacity);
+}
+
 String* StringBuilder::build() {
     return string_new(this->buf);
 }
+
+String* StringBuilder::build_take() {
+    // Hands the buffer to the string without copying and leaves the builder empty,
+    // arena buffers are copied because a heap string can't own them
+    if (_object_in_arena(this)) {
+        String* s = string_new(this->buf);
+        this->length = 0;
+        this->buf[0] = '\0';
+        return s;
+    }
+    String* s = string_new_owned(this->buf, this->length);
+    this->length = 0;
+    this->capacity = 16;
+    this->buf = malloc(this->capacity);
+    this->buf[0] = '\0';
+    return s;
+}
@@ -12,12 +12,17 @@
 class StringBuilder {
     char* buf;
     @get usize length = 0;
-    usize capacity = 16;
+    @get usize capacity = 16;
 
     void init();
+    void init_with_capacity(usize capacity);
     virtual void deinit();
+    virtual Self* promote();
     void append_cstr(char* s);
     void append_char(char c);
     void append_string(String* s);
+    void reserve(usize length);
+    void shrink_to_fit();
     String* build();
+    String* build_take();
 };
@@ -0,0 +1,132 @@
+/*
+ * Copyright (c) 2026 Bastiaan van der Plaat
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "StringView.hh"
+
+void StringView::init(String* parent, usize offset, usize length) {
+    Object::init();
+    usize parent_length = string_get_length(parent);
+    this->parent = string_ref(parent);
+    this->offset = MIN(offset, parent_length);
+    this->length = MIN(length, parent_length - this->offset);
+}
+
+void StringView::deinit() {
+    string_free(this->parent);
+    Object::deinit();
+}
+
+Self* StringView::promote() {
+    if (!_object_in_arena(this))
+        return (StringView*)object_ref(this);
+    StringView* copy = (StringView*)Object::promote();
+    copy->parent = string_promote(this->parent);
+    return copy;
+}
+
+bool StringView::equals(Object* other) {
+    if (other == NULL)
+        return false;
+    if (instanceof<StringView>(other)) {
+        StringView* view = (StringView*)other;
+        if (this == view)
+            return true;
+        if (this->length != view->length)
+            return false;
+        if (this->hashed && view->hashed && this->hash_cache != view->hash_cache)
+            return false;
+        return memcmp(string_view_data(this), string_view_data(view), this->length) == 0;
+    }
+    if (instanceof<String>(other)) {
+        String* s = (String*)other;
+        return this->length == string_get_length(s) && memcmp(string_view_data(this), string_get_cstr(s), this->length) == 0;
+    }
+    return false;
+}
+
+u32 StringView::hash() {
+    // Same hash as String over the same bytes, so views and strings are interchangeable keys
+    if (!this->hashed) {
+        this->hash_cache = hash_bytes(string_view_data(this), this->length);
+        this->hashed = true;
+    }
+    return this->hash_cache;
+}
+
+char* StringView::data() {
+    return string_get_cstr(this->parent) + this->offset;
+}
+
+char StringView::get(usize index) {
+    return index < this->length ? string_view_data(this)[index] : '\0';
+}
+
+bool StringView::contains(char* substr) {
+    return _str_find(string_view_data(this), this->length, substr, strlen(substr)) >= 0;
+}
+
+bool StringView::starts_with(char* prefix) {
+    usize prefix_len = strlen(prefix);
+    return prefix_len <= this->length && memcmp(string_view_data(this), prefix, prefix_len) == 0;
+}
+
+bool StringView::ends_with(char* suffix) {
+    usize suffix_len = strlen(suffix);
+    return suffix_len <= this->length &&
+           memcmp(string_view_data(this) + this->length - suffix_len, suffix, suffix_len) == 0;
+}
+
+i32 StringView::index_of(char* substr) {
+    return (i32)_str_find(string_view_data(this), this->length, substr, strlen(substr));
+}
+
+i32 StringView::find_byte(char c) {
+    return (i32)_str_find_byte(string_view_data(this), this->length, c);
+}
+
+usize StringView::count_byte(char c) {
+    return _str_count_byte(string_view_data(this), this->length, c);
+}
+
+List* StringView::split(char separator) {
+    // Pieces are views of the same parent, the bytes are never copied
+    char* data = string_view_data(this);
+    List* parts = list_new_with_capacity(_str_count_byte(data, this->length, separator) + 1);
+    usize start = 0;
+    for (;;) {
+        isize found = _str_find_byte(data + start, this->length - start, separator);
+        usize end = found < 0 ? this->length : start + (usize)found;
+        list_add(parts, (Object*)string_view_new(this->parent, this->offset + start, end - start));
+        if (found < 0)
+            break;
+        start = end + 1;
+    }
+    return parts;
+}
+
+StringView* StringView::trim() {
+    // A narrower view of the same parent, the bytes are never copied
+    const char* data = string_view_data(this);
+    const char* start = data;
+    const char* end = start + this->length;
+    while (start < end && (*start == ' ' || *start == '\t' || *start == '\n' || *start == '\r'))
+        start++;
+    while (end > start && (end[-1] == ' ' || end[-1] == '\t' || end[-1] == '\n' || end[-1] == '\r'))
+        end--;
+    return string_view_new(this->parent, this->offset + (usize)(start - data), (usize)(end - start));
+}
+
+StringView* StringView::slice(usize start, usize length) {
+    start = MIN(start, this->length);
+    return string_view_new(this->parent, this->offset + start, MIN(length, this->length - start));
+}
+
+String* StringView::to_string() {
+    char* result = malloc(this->length + 1);
+    memcpy(result, string_view_data(this), this->length);
+    result[this->length] = '\0';
+    return string_new_owned(result, this->length);
+}
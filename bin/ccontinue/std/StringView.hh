@@ -0,0 +1,38 @@
+/*
+ * Copyright (c) 2026 Bastiaan van der Plaat
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include "List.hh"
+#include "Object.hh"
+#include "String.hh"
+
+// Borrowed slice of a String, keeps a ref to its parent and never copies bytes
+@pool class StringView : IEquatable, IHashable {
+    @get String* parent;
+    @get usize offset;
+    @get usize length;
+    u32 hash_cache = 0; // Valid when hashed, views never change
+    bool hashed = false;
+
+    void init(String* parent, usize offset, usize length);
+    virtual void deinit();
+    virtual Self* promote();
+    virtual bool equals(Object* other);
+    virtual u32 hash();
+    char* data();
+    char get(usize index);
+    bool contains(char* substr);
+    bool starts_with(char* prefix);
+    bool ends_with(char* suffix);
+    i32 index_of(char* substr);
+    i32 find_byte(char c);
+    usize count_byte(char c);
+    List* split(char separator);
+    StringView* trim();
+    StringView* slice(usize start, usize length);
+    String* to_string();
+};
@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) 2026 Bastiaan van der Plaat
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <stdatomic.h>
+
+#include "Symbol.hh"
+
+// Intern table: linear probing over symbols that live for the rest of the process
+static Symbol** symbol_table = NULL;
+static usize symbol_capacity = 0;
+static usize symbol_count = 0;
+static atomic_flag symbol_lock = ATOMIC_FLAG_INIT;
+
+static usize symbol_table_find(char* cstr, usize length, u32 hash) {
+    usize mask = symbol_capacity - 1;
+    usize index = hash & mask;
+    for (;;) {
+        Symbol* symbol = symbol_table[index];
+        if (symbol == NULL)
+            return index;
+        if (symbol->hash_value == hash && string_get_length(symbol->string) == length &&
+            memcmp(string_get_cstr(symbol->string), cstr, length) == 0)
+            return index;
+        index = (index + 1) & mask;
+    }
+}
+
+static void symbol_table_grow(void) {
+    usize old_capacity = symbol_capacity;
+    Symbol** old_table = symbol_table;
+    symbol_capacity = _linear_probe_capacity(symbol_count + 1);
+    symbol_table = calloc(symbol_capacity, sizeof(Symbol*));
+    for (usize i = 0; i < old_capacity; i++) {
+        Symbol* symbol = old_table[i];
+        if (symbol != NULL) {
+            usize index = symbol->hash_value & (symbol_capacity - 1);
+            while (symbol_table[index] != NULL)
+                index = (index + 1) & (symbol_capacity - 1);
+            symbol_table[index] = symbol;
+        }
+    }
+    free(old_table);
+}
+
+// Looks up or inserts the symbol for these bytes, string is adopted on insert when not NULL
+static Symbol* symbol_table_intern(char* cstr, usize length, u32 hash, String* string) {
+    while (atomic_flag_test_and_set_explicit(&symbol_lock, memory_order_acquire)) {
+    }
+    if ((symbol_count + 1) * 4 > symbol_capacity * 3)
+        symbol_table_grow();
+    usize index = symbol_table_find(cstr, length, hash);
+    Symbol* symbol = symbol_table[index];
+    if (symbol == NULL) {
+        // Symbols outlive any arena, so they are always created on the heap
+        Arena* arena = _arena_suspend();
+        String* owned = string != NULL ? string_promote(string) : string_new(cstr);
+        symbol = symbol_new(owned, hash);
+        string_free(owned);
+        _arena_resume(arena);
+        symbol_table[index] = symbol;
+        symbol_count++;
+    }
+    symbol_ref(symbol);
+    atomic_flag_clear_explicit(&symbol_lock, memory_order_release);
+    return symbol;
+}
+
+void Symbol::init(String* string, u32 hash) {
+    Object::init();
+    this->string = string_ref(string);
+    this->hash_value = hash;
+}
+
+void Symbol::deinit() {
+    string_free(this->string);
+    Object::deinit();
+}
+
+Self* Symbol::promote() {
+    // Symbols are never arena allocated
+    return (Symbol*)object_ref(this);
+}
+
+bool Symbol::equals(Object* other) {
+    // Interning makes identity and content equality the same thing
+    return (Object*)this == other;
+}
+
+u32 Symbol::hash() {
+    return this->hash_value;
+}
+
+char* Symbol::get_cstr() {
+    return string_get_cstr(this->string);
+}
+
+usize Symbol::get_length() {
+    return string_get_length(this->string);
+}
+
+String* Symbol::to_string() {
+    return string_ref(this->string);
+}
+
+Symbol* Symbol::intern(char* cstr) {
+    usize length = strlen(cstr);
+    return symbol_table_intern(cstr, length, hash_bytes(cstr, length), NULL);
+}
+
+Symbol* Symbol::intern_string(String* string) {
+    return symbol_table_intern(string_get_cstr(string), string_get_length(string), string_hash(string), string);
+}
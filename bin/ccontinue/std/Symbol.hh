@@ -0,0 +1,27 @@
+/*
+ * Copyright (c) 2026 Bastiaan van der Plaat
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include "Object.hh"
+#include "String.hh"
+
+// Interned string: one canonical instance per distinct string, compared by pointer
+class Symbol : IEquatable, IHashable {
+    @get String* string;
+    u32 hash_value;
+
+    void init(String* string, u32 hash);
+    virtual void deinit();
+    virtual Self* promote();
+    virtual bool equals(Object* other);
+    virtual u32 hash();
+    char* get_cstr();
+    usize get_length();
+    String* to_string();
+    static Symbol* intern(char* cstr);
+    static Symbol* intern_string(String* string);
+};
@@ -0,0 +1,324 @@
+/*
+ * Copyright (c) 2026 Bastiaan van der Plaat
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <sched.h>
+#include <unistd.h>
+
+#include "ThreadPool.hh"
+
+#define _POOL_DEQUE_CAPACITY 4096
+
+struct _PoolTask {
+    TaskFn* fn;
+    void* arg;
+    _PoolTask* next;
+};
+
+// Chase-Lev deque: the owner pushes and pops at the bottom, thieves steal from the top.
+// A full deque makes the owner run the task itself, so it never grows
+typedef struct _PoolDeque {
+    _Atomic isize top;
+    _Atomic isize bottom;
+    _Atomic(_PoolTask*) tasks[_POOL_DEQUE_CAPACITY];
+} _PoolDeque;
+
+struct _PoolWorker {
+    ThreadPool* pool;
+    pthread_t thread;
+    u64 victim_state;
+    _PoolDeque deque;
+};
+
+static _Thread_local _PoolWorker* _pool_current_worker = NULL;
+
+static bool pool_deque_push(_PoolDeque* deque, _PoolTask* task) {
+    isize bottom = atomic_load_explicit(&deque->bottom, memory_order_relaxed);
+    isize top = atomic_load_explicit(&deque->top, memory_order_acquire);
+    if (bottom - top >= _POOL_DEQUE_CAPACITY)
+        return false;
+    atomic_store_explicit(&deque->tasks[bottom & (_POOL_DEQUE_CAPACITY - 1)], task, memory_order_relaxed);
+    // Sequentially consistent so a worker going to sleep either sees the task or is woken
+    atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_seq_cst);
+    return true;
+}
+
+static _PoolTask* pool_deque_pop(_PoolDeque* deque) {
+    isize bottom = atomic_load_explicit(&deque->bottom, memory_order_relaxed) - 1;
+    atomic_store_explicit(&deque->bottom, bottom, memory_order_seq_cst);
+    isize top = atomic_load_explicit(&deque->top, memory_order_seq_cst);
+    if (top > bottom) {
+        atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+        return NULL;
+    }
+    _PoolTask* task = atomic_load_explicit(&deque->tasks[bottom & (_POOL_DEQUE_CAPACITY - 1)], memory_order_relaxed);
+    if (top == bottom) {
+        // Last task, race the thieves for it
+        if (!atomic_compare_exchange_strong_explicit(&deque->top, &top, top + 1, memory_order_seq_cst,
+                                                     memory_order_relaxed))
+            task = NULL;
+        atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+    }
+    return task;
+}
+
+static _PoolTask* pool_deque_steal(_PoolDeque* deque) {
+    isize top = atomic_load_explicit(&deque->top, memory_order_seq_cst);
+    isize bottom = atomic_load_explicit(&deque->bottom, memory_order_seq_cst);
+    if (top >= bottom)
+        return NULL;
+    _PoolTask* task = atomic_load_explicit(&deque->tasks[top & (_POOL_DEQUE_CAPACITY - 1)], memory_order_relaxed);
+    if (!atomic_compare_exchange_strong_explicit(&deque->top, &top, top + 1, memory_order_seq_cst,
+                                                 memory_order_relaxed))
+        return NULL;
+    return task;
+}
+
+// Own deque first, then steal starting at a random victim, then the injected queue
+static _PoolTask* thread_pool_find_task(ThreadPool* pool, _PoolWorker* self, bool locked) {
+    _PoolTask* task;
+    if (self != NULL && (task = pool_deque_pop(&self->deque)) != NULL)
+        return task;
+
+    usize start = 0;
+    if (self != NULL) {
+        self->victim_state = self->victim_state * 6364136223846793005ULL + 1442695040888963407ULL;
+        start = (usize)(self->victim_state >> 33);
+    }
+    for (usize i = 0; i < pool->size; i++) {
+        _PoolWorker* victim = &pool->workers[(start + i) % pool->size];
+        if (victim != self && (task = pool_deque_steal(&victim->deque)) != NULL)
+            return task;
+    }
+
+    if (atomic_load(&pool->injected_count) == 0)
+        return NULL;
+    if (!locked)
+        pthread_mutex_lock(&pool->lock);
+    task = pool->injected_head;
+    if (task != NULL) {
+        pool->injected_head = task->next;
+        if (pool->injected_head == NULL)
+            pool->injected_tail = NULL;
+        atomic_fetch_sub(&pool->injected_count, 1);
+    }
+    if (!locked)
+        pthread_mutex_unlock(&pool->lock);
+    return task;
+}
+
+static void thread_pool_run_task(ThreadPool* pool, _PoolTask* task) {
+    task->fn(task->arg);
+    free(task);
+    atomic_fetch_sub_explicit(&pool->pending, 1, memory_order_acq_rel);
+}
+
+static void* thread_pool_worker_main(void* arg) {
+    _PoolWorker* self = arg;
+    ThreadPool* pool = self->pool;
+    _pool_current_worker = self;
+    for (;;) {
+        _PoolTask* task = thread_pool_find_task(pool, self, false);
+        if (task == NULL) {
+            pthread_mutex_lock(&pool->lock);
+            atomic_fetch_add(&pool->sleeping, 1);
+            while ((task = thread_pool_find_task(pool, self, true)) == NULL && !atomic_load(&pool->stopping))
+                pthread_cond_wait(&pool->wake, &pool->lock);
+            atomic_fetch_sub(&pool->sleeping, 1);
+            pthread_mutex_unlock(&pool->lock);
+            if (task == NULL)
+                break;
+        }
+        thread_pool_run_task(pool, task);
+    }
+    return NULL;
+}
+
+// ThreadPool
+void ThreadPool::init(usize size) {
+    if (size == 0) {
+        long cores = sysconf(_SC_NPROCESSORS_ONLN);
+        size = cores > 0 ? (usize)cores : 1;
+    }
+    this->size = size;
+    this->injected_head = NULL;
+    this->injected_tail = NULL;
+    atomic_init(&this->injected_count, 0);
+    atomic_init(&this->pending, 0);
+    atomic_init(&this->sleeping, 0);
+    atomic_init(&this->stopping, false);
+    pthread_mutex_init(&this->lock, NULL);
+    pthread_cond_init(&this->wake, NULL);
+    this->workers = calloc(size, sizeof(_PoolWorker));
+    for (usize i = 0; i < size; i++) {
+        _PoolWorker* worker = &this->workers[i];
+        worker->pool = this;
+        worker->victim_state = i + 1;
+        atomic_init(&worker->deque.top, 0);
+        atomic_init(&worker->deque.bottom, 0);
+    }
+    for (usize i = 0; i < size; i++)
+        pthread_create(&this->workers[i].thread, NULL, thread_pool_worker_main, &this->workers[i]);
+}
+
+void ThreadPool::deinit() {
+    thread_pool_wait(this);
+    pthread_mutex_lock(&this->lock);
+    atomic_store(&this->stopping, true);
+    pthread_cond_broadcast(&this->wake);
+    pthread_mutex_unlock(&this->lock);
+    for (usize i = 0; i < this->size; i++)
+        pthread_join(this->workers[i].thread, NULL);
+    free(this->workers);
+    pthread_cond_destroy(&this->wake);
+    pthread_mutex_destroy(&this->lock);
+    Object::deinit();
+}
+
+static ThreadPool* thread_pool_global_instance = NULL;
+static pthread_once_t thread_pool_global_once = PTHREAD_ONCE_INIT;
+
+static void thread_pool_global_create(void) {
+    // The global pool lives for the rest of the process, so it is never owned by an arena
+    Arena* arena = _arena_suspend();
+    thread_pool_global_instance = thread_pool_new(0);
+    _arena_resume(arena);
+}
+
+ThreadPool* ThreadPool::global() {
+    pthread_once(&thread_pool_global_once, thread_pool_global_create);
+    return thread_pool_global_instance;
+}
+
+void ThreadPool::spawn(TaskFn* fn, void* arg) {
+    _PoolTask* task = malloc(sizeof(_PoolTask));
+    task->fn = fn;
+    task->arg = arg;
+    task->next = NULL;
+    atomic_fetch_add(&this->pending, 1);
+
+    _PoolWorker* self = _pool_current_worker;
+    if (self != NULL && self->pool == this) {
+        if (!pool_deque_push(&self->deque, task)) {
+            thread_pool_run_task(this, task);
+            return;
+        }
+        if (atomic_load(&this->sleeping) > 0) {
+            pthread_mutex_lock(&this->lock);
+            pthread_cond_signal(&this->wake);
+            pthread_mutex_unlock(&this->lock);
+        }
+        return;
+    }
+
+    pthread_mutex_lock(&this->lock);
+    if (this->injected_tail != NULL)
+        this->injected_tail->next = task;
+    else
+        this->injected_head = task;
+    this->injected_tail = task;
+    atomic_fetch_add(&this->injected_count, 1);
+    pthread_cond_signal(&this->wake);
+    pthread_mutex_unlock(&this->lock);
+}
+
+// Waiting threads run queued tasks instead of blocking, so waiting inside a task can't deadlock
+static void thread_pool_help_until(ThreadPool* pool, _Atomic usize* counter) {
+    _PoolWorker* self = _pool_current_worker;
+    if (self != NULL && self->pool != pool)
+        self = NULL;
+    while (atomic_load_explicit(counter, memory_order_acquire) > 0) {
+        _PoolTask* task = thread_pool_find_task(pool, self, false);
+        if (task != NULL)
+            thread_pool_run_task(pool, task);
+        else
+            sched_yield();
+    }
+}
+
+void ThreadPool::wait() {
+    thread_pool_help_until(this, &this->pending);
+}
+
+// Parallel for: ranges are split in halves, the upper half is left for thieves and the lower
+// half is split again until it fits in one grain
+typedef struct _ParallelJob {
+    ThreadPool* pool;
+    ParallelRangeFn* fn;
+    void* context;
+    usize grain;
+    _Atomic usize remaining;
+} _ParallelJob;
+
+typedef struct _ParallelSplit {
+    _ParallelJob* job;
+    usize begin;
+    usize end;
+} _ParallelSplit;
+
+static void parallel_split_run(void* arg) {
+    _ParallelSplit* split = arg;
+    _ParallelJob* job = split->job;
+    usize begin = split->begin;
+    usize end = split->end;
+    free(split);
+    while (end - begin > job->grain) {
+        usize middle = begin + (end - begin) / 2;
+        _ParallelSplit* upper = malloc(sizeof(_ParallelSplit));
+        upper->job = job;
+        upper->begin = middle;
+        upper->end = end;
+        thread_pool_spawn(job->pool, parallel_split_run, upper);
+        end = middle;
+    }
+    job->fn(begin, end, job->context);
+    atomic_fetch_sub_explicit(&job->remaining, end - begin, memory_order_acq_rel);
+}
+
+void ThreadPool::parallel_for_range(usize begin, usize end, usize grain, ParallelRangeFn* fn, void* context) {
+    if (end <= begin)
+        return;
+    usize count = end - begin;
+    if (grain == 0)
+        grain = MAX(count / (this->size * 8), 1);
+    if (count <= grain || this->size == 1) {
+        fn(begin, end, context);
+        return;
+    }
+
+    _ParallelJob job = {.pool = this, .fn = fn, .context = context, .grain = grain};
+    atomic_init(&job.remaining, count);
+    _ParallelSplit* root = malloc(sizeof(_ParallelSplit));
+    root->job = &job;
+    root->begin = begin;
+    root->end = end;
+    thread_pool_spawn(this, parallel_split_run, root);
+    thread_pool_help_until(this, &job.remaining);
+}
+
+typedef struct _ParallelItems {
+    List* list;
+    ParallelItemFn* fn;
+    void* context;
+} _ParallelItems;
+
+static void parallel_items_run(usize begin, usize end, void* context) {
+    _ParallelItems* items = context;
+    for (usize i = begin; i < end; i++)
+        items->fn(items->list->items[i], items->context);
+}
+
+void ThreadPool::parallel_for(List* list, ParallelItemFn* fn, void* context) {
+    _ParallelItems items = {.list = list, .fn = fn, .context = context};
+    thread_pool_parallel_for_range(this, 0, list->size, 0, parallel_items_run, &items);
+}
+
+void parallel_for_range(usize begin, usize end, usize grain, ParallelRangeFn* fn, void* context) {
+    thread_pool_parallel_for_range(thread_pool_global(), begin, end, grain, fn, context);
+}
+
+void parallel_for(List* list, ParallelItemFn* fn, void* context) {
+    thread_pool_parallel_for(thread_pool_global(), list, fn, context);
+}
@@ -0,0 +1,47 @@
+/*
+ * Copyright (c) 2026 Bastiaan van der Plaat
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include <pthread.h>
+
+#include "List.hh"
+
+typedef void TaskFn(void* arg);
+typedef void ParallelRangeFn(usize begin, usize end, void* context);
+typedef void ParallelItemFn(Object* item, void* context);
+
+typedef struct _PoolWorker _PoolWorker;
+typedef struct _PoolTask _PoolTask;
+
+// Worker threads with a work-stealing deque each, tasks spawned from other threads are
+// injected through a locked queue
+class ThreadPool {
+    @get usize size;
+    _PoolWorker* workers;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    _PoolTask* injected_head;
+    _PoolTask* injected_tail;
+    _Atomic usize injected_count;
+    _Atomic usize pending;
+    _Atomic usize sleeping;
+    _Atomic bool stopping;
+
+    void init(usize size);
+    virtual void deinit();
+    static ThreadPool* global();
+    void spawn(TaskFn* task, void* arg);
+    void wait();
+    void parallel_for_range(usize begin, usize end, usize grain, ParallelRangeFn* fn, void* context);
+    void parallel_for(List* list, ParallelItemFn* fn, void* context);
+};
+
+// Run fn over [begin, end) in chunks of at most grain indices (0 picks one) on the global pool
+void parallel_for_range(usize begin, usize end, usize grain, ParallelRangeFn* fn, void* context);
+
+// Run fn for every item of list on the global pool
+void parallel_for(List* list, ParallelItemFn* fn, void* context);
@@ -0,0 +1,562 @@
+/*
+ * Copyright (c) 2026 Bastiaan van der Plaat
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <String.hh>
+#include <TreeMap.hh>
+
+// Keys per node, the key pointers of a full node span four cache lines
+#define _TREE_ORDER 32
+#define _TREE_MIN (_TREE_ORDER / 2 - 1)
+
+// Inner nodes route with keys[i] between children[i] (smaller keys) and children[i + 1]. Their
+// keys are references of their own, so removing a key from a leaf never leaves one dangling
+struct _TreeNode {
+    u32 count;
+    bool leaf;
+    Object* keys[_TREE_ORDER];
+    union {
+        _TreeNode* children[_TREE_ORDER + 1];
+        struct {
+            Object* values[_TREE_ORDER];
+            _TreeNode* prev;
+            _TreeNode* next;
+        };
+    };
+};
+
+// Boxed keys of the same type compare without dispatch
+static inline i32 tree_compare(IComparable key, Object* other) {
+    Object* obj = key.obj;
+    if (obj->vtbl == other->vtbl) {
+        if (obj->vtbl == (void*)&_IntVtbl) {
+            i64 a = ((Int*)obj)->value;
+            i64 b = ((Int*)other)->value;
+            return (a > b) - (a < b);
+        }
+        if (obj->vtbl == (void*)&_StringVtbl)
+            return _string_compare((String*)obj, other);
+    }
+    return i_comparable_compare(key, other);
+}
+
+// First index with a key >= key
+static u32 tree_lower_bound(_TreeNode* node, IComparable key) {
+    u32 low = 0, high = node->count;
+    while (low < high) {
+        u32 middle = (low + high) / 2;
+        if (tree_compare(key, node->keys[middle]) > 0)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+    return low;
+}
+
+// First index with a key > key
+static u32 tree_upper_bound(_TreeNode* node, IComparable key) {
+    u32 low = 0, high = node->count;
+    while (low < high) {
+        u32 middle = (low + high) / 2;
+        if (tree_compare(key, node->keys[middle]) >= 0)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+    return low;
+}
+
+static _TreeNode* tree_node_new(TreeMap* map, bool leaf) {
+    _TreeNode* node = _object_buffer_alloc(map, sizeof(_TreeNode));
+    node->count = 0;
+    node->leaf = leaf;
+    if (leaf) {
+        node->prev = NULL;
+        node->next = NULL;
+    }
+    return node;
+}
+
+static void tree_node_release(TreeMap* map, _TreeNode* node) {
+    // Arena buffers are only released with their arena
+    if (!_object_in_arena(map))
+        free(node);
+}
+
+static void tree_node_free(TreeMap* map, _TreeNode* node) {
+    for (u32 i = 0; i < node->count; i++) {
+        object_free(node->keys[i]);
+        if (node->leaf && node->values[i] != NULL)
+            object_free(node->values[i]);
+    }
+    if (!node->leaf) {
+        for (u32 i = 0; i <= node->count; i++)
+            tree_node_free(map, node->children[i]);
+    }
+    tree_node_release(map, node);
+}
+
+static _TreeNode* tree_find_leaf(TreeMap* map, IComparable key) {
+    _TreeNode* node = map->root;
+    while (!node->leaf)
+        node = node->children[tree_upper_bound(node, key)];
+    return node;
+}
+
+static _TreeNode* tree_first_leaf(TreeMap* map) {
+    _TreeNode* node = map->root;
+    while (!node->leaf)
+        node = node->children[0];
+    return node;
+}
+
+// Builds the tree bottom up from keys in increasing order. Nodes of a level share the items
+// evenly, so every node but the root stays above the minimum
+static _TreeNode* tree_build(TreeMap* map, Object** keys, Object** values, usize size) {
+    if (size == 0)
+        return tree_node_new(map, true);
+    usize count = (size + _TREE_ORDER - 1) / _TREE_ORDER;
+    _TreeNode** level = malloc(sizeof(_TreeNode*) * count);
+    Object** firsts = malloc(sizeof(Object*) * count);
+    _TreeNode* prev = NULL;
+    usize offset = 0;
+    for (usize i = 0; i < count; i++) {
+        usize take = size / count + (i < size % count ? 1 : 0);
+        _TreeNode* leaf = tree_node_new(map, true);
+        memcpy(leaf->keys, &keys[offset], sizeof(Object*) * take);
+        if (values != NULL)
+            memcpy(leaf->values, &values[offset], sizeof(Object*) * take);
+        else
+            memset(leaf->values, 0, sizeof(Object*) * take);
+        leaf->count = (u32)take;
+        leaf->prev = prev;
+        if (prev != NULL)
+            prev->next = leaf;
+        prev = leaf;
+        level[i] = leaf;
+        firsts[i] = leaf->keys[0];
+        offset += take;
+    }
+
+    while (count > 1) {
+        usize parents = (count + _TREE_ORDER) / (_TREE_ORDER + 1);
+        usize child = 0;
+        for (usize i = 0; i < parents; i++) {
+            usize take = count / parents + (i < count % parents ? 1 : 0);
+            _TreeNode* node = tree_node_new(map, false);
+            node->count = (u32)(take - 1);
+            for (usize j = 0; j < take; j++) {
+                node->children[j] = level[child + j];
+                if (j > 0)
+                    node->keys[j - 1] = object_ref(firsts[child + j]);
+            }
+            firsts[i] = firsts[child];
+            level[i] = node;
+            child += take;
+        }
+        count = parents;
+    }
+    _TreeNode* root = level[0];
+    free(level);
+    free(firsts);
+    return root;
+}
+
+// Splits a full leaf in halves, returns the new right half
+static _TreeNode* tree_split_leaf(TreeMap* map, _TreeNode* node) {
+    _TreeNode* right = tree_node_new(map, true);
+    u32 middle = _TREE_ORDER / 2;
+    right->count = _TREE_ORDER - middle;
+    memcpy(right->keys, &node->keys[middle], sizeof(Object*) * right->count);
+    memcpy(right->values, &node->values[middle], sizeof(Object*) * right->count);
+    node->count = middle;
+    right->next = node->next;
+    if (right->next != NULL)
+        right->next->prev = right;
+    right->prev = node;
+    node->next = right;
+    return right;
+}
+
+// Splits a full inner node around its middle key, which moves up into separator
+static _TreeNode* tree_split_inner(TreeMap* map, _TreeNode* node, Object** separator) {
+    _TreeNode* right = tree_node_new(map, false);
+    u32 middle = _TREE_ORDER / 2;
+    right->count = _TREE_ORDER - middle - 1;
+    memcpy(right->keys, &node->keys[middle + 1], sizeof(Object*) * right->count);
+    memcpy(right->children, &node->children[middle + 1], sizeof(_TreeNode*) * (right->count + 1));
+    *separator = node->keys[middle];
+    node->count = middle;
+    return right;
+}
+
+// Inserts into the subtree. A node that had to split returns its new right sibling, with the
+// key separating the two in separator. With adopt the caller's key reference moves into the
+// tree, or is dropped when the key is already present
+static _TreeNode* tree_insert(TreeMap* map, _TreeNode* node, IComparable key, Object* value, bool adopt,
+                              Object** separator) {
+    if (node->leaf) {
+        u32 index = tree_lower_bound(node, key);
+        if (index < node->count && tree_compare(key, node->keys[index]) == 0) {
+            if (node->values[index] != NULL)
+                object_free(node->values[index]);
+            node->values[index] = value;
+            if (adopt)
+                object_free((Object*)key.obj);
+            return NULL;
+        }
+        _TreeNode* right = NULL;
+        if (node->count == _TREE_ORDER) {
+            right = tree_split_leaf(map, node);
+            if (index > node->count) {
+                index -= node->count;
+                node = right;
+            }
+        }
+        memmove(&node->keys[index + 1], &node->keys[index], sizeof(Object*) * (node->count - index));
+        memmove(&node->values[index + 1], &node->values[index], sizeof(Object*) * (node->count - index));
+        node->keys[index] = adopt ? (Object*)key.obj : object_ref((Object*)key.obj);
+        node->values[index] = value;
+        node->count++;
+        map->size++;
+        if (right != NULL)
+            *separator = object_ref(right->keys[0]);
+        return right;
+    }
+
+    u32 index = tree_upper_bound(node, key);
+    Object* child_separator;
+    _TreeNode* child_right = tree_insert(map, node->children[index], key, value, adopt, &child_separator);
+    if (child_right == NULL)
+        return NULL;
+    _TreeNode* right = NULL;
+    if (node->count == _TREE_ORDER) {
+        right = tree_split_inner(map, node, separator);
+        if (index > node->count) {
+            index -= node->count + 1;
+            node = right;
+        }
+    }
+    memmove(&node->keys[index + 1], &node->keys[index], sizeof(Object*) * (node->count - index));
+    memmove(&node->children[index + 2], &node->children[index + 1], sizeof(_TreeNode*) * (node->count - index));
+    node->keys[index] = child_separator;
+    node->children[index + 1] = child_right;
+    node->count++;
+    return right;
+}
+
+// Moves the last item of the left sibling into the underfull child at index
+static void tree_borrow_left(_TreeNode* parent, u32 index) {
+    _TreeNode* child = parent->children[index];
+    _TreeNode* left = parent->children[index - 1];
+    memmove(&child->keys[1], &child->keys[0], sizeof(Object*) * child->count);
+    if (child->leaf) {
+        memmove(&child->values[1], &child->values[0], sizeof(Object*) * child->count);
+        child->keys[0] = left->keys[left->count - 1];
+        child->values[0] = left->values[left->count - 1];
+        object_free(parent->keys[index - 1]);
+        parent->keys[index - 1] = object_ref(child->keys[0]);
+    } else {
+        memmove(&child->children[1], &child->children[0], sizeof(_TreeNode*) * (child->count + 1));
+        child->keys[0] = parent->keys[index - 1];
+        child->children[0] = left->children[left->count];
+        parent->keys[index - 1] = left->keys[left->count - 1];
+    }
+    left->count--;
+    child->count++;
+}
+
+// Moves the first item of the right sibling into the underfull child at index
+static void tree_borrow_right(_TreeNode* parent, u32 index) {
+    _TreeNode* child = parent->children[index];
+    _TreeNode* right = parent->children[index + 1];
+    if (child->leaf) {
+        child->keys[child->count] = right->keys[0];
+        child->values[child->count] = right->values[0];
+        memmove(&right->keys[0], &right->keys[1], sizeof(Object*) * (right->count - 1));
+        memmove(&right->values[0], &right->values[1], sizeof(Object*) * (right->count - 1));
+        object_free(parent->keys[index]);
+        parent->keys[index] = object_ref(right->keys[0]);
+    } else {
+        child->keys[child->count] = parent->keys[index];
+        child->children[child->count + 1] = right->children[0];
+        parent->keys[index] = right->keys[0];
+        memmove(&right->keys[0], &right->keys[1], sizeof(Object*) * (right->count - 1));
+        memmove(&right->children[0], &right->children[1], sizeof(_TreeNode*) * right->count);
+    }
+    right->count--;
+    child->count++;
+}
+
+// Merges the child right of index into the child at index
+static void tree_merge(TreeMap* map, _TreeNode* parent, u32 index) {
+    _TreeNode* left = parent->children[index];
+    _TreeNode* right = parent->children[index + 1];
+    if (left->leaf) {
+        memcpy(&left->keys[left->count], right->keys, sizeof(Object*) * right->count);
+        memcpy(&left->values[left->count], right->values, sizeof(Object*) * right->count);
+        left->count += right->count;
+        left->next = right->next;
+        if (left->next != NULL)
+            left->next->prev = left;
+        object_free(parent->keys[index]);
+    } else {
+        left->keys[left->count] = parent->keys[index];
+        memcpy(&left->keys[left->count + 1], right->keys, sizeof(Object*) * right->count);
+        memcpy(&left->children[left->count + 1], right->children, sizeof(_TreeNode*) * (right->count + 1));
+        left->count += right->count + 1;
+    }
+    memmove(&parent->keys[index], &parent->keys[index + 1], sizeof(Object*) * (parent->count - index - 1));
+    memmove(&parent->children[index + 1], &parent->children[index + 2],
+            sizeof(_TreeNode*) * (parent->count - index - 1));
+    parent->count--;
+    tree_node_release(map, right);
+}
+
+static bool tree_remove(TreeMap* map, _TreeNode* node, IComparable key) {
+    if (node->leaf) {
+        u32 index = tree_lower_bound(node, key);
+        if (index >= node->count || tree_compare(key, node->keys[index]) != 0)
+            return false;
+        Object* removed_key = node->keys[index];
+        Object* removed_value = node->values[index];
+        memmove(&node->keys[index], &node->keys[index + 1], sizeof(Object*) * (node->count - index - 1));
+        memmove(&node->values[index], &node->values[index + 1], sizeof(Object*) * (node->count - index - 1));
+        node->count--;
+        map->size--;
+        object_free(removed_key);
+        if (removed_value != NULL)
+            object_free(removed_value);
+        return true;
+    }
+
+    u32 index = tree_upper_bound(node, key);
+    if (!tree_remove(map, node->children[index], key))
+        return false;
+    if (node->children[index]->count < _TREE_MIN) {
+        // Refill the underfull child from a sibling with items to spare, otherwise merge them
+        if (index > 0 && node->children[index - 1]->count > _TREE_MIN)
+            tree_borrow_left(node, index);
+        else if (index < node->count && node->children[index + 1]->count > _TREE_MIN)
+            tree_borrow_right(node, index);
+        else
+            tree_merge(map, node, index > 0 ? index - 1 : index);
+    }
+    return true;
+}
+
+// TreeMap
+void TreeMap::init() {
+    Object::init();
+    this->root = tree_node_new(this, true);
+}
+
+void TreeMap::init_from_sorted(List* keys, List* values) {
+    Object::init();
+    // Keys out of order, or repeated, are inserted one by one instead
+    bool sorted = true;
+    for (usize i = 1; i < keys->size && sorted; i++)
+        sorted = tree_compare(cast<IComparable>(keys->items[i - 1]), keys->items[i]) < 0;
+    if (!sorted) {
+        this->root = tree_node_new(this, true);
+        for (usize i = 0; i < keys->size; i++) {
+            Object* value = values != NULL ? values->items[i] : NULL;
+            tree_map_set(this, cast<IComparable>(keys->items[i]), value != NULL ? object_ref(value) : NULL);
+        }
+        return;
+    }
+
+    // Items end up owned by both the lists and the map
+    for (usize i = 0; i < keys->size; i++) {
+        object_ref(keys->items[i]);
+        if (values != NULL && values->items[i] != NULL)
+            object_ref(values->items[i]);
+    }
+    this->root = tree_build(this, keys->items, values != NULL ? values->items : NULL, keys->size);
+    this->size = keys->size;
+}
+
+void TreeMap::deinit() {
+    tree_node_free(this, this->root);
+    Object::deinit();
+}
+
+Self* TreeMap::promote() {
+    if (!_object_in_arena(this))
+        return (TreeMap*)object_ref(this);
+    TreeMap* copy = (TreeMap*)Object::promote();
+    Object** keys = malloc(sizeof(Object*) * (this->size + 1));
+    Object** values = malloc(sizeof(Object*) * (this->size + 1));
+    usize i = 0;
+    for (_TreeNode* leaf = tree_first_leaf(this); leaf != NULL; leaf = leaf->next) {
+        for (u32 j = 0; j < leaf->count; j++, i++) {
+            keys[i] = object_promote(leaf->keys[j]);
+            values[i] = leaf->values[j] != NULL ? object_promote(leaf->values[j]) : NULL;
+        }
+    }
+    copy->root = tree_build(copy, keys, values, this->size);
+    free(keys);
+    free(values);
+    return copy;
+}
+
+Object* TreeMap::get(IComparable key) {
+    _TreeNode* leaf = tree_find_leaf(this, key);
+    u32 index = tree_lower_bound(leaf, key);
+    if (index < leaf->count && tree_compare(key, leaf->keys[index]) == 0)
+        return leaf->values[index];
+    return NULL;
+}
+
+bool TreeMap::contains(IComparable key) {
+    _TreeNode* leaf = tree_find_leaf(this, key);
+    u32 index = tree_lower_bound(leaf, key);
+    return index < leaf->count && tree_compare(key, leaf->keys[index]) == 0;
+}
+
+static void tree_put(TreeMap* map, IComparable key, Object* value, bool adopt) {
+    Object* separator;
+    _TreeNode* right = tree_insert(map, map->root, key, value, adopt, &separator);
+    if (right != NULL) {
+        _TreeNode* root = tree_node_new(map, false);
+        root->count = 1;
+        root->keys[0] = separator;
+        root->children[0] = map->root;
+        root->children[1] = right;
+        map->root = root;
+    }
+}
+
+void TreeMap::set(IComparable key, Object* value) {
+    tree_put(this, key, value, false);
+}
+
+void TreeMap::set_move(IComparable key, Object* value) {
+    tree_put(this, key, value, true);
+}
+
+void TreeMap::remove(IComparable key) {
+    tree_remove(this, this->root, key);
+    if (!this->root->leaf && this->root->count == 0) {
+        _TreeNode* root = this->root;
+        this->root = root->children[0];
+        tree_node_release(this, root);
+    }
+}
+
+Object* TreeMap::first_key() {
+    _TreeNode* leaf = tree_first_leaf(this);
+    return leaf->count > 0 ? leaf->keys[0] : NULL;
+}
+
+Object* TreeMap::last_key() {
+    _TreeNode* node = this->root;
+    while (!node->leaf)
+        node = node->children[node->count];
+    return node->count > 0 ? node->keys[node->count - 1] : NULL;
+}
+
+Object* TreeMap::floor(IComparable key) {
+    // Keys in the leaf before are below the separator that led here, so below key
+    _TreeNode* leaf = tree_find_leaf(this, key);
+    u32 index = tree_upper_bound(leaf, key);
+    if (index > 0)
+        return leaf->keys[index - 1];
+    return leaf->prev != NULL ? leaf->prev->keys[leaf->prev->count - 1] : NULL;
+}
+
+Object* TreeMap::ceiling(IComparable key) {
+    _TreeNode* leaf = tree_find_leaf(this, key);
+    u32 index = tree_lower_bound(leaf, key);
+    if (index < leaf->count)
+        return leaf->keys[index];
+    return leaf->next != NULL ? leaf->next->keys[0] : NULL;
+}
+
+TreeMapRange* TreeMap::range(Object* low, Object* high) {
+    return tree_map_range_new(this, low, high);
+}
+
+void TreeMap::foreach(TreeMapForeachFn* fn, void* context) {
+    for (_TreeNode* leaf = tree_first_leaf(this); leaf != NULL; leaf = leaf->next) {
+        for (u32 i = 0; i < leaf->count; i++)
+            fn(leaf->keys[i], leaf->values[i], context);
+    }
+}
+
+void TreeMap::foreach_range(Object* low, Object* high, TreeMapForeachFn* fn, void* context) {
+    _TreeNode* leaf = tree_first_leaf(this);
+    u32 index = 0;
+    if (low != NULL) {
+        IComparable key = cast<IComparable>(low);
+        leaf = tree_find_leaf(this, key);
+        index = tree_lower_bound(leaf, key);
+    }
+    IComparable end = high != NULL ? cast<IComparable>(high) : (IComparable){0};
+    for (; leaf != NULL; leaf = leaf->next, index = 0) {
+        for (; index < leaf->count; index++) {
+            if (high != NULL && tree_compare(end, leaf->keys[index]) <= 0)
+                return;
+            fn(leaf->keys[index], leaf->values[index], context);
+        }
+    }
+}
+
+IIterator TreeMap::iterator() {
+    return cast<IIterator>(tree_map_iterator_new(this, NULL, NULL));
+}
+
+// TreeMapRange
+void TreeMapRange::init(TreeMap* map, Object* low, Object* high) {
+    Object::init();
+    this->map = tree_map_ref(map);
+    this->low = low != NULL ? object_ref(low) : NULL;
+    this->high = high != NULL ? object_ref(high) : NULL;
+}
+
+void TreeMapRange::deinit() {
+    tree_map_free(this->map);
+    if (this->low != NULL)
+        object_free(this->low);
+    if (this->high != NULL)
+        object_free(this->high);
+    Object::deinit();
+}
+
+IIterator TreeMapRange::iterator() {
+    return cast<IIterator>(tree_map_iterator_new(this->map, this->low, this->high));
+}
+
+// TreeMapIterator
+void TreeMapIterator::init(TreeMap* map, Object* low, Object* high) {
+    Object::init();
+    this->leaf = tree_first_leaf(map);
+    this->index = 0;
+    if (low != NULL) {
+        IComparable key = cast<IComparable>(low);
+        this->leaf = tree_find_leaf(map, key);
+        this->index = tree_lower_bound(this->leaf, key);
+    }
+    if (this->index == this->leaf->count) {
+        this->leaf = this->leaf->next;
+        this->index = 0;
+    }
+    this->high = high != NULL ? cast<IComparable>(high) : (IComparable){0};
+}
+
+bool TreeMapIterator::has_next() {
+    if (this->leaf == NULL)
+        return false;
+    return this->high.obj == NULL || tree_compare(this->high, this->leaf->keys[this->index]) > 0;
+}
+
+Object* TreeMapIterator::next() {
+    Object* key = this->leaf->keys[this->index++];
+    if (this->index == this->leaf->count) {
+        this->leaf = this->leaf->next;
+        this->index = 0;
+    }
+    return key;
+}
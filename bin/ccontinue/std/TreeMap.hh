@@ -0,0 +1,60 @@
+/*
+ * Copyright (c) 2026 Bastiaan van der Plaat
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include "List.hh"
+
+typedef void TreeMapForeachFn(Object* key, Object* value, void* context);
+
+typedef struct _TreeNode _TreeNode;
+typedef struct TreeMapRange TreeMapRange;
+
+// Ordered map of IComparable keys: a B+ tree with wide nodes, keys stored contiguously per
+// node and linked leaves for in-order scans
+class TreeMap : IIterable {
+    _TreeNode* root;
+    @get usize size = 0;
+
+    void init();
+    void init_from_sorted(List* keys, List* values);
+    virtual void deinit();
+    virtual Self* promote();
+    Object* get(IComparable key);
+    bool contains(IComparable key);
+    void set(IComparable key, Object* value);
+    void set_move(IComparable key, Object* value);
+    void remove(IComparable key);
+    Object* first_key();
+    Object* last_key();
+    Object* floor(IComparable key);
+    Object* ceiling(IComparable key);
+    TreeMapRange* range(Object* low, Object* high);
+    void foreach(TreeMapForeachFn* fn, void* context);
+    void foreach_range(Object* low, Object* high, TreeMapForeachFn* fn, void* context);
+    virtual IIterator iterator();
+};
+
+// Keys in [low, high) of a map, a NULL bound is open. Keeps the map alive but copies nothing
+class TreeMapRange : IIterable {
+    @get TreeMap* map;
+    Object* low;
+    Object* high;
+
+    void init(TreeMap* map, Object* low, Object* high);
+    virtual void deinit();
+    virtual IIterator iterator();
+};
+
+class TreeMapIterator : IIterator {
+    _TreeNode* leaf;
+    u32 index;
+    IComparable high;
+
+    void init(TreeMap* map, Object* low, Object* high);
+    virtual bool has_next();
+    virtual Object* next();
+};
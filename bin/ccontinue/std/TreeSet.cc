@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) 2026 Bastiaan van der Plaat
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <TreeSet.hh>
+
+void TreeSet::init() {
+    Object::init();
+    this->map = tree_map_new();
+}
+
+void TreeSet::init_from_sorted(List* keys) {
+    Object::init();
+    this->map = tree_map_new_from_sorted(keys, NULL);
+}
+
+void TreeSet::deinit() {
+    tree_map_free(this->map);
+    Object::deinit();
+}
+
+Self* TreeSet::promote() {
+    if (!_object_in_arena(this))
+        return (TreeSet*)object_ref(this);
+    TreeSet* copy = (TreeSet*)Object::promote();
+    copy->map = tree_map_promote(this->map);
+    return copy;
+}
+
+usize TreeSet::get_size() {
+    return tree_map_get_size(this->map);
+}
+
+bool TreeSet::contains(IComparable key) {
+    return tree_map_contains(this->map, key);
+}
+
+void TreeSet::add(IComparable key) {
+    tree_map_set(this->map, key, NULL);
+}
+
+void TreeSet::add_move(IComparable key) {
+    tree_map_set_move(this->map, key, NULL);
+}
+
+void TreeSet::remove(IComparable key) {
+    tree_map_remove(this->map, key);
+}
+
+Object* TreeSet::first() {
+    return tree_map_first_key(this->map);
+}
+
+Object* TreeSet::last() {
+    return tree_map_last_key(this->map);
+}
+
+Object* TreeSet::floor(IComparable key) {
+    return tree_map_floor(this->map, key);
+}
+
+Object* TreeSet::ceiling(IComparable key) {
+    return tree_map_ceiling(this->map, key);
+}
+
+TreeMapRange* TreeSet::range(Object* low, Object* high) {
+    return tree_map_range_new(this->map, low, high);
+}
+
+IIterator TreeSet::iterator() {
+    return cast<IIterator>(tree_map_iterator_new(this->map, NULL, NULL));
+}
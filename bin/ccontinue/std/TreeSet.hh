@@ -0,0 +1,30 @@
+/*
+ * Copyright (c) 2026 Bastiaan van der Plaat
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include "TreeMap.hh"
+
+// Ordered set of IComparable keys, a TreeMap with all values NULL
+class TreeSet : IIterable {
+    @get TreeMap* map;
+
+    void init();
+    void init_from_sorted(List* keys);
+    virtual void deinit();
+    virtual Self* promote();
+    usize get_size();
+    bool contains(IComparable key);
+    void add(IComparable key);
+    void add_move(IComparable key);
+    void remove(IComparable key);
+    Object* first();
+    Object* last();
+    Object* floor(IComparable key);
+    Object* ceiling(IComparable key);
+    TreeMapRange* range(Object* low, Object* high);
+    virtual IIterator iterator();
+};
@@ -0,0 +1,119 @@
+/*
+ * Copyright (c) 2026 Bastiaan van der Plaat
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include "Object.hh"
+
+// Dense growable array of unboxed values, items are stored by value and never freed
+class Vec<T> {
+    T* items;
+    @get usize capacity = 8;
+    @get usize size = 0;
+
+    void init();
+    void init_with_capacity(usize capacity);
+    virtual void deinit();
+    virtual Self* promote();
+    T* data();
+    T get(usize index);
+    void set(usize index, T item);
+    void add(T item);
+    void insert(usize index, T item);
+    T remove(usize index);
+    T pop();
+    void clear();
+    void reserve(usize capacity);
+    void shrink_to_fit();
+};
+
+void Vec<T>::init() {
+    Object::init();
+    this->items = _object_buffer_alloc(this, sizeof(T) * this->capacity);
+}
+
+void Vec<T>::init_with_capacity(usize capacity) {
+    Object::init();
+    this->capacity = capacity > 0 ? capacity : 1;
+    this->items = _object_buffer_alloc(this, sizeof(T) * this->capacity);
+}
+
+void Vec<T>::deinit() {
+    _object_buffer_free(this, this->items);
+    Object::deinit();
+}
+
+Self* Vec<T>::promote() {
+    if (!_object_in_arena(this))
+        return (Vec<T>*)object_ref(this);
+    Vec<T>* copy = (Vec<T>*)Object::promote();
+    copy->items = malloc(sizeof(T) * copy->capacity);
+    memcpy(copy->items, this->items, sizeof(T) * copy->size);
+    return copy;
+}
+
+T* Vec<T>::data() {
+    return this->items;
+}
+
+T Vec<T>::get(usize index) {
+    return this->items[index];
+}
+
+void Vec<T>::set(usize index, T item) {
+    this->items[index] = item;
+}
+
+void Vec<T>::add(T item) {
+    if (this->size == this->capacity) {
+        this->items = _object_buffer_realloc(this, this->items, sizeof(T) * this->capacity,
+                                             sizeof(T) * this->capacity * 2);
+        this->capacity *= 2;
+    }
+    this->items[this->size++] = item;
+}
+
+void Vec<T>::insert(usize index, T item) {
+    if (this->size == this->capacity) {
+        this->items = _object_buffer_realloc(this, this->items, sizeof(T) * this->capacity,
+                                             sizeof(T) * this->capacity * 2);
+        this->capacity *= 2;
+    }
+    memmove(&this->items[index + 1], &this->items[index], sizeof(T) * (this->size - index));
+    this->items[index] = item;
+    this->size++;
+}
+
+T Vec<T>::remove(usize index) {
+    T item = this->items[index];
+    memmove(&this->items[index], &this->items[index + 1], sizeof(T) * (this->size - index - 1));
+    this->size--;
+    return item;
+}
+
+T Vec<T>::pop() {
+    return this->items[--this->size];
+}
+
+void Vec<T>::clear() {
+    this->size = 0;
+}
+
+void Vec<T>::reserve(usize capacity) {
+    if (capacity > this->capacity) {
+        this->items = _object_buffer_realloc(this, this->items, sizeof(T) * this->capacity, sizeof(T) * capacity);
+        this->capacity = capacity;
+    }
+}
+
+void Vec<T>::shrink_to_fit() {
+    // Arena buffers are only released with their arena
+    usize capacity = this->size > 0 ? this->size : 1;
+    if (_object_in_arena(this) || capacity == this->capacity)
+        return;
+    this->items = realloc(this->items, sizeof(T) * capacity);
+    this->capacity = capacity;
+}
@@ -4,8 +4,26 @@
  * SPDX-License-Identifier: MIT
  */
 
+#ifdef CCC_TRACK_ALLOCS
+#define _GNU_SOURCE // dladdr()
+#endif
+
 #include "prelude.h"
 
+#if defined(CCC_RANDOM_HASH_SEED) || defined(CCC_BENCH) || defined(CCC_PROFILE)
+#include <time.h>
+#endif
+#ifdef CCC_BENCH
+#include <math.h>
+#endif
+
+#ifdef CCC_TRACK_ALLOCS
+#include <signal.h>
+#if defined(__unix__) || defined(__APPLE__)
+#include <dlfcn.h>
+#endif
+#endif
+
 char* strdup(const char* s) {
     char* n = malloc(strlen(s) + 1);
     strcpy(n, s);
@@ -21,3 +39,1069 @@ u32 fnv1a_32(const void* data, usize length) {
     }
     return hash;
 }
+
+// wyhash (final version 4) with the default secret
+static const u64 _wyp[4] = {0x2d358dccaa6c78a5ull, 0x8bb84b93962eacc9ull, 0x4b33a62ed433d4a3ull,
+                            0x4d5a2da51de1aa47ull};
+
+static inline void _wymum(u64* a, u64* b) {
+#if defined(__SIZEOF_INT128__)
+    __extension__ typedef unsigned __int128 u128;
+    u128 r = (u128)*a * *b;
+    *a = (u64)r;
+    *b = (u64)(r >> 64);
+#else
+    u64 ha = *a >> 32, hb = *b >> 32, la = (u32)*a, lb = (u32)*b;
+    u64 rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb, t = rl + (rm0 << 32);
+    u64 c = t < rl;
+    u64 lo = t + (rm1 << 32);
+    c += lo < t;
+    *a = lo;
+    *b = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+#endif
+}
+
+static inline u64 _wymix(u64 a, u64 b) {
+    _wymum(&a, &b);
+    return a ^ b;
+}
+
+static inline u64 _wyr8(const u8* p) {
+    u64 v;
+    memcpy(&v, p, 8);
+    return v;
+}
+
+static inline u64 _wyr4(const u8* p) {
+    u32 v;
+    memcpy(&v, p, 4);
+    return v;
+}
+
+static inline u64 _wyr3(const u8* p, usize k) {
+    return ((u64)p[0] << 16) | ((u64)p[k >> 1] << 8) | p[k - 1];
+}
+
+u64 wyhash(const void* data, usize length, u64 seed) {
+    const u8* p = data;
+    u64 a, b;
+    seed ^= _wymix(seed ^ _wyp[0], _wyp[1]);
+    if (length <= 16) {
+        if (length >= 4) {
+            a = (_wyr4(p) << 32) | _wyr4(p + ((length >> 3) << 2));
+            b = (_wyr4(p + length - 4) << 32) | _wyr4(p + length - 4 - ((length >> 3) << 2));
+        } else if (length > 0) {
+            a = _wyr3(p, length);
+            b = 0;
+        } else {
+            a = b = 0;
+        }
+    } else {
+        usize i = length;
+        if (i >= 48) {
+            u64 see1 = seed, see2 = seed;
+            do {
+                seed = _wymix(_wyr8(p) ^ _wyp[1], _wyr8(p + 8) ^ seed);
+                see1 = _wymix(_wyr8(p + 16) ^ _wyp[2], _wyr8(p + 24) ^ see1);
+                see2 = _wymix(_wyr8(p + 32) ^ _wyp[3], _wyr8(p + 40) ^ see2);
+                p += 48;
+                i -= 48;
+            } while (i >= 48);
+            seed ^= see1 ^ see2;
+        }
+        while (i > 16) {
+            seed = _wymix(_wyr8(p) ^ _wyp[1], _wyr8(p + 8) ^ seed);
+            i -= 16;
+            p += 16;
+        }
+        a = _wyr8(p + i - 16);
+        b = _wyr8(p + i - 8);
+    }
+    a ^= _wyp[1];
+    b ^= seed;
+    _wymum(&a, &b);
+    return _wymix(a ^ _wyp[0] ^ length, b ^ _wyp[1]);
+}
+
+// Process hash seed: fixed by default, random per process when built with CCC_RANDOM_HASH_SEED
+#ifdef CCC_RANDOM_HASH_SEED
+static _Atomic u64 _hash_seed = 0;
+
+u64 hash_seed(void) {
+    u64 seed = atomic_load_explicit(&_hash_seed, memory_order_relaxed);
+    if (seed != 0)
+        return seed;
+    // Clock plus stack, heap and code addresses, which differ per run with ASLR
+    void* heap = malloc(1);
+    u64 entropy[5] = {(u64)time(NULL), (u64)clock(), (u64)(uintptr_t)&seed, (u64)(uintptr_t)heap,
+                      (u64)(uintptr_t)&hash_seed};
+    free(heap);
+    u64 candidate = wyhash(entropy, sizeof(entropy), 0) | 1;
+    // Every thread must agree on the seed, the first one to publish wins
+    if (!atomic_compare_exchange_strong(&_hash_seed, &seed, candidate))
+        return seed;
+    return candidate;
+}
+#else
+u64 hash_seed(void) {
+    return 0x9e3779b97f4a7c15ull;
+}
+#endif
+
+u32 hash_bytes(const void* data, usize length) {
+    return (u32)wyhash(data, length, hash_seed());
+}
+
+u32 hash_u64(u64 value) {
+    // One wyhash multiply-mix, enough to spread sequential integers over the low bits used by probing
+    return (u32)_wymix(value ^ hash_seed() ^ _wyp[0], _wyp[1]);
+}
+
+// String kernels
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define _STR_SIMD
+#define _STR_MASK_SHIFT 0 // One mask bit per byte
+
+typedef __m128i _str_vec;
+static inline _str_vec _str_load(const char* ptr) {
+    return _mm_loadu_si128((const __m128i*)ptr);
+}
+static inline void _str_store(char* ptr, _str_vec v) {
+    _mm_storeu_si128((__m128i*)ptr, v);
+}
+static inline _str_vec _str_splat(char c) {
+    return _mm_set1_epi8(c);
+}
+static inline _str_vec _str_eq(_str_vec a, _str_vec b) {
+    return _mm_cmpeq_epi8(a, b);
+}
+static inline _str_vec _str_and(_str_vec a, _str_vec b) {
+    return _mm_and_si128(a, b);
+}
+static inline u64 _str_mask(_str_vec eq) {
+    return (u64)(u32)_mm_movemask_epi8(eq);
+}
+static inline _str_vec _str_flip_case(_str_vec v, char lo, char hi) {
+    // Signed compares, so bytes >= 0x80 are never in range
+    _str_vec in_range = _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8((char)(lo - 1))),
+                                      _mm_cmplt_epi8(v, _mm_set1_epi8((char)(hi + 1))));
+    return _mm_xor_si128(v, _mm_and_si128(in_range, _mm_set1_epi8(0x20)));
+}
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define _STR_SIMD
+#define _STR_MASK_SHIFT 2 // Four mask bits per byte, NEON has no movemask
+
+typedef uint8x16_t _str_vec;
+static inline _str_vec _str_load(const char* ptr) {
+    return vld1q_u8((const u8*)ptr);
+}
+static inline void _str_store(char* ptr, _str_vec v) {
+    vst1q_u8((u8*)ptr, v);
+}
+static inline _str_vec _str_splat(char c) {
+    return vdupq_n_u8((u8)c);
+}
+static inline _str_vec _str_eq(_str_vec a, _str_vec b) {
+    return vceqq_u8(a, b);
+}
+static inline _str_vec _str_and(_str_vec a, _str_vec b) {
+    return vandq_u8(a, b);
+}
+static inline u64 _str_mask(_str_vec eq) {
+    return vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(eq), 4)), 0);
+}
+static inline _str_vec _str_flip_case(_str_vec v, char lo, char hi) {
+    _str_vec in_range = vandq_u8(vcgeq_u8(v, vdupq_n_u8((u8)lo)), vcleq_u8(v, vdupq_n_u8((u8)hi)));
+    return veorq_u8(v, vandq_u8(in_range, vdupq_n_u8(0x20)));
+}
+#endif
+
+#ifdef _STR_SIMD
+#define _STR_LANE_MASK (((u64)1 << (1 << _STR_MASK_SHIFT)) - 1)
+#define _str_mask_first(mask) ((usize)__builtin_ctzll(mask) >> _STR_MASK_SHIFT)
+#endif
+
+isize _str_find_byte(const char* data, usize length, char c) {
+    usize i = 0;
+#ifdef _STR_SIMD
+    _str_vec splat = _str_splat(c);
+    for (; i + 16 <= length; i += 16) {
+        u64 mask = _str_mask(_str_eq(_str_load(data + i), splat));
+        if (mask != 0)
+            return (isize)(i + _str_mask_first(mask));
+    }
+#endif
+    for (; i < length; i++)
+        if (data[i] == c)
+            return (isize)i;
+    return -1;
+}
+
+usize _str_count_byte(const char* data, usize length, char c) {
+    usize count = 0;
+    usize i = 0;
+#ifdef _STR_SIMD
+    _str_vec splat = _str_splat(c);
+    for (; i + 16 <= length; i += 16)
+        count += (usize)__builtin_popcountll(_str_mask(_str_eq(_str_load(data + i), splat))) >> _STR_MASK_SHIFT;
+#endif
+    for (; i < length; i++)
+        count += data[i] == c;
+    return count;
+}
+
+isize _str_find(const char* data, usize length, const char* needle, usize needle_length) {
+    if (needle_length == 0)
+        return 0;
+    if (needle_length > length)
+        return -1;
+    if (needle_length == 1)
+        return _str_find_byte(data, length, needle[0]);
+    usize starts = length - needle_length + 1;
+    usize i = 0;
+#ifdef _STR_SIMD
+    // Candidates must match the first and last needle byte, only those are verified with memcmp
+    _str_vec first = _str_splat(needle[0]);
+    _str_vec last = _str_splat(needle[needle_length - 1]);
+    for (; i + 16 <= starts; i += 16) {
+        u64 mask = _str_mask(_str_and(_str_eq(_str_load(data + i), first),
+                                      _str_eq(_str_load(data + i + needle_length - 1), last)));
+        while (mask != 0) {
+            usize j = _str_mask_first(mask);
+            if (memcmp(data + i + j + 1, needle + 1, needle_length - 2) == 0)
+                return (isize)(i + j);
+            mask &= ~(_STR_LANE_MASK << (j << _STR_MASK_SHIFT));
+        }
+    }
+#endif
+    while (i < starts) {
+        const char* found = memchr(data + i, needle[0], starts - i);
+        if (found == NULL)
+            return -1;
+        i = (usize)(found - data);
+        if (memcmp(data + i + 1, needle + 1, needle_length - 1) == 0)
+            return (isize)i;
+        i++;
+    }
+    return -1;
+}
+
+void _str_ascii_upper(char* dst, const char* src, usize length) {
+    usize i = 0;
+#ifdef _STR_SIMD
+    for (; i + 16 <= length; i += 16)
+        _str_store(dst + i, _str_flip_case(_str_load(src + i), 'a', 'z'));
+#endif
+    for (; i < length; i++)
+        dst[i] = src[i] >= 'a' && src[i] <= 'z' ? (char)(src[i] - 0x20) : src[i];
+}
+
+void _str_ascii_lower(char* dst, const char* src, usize length) {
+    usize i = 0;
+#ifdef _STR_SIMD
+    for (; i + 16 <= length; i += 16)
+        _str_store(dst + i, _str_flip_case(_str_load(src + i), 'A', 'Z'));
+#endif
+    for (; i < length; i++)
+        dst[i] = src[i] >= 'A' && src[i] <= 'Z' ? (char)(src[i] + 0x20) : src[i];
+}
+
+// Linear probing
+usize _linear_probe_capacity(usize count) {
+    usize capacity = 8;
+    while (capacity * 3 / 4 < count)
+        capacity <<= 1;
+    return capacity;
+}
+
+void _linear_probe_remove(_FatPointer* keys, u32* hashes, void** values, usize capacity, usize index) {
+    // Shift later entries of the cluster back into the hole unless that would move
+    // them before their home slot, no rehashing needed thanks to the stored hashes
+    usize mask = capacity - 1;
+    usize hole = index;
+    for (usize next = (index + 1) & mask; keys[next].obj != NULL; next = (next + 1) & mask) {
+        usize home = hashes[next] & mask;
+        if (((next - home) & mask) >= ((next - hole) & mask)) {
+            keys[hole] = keys[next];
+            hashes[hole] = hashes[next];
+            if (values != NULL)
+                values[hole] = values[next];
+            hole = next;
+        }
+    }
+    keys[hole].obj = NULL;
+    if (values != NULL)
+        values[hole] = NULL;
+}
+
+// Pool allocator
+#define _POOL_GRANULE 16
+#define _POOL_CLASSES 16
+#define _POOL_SLAB_SIZE (64 * 1024)
+
+typedef struct _PoolBlock {
+    struct _PoolBlock* next;
+} _PoolBlock;
+
+// Slabs are chained through their first block so they stay reachable for leak checkers
+static _Thread_local _PoolBlock* _pool_slabs = NULL;
+static _Thread_local _PoolBlock* _pool_free_lists[_POOL_CLASSES];
+
+void* _pool_alloc(usize size) {
+    usize index = (size + _POOL_GRANULE - 1) / _POOL_GRANULE - 1;
+    if (index >= _POOL_CLASSES)
+        return malloc(size);
+
+    if (_pool_free_lists[index] == NULL) {
+        // Carve a fresh slab into blocks of this size class
+        usize block_size = (index + 1) * _POOL_GRANULE;
+        u8* slab = malloc(_POOL_SLAB_SIZE);
+        ((_PoolBlock*)slab)->next = _pool_slabs;
+        _pool_slabs = (_PoolBlock*)slab;
+        for (usize offset = _POOL_GRANULE; offset + block_size <= _POOL_SLAB_SIZE; offset += block_size) {
+            _PoolBlock* block = (_PoolBlock*)(slab + offset);
+            block->next = _pool_free_lists[index];
+            _pool_free_lists[index] = block;
+        }
+    }
+
+    _PoolBlock* block = _pool_free_lists[index];
+    _pool_free_lists[index] = block->next;
+    return block;
+}
+
+void _pool_free(void* ptr, usize size) {
+    usize index = (size + _POOL_GRANULE - 1) / _POOL_GRANULE - 1;
+    if (index >= _POOL_CLASSES) {
+        free(ptr);
+        return;
+    }
+    _PoolBlock* block = ptr;
+    block->next = _pool_free_lists[index];
+    _pool_free_lists[index] = block;
+}
+
+// Arena
+#define _ARENA_CHUNK_SIZE (64 * 1024)
+#define _ARENA_HEADER_SIZE 16
+#define _ARENA_LARGE_SIZE (_ARENA_CHUNK_SIZE / 4)
+
+// Chunks are aligned to their size so an object can find its arena by masking its address
+typedef struct _ArenaChunk {
+    struct _ArenaChunk* next;
+    Arena* arena;
+} _ArenaChunk;
+
+// Objects that arena_free() deinits, newest first
+typedef struct _ArenaDeinit {
+    struct _ArenaDeinit* next;
+    void* obj;
+    void (*deinit)(void* obj);
+} _ArenaDeinit;
+
+struct Arena {
+    Arena* parent;
+    _ArenaChunk* chunks;
+    _PoolBlock* large;
+    _ArenaDeinit* deinits;
+    u8* cursor;
+    u8* end;
+};
+
+static _Thread_local Arena* _arena_current = NULL;
+
+Arena* arena_new(void) {
+    Arena* arena = calloc(1, sizeof(Arena));
+    arena->parent = _arena_current;
+    _arena_current = arena;
+    return arena;
+}
+
+void arena_free(Arena* arena) {
+    if (_arena_current == arena)
+        _arena_current = arena->parent;
+    // Deinits release heap children and the buffers of arena objects before their memory goes
+    for (_ArenaDeinit* entry = arena->deinits; entry != NULL; entry = entry->next)
+        entry->deinit(entry->obj);
+    _ArenaChunk* chunk = arena->chunks;
+    while (chunk != NULL) {
+        _ArenaChunk* next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+    _PoolBlock* large = arena->large;
+    while (large != NULL) {
+        _PoolBlock* next = large->next;
+        free(large);
+        large = next;
+    }
+    free(arena);
+}
+
+Arena* arena_current(void) {
+    return _arena_current;
+}
+
+Arena* _arena_suspend(void) {
+    Arena* arena = _arena_current;
+    _arena_current = NULL;
+    return arena;
+}
+
+void _arena_resume(Arena* arena) {
+    _arena_current = arena;
+}
+
+void* arena_alloc(Arena* arena, usize size) {
+    size = (size + 15) & ~(usize)15;
+    if (size > _ARENA_LARGE_SIZE) {
+        u8* large = malloc(_ARENA_HEADER_SIZE + size);
+        ((_PoolBlock*)large)->next = arena->large;
+        arena->large = (_PoolBlock*)large;
+        return large + _ARENA_HEADER_SIZE;
+    }
+    if (arena->cursor == NULL || arena->cursor + size > arena->end) {
+        _ArenaChunk* chunk = aligned_alloc(_ARENA_CHUNK_SIZE, _ARENA_CHUNK_SIZE);
+        chunk->next = arena->chunks;
+        chunk->arena = arena;
+        arena->chunks = chunk;
+        arena->cursor = (u8*)chunk + _ARENA_HEADER_SIZE;
+        arena->end = (u8*)chunk + _ARENA_CHUNK_SIZE;
+    }
+    void* ptr = arena->cursor;
+    arena->cursor += size;
+    return ptr;
+}
+
+// Object allocation
+static Arena* _object_arena(void* obj) {
+    if (!_object_in_arena(obj))
+        return NULL;
+    return ((_ArenaChunk*)((uintptr_t)obj & ~(uintptr_t)(_ARENA_CHUNK_SIZE - 1)))->arena;
+}
+
+void _arena_defer_deinit(void* obj, void (*deinit)(void* obj)) {
+    Arena* arena = _object_arena(obj);
+    _ArenaDeinit* entry = arena_alloc(arena, sizeof(_ArenaDeinit));
+    entry->obj = obj;
+    entry->deinit = deinit;
+    entry->next = arena->deinits;
+    arena->deinits = entry;
+}
+
+#ifdef CCC_TRACK_ALLOCS
+// Every heap object is preceded by a header that links it into the list of live objects
+typedef struct _TrackHeader {
+    struct _TrackHeader* prev;
+    struct _TrackHeader* next;
+    const _VtblHeader* vtbl;
+    const void* site;
+} _TrackHeader;
+#define _TRACK_HEADER_SIZE sizeof(_TrackHeader)
+#else
+#define _TRACK_HEADER_SIZE 0
+#endif
+
+static void* _object_heap_alloc(usize size, bool pool) {
+    _BENCH_COUNT_ALLOC();
+    u8* block = pool ? _pool_alloc(size + _TRACK_HEADER_SIZE) : malloc(size + _TRACK_HEADER_SIZE);
+#ifdef CCC_TRACK_ALLOCS
+    // Untracked until _track_add(), unlinking it is harmless
+    _TrackHeader* header = (_TrackHeader*)block;
+    header->prev = header;
+    header->next = header;
+    header->vtbl = NULL;
+#endif
+    return block + _TRACK_HEADER_SIZE;
+}
+
+void* _object_alloc(usize size, bool pool) {
+    _ObjectHeader* obj;
+    if (_arena_current != NULL && size <= _ARENA_LARGE_SIZE) {
+        _BENCH_COUNT_ALLOC();
+        obj = arena_alloc(_arena_current, size);
+        atomic_init(&obj->refs, _ARENA_REFS | 1);
+    } else {
+        obj = _object_heap_alloc(size, pool);
+        atomic_init(&obj->refs, 1);
+    }
+    return obj;
+}
+
+#ifdef CCC_TRACK_ALLOCS
+typedef struct _TrackStats {
+    const _VtblHeader* vtbl;
+    usize live;
+    usize peak;
+    usize total;
+    usize arena;
+} _TrackStats;
+
+// Open addressing by vtbl address, classes past the capacity go uncounted
+#define _TRACK_CLASSES 1024
+
+// One spinlock guards the live list and the counters, objects may be freed on another thread
+static atomic_flag _track_lock = ATOMIC_FLAG_INIT;
+static _TrackHeader _track_live = {&_track_live, &_track_live, NULL, NULL};
+static _TrackStats _track_stats[_TRACK_CLASSES];
+static bool _track_started = false;
+
+static void _track_acquire(void) {
+    while (atomic_flag_test_and_set_explicit(&_track_lock, memory_order_acquire)) {
+    }
+}
+
+static void _track_release(void) {
+    atomic_flag_clear_explicit(&_track_lock, memory_order_release);
+}
+
+static _TrackStats* _track_stats_of(const _VtblHeader* vtbl) {
+    usize index = ((uintptr_t)vtbl >> 4) & (_TRACK_CLASSES - 1);
+    for (usize i = 0; i < _TRACK_CLASSES; i++, index = (index + 1) & (_TRACK_CLASSES - 1)) {
+        if (_track_stats[index].vtbl == vtbl)
+            return &_track_stats[index];
+        if (_track_stats[index].vtbl == NULL) {
+            _track_stats[index].vtbl = vtbl;
+            return &_track_stats[index];
+        }
+    }
+    return NULL;
+}
+
+static int _track_compare_stats(const void* a, const void* b) {
+    // Most live bytes first, then most allocations
+    const _TrackStats* sa = *(_TrackStats* const*)a;
+    const _TrackStats* sb = *(_TrackStats* const*)b;
+    usize bytes_a = sa->live * sa->vtbl->size, bytes_b = sb->live * sb->vtbl->size;
+    if (bytes_a != bytes_b)
+        return bytes_a < bytes_b ? 1 : -1;
+    return (sa->total < sb->total) - (sa->total > sb->total);
+}
+
+static int _track_compare_headers(const void* a, const void* b) {
+    const _TrackHeader* ha = *(_TrackHeader* const*)a;
+    const _TrackHeader* hb = *(_TrackHeader* const*)b;
+    if (ha->vtbl != hb->vtbl)
+        return (uintptr_t)ha->vtbl < (uintptr_t)hb->vtbl ? -1 : 1;
+    return ((uintptr_t)ha->site > (uintptr_t)hb->site) - ((uintptr_t)ha->site < (uintptr_t)hb->site);
+}
+
+static void _track_print_site(const void* site) {
+#if defined(__unix__) || defined(__APPLE__)
+    Dl_info info;
+    if (dladdr(site, &info) != 0) {
+        if (info.dli_sname != NULL) {
+            fprintf(stderr, "%s+0x%zx", info.dli_sname, (usize)((uintptr_t)site - (uintptr_t)info.dli_saddr));
+            return;
+        }
+        if (info.dli_fname != NULL) {
+            const char* name = strrchr(info.dli_fname, '/');
+            fprintf(stderr, "%s+0x%zx", name != NULL ? name + 1 : info.dli_fname,
+                    (usize)((uintptr_t)site - (uintptr_t)info.dli_fbase));
+            return;
+        }
+    }
+#endif
+    fprintf(stderr, "%p", site);
+}
+
+#define _TRACK_MAX_SITES 32
+
+void _object_track_report(void) {
+    _track_acquire();
+    _TrackStats* rows[_TRACK_CLASSES];
+    usize row_count = 0;
+    for (usize i = 0; i < _TRACK_CLASSES; i++) {
+        if (_track_stats[i].vtbl != NULL)
+            rows[row_count++] = &_track_stats[i];
+    }
+    qsort(rows, row_count, sizeof(_TrackStats*), _track_compare_stats);
+    fprintf(stderr, "[ccc] Allocations by class\n");
+    fprintf(stderr, "%-24s %10s %12s %10s %12s %10s %10s\n", "Class", "Live", "Live bytes", "Peak", "Peak bytes",
+            "Total", "Arena");
+    usize live = 0, live_bytes = 0;
+    for (usize i = 0; i < row_count; i++) {
+        _TrackStats* stats = rows[i];
+        fprintf(stderr, "%-24s %10zu %12zu %10zu %12zu %10zu %10zu\n", stats->vtbl->class_name, stats->live,
+                stats->live * stats->vtbl->size, stats->peak, stats->peak * stats->vtbl->size, stats->total,
+                stats->arena);
+        live += stats->live;
+        live_bytes += stats->live * stats->vtbl->size;
+    }
+
+    // Live objects grouped by class and call site
+    if (live > 0) {
+        fprintf(stderr, "[ccc] %zu live objects (%zu bytes) by allocation site\n", live, live_bytes);
+        _TrackHeader** headers = malloc(sizeof(_TrackHeader*) * live);
+        usize count = 0;
+        for (_TrackHeader* header = _track_live.next; header != &_track_live && count < live; header = header->next)
+            headers[count++] = header;
+        qsort(headers, count, sizeof(_TrackHeader*), _track_compare_headers);
+        usize sites = 0;
+        for (usize i = 0; i < count;) {
+            usize j = i + 1;
+            while (j < count && _track_compare_headers(&headers[i], &headers[j]) == 0)
+                j++;
+            if (sites++ < _TRACK_MAX_SITES) {
+                fprintf(stderr, "%10zu x %s from ", j - i, headers[i]->vtbl->class_name);
+                _track_print_site(headers[i]->site);
+                fprintf(stderr, "\n");
+            }
+            i = j;
+        }
+        if (sites > _TRACK_MAX_SITES)
+            fprintf(stderr, "%10s %zu more sites\n", "...", sites - _TRACK_MAX_SITES);
+        free(headers);
+    }
+    _track_release();
+}
+
+// The report allocates and locks, so the signal handler only asks for it and the next
+// tracked allocation or free prints it
+static volatile sig_atomic_t _track_report_requested = 0;
+
+#ifdef SIGUSR1
+static void _track_signal(int sig) {
+    (void)sig;
+    _track_report_requested = 1;
+}
+#endif
+
+static void _track_report_if_requested(void) {
+    if (_track_report_requested) {
+        _track_report_requested = 0;
+        _object_track_report();
+    }
+}
+
+static void _track_add(void* obj, const _VtblHeader* vtbl, const void* site) {
+    _track_acquire();
+    if (!_track_started) {
+        _track_started = true;
+        atexit(_object_track_report);
+#ifdef SIGUSR1
+        signal(SIGUSR1, _track_signal);
+#endif
+    }
+    _TrackStats* stats = _track_stats_of(vtbl);
+    if (_object_in_arena(obj)) {
+        // Freed with their arena, only counted
+        if (stats != NULL) {
+            stats->arena++;
+            stats->total++;
+        }
+    } else {
+        _TrackHeader* header = (_TrackHeader*)obj - 1;
+        header->vtbl = vtbl;
+        header->site = site;
+        header->prev = _track_live.prev;
+        header->next = &_track_live;
+        _track_live.prev->next = header;
+        _track_live.prev = header;
+        if (stats != NULL) {
+            stats->total++;
+            if (++stats->live > stats->peak)
+                stats->peak = stats->live;
+        }
+    }
+    _track_release();
+    _track_report_if_requested();
+}
+
+static void _track_remove(void* obj) {
+    _TrackHeader* header = (_TrackHeader*)obj - 1;
+    _track_acquire();
+    header->prev->next = header->next;
+    header->next->prev = header->prev;
+    if (header->vtbl != NULL) {
+        _TrackStats* stats = _track_stats_of(header->vtbl);
+        if (stats != NULL)
+            stats->live--;
+    }
+    _track_release();
+    _track_report_if_requested();
+}
+
+void* _object_alloc_tracked(const void* vtbl, usize size, bool pool, const void* site) {
+    void* obj = _object_alloc(size, pool);
+    _track_add(obj, vtbl, site);
+    return obj;
+}
+#endif
+
+// Promoted copies leave the arena, so they always come from the heap
+void* _object_alloc_heap(const void* vtbl) {
+    const _VtblHeader* header = vtbl;
+    _ObjectHeader* obj = _object_heap_alloc(header->size, header->pool);
+    atomic_init(&obj->refs, 1);
+#ifdef CCC_TRACK_ALLOCS
+    _track_add(obj, header, __builtin_return_address(0));
+#endif
+    return obj;
+}
+
+void _object_dealloc(void* obj) {
+    // Arena objects are deinit by arena_free(), their memory goes with the arena
+    if (_object_in_arena(obj))
+        return;
+    const _VtblHeader* vtbl = ((_ObjectHeader*)obj)->vtbl;
+#ifdef CCC_TRACK_ALLOCS
+    _track_remove(obj);
+#endif
+    u8* block = (u8*)obj - _TRACK_HEADER_SIZE;
+    if (vtbl->pool)
+        _pool_free(block, vtbl->size + _TRACK_HEADER_SIZE);
+    else
+        free(block);
+}
+
+void* _object_buffer_alloc(void* obj, usize size) {
+    _BENCH_COUNT_ALLOC();
+    Arena* arena = _object_arena(obj);
+    return arena != NULL ? arena_alloc(arena, size) : malloc(size);
+}
+
+void* _object_buffer_calloc(void* obj, usize count, usize size) {
+    _BENCH_COUNT_ALLOC();
+    Arena* arena = _object_arena(obj);
+    if (arena == NULL)
+        return calloc(count, size);
+    void* ptr = arena_alloc(arena, count * size);
+    memset(ptr, 0, count * size);
+    return ptr;
+}
+
+void* _object_buffer_realloc(void* obj, void* ptr, usize old_size, usize new_size) {
+    _BENCH_COUNT_ALLOC();
+    Arena* arena = _object_arena(obj);
+    if (arena == NULL)
+        return realloc(ptr, new_size);
+    void* new_ptr = arena_alloc(arena, new_size);
+    memcpy(new_ptr, ptr, MIN(old_size, new_size));
+    return new_ptr;
+}
+
+void _object_buffer_free(void* obj, void* ptr) {
+    if (!_object_in_arena(obj))
+        free(ptr);
+}
+
+// Method profiler
+#ifdef CCC_PROFILE
+// Sites past the capacity go uncounted, frames past the depth are counted but not timed
+#define _PROFILE_SITES 4096
+#define _PROFILE_DEPTH 256
+#define _PROFILE_MAX_ROWS 48
+
+typedef struct _ProfileCounters {
+    u64 calls;
+    u64 virtual_calls;
+    u64 interface_calls;
+    u64 self_ticks;
+    u64 total_ticks;
+    u32 active;
+} _ProfileCounters;
+
+struct _ProfileFrame {
+    u32 id;
+    u64 start;
+    u64 child_ticks;
+};
+
+// Every thread owns its counters and call stack, so counting needs no atomics, the
+// records stay alive after their thread exits and are summed by the report
+typedef struct _ProfileThread {
+    struct _ProfileThread* next;
+    usize depth;
+    _ProfileFrame frames[_PROFILE_DEPTH];
+    _ProfileCounters counters[_PROFILE_SITES];
+} _ProfileThread;
+
+_Thread_local u8 _profile_dispatch;
+static _Thread_local _ProfileThread* _profile_thread;
+
+// One spinlock guards the site table and the thread list
+static atomic_flag _profile_lock = ATOMIC_FLAG_INIT;
+static _ProfileSite* _profile_sites[_PROFILE_SITES];
+static u32 _profile_site_count;
+static _ProfileThread* _profile_threads;
+static u64 _profile_start_ticks;
+static f64 _profile_start_time;
+
+static void _profile_acquire(void) {
+    while (atomic_flag_test_and_set_explicit(&_profile_lock, memory_order_acquire)) {
+    }
+}
+
+static void _profile_release(void) {
+    atomic_flag_clear_explicit(&_profile_lock, memory_order_release);
+}
+
+// Cycle counter where the target has a cheap one, converted with the rate measured over the run
+static inline u64 _profile_ticks(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    return __builtin_ia32_rdtsc();
+#elif defined(__aarch64__)
+    u64 ticks;
+    __asm__ volatile("mrs %0, cntvct_el0" : "=r"(ticks));
+    return ticks;
+#else
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (u64)ts.tv_sec * 1000000000 + (u64)ts.tv_nsec;
+#endif
+}
+
+static f64 _profile_time(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (f64)ts.tv_sec + (f64)ts.tv_nsec / 1e9;
+}
+
+static u32 _profile_register(_ProfileSite* site) {
+    _profile_acquire();
+    u32 id = atomic_load_explicit(&site->id, memory_order_relaxed);
+    if (id == 0 && _profile_site_count < _PROFILE_SITES) {
+        _profile_sites[_profile_site_count++] = site;
+        id = _profile_site_count;
+        atomic_store_explicit(&site->id, id, memory_order_release);
+    }
+    _profile_release();
+    return id;
+}
+
+static _ProfileThread* _profile_thread_new(void) {
+    _ProfileThread* thread = calloc(1, sizeof(_ProfileThread));
+    _profile_acquire();
+    if (_profile_threads == NULL) {
+        _profile_start_ticks = _profile_ticks();
+        _profile_start_time = _profile_time();
+        atexit(_profile_report);
+    }
+    thread->next = _profile_threads;
+    _profile_threads = thread;
+    _profile_release();
+    _profile_thread = thread;
+    return thread;
+}
+
+_ProfileFrame* _profile_enter(_ProfileSite* site) {
+    u8 dispatch = _profile_dispatch;
+    _profile_dispatch = 0;
+    u32 id = atomic_load_explicit(&site->id, memory_order_acquire);
+    if (id == 0 && (id = _profile_register(site)) == 0)
+        return NULL;
+    _ProfileThread* thread = _profile_thread != NULL ? _profile_thread : _profile_thread_new();
+
+    _ProfileCounters* counters = &thread->counters[id - 1];
+    counters->calls++;
+    if (dispatch == 1)
+        counters->virtual_calls++;
+    else if (dispatch == 2)
+        counters->interface_calls++;
+    if (thread->depth == _PROFILE_DEPTH)
+        return NULL;
+    counters->active++;
+    _ProfileFrame* frame = &thread->frames[thread->depth++];
+    frame->id = id;
+    frame->child_ticks = 0;
+    frame->start = _profile_ticks();
+    return frame;
+}
+
+void _profile_exit(_ProfileFrame** frame_ptr) {
+    _ProfileFrame* frame = *frame_ptr;
+    if (frame == NULL)
+        return;
+    u64 elapsed = _profile_ticks() - frame->start;
+    _ProfileThread* thread = _profile_thread;
+    _ProfileCounters* counters = &thread->counters[frame->id - 1];
+    counters->self_ticks += elapsed - frame->child_ticks;
+    // Recursive calls add their total time once, at the outermost call
+    if (--counters->active == 0)
+        counters->total_ticks += elapsed;
+    thread->depth--;
+    if (thread->depth > 0)
+        thread->frames[thread->depth - 1].child_ticks += elapsed;
+}
+
+typedef struct _ProfileRow {
+    const char* name;
+    _ProfileCounters counters;
+} _ProfileRow;
+
+static int _profile_compare_names(const void* a, const void* b) {
+    return strcmp(((const _ProfileRow*)a)->name, ((const _ProfileRow*)b)->name);
+}
+
+static int _profile_compare_self(const void* a, const void* b) {
+    // Most self time first, then most calls
+    const _ProfileCounters* ca = &((const _ProfileRow*)a)->counters;
+    const _ProfileCounters* cb = &((const _ProfileRow*)b)->counters;
+    if (ca->self_ticks != cb->self_ticks)
+        return ca->self_ticks < cb->self_ticks ? 1 : -1;
+    return (ca->calls < cb->calls) - (ca->calls > cb->calls);
+}
+
+void _profile_report(void) {
+    _profile_acquire();
+    u32 site_count = _profile_site_count;
+    usize thread_count = 0;
+    _ProfileRow* rows = calloc(site_count + 1, sizeof(_ProfileRow));
+    for (u32 i = 0; i < site_count; i++)
+        rows[i].name = _profile_sites[i]->name;
+    // Threads still running are read as they are
+    for (_ProfileThread* thread = _profile_threads; thread != NULL; thread = thread->next) {
+        thread_count++;
+        for (u32 i = 0; i < site_count; i++) {
+            const _ProfileCounters* counters = &thread->counters[i];
+            rows[i].counters.calls += counters->calls;
+            rows[i].counters.virtual_calls += counters->virtual_calls;
+            rows[i].counters.interface_calls += counters->interface_calls;
+            rows[i].counters.self_ticks += counters->self_ticks;
+            rows[i].counters.total_ticks += counters->total_ticks;
+        }
+    }
+    f64 ns_per_tick = 1;
+    u64 ticks = _profile_ticks() - _profile_start_ticks;
+    if (ticks > 0)
+        ns_per_tick = (_profile_time() - _profile_start_time) * 1e9 / (f64)ticks;
+    _profile_release();
+
+    // Inline methods have a site in every file that calls them, merge them by name
+    qsort(rows, site_count, sizeof(_ProfileRow), _profile_compare_names);
+    usize row_count = 0;
+    u64 self_ticks = 0;
+    for (u32 i = 0; i < site_count; i++) {
+        if (rows[i].counters.calls == 0)
+            continue;
+        self_ticks += rows[i].counters.self_ticks;
+        if (row_count > 0 && strcmp(rows[row_count - 1].name, rows[i].name) == 0) {
+            _ProfileCounters* merged = &rows[row_count - 1].counters;
+            merged->calls += rows[i].counters.calls;
+            merged->virtual_calls += rows[i].counters.virtual_calls;
+            merged->interface_calls += rows[i].counters.interface_calls;
+            merged->self_ticks += rows[i].counters.self_ticks;
+            merged->total_ticks += rows[i].counters.total_ticks;
+        } else {
+            rows[row_count++] = rows[i];
+        }
+    }
+    qsort(rows, row_count, sizeof(_ProfileRow), _profile_compare_self);
+
+    fprintf(stderr, "[ccc] Profile by method, %zu threads\n", thread_count);
+    fprintf(stderr, "%-32s %12s %12s %12s %12s %12s %7s\n", "Method", "Calls", "Virtual", "Interface", "Self ms",
+            "Total ms", "Self %");
+    for (usize i = 0; i < row_count && i < _PROFILE_MAX_ROWS; i++) {
+        const _ProfileCounters* counters = &rows[i].counters;
+        fprintf(stderr, "%-32s %12llu %12llu %12llu %12.3f %12.3f %6.1f%%\n", rows[i].name,
+                (unsigned long long)counters->calls, (unsigned long long)counters->virtual_calls,
+                (unsigned long long)counters->interface_calls, (f64)counters->self_ticks * ns_per_tick / 1e6,
+                (f64)counters->total_ticks * ns_per_tick / 1e6,
+                self_ticks > 0 ? (f64)counters->self_ticks * 100 / (f64)self_ticks : 0);
+    }
+    if (row_count > _PROFILE_MAX_ROWS)
+        fprintf(stderr, "%-32s %zu more methods\n", "...", row_count - _PROFILE_MAX_ROWS);
+    free(rows);
+}
+#endif
+
+// Benchmark harness
+#ifdef CCC_BENCH
+#define _BENCH_SAMPLES 10
+#define _BENCH_SAMPLE_TIME 0.02
+
+volatile uintptr_t _bench_sink;
+_Atomic usize _bench_allocs;
+
+static f64 _bench_now(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (f64)ts.tv_sec + (f64)ts.tv_nsec / 1e9;
+}
+
+void bench_reset_timer(Bench* b) {
+    b->elapsed = 0;
+    b->allocs = 0;
+    if (b->running) {
+        b->start = _bench_now();
+        b->allocs_start = atomic_load_explicit(&_bench_allocs, memory_order_relaxed);
+    }
+}
+
+void bench_stop_timer(Bench* b) {
+    if (!b->running)
+        return;
+    b->elapsed += _bench_now() - b->start;
+    b->allocs += atomic_load_explicit(&_bench_allocs, memory_order_relaxed) - b->allocs_start;
+    b->running = false;
+}
+
+void bench_start_timer(Bench* b) {
+    if (b->running)
+        return;
+    b->allocs_start = atomic_load_explicit(&_bench_allocs, memory_order_relaxed);
+    b->start = _bench_now();
+    b->running = true;
+}
+
+static void _bench_call(const _BenchCase* bench_case, Bench* b, usize iterations) {
+    b->iterations = iterations;
+    b->elapsed = 0;
+    b->allocs = 0;
+    b->running = false;
+    bench_start_timer(b);
+    bench_case->fn(b);
+    bench_stop_timer(b);
+}
+
+static void _bench_run(const _BenchCase* bench_case) {
+    Bench b;
+
+    // Warm up, then grow the iteration count until one sample takes _BENCH_SAMPLE_TIME
+    _bench_call(bench_case, &b, 1);
+    usize iterations = 1;
+    for (;;) {
+        _bench_call(bench_case, &b, iterations);
+        if (b.elapsed >= _BENCH_SAMPLE_TIME || iterations >= 1000000000)
+            break;
+        f64 predicted = b.elapsed > 0 ? (f64)iterations * _BENCH_SAMPLE_TIME * 1.2 / b.elapsed : 1e9;
+        usize next = predicted > 1e9 ? 1000000000 : (usize)predicted;
+        iterations = MAX(iterations + 1, MIN(next, iterations * 100));
+    }
+
+    f64 samples[_BENCH_SAMPLES];
+    f64 mean = 0;
+    usize allocs = 0;
+    for (usize i = 0; i < _BENCH_SAMPLES; i++) {
+        _bench_call(bench_case, &b, iterations);
+        samples[i] = b.elapsed * 1e9 / (f64)iterations;
+        mean += samples[i];
+        allocs += b.allocs;
+    }
+    mean /= _BENCH_SAMPLES;
+    f64 variance = 0;
+    for (usize i = 0; i < _BENCH_SAMPLES; i++)
+        variance += (samples[i] - mean) * (samples[i] - mean);
+    f64 deviation = mean > 0 ? sqrt(variance / (_BENCH_SAMPLES - 1)) * 100 / mean : 0;
+
+    printf("%-32s %12zu %12.2f ns/op %6.1f%% %10.2f allocs/op\n", bench_case->name, iterations, mean, deviation,
+           (f64)allocs / ((f64)iterations * _BENCH_SAMPLES));
+    fflush(stdout);
+}
+
+int _bench_main(int argc, char** argv, const _BenchCase* cases, usize count) {
+    // Optional arguments select benchmarks by substring of their name
+    printf("%-32s %12s %18s %7s %20s\n", "Benchmark", "Iterations", "Time", "Stddev", "Allocations");
+    for (usize i = 0; i < count; i++) {
+        bool selected = argc <= 1;
+        for (int j = 1; j < argc && !selected; j++)
+            selected = strstr(cases[i].name, argv[j]) != NULL;
+        if (selected)
+            _bench_run(&cases[i]);
+    }
+    return EXIT_SUCCESS;
+}
+#endif
@@ -7,6 +7,7 @@
 #pragma once
 
 #include <ctype.h>
+#include <stdatomic.h>
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
@@ -37,8 +38,202 @@ char* strdup(const char* s);
 
 u32 fnv1a_32(const void* data, usize length);
 
+// wyhash: 64-bit word at a time hash of bytes with a seed
+u64 wyhash(const void* data, usize length, u64 seed);
+
+// Hashes used by the std library, seeded with the process hash seed
+u64 hash_seed(void);
+u32 hash_bytes(const void* data, usize length);
+u32 hash_u64(u64 value);
+
+// Length aware string kernels, vectorized with SSE2 or NEON when the target has them
+isize _str_find_byte(const char* data, usize length, char c);
+usize _str_count_byte(const char* data, usize length, char c);
+isize _str_find(const char* data, usize length, const char* needle, usize needle_length);
+void _str_ascii_upper(char* dst, const char* src, usize length);
+void _str_ascii_lower(char* dst, const char* src, usize length);
+
+// Hash and equality of unboxed values for the generic containers, pointers hash by identity
+static inline u32 _generic_hash_u64(u64 x) {
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+    return (u32)x;
+}
+
+static inline u32 _generic_hash_f64(f64 x) {
+    u64 bits;
+    if (x == 0.0)
+        x = 0.0; // -0.0 == 0.0
+    memcpy(&bits, &x, sizeof(bits));
+    return _generic_hash_u64(bits);
+}
+
+static inline u32 _generic_hash_ptr(const void* ptr) {
+    return _generic_hash_u64((u64)(uintptr_t)ptr);
+}
+
+#define _generic_hash(x)                                                                              \
+    _Generic((x),                                                                                     \
+        _Bool: _generic_hash_u64, char: _generic_hash_u64, signed char: _generic_hash_u64,           \
+        unsigned char: _generic_hash_u64, short: _generic_hash_u64, unsigned short: _generic_hash_u64, \
+        int: _generic_hash_u64, unsigned int: _generic_hash_u64, long: _generic_hash_u64,             \
+        unsigned long: _generic_hash_u64, long long: _generic_hash_u64,                               \
+        unsigned long long: _generic_hash_u64, float: _generic_hash_f64, double: _generic_hash_f64,    \
+        default: _generic_hash_ptr)(x)
+#define _generic_equals(a, b) ((a) == (b))
+
+// Pool allocator: size-class slabs with thread-local free lists
+void* _pool_alloc(usize size);
+void _pool_free(void* ptr, usize size);
+
+// Arena: bump allocator region, objects created while an arena is current are owned by it
+typedef struct Arena Arena;
+
+Arena* arena_new(void);
+void arena_free(Arena* arena);
+Arena* arena_current(void);
+void* arena_alloc(Arena* arena, usize size);
+
+// Detach the current arena so long-lived objects go to the heap, then restore it
+Arena* _arena_suspend(void);
+void _arena_resume(Arena* arena);
+
 // Internals
 typedef struct _InterfaceSlot {
     usize id;
     const void* vtbl;
 } _InterfaceSlot;
+
+// Every class vtbl starts with its interface table, laid out by the transpiler so each
+// interface id has its own slot at (id >> interface_shift) & interface_mask, followed by
+// the class ids of its ancestors indexed by depth, from Object down to the class itself,
+// and the allocation info of the class
+typedef struct _VtblHeader {
+    const _InterfaceSlot* interfaces;
+    u32 interface_mask;
+    u32 interface_shift;
+    const usize* classes;
+    usize class_depth;
+    usize size;
+    bool pool;
+    bool shared;
+    const char* class_name;
+} _VtblHeader;
+
+static inline const void* _interface_vtbl(const void* vtbl, usize id) {
+    const _VtblHeader* header = vtbl;
+    const _InterfaceSlot* slot = &header->interfaces[(id >> header->interface_shift) & header->interface_mask];
+    return slot->id == id ? slot->vtbl : NULL;
+}
+
+// Layout of every interface value: object pointer plus interface vtbl
+typedef struct _FatPointer {
+    void* obj;
+    const void* vtbl;
+} _FatPointer;
+
+// Smallest power of two capacity (at least 8) holding count entries below the 3/4 load factor
+usize _linear_probe_capacity(usize count);
+
+// Backward shift deletion shared by the linear probing Map and Set
+void _linear_probe_remove(_FatPointer* keys, u32* hashes, void** values, usize capacity, usize index);
+
+// refs is atomic so @shared objects can use locked increments, everything else does a
+// relaxed load and store which compiles to the same plain instructions as a usize
+typedef struct _ObjectHeader {
+    const void* vtbl;
+    _Atomic usize refs;
+} _ObjectHeader;
+
+// Arena owned objects carry this bit in refs so they never reach zero, objects of classes with
+// their own deinit are deinit by arena_free() instead so they release heap children and buffers
+#define _ARENA_REFS ((usize)1 << (sizeof(usize) * 8 - 1))
+#define _object_in_arena(obj) \
+    ((atomic_load_explicit(&((_ObjectHeader*)(obj))->refs, memory_order_relaxed) & _ARENA_REFS) != 0)
+
+void* _object_alloc(usize size, bool pool);
+void* _object_alloc_heap(const void* vtbl);
+void _object_dealloc(void* obj);
+void* _object_buffer_alloc(void* obj, usize size);
+void* _object_buffer_calloc(void* obj, usize count, usize size);
+void* _object_buffer_realloc(void* obj, void* ptr, usize old_size, usize new_size);
+void _object_buffer_free(void* obj, void* ptr);
+void _arena_defer_deinit(void* obj, void (*deinit)(void* obj));
+
+// Generated new() functions allocate through _object_new(). Built with CCC_TRACK_ALLOCS
+// (ccc --track-allocs) it counts live objects per class and remembers the call site of each
+#ifdef CCC_TRACK_ALLOCS
+void* _object_alloc_tracked(const void* vtbl, usize size, bool pool, const void* site);
+void _object_track_report(void);
+#define _object_new(vtbl, size, pool) _object_alloc_tracked((vtbl), (size), (pool), __builtin_return_address(0))
+#else
+#define _object_new(vtbl, size, pool) _object_alloc((size), (pool))
+#endif
+
+// Method profiler of ccc --profile, which builds with CCC_PROFILE: the transpiler opens every
+// method body with _PROFILE_METHOD() and marks vtbl and interface calls, each thread counts
+// calls, self time and total time per method and the totals are printed at exit
+#ifdef CCC_PROFILE
+typedef struct _ProfileSite {
+    const char* name;
+    _Atomic u32 id;
+} _ProfileSite;
+
+typedef struct _ProfileFrame _ProfileFrame;
+
+_ProfileFrame* _profile_enter(_ProfileSite* site);
+void _profile_exit(_ProfileFrame** frame);
+void _profile_report(void);
+
+// Kind of call that enters the next method, set by the call macros once the object and the
+// arguments are evaluated, right before the vtbl call, and read and cleared by _profile_enter()
+extern _Thread_local u8 _profile_dispatch;
+#define _PROFILE_VIRTUAL() (_profile_dispatch = 1)
+#define _PROFILE_INTERFACE() (_profile_dispatch = 2)
+
+#define _PROFILE_METHOD(name) \
+    static _ProfileSite _profile_site = {(name), 0}; \
+    _ProfileFrame* _profile_frame __attribute__((cleanup(_profile_exit), unused)) = _profile_enter(&_profile_site)
+#else
+#define _PROFILE_METHOD(name)
+#define _PROFILE_VIRTUAL() ((void)0)
+#define _PROFILE_INTERFACE() ((void)0)
+#endif
+
+// Benchmark harness of ccc --bench, which builds with CCC_BENCH and runs every
+// void bench_<name>(Bench* b) function of the file, each doing its work b->iterations times
+#ifdef CCC_BENCH
+typedef struct Bench {
+    usize iterations;
+    f64 start;
+    f64 elapsed;
+    usize allocs_start;
+    usize allocs;
+    bool running;
+} Bench;
+
+// Exclude setup from the measurement, the timer runs when a bench function is called
+void bench_reset_timer(Bench* b);
+void bench_stop_timer(Bench* b);
+void bench_start_timer(Bench* b);
+
+// Keep the compiler from optimizing away a result
+extern volatile uintptr_t _bench_sink;
+#define bench_use(value) (_bench_sink += (uintptr_t)(value))
+
+typedef struct _BenchCase {
+    const char* name;
+    void (*fn)(Bench* b);
+} _BenchCase;
+
+int _bench_main(int argc, char** argv, const _BenchCase* cases, usize count);
+
+// Object and container buffer allocations, counted for allocs/op
+extern _Atomic usize _bench_allocs;
+#define _BENCH_COUNT_ALLOC() atomic_fetch_add_explicit(&_bench_allocs, 1, memory_order_relaxed)
+#else
+#define _BENCH_COUNT_ALLOC() ((void)0)
+#endif
@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) 2026 Bastiaan van der Plaat
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#pragma once
+
+#include "prelude.h"
+
+// Swiss table control bytes: full slots store the top 7 hash bits, empty and
+// deleted slots have the high bit set so both can be found with one movemask
+#define _SWISS_GROUP 16
+#define _SWISS_EMPTY 0x80
+#define _SWISS_DELETED 0xfe
+
+#define _swiss_h2(hash) ((u8)((hash) >> 25))
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+
+typedef u32 _SwissMask;
+#define _SWISS_SHIFT 0
+
+static inline _SwissMask _swiss_match(const u8* group, u8 h2) {
+    __m128i ctrl = _mm_loadu_si128((const __m128i*)group);
+    return (_SwissMask)_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8((char)h2)));
+}
+
+static inline _SwissMask _swiss_match_empty(const u8* group) {
+    return _swiss_match(group, _SWISS_EMPTY);
+}
+
+static inline _SwissMask _swiss_match_empty_or_deleted(const u8* group) {
+    return (_SwissMask)_mm_movemask_epi8(_mm_loadu_si128((const __m128i*)group));
+}
+
+static inline usize _swiss_leading(_SwissMask mask) {
+    return (usize)__builtin_clz(mask) - 16;
+}
+
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+
+// NEON has no movemask: narrow to one nibble per byte and keep a single bit of each
+typedef u64 _SwissMask;
+#define _SWISS_SHIFT 2
+
+static inline _SwissMask _swiss_nibbles(uint8x16_t cmp) {
+    uint8x8_t narrowed = vshrn_n_u16(vreinterpretq_u16_u8(cmp), 4);
+    return vget_lane_u64(vreinterpret_u64_u8(narrowed), 0) & 0x8888888888888888ull;
+}
+
+static inline _SwissMask _swiss_match(const u8* group, u8 h2) {
+    return _swiss_nibbles(vceqq_u8(vld1q_u8(group), vdupq_n_u8(h2)));
+}
+
+static inline _SwissMask _swiss_match_empty(const u8* group) {
+    return _swiss_match(group, _SWISS_EMPTY);
+}
+
+static inline _SwissMask _swiss_match_empty_or_deleted(const u8* group) {
+    return _swiss_nibbles(vcltq_s8(vreinterpretq_s8_u8(vld1q_u8(group)), vdupq_n_s8(0)));
+}
+
+static inline usize _swiss_leading(_SwissMask mask) {
+    return (usize)__builtin_clzll(mask) >> _SWISS_SHIFT;
+}
+
+#else
+typedef u32 _SwissMask;
+#define _SWISS_SHIFT 0
+
+static inline _SwissMask _swiss_match(const u8* group, u8 h2) {
+    _SwissMask mask = 0;
+    for (usize i = 0; i < _SWISS_GROUP; i++)
+        mask |= (_SwissMask)(group[i] == h2) << i;
+    return mask;
+}
+
+static inline _SwissMask _swiss_match_empty(const u8* group) {
+    return _swiss_match(group, _SWISS_EMPTY);
+}
+
+static inline _SwissMask _swiss_match_empty_or_deleted(const u8* group) {
+    _SwissMask mask = 0;
+    for (usize i = 0; i < _SWISS_GROUP; i++)
+        mask |= (_SwissMask)(group[i] >> 7) << i;
+    return mask;
+}
+
+static inline usize _swiss_leading(_SwissMask mask) {
+    return (usize)__builtin_clz(mask) - 16;
+}
+#endif
+
+// Index of the lowest matching byte; clear it with mask &= mask - 1
+#define _swiss_first(mask) ((usize)__builtin_ctzll(mask) >> _SWISS_SHIFT)
+
+// Write a control byte, mirroring the first group after the end so groups can be loaded unaligned
+static inline void _swiss_set_ctrl(u8* ctrl, usize capacity, usize index, u8 value) {
+    ctrl[index] = value;
+    if (index < _SWISS_GROUP)
+        ctrl[capacity + index] = value;
+}
+
+// A deleted slot can become empty again when no probe window containing it was ever full
+static inline bool _swiss_can_empty(const u8* ctrl, usize capacity, usize index) {
+    usize index_before = (index - _SWISS_GROUP) & (capacity - 1);
+    _SwissMask empty_after = _swiss_match_empty(ctrl + index);
+    _SwissMask empty_before = _swiss_match_empty(ctrl + index_before);
+    return empty_before != 0 && empty_after != 0 &&
+           _swiss_leading(empty_before) + _swiss_first(empty_after) < _SWISS_GROUP;
+}
@@ -0,0 +1,27 @@
+// EXIT: 0
+// OUT: reused=true
+// OUT: sum=4950
+
+@pool class Particle {
+    @get @init i32 x;
+};
+
+int main(void) {
+    Particle* first = particle_new(0);
+    void* first_addr = first;
+    particle_free(first);
+    Particle* second = particle_new(1);
+    printf("reused=%s\n", (void*)second == first_addr ? "true" : "false");
+    particle_free(second);
+
+    Particle* particles[100];
+    for (i32 i = 0; i < 100; i++)
+        particles[i] = particle_new(i);
+    i32 sum = 0;
+    for (i32 i = 0; i < 100; i++) {
+        sum += particle_get_x(particles[i]);
+        particle_free(particles[i]);
+    }
+    printf("sum=%d\n", sum);
+    return EXIT_SUCCESS;
+}
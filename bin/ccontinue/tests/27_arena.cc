@@ -0,0 +1,44 @@
+// EXIT: 0
+// OUT: size=1000
+// OUT: filled=2
+// OUT: kept=item 42
+// OUT: names=Alice,Bob
+// OUT: outside=false
+
+#include <List.hh>
+#include <Map.hh>
+#include <String.hh>
+
+int main(void) {
+    Arena* arena = arena_new();
+    List* list = list_new();
+    for (i32 i = 0; i < 1000; i++) {
+        char buf[32];
+        snprintf(buf, sizeof(buf), "item %d", i);
+        list_add(list, string_new(buf));
+    }
+    printf("size=%zu\n", list_get_size(list));
+
+    Map* map = map_new();
+    map_set(map, cast<IKeyable>(@"a"), @"Alice");
+    map_set(map, cast<IKeyable>(@"b"), @"Bob");
+    printf("filled=%zu\n", map_get_filled(map));
+
+    // Promote objects that must outlive the arena
+    String* kept = string_promote((String*)list_get(list, 42));
+    List* names = list_new();
+    list_add(names, map_get(map, cast<IKeyable>(@"a")));
+    list_add(names, map_get(map, cast<IKeyable>(@"b")));
+    List* promoted = list_promote(names);
+    arena_free(arena);
+
+    printf("kept=%s\n", string_get_cstr(kept));
+    printf("names=%s,%s\n", string_get_cstr((String*)list_get(promoted, 0)),
+           string_get_cstr((String*)list_get(promoted, 1)));
+    String* outside = @"outside";
+    printf("outside=%s\n", arena_current() != NULL ? "true" : "false");
+    string_free(outside);
+    string_free(kept);
+    list_free(promoted);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,41 @@
+// EXIT: 0
+// OUT: same_hash=true
+// OUT: stable=true
+// OUT: equals=true
+// OUT: equals_prefix=false
+// OUT: equals_other=false
+// OUT: lookups=100
+
+#include <Map.hh>
+#include <String.hh>
+
+int main(void) {
+    String* a = @"a fairly long key used for hashing";
+    String* b = @"a fairly long key used for hashing";
+    String* prefix = @"a fairly long key";
+    String* other = @"a fairly long key used for hashinG";
+
+    u32 ha = string_hash(a);
+    printf("same_hash=%s\n", ha == string_hash(b) ? "true" : "false");
+    printf("stable=%s\n", ha == string_hash(a) ? "true" : "false");
+    printf("equals=%s\n", string_equals(a, (Object*)b) ? "true" : "false");
+    printf("equals_prefix=%s\n", string_equals(a, (Object*)prefix) ? "true" : "false");
+    string_hash(other);
+    printf("equals_other=%s\n", string_equals(a, (Object*)other) ? "true" : "false");
+
+    Map* map = map_new();
+    map_set(map, cast<IKeyable>(a), @"value");
+    i32 lookups = 0;
+    for (i32 i = 0; i < 100; i++) {
+        if (map_get(map, cast<IKeyable>(b)) != NULL)
+            lookups++;
+    }
+    printf("lookups=%d\n", lookups);
+
+    map_free(map);
+    string_free(a);
+    string_free(b);
+    string_free(prefix);
+    string_free(other);
+    return EXIT_SUCCESS;
+}
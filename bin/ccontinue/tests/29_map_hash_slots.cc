@@ -0,0 +1,62 @@
+// EXIT: 0
+// OUT: filled=100
+// OUT: hash_calls=100
+// OUT: found=100
+// OUT: set_size=100
+// OUT: set_hash_calls=200
+
+#include <Map.hh>
+#include <Set.hh>
+#include <String.hh>
+
+i32 hash_calls = 0;
+
+class Key : IEquatable, IHashable {
+    @get @init i32 id;
+
+    virtual bool equals(Object* other);
+    virtual u32 hash();
+};
+
+bool Key::equals(Object* other) {
+    return ((Key*)other)->id == this->id;
+}
+
+u32 Key::hash() {
+    hash_calls++;
+    return (u32)this->id * 2654435761u;
+}
+
+int main(void) {
+    Map* map = map_new();
+    for (i32 i = 0; i < 100; i++) {
+        Key* key = key_new(i);
+        map_set(map, cast<IKeyable>(key), @"value");
+        key_free(key);
+    }
+    // Growing the table reuses the stored hashes: one hash call per insert
+    printf("filled=%zu\n", map_get_filled(map));
+    printf("hash_calls=%d\n", hash_calls);
+
+    i32 found = 0;
+    for (i32 i = 0; i < 100; i++) {
+        Key* key = key_new(i);
+        if (map_get(map, cast<IKeyable>(key)) != NULL)
+            found++;
+        key_free(key);
+    }
+    printf("found=%d\n", found);
+    map_free(map);
+
+    hash_calls = 0;
+    Set* set = set_new();
+    for (i32 i = 0; i < 200; i++) {
+        Key* key = key_new(i % 100);
+        set_add(set, cast<IKeyable>(key));
+        key_free(key);
+    }
+    printf("set_size=%zu\n", set_get_size(set));
+    printf("set_hash_calls=%d\n", hash_calls);
+    set_free(set);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,60 @@
+// EXIT: 0
+// OUT: size=1000
+// OUT: get 500=500
+// OUT: replaced=-1
+// OUT: after remove size=500
+// OUT: found=500
+// OUT: set size=100
+// OUT: set contains 42=true
+// OUT: set removed 42=false
+
+#include <HashMap.hh>
+#include <HashSet.hh>
+
+int main(void) {
+    HashMap* map = hash_map_new();
+    for (i64 i = 0; i < 1000; i++) {
+        Int* key = int_new(i);
+        hash_map_set(map, cast<IKeyable>(key), (Object*)int_new(i));
+        int_free(key);
+    }
+    printf("size=%zu\n", hash_map_get_size(map));
+
+    Int* key = @500;
+    printf("get 500=%lld\n", (long long)int_get_value((Int*)hash_map_get(map, cast<IKeyable>(key))));
+    hash_map_set(map, cast<IKeyable>(key), (Object*)int_new(-1));
+    printf("replaced=%lld\n", (long long)int_get_value((Int*)hash_map_get(map, cast<IKeyable>(key))));
+    int_free(key);
+
+    // Remove the even keys, then check the odd keys survived the tombstones
+    for (i64 i = 0; i < 1000; i += 2) {
+        Int* k = int_new(i);
+        hash_map_remove(map, cast<IKeyable>(k));
+        int_free(k);
+    }
+    printf("after remove size=%zu\n", hash_map_get_size(map));
+    i32 found = 0;
+    for (i64 i = 0; i < 1000; i++) {
+        Int* k = int_new(i);
+        if (hash_map_get(map, cast<IKeyable>(k)) != NULL)
+            found++;
+        int_free(k);
+    }
+    printf("found=%d\n", found);
+    hash_map_free(map);
+
+    HashSet* set = hash_set_new();
+    for (i64 i = 0; i < 200; i++) {
+        Int* k = int_new(i % 100);
+        hash_set_add(set, cast<IKeyable>(k));
+        int_free(k);
+    }
+    printf("set size=%zu\n", hash_set_get_size(set));
+    Int* k42 = @42;
+    printf("set contains 42=%s\n", hash_set_contains(set, cast<IKeyable>(k42)) ? "true" : "false");
+    hash_set_remove(set, cast<IKeyable>(k42));
+    printf("set removed 42=%s\n", hash_set_contains(set, cast<IKeyable>(k42)) ? "true" : "false");
+    int_free(k42);
+    hash_set_free(set);
+    return EXIT_SUCCESS;
+}
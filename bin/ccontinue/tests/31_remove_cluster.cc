@@ -0,0 +1,72 @@
+// EXIT: 0
+// OUT: map found=7
+// OUT: map removed=false
+// OUT: set found=7
+// OUT: set removed=false
+// OUT: churn filled=3
+
+#include <Map.hh>
+#include <Set.hh>
+#include <String.hh>
+
+class Key : IEquatable, IHashable {
+    @get @init i32 id;
+
+    virtual bool equals(Object* other);
+    virtual u32 hash();
+};
+
+bool Key::equals(Object* other) {
+    return ((Key*)other)->id == this->id;
+}
+
+u32 Key::hash() {
+    // Every key collides so they all share one probe cluster
+    (void)this;
+    return 3;
+}
+
+int main(void) {
+    Key* keys[8];
+    for (i32 i = 0; i < 8; i++)
+        keys[i] = key_new(i);
+
+    Map* map = map_new();
+    Set* set = set_new();
+    for (i32 i = 0; i < 6; i++) {
+        map_set(map, cast<IKeyable>(keys[i]), @"value");
+        set_add(set, cast<IKeyable>(keys[i]));
+    }
+    map_remove(map, cast<IKeyable>(keys[0]));
+    set_remove(set, cast<IKeyable>(keys[0]));
+    map_set(map, cast<IKeyable>(keys[6]), @"value");
+    set_add(set, cast<IKeyable>(keys[6]));
+    map_set(map, cast<IKeyable>(keys[7]), @"value");
+    set_add(set, cast<IKeyable>(keys[7]));
+
+    // Keys after the removed slot must still be reachable
+    i32 map_found = 0;
+    i32 set_found = 0;
+    for (i32 i = 1; i < 8; i++) {
+        if (map_get(map, cast<IKeyable>(keys[i])) != NULL)
+            map_found++;
+        if (set_contains(set, cast<IKeyable>(keys[i])))
+            set_found++;
+    }
+    printf("map found=%d\n", map_found);
+    printf("map removed=%s\n", map_get(map, cast<IKeyable>(keys[0])) != NULL ? "true" : "false");
+    printf("set found=%d\n", set_found);
+    printf("set removed=%s\n", set_contains(set, cast<IKeyable>(keys[0])) ? "true" : "false");
+
+    for (i32 round = 0; round < 100; round++) {
+        map_remove(map, cast<IKeyable>(keys[1 + round % 7]));
+        map_set(map, cast<IKeyable>(keys[1 + (round + 3) % 7]), @"value");
+    }
+    printf("churn filled=%zu\n", map_get_filled(map));
+
+    map_free(map);
+    set_free(set);
+    for (i32 i = 0; i < 8; i++)
+        key_free(keys[i]);
+    return EXIT_SUCCESS;
+}
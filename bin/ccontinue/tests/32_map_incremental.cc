@@ -0,0 +1,76 @@
+// EXIT: 0
+// OUT: rehashing seen=true
+// OUT: found=2000
+// OUT: removed=1000
+// OUT: filled=2000 left=2000
+// OUT: updated=7
+// OUT: normal rehashing=false
+
+#include <Map.hh>
+#include <String.hh>
+
+int main(void) {
+    Map* map = map_new_incremental();
+    bool seen = false;
+    for (i64 i = 0; i < 2000; i++) {
+        Int* key = int_new(i);
+        map_set(map, cast<IKeyable>(key), int_new(i * 2));
+        int_free(key);
+        if (map_is_rehashing(map))
+            seen = true;
+    }
+    printf("rehashing seen=%s\n", seen ? "true" : "false");
+
+    i32 found = 0;
+    for (i64 i = 0; i < 2000; i++) {
+        Int* key = int_new(i);
+        Int* value = (Int*)map_get(map, cast<IKeyable>(key));
+        if (value != NULL && int_get_value(value) == i * 2)
+            found++;
+        int_free(key);
+    }
+    printf("found=%d\n", found);
+
+    // Grow again and remove while the migration is running
+    for (i64 i = 2000; i < 3000; i++) {
+        Int* key = int_new(i);
+        map_set(map, cast<IKeyable>(key), int_new(i * 2));
+        int_free(key);
+    }
+    i32 removed = 0;
+    for (i64 i = 0; i < 3000; i += 3) {
+        Int* key = int_new(i);
+        if (map_get(map, cast<IKeyable>(key)) != NULL)
+            removed++;
+        map_remove(map, cast<IKeyable>(key));
+        int_free(key);
+    }
+    printf("removed=%d\n", removed);
+    i32 left = 0;
+    for (i64 i = 0; i < 3000; i++) {
+        Int* key = int_new(i);
+        if (map_get(map, cast<IKeyable>(key)) != NULL)
+            left++;
+        int_free(key);
+    }
+    printf("filled=%zu left=%d\n", map_get_filled(map), left);
+
+    Int* key = int_new(5);
+    map_set(map, cast<IKeyable>(key), int_new(7));
+    printf("updated=%lld\n", (long long)int_get_value((Int*)map_get(map, cast<IKeyable>(key))));
+    int_free(key);
+    map_free(map);
+
+    Map* normal = map_new();
+    bool normal_seen = false;
+    for (i64 i = 0; i < 100; i++) {
+        Int* k = int_new(i);
+        map_set(normal, cast<IKeyable>(k), NULL);
+        int_free(k);
+        if (map_is_rehashing(normal))
+            normal_seen = true;
+    }
+    printf("normal rehashing=%s\n", normal_seen ? "true" : "false");
+    map_free(normal);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,76 @@
+// EXIT: 0
+// OUT: list capacity=100 size=0
+// OUT: list reserve=500 shrink=3
+// OUT: map capacity=1024 filled=0
+// OUT: map reserve=4096 shrink=8 found=5
+// OUT: set capacity=16 shrink=8 found=3
+// OUT: builder capacity=65 reserve=201 shrink=6 hello
+
+#include <List.hh>
+#include <Map.hh>
+#include <Set.hh>
+#include <StringBuilder.hh>
+
+int main(void) {
+    List* list = list_new_with_capacity(100);
+    printf("list capacity=%zu size=%zu\n", list_get_capacity(list), list_get_size(list));
+    list_reserve(list, 500);
+    usize reserved = list_get_capacity(list);
+    for (i64 i = 0; i < 3; i++)
+        list_add(list, int_new(i));
+    list_shrink_to_fit(list);
+    printf("list reserve=%zu shrink=%zu\n", reserved, list_get_capacity(list));
+    list_add(list, int_new(3));
+    list_free(list);
+
+    Map* map = map_new_with_capacity(700);
+    printf("map capacity=%zu filled=%zu\n", map_get_capacity(map), map_get_filled(map));
+    map_reserve(map, 3000);
+    reserved = map_get_capacity(map);
+    for (i64 i = 0; i < 5; i++) {
+        Int* key = int_new(i);
+        map_set(map, cast<IKeyable>(key), int_new(i));
+        int_free(key);
+    }
+    map_shrink_to_fit(map);
+    i32 found = 0;
+    for (i64 i = 0; i < 5; i++) {
+        Int* key = int_new(i);
+        if (map_get(map, cast<IKeyable>(key)) != NULL)
+            found++;
+        int_free(key);
+    }
+    printf("map reserve=%zu shrink=%zu found=%d\n", reserved, map_get_capacity(map), found);
+    map_free(map);
+
+    Set* set = set_new_with_capacity(10);
+    usize set_capacity = set_get_capacity(set);
+    for (i64 i = 0; i < 3; i++) {
+        Int* key = int_new(i);
+        set_add(set, cast<IKeyable>(key));
+        int_free(key);
+    }
+    set_shrink_to_fit(set);
+    found = 0;
+    for (i64 i = 0; i < 3; i++) {
+        Int* key = int_new(i);
+        if (set_contains(set, cast<IKeyable>(key)))
+            found++;
+        int_free(key);
+    }
+    printf("set capacity=%zu shrink=%zu found=%d\n", set_capacity, set_get_capacity(set), found);
+    set_free(set);
+
+    StringBuilder* sb = string_builder_new_with_capacity(64);
+    usize sb_capacity = string_builder_get_capacity(sb);
+    string_builder_reserve(sb, 200);
+    usize sb_reserved = string_builder_get_capacity(sb);
+    string_builder_append_cstr(sb, "hello");
+    string_builder_shrink_to_fit(sb);
+    String* str = string_builder_build(sb);
+    printf("builder capacity=%zu reserve=%zu shrink=%zu %s\n", sb_capacity, sb_reserved,
+           string_builder_get_capacity(sb), string_get_cstr(str));
+    string_free(str);
+    string_builder_free(sb);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,61 @@
+// EXIT: 0
+// OUT: insert=0 1 2 3 4
+// OUT: add_all=0 1 2 3 4 0 1 2 3 4 capacity=16
+// OUT: extend=8
+// OUT: remove_range=0 1 0 1 2 3 4
+// OUT: truncate=0 1 0
+// OUT: remove=1 0
+// OUT: set=5 capacity=16
+
+#include <List.hh>
+
+void print_list(char* label, List* list) {
+    printf("%s=", label);
+    for (usize i = 0; i < list_get_size(list); i++)
+        printf(i == 0 ? "%lld" : " %lld", (long long)int_get_value((Int*)list_get(list, i)));
+}
+
+int main(void) {
+    List* list = list_new();
+    list_add(list, int_new(1));
+    list_add(list, int_new(3));
+    list_insert(list, 0, int_new(0));
+    list_insert(list, 2, int_new(2));
+    list_insert(list, 4, int_new(4));
+    print_list("insert", list);
+    printf("\n");
+
+    List* copy = list_new();
+    list_add_all(copy, list);
+    list_add_all(copy, list);
+    print_list("add_all", copy);
+    printf(" capacity=%zu\n", list_get_capacity(copy));
+
+    List* extended = list_new();
+    list_extend(extended, cast<IIterable>(list));
+    list_extend(extended, cast<IIterable>(list));
+    list_remove_range(extended, 1, 2);
+    printf("extend=%zu\n", list_get_size(extended));
+    list_free(extended);
+
+    list_remove_range(copy, 2, 3);
+    list_remove_range(copy, 4, 0);
+    print_list("remove_range", copy);
+    printf("\n");
+    list_truncate(copy, 3);
+    list_truncate(copy, 10);
+    print_list("truncate", copy);
+    printf("\n");
+    list_remove(copy, 0);
+    print_list("remove", copy);
+    printf("\n");
+    list_free(copy);
+    list_free(list);
+
+    List* sparse = list_new();
+    list_set(sparse, 8, int_new(5));
+    printf("set=%lld capacity=%zu\n", (long long)int_get_value((Int*)list_get(sparse, 8)),
+           list_get_capacity(sparse));
+    list_free(sparse);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,109 @@
+// EXIT: 0
+// OUT: 1 2 3
+// OUT: sum=6
+// OUT: skip=1 3
+// OUT: grid=0 1 2 3
+// OUT: tagged=a b
+// OUT: reversed=b a
+
+#include <List.hh>
+#include <String.hh>
+
+class TaggedList : List {};
+
+// Overrides iterator(), so for-in can't walk it by index
+class ReversedList : List {
+    virtual IIterator iterator();
+};
+
+class ReversedIterator : IIterator {
+    @init List* list;
+    @init usize index;
+
+    virtual bool has_next();
+    virtual Object* next();
+};
+
+IIterator ReversedList::iterator() {
+    return cast<IIterator>(reversed_iterator_new((List*)this, list_get_size(this)));
+}
+
+bool ReversedIterator::has_next() {
+    return this->index > 0;
+}
+
+Object* ReversedIterator::next() {
+    return list_get(this->list, --this->index);
+}
+
+i64 sum_list(List* numbers) {
+    i64 sum = 0;
+    for (Int* number in numbers) {
+        sum += int_get_value(number);
+    }
+    return sum;
+}
+
+int main(void) {
+    List* numbers = list_new();
+    list_add(numbers, @1);
+    list_add(numbers, @2);
+    list_add(numbers, @3);
+    for (Int* number in numbers) {
+        printf(number == (Int*)list_get(numbers, 0) ? "%lld" : " %lld", (long long)int_get_value(number));
+    }
+    printf("\n");
+    printf("sum=%lld\n", (long long)sum_list(numbers));
+
+    // break and continue leave nothing to clean up
+    printf("skip=");
+    for (Int* number in numbers) {
+        if (int_get_value(number) == 2)
+            continue;
+        printf(int_get_value(number) == 1 ? "%lld" : " %lld", (long long)int_get_value(number));
+    }
+    printf("\n");
+    for (Int* number in numbers) {
+        if (int_get_value(number) == 1)
+            break;
+    }
+
+    List* grid = list_new();
+    for (i64 i = 0; i < 2; i++) {
+        List* row = list_new();
+        list_add(row, int_new(i * 2));
+        list_add(row, int_new(i * 2 + 1));
+        list_add(grid, row);
+    }
+    printf("grid=");
+    for (List* row in grid) {
+        for (Int* cell in row) {
+            printf(int_get_value(cell) == 0 ? "%lld" : " %lld", (long long)int_get_value(cell));
+        }
+    }
+    printf("\n");
+
+    TaggedList* tagged = tagged_list_new();
+    list_add(tagged, @"a");
+    list_add(tagged, @"b");
+    printf("tagged=");
+    for (String* tag in tagged) {
+        printf(tag == (String*)list_get(tagged, 0) ? "%s" : " %s", string_get_cstr(tag));
+    }
+    printf("\n");
+
+    ReversedList* reversed = reversed_list_new();
+    list_add(reversed, @"a");
+    list_add(reversed, @"b");
+    printf("reversed=");
+    for (String* item in reversed) {
+        printf(item == (String*)list_get(reversed, 1) ? "%s" : " %s", string_get_cstr(item));
+    }
+    printf("\n");
+
+    list_free(reversed);
+    list_free(tagged);
+    list_free(grid);
+    list_free(numbers);
+    return EXIT_SUCCESS;
+}
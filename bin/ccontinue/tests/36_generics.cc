@@ -0,0 +1,92 @@
+// EXIT: 0
+// OUT: vec sum=4950 size=100 capacity=128
+// OUT: vec remove=10 insert=7 pop=99
+// OUT: floats=0.5 1.5 2.5
+// OUT: names=Alice Bob
+// OUT: map size=1000 hit=499.5 miss=true
+// OUT: map removed=500 size=500 found=250
+// OUT: nested=3
+// OUT: pair=7 x
+
+#include <FlatMap.hh>
+#include <String.hh>
+#include <Vec.hh>
+
+class Pair<A, B> {
+    @get @init A first;
+    @get @init B second;
+
+    A swap_first(A value);
+};
+
+A Pair<A, B>::swap_first(A value) {
+    A old = this->first;
+    this->first = value;
+    return old;
+}
+
+int main(void) {
+    Vec<i64>* numbers = vec_i64_new();
+    for (i64 i = 0; i < 100; i++)
+        vec_i64_add(numbers, i);
+    i64 sum = 0;
+    for (usize i = 0; i < vec_i64_get_size(numbers); i++)
+        sum += vec_i64_get(numbers, i);
+    printf("vec sum=%lld size=%zu capacity=%zu\n", (long long)sum, vec_i64_get_size(numbers),
+           vec_i64_get_capacity(numbers));
+    i64 removed = vec_i64_remove(numbers, 10);
+    vec_i64_insert(numbers, 0, 7);
+    printf("vec remove=%lld insert=%lld pop=%lld\n", (long long)removed, (long long)vec_i64_get(numbers, 0),
+           (long long)vec_i64_pop(numbers));
+    vec_i64_free(numbers);
+
+    Vec<f64>* floats = vec_f64_new_with_capacity(2);
+    for (i32 i = 0; i < 3; i++)
+        vec_f64_add(floats, i + 0.5);
+    f64* data = vec_f64_data(floats);
+    printf("floats=%.1f %.1f %.1f\n", data[0], data[1], data[2]);
+    vec_f64_free(floats);
+
+    String* alice = @"Alice";
+    String* bob = @"Bob";
+    Vec<String*>* names = vec_string_ptr_new();
+    vec_string_ptr_add(names, alice);
+    vec_string_ptr_add(names, bob);
+    printf("names=%s %s\n", string_get_cstr(vec_string_ptr_get(names, 0)),
+           string_get_cstr(vec_string_ptr_get(names, 1)));
+    vec_string_ptr_free(names);
+    string_free(alice);
+    string_free(bob);
+
+    FlatMap<i64, f64>* map = flat_map_i64_f64_new();
+    for (i64 i = 0; i < 1000; i++)
+        flat_map_i64_f64_set(map, i, i * 0.5);
+    printf("map size=%zu hit=%.1f miss=%s\n", flat_map_i64_f64_get_size(map), *flat_map_i64_f64_get(map, 999),
+           flat_map_i64_f64_get(map, 5000) == NULL ? "true" : "false");
+    i32 removed_count = 0;
+    for (i64 i = 0; i < 1000; i += 2) {
+        if (flat_map_i64_f64_remove(map, i))
+            removed_count++;
+    }
+    i32 found = 0;
+    for (i64 i = 0; i < 1000; i += 2) {
+        if (flat_map_i64_f64_contains(map, i + 1) && i % 4 == 0)
+            found++;
+    }
+    printf("map removed=%d size=%zu found=%d\n", removed_count, flat_map_i64_f64_get_size(map), found);
+    flat_map_i64_f64_free(map);
+
+    Vec<Vec<i64>*>* rows = vec_vec_i64_ptr_new();
+    for (i32 i = 0; i < 3; i++)
+        vec_vec_i64_ptr_add(rows, vec_i64_new());
+    printf("nested=%zu\n", vec_vec_i64_ptr_get_size(rows));
+    for (usize i = 0; i < vec_vec_i64_ptr_get_size(rows); i++)
+        vec_i64_free(vec_vec_i64_ptr_get(rows, i));
+    vec_vec_i64_ptr_free(rows);
+
+    Pair<i32, char>* pair = pair_i32_char_new(3, 'x');
+    pair_i32_char_swap_first(pair, 7);
+    printf("pair=%d %c\n", pair_i32_char_get_first(pair), pair_i32_char_get_second(pair));
+    pair_i32_char_free(pair);
+    return EXIT_SUCCESS;
+}
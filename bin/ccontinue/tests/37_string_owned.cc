@@ -0,0 +1,52 @@
+// EXIT: 0
+// OUT: owned=hello length=5
+// OUT: take=ab length=2 builder=0
+// OUT: reuse=cd
+// OUT: derived=HELLO WORLD|hello world|Hello World|World
+// OUT: arena=xyz
+
+#include <StringBuilder.hh>
+
+int main(void) {
+    char* buffer = malloc(6);
+    memcpy(buffer, "hello", 6);
+    String* owned = string_new_owned(buffer, 5);
+    printf("owned=%s length=%zu\n", string_get_cstr(owned), string_get_length(owned));
+    string_free(owned);
+
+    StringBuilder* sb = string_builder_new();
+    string_builder_append_cstr(sb, "a");
+    string_builder_append_char(sb, 'b');
+    String* taken = string_builder_build_take(sb);
+    printf("take=%s length=%zu builder=%zu\n", string_get_cstr(taken), string_get_length(taken),
+           string_builder_get_length(sb));
+    string_builder_append_cstr(sb, "cd");
+    String* reused = string_builder_build_take(sb);
+    printf("reuse=%s\n", string_get_cstr(reused));
+    string_free(taken);
+    string_free(reused);
+    string_builder_free(sb);
+
+    String* text = @"  Hello World \n";
+    String* trimmed = string_trim(text);
+    String* upper = string_to_upper(trimmed);
+    String* lower = string_to_lower(trimmed);
+    String* word = string_substring(trimmed, 6, 100);
+    printf("derived=%s|%s|%s|%s\n", string_get_cstr(upper), string_get_cstr(lower), string_get_cstr(trimmed),
+           string_get_cstr(word));
+    string_free(word);
+    string_free(lower);
+    string_free(upper);
+    string_free(trimmed);
+    string_free(text);
+
+    Arena* arena = arena_new();
+    StringBuilder* arena_sb = string_builder_new();
+    string_builder_append_cstr(arena_sb, "xyz");
+    String* arena_str = string_builder_build_take(arena_sb);
+    String* kept = string_promote(arena_str);
+    arena_free(arena);
+    printf("arena=%s\n", string_get_cstr(kept));
+    string_free(kept);
+    return EXIT_SUCCESS;
+}
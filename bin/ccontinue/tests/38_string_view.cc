@@ -0,0 +1,70 @@
+// EXIT: 0
+// OUT: token=[GET] [/index.html] [200]
+// OUT: trim=[key: value] length=10 whole=14
+// OUT: rehash=1
+// OUT: search=1 1 0 5 -1
+// OUT: equals=1 1 0 hash=1
+// OUT: map=3 hits=2
+// OUT: copy=value
+
+#include <Map.hh>
+#include <StringView.hh>
+
+int main(void) {
+    String* line = @"GET /index.html 200";
+    StringView* method = string_slice(line, 0, 3);
+    StringView* path = string_slice(line, 4, 11);
+    StringView* status = string_slice(line, 16, 100);
+    printf("token=[%.*s] [%.*s] [%.*s]\n", (int)string_view_get_length(method), string_view_data(method),
+           (int)string_view_get_length(path), string_view_data(path), (int)string_view_get_length(status),
+           string_view_data(status));
+
+    String* padded = @"\t key: value \n";
+    StringView* whole = string_slice(padded, 0, string_get_length(padded));
+    u32 whole_hash = string_view_hash(whole);
+    StringView* pair = string_view_trim(whole);
+    printf("trim=[%.*s] length=%zu whole=%zu\n", (int)string_view_get_length(pair), string_view_data(pair),
+           string_view_get_length(pair), string_view_get_length(whole));
+    // Trimming leaves the original view and its cached hash alone
+    printf("rehash=%d\n", string_view_hash(whole) == whole_hash);
+    string_view_free(whole);
+    printf("search=%d %d %d %d %d\n", string_view_starts_with(pair, "key"), string_view_ends_with(pair, "value"),
+           string_view_contains(pair, "\n"), string_view_index_of(pair, "value"), string_view_index_of(pair, "zz"));
+
+    String* get = @"GET";
+    printf("equals=%d %d %d hash=%d\n", string_view_equals(method, (Object*)get), string_equals(get, (Object*)method),
+           string_view_equals(method, (Object*)path), string_view_hash(method) == string_hash(get));
+
+    Map* counts = map_new();
+    String* post = @"POST";
+    StringView* page = string_view_slice(path, 1, 5);
+    map_set(counts, cast<IKeyable>(get), (Object*)int_new(1));
+    map_set(counts, cast<IKeyable>(post), (Object*)int_new(2));
+    map_set(counts, cast<IKeyable>(page), (Object*)int_new(3));
+    String* index = @"index";
+    i32 hits = 0;
+    if (map_get(counts, cast<IKeyable>(method)) != NULL)
+        hits++;
+    if (map_get(counts, cast<IKeyable>(index)) != NULL)
+        hits++;
+    printf("map=%zu hits=%d\n", map_get_filled(counts), hits);
+    map_free(counts);
+    string_free(index);
+    string_view_free(page);
+    string_free(post);
+
+    StringView* value = string_view_slice(pair, 5, 100);
+    String* copy = string_view_to_string(value);
+    string_view_free(value);
+    string_view_free(pair);
+    string_free(padded);
+    printf("copy=%s\n", string_get_cstr(copy));
+
+    string_free(copy);
+    string_free(get);
+    string_view_free(status);
+    string_view_free(path);
+    string_view_free(method);
+    string_free(line);
+    return EXIT_SUCCESS;
+}
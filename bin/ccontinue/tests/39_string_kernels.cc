@@ -0,0 +1,57 @@
+// EXIT: 0
+// OUT: find=37 -1 0 39 -1
+// OUT: byte=16 -1 count=3
+// OUT: suffix=1 0 prefix=1 0
+// OUT: case=THE QUICK BROWN FOX JUMPS OVER 13 LAZY DOGS @[\]`{
+// OUT: case=the quick brown fox jumps over 13 lazy dogs @[\]`{ high=233
+// OUT: split=5 [a] [bb] [] [ccc] [d]
+// OUT: view=2 [x y] [z]
+
+#include <StringView.hh>
+
+static void print_parts(List* parts) {
+    for (usize i = 0; i < list_get_size(parts); i++) {
+        StringView* part = (StringView*)list_get(parts, i);
+        printf(" [%.*s]", (int)string_view_get_length(part), string_view_data(part));
+    }
+    printf("\n");
+}
+
+int main(void) {
+    String* text = @"aaaaaaaaaaaaaaaa,aaaaaaaaaaaaaaaaaaaaaneedle";
+    printf("find=%d %d %d %d %d\n", string_index_of(text, "aneedle"), string_index_of(text, "needles"),
+           string_index_of(text, ""), string_index_of(text, "eedle"), string_index_of(text, "aaaaaaaaaaaaaaaaaaaaaaaa"));
+    printf("byte=%d %d count=%zu\n", string_find_byte(text, ','), string_find_byte(text, '#'),
+           string_count_byte(text, 'e'));
+    printf("suffix=%d %d prefix=%d %d\n", string_ends_with(text, "needle"), string_ends_with(text, "needlex"),
+           string_starts_with(text, "aaaa"), string_starts_with(text, "b"));
+
+    String* mixed = @"The Quick Brown Fox Jumps Over 13 Lazy Dogs @[\\]`{\xe9";
+    String* upper = string_to_upper(mixed);
+    String* lower = string_to_lower(mixed);
+    usize last = string_get_length(lower) - 1;
+    printf("case=%.*s\n", (int)last, string_get_cstr(upper));
+    printf("case=%.*s high=%d\n", (int)last, string_get_cstr(lower), (u8)string_get_cstr(lower)[last]);
+
+    String* csv = @"a,bb,,ccc,d";
+    List* parts = string_split(csv, ',');
+    printf("split=%zu", list_get_size(parts));
+    print_parts(parts);
+
+    String* line = @"key=x y;z";
+    StringView* value = string_slice(line, 4, 100);
+    List* words = string_view_split(value, ';');
+    printf("view=%zu", list_get_size(words));
+    print_parts(words);
+
+    list_free(words);
+    string_view_free(value);
+    string_free(line);
+    list_free(parts);
+    string_free(csv);
+    string_free(lower);
+    string_free(upper);
+    string_free(mixed);
+    string_free(text);
+    return EXIT_SUCCESS;
+}
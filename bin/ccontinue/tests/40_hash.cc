@@ -0,0 +1,51 @@
+// EXIT: 0
+// OUT: wyhash=93228a4de0eec5a2 c5bac3db178713c4 786d1f1df3801df4 6cc5eab49a92d617
+// OUT: string=1 view=1 float=1 int=1
+// OUT: map=1000 missing=0
+
+#include <Map.hh>
+#include <StringView.hh>
+
+int main(void) {
+    char* digits = "12345678901234567890123456789012345678901234567890123456789012345678901234567890";
+    printf("wyhash=%016llx %016llx %016llx %016llx\n", (unsigned long long)wyhash("", 0, 0),
+           (unsigned long long)wyhash("a", 1, 1), (unsigned long long)wyhash("message digest", 14, 3),
+           (unsigned long long)wyhash(digits, strlen(digits), 6));
+
+    String* s = @"hello world";
+    StringView* v = string_slice(s, 0, 5);
+    String* hello = @"hello";
+    Float* zero = @0.0;
+    Float* negative_zero = float_new(-0.0);
+    Int* a = @42;
+    Int* b = int_new(42);
+    printf("string=%d view=%d float=%d int=%d\n", string_hash(s) == hash_bytes("hello world", 11),
+           string_view_hash(v) == string_hash(hello), float_hash(zero) == float_hash(negative_zero),
+           int_hash(a) == int_hash(b));
+
+    Map* map = map_new();
+    for (i64 i = 0; i < 1000; i++) {
+        Int* key = int_new(i << 16);
+        map_set(map, cast<IKeyable>(key), (Object*)int_new(i));
+        int_free(key);
+    }
+    usize missing = 0;
+    for (i64 i = 0; i < 1000; i++) {
+        Int* key = int_new(i << 16);
+        Int* value = (Int*)map_get(map, cast<IKeyable>(key));
+        if (value == NULL || int_get_value(value) != i)
+            missing++;
+        int_free(key);
+    }
+    printf("map=%zu missing=%zu\n", map_get_filled(map), missing);
+
+    map_free(map);
+    int_free(b);
+    int_free(a);
+    float_free(negative_zero);
+    float_free(zero);
+    string_free(hello);
+    string_view_free(v);
+    string_free(s);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,52 @@
+// EXIT: 0
+// OUT: same=1 different=0 equals=1 0
+// OUT: cstr=host length=4 hash=1
+// OUT: from_string=1 to_string=port shared=1
+// OUT: map=2 host=localhost port=8080
+// OUT: arena=1 alive=arena key
+
+#include <Map.hh>
+#include <Symbol.hh>
+
+int main(void) {
+    Symbol* host = symbol_intern("host");
+    Symbol* host_again = symbol_intern("host");
+    Symbol* port = symbol_intern("port");
+    printf("same=%d different=%d equals=%d %d\n", host == host_again, host == port,
+           symbol_equals(host, (Object*)host_again), symbol_equals(host, (Object*)port));
+    String* host_string = @"host";
+    printf("cstr=%s length=%zu hash=%d\n", symbol_get_cstr(host), symbol_get_length(host),
+           symbol_hash(host) == string_hash(host_string));
+
+    String* port_string = @"port";
+    Symbol* port_again = symbol_intern_string(port_string);
+    String* port_back = symbol_to_string(port_again);
+    printf("from_string=%d to_string=%s shared=%d\n", port == port_again, string_get_cstr(port_back),
+           port_back == symbol_get_string(port));
+
+    Map* config = map_new();
+    map_set(config, cast<IKeyable>(host), @"localhost");
+    map_set(config, cast<IKeyable>(port), @"8080");
+    printf("map=%zu host=%s port=%s\n", map_get_filled(config),
+           string_get_cstr((String*)map_get(config, cast<IKeyable>(host_again))),
+           string_get_cstr((String*)map_get(config, cast<IKeyable>(port_again))));
+    map_free(config);
+
+    Arena* arena = arena_new();
+    String* temp = @"arena key";
+    Symbol* from_arena = symbol_intern_string(temp);
+    arena_free(arena);
+    Symbol* later = symbol_intern("arena key");
+    printf("arena=%d alive=%s\n", from_arena == later, symbol_get_cstr(later));
+
+    symbol_free(later);
+    symbol_free(from_arena);
+    string_free(port_back);
+    symbol_free(port_again);
+    string_free(port_string);
+    string_free(host_string);
+    symbol_free(port);
+    symbol_free(host_again);
+    symbol_free(host);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,73 @@
+// EXIT: 0
+// OUT: casts=1 2 3 4 5 6 7
+// OUT: instanceof=1 1 0 0
+// OUT: missing=1
+// OUT: plain=0 0
+
+#include <Object.hh>
+
+class IOne { i32 one(); };
+class ITwo { i32 two(); };
+class IThree { i32 three(); };
+class IFour { i32 four(); };
+class IFive { i32 five(); };
+class ISix { i32 six(); };
+class ISeven { i32 seven(); };
+class IUnused { void unused(); };
+
+class Many : IOne, ITwo, IThree, IFour, IFive, ISix, ISeven {
+    virtual i32 one();
+    virtual i32 two();
+    virtual i32 three();
+    virtual i32 four();
+    virtual i32 five();
+    virtual i32 six();
+    virtual i32 seven();
+};
+i32 Many::one() {
+    (void)this;
+    return 1;
+}
+i32 Many::two() {
+    (void)this;
+    return 2;
+}
+i32 Many::three() {
+    (void)this;
+    return 3;
+}
+i32 Many::four() {
+    (void)this;
+    return 4;
+}
+i32 Many::five() {
+    (void)this;
+    return 5;
+}
+i32 Many::six() {
+    (void)this;
+    return 6;
+}
+i32 Many::seven() {
+    (void)this;
+    return 7;
+}
+
+class Plain {};
+
+int main(void) {
+    Many* many = many_new();
+    printf("casts=%d %d %d %d %d %d %d\n", i_one_one(cast<IOne>(many)), i_two_two(cast<ITwo>(many)),
+           i_three_three(cast<IThree>(many)), i_four_four(cast<IFour>(many)), i_five_five(cast<IFive>(many)),
+           i_six_six(cast<ISix>(many)), i_seven_seven(cast<ISeven>(many)));
+    printf("instanceof=%d %d %d %d\n", instanceof<IOne>(many), instanceof<ISeven>(many), instanceof<IUnused>(many),
+           instanceof<IKeyable>(many));
+    IUnused unused = cast<IUnused>(many);
+    printf("missing=%d\n", unused.vtbl == NULL);
+
+    Plain* plain = plain_new();
+    printf("plain=%d %d\n", instanceof<IOne>(plain), instanceof<IUnused>(plain));
+    plain_free(plain);
+    many_free(many);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,65 @@
+// EXIT: 0
+// OUT: circle=1 1 1 0 0
+// OUT: square=1 1 0 1 1
+// OUT: object=1 0 0
+// OUT: describe=circle square+rect object
+
+#include <String.hh>
+
+class Shape {
+    virtual f64 area() = 0;
+};
+
+class Round : Shape {
+    virtual f64 area() = 0;
+};
+
+class Circle : Round {
+    virtual f64 area();
+};
+f64 Circle::area() {
+    (void)this;
+    return 3.0;
+}
+
+class Rect : Shape {
+    virtual f64 area();
+};
+f64 Rect::area() {
+    (void)this;
+    return 4.0;
+}
+
+class Square : Rect {};
+
+class Describer {
+    char* describe(Object* obj);
+};
+char* Describer::describe(Object* obj) {
+    (void)this;
+    if (instanceof<Circle>(obj))
+        return "circle";
+    if (instanceof<Square>(obj) && instanceof<Rect>(obj))
+        return "square+rect";
+    return "object";
+}
+
+int main(void) {
+    Circle* circle = circle_new();
+    Square* square = square_new();
+    Object* object = object_new();
+    printf("circle=%d %d %d %d %d\n", instanceof<Object>(circle), instanceof<Shape>(circle), instanceof<Round>(circle),
+           instanceof<Rect>(circle), instanceof<String>(circle));
+    printf("square=%d %d %d %d %d\n", instanceof<Object>(square), instanceof<Shape>(square), instanceof<Round>(square),
+           instanceof<Rect>(square), instanceof<Square>(square));
+    printf("object=%d %d %d\n", instanceof<Object>(object), instanceof<Shape>(object), instanceof<Circle>(object));
+
+    Describer* describer = describer_new();
+    printf("describe=%s %s %s\n", describer_describe(describer, (Object*)circle),
+           describer_describe(describer, (Object*)square), describer_describe(describer, object));
+    describer_free(describer);
+    object_free(object);
+    square_free(square);
+    circle_free(circle);
+    return EXIT_SUCCESS;
+}
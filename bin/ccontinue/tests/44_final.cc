@@ -0,0 +1,65 @@
+// EXIT: 0
+// OUT: sum=4950 name=point
+// OUT: base=base:1 derived=derived:1 id=1
+
+#include <Object.hh>
+
+@final class Point {
+    @get @init i32 x;
+
+    virtual i32 value();
+    virtual char* name();
+};
+i32 Point::value() {
+    return this->x;
+}
+char* Point::name() {
+    (void)this;
+    return "point";
+}
+
+class Base {
+    virtual final i32 id();
+    virtual char* label();
+    char* describe(char* buffer);
+};
+i32 Base::id() {
+    (void)this;
+    return 1;
+}
+char* Base::label() {
+    (void)this;
+    return "base";
+}
+char* Base::describe(char* buffer) {
+    sprintf(buffer, "%s:%d", base_label(this), base_id(this));
+    return buffer;
+}
+
+class Derived : Base {
+    virtual char* label();
+};
+char* Derived::label() {
+    (void)this;
+    return "derived";
+}
+
+int main(void) {
+    i32 sum = 0;
+    for (i32 i = 0; i < 100; i++) {
+        Point* point = point_new(i);
+        sum += point_value(point);
+        point_free(point);
+    }
+    Point* point = point_new(0);
+    printf("sum=%d name=%s\n", sum, point_name(point));
+    point_free(point);
+
+    char a[32], b[32];
+    Base* base = base_new();
+    Derived* derived = derived_new();
+    printf("base=%s derived=%s id=%d\n", base_describe(base, a), base_describe((Base*)derived, b), derived_id(derived));
+    derived_free(derived);
+    base_free(base);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,51 @@
+// EXIT: 0
+// OUT: x=3 y=4 area=12 scaled=18
+// OUT: name=box length=3 heavy=1 weight=7 unit=1
+
+#include <Object.hh>
+#include <String.hh>
+
+class Rect {
+    @prop @init i32 x;
+    @prop @init i32 y;
+
+    inline i32 area() {
+        return rect_get_x(this) * rect_get_y(this);
+    }
+    inline void scale(i32 factor) {
+        this->x *= factor;
+        this->y *= factor;
+    }
+    static inline Rect* unit() {
+        return rect_new(1, 1);
+    }
+};
+
+class Box : Rect {
+    @get @init String* name;
+    @prop i32 weight = 0;
+
+    inline bool is_heavy() {
+        return this->weight > 5;
+    }
+};
+
+int main(void) {
+    Rect* rect = rect_new(3, 4);
+    printf("x=%d y=%d area=%d", rect_get_x(rect), rect_get_y(rect), rect_area(rect));
+    rect_scale(rect, 2);
+    rect_set_y(rect, 3);
+    printf(" scaled=%d\n", rect_area(rect));
+    rect_free(rect);
+
+    String* name = string_new("box");
+    Box* box = box_new(1, 2, name);
+    box_set_weight(box, 7);
+    Rect* unit = rect_unit();
+    printf("name=%s length=%zu heavy=%d weight=%d unit=%d\n", string_get_cstr(box_get_name(box)),
+           string_get_length(box_get_name(box)), box_is_heavy(box), box_get_weight(box), rect_area(unit));
+    rect_free(unit);
+    box_free(box);
+    string_free(name);
+    return EXIT_SUCCESS;
+}
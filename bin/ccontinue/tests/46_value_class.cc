@@ -0,0 +1,69 @@
+// EXIT: 0
+// OUT: size=8 sum=(10,14) dot=11 scaled=(6,8) area=24
+// OUT: hash=1 equals=1 boxed=(3,4)
+
+#include <Object.hh>
+
+@value class Point : IEquatable, IHashable {
+    @prop @init i32 x;
+    @prop @init i32 y;
+
+    i32 dot(Point other);
+    Point scaled(i32 factor);
+    inline Point add(Point other) {
+        return point_new(this->x + other.x, this->y + other.y);
+    }
+    bool equals(Object* other);
+    u32 hash();
+};
+i32 Point::dot(Point other) {
+    return this->x * other.x + this->y * other.y;
+}
+Point Point::scaled(i32 factor) {
+    return point_new(this->x * factor, this->y * factor);
+}
+bool Point::equals(Object* other) {
+    if (!instanceof<PointBox>(other))
+        return false;
+    Point value = point_box_get_value(other);
+    return this->x == value.x && this->y == value.y;
+}
+u32 Point::hash() {
+    return hash_u64(((u64)(u32)this->x << 32) | (u32)this->y);
+}
+
+@value class Size {
+    @init i32 width;
+    @init i32 height;
+    i32 scale = 1;
+
+    inline i32 area() {
+        return this->width * this->height * this->scale;
+    }
+};
+
+int main(void) {
+    Point points[4];
+    for (i32 i = 0; i < 4; i++)
+        points[i] = point_new(i + 1, i + 2);
+    Point sum = point_new(0, 0);
+    for (i32 i = 0; i < 4; i++)
+        sum = point_add(&sum, points[i]);
+    Point a = point_new(1, 2);
+    Point b = point_new(3, 4);
+    Point scaled = point_scaled(&b, 2);
+    Size size = size_new(3, 4);
+    size.scale = 2;
+    printf("size=%zu sum=(%d,%d) dot=%d scaled=(%d,%d) area=%d\n", sizeof(Point), point_get_x(&sum),
+           point_get_y(&sum), point_dot(&a, b), scaled.x, scaled.y, size_area(&size));
+
+    PointBox* boxed = point_box_new(b);
+    PointBox* other = point_box_new(point_new(3, 4));
+    IHashable hashable = cast<IHashable>(boxed);
+    IEquatable equatable = cast<IEquatable>(boxed);
+    printf("hash=%d equals=%d boxed=(%d,%d)\n", i_hashable_hash(hashable) == point_hash(&b),
+           i_equatable_equals(equatable, (Object*)other), point_box_get_value(boxed).x, point_box_get_value(boxed).y);
+    point_box_free(other);
+    point_box_free(boxed);
+    return EXIT_SUCCESS;
+}
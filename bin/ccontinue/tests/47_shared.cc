@@ -0,0 +1,59 @@
+// EXIT: 0
+// OUT: shared=1 plain=0 refs=1 deinits=1
+
+#include <pthread.h>
+
+#include <Object.hh>
+
+#define THREADS 4
+#define ROUNDS 100000
+
+static atomic_int deinits = 0;
+
+@shared class Payload {
+    @get @init i32 value;
+
+    virtual void deinit();
+};
+void Payload::deinit() {
+    atomic_fetch_add(&deinits, 1);
+    Object::deinit();
+}
+
+class Plain {};
+
+static void* churn(void* arg) {
+    Payload* payload = arg;
+    for (i32 i = 0; i < ROUNDS; i++)
+        payload_free(payload_ref(payload));
+    return NULL;
+}
+
+static void* release(void* arg) {
+    payload_free(arg);
+    return NULL;
+}
+
+int main(void) {
+    Payload* payload = payload_new(42);
+    pthread_t threads[THREADS];
+    for (i32 i = 0; i < THREADS; i++)
+        pthread_create(&threads[i], NULL, churn, payload);
+    for (i32 i = 0; i < THREADS; i++)
+        pthread_join(threads[i], NULL);
+
+    Plain* plain = plain_new();
+    printf("shared=%d plain=%d refs=%zu", payload->vtbl->shared, plain->vtbl->shared, atomic_load(&payload->refs));
+    plain_free(plain);
+
+    // The last reference is dropped on other threads, exactly one of them deinits
+    for (i32 i = 0; i < THREADS; i++)
+        payload_ref(payload);
+    payload_free(payload);
+    for (i32 i = 0; i < THREADS; i++)
+        pthread_create(&threads[i], NULL, release, payload);
+    for (i32 i = 0; i < THREADS; i++)
+        pthread_join(threads[i], NULL);
+    printf(" deinits=%d\n", atomic_load(&deinits));
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,67 @@
+// EXIT: 0
+// OUT: squares=333328333350000 items=5050 tasks=100 nested=400 empty=0
+
+#include <ThreadPool.hh>
+
+static _Atomic u64 squares = 0;
+static _Atomic i64 items = 0;
+static atomic_int tasks = 0;
+static _Atomic usize nested = 0;
+
+static void add_squares(usize begin, usize end, void* context) {
+    (void)context;
+    u64 sum = 0;
+    for (usize i = begin; i < end; i++)
+        sum += (u64)i * i;
+    atomic_fetch_add(&squares, sum);
+}
+
+static void add_item(Object* item, void* context) {
+    (void)context;
+    atomic_fetch_add(&items, int_get_value(item));
+}
+
+static void count_task(void* arg) {
+    (void)arg;
+    atomic_fetch_add(&tasks, 1);
+}
+
+static void count_range(usize begin, usize end, void* context) {
+    (void)context;
+    atomic_fetch_add(&nested, end - begin);
+}
+
+// A task waiting on its own parallel loop runs queued work instead of blocking a worker
+static void nested_task(void* arg) {
+    thread_pool_parallel_for_range(arg, 0, 100, 7, count_range, NULL);
+}
+
+static void never_called(usize begin, usize end, void* context) {
+    (void)begin;
+    (void)end;
+    (void)context;
+    printf("called on empty range\n");
+}
+
+int main(void) {
+    parallel_for_range(0, 100000, 1000, add_squares, NULL);
+
+    List* list = list_new();
+    for (i64 i = 1; i <= 100; i++)
+        list_add(list, (Object*)int_new(i));
+    parallel_for(list, add_item, NULL);
+    list_free(list);
+
+    ThreadPool* pool = thread_pool_new(4);
+    for (i32 i = 0; i < 100; i++)
+        thread_pool_spawn(pool, count_task, NULL);
+    for (i32 i = 0; i < 4; i++)
+        thread_pool_spawn(pool, nested_task, pool);
+    thread_pool_wait(pool);
+    thread_pool_parallel_for_range(pool, 10, 10, 0, never_called, NULL);
+    thread_pool_free(pool);
+
+    printf("squares=%llu items=%lld tasks=%d nested=%zu empty=0\n", (unsigned long long)atomic_load(&squares),
+           (long long)atomic_load(&items), atomic_load(&tasks), atomic_load(&nested));
+    return EXIT_SUCCESS;
+}
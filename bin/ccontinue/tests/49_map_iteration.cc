@@ -0,0 +1,102 @@
+// EXIT: 0
+// OUT: keys=4950 values=9900 entries=100
+// OUT: foreach=100 sum=14850
+// OUT: iterator=4950 values=9900
+// OUT: rehashing=true found=780 rehashing=false
+// OUT: set=4950 foreach=100 iterator=4950
+
+#include <Map.hh>
+#include <Set.hh>
+
+static void sum_entry(Object* key, Object* value, void* context) {
+    *(i64*)context += int_get_value((Int*)key) + int_get_value((Int*)value);
+}
+
+static void count_key(Object* key, void* context) {
+    (void)key;
+    (*(i32*)context)++;
+}
+
+// Sums through the IIterable interface, the path unknown iterables take
+static i64 sum_iterable(IIterable iterable) {
+    i64 sum = 0;
+    IIterator iterator = i_iterable_iterator(iterable);
+    while (i_iterator_has_next(iterator))
+        sum += int_get_value((Int*)i_iterator_next(iterator));
+    object_free((Object*)iterator.obj);
+    return sum;
+}
+
+int main(void) {
+    Map* map = map_new();
+    for (i64 i = 0; i < 100; i++) {
+        Int* key = int_new(i);
+        map_set(map, cast<IKeyable>(key), int_new(i * 2));
+        int_free(key);
+    }
+
+    i64 key_sum = 0;
+    i32 entries = 0;
+    for (Int* key in map) {
+        key_sum += int_get_value(key);
+        entries++;
+    }
+    MapValues* values = map_values(map);
+    i64 value_sum = 0;
+    for (Int* value in values) {
+        value_sum += int_get_value(value);
+    }
+    printf("keys=%lld values=%lld entries=%d\n", (long long)key_sum, (long long)value_sum, entries);
+
+    i32 count = 0;
+    i64 sum = 0;
+    map_foreach(map, sum_entry, &sum);
+    MapKeys* keys = map_keys(map);
+    for (Int* key in keys) {
+        (void)key;
+        count++;
+    }
+    printf("foreach=%d sum=%lld\n", count, (long long)sum);
+
+    printf("iterator=%lld values=%lld\n", (long long)sum_iterable(cast<IIterable>(keys)),
+           (long long)sum_iterable(cast<IIterable>(values)));
+    map_keys_free(keys);
+
+    // The values view keeps the map alive after its owner lets go
+    map_free(map);
+    map_values_free(values);
+
+    // Lookups in the loop body don't move entries of a running incremental resize
+    Map* incremental = map_new_incremental();
+    for (i64 i = 0; i < 780; i++) {
+        Int* key = int_new(i);
+        map_set(incremental, cast<IKeyable>(key), NULL);
+        int_free(key);
+    }
+    bool rehashing = map_is_rehashing(incremental);
+    i32 found = 0;
+    for (Int* key in incremental) {
+        if (map_get(incremental, cast<IKeyable>(key)) == NULL)
+            found++;
+    }
+    printf("rehashing=%s found=%d rehashing=%s\n", rehashing ? "true" : "false", found,
+           map_is_rehashing(incremental) ? "true" : "false");
+    map_free(incremental);
+
+    Set* set = set_new();
+    for (i64 i = 0; i < 100; i++) {
+        Int* key = int_new(i);
+        set_add(set, cast<IKeyable>(key));
+        int_free(key);
+    }
+    i64 set_sum = 0;
+    for (Int* key in set) {
+        set_sum += int_get_value(key);
+    }
+    i32 set_count = 0;
+    set_foreach(set, count_key, &set_count);
+    printf("set=%lld foreach=%d iterator=%lld\n", (long long)set_sum, set_count,
+           (long long)sum_iterable(cast<IIterable>(set)));
+    set_free(set);
+    return EXIT_SUCCESS;
+}
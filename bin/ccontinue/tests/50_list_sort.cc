@@ -0,0 +1,200 @@
+// EXIT: 0
+// OUT: ints=1 random=1 sorted=1 reversed=1 equal=1 pipe=1
+// OUT: floats=-2.5 0 1.5 nan
+// OUT: strings=a ab b ba
+// OUT: versions=1.2 1.10 2.0 mixed=1
+// OUT: descending=9 7 5 3 1
+// OUT: stable=1 stable_ints=1
+// OUT: search=43 missing=-5 first=0 by=2
+
+#include <math.h>
+
+#include <List.hh>
+#include <String.hh>
+
+// Sorts through the IComparable vtbl, it's not one of the boxed types
+class Version : IComparable {
+    @get @init i32 major;
+    @get @init i32 minor;
+
+    virtual bool equals(Object* other);
+    virtual i32 compare(Object* other);
+};
+bool Version::equals(Object* other) {
+    return version_compare(this, other) == 0;
+}
+i32 Version::compare(Object* other) {
+    Version* v = (Version*)other;
+    if (this->major != v->major)
+        return this->major - v->major;
+    return this->minor - v->minor;
+}
+
+// A different vtbl than Int, so lists holding both take the mixed comparison
+class Count : Int {};
+
+// Sorted by key only, the tag records the original order
+class Entry {
+    @get @init i64 key;
+    @get @init i64 tag;
+};
+
+static i32 compare_entries(Object* a, Object* b) {
+    i64 ka = entry_get_key((Entry*)a), kb = entry_get_key((Entry*)b);
+    return (ka > kb) - (ka < kb);
+}
+
+static i32 compare_descending(Object* a, Object* b) {
+    return int_compare((Int*)b, a);
+}
+
+static bool is_sorted(List* list) {
+    for (usize i = 1; i < list_get_size(list); i++) {
+        if (int_get_value((Int*)list_get(list, i - 1)) > int_get_value((Int*)list_get(list, i)))
+            return false;
+    }
+    return true;
+}
+
+static List* int_list(usize size, i64 (*value)(usize i, usize size)) {
+    List* list = list_new_with_capacity(size);
+    for (usize i = 0; i < size; i++)
+        list_add(list, (Object*)int_new(value(i, size)));
+    return list;
+}
+
+static u64 seed = 12345;
+static i64 random_value(usize i, usize size) {
+    (void)i;
+    (void)size;
+    seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+    return (i64)(seed >> 33) % 1000;
+}
+static i64 ascending(usize i, usize size) {
+    (void)size;
+    return (i64)i;
+}
+static i64 descending(usize i, usize size) {
+    return (i64)(size - i);
+}
+static i64 constant(usize i, usize size) {
+    (void)i;
+    (void)size;
+    return 7;
+}
+static i64 organ_pipe(usize i, usize size) {
+    return (i64)(i < size / 2 ? i : size - i);
+}
+
+static bool sorts(usize size, i64 (*value)(usize i, usize size)) {
+    List* list = int_list(size, value);
+    list_sort(list);
+    bool sorted = is_sorted(list) && list_get_size(list) == size;
+    list_free(list);
+    return sorted;
+}
+
+int main(void) {
+    bool small = true;
+    for (usize size = 0; size < 64; size++)
+        small = small && sorts(size, random_value);
+    printf("ints=%d random=%d sorted=%d reversed=%d equal=%d pipe=%d\n", small, sorts(100000, random_value),
+           sorts(100000, ascending), sorts(100000, descending), sorts(100000, constant), sorts(100000, organ_pipe));
+
+    List* floats = list_new();
+    list_add(floats, (Object*)float_new(1.5));
+    list_add(floats, (Object*)float_new(NAN));
+    list_add(floats, (Object*)float_new(-2.5));
+    list_add(floats, (Object*)float_new(0.0));
+    list_sort(floats);
+    printf("floats=");
+    for (Float* value in floats) {
+        printf(value == (Float*)list_get(floats, 0) ? "%g" : " %g", float_get_value(value));
+    }
+    printf("\n");
+    list_free(floats);
+
+    List* strings = list_new();
+    list_add(strings, (Object*)string_new("ba"));
+    list_add(strings, (Object*)string_new("ab"));
+    list_add(strings, (Object*)string_new("b"));
+    list_add(strings, (Object*)string_new("a"));
+    list_sort(strings);
+    printf("strings=");
+    for (String* string in strings) {
+        printf(string == (String*)list_get(strings, 0) ? "%s" : " %s", string_get_cstr(string));
+    }
+    printf("\n");
+    list_free(strings);
+
+    List* versions = list_new();
+    list_add(versions, (Object*)version_new(2, 0));
+    list_add(versions, (Object*)version_new(1, 10));
+    list_add(versions, (Object*)version_new(1, 2));
+    list_sort(versions);
+    printf("versions=");
+    for (Version* version in versions) {
+        printf(version == (Version*)list_get(versions, 0) ? "%d.%d" : " %d.%d", version_get_major(version),
+               version_get_minor(version));
+    }
+    list_free(versions);
+
+    List* mixed = list_new();
+    for (usize i = 0; i < 200; i++) {
+        i64 value = random_value(i, 200);
+        list_add(mixed, i % 2 == 0 ? (Object*)int_new(value) : (Object*)count_new(value));
+    }
+    list_sort(mixed);
+    printf(" mixed=%d\n", is_sorted(mixed));
+    list_free(mixed);
+
+    List* numbers = list_new();
+    for (i64 i = 1; i <= 9; i += 2)
+        list_add(numbers, (Object*)int_new(i));
+    list_sort_by(numbers, compare_descending);
+    printf("descending=");
+    for (Int* number in numbers) {
+        printf(number == (Int*)list_get(numbers, 0) ? "%lld" : " %lld", (long long)int_get_value(number));
+    }
+    printf("\n");
+    list_free(numbers);
+
+    List* entries = list_new();
+    for (i64 i = 0; i < 10000; i++)
+        list_add(entries, (Object*)entry_new(random_value(0, 0) % 10, i));
+    list_sort_stable_by(entries, compare_entries);
+    bool stable = true;
+    for (usize i = 1; i < list_get_size(entries); i++) {
+        Entry* a = (Entry*)list_get(entries, i - 1);
+        Entry* b = (Entry*)list_get(entries, i);
+        if (entry_get_key(a) > entry_get_key(b) ||
+            (entry_get_key(a) == entry_get_key(b) && entry_get_tag(a) > entry_get_tag(b)))
+            stable = false;
+    }
+    list_free(entries);
+    List* stable_ints = int_list(10000, random_value);
+    list_sort_stable(stable_ints);
+    printf("stable=%d stable_ints=%d\n", stable, is_sorted(stable_ints));
+    list_free(stable_ints);
+
+    // 0 0 2 4 ... 198
+    List* evens = list_new();
+    for (i64 i = 99; i >= 0; i--)
+        list_add(evens, (Object*)int_new(i * 2));
+    list_add(evens, (Object*)int_new(0));
+    list_sort(evens);
+    Int* probe = int_new(84);
+    Int* odd = int_new(5);
+    Int* zero = int_new(0);
+    printf("search=%td missing=%td first=%td", list_binary_search(evens, (Object*)probe),
+           list_binary_search(evens, (Object*)odd), list_binary_search(evens, (Object*)zero));
+    list_sort_by(evens, compare_descending);
+    Int* target = int_new(194);
+    printf(" by=%td\n", list_binary_search_by(evens, (Object*)target, compare_descending));
+    int_free(probe);
+    int_free(odd);
+    int_free(zero);
+    int_free(target);
+    list_free(evens);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,230 @@
+// EXIT: 0
+// OUT: size=5000 ordered=1 matches=1 removed=2500 size=2500 ordered=1 matches=1 empty=1
+// OUT: first=10 last=90 floor=40 ceiling=50 below=null above=null exact=30
+// OUT: range=20 30 40 open=70 80 90 sum=45
+// OUT: strings=apple banana cherry value=2
+// OUT: sorted=1000 ordered=1 fallback=3 ordered=1 get=42
+// OUT: set=3 contains=1 missing=0 first=1 last=9 range=5 7 9
+// OUT: promoted=10 last=9
+
+#include <String.hh>
+#include <TreeSet.hh>
+
+static bool ordered(TreeMap* map) {
+    Int* prev = NULL;
+    usize count = 0;
+    for (Int* key in map) {
+        if (prev != NULL && int_get_value(prev) >= int_get_value(key))
+            return false;
+        prev = key;
+        count++;
+    }
+    return count == tree_map_get_size(map);
+}
+
+// Every key in the reference array must be found with its value, none of the others
+static bool matches(TreeMap* map, bool* present, i64 count) {
+    for (i64 i = 0; i < count; i++) {
+        Int* key = int_new(i);
+        Object* value = tree_map_get(map, cast<IComparable>(key));
+        bool ok = present[i] ? value != NULL && int_get_value((Int*)value) == i * 3 : value == NULL;
+        int_free(key);
+        if (!ok)
+            return false;
+    }
+    return true;
+}
+
+static void sum_value(Object* key, Object* value, void* context) {
+    (void)key;
+    *(i64*)context += int_get_value((Int*)value);
+}
+
+static void print_key(Object* key) {
+    if (key != NULL)
+        printf("%lld", (long long)int_get_value((Int*)key));
+    else
+        printf("null");
+}
+
+static u64 seed = 12345;
+static i64 random_below(i64 limit) {
+    seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+    return (i64)(seed >> 33) % limit;
+}
+
+int main(void) {
+    // Random inserts and removes split, borrow and merge nodes on every level
+    enum { COUNT = 20000 };
+    static bool present[COUNT];
+    TreeMap* map = tree_map_new();
+    usize inserted = 0;
+    while (inserted < 5000) {
+        i64 i = random_below(COUNT);
+        if (!present[i]) {
+            Int* key = int_new(i);
+            tree_map_set(map, cast<IComparable>(key), int_new(i * 3));
+            int_free(key);
+            present[i] = true;
+            inserted++;
+        }
+    }
+    printf("size=%zu ordered=%d matches=%d", tree_map_get_size(map), ordered(map), matches(map, present, COUNT));
+    usize removed = 0;
+    while (removed < 2500) {
+        i64 i = random_below(COUNT);
+        if (present[i]) {
+            Int* key = int_new(i);
+            tree_map_remove(map, cast<IComparable>(key));
+            int_free(key);
+            present[i] = false;
+            removed++;
+        }
+    }
+    printf(" removed=%zu size=%zu ordered=%d matches=%d", removed, tree_map_get_size(map), ordered(map),
+           matches(map, present, COUNT));
+    for (i64 i = 0; i < COUNT; i++) {
+        Int* key = int_new(i);
+        tree_map_remove(map, cast<IComparable>(key));
+        int_free(key);
+    }
+    printf(" empty=%d\n", tree_map_get_size(map) == 0 && tree_map_first_key(map) == NULL);
+    tree_map_free(map);
+
+    map = tree_map_new();
+    for (i64 i = 90; i >= 10; i -= 10) {
+        Int* key = int_new(i);
+        tree_map_set(map, cast<IComparable>(key), int_new(i / 10));
+        int_free(key);
+    }
+    Int* probe = int_new(45);
+    Int* low = int_new(5);
+    Int* high = int_new(95);
+    Int* exact = int_new(30);
+    printf("first=");
+    print_key(tree_map_first_key(map));
+    printf(" last=");
+    print_key(tree_map_last_key(map));
+    printf(" floor=");
+    print_key(tree_map_floor(map, cast<IComparable>(probe)));
+    printf(" ceiling=");
+    print_key(tree_map_ceiling(map, cast<IComparable>(probe)));
+    printf(" below=");
+    print_key(tree_map_floor(map, cast<IComparable>(low)));
+    printf(" above=");
+    print_key(tree_map_ceiling(map, cast<IComparable>(high)));
+    printf(" exact=");
+    print_key(tree_map_floor(map, cast<IComparable>(exact)));
+    printf("\n");
+
+    Int* from = int_new(20);
+    Int* to = int_new(50);
+    TreeMapRange* range = tree_map_range(map, (Object*)from, (Object*)to);
+    printf("range=");
+    for (Int* key in range) {
+        printf(int_get_value(key) == 20 ? "%lld" : " %lld", (long long)int_get_value(key));
+    }
+    tree_map_range_free(range);
+    Int* start = int_new(65);
+    range = tree_map_range(map, (Object*)start, NULL);
+    printf(" open=");
+    for (Int* key in range) {
+        printf(int_get_value(key) == 70 ? "%lld" : " %lld", (long long)int_get_value(key));
+    }
+    tree_map_range_free(range);
+    i64 sum = 0;
+    tree_map_foreach_range(map, (Object*)from, NULL, sum_value, &sum);
+    tree_map_foreach_range(map, NULL, (Object*)from, sum_value, &sum);
+    printf(" sum=%lld\n", (long long)sum);
+    int_free(probe);
+    int_free(low);
+    int_free(high);
+    int_free(exact);
+    int_free(from);
+    int_free(to);
+    int_free(start);
+    tree_map_free(map);
+
+    map = tree_map_new();
+    String* cherry = @"cherry";
+    String* apple = @"apple";
+    String* banana = @"banana";
+    tree_map_set(map, cast<IComparable>(cherry), int_new(3));
+    tree_map_set(map, cast<IComparable>(apple), int_new(1));
+    tree_map_set(map, cast<IComparable>(banana), int_new(2));
+    printf("strings=");
+    for (String* key in map) {
+        printf(tree_map_first_key(map) == (Object*)key ? "%s" : " %s", string_get_cstr(key));
+    }
+    printf(" value=%lld\n", (long long)int_get_value((Int*)tree_map_get(map, cast<IComparable>(banana))));
+    string_free(cherry);
+    string_free(apple);
+    string_free(banana);
+    tree_map_free(map);
+
+    // Bulk loading sorted keys, and the fallback for keys out of order
+    List* keys = list_new();
+    List* values = list_new();
+    for (i64 i = 0; i < 1000; i++) {
+        list_add(keys, int_new(i));
+        list_add(values, int_new(i * 3));
+    }
+    map = tree_map_new_from_sorted(keys, values);
+    printf("sorted=%zu ordered=%d", tree_map_get_size(map), ordered(map));
+    Int* answer = int_new(14);
+    i64 found = int_get_value((Int*)tree_map_get(map, cast<IComparable>(answer)));
+    tree_map_free(map);
+    list_free(keys);
+    list_free(values);
+    keys = list_new();
+    list_add(keys, int_new(3));
+    list_add(keys, int_new(1));
+    list_add(keys, int_new(2));
+    list_add(keys, int_new(1));
+    map = tree_map_new_from_sorted(keys, NULL);
+    printf(" fallback=%zu ordered=%d get=%lld\n", tree_map_get_size(map), ordered(map), (long long)found);
+    int_free(answer);
+    tree_map_free(map);
+    list_free(keys);
+
+    TreeSet* set = tree_set_new();
+    for (i64 i = 9; i >= 1; i -= 4) {
+        Int* key = int_new(i);
+        tree_set_add(set, cast<IComparable>(key));
+        tree_set_add(set, cast<IComparable>(key));
+        int_free(key);
+    }
+    Int* member = int_new(5);
+    Int* other = int_new(4);
+    printf("set=%zu contains=%d missing=%d first=", tree_set_get_size(set),
+           tree_set_contains(set, cast<IComparable>(member)), tree_set_contains(set, cast<IComparable>(other)));
+    print_key(tree_set_first(set));
+    printf(" last=");
+    print_key(tree_set_last(set));
+    Int* seven = int_new(7);
+    tree_set_add(set, cast<IComparable>(seven));
+    range = tree_set_range(set, (Object*)other, NULL);
+    printf(" range=");
+    for (Int* key in range) {
+        printf(int_get_value(key) == 5 ? "%lld" : " %lld", (long long)int_get_value(key));
+    }
+    printf("\n");
+    tree_map_range_free(range);
+    int_free(member);
+    int_free(other);
+    int_free(seven);
+    tree_set_free(set);
+
+    // Trees built in an arena are rebuilt outside it on promote
+    Arena* arena = arena_new();
+    set = tree_set_new();
+    for (i64 i = 0; i < 10; i++)
+        tree_set_add(set, cast<IComparable>(int_new(i)));
+    TreeSet* promoted = tree_set_promote(set);
+    arena_free(arena);
+    printf("promoted=%zu last=", tree_set_get_size(promoted));
+    print_key(tree_set_last(promoted));
+    printf("\n");
+    tree_set_free(promoted);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,118 @@
+// EXIT: 0
+// OUT: deque capacity=16 size=5 first=2 last=4 items=2 1 0 3 4
+// OUT: wrapped=1 2 3 4 5 6 7 8 9 10 capacity=16 ordered=1
+// OUT: popped=10 9 1 empty=null null
+// OUT: heap=1 2 3 5 8 13 21 ordered=1 peek=null
+// OUT: max=21 13 8 strings=apple banana cherry
+
+#include <Deque.hh>
+#include <PriorityQueue.hh>
+#include <String.hh>
+
+static i32 compare_descending(Object* a, Object* b) {
+    return int_compare((Int*)b, a);
+}
+
+int main(void) {
+    Deque* deque = deque_new_with_capacity(9);
+    usize capacity = deque_get_capacity(deque);
+    deque_push_back(deque, int_new(0));
+    deque_push_front(deque, int_new(1));
+    deque_push_front(deque, int_new(2));
+    deque_push_back(deque, int_new(3));
+    deque_push_back(deque, int_new(4));
+    printf("deque capacity=%zu size=%zu first=%lld last=%lld items=", capacity, deque_get_size(deque),
+           (long long)int_get_value((Int*)deque_first(deque)), (long long)int_get_value((Int*)deque_last(deque)));
+    for (Int* item in deque) {
+        printf(deque_first(deque) == (Object*)item ? "%lld" : " %lld", (long long)int_get_value(item));
+    }
+    printf("\n");
+    deque_clear(deque);
+
+    // Growing while the items wrap around the end of the buffer keeps their order
+    deque_free(deque);
+    deque = deque_new();
+    for (i64 i = 1; i <= 6; i++)
+        deque_push_back(deque, int_new(i));
+    for (i64 i = 0; i < 4; i++)
+        int_free((Int*)deque_pop_front(deque));
+    for (i64 i = 7; i <= 10; i++)
+        deque_push_back(deque, int_new(i));
+    for (i64 i = 4; i >= 1; i--)
+        deque_push_front(deque, int_new(i));
+    printf("wrapped=");
+    bool ordered = true;
+    IIterator iterator = i_iterable_iterator(cast<IIterable>(deque));
+    for (i64 i = 1; i_iterator_has_next(iterator); i++) {
+        Int* item = (Int*)i_iterator_next(iterator);
+        printf(i == 1 ? "%lld" : " %lld", (long long)int_get_value(item));
+        ordered = ordered && int_get_value((Int*)deque_get(deque, (usize)i - 1)) == i;
+    }
+    object_free((Object*)iterator.obj);
+    printf(" capacity=%zu ordered=%d\n", deque_get_capacity(deque), ordered);
+
+    Int* back = (Int*)deque_pop_back(deque);
+    Int* before = (Int*)deque_pop_back(deque);
+    Int* front = (Int*)deque_pop_front(deque);
+    printf("popped=%lld %lld %lld", (long long)int_get_value(back), (long long)int_get_value(before),
+           (long long)int_get_value(front));
+    int_free(back);
+    int_free(before);
+    int_free(front);
+    while (deque_get_size(deque) > 0)
+        int_free((Int*)deque_pop_front(deque));
+    printf(" empty=%s %s\n", deque_pop_front(deque) == NULL ? "null" : "item",
+           deque_pop_back(deque) == NULL ? "null" : "item");
+    deque_free(deque);
+
+    PriorityQueue* queue = priority_queue_new_with_capacity(4);
+    i64 values[] = {13, 2, 21, 1, 8, 3, 5};
+    for (usize i = 0; i < 7; i++)
+        priority_queue_push(queue, int_new(values[i]));
+    printf("heap=");
+    ordered = true;
+    i64 prev = 0;
+    for (usize i = 0; priority_queue_get_size(queue) > 0; i++) {
+        Int* item = (Int*)priority_queue_pop(queue);
+        printf(i == 0 ? "%lld" : " %lld", (long long)int_get_value(item));
+        ordered = ordered && int_get_value(item) >= prev;
+        prev = int_get_value(item);
+        int_free(item);
+    }
+    // Many items in random order
+    for (i64 i = 0; i < 1000; i++)
+        priority_queue_push(queue, int_new((i * 7919) % 1000));
+    for (i64 i = 0; i < 1000; i++) {
+        Int* item = (Int*)priority_queue_pop(queue);
+        ordered = ordered && int_get_value(item) == i;
+        int_free(item);
+    }
+    printf(" ordered=%d peek=%s\n", ordered, priority_queue_peek(queue) == NULL ? "null" : "item");
+    priority_queue_free(queue);
+
+    queue = priority_queue_new_by(compare_descending);
+    for (usize i = 0; i < 7; i++)
+        priority_queue_push(queue, int_new(values[i]));
+    printf("max=");
+    for (usize i = 0; i < 3; i++) {
+        Int* item = (Int*)priority_queue_pop(queue);
+        printf(i == 0 ? "%lld" : " %lld", (long long)int_get_value(item));
+        int_free(item);
+    }
+    priority_queue_free(queue);
+
+    // Strings order through IComparable
+    queue = priority_queue_new();
+    priority_queue_push(queue, @"cherry");
+    priority_queue_push(queue, @"apple");
+    priority_queue_push(queue, @"banana");
+    printf(" strings=");
+    for (usize i = 0; i < 3; i++) {
+        String* item = (String*)priority_queue_pop(queue);
+        printf(i == 0 ? "%s" : " %s", string_get_cstr(item));
+        string_free(item);
+    }
+    printf("\n");
+    priority_queue_free(queue);
+    return EXIT_SUCCESS;
+}
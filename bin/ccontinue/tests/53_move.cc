@@ -0,0 +1,114 @@
+// EXIT: 0
+// OUT: map=1 refs=1 replaced=2 refs=1
+// OUT: set=1 refs=1 duplicate=1
+// OUT: hash_map=1 hash_set=1 tree_map=1 tree_set=1
+// OUT: list=1 refs=1 plain=2
+// OUT: piece=5 knight=4 rules=6
+
+#include <HashMap.hh>
+#include <HashSet.hh>
+#include <List.hh>
+#include <Map.hh>
+#include <Set.hh>
+#include <TreeSet.hh>
+
+// Methods and fields named move are not the move() marker
+class Piece {
+    @get i32 x = 0;
+
+    virtual void move(i32 dx);
+};
+void Piece::move(i32 dx) {
+    this->x += dx;
+}
+
+class Knight : Piece {
+    virtual void move(i32 dx);
+};
+void Knight::move(i32 dx) {
+    Piece::move(dx * 2);
+}
+
+typedef struct Rules {
+    i32 (*move)(i32 steps);
+} Rules;
+
+static i32 double_steps(i32 steps) {
+    return steps * 2;
+}
+
+static usize refs(void* obj) {
+    return atomic_load(&((Object*)obj)->refs);
+}
+
+int main(void) {
+    // The map adopts the key reference, so the key is owned by the map alone
+    Map* map = map_new();
+    Int* key = int_new(1);
+    map_set(map, cast<IKeyable>(move(key)), int_new(10));
+    printf("map=%zu refs=%zu", map_get_filled(map), refs(key));
+
+    // An equal key for an existing entry is freed, the map keeps its own
+    Int* again = int_new(1);
+    map_set(map, cast<IKeyable>(move(again)), int_new(20));
+    Int* probe = int_new(1);
+    printf(" replaced=%lld refs=%zu\n", (long long)int_get_value((Int*)map_get(map, cast<IKeyable>(probe))) / 10,
+           refs(key));
+    map_free(map);
+
+    Set* set = set_new();
+    Int* member = int_new(2);
+    set_add(set, cast<IKeyable>(move(member)));
+    printf("set=%zu refs=%zu", set_get_size(set), refs(member));
+    set_add_move(set, cast<IKeyable>(int_new(2)));
+    printf(" duplicate=%zu\n", set_get_size(set));
+    set_free(set);
+
+    HashMap* hash_map = hash_map_new();
+    hash_map_set(hash_map, cast<IKeyable>(move(int_new(3))), int_new(30));
+    hash_map_set_move(hash_map, cast<IKeyable>(int_new(3)), int_new(31));
+    HashSet* hash_set = hash_set_new();
+    hash_set_add(hash_set, cast<IKeyable>(move(int_new(4))));
+    hash_set_add(hash_set, cast<IKeyable>(move(int_new(4))));
+    TreeMap* tree_map = tree_map_new();
+    tree_map_set(tree_map, cast<IComparable>(move(int_new(5))), int_new(50));
+    tree_map_set(tree_map, cast<IComparable>(move(int_new(5))), int_new(51));
+    TreeSet* tree_set = tree_set_new();
+    tree_set_add(tree_set, cast<IComparable>(move(int_new(6))));
+    tree_set_add(tree_set, cast<IComparable>(move(int_new(6))));
+    printf("hash_map=%zu hash_set=%zu tree_map=%zu tree_set=%zu\n", hash_map_get_size(hash_map),
+           hash_set_get_size(hash_set), tree_map_get_size(tree_map), tree_set_get_size(tree_set));
+    hash_map_free(hash_map);
+    hash_set_free(hash_set);
+    tree_map_free(tree_map);
+    tree_set_free(tree_set);
+
+    // List::add already adopts its item, move() only documents the handover. A moved value
+    // argument doesn't switch the call to a _move variant either
+    List* list = list_new();
+    Int* item = int_new(7);
+    list_add(list, move(item));
+    printf("list=%zu refs=%zu", list_get_size(list), refs(item));
+    list_free(list);
+
+    map = map_new();
+    Int* plain = int_new(8);
+    map_set(map, cast<IKeyable>(plain), move(int_new(80)));
+    printf(" plain=%zu\n", refs(plain));
+    map_free(map);
+    int_free(plain);
+
+    Piece* piece = piece_new();
+    piece_move(piece, 2);
+    piece_move(piece, 3);
+    Knight* knight = knight_new();
+    piece_move(knight, 2);
+    Rules rules = {.move = double_steps};
+    Rules* rules_ptr = &rules;
+    printf("piece=%d knight=%d rules=%d\n", piece_get_x(piece), piece_get_x(knight),
+           rules.move(1) + rules_ptr->move(2));
+    piece_free(piece);
+    knight_free(knight);
+    int_free(probe);
+    return EXIT_SUCCESS;
+}
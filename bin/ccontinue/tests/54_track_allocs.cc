@@ -0,0 +1,62 @@
+// FLAGS: --track-allocs
+// EXIT: 0
+// OUT: tracking=true
+// OUT: reused=true
+// OUT: sum=4950
+// OUT: signaled=true
+// OUT: kept=item 7
+
+#include <signal.h>
+
+#include <List.hh>
+#include <String.hh>
+
+@pool class Particle {
+    @get @init i32 x;
+};
+
+int main(void) {
+#ifdef CCC_TRACK_ALLOCS
+    printf("tracking=true\n");
+#else
+    printf("tracking=false\n");
+#endif
+
+    // Pooled slots keep being reused with the tracking header in front
+    Particle* first = particle_new(0);
+    void* first_addr = first;
+    particle_free(first);
+    Particle* second = particle_new(1);
+    printf("reused=%s\n", (void*)second == first_addr ? "true" : "false");
+    particle_free(second);
+
+    List* particles = list_new();
+    for (i32 i = 0; i < 100; i++)
+        list_add(particles, particle_new(i));
+    i32 sum = 0;
+    for (usize i = 0; i < list_get_size(particles); i++)
+        sum += particle_get_x((Particle*)list_get(particles, i));
+    printf("sum=%d\n", sum);
+    list_free(particles);
+
+    // SIGUSR1 only flags the report, the next allocation prints it outside the handler
+    raise(SIGUSR1);
+    particle_free(particle_new(0));
+    printf("signaled=true\n");
+
+    // Arena objects are counted but never tracked as live, promoted copies are
+    Arena* arena = arena_new();
+    List* items = list_new();
+    for (i32 i = 0; i < 10; i++) {
+        char buf[32];
+        snprintf(buf, sizeof(buf), "item %d", i);
+        list_add(items, string_new(buf));
+    }
+    String* kept = string_promote((String*)list_get(items, 7));
+    arena_free(arena);
+    printf("kept=%s\n", string_get_cstr(kept));
+    string_free(kept);
+
+    _object_track_report();
+    return EXIT_SUCCESS;
+}
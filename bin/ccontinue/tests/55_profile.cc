@@ -0,0 +1,113 @@
+// FLAGS: --profile
+// EXIT: 0
+// OUT: profiling=true
+// OUT: area=750
+// OUT: hash=true
+// OUT: compare=true
+// OUT: Shape::scale calls=1 virtual=1 interface=0
+// OUT: Square::area calls=4 virtual=4 interface=0
+// OUT: Int::compare calls=1 virtual=0 interface=1
+
+#include <unistd.h>
+
+#include <Object.hh>
+
+class Shape {
+    @init i32 size;
+    virtual i32 area();
+    virtual i32 scale(i32 factor);
+};
+i32 Shape::area() {
+    return this->size * this->size;
+}
+i32 Shape::scale(i32 factor) {
+    return this->size * factor;
+}
+
+class Square : Shape {
+    virtual i32 area();
+};
+i32 Square::area() {
+    i32 area = Shape::area();
+    return area;
+}
+
+@final class Counter {
+    @get i32 count = 0;
+    void tick();
+};
+void Counter::tick() {
+    this->count++;
+}
+
+// Prints the counters of some methods from the report, which goes to stderr
+static void print_counters(const char** names, usize count) {
+    int fds[2];
+    if (pipe(fds) != 0)
+        return;
+    fflush(stderr);
+    int saved = dup(STDERR_FILENO);
+    dup2(fds[1], STDERR_FILENO);
+    _profile_report();
+    fflush(stderr);
+    dup2(saved, STDERR_FILENO);
+    close(saved);
+    close(fds[1]);
+    static char report[1 << 16];
+    usize length = 0;
+    isize n;
+    while ((n = read(fds[0], report + length, sizeof(report) - 1 - length)) > 0)
+        length += (usize)n;
+    close(fds[0]);
+    report[length] = '\0';
+    for (usize i = 0; i < count; i++) {
+        for (char* line = report; line != NULL && *line != '\0';) {
+            char name[64];
+            unsigned long long calls, virtual_calls, interface_calls;
+            if (sscanf(line, "%63s %llu %llu %llu", name, &calls, &virtual_calls, &interface_calls) == 4 &&
+                strcmp(name, names[i]) == 0)
+                printf("%s calls=%llu virtual=%llu interface=%llu\n", name, calls, virtual_calls, interface_calls);
+            line = strchr(line, '\n');
+            if (line != NULL)
+                line++;
+        }
+    }
+}
+
+int main(void) {
+#ifdef CCC_PROFILE
+    printf("profiling=true\n");
+#else
+    printf("profiling=false\n");
+#endif
+
+    // Virtual, direct and interface calls all return through the profiling hooks
+    Shape* shapes[2] = {shape_new(10), (Shape*)square_new(20)};
+    Counter* counter = counter_new();
+    i32 area = 0;
+    for (i32 i = 0; i < 6; i++) {
+        area += shape_area(shapes[i % 2]) / 2;
+        counter_tick(counter);
+    }
+    printf("area=%d\n", area + counter_get_count(counter) - 6);
+
+    Int* value = int_new(42);
+    IHashable hashable = cast<IHashable>(value);
+    printf("hash=%s\n", i_hashable_hash(hashable) == int_hash(value) ? "true" : "false");
+
+    // A call in an argument doesn't take the mark of the call around it
+    i32 scaled = shape_scale(shapes[0], shape_area(shapes[1]));
+    Int* other = int_new(7);
+    i32 order = i_comparable_compare(cast<IComparable>(value), (Object*)int_promote(other));
+    printf("compare=%s\n", scaled == 4000 && order > 0 ? "true" : "false");
+    const char* names[] = {"Shape::scale", "Square::area", "Int::compare"};
+    print_counters(names, sizeof(names) / sizeof(names[0]));
+
+    int_free(other);
+    int_free(other);
+    int_free(value);
+    counter_free(counter);
+    shape_free(shapes[0]);
+    shape_free(shapes[1]);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,53 @@
+// EXIT: 0
+// OUT: file=true
+// OUT: init=31
+// OUT: default=18
+// OUT: for=44
+// OUT: after_for=46
+// OUT: generic=49
+
+#include <List.hh>
+#include <Vec.hh>
+
+class IDescribe {
+    void describe();
+    void describe_default();
+};
+
+void IDescribe::describe_default() {
+    printf("default=%d\n", __LINE__);
+    describe(this);
+}
+
+class Point : IDescribe {
+    i32 x = 1;
+    @deinit char* name;
+
+    void init();
+    virtual void describe();
+};
+void Point::init() {
+    this->name = strdup("point");
+    printf("init=%d\n", __LINE__);
+}
+
+void Point::describe() {
+    (void)this;
+}
+
+int main(void) {
+    printf("file=%s\n", strstr(__FILE__, "56_line_directives.cc") != NULL ? "true" : "false");
+    List* points = list_new();
+    list_add(points, point_new());
+    for (Point* point in points) {
+        i_describe_describe_default(cast<IDescribe>(point));
+        printf("for=%d\n", __LINE__);
+    }
+    printf("after_for=%d\n", __LINE__);
+    Vec<i32>* numbers = vec_i32_new();
+    vec_i32_add(numbers, 1);
+    printf("generic=%d\n", __LINE__);
+    vec_i32_free(numbers);
+    list_free(points);
+    return EXIT_SUCCESS;
+}
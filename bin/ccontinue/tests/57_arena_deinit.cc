@@ -0,0 +1,58 @@
+// EXIT: 0
+// OUT: deinits=0
+// OUT: deinits=5
+// OUT: kept=heap
+
+#include <List.hh>
+#include <Map.hh>
+#include <StringBuilder.hh>
+#include <TreeMap.hh>
+
+static i32 deinits = 0;
+
+class Handle {
+    @get @init i32 id;
+    char* name;
+
+    virtual void deinit();
+};
+void Handle::deinit() {
+    deinits++;
+    free(this->name);
+    Object::deinit();
+}
+
+int main(void) {
+    // Heap objects made outside the arena and handed to arena containers
+    Handle* handles[4];
+    for (i32 i = 0; i < 4; i++) {
+        handles[i] = handle_new(i);
+        handles[i]->name = strdup("handle");
+    }
+    String* kept = @"heap";
+
+    Arena* arena = arena_new();
+    List* list = list_new();
+    list_add(list, handles[0]);
+    list_add(list, string_ref(kept));
+    Map* map = map_new();
+    map_set(map, cast<IKeyable>(@"key"), handles[1]);
+    TreeMap* tree = tree_map_new();
+    tree_map_set(tree, cast<IComparable>(int_new(1)), handles[2]);
+    List* nested = list_new();
+    list_add(nested, handles[3]);
+    list_add(list, nested);
+    StringBuilder* sb = string_builder_new();
+    for (i32 i = 0; i < 100; i++)
+        string_builder_append_cstr(sb, "grow ");
+    Handle* local = handle_new(4);
+    local->name = strdup("local");
+    printf("deinits=%d\n", deinits);
+    arena_free(arena);
+
+    // Deinit released the heap children and the malloc'd fields of arena objects
+    printf("deinits=%d\n", deinits);
+    printf("kept=%s\n", string_get_cstr(kept));
+    string_free(kept);
+    return EXIT_SUCCESS;
+}
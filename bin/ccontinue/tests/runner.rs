@@ -28,11 +28,16 @@ fn get_entitlements_path() -> String {
     path.to_str().expect("temp path is valid UTF-8").to_owned()
 }
 
-fn parse_test_meta(filepath: &str) -> (i32, String) {
+fn parse_test_meta(filepath: &str) -> (i32, String, Vec<String>) {
     let content = fs::read_to_string(filepath).expect("read test file");
     let mut expected_exit = 0i32;
     let mut out_lines: Vec<String> = Vec::new();
+    let mut flags: Vec<String> = Vec::new();
     for line in content.lines() {
+        if let Some(rest) = line.strip_prefix("// FLAGS: ") {
+            flags.extend(rest.split_whitespace().map(str::to_owned));
+            continue;
+        }
         if let Some(rest) = line.strip_prefix("// EXIT: ") {
             expected_exit = rest.trim().parse().unwrap_or(0);
             continue;
@@ -50,10 +55,10 @@ fn parse_test_meta(filepath: &str) -> (i32, String) {
     } else {
         out_lines.join("\n") + "\n"
     };
-    (expected_exit, expected_stdout)
+    (expected_exit, expected_stdout, flags)
 }
 
-fn build_test(test_file: &str) -> Result<String, String> {
+fn build_test(test_file: &str, flags: &[String]) -> Result<String, String> {
     let ccc_bin = env!("CARGO_BIN_EXE_ccc");
     let stem = Path::new(test_file)
         .file_stem()
@@ -71,6 +76,7 @@ fn build_test(test_file: &str) -> Result<String, String> {
         .arg(&exe_path)
         .arg("-I")
         .arg(std_dir)
+        .args(flags)
         .output()
         .map_err(|e| format!("failed to run ccc: {e}"))?;
 
@@ -180,9 +186,9 @@ fn run_leaks(exe_path: &str) -> Result<(), String> {
 }
 
 fn run_test(test_file: &str) {
-    let (expected_exit, expected_stdout) = parse_test_meta(test_file);
+    let (expected_exit, expected_stdout, flags) = parse_test_meta(test_file);
 
-    let exe_path = match build_test(test_file) {
+    let exe_path = match build_test(test_file, &flags) {
         Ok(p) => p,
         Err(e) => panic!("build error: {e}"),
     };
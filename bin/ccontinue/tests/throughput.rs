@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) 2026 Bastiaan van der Plaat
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+//! Transpile throughput on a large generated source.
+//! Run with: cargo test --release --test throughput -- --ignored --nocapture
+
+use std::fmt::Write;
+use std::fs;
+use std::process::Command;
+use std::time::Instant;
+
+const CLASSES: usize = 800;
+const ROUNDS: usize = 3;
+
+// About 20k lines: classes with fields and methods, then a main using for-in, cast<> and instanceof<>
+fn generate_source() -> String {
+    let mut s = String::from("#include <List.hh>\n#include <Map.hh>\n#include <String.hh>\n\n");
+    for i in 0..CLASSES {
+        writeln!(
+            s,
+            "class Shape{i} {{\n    @get @init i32 width;\n    @get @set i32 height;\n    virtual i32 area();\n    void grow(i32 amount);\n}};\n"
+        )
+        .expect("write to string");
+        writeln!(
+            s,
+            "i32 Shape{i}::area() {{\n    return this->width * this->height;\n}}\n\nvoid Shape{i}::grow(i32 amount) {{\n    this->width += amount;\n    this->height += amount;\n}}\n"
+        )
+        .expect("write to string");
+    }
+    s += "int main(void) {\n    List* list = list_new();\n";
+    for i in 0..CLASSES {
+        writeln!(
+            s,
+            "    Shape{i}* s{i} = shape{i}_new({i});\n    shape{i}_grow(s{i}, 1);\n    list_add(list, s{i});\n    if (instanceof<Shape{i}>(list_get(list, 0)))\n        printf(\"%d\\n\", shape{i}_area(s{i}));\n    for (Object* item in list) {{\n        (void)item;\n    }}\n    Map* m{i} = map_new();\n    map_set(m{i}, cast<IKeyable>(@\"k\"), @{i});\n    map_free(m{i});"
+        )
+        .expect("write to string");
+    }
+    s += "    list_free(list);\n    return 0;\n}\n";
+    s
+}
+
+#[test]
+#[ignore = "benchmark, run explicitly"]
+fn transpile_throughput() {
+    let source = generate_source();
+    let dir = std::env::temp_dir();
+    let input = dir.join("ccc_throughput.cc");
+    let output = dir.join("ccc_throughput.c");
+    fs::write(&input, &source).expect("write generated source");
+
+    let mut best = f64::MAX;
+    for _ in 0..ROUNDS {
+        let start = Instant::now();
+        let status = Command::new(env!("CARGO_BIN_EXE_ccc"))
+            .arg(&input)
+            .arg("-S")
+            .arg("-o")
+            .arg(&output)
+            .status()
+            .expect("run ccc");
+        assert!(status.success(), "ccc failed on the generated source");
+        best = best.min(start.elapsed().as_secs_f64());
+    }
+
+    let megabytes = source.len() as f64 / 1e6;
+    println!(
+        "transpiled {} lines ({megabytes:.2} MB) in {:.0} ms: {:.2} MB/s",
+        source.lines().count(),
+        best * 1e3,
+        megabytes / best
+    );
+    let _ = fs::remove_file(&input);
+    let _ = fs::remove_file(&output);
+}
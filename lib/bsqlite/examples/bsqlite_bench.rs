@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) 2026 Bastiaan van der Plaat
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+//! A example that measures the insert and select throughput of the SQLite build, run it once with the
+//! `bundled` and once with the `bundled-fast` feature to compare them:
+//! `cargo run --release --example bsqlite_bench --features bundled-fast`
+//! It also compares inserting with `Connection::execute` with and without the statement cache and
+//! with `Connection::insert_batch`.
+
+use std::time::{Duration, Instant};
+
+use bsqlite::Connection;
+
+const ROWS: i64 = 100_000;
+const RUNS: usize = 7;
+
+fn report(name: &str, best: Duration) {
+    println!(
+        "{name}: {ROWS} rows in {:.1} ms, {:.0} rows/s",
+        best.as_secs_f64() * 1000.0,
+        ROWS as f64 / best.as_secs_f64()
+    );
+}
+
+fn main() -> anyhow::Result<()> {
+    println!(
+        "SQLite build: {}, best of {RUNS} runs",
+        if cfg!(feature = "bundled-fast") {
+            "bundled-fast"
+        } else if cfg!(feature = "bundled") {
+            "bundled"
+        } else {
+            "system"
+        }
+    );
+
+    let db = Connection::open_memory().expect("Can't open database");
+    let mut best_insert = Duration::MAX;
+    let mut best_select = Duration::MAX;
+    let mut best_execute = Duration::MAX;
+    let mut best_execute_uncached = Duration::MAX;
+    let mut best_insert_batch = Duration::MAX;
+    for _ in 0..RUNS {
+        db.execute("DROP TABLE IF EXISTS persons", ())?;
+        db.execute(
+            "CREATE TABLE persons (
+                id INTEGER PRIMARY KEY AUTOINCREMENT,
+                name TEXT NOT NULL,
+                age INTEGER NOT NULL
+            ) STRICT",
+            (),
+        )?;
+
+        // Insert the rows with one prepared statement in a transaction
+        let start = Instant::now();
+        db.execute("BEGIN", ())?;
+        let mut stat = db.prepare::<()>("INSERT INTO persons (name, age) VALUES (?, ?)")?;
+        for i in 0..ROWS {
+            stat.reset();
+            stat.bind((format!("Person {i}"), i % 100))?;
+            stat.next().transpose()?;
+        }
+        drop(stat);
+        db.execute("COMMIT", ())?;
+        best_insert = best_insert.min(start.elapsed());
+
+        // Read all rows back
+        let start = Instant::now();
+        for row in db.query::<(i64, String, i64)>("SELECT id, name, age FROM persons", ())? {
+            row?;
+        }
+        best_select = best_select.min(start.elapsed());
+
+        // Insert the rows with execute, once with and once without the statement cache
+        for cached in [true, false] {
+            db.execute("DELETE FROM persons", ())?;
+            db.set_statement_cache_capacity(if cached { 16 } else { 0 });
+            let start = Instant::now();
+            db.execute("BEGIN", ())?;
+            for i in 0..ROWS {
+                db.execute(
+                    "INSERT INTO persons (name, age) VALUES (?, ?)",
+                    (format!("Person {i}"), i % 100),
+                )?;
+            }
+            db.execute("COMMIT", ())?;
+            let best = if cached {
+                &mut best_execute
+            } else {
+                &mut best_execute_uncached
+            };
+            *best = (*best).min(start.elapsed());
+        }
+        db.set_statement_cache_capacity(16);
+
+        // Insert the rows with insert_batch
+        db.execute("DELETE FROM persons", ())?;
+        let start = Instant::now();
+        db.insert_batch(
+            "INSERT INTO persons (name, age) VALUES (?, ?)",
+            (0..ROWS).map(|i| (format!("Person {i}"), i % 100)),
+        )?;
+        best_insert_batch = best_insert_batch.min(start.elapsed());
+    }
+    report("insert", best_insert);
+    report("select", best_select);
+    report("execute", best_execute);
+    report("execute without statement cache", best_execute_uncached);
+    report("insert_batch", best_insert_batch);
+    Ok(())
+}
@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) 2026 Bastiaan van der Plaat
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+//! A example that reads rows from multiple threads, once through one shared connection and once
+//! through the readers of a pool, to compare how the read throughput scales with the cores.
+
+use std::thread;
+use std::time::Instant;
+
+use bsqlite::{Connection, OpenMode, Pool};
+
+const ROWS: i64 = 10_000;
+const QUERIES_PER_THREAD: i64 = 2_000;
+
+fn read(db: &Connection, i: i64) -> anyhow::Result<()> {
+    let (name, age) =
+        db.query_some::<(String, i64)>("SELECT name, age FROM persons WHERE id = ?", i % ROWS + 1)?;
+    assert_eq!(age, i % ROWS % 100);
+    assert!(name.starts_with("Person"));
+    Ok(())
+}
+
+fn main() -> anyhow::Result<()> {
+    let pool = Pool::open("database.db")?;
+    {
+        let writer = pool.writer();
+        writer.execute("DROP TABLE IF EXISTS persons", ())?;
+        writer.execute(
+            "CREATE TABLE persons (
+                id INTEGER PRIMARY KEY AUTOINCREMENT,
+                name TEXT NOT NULL,
+                age INTEGER NOT NULL
+            ) STRICT",
+            (),
+        )?;
+        writer.execute("BEGIN", ())?;
+        for i in 0..ROWS {
+            writer.execute(
+                "INSERT INTO persons (name, age) VALUES (?, ?)",
+                (format!("Person {i}"), i % 100),
+            )?;
+        }
+        writer.execute("COMMIT", ())?;
+    }
+
+    let threads = thread::available_parallelism().map_or(1, |count| count.get());
+    let queries = threads as i64 * QUERIES_PER_THREAD;
+
+    // Read with all threads through one shared connection
+    let db = Connection::open("database.db", OpenMode::ReadOnly)?;
+    let start = Instant::now();
+    thread::scope(|scope| {
+        for _ in 0..threads {
+            scope.spawn(|| {
+                for i in 0..QUERIES_PER_THREAD {
+                    read(&db, i).expect("Can't read row");
+                }
+            });
+        }
+    });
+    let elapsed = start.elapsed();
+    println!(
+        "shared connection: {queries} queries on {threads} threads, {:.0} queries/s",
+        queries as f64 / elapsed.as_secs_f64()
+    );
+
+    // Read with all threads through the readers of the pool
+    let start = Instant::now();
+    thread::scope(|scope| {
+        for _ in 0..threads {
+            scope.spawn(|| {
+                for i in 0..QUERIES_PER_THREAD {
+                    read(&pool.reader(), i).expect("Can't read row");
+                }
+            });
+        }
+    });
+    let elapsed = start.elapsed();
+    println!(
+        "pool readers: {queries} queries on {threads} threads, {:.0} queries/s",
+        queries as f64 / elapsed.as_secs_f64()
+    );
+    Ok(())
+}
@@ -0,0 +1,49 @@
+/*
+ * Copyright (c) 2026 Bastiaan van der Plaat
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+//! A example that logs slow queries with their counters and prints the connection statistics.
+
+use std::time::Duration;
+
+use bsqlite::Connection;
+
+fn main() -> anyhow::Result<()> {
+    let db = Connection::open_memory().expect("Can't open database");
+    db.set_slow_query_hook(Duration::from_millis(1), |query| {
+        println!(
+            "Slow query ({:.1} ms): {} {:?}",
+            query.duration.as_secs_f64() * 1000.0,
+            query.sql,
+            query.stats
+        );
+    });
+
+    // Create table and insert rows
+    db.execute(
+        "CREATE TABLE IF NOT EXISTS persons (
+            id INTEGER PRIMARY KEY AUTOINCREMENT,
+            name TEXT NOT NULL,
+            age INTEGER NOT NULL
+        ) STRICT",
+        (),
+    )?;
+    db.insert_batch(
+        "INSERT INTO persons (name, age) VALUES (?, ?)",
+        (0..100_000i64).map(|i| (format!("Person {i}"), i % 100)),
+    )?;
+
+    // A query without index on age does a full scan and a sort
+    let mut statement =
+        db.prepare::<(String, i64)>("SELECT name, age FROM persons WHERE age = ? ORDER BY name")?;
+    statement.bind(42)?;
+    let rows = statement.by_ref().collect::<Result<Vec<_>, _>>()?;
+    println!("Read {} rows with {:?}", rows.len(), statement.stats());
+
+    let stats = db.stats();
+    println!("{stats:?}");
+    println!("Cache hit ratio: {:.1}%", stats.cache_hit_ratio() * 100.0);
+    Ok(())
+}
@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) 2026 Bastiaan van der Plaat
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+//! A example that reads rows into structs with borrowed fields that derive [FromRow], so scanning
+//! rows doesn't allocate for every text and blob column.
+
+use bsqlite::{Connection, FromRow};
+
+#[derive(Debug, FromRow)]
+struct PersonRef<'a> {
+    id: i64,
+    name: &'a str,
+    avatar: Option<&'a [u8]>,
+}
+
+fn main() -> anyhow::Result<()> {
+    // Connect and create table
+    let db = Connection::open_memory().expect("Can't open database");
+    db.execute(
+        "CREATE TABLE IF NOT EXISTS persons (
+            id INTEGER PRIMARY KEY AUTOINCREMENT,
+            name TEXT NOT NULL,
+            avatar BLOB
+        ) STRICT",
+        (),
+    )?;
+
+    // Insert a rows, structs with borrowed fields can be bound as well
+    let persons = [
+        PersonRef {
+            id: 1,
+            name: "Alice",
+            avatar: Some(&[0x89, 0x50, 0x4e, 0x47]),
+        },
+        PersonRef {
+            id: 2,
+            name: "Bob",
+            avatar: None,
+        },
+    ];
+    for person in persons {
+        db.execute(
+            format!(
+                "INSERT INTO persons ({}) VALUES ({})",
+                PersonRef::columns(),
+                PersonRef::values()
+            ),
+            person,
+        )?;
+    }
+
+    // Read rows back, every row borrows from the statement until the next row is read
+    let mut statement =
+        db.prepare::<()>(format!("SELECT {} FROM persons", PersonRef::columns()))?;
+    while let Some(row) = statement.next_row()? {
+        let person = row.read::<PersonRef>()?;
+        println!("{person:?}");
+    }
+    Ok(())
+}
@@ -4,16 +4,61 @@
  * SPDX-License-Identifier: MIT
  */
 
+use std::collections::VecDeque;
 use std::error::Error;
 use std::ffi::{c_char, CStr, CString};
 use std::fmt::{self, Display, Formatter};
 use std::path::Path;
 use std::ptr;
-use std::sync::Arc;
+use std::sync::{Arc, Mutex, PoisonError};
+use std::time::Duration;
 
 use libsqlite3_sys::*;
 
-use crate::{Bind, FromRow, Statement, StatementError};
+use crate::stats::{self, ConnectionStats, SlowQuery, SlowQueryHook, SlowQueryHookSlot};
+use crate::{Bind, FromRow, RawStatement, Statement, StatementError};
+
+// MARK: Statement Cache
+const DEFAULT_STATEMENT_CACHE_CAPACITY: usize = 16;
+const INSERT_BATCH_SIZE: usize = 10_000;
+
+/// LRU cache of the prepared statements that are not in use, keyed by their SQL text
+struct StatementCache {
+    capacity: usize,
+    // Least recently used statement first
+    statements: VecDeque<(Box<str>, *mut sqlite3_stmt)>,
+}
+
+impl StatementCache {
+    fn new() -> Self {
+        Self {
+            capacity: DEFAULT_STATEMENT_CACHE_CAPACITY,
+            statements: VecDeque::new(),
+        }
+    }
+
+    fn take(&mut self, sql: &str) -> Option<*mut sqlite3_stmt> {
+        let index = self.statements.iter().rposition(|(key, _)| **key == *sql)?;
+        self.statements
+            .remove(index)
+            .map(|(_, statement)| statement)
+    }
+
+    fn insert(&mut self, sql: Box<str>, statement: *mut sqlite3_stmt) {
+        self.statements.push_back((sql, statement));
+        self.evict();
+    }
+
+    fn evict(&mut self) {
+        while self.statements.len() > self.capacity {
+            if let Some((_, statement)) = self.statements.pop_front() {
+                // SAFETY: statement is a valid prepared statement handle that is exclusively owned
+                // by the cache, popping it from the cache means it's finalized exactly once.
+                unsafe { sqlite3_finalize(statement) };
+            }
+        }
+    }
+}
 
 // MARK: Inner Connection
 /// The mode to open the database in
@@ -24,12 +69,18 @@ pub enum OpenMode {
     ReadWrite,
 }
 
-struct InnerConnection(*mut sqlite3);
-// SAFETY: InnerConnection exclusively owns its *mut sqlite3 handle and never aliases it, so
-// transferring ownership to another thread is safe.
+pub(crate) struct InnerConnection(
+    *mut sqlite3,
+    Mutex<StatementCache>,
+    // Boxed so the address SQLite gets stays the same while the db handle is open
+    Box<SlowQueryHookSlot>,
+);
+// SAFETY: InnerConnection exclusively owns its *mut sqlite3 handle and the cached statement
+// handles and never aliases them, so transferring ownership to another thread is safe.
 unsafe impl Send for InnerConnection {}
 // SAFETY: SQLite opened with SQLITE_OPEN_FULLMUTEX serializes all API calls with an internal
-// mutex, so shared access from multiple threads via &InnerConnection is safe.
+// mutex and the statement cache is guarded by its own mutex, so shared access from multiple
+// threads via &InnerConnection is safe.
 unsafe impl Sync for InnerConnection {}
 
 impl InnerConnection {
@@ -65,7 +116,11 @@ impl InnerConnection {
                 msg: format!("Failed to open database: {error}"),
             });
         }
-        Ok(InnerConnection(db))
+        Ok(InnerConnection(
+            db,
+            Mutex::new(StatementCache::new()),
+            Box::new(Mutex::new(None)),
+        ))
     }
 
     fn execute_script(&self, sql: &str) -> Result<(), StatementError> {
@@ -96,7 +151,28 @@ impl InnerConnection {
         Ok(())
     }
 
-    fn prepare<T: FromRow>(&self, query: &str) -> Result<Statement<T>, StatementError> {
+    fn prepare<T: FromRow>(self: &Arc<Self>, query: &str) -> Result<Statement<T>, StatementError> {
+        let (cached, capacity) = {
+            let mut cache = self.1.lock().expect("Can't get lock");
+            (cache.take(query), cache.capacity)
+        };
+        let statement = match cached {
+            Some(statement) => statement,
+            None => self.prepare_raw(query)?,
+        };
+        let cache_sql = if capacity > 0 {
+            Some(query.into())
+        } else {
+            None
+        };
+        Ok(Statement::new(RawStatement::new(
+            statement,
+            self.clone(),
+            cache_sql,
+        )))
+    }
+
+    fn prepare_raw(&self, query: &str) -> Result<*mut sqlite3_stmt, StatementError> {
         let mut statement = ptr::null_mut();
         // SAFETY: self.0 is a valid open db handle, query bytes are valid UTF-8 from a &str with
         // the correct byte length, statement is initialized to null_mut, and the tail pointer is
@@ -118,7 +194,33 @@ impl InnerConnection {
                 msg: format!("Failed to prepare statement '{query}': {error}"),
             });
         }
-        Ok(Statement::new(statement))
+        Ok(statement)
+    }
+
+    pub(crate) fn release_statement(&self, sql: Box<str>, statement: *mut sqlite3_stmt) {
+        // SQL without a statement (like an empty string) prepares to a null handle
+        if statement.is_null() {
+            return;
+        }
+        // Reset the statement so it doesn't keep a read transaction open and clear the bindings so
+        // the next user starts with all parameters NULL like a fresh statement
+        // SAFETY: statement is a valid prepared statement handle of this connection that is
+        // exclusively owned by the caller.
+        unsafe {
+            sqlite3_reset(statement);
+            sqlite3_clear_bindings(statement);
+        }
+        stats::reset_statement_stats(statement);
+        self.1
+            .lock()
+            .expect("Can't get lock")
+            .insert(sql, statement);
+    }
+
+    fn set_statement_cache_capacity(&self, capacity: usize) {
+        let mut cache = self.1.lock().expect("Can't get lock");
+        cache.capacity = capacity;
+        cache.evict();
     }
 
     fn affected_rows(&self) -> i32 {
@@ -130,10 +232,30 @@ impl InnerConnection {
         // SAFETY: self.0 is a valid open db handle.
         unsafe { sqlite3_last_insert_rowid(self.0) }
     }
+
+    fn is_autocommit(&self) -> bool {
+        // SAFETY: self.0 is a valid open db handle.
+        unsafe { sqlite3_get_autocommit(self.0) != 0 }
+    }
+
+    fn set_slow_query_hook(&self, hook: Option<Arc<SlowQueryHook>>) {
+        // The slot is registered once a hook is set and stays registered, clearing the hook only
+        // empties the slot. The lock is released before registering, because SQLite holds its
+        // mutex while it runs the callback that takes the lock.
+        let registered = hook.is_some();
+        *self.2.lock().expect("Can't get lock") = hook;
+        if registered {
+            stats::register_slow_query_hook(self.0, &self.2);
+        }
+    }
 }
 
 impl Drop for InnerConnection {
     fn drop(&mut self) {
+        // Statements in use hold a reference to the connection, so only cached statements are left
+        let cache = self.1.get_mut().unwrap_or_else(PoisonError::into_inner);
+        cache.capacity = 0;
+        cache.evict();
         // SAFETY: self.0 is the exclusively owned db handle; Drop guarantees no other references
         // exist, and sqlite3_close frees the handle exactly once.
         unsafe { sqlite3_close(self.0) };
@@ -144,7 +266,7 @@ impl Drop for InnerConnection {
 /// A connection error
 #[derive(Debug)]
 pub struct ConnectionError {
-    msg: String,
+    pub(crate) msg: String,
 }
 
 impl Display for ConnectionError {
@@ -201,7 +323,16 @@ impl Connection {
         Ok(())
     }
 
-    /// Prepare a statement
+    /// Set how many unused prepared statements are kept for reuse, 0 disables the statement cache
+    ///
+    /// Statements are cached by their SQL text, so [`Connection::prepare`], [`Connection::query`],
+    /// [`Connection::execute`] and the macros only compile a query the first time it's used. A
+    /// statement returns to the cache when it's dropped.
+    pub fn set_statement_cache_capacity(&self, capacity: usize) {
+        self.0.set_statement_cache_capacity(capacity);
+    }
+
+    /// Prepare a statement, reusing a cached statement with the same SQL text when there is one
     pub fn prepare<T: FromRow>(
         &self,
         query: impl AsRef<str>,
@@ -247,6 +378,65 @@ impl Connection {
         Ok(())
     }
 
+    /// Execute a query for every row of params, for bulk inserts
+    ///
+    /// The rows reuse one prepared statement and are committed in transactions of 10000 rows, when
+    /// a row fails its transaction is rolled back but the transactions before it stay committed.
+    /// When a transaction is already open the rows are only executed in it.
+    pub fn insert_batch<P: Bind>(
+        &self,
+        query: impl AsRef<str>,
+        rows: impl IntoIterator<Item = P>,
+    ) -> Result<(), StatementError> {
+        let mut statement = self.prepare::<()>(query.as_ref())?;
+        let use_transactions = self.0.is_autocommit();
+        let mut rows = rows.into_iter().peekable();
+        while rows.peek().is_some() {
+            if use_transactions {
+                self.execute("BEGIN", ())?;
+            }
+            let result: Result<(), StatementError> =
+                rows.by_ref().take(INSERT_BATCH_SIZE).try_for_each(|row| {
+                    statement.reset();
+                    statement.clear_bindings();
+                    statement.bind(row)?;
+                    statement.step()?;
+                    Ok(())
+                });
+            statement.reset();
+            if use_transactions {
+                if result.is_err() {
+                    _ = self.execute("ROLLBACK", ());
+                } else {
+                    self.execute("COMMIT", ())?;
+                }
+            }
+            result?;
+        }
+        Ok(())
+    }
+
+    /// Get the runtime statistics of the connection
+    pub fn stats(&self) -> ConnectionStats {
+        stats::connection_stats(self.0 .0)
+    }
+
+    /// Call a hook with the SQL, duration and counters of every statement that runs at least the
+    /// threshold, replaces the previous hook
+    pub fn set_slow_query_hook(
+        &self,
+        threshold: Duration,
+        hook: impl Fn(&SlowQuery) + Send + Sync + 'static,
+    ) {
+        self.0
+            .set_slow_query_hook(Some(SlowQueryHook::new(threshold, hook)));
+    }
+
+    /// Remove the slow query hook
+    pub fn clear_slow_query_hook(&self) {
+        self.0.set_slow_query_hook(None);
+    }
+
     /// Get the number of affected rows
     pub fn affected_rows(&self) -> i32 {
         self.0.affected_rows()
@@ -293,6 +483,7 @@ macro_rules! execute_args {
 #[cfg(test)]
 mod test {
     use super::*;
+    use crate::StatementStats;
 
     #[test]
     fn test_open_db_execute_queries() -> Result<(), StatementError> {
@@ -433,6 +624,187 @@ mod test {
         Ok(())
     }
 
+    #[test]
+    fn test_insert_batch() -> Result<(), StatementError> {
+        let db = Connection::open_memory().unwrap();
+        db.execute(
+            "CREATE TABLE persons (name TEXT NOT NULL UNIQUE, age INTEGER NOT NULL) STRICT",
+            (),
+        )?;
+        db.insert_batch(
+            "INSERT INTO persons (name, age) VALUES (?, ?)",
+            (0..25_000i64).map(|i| (format!("Person {i}"), i % 100)),
+        )?;
+        assert_eq!(
+            db.query_some::<i64>("SELECT COUNT(*) FROM persons", ())?,
+            25_000
+        );
+        assert_eq!(
+            db.query_some::<String>("SELECT name FROM persons WHERE rowid = 12345", ())?,
+            "Person 12344"
+        );
+
+        // A failing row rolls back its own transaction and leaves no transaction open
+        let result = db.insert_batch(
+            "INSERT INTO persons (name, age) VALUES (?, ?)",
+            ["Alice", "Bob", "Alice"].map(|name| (name.to_string(), 30)),
+        );
+        assert!(result.is_err());
+        assert_eq!(
+            db.query_some::<i64>("SELECT COUNT(*) FROM persons", ())?,
+            25_000
+        );
+
+        // Inside a transaction the rows join that transaction
+        db.execute("BEGIN", ())?;
+        db.insert_batch(
+            "INSERT INTO persons (name, age) VALUES (?, 40)",
+            ["Carol".to_string()],
+        )?;
+        db.execute("ROLLBACK", ())?;
+        assert_eq!(
+            db.query_some::<i64>("SELECT COUNT(*) FROM persons", ())?,
+            25_000
+        );
+        Ok(())
+    }
+
+    #[test]
+    fn test_stats_and_slow_query_hook() -> Result<(), StatementError> {
+        let db = Connection::open_memory().unwrap();
+        db.execute("CREATE TABLE nums (n INTEGER NOT NULL)", ())?;
+        db.insert_batch("INSERT INTO nums (n) VALUES (?)", 0i64..100)?;
+
+        // Statement counters show the full scan and the sort
+        let mut statement = db.prepare::<i64>("SELECT n FROM nums WHERE n % 2 = 0 ORDER BY -n")?;
+        assert_eq!(statement.by_ref().count(), 50);
+        let stats = statement.stats();
+        assert_eq!(stats.fullscan_steps, 99);
+        assert_eq!(stats.sorts, 1);
+        assert!(stats.vm_steps > 0);
+        drop(statement);
+
+        // Counters start again when a statement is taken from the cache
+        let statement = db.prepare::<i64>("SELECT n FROM nums WHERE n % 2 = 0 ORDER BY -n")?;
+        assert_eq!(statement.stats(), StatementStats::default());
+        drop(statement);
+
+        let stats = db.stats();
+        assert!(stats.cache_used > 0);
+        assert!(stats.schema_used > 0);
+        assert!((0.0..=1.0).contains(&stats.cache_hit_ratio()));
+
+        // The hook gets every statement that reaches the threshold
+        let slow_queries = Arc::new(Mutex::new(Vec::new()));
+        db.set_slow_query_hook(Duration::ZERO, {
+            let slow_queries = slow_queries.clone();
+            move |query| {
+                slow_queries
+                    .lock()
+                    .unwrap()
+                    .push((query.sql.to_string(), query.stats.fullscan_steps))
+            }
+        });
+        db.query_some::<i64>("SELECT COUNT(*) FROM nums WHERE n > ?", 10)?;
+        db.set_slow_query_hook(Duration::from_secs(3600), |_| panic!("not slow"));
+        db.query_some::<i64>("SELECT COUNT(*) FROM nums", ())?;
+        db.clear_slow_query_hook();
+        db.query_some::<i64>("SELECT COUNT(*) FROM nums WHERE n > ?", 20)?;
+        assert_eq!(
+            *slow_queries.lock().unwrap(),
+            vec![("SELECT COUNT(*) FROM nums WHERE n > ?".to_string(), 99)]
+        );
+        Ok(())
+    }
+
+    #[test]
+    fn test_slow_query_hook_clears_itself() -> Result<(), StatementError> {
+        let db = Connection::open_memory().unwrap();
+        let calls = Arc::new(Mutex::new(Vec::new()));
+        db.set_slow_query_hook(Duration::ZERO, {
+            let db = db.clone();
+            let calls = calls.clone();
+            move |query| {
+                // Clearing the hook from inside the hook must not free it while it runs
+                db.clear_slow_query_hook();
+                calls.lock().unwrap().push(query.sql.to_string());
+            }
+        });
+        db.query_some::<i64>("SELECT 1", ())?;
+        db.query_some::<i64>("SELECT 2", ())?;
+        assert_eq!(*calls.lock().unwrap(), vec!["SELECT 1".to_string()]);
+        Ok(())
+    }
+
+    fn cached_statements(db: &Connection) -> usize {
+        db.0 .1.lock().unwrap().statements.len()
+    }
+
+    #[test]
+    fn test_statement_cache_reuses_statements() -> Result<(), StatementError> {
+        let db = Connection::open_memory().unwrap();
+        db.execute("CREATE TABLE nums (n INTEGER NOT NULL)", ())?;
+        for i in 0i64..10 {
+            db.execute("INSERT INTO nums (n) VALUES (?)", i)?;
+        }
+        assert_eq!(cached_statements(&db), 2);
+
+        // A statement in use is taken out of the cache, a second user gets its own statement
+        let first = db.prepare::<i64>("SELECT COUNT(*) FROM nums")?;
+        let mut second = db.prepare::<i64>("SELECT COUNT(*) FROM nums")?;
+        assert_eq!(second.next().transpose()?, Some(10));
+        drop(first);
+        drop(second);
+        assert_eq!(cached_statements(&db), 4);
+
+        db.set_statement_cache_capacity(1);
+        assert_eq!(cached_statements(&db), 1);
+        db.set_statement_cache_capacity(0);
+        db.execute("INSERT INTO nums (n) VALUES (?)", 10)?;
+        assert_eq!(cached_statements(&db), 0);
+        Ok(())
+    }
+
+    #[test]
+    fn test_uncached_statement_keeps_connection_open() -> Result<(), StatementError> {
+        let db = Connection::open_memory().unwrap();
+        db.set_statement_cache_capacity(0);
+        let mut statement = db.prepare::<i64>("SELECT 42")?;
+        let connection = Arc::downgrade(&db.0);
+        drop(db);
+
+        // Without the cache the statement still holds the connection, so it closes after it
+        assert_eq!(statement.next().transpose()?, Some(42));
+        assert!(connection.upgrade().is_some());
+        drop(statement);
+        assert!(connection.upgrade().is_none());
+        Ok(())
+    }
+
+    #[test]
+    fn test_statement_cache_resets_statements() -> Result<(), StatementError> {
+        let db = Connection::open_memory().unwrap();
+        db.execute("CREATE TABLE nums (n INTEGER NOT NULL)", ())?;
+        for i in 0i64..10 {
+            db.execute("INSERT INTO nums (n) VALUES (?)", i)?;
+        }
+
+        // A statement dropped halfway must not keep the table locked
+        let mut rows = db.query::<i64>("SELECT n FROM nums ORDER BY n", ())?;
+        assert_eq!(rows.next().transpose()?, Some(0));
+        drop(rows);
+        db.execute("DROP TABLE nums", ())?;
+
+        // SQL without a statement prepares to a null handle that isn't cached
+        drop(db.prepare::<()>("")?);
+
+        // A cached statement starts with cleared bindings
+        assert_eq!(db.query_some::<Option<i64>>("SELECT ?", 42)?, Some(42));
+        let mut statement = db.prepare::<Option<i64>>("SELECT ?")?;
+        assert_eq!(statement.next().transpose()?, Some(None));
+        Ok(())
+    }
+
     #[cfg(feature = "uuid")]
     #[test]
     fn test_uuid_roundtrip() -> Result<(), StatementError> {
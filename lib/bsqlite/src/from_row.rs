@@ -5,7 +5,7 @@
  */
 
 use crate::value::ValueError;
-use crate::{RawStatement, Value};
+use crate::{FromValueRef, RawStatement, RowRef, Value};
 
 /// A trait for converting read values from a statement to a row
 pub trait FromRow: Sized {
@@ -55,3 +55,46 @@ impl_from_row_for_tuple!(0: A, 1: B, 2: C, 3: D, 4: E, 5: F, 6: G, 7: H, 8: I, 9
 impl_from_row_for_tuple!(0: A, 1: B, 2: C, 3: D, 4: E, 5: F, 6: G, 7: H, 8: I, 9: J, 10: K, 11: L, 12: M, 13: N);
 impl_from_row_for_tuple!(0: A, 1: B, 2: C, 3: D, 4: E, 5: F, 6: G, 7: H, 8: I, 9: J, 10: K, 11: L, 12: M, 13: N, 14: O);
 impl_from_row_for_tuple!(0: A, 1: B, 2: C, 3: D, 4: E, 5: F, 6: G, 7: H, 8: I, 9: J, 10: K, 11: L, 12: M, 13: N, 14: O, 15: P);
+
+/// A trait for converting a borrowed row to a type that can borrow text and blob values from it
+pub trait FromRowRef<'stmt>: Sized {
+    /// Convert a borrowed row
+    fn from_row_ref(row: RowRef<'stmt>) -> Result<Self, ValueError>;
+}
+
+impl<'stmt, T: FromValueRef<'stmt>> FromRowRef<'stmt> for T {
+    fn from_row_ref(row: RowRef<'stmt>) -> Result<Self, ValueError> {
+        row.get(0)
+    }
+}
+
+macro_rules! impl_from_row_ref_for_tuple {
+    ($($n:tt: $t:ident),*) => (
+        impl<'stmt, $($t,)*> FromRowRef<'stmt> for ($($t,)*)
+        where
+            $($t: FromValueRef<'stmt>,)+
+        {
+            fn from_row_ref(row: RowRef<'stmt>) -> Result<Self, ValueError> {
+                Ok((
+                    $(row.get::<$t>($n)?,)*
+                ))
+            }
+        }
+    );
+}
+impl_from_row_ref_for_tuple!(0: A);
+impl_from_row_ref_for_tuple!(0: A, 1: B);
+impl_from_row_ref_for_tuple!(0: A, 1: B, 2: C);
+impl_from_row_ref_for_tuple!(0: A, 1: B, 2: C, 3: D);
+impl_from_row_ref_for_tuple!(0: A, 1: B, 2: C, 3: D, 4: E);
+impl_from_row_ref_for_tuple!(0: A, 1: B, 2: C, 3: D, 4: E, 5: F);
+impl_from_row_ref_for_tuple!(0: A, 1: B, 2: C, 3: D, 4: E, 5: F, 6: G);
+impl_from_row_ref_for_tuple!(0: A, 1: B, 2: C, 3: D, 4: E, 5: F, 6: G, 7: H);
+impl_from_row_ref_for_tuple!(0: A, 1: B, 2: C, 3: D, 4: E, 5: F, 6: G, 7: H, 8: I);
+impl_from_row_ref_for_tuple!(0: A, 1: B, 2: C, 3: D, 4: E, 5: F, 6: G, 7: H, 8: I, 9: J);
+impl_from_row_ref_for_tuple!(0: A, 1: B, 2: C, 3: D, 4: E, 5: F, 6: G, 7: H, 8: I, 9: J, 10: K);
+impl_from_row_ref_for_tuple!(0: A, 1: B, 2: C, 3: D, 4: E, 5: F, 6: G, 7: H, 8: I, 9: J, 10: K, 11: L);
+impl_from_row_ref_for_tuple!(0: A, 1: B, 2: C, 3: D, 4: E, 5: F, 6: G, 7: H, 8: I, 9: J, 10: K, 11: L, 12: M);
+impl_from_row_ref_for_tuple!(0: A, 1: B, 2: C, 3: D, 4: E, 5: F, 6: G, 7: H, 8: I, 9: J, 10: K, 11: L, 12: M, 13: N);
+impl_from_row_ref_for_tuple!(0: A, 1: B, 2: C, 3: D, 4: E, 5: F, 6: G, 7: H, 8: I, 9: J, 10: K, 11: L, 12: M, 13: N, 14: O);
+impl_from_row_ref_for_tuple!(0: A, 1: B, 2: C, 3: D, 4: E, 5: F, 6: G, 7: H, 8: I, 9: J, 10: K, 11: L, 12: M, 13: N, 14: O, 15: P);
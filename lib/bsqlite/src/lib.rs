@@ -9,17 +9,21 @@
 
 pub use crate::bind::Bind;
 pub use crate::connection::{Connection, ConnectionError, OpenMode};
-pub use crate::from_row::FromRow;
+pub use crate::from_row::{FromRow, FromRowRef};
 pub use crate::migration::{Migration, MigrationError};
-pub use crate::statement::{ColumnType, RawStatement, Statement, StatementError};
+pub use crate::pool::{Pool, PooledConnection};
+pub use crate::statement::{ColumnType, RawStatement, RowRef, Statement, StatementError};
+pub use crate::stats::{ConnectionStats, SlowQuery, StatementStats};
 pub use crate::utils::preprocess_fts_query;
-pub use crate::value::{Value, ValueError};
+pub use crate::value::{FromValueRef, Value, ValueError, ValueRef};
 
 mod bind;
 mod connection;
 mod from_row;
 mod migration;
+mod pool;
 mod statement;
+mod stats;
 mod utils;
 mod value;
 
@@ -0,0 +1,231 @@
+/*
+ * Copyright (c) 2026 Bastiaan van der Plaat
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+use std::ops::Deref;
+use std::path::Path;
+use std::sync::{Arc, Condvar, Mutex};
+use std::thread;
+
+use crate::{Connection, ConnectionError, OpenMode, StatementError};
+
+// MARK: Queue
+struct Queue {
+    idle: Mutex<Vec<Connection>>,
+    available: Condvar,
+}
+
+impl Queue {
+    const fn new(connections: Vec<Connection>) -> Self {
+        Self {
+            idle: Mutex::new(connections),
+            available: Condvar::new(),
+        }
+    }
+
+    fn checkout(&self) -> Connection {
+        let mut idle = self.idle.lock().expect("Can't get lock");
+        loop {
+            if let Some(connection) = idle.pop() {
+                return connection;
+            }
+            idle = self.available.wait(idle).expect("Can't get lock");
+        }
+    }
+
+    fn checkin(&self, connection: Connection) {
+        self.idle.lock().expect("Can't get lock").push(connection);
+        self.available.notify_one();
+    }
+}
+
+// MARK: Pooled Connection
+/// A connection checked out from a [`Pool`], it returns to the pool when dropped
+pub struct PooledConnection<'a> {
+    queue: &'a Queue,
+    connection: Option<Connection>,
+}
+
+impl Deref for PooledConnection<'_> {
+    type Target = Connection;
+
+    fn deref(&self) -> &Connection {
+        self.connection
+            .as_ref()
+            .expect("Connection should be checked out")
+    }
+}
+
+impl Drop for PooledConnection<'_> {
+    fn drop(&mut self) {
+        if let Some(connection) = self.connection.take() {
+            self.queue.checkin(connection);
+        }
+    }
+}
+
+// MARK: Pool
+struct InnerPool {
+    writer: Queue,
+    readers: Queue,
+}
+
+/// A pool of connections to a database file in Write-Ahead Logging mode with one writer and
+/// multiple readers, so read queries of multiple threads run in parallel
+///
+/// Every connection has its own statement cache, statements should be dropped before their
+/// connection is returned to the pool.
+#[derive(Clone)]
+pub struct Pool(Arc<InnerPool>);
+
+impl Pool {
+    /// Open a pool with one reader connection per available core
+    pub fn open(path: impl AsRef<Path>) -> Result<Self, ConnectionError> {
+        let readers = thread::available_parallelism().map_or(1, |count| count.get());
+        Self::open_with_readers(path, readers)
+    }
+
+    /// Open a pool with a number of reader connections
+    pub fn open_with_readers(
+        path: impl AsRef<Path>,
+        readers: usize,
+    ) -> Result<Self, ConnectionError> {
+        // The writer creates the database and switches it to Write-Ahead Logging before the
+        // read only connections open it
+        let path = path.as_ref();
+        let writer = Connection::open(path, OpenMode::ReadWrite)?;
+        writer.enable_wal_logging().map_err(setup_error)?;
+        writer
+            .apply_various_performance_settings()
+            .map_err(setup_error)?;
+
+        let readers = (0..readers.max(1))
+            .map(|_| {
+                let reader = Connection::open(path, OpenMode::ReadOnly)?;
+                reader
+                    .apply_various_performance_settings()
+                    .map_err(setup_error)?;
+                Ok(reader)
+            })
+            .collect::<Result<Vec<_>, ConnectionError>>()?;
+
+        Ok(Pool(Arc::new(InnerPool {
+            writer: Queue::new(vec![writer]),
+            readers: Queue::new(readers),
+        })))
+    }
+
+    /// Check out the writer connection, waits until the writer is free
+    pub fn writer(&self) -> PooledConnection<'_> {
+        PooledConnection {
+            queue: &self.0.writer,
+            connection: Some(self.0.writer.checkout()),
+        }
+    }
+
+    /// Check out a reader connection, waits until a reader is free
+    pub fn reader(&self) -> PooledConnection<'_> {
+        PooledConnection {
+            queue: &self.0.readers,
+            connection: Some(self.0.readers.checkout()),
+        }
+    }
+}
+
+fn setup_error(error: StatementError) -> ConnectionError {
+    ConnectionError {
+        msg: format!("Failed to setup pool connection: {}", error.msg),
+    }
+}
+
+// MARK: Tests
+#[cfg(test)]
+mod test {
+    use std::fs;
+    use std::path::PathBuf;
+
+    use super::*;
+
+    struct TempDatabase(PathBuf);
+
+    impl TempDatabase {
+        fn new(name: &str) -> Self {
+            let path =
+                std::env::temp_dir().join(format!("bsqlite-{}-{name}.db", std::process::id()));
+            let database = Self(path);
+            database.remove();
+            database
+        }
+
+        fn remove(&self) {
+            for suffix in ["", "-wal", "-shm"] {
+                let mut path = self.0.clone().into_os_string();
+                path.push(suffix);
+                _ = fs::remove_file(path);
+            }
+        }
+    }
+
+    impl Drop for TempDatabase {
+        fn drop(&mut self) {
+            self.remove();
+        }
+    }
+
+    #[test]
+    fn test_pool_routes_reads_and_writes() -> Result<(), StatementError> {
+        let database = TempDatabase::new("routes");
+        let pool = Pool::open_with_readers(&database.0, 2).unwrap();
+        {
+            let writer = pool.writer();
+            writer.execute("CREATE TABLE nums (n INTEGER NOT NULL)", ())?;
+            writer.execute("INSERT INTO nums (n) VALUES (?), (?)", (1, 2))?;
+        }
+
+        // Readers see the committed rows but can't write
+        let reader = pool.reader();
+        assert_eq!(reader.query_some::<i64>("SELECT SUM(n) FROM nums", ())?, 3);
+        assert!(reader
+            .execute("INSERT INTO nums (n) VALUES (3)", ())
+            .is_err());
+        assert_eq!(
+            reader.query_some::<String>("PRAGMA journal_mode", ())?,
+            "wal"
+        );
+        Ok(())
+    }
+
+    #[test]
+    fn test_pool_reads_in_parallel() -> Result<(), StatementError> {
+        let database = TempDatabase::new("parallel");
+        let pool = Pool::open_with_readers(&database.0, 2).unwrap();
+        pool.writer()
+            .execute("CREATE TABLE nums (n INTEGER NOT NULL)", ())?;
+
+        // Both readers can be checked out at the same time next to the writer
+        let first = pool.reader();
+        let second = pool.reader();
+        pool.writer()
+            .execute("INSERT INTO nums (n) VALUES (1)", ())?;
+        assert_eq!(first.query_some::<i64>("SELECT COUNT(*) FROM nums", ())?, 1);
+        assert_eq!(
+            second.query_some::<i64>("SELECT COUNT(*) FROM nums", ())?,
+            1
+        );
+
+        // A third reader waits until one is returned
+        let handle = thread::spawn({
+            let pool = pool.clone();
+            move || {
+                pool.reader()
+                    .query_some::<i64>("SELECT COUNT(*) FROM nums", ())
+                    .unwrap()
+            }
+        });
+        drop(first);
+        assert_eq!(handle.join().unwrap(), 1);
+        Ok(())
+    }
+}
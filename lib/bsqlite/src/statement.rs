@@ -8,10 +8,13 @@ use std::error::Error;
 use std::ffi::{c_char, c_void, CStr, CString};
 use std::fmt::{self, Display, Formatter};
 use std::marker::PhantomData;
+use std::sync::Arc;
 
 use libsqlite3_sys::*;
 
-use crate::{Bind, FromRow, Value};
+use crate::connection::InnerConnection;
+use crate::stats::{self, StatementStats};
+use crate::{Bind, FromRow, FromRowRef, FromValueRef, Value, ValueError, ValueRef};
 
 // MARK: Statement Error
 /// A statement error
@@ -35,6 +38,14 @@ impl Display for StatementError {
 
 impl Error for StatementError {}
 
+impl From<ValueError> for StatementError {
+    fn from(error: ValueError) -> Self {
+        Self {
+            msg: error.to_string(),
+        }
+    }
+}
+
 // MARK: Column Type
 /// Column type
 #[derive(Debug, Clone, Copy, PartialEq, Eq)]
@@ -53,11 +64,25 @@ pub enum ColumnType {
 
 // MARK: Raw Statement
 /// Raw SQLite statement without type information
-pub struct RawStatement(*mut sqlite3_stmt);
+///
+/// Bound text and blob values are kept alive by the statement until they are rebound, the
+/// bindings are cleared or the statement is finalized, so SQLite doesn't need to copy them.
+pub struct RawStatement(
+    *mut sqlite3_stmt,
+    Arc<InnerConnection>,
+    Vec<Value>,
+    Option<Box<str>>,
+);
 
 impl RawStatement {
-    pub(crate) const fn new(statement: *mut sqlite3_stmt) -> Self {
-        Self(statement)
+    /// The statement keeps its connection open, when SQL text is given the statement returns to
+    /// the statement cache of the connection on drop instead of being finalized
+    pub(crate) const fn new(
+        statement: *mut sqlite3_stmt,
+        connection: Arc<InnerConnection>,
+        cache_sql: Option<Box<str>>,
+    ) -> Self {
+        Self(statement, connection, Vec::new(), cache_sql)
     }
 
     /// Reset the statement
@@ -66,6 +91,13 @@ impl RawStatement {
         unsafe { sqlite3_reset(self.0) };
     }
 
+    /// Clear the bindings of the statement, all parameters become NULL
+    pub fn clear_bindings(&mut self) {
+        // SAFETY: self.0 is a valid prepared statement handle.
+        unsafe { sqlite3_clear_bindings(self.0) };
+        self.2.clear();
+    }
+
     /// Bind values to the statement
     pub fn bind(&mut self, params: impl Bind) -> Result<(), StatementError> {
         params.bind(self)
@@ -74,7 +106,7 @@ impl RawStatement {
     /// Bind value to the statement
     pub fn bind_value(&mut self, index: i32, value: Value) -> Result<(), StatementError> {
         let index = index + 1;
-        let result = match value {
+        let result = match &value {
             Value::Null => {
                 // SAFETY: self.0 is a valid prepared statement handle and index is a valid
                 // 1-based parameter index.
@@ -83,27 +115,28 @@ impl RawStatement {
             Value::Integer(i) => {
                 // SAFETY: self.0 is a valid prepared statement handle and index is a valid
                 // 1-based parameter index.
-                unsafe { sqlite3_bind_int64(self.0, index, i) }
+                unsafe { sqlite3_bind_int64(self.0, index, *i) }
             }
             Value::Float(f) => {
                 // SAFETY: self.0 is a valid prepared statement handle and index is a valid
                 // 1-based parameter index.
-                unsafe { sqlite3_bind_double(self.0, index, f) }
+                unsafe { sqlite3_bind_double(self.0, index, *f) }
             }
             Value::Text(s) => {
                 let len = i32::try_from(s.len()).map_err(|_| StatementError {
                     msg: "text value too large to bind".to_string(),
                 })?;
-                // SAFETY: self.0 is a valid prepared statement, index is valid, s.as_ptr() points
-                // to valid UTF-8 bytes for the given len, and SQLITE_TRANSIENT causes SQLite to
-                // copy the data before returning.
+                // SAFETY: self.0 is a valid prepared statement, index is valid and s.as_ptr() points
+                // to valid UTF-8 bytes for the given len. The string is moved into self.2 below,
+                // which doesn't move its heap buffer, and it's only dropped after SQLite stopped
+                // using it, so SQLITE_STATIC is safe.
                 unsafe {
                     sqlite3_bind_text(
                         self.0,
                         index,
                         s.as_ptr() as *const c_char,
                         len,
-                        SQLITE_TRANSIENT(),
+                        SQLITE_STATIC(),
                     )
                 }
             }
@@ -111,16 +144,17 @@ impl RawStatement {
                 let len = i32::try_from(b.len()).map_err(|_| StatementError {
                     msg: "blob value too large to bind".to_string(),
                 })?;
-                // SAFETY: self.0 is a valid prepared statement, index is valid, b.as_ptr() points
-                // to valid bytes for the given len, and SQLITE_TRANSIENT causes SQLite to copy
-                // the data before returning.
+                // SAFETY: self.0 is a valid prepared statement, index is valid and b.as_ptr() points
+                // to valid bytes for the given len. The blob is moved into self.2 below, which
+                // doesn't move its heap buffer, and it's only dropped after SQLite stopped using
+                // it, so SQLITE_STATIC is safe.
                 unsafe {
                     sqlite3_bind_blob(
                         self.0,
                         index,
                         b.as_ptr() as *const c_void,
                         len,
-                        SQLITE_TRANSIENT(),
+                        SQLITE_STATIC(),
                     )
                 }
             }
@@ -137,6 +171,14 @@ impl RawStatement {
                 msg: format!("Failed to bind value to statement '{query}': {error}"),
             });
         }
+
+        // Keep the value alive until the parameter is bound again, the old value of the parameter
+        // is dropped here because SQLite doesn't use it anymore
+        let slot = index as usize - 1;
+        if self.2.len() <= slot {
+            self.2.resize_with(slot + 1, || Value::Null);
+        }
+        self.2[slot] = value;
         Ok(())
     }
 
@@ -176,6 +218,16 @@ impl RawStatement {
         }
     }
 
+    /// Step the statement and borrow the read row, see [RowRef]
+    pub fn next_row(&mut self) -> Result<Option<RowRef<'_>>, StatementError> {
+        Ok(self.step()?.map(|()| RowRef(self)))
+    }
+
+    /// Get the runtime counters of the statement
+    pub fn stats(&self) -> StatementStats {
+        stats::statement_stats(self.0)
+    }
+
     /// Get the number of columns in the statement
     pub fn column_count(&self) -> i32 {
         // SAFETY: self.0 is a valid prepared statement handle.
@@ -300,10 +352,88 @@ impl RawStatement {
 }
 
 impl Drop for RawStatement {
+    // The bound values in self.2 are dropped after this, when SQLite doesn't use them anymore
     fn drop(&mut self) {
-        // SAFETY: self.0 is the exclusively owned statement handle; Drop guarantees no other
-        // references exist, and sqlite3_finalize frees the handle exactly once.
-        unsafe { sqlite3_finalize(self.0) };
+        if let Some(sql) = self.3.take() {
+            self.1.release_statement(sql, self.0);
+        } else {
+            // SAFETY: self.0 is the exclusively owned statement handle; Drop guarantees no other
+            // references exist, and sqlite3_finalize frees the handle exactly once.
+            unsafe { sqlite3_finalize(self.0) };
+        }
+    }
+}
+
+// MARK: Row Ref
+/// A borrowed row of a statement, its text and blob values point straight into the memory of
+/// SQLite and stay valid until the statement is stepped again
+#[derive(Clone, Copy)]
+pub struct RowRef<'stmt>(&'stmt RawStatement);
+
+impl<'stmt> RowRef<'stmt> {
+    /// Get the number of columns in the row
+    pub fn column_count(&self) -> i32 {
+        self.0.column_count()
+    }
+
+    /// Get the type of a column
+    pub fn column_type(&self, index: i32) -> ColumnType {
+        self.0.column_type(index)
+    }
+
+    /// Get the borrowed value of a column
+    pub fn column_value(&self, index: i32) -> Result<ValueRef<'stmt>, ValueError> {
+        let statement = self.0 .0;
+        Ok(match self.column_type(index) {
+            ColumnType::Null => ValueRef::Null,
+            ColumnType::Integer => {
+                // SAFETY: statement is valid, index is in bounds, and the column type is INTEGER.
+                ValueRef::Integer(unsafe { sqlite3_column_int64(statement, index) })
+            }
+            ColumnType::Float => {
+                // SAFETY: statement is valid, index is in bounds, and the column type is FLOAT.
+                ValueRef::Float(unsafe { sqlite3_column_double(statement, index) })
+            }
+            ColumnType::Text => {
+                let bytes = self.column_bytes(index, true);
+                ValueRef::Text(std::str::from_utf8(bytes).map_err(|_| {
+                    ValueError::new(format!("Column {index} contains invalid UTF-8 text"))
+                })?)
+            }
+            ColumnType::Blob => ValueRef::Blob(self.column_bytes(index, false)),
+        })
+    }
+
+    /// Get the value of a column converted to a type, `&str` and `&[u8]` borrow from the row
+    pub fn get<T: FromValueRef<'stmt>>(&self, index: i32) -> Result<T, ValueError> {
+        T::from_value_ref(self.column_value(index)?)
+    }
+
+    /// Convert the row to a type, like a tuple or a struct that derives [FromRow] with a lifetime
+    pub fn read<T: FromRowRef<'stmt>>(self) -> Result<T, ValueError> {
+        T::from_row_ref(self)
+    }
+
+    fn column_bytes(&self, index: i32, text: bool) -> &'stmt [u8] {
+        let statement = self.0 .0;
+        // SAFETY: statement is valid and index is in bounds. The column already has the requested
+        // type so SQLite doesn't convert it, which would invalidate earlier returned pointers.
+        let data = unsafe {
+            if text {
+                sqlite3_column_text(statement, index) as *const u8
+            } else {
+                sqlite3_column_blob(statement, index) as *const u8
+            }
+        };
+        if data.is_null() {
+            return &[];
+        }
+        // SAFETY: Called on the same column right after sqlite3_column_text or sqlite3_column_blob
+        // to get the byte length of that value.
+        let len = unsafe { sqlite3_column_bytes(statement, index) };
+        // SAFETY: data is non-null with len bytes, it stays valid until the statement is stepped,
+        // reset or finalized, which needs a mutable borrow that the 'stmt borrow prevents.
+        unsafe { std::slice::from_raw_parts(data, len as usize) }
     }
 }
 
@@ -312,8 +442,8 @@ impl Drop for RawStatement {
 pub struct Statement<T>(RawStatement, PhantomData<T>);
 
 impl<T> Statement<T> {
-    pub(crate) const fn new(statement: *mut sqlite3_stmt) -> Self {
-        Self(RawStatement::new(statement), PhantomData)
+    pub(crate) const fn new(statement: RawStatement) -> Self {
+        Self(statement, PhantomData)
     }
 
     /// Reset the statement
@@ -321,6 +451,11 @@ impl<T> Statement<T> {
         self.0.reset();
     }
 
+    /// Clear the bindings of the statement, all parameters become NULL
+    pub fn clear_bindings(&mut self) {
+        self.0.clear_bindings();
+    }
+
     /// Bind values to the statement
     pub fn bind(&mut self, params: impl Bind) -> Result<(), StatementError> {
         self.0.bind(params)
@@ -349,6 +484,16 @@ impl<T> Statement<T> {
         self.0.step()
     }
 
+    /// Step the statement and borrow the read row, see [RowRef]
+    pub fn next_row(&mut self) -> Result<Option<RowRef<'_>>, StatementError> {
+        self.0.next_row()
+    }
+
+    /// Get the runtime counters of the statement
+    pub fn stats(&self) -> StatementStats {
+        self.0.stats()
+    }
+
     /// Get the number of columns in the statement
     pub fn column_count(&self) -> i32 {
         self.0.column_count()
@@ -402,7 +547,7 @@ impl<T: FromRow> Iterator for Statement<T> {
 // MARK: Tests
 #[cfg(test)]
 mod tests {
-    use crate::{ColumnType, Connection, StatementError, Value};
+    use crate::{ColumnType, Connection, StatementError, Value, ValueRef};
 
     #[test]
     fn test_statement_metadata_and_column_accessors() -> Result<(), StatementError> {
@@ -490,6 +635,68 @@ mod tests {
         Ok(())
     }
 
+    #[test]
+    fn test_bound_values_outlive_rebinding() -> Result<(), StatementError> {
+        let db = Connection::open_memory().unwrap();
+        let mut statement = db.prepare::<(String, Vec<u8>, String)>("SELECT ?, ?, ?")?;
+
+        // Values bound without copy stay valid until the parameter is bound again
+        statement.bind(("first".to_string(), vec![1_u8, 2], "kept".to_string()))?;
+        assert_eq!(
+            statement.next().transpose()?,
+            Some(("first".to_string(), vec![1, 2], "kept".to_string()))
+        );
+        statement.reset();
+        statement.bind_value(0, "second".to_string())?;
+        statement.bind_value(1, vec![3_u8])?;
+        assert_eq!(
+            statement.next().transpose()?,
+            Some(("second".to_string(), vec![3], "kept".to_string()))
+        );
+
+        statement.reset();
+        statement.clear_bindings();
+        assert_eq!(statement.step()?, Some(()));
+        assert_eq!(statement.column_type(0), ColumnType::Null);
+        assert_eq!(statement.column_type(1), ColumnType::Null);
+        Ok(())
+    }
+
+    #[test]
+    fn test_row_ref_borrows_text_and_blob() -> Result<(), StatementError> {
+        let db = Connection::open_memory().unwrap();
+        db.execute(
+            "CREATE TABLE items (name TEXT NOT NULL, payload BLOB, score INTEGER NOT NULL)",
+            (),
+        )?;
+        db.execute(
+            "INSERT INTO items (name, payload, score) VALUES (?, ?, ?), (?, ?, ?)",
+            (
+                "widget",
+                vec![1_u8, 2_u8],
+                3,
+                "gadget",
+                Option::<Vec<u8>>::None,
+                4,
+            ),
+        )?;
+
+        let mut statement = db.prepare::<()>("SELECT name, payload, score FROM items")?;
+        let row = statement.next_row()?.expect("expected row");
+        assert_eq!(row.column_value(0)?, ValueRef::Text("widget"));
+        let name: &str = row.get(0)?;
+        let payload: &[u8] = row.get(1)?;
+        assert_eq!((name, payload), ("widget", &[1_u8, 2_u8][..]));
+        assert_eq!(row.get::<String>(0)?, "widget");
+        assert!(row.get::<&[u8]>(0).is_err());
+
+        let row = statement.next_row()?.expect("expected row");
+        let (name, payload, score) = row.read::<(&str, Option<&[u8]>, i64)>()?;
+        assert_eq!((name, payload, score), ("gadget", None, 4));
+        assert!(statement.next_row()?.is_none());
+        Ok(())
+    }
+
     #[test]
     fn test_bind_named_value_reports_missing_parameter() {
         let db = Connection::open_memory().unwrap();
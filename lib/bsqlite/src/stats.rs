@@ -0,0 +1,214 @@
+/*
+ * Copyright (c) 2026 Bastiaan van der Plaat
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+use std::ffi::{c_uint, c_void, CStr};
+use std::panic::{self, AssertUnwindSafe};
+use std::sync::{Arc, Mutex, PoisonError};
+use std::time::Duration;
+
+use libsqlite3_sys::*;
+
+// MARK: Connection Stats
+/// Runtime statistics of a connection and the memory SQLite uses
+#[derive(Debug, Clone, Copy, Default, PartialEq, Eq)]
+pub struct ConnectionStats {
+    /// Number of lookaside memory slots in use
+    pub lookaside_used: i32,
+    /// Number of allocations served from lookaside memory
+    pub lookaside_hits: i32,
+    /// Number of allocations that didn't fit in or found no free lookaside slot
+    pub lookaside_misses: i32,
+    /// Bytes of page cache memory used
+    pub cache_used: i32,
+    /// Number of page cache hits
+    pub cache_hits: i32,
+    /// Number of page cache misses
+    pub cache_misses: i32,
+    /// Number of dirty pages written to the database file
+    pub cache_writes: i32,
+    /// Number of dirty pages written to the database file in the middle of a transaction
+    pub cache_spills: i32,
+    /// Bytes of memory used by the schemas
+    pub schema_used: i32,
+    /// Bytes of memory used by the prepared statements
+    pub statement_used: i32,
+    /// Bytes of memory SQLite allocated in the whole process, 0 when memory statistics are disabled
+    pub memory_used: i64,
+    /// Highest bytes of memory SQLite allocated in the whole process
+    pub memory_highwater: i64,
+    /// Bytes of page cache allocations that didn't fit in the page cache memory of the process
+    pub page_cache_overflow: i64,
+}
+
+impl ConnectionStats {
+    /// The ratio of page cache lookups that were hits
+    pub fn cache_hit_ratio(&self) -> f64 {
+        let lookups = self.cache_hits as f64 + self.cache_misses as f64;
+        if lookups > 0.0 {
+            self.cache_hits as f64 / lookups
+        } else {
+            0.0
+        }
+    }
+}
+
+pub(crate) fn connection_stats(db: *mut sqlite3) -> ConnectionStats {
+    let db_status = |op| {
+        let (mut current, mut highwater) = (0, 0);
+        // SAFETY: db is a valid open db handle, op is a valid status code, and current and
+        // highwater are valid pointers to ints.
+        unsafe { sqlite3_db_status(db, op, &mut current, &mut highwater, 0) };
+        (current, highwater)
+    };
+    let status = |op| {
+        let (mut current, mut highwater) = (0, 0);
+        // SAFETY: op is a valid status code, and current and highwater are valid pointers.
+        unsafe { sqlite3_status64(op, &mut current, &mut highwater, 0) };
+        (current, highwater)
+    };
+
+    // The lookaside hit and miss counters are only reported as highwater
+    let (memory_used, memory_highwater) = status(SQLITE_STATUS_MEMORY_USED);
+    ConnectionStats {
+        lookaside_used: db_status(SQLITE_DBSTATUS_LOOKASIDE_USED).0,
+        lookaside_hits: db_status(SQLITE_DBSTATUS_LOOKASIDE_HIT).1,
+        lookaside_misses: db_status(SQLITE_DBSTATUS_LOOKASIDE_MISS_SIZE).1
+            + db_status(SQLITE_DBSTATUS_LOOKASIDE_MISS_FULL).1,
+        cache_used: db_status(SQLITE_DBSTATUS_CACHE_USED).0,
+        cache_hits: db_status(SQLITE_DBSTATUS_CACHE_HIT).0,
+        cache_misses: db_status(SQLITE_DBSTATUS_CACHE_MISS).0,
+        cache_writes: db_status(SQLITE_DBSTATUS_CACHE_WRITE).0,
+        cache_spills: db_status(SQLITE_DBSTATUS_CACHE_SPILL).0,
+        schema_used: db_status(SQLITE_DBSTATUS_SCHEMA_USED).0,
+        statement_used: db_status(SQLITE_DBSTATUS_STMT_USED).0,
+        memory_used,
+        memory_highwater,
+        page_cache_overflow: status(SQLITE_STATUS_PAGECACHE_OVERFLOW).0,
+    }
+}
+
+// MARK: Statement Stats
+/// Runtime counters of a statement since it was prepared or taken from the statement cache
+#[derive(Debug, Clone, Copy, Default, PartialEq, Eq)]
+pub struct StatementStats {
+    /// Number of steps through a table in a full scan, a high number means an index is missing
+    pub fullscan_steps: i32,
+    /// Number of sort operations
+    pub sorts: i32,
+    /// Number of rows inserted in automatic indexes, a high number means an index is missing
+    pub autoindexes: i32,
+    /// Number of virtual machine operations
+    pub vm_steps: i32,
+}
+
+pub(crate) fn statement_stats(statement: *mut sqlite3_stmt) -> StatementStats {
+    // SAFETY: statement is a valid prepared statement handle and op is a valid status code.
+    let stmt_status = |op| unsafe { sqlite3_stmt_status(statement, op, 0) };
+    StatementStats {
+        fullscan_steps: stmt_status(SQLITE_STMTSTATUS_FULLSCAN_STEP),
+        sorts: stmt_status(SQLITE_STMTSTATUS_SORT),
+        autoindexes: stmt_status(SQLITE_STMTSTATUS_AUTOINDEX),
+        vm_steps: stmt_status(SQLITE_STMTSTATUS_VM_STEP),
+    }
+}
+
+pub(crate) fn reset_statement_stats(statement: *mut sqlite3_stmt) {
+    for op in [
+        SQLITE_STMTSTATUS_FULLSCAN_STEP,
+        SQLITE_STMTSTATUS_SORT,
+        SQLITE_STMTSTATUS_AUTOINDEX,
+        SQLITE_STMTSTATUS_VM_STEP,
+    ] {
+        // SAFETY: statement is a valid prepared statement handle and op is a valid status code.
+        unsafe { sqlite3_stmt_status(statement, op, 1) };
+    }
+}
+
+// MARK: Slow Query Hook
+/// A statement that ran longer than the threshold of the slow query hook
+#[derive(Debug)]
+pub struct SlowQuery<'a> {
+    /// The SQL text of the statement
+    pub sql: &'a str,
+    /// The time the statement ran
+    pub duration: Duration,
+    /// The counters of the statement
+    pub stats: StatementStats,
+}
+
+pub(crate) struct SlowQueryHook {
+    threshold: Duration,
+    callback: Box<dyn Fn(&SlowQuery) + Send + Sync>,
+}
+
+impl SlowQueryHook {
+    pub(crate) fn new(
+        threshold: Duration,
+        callback: impl Fn(&SlowQuery) + Send + Sync + 'static,
+    ) -> Arc<Self> {
+        Arc::new(Self {
+            threshold,
+            callback: Box::new(callback),
+        })
+    }
+}
+
+/// The slot with the slow query hook of a connection, SQLite gets a pointer to the slot instead
+/// of the hook, so replacing the hook from inside the hook doesn't free it while it runs
+pub(crate) type SlowQueryHookSlot = Mutex<Option<Arc<SlowQueryHook>>>;
+
+/// Register the slot with SQLite, registering the same slot again does nothing, the slot must stay
+/// alive until the db handle is closed
+pub(crate) fn register_slow_query_hook(db: *mut sqlite3, slot: &SlowQueryHookSlot) {
+    // SAFETY: db is a valid open db handle, the callback matches the trace_v2 signature and slot
+    // points to a SlowQueryHookSlot that the connection keeps alive until it's closed.
+    unsafe {
+        sqlite3_trace_v2(
+            db,
+            SQLITE_TRACE_PROFILE,
+            Some(slow_query_callback),
+            slot as *const SlowQueryHookSlot as *mut c_void,
+        )
+    };
+}
+
+unsafe extern "C" fn slow_query_callback(
+    _mask: c_uint,
+    context: *mut c_void,
+    statement: *mut c_void,
+    nanoseconds: *mut c_void,
+) -> i32 {
+    // SAFETY: context is the SlowQueryHookSlot registered with sqlite3_trace_v2 that stays alive
+    // until the connection is closed, and for SQLITE_TRACE_PROFILE nanoseconds points to a
+    // sqlite3_int64.
+    let (slot, nanoseconds) = unsafe {
+        (
+            &*(context as *const SlowQueryHookSlot),
+            *(nanoseconds as *const i64),
+        )
+    };
+    // The hook is cloned out of the slot, so the lock isn't held while it runs and it stays alive
+    // when the hook replaces or clears itself
+    let Some(hook) = slot.lock().unwrap_or_else(PoisonError::into_inner).clone() else {
+        return 0;
+    };
+    let duration = Duration::from_nanos(nanoseconds.max(0) as u64);
+    if duration < hook.threshold {
+        return 0;
+    }
+
+    // SAFETY: statement is the valid prepared statement that finished running, sqlite3_sql returns
+    // a NUL-terminated string that lives as long as the statement.
+    let sql = unsafe { CStr::from_ptr(sqlite3_sql(statement)) }.to_string_lossy();
+    let query = SlowQuery {
+        sql: &sql,
+        duration,
+        stats: statement_stats(statement),
+    };
+    // A panic can't unwind through SQLite, so it's caught and the hook is ignored
+    _ = panic::catch_unwind(AssertUnwindSafe(|| (hook.callback)(&query)));
+    0
+}
@@ -21,6 +21,33 @@ pub enum Value {
     Blob(Vec<u8>),
 }
 
+/// A SQLite value that borrows its text and blob from the current row of a statement
+#[derive(Debug, Clone, Copy, PartialEq)]
+pub enum ValueRef<'a> {
+    /// A NULL value
+    Null,
+    /// An 64-bit integer value
+    Integer(i64),
+    /// A 64-bit floating point value
+    Float(f64),
+    /// A text value
+    Text(&'a str),
+    /// A blob value
+    Blob(&'a [u8]),
+}
+
+impl From<ValueRef<'_>> for Value {
+    fn from(value: ValueRef<'_>) -> Self {
+        match value {
+            ValueRef::Null => Value::Null,
+            ValueRef::Integer(v) => Value::Integer(v),
+            ValueRef::Float(v) => Value::Float(v),
+            ValueRef::Text(v) => Value::Text(v.to_string()),
+            ValueRef::Blob(v) => Value::Blob(v.to_vec()),
+        }
+    }
+}
+
 // MARK: ValueError
 type Result<T> = std::result::Result<T, ValueError>;
 
@@ -351,6 +378,97 @@ impl TryFrom<Value> for Option<Vec<u8>> {
     }
 }
 
+// MARK: From &T
+impl From<&str> for Value {
+    fn from(value: &str) -> Self {
+        Value::Text(value.to_string())
+    }
+}
+
+impl From<&[u8]> for Value {
+    fn from(value: &[u8]) -> Self {
+        Value::Blob(value.to_vec())
+    }
+}
+
+impl From<Option<&str>> for Value {
+    fn from(value: Option<&str>) -> Self {
+        match value {
+            Some(v) => Value::Text(v.to_string()),
+            None => Value::Null,
+        }
+    }
+}
+
+impl From<Option<&[u8]>> for Value {
+    fn from(value: Option<&[u8]>) -> Self {
+        match value {
+            Some(v) => Value::Blob(v.to_vec()),
+            None => Value::Null,
+        }
+    }
+}
+
+// MARK: FromValueRef
+/// A trait for converting a borrowed value of the current row, borrowed types like `&str` and
+/// `&[u8]` point into the statement and all other types are converted from an owned [Value]
+pub trait FromValueRef<'a>: Sized {
+    /// Convert a borrowed value
+    fn from_value_ref(value: ValueRef<'a>) -> Result<Self>;
+}
+
+impl<T: TryFrom<Value, Error = ValueError>> FromValueRef<'_> for T {
+    fn from_value_ref(value: ValueRef<'_>) -> Result<Self> {
+        T::try_from(value.into())
+    }
+}
+
+impl<'a> FromValueRef<'a> for &'a str {
+    fn from_value_ref(value: ValueRef<'a>) -> Result<Self> {
+        match value {
+            ValueRef::Text(v) => Ok(v),
+            _ => Err(ValueError {
+                msg: "expected text".to_string(),
+            }),
+        }
+    }
+}
+
+impl<'a> FromValueRef<'a> for &'a [u8] {
+    fn from_value_ref(value: ValueRef<'a>) -> Result<Self> {
+        match value {
+            ValueRef::Blob(v) => Ok(v),
+            _ => Err(ValueError {
+                msg: "expected blob".to_string(),
+            }),
+        }
+    }
+}
+
+impl<'a> FromValueRef<'a> for Option<&'a str> {
+    fn from_value_ref(value: ValueRef<'a>) -> Result<Self> {
+        match value {
+            ValueRef::Text(v) => Ok(Some(v)),
+            ValueRef::Null => Ok(None),
+            _ => Err(ValueError {
+                msg: "expected text or null".to_string(),
+            }),
+        }
+    }
+}
+
+impl<'a> FromValueRef<'a> for Option<&'a [u8]> {
+    fn from_value_ref(value: ValueRef<'a>) -> Result<Self> {
+        match value {
+            ValueRef::Blob(v) => Ok(Some(v)),
+            ValueRef::Null => Ok(None),
+            _ => Err(ValueError {
+                msg: "expected blob or null".to_string(),
+            }),
+        }
+    }
+}
+
 // MARK: Uuid
 #[cfg(feature = "uuid")]
 mod uuid_impls {
@@ -11,6 +11,12 @@ use syn::{parse_macro_input, DeriveInput};
 pub(crate) fn from_row_derive(input: TokenStream) -> TokenStream {
     let input = parse_macro_input!(input as DeriveInput);
     let name = input.ident;
+    let (impl_generics, ty_generics, where_clause) = input.generics.split_for_impl();
+    let lifetime = input
+        .generics
+        .lifetimes()
+        .next()
+        .map(|param| param.lifetime.clone());
 
     // Parse fields and handle #[sqlite(skip)] and #[sqlite(rename = "example")] attributes
     let (fields, has_skipped) = match input.data {
@@ -78,24 +84,59 @@ pub(crate) fn from_row_derive(input: TokenStream) -> TokenStream {
         quote! { statement.bind_value(#index, self.#ident.into())?; }
     });
 
-    let from_rows = fields
-        .iter()
-        .enumerate()
-        .map(|(index, (field, field_name))| {
-            let index = index as i32;
-            let ident = field.ident.as_ref().expect("Invalid field");
-            quote! { #ident: statement.column_value(#index).try_into().map_err(|_| bsqlite::ValueError::new(format!(
-                "Can't get value of column: {}", #field_name
-            )))? }
-        });
     let from_rows_default = if has_skipped {
         quote! { ..Default::default() }
     } else {
         quote! {}
     };
 
+    // Structs with a lifetime borrow their text and blob fields from a bsqlite::RowRef
+    let from_row = if let Some(lifetime) = lifetime {
+        let from_rows = fields
+            .iter()
+            .enumerate()
+            .map(|(index, (field, field_name))| {
+                let index = index as i32;
+                let ident = field.ident.as_ref().expect("Invalid field");
+                quote! { #ident: row.get(#index).map_err(|_| bsqlite::ValueError::new(format!(
+                    "Can't get value of column: {}", #field_name
+                )))? }
+            });
+        quote! {
+            impl #impl_generics bsqlite::FromRowRef<#lifetime> for #name #ty_generics #where_clause {
+                fn from_row_ref(row: bsqlite::RowRef<#lifetime>) -> Result<Self, bsqlite::ValueError> {
+                    Ok(Self {
+                        #( #from_rows, )*
+                        #from_rows_default
+                    })
+                }
+            }
+        }
+    } else {
+        let from_rows = fields
+            .iter()
+            .enumerate()
+            .map(|(index, (field, field_name))| {
+                let index = index as i32;
+                let ident = field.ident.as_ref().expect("Invalid field");
+                quote! { #ident: statement.column_value(#index).try_into().map_err(|_| bsqlite::ValueError::new(format!(
+                    "Can't get value of column: {}", #field_name
+                )))? }
+            });
+        quote! {
+            impl #impl_generics bsqlite::FromRow for #name #ty_generics #where_clause {
+                fn from_row(statement: &mut bsqlite::RawStatement) -> Result<Self, bsqlite::ValueError> {
+                    Ok(Self {
+                        #( #from_rows, )*
+                        #from_rows_default
+                    })
+                }
+            }
+        }
+    };
+
     TokenStream::from(quote! {
-        impl #name {
+        impl #impl_generics #name #ty_generics #where_clause {
             pub const fn columns() -> &'static str {
                 #columns
             }
@@ -103,19 +144,12 @@ pub(crate) fn from_row_derive(input: TokenStream) -> TokenStream {
                 #values
             }
         }
-        impl bsqlite::Bind for #name {
+        impl #impl_generics bsqlite::Bind for #name #ty_generics #where_clause {
             fn bind(self, statement: &mut bsqlite::RawStatement) -> Result<(), bsqlite::StatementError> {
                 #( #binds )*
                 Ok(())
             }
         }
-        impl bsqlite::FromRow for #name {
-            fn from_row(statement: &mut bsqlite::RawStatement) -> Result<Self, bsqlite::ValueError> {
-                Ok(Self {
-                    #( #from_rows, )*
-                    #from_rows_default
-                })
-            }
-        }
+        #from_row
     })
 }
@@ -10,11 +10,38 @@ fn main() {
     cfg_select! {
         // Compile and link the SQLite library from source
         feature = "bundled" => {
-            cc::Build::new()
+            let mut build = cc::Build::new();
+            build
                 .file("sqlite3/sqlite3.c")
                 .define("SQLITE_ENABLE_COLUMN_METADATA", None)
-                .define("SQLITE_ENABLE_FTS5", None)
-                .compile("sqlite3");
+                .define("SQLITE_ENABLE_FTS5", None);
+
+            // Leave out the features that cost time on every call and aren't used through this crate,
+            // connections opened with SQLITE_OPEN_FULLMUTEX stay serialized with SQLITE_THREADSAFE=2
+            if cfg!(feature = "bundled-fast") {
+                build
+                    .define("SQLITE_THREADSAFE", "2")
+                    .define("SQLITE_DEFAULT_MEMSTATUS", "0")
+                    .define("SQLITE_DQS", "0")
+                    .define("SQLITE_OMIT_DEPRECATED", None)
+                    .define("SQLITE_OMIT_SHARED_CACHE", None)
+                    .define("SQLITE_LIKE_DOESNT_MATCH_BLOBS", None)
+                    .define("SQLITE_USE_ALLOCA", None)
+                    .flag_if_supported("-Wno-unused-parameter");
+
+                // Debug builds get an optimized SQLite too, release profiles keep their own level
+                if matches!(std::env::var("OPT_LEVEL").as_deref(), Ok("0" | "1")) {
+                    build.opt_level(2);
+                }
+
+                // The amalgamation is one translation unit already, LTO only helps across the boundary
+                // with Rust when rustc does linker plugin LTO with the same clang
+                let rustflags = std::env::var("CARGO_ENCODED_RUSTFLAGS").unwrap_or_default();
+                if rustflags.contains("linker-plugin-lto") && build.get_compiler().is_like_clang() {
+                    build.flag("-flto=thin");
+                }
+            }
+            build.compile("sqlite3");
         }
         // Or link to the system SQLite library
         _ => {
@@ -8,7 +8,7 @@
 
 #![allow(non_camel_case_types, non_snake_case, missing_docs)]
 
-use std::ffi::{c_char, c_int, c_void};
+use std::ffi::{c_char, c_int, c_uint, c_void};
 
 pub type sqlite3 = c_void;
 pub type sqlite3_stmt = c_void;
@@ -30,6 +30,36 @@ pub const SQLITE_TEXT: i32 = 3;
 pub const SQLITE_BLOB: i32 = 4;
 pub const SQLITE_NULL: i32 = 5;
 
+pub const SQLITE_STATUS_MEMORY_USED: i32 = 0;
+pub const SQLITE_STATUS_PAGECACHE_USED: i32 = 1;
+pub const SQLITE_STATUS_PAGECACHE_OVERFLOW: i32 = 2;
+pub const SQLITE_STATUS_MALLOC_SIZE: i32 = 5;
+pub const SQLITE_STATUS_MALLOC_COUNT: i32 = 9;
+
+pub const SQLITE_DBSTATUS_LOOKASIDE_USED: i32 = 0;
+pub const SQLITE_DBSTATUS_CACHE_USED: i32 = 1;
+pub const SQLITE_DBSTATUS_SCHEMA_USED: i32 = 2;
+pub const SQLITE_DBSTATUS_STMT_USED: i32 = 3;
+pub const SQLITE_DBSTATUS_LOOKASIDE_HIT: i32 = 4;
+pub const SQLITE_DBSTATUS_LOOKASIDE_MISS_SIZE: i32 = 5;
+pub const SQLITE_DBSTATUS_LOOKASIDE_MISS_FULL: i32 = 6;
+pub const SQLITE_DBSTATUS_CACHE_HIT: i32 = 7;
+pub const SQLITE_DBSTATUS_CACHE_MISS: i32 = 8;
+pub const SQLITE_DBSTATUS_CACHE_WRITE: i32 = 9;
+pub const SQLITE_DBSTATUS_CACHE_SPILL: i32 = 12;
+
+pub const SQLITE_STMTSTATUS_FULLSCAN_STEP: i32 = 1;
+pub const SQLITE_STMTSTATUS_SORT: i32 = 2;
+pub const SQLITE_STMTSTATUS_AUTOINDEX: i32 = 3;
+pub const SQLITE_STMTSTATUS_VM_STEP: i32 = 4;
+
+pub const SQLITE_TRACE_PROFILE: u32 = 0x02;
+
+pub fn SQLITE_STATIC() -> sqlite3_destructor_type {
+    // The SQLite docs say that the value of `SQLITE_STATIC` is 0.
+    None
+}
+
 #[allow(unsafe_code)]
 pub fn SQLITE_TRANSIENT() -> sqlite3_destructor_type {
     // SAFETY: The SQLite docs say that the value of `SQLITE_TRANSIENT` is -1.
@@ -39,6 +69,12 @@ pub fn SQLITE_TRANSIENT() -> sqlite3_destructor_type {
 #[allow(unsafe_code)]
 unsafe extern "C" {
     pub fn sqlite3_free(ptr: *mut c_void);
+    pub fn sqlite3_status64(
+        op: c_int,
+        pCurrent: *mut i64,
+        pHighwater: *mut i64,
+        resetFlag: c_int,
+    ) -> c_int;
 
     // sqlite3
     pub fn sqlite3_open_v2(
@@ -65,6 +101,22 @@ unsafe extern "C" {
     ) -> c_int;
     pub fn sqlite3_changes(db: *mut sqlite3) -> i32;
     pub fn sqlite3_last_insert_rowid(db: *mut sqlite3) -> i64;
+    pub fn sqlite3_get_autocommit(db: *mut sqlite3) -> c_int;
+    pub fn sqlite3_db_status(
+        db: *mut sqlite3,
+        op: c_int,
+        pCur: *mut c_int,
+        pHiwtr: *mut c_int,
+        resetFlg: c_int,
+    ) -> c_int;
+    pub fn sqlite3_trace_v2(
+        db: *mut sqlite3,
+        uMask: c_uint,
+        xCallback: Option<
+            unsafe extern "C" fn(c_uint, *mut c_void, *mut c_void, *mut c_void) -> c_int,
+        >,
+        pCtx: *mut c_void,
+    ) -> c_int;
     pub fn sqlite3_errmsg(db: *mut sqlite3) -> *const c_char;
     pub fn sqlite3_close(db: *mut sqlite3) -> c_int;
 
@@ -73,7 +125,9 @@ unsafe extern "C" {
     pub fn sqlite3_sql(pStmt: *mut sqlite3_stmt) -> *const c_char;
     pub fn sqlite3_step(pStmt: *mut sqlite3_stmt) -> c_int;
     pub fn sqlite3_reset(pStmt: *mut sqlite3_stmt) -> c_int;
+    pub fn sqlite3_clear_bindings(pStmt: *mut sqlite3_stmt) -> c_int;
     pub fn sqlite3_finalize(pStmt: *mut sqlite3_stmt) -> c_int;
+    pub fn sqlite3_stmt_status(pStmt: *mut sqlite3_stmt, op: c_int, resetFlg: c_int) -> c_int;
 
     pub fn sqlite3_bind_parameter_index(pStmt: *mut sqlite3_stmt, zName: *const c_char) -> c_int;
     pub fn sqlite3_bind_null(pStmt: *mut sqlite3_stmt, i: c_int) -> c_int;